@@ -0,0 +1,142 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "AutomationQueue.h"
+
+#include <math.h>
+#include <string.h>
+
+static const UInt32 kRingMask = AutomationQueue::kCapacity - 1;
+
+#pragma mark Construction/Destruction
+
+AutomationQueue::AutomationQueue()
+        : mRing(kCapacity),
+          mWriteIndex(0),
+          mReadIndex(0),
+          mPending(kNumberParameters),
+          mNumberPushedEvents(0),
+          mNumberDroppedEvents(0) {
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "the ring size has to be a power of two");
+    for (UInt32 theParameter = 0; theParameter < kNumberParameters; ++theParameter) {
+        mPending[theParameter].mStart = 0;
+        mPending[theParameter].mCount = 0;
+    }
+}
+
+#pragma mark Producer
+
+UInt32 AutomationQueue::Push(const Event *inEvents, UInt32 inNumberEvents) {
+    UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+    UInt32 theReadIndex = mReadIndex.load(std::memory_order_acquire);
+    UInt32 theFreeSlots = kCapacity - (theWriteIndex - theReadIndex);
+    UInt32 theNumberEvents = inNumberEvents < theFreeSlots ? inNumberEvents : theFreeSlots;
+
+    for (UInt32 theEvent = 0; theEvent < theNumberEvents; ++theEvent) {
+        mRing[(theWriteIndex + theEvent) & kRingMask] = inEvents[theEvent];
+    }
+    mWriteIndex.store(theWriteIndex + theNumberEvents, std::memory_order_release);
+
+    mNumberPushedEvents.fetch_add(theNumberEvents, std::memory_order_relaxed);
+    if (theNumberEvents < inNumberEvents) {
+        mNumberDroppedEvents.fetch_add(inNumberEvents - theNumberEvents, std::memory_order_relaxed);
+    }
+    return theNumberEvents;
+}
+
+#pragma mark Consumer
+
+void AutomationQueue::Drain() {
+    UInt32 theReadIndex = mReadIndex.load(std::memory_order_relaxed);
+    UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+
+    //  An event of a parameter whose list is full stays in the ring until some of that parameter's
+    //  events are due, and the read index stops at the first such event. The events behind it are
+    //  still taken for the other parameters and marked as taken, the slots between the two indices
+    //  belong to the IO thread until the read index passes them.
+    UInt32 theNewReadIndex = theWriteIndex;
+    for (UInt32 theIndex = theReadIndex; theIndex != theWriteIndex; ++theIndex) {
+        Event &theEvent = mRing[theIndex & kRingMask];
+        if (theEvent.mParameter >= kNumberParameters) {
+            continue;
+        }
+        if (mPending[theEvent.mParameter].mCount == kCapacity) {
+            if (theNewReadIndex == theWriteIndex) {
+                theNewReadIndex = theIndex;
+            }
+            continue;
+        }
+        Insert(theEvent);
+        theEvent.mParameter = kParameterTaken;
+    }
+    mReadIndex.store(theNewReadIndex, std::memory_order_release);
+}
+
+UInt32 AutomationQueue::NextSegment(UInt32 inParameter, Float64 inSampleTime, UInt32 inNumberFrames, Float32 &ioValue) {
+    Pending &thePending = mPending[inParameter];
+
+    //  everything that is due by the first frame takes effect, the last one wins
+    while ((thePending.mCount > 0) && (thePending.mEvents[thePending.mStart].mSampleTime <= inSampleTime)) {
+        ioValue = thePending.mEvents[thePending.mStart].mValue;
+        ++thePending.mStart;
+        --thePending.mCount;
+    }
+    if (thePending.mCount == 0) {
+        thePending.mStart = 0;
+        return inNumberFrames;
+    }
+
+    //  the value holds until the frame the next event lands on
+    Float64 theNumberFrames = ceil(thePending.mEvents[thePending.mStart].mSampleTime - inSampleTime);
+    return theNumberFrames < inNumberFrames ? static_cast<UInt32>(theNumberFrames) : inNumberFrames;
+}
+
+void AutomationQueue::Clear() {
+    mReadIndex.store(mWriteIndex.load(std::memory_order_acquire), std::memory_order_release);
+    for (UInt32 theParameter = 0; theParameter < kNumberParameters; ++theParameter) {
+        mPending[theParameter].mStart = 0;
+        mPending[theParameter].mCount = 0;
+    }
+}
+
+#pragma mark Implementation
+
+void AutomationQueue::Insert(const Event &inEvent) {
+    Pending &thePending = mPending[inEvent.mParameter];
+    if (thePending.mStart + thePending.mCount == kCapacity) {
+        memmove(&thePending.mEvents[0], &thePending.mEvents[thePending.mStart], thePending.mCount * sizeof(Event));
+        thePending.mStart = 0;
+    }
+
+    //  events mostly arrive in order, so look for the place from the back, after any event at the
+    //  same time so that the later push wins
+    Event *theEvents = &thePending.mEvents[thePending.mStart];
+    UInt32 thePosition = thePending.mCount;
+    while ((thePosition > 0) && (theEvents[thePosition - 1].mSampleTime > inEvent.mSampleTime)) {
+        theEvents[thePosition] = theEvents[thePosition - 1];
+        --thePosition;
+    }
+    theEvents[thePosition] = inEvent;
+    ++thePending.mCount;
+}
@@ -0,0 +1,113 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __AutomationQueue__
+#define __AutomationQueue__
+
+#include <CoreAudio/CoreAudioTypes.h>
+
+#include <atomic>
+#include <vector>
+
+//  Timestamped parameter changes for a device. Property calls push events at the device's sample
+//  times into a single producer/single consumer ring; the IO thread drains the ring into a sorted
+//  list per parameter and asks NextSegment how many frames of its buffer the current value still
+//  holds for, so a buffer is split at exactly the frames the events land on. Events at or before
+//  the start of a buffer take effect on its first frame.
+class AutomationQueue {
+public:
+    enum {
+        kParameterInputVolume = 0,
+        kParameterOutputVolume = 1,
+        kNumberParameters = 2
+    };
+    static const UInt32 kCapacity = 1024;
+
+    struct Event {
+        Float64 mSampleTime;
+        UInt32 mParameter;
+        Float32 mValue;
+    };
+
+#pragma mark Construction/Destruction
+public:
+    AutomationQueue();
+
+private:
+    AutomationQueue(const AutomationQueue &);
+    AutomationQueue &operator=(const AutomationQueue &);
+
+#pragma mark Producer
+public:
+    //  only one thread at a time may push, returns how many events fit, the rest are dropped
+    UInt32 Push(const Event *inEvents, UInt32 inNumberEvents);
+    bool Push(const Event &inEvent) {
+        return Push(&inEvent, 1) == 1;
+    }
+
+    //  at least this many events fit, more once the IO thread drains the ring
+    UInt32 GetNumberFreeSlots() const {
+        return kCapacity - (mWriteIndex.load(std::memory_order_relaxed) - mReadIndex.load(std::memory_order_acquire));
+    }
+
+#pragma mark Consumer
+public:
+    //  real time safe, called by the IO thread only
+    void Drain();
+    UInt32 NextSegment(UInt32 inParameter, Float64 inSampleTime, UInt32 inNumberFrames, Float32 &ioValue);
+
+    //  forgets every event, neither side may be running
+    void Clear();
+
+#pragma mark Statistics
+public:
+    UInt64 GetNumberPushedEvents() const { return mNumberPushedEvents.load(std::memory_order_relaxed); }
+    UInt64 GetNumberDroppedEvents() const { return mNumberDroppedEvents.load(std::memory_order_relaxed); }
+
+#pragma mark Implementation
+private:
+    //  the events of one parameter that the IO thread has taken off the ring, sorted by sample time
+    struct Pending {
+        Event mEvents[kCapacity];
+        UInt32 mStart;
+        UInt32 mCount;
+    };
+
+    void Insert(const Event &inEvent);
+
+    //  marks an event in the ring that Drain already took
+    static const UInt32 kParameterTaken = 0xFFFFFFFF;
+
+    //  the ring, mWriteIndex is only written by the producer and mReadIndex by the IO thread
+    std::vector<Event> mRing;
+    std::atomic<UInt32> mWriteIndex;
+    std::atomic<UInt32> mReadIndex;
+
+    std::vector<Pending> mPending;
+
+    std::atomic<UInt64> mNumberPushedEvents;
+    std::atomic<UInt64> mNumberDroppedEvents;
+};
+
+#endif /* __AutomationQueue__ */
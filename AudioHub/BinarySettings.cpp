@@ -0,0 +1,216 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "BinarySettings.h"
+
+#include <CoreFoundation/CFByteOrder.h>
+#include <CoreAudio/AudioHardwareBase.h>
+#include <string.h>
+
+#include "CAException.h"
+
+#pragma mark BinarySettingsDevice
+
+CFStringRef BinarySettingsDevice::CopyUID() const {
+    return CFStringCreateWithBytes(kCFAllocatorDefault, mUID, mUIDLength, kCFStringEncodingUTF8, false);
+}
+
+CFStringRef BinarySettingsDevice::CopyName() const {
+    return CFStringCreateWithBytes(kCFAllocatorDefault, mName, mNameLength, kCFStringEncodingUTF8, false);
+}
+
+#pragma mark BinarySettingsReader
+
+//  records are packed, so fields are not necessarily aligned
+static inline UInt16 ReadUInt16(const UInt8 *inData) {
+    UInt16 theValue;
+    memcpy(&theValue, inData, sizeof(theValue));
+    return CFSwapInt16LittleToHost(theValue);
+}
+
+static inline UInt32 ReadUInt32(const UInt8 *inData) {
+    UInt32 theValue;
+    memcpy(&theValue, inData, sizeof(theValue));
+    return CFSwapInt32LittleToHost(theValue);
+}
+
+static inline Float32 ReadFloat32(const UInt8 *inData) {
+    UInt32 theBits = ReadUInt32(inData);
+    Float32 theValue;
+    memcpy(&theValue, &theBits, sizeof(theValue));
+    return theValue;
+}
+
+static inline void WriteUInt16(UInt8 *outData, UInt16 inValue) {
+    UInt16 theValue = CFSwapInt16HostToLittle(inValue);
+    memcpy(outData, &theValue, sizeof(theValue));
+}
+
+static inline void WriteUInt32(UInt8 *outData, UInt32 inValue) {
+    UInt32 theValue = CFSwapInt32HostToLittle(inValue);
+    memcpy(outData, &theValue, sizeof(theValue));
+}
+
+BinarySettingsReader::BinarySettingsReader(const UInt8 *inData, size_t inDataSize)
+        : mData(inData),
+          mDataSize(inDataSize),
+          mOffset(0),
+          mIsValid(false),
+          mVersion(0),
+          mNumberDevices(0),
+          mNumberDevicesRead(0) {
+    ReadHeader();
+}
+
+BinarySettingsReader::BinarySettingsReader(CFDataRef inData)
+        : mData(inData != NULL ? CFDataGetBytePtr(inData) : NULL),
+          mDataSize(inData != NULL ? CFDataGetLength(inData) : 0),
+          mOffset(0),
+          mIsValid(false),
+          mVersion(0),
+          mNumberDevices(0),
+          mNumberDevicesRead(0) {
+    ReadHeader();
+}
+
+void BinarySettingsReader::ReadHeader() {
+    if (!HasMagic(mData, mDataSize) || (mDataSize < kBinarySettingsHeaderSize)) {
+        return;
+    }
+    mVersion = ReadUInt16(mData + 4);
+    mNumberDevices = ReadUInt32(mData + 8);
+    mOffset = kBinarySettingsHeaderSize;
+    mIsValid = (mVersion > 0) && (mVersion <= kBinarySettingsVersion);
+}
+
+bool BinarySettingsReader::GetNextDevice(BinarySettingsDevice &outDevice) {
+    if (!mIsValid || (mNumberDevicesRead >= mNumberDevices)) {
+        return false;
+    }
+    //  version 1 records end their header before the noise reduction
+    size_t theHeaderSize = (mVersion < 2) ? kBinarySettingsDeviceHeaderSizeVersion1 : kBinarySettingsDeviceHeaderSize;
+    if (mDataSize - mOffset < theHeaderSize) {
+        mIsValid = false;
+        return false;
+    }
+
+    const UInt8 *theRecord = mData + mOffset;
+    UInt32 theChannels = ReadUInt32(theRecord);
+    UInt16 theUIDLength = ReadUInt16(theRecord + 4);
+    UInt16 theNameLength = ReadUInt16(theRecord + 6);
+    size_t theRecordSize = theHeaderSize + theUIDLength + theNameLength;
+    if (mDataSize - mOffset < theRecordSize) {
+        mIsValid = false;
+        return false;
+    }
+
+    outDevice.mChannels = theChannels;
+    outDevice.mNoiseReduction = (mVersion < 2) ? 0.0f : ReadFloat32(theRecord + 8);
+    outDevice.mUID = theRecord + theHeaderSize;
+    outDevice.mUIDLength = theUIDLength;
+    outDevice.mName = outDevice.mUID + theUIDLength;
+    outDevice.mNameLength = theNameLength;
+
+    mOffset += theRecordSize;
+    ++mNumberDevicesRead;
+    return true;
+}
+
+bool BinarySettingsReader::HasMagic(const UInt8 *inData, size_t inDataSize) {
+    return (inData != NULL) && (inDataSize >= 4) && (ReadUInt32(inData) == kBinarySettingsMagic);
+}
+
+bool BinarySettingsReader::HasMagic(CFTypeRef inSettings) {
+    if ((inSettings == NULL) || (CFGetTypeID(inSettings) != CFDataGetTypeID())) {
+        return false;
+    }
+    CFDataRef theData = static_cast<CFDataRef>(inSettings);
+    return HasMagic(CFDataGetBytePtr(theData), CFDataGetLength(theData));
+}
+
+#pragma mark BinarySettingsWriter
+
+BinarySettingsWriter::BinarySettingsWriter()
+        : mData(CFDataCreateMutable(kCFAllocatorDefault, 0)),
+          mNumberDevices(0) {
+    ThrowIfNULL(mData, CAException(kAudioHardwareIllegalOperationError), "BinarySettingsWriter::BinarySettingsWriter: couldn't allocate the data");
+    AppendUInt32(kBinarySettingsMagic);
+    AppendUInt16(kBinarySettingsVersion);
+    AppendUInt16(0);
+    AppendUInt32(0);
+}
+
+BinarySettingsWriter::~BinarySettingsWriter() {
+    CFRelease(mData);
+}
+
+void BinarySettingsWriter::AppendDevice(CFStringRef inUID, CFStringRef inName, UInt32 inChannels, Float32 inNoiseReduction) {
+    ThrowIf((inUID == NULL) || (inName == NULL), CAException(kAudioHardwareIllegalOperationError), "BinarySettingsWriter::AppendDevice: missing UID or name");
+
+    //  write the record header with placeholder lengths and patch them once the strings are in
+    CFIndex theRecordOffset = CFDataGetLength(mData);
+    UInt32 theNoiseReductionBits;
+    memcpy(&theNoiseReductionBits, &inNoiseReduction, sizeof(theNoiseReductionBits));
+    AppendUInt32(inChannels);
+    AppendUInt16(0);
+    AppendUInt16(0);
+    AppendUInt32(theNoiseReductionBits);
+    UInt16 theUIDLength = AppendString(inUID);
+    UInt16 theNameLength = AppendString(inName);
+
+    UInt8 *theRecord = CFDataGetMutableBytePtr(mData) + theRecordOffset;
+    WriteUInt16(theRecord + 4, theUIDLength);
+    WriteUInt16(theRecord + 6, theNameLength);
+
+    ++mNumberDevices;
+    WriteUInt32(CFDataGetMutableBytePtr(mData) + 8, mNumberDevices);
+}
+
+CFDataRef BinarySettingsWriter::CopyData() const {
+    return CFDataCreateCopy(kCFAllocatorDefault, mData);
+}
+
+void BinarySettingsWriter::AppendUInt16(UInt16 inValue) {
+    UInt8 theBytes[sizeof(UInt16)];
+    WriteUInt16(theBytes, inValue);
+    CFDataAppendBytes(mData, theBytes, sizeof(theBytes));
+}
+
+void BinarySettingsWriter::AppendUInt32(UInt32 inValue) {
+    UInt8 theBytes[sizeof(UInt32)];
+    WriteUInt32(theBytes, inValue);
+    CFDataAppendBytes(mData, theBytes, sizeof(theBytes));
+}
+
+UInt16 BinarySettingsWriter::AppendString(CFStringRef inString) {
+    CFRange theRange = CFRangeMake(0, CFStringGetLength(inString));
+    CFIndex theLength = 0;
+    CFStringGetBytes(inString, theRange, kCFStringEncodingUTF8, 0, false, NULL, 0, &theLength);
+    ThrowIf(theLength > 0xFFFF, CAException(kAudioHardwareIllegalOperationError), "BinarySettingsWriter::AppendString: string too long");
+
+    CFIndex theOffset = CFDataGetLength(mData);
+    CFDataIncreaseLength(mData, theLength);
+    CFStringGetBytes(inString, theRange, kCFStringEncodingUTF8, 0, false, CFDataGetMutableBytePtr(mData) + theOffset, theLength, NULL);
+    return static_cast<UInt16>(theLength);
+}
@@ -0,0 +1,107 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __BinarySettings__
+#define __BinarySettings__
+
+#include <CoreFoundation/CoreFoundation.h>
+
+//  Compact settings encoding that can be turned into devices without building a property list
+//  first. All integers are little endian, strings are UTF-8 without a terminator.
+//
+//      header:     'AHSB' magic (4 bytes), version (UInt16), flags (UInt16), device count (UInt32)
+//      device:     channels (UInt32), UID length (UInt16), name length (UInt16),
+//                  noise reduction in dB (Float32, version 2 and later), UID bytes, name bytes
+//
+//  Readers reject any version newer than the one they know, so a new layout needs a new version.
+enum {
+    kBinarySettingsMagic = 'AHSB',
+    kBinarySettingsVersion = 2,
+    kBinarySettingsHeaderSize = 12,
+    kBinarySettingsDeviceHeaderSizeVersion1 = 8,
+    kBinarySettingsDeviceHeaderSize = 12
+};
+
+struct BinarySettingsDevice {
+    UInt32 mChannels;
+    Float32 mNoiseReduction;
+    const UInt8 *mUID;
+    UInt16 mUIDLength;
+    const UInt8 *mName;
+    UInt16 mNameLength;
+
+    CFStringRef CopyUID() const;
+    CFStringRef CopyName() const;
+};
+
+class BinarySettingsReader {
+public:
+    BinarySettingsReader(const UInt8 *inData, size_t inDataSize);
+    BinarySettingsReader(CFDataRef inData);
+
+    //  true if the header is intact and the version is supported
+    bool IsValid() const { return mIsValid; }
+    UInt16 GetVersion() const { return mVersion; }
+    UInt32 GetNumberDevices() const { return mNumberDevices; }
+
+    //  returns false at the end of the data or if a device record is truncated
+    bool GetNextDevice(BinarySettingsDevice &outDevice);
+
+    static bool HasMagic(const UInt8 *inData, size_t inDataSize);
+    static bool HasMagic(CFTypeRef inSettings);
+
+private:
+    void ReadHeader();
+
+    const UInt8 *mData;
+    size_t mDataSize;
+    size_t mOffset;
+    bool mIsValid;
+    UInt16 mVersion;
+    UInt32 mNumberDevices;
+    UInt32 mNumberDevicesRead;
+};
+
+class BinarySettingsWriter {
+public:
+    BinarySettingsWriter();
+    ~BinarySettingsWriter();
+
+    //  throws if the strings can't be encoded
+    void AppendDevice(CFStringRef inUID, CFStringRef inName, UInt32 inChannels, Float32 inNoiseReduction = 0.0f);
+    CFDataRef CopyData() const;
+
+private:
+    BinarySettingsWriter(const BinarySettingsWriter &);
+    BinarySettingsWriter &operator=(const BinarySettingsWriter &);
+
+    void AppendUInt16(UInt16 inValue);
+    void AppendUInt32(UInt32 inValue);
+    UInt16 AppendString(CFStringRef inString);
+
+    CFMutableDataRef mData;
+    UInt32 mNumberDevices;
+};
+
+#endif /* __BinarySettings__ */
@@ -37,6 +37,7 @@ THE SOFTWARE.
 #endif
 #endif
 #include "PlugIn.h"
+#include "Profiler.h"
 #include "CAException.h"
 #include "CADebugMacros.h"
 #include "CACFDictionary.h"
@@ -77,6 +78,7 @@ bool Box::HasProperty(AudioObjectID inObjectID, pid_t inClientPID, const AudioOb
 #if !ULTRASCHALL
         case kAudioHubCustomPropertySettings:
         case kAudioHubCustomPropertyActive:
+        case kAudioHubCustomPropertyProfile:
 #endif
         
         case kAudioBoxPropertyBoxUID:
@@ -121,6 +123,7 @@ bool Box::IsPropertySettable(AudioObjectID inObjectID, pid_t inClientPID, const
 #if !ULTRASCHALL
         case kAudioHubCustomPropertySettings:
         case kAudioHubCustomPropertyActive:
+        case kAudioHubCustomPropertyProfile:
 #endif
         case kAudioObjectPropertyName:
             theAnswer = true;
@@ -173,6 +176,10 @@ UInt32 Box::GetPropertyDataSize(AudioObjectID inObjectID, pid_t inClientPID, con
         case kAudioHubCustomPropertyActive:
             theAnswer = sizeof(CFStringRef);
             break;
+
+        case kAudioHubCustomPropertyProfile:
+            theAnswer = sizeof(CFPropertyListRef);
+            break;
 #endif
             
         case kAudioBoxPropertyBoxUID:
@@ -295,6 +302,11 @@ void Box::GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID, const Aud
                 ((AudioServerPlugInCustomPropertyInfo*)outData)[1].mPropertyDataType = kAudioServerPlugInCustomPropertyDataTypeCFString;
                 ((AudioServerPlugInCustomPropertyInfo*)outData)[1].mQualifierDataType = kAudioServerPlugInCustomPropertyDataTypeNone;
             }
+            if (theNumberItemsToFetch > 2) {
+                ((AudioServerPlugInCustomPropertyInfo*)outData)[2].mSelector = kAudioHubCustomPropertyProfile;
+                ((AudioServerPlugInCustomPropertyInfo*)outData)[2].mPropertyDataType = kAudioServerPlugInCustomPropertyDataTypeCFPropertyList;
+                ((AudioServerPlugInCustomPropertyInfo*)outData)[2].mQualifierDataType = kAudioServerPlugInCustomPropertyDataTypeNone;
+            }
 #endif
             outDataSize = (UInt32)(theNumberItemsToFetch * sizeof(AudioServerPlugInCustomPropertyInfo));
             break;
@@ -331,6 +343,14 @@ void Box::GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID, const Aud
             outDataSize = sizeof(CFStringRef);
             break;
         }
+
+        case kAudioHubCustomPropertyProfile: {
+            //  the profiler report, see Profiler::CopyReport
+            ThrowIf(inDataSize < sizeof(CFPropertyListRef), CAException(kAudioHardwareBadPropertySizeError), "Box::GetPropertyData: not enough space for the return value of kAudioHubCustomPropertyProfile for the box");
+            *reinterpret_cast<CFPropertyListRef*>(outData) = Profiler::CopyReport();
+            outDataSize = sizeof(CFPropertyListRef);
+            break;
+        }
 #endif
             
         case kAudioBoxPropertyBoxUID:
@@ -424,6 +444,9 @@ void Box::SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID, const Aud
             CFPropertyListRef* settings = (CFPropertyListRef*)inData;
             if((settings != NULL) && (*settings != NULL))
             {
+                //  the device list changes several times while the new settings are applied, the
+                //  transaction makes sure the host only hears about it once per object
+                NotificationAggregator::Transaction theTransaction(PlugIn::GetNotificationAggregator());
                 {
                     RemoveAllDevices();
                     AudioObjectPropertyAddress theChangedProperties[] = {
@@ -475,6 +498,21 @@ void Box::SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID, const Aud
 
         }
             break;
+
+        case kAudioHubCustomPropertyProfile:
+        {
+            //  true/false turns profiling on or off, anything else clears the collected samples
+            ThrowIf(inDataSize < sizeof(CFPropertyListRef), CAException(kAudioHardwareBadPropertySizeError), "Box::SetPropertyData: not enough space for the value of kAudioHubCustomPropertyProfile for the box");
+            CFPropertyListRef* profile = (CFPropertyListRef*)inData;
+            if((profile != NULL) && (*profile != NULL))
+            {
+                if (CFGetTypeID(*profile) == CFBooleanGetTypeID())
+                    Profiler::SetEnabled(CFBooleanGetValue((CFBooleanRef)*profile));
+                else
+                    Profiler::Reset();
+            }
+        }
+            break;
 #endif
             
         default:
@@ -57,9 +57,11 @@
 
 //	PublicUtility Includes
 #include "CADebugMacros.h"
-#include "CADispatchQueue.h"
 #include "CAException.h"
 
+//	Local Includes
+#include "DispatchLanes.h"
+
 //==================================================================================================
 #pragma mark -
 #pragma mark CAObject
@@ -343,7 +345,7 @@ void    CAObjectMap::_UnmapObject(AudioObjectID inObjectID, CAObject *inObject)
                         mObjectInfoList.erase(theIterator);
 
                         //	and destroy the object
-                        CADispatchQueue::GetGlobalSerialQueue().Dispatch(false, ^{
+                        DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneReclamation, false, ^{
                             DestroyObject(inObject);
                         });
                     }
@@ -413,7 +415,7 @@ UInt64    CAObjectMap::_ReleaseObject(CAObject *inObject) {
                 mObjectInfoList.erase(theIterator);
 
                 //	and destroy the object
-                CADispatchQueue::GetGlobalSerialQueue().Dispatch(false, ^{
+                DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneReclamation, false, ^{
                     DestroyObject(inObject);
                 });
                 return 0;
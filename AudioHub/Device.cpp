@@ -39,17 +39,29 @@ THE SOFTWARE.
 #endif
 #endif
 #include <Accelerate/Accelerate.h>
-#include "CADispatchQueue.h"
+#include "CACFArray.h"
+#include "CACFDictionary.h"
+#include "DispatchLanes.h"
+#include "NoiseReducer.h"
+#include "SpectrumAnalyzer.h"
 #include "CAException.h"
+#include "CARealTimeChecker.h"
 
 #pragma mark Construction/Destruction
 
 Device::Device(AudioObjectID inObjectID, SInt16 numChannels, AudioObjectID owner)
         : CAObject(inObjectID, kAudioDeviceClassID, kAudioObjectClassID, owner),
-          mStateMutex(new CAMutex("Hub State")),
+          mIsMaterialized(false),
+          mStateMutex(new CASharedMutex("Hub State", CAMutex::kDefaultSpinCount)),
           mIOMutex(new CAMutex("Hub IO")),
           mStartCount(0),
           mRingBufferSize(1024 * 8),
+          mSpectrumAnalyzer(nullptr),
+          mAutomationQueue(nullptr),
+          mAutomatedVolumeChanges(0),
+          mIsPostingAutomatedVolumeChanges(false),
+          mNoiseReduction(0.0f),
+          mNoiseReducer(nullptr),
           mDeviceUID("Hub:0"),
           mInputStreamObjectID(CAObjectMap::GetNextObjectID()),
           mInputStreamIsActive(true),
@@ -63,15 +75,8 @@ Device::Device(AudioObjectID inObjectID, SInt16 numChannels, AudioObjectID owner
           mTimeline(0),
           mMasterInputVolume(1),
           mMasterOutputVolume(1) {
-    //  put the device info in the list
-    mStreamDescriptions.push_back(CAStreamBasicDescription(44100.0, numChannels, CAStreamBasicDescription::kPCMFormatFloat32, true));
-    mStreamDescriptions.push_back(CAStreamBasicDescription(48000.0, numChannels, CAStreamBasicDescription::kPCMFormatFloat32, true));
-    mStreamDescriptions.push_back(CAStreamBasicDescription(96000.0, numChannels, CAStreamBasicDescription::kPCMFormatFloat32, true));
-
-    mStreamDescription = mStreamDescriptions[1];
-
-    //	Setup the volume curve with the one range
-    mVolumeCurve.AddRange(kHub_Control_MinRawVolumeValue, kHub_Control_MaxRawVolumeValue, kHub_Control_MinDBVolumeValue, kHub_Control_MaxDbVolumeValue);
+    //  the current format is all that is needed until the device is materialized
+    mStreamDescription = CAStreamBasicDescription(48000.0, numChannels, CAStreamBasicDescription::kPCMFormatFloat32, true);
 }
 
 void Device::Activate() {
@@ -104,10 +109,63 @@ void Device::Deactivate() {
 
 Device::~Device() {
     mRingBuffer.Deallocate();
+    delete mSpectrumAnalyzer.load();
+    delete mAutomationQueue;
+    delete mNoiseReducer;
     delete mStateMutex;
     delete mIOMutex;
-    mStateMutex = nullptr;
-    mIOMutex = nullptr;
+    if (IsMaterialized()) {
+        sNumberMaterializedDevices.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+#pragma mark Materialization
+
+void Device::Materialize() const {
+    if (!IsMaterialized()) {
+        std::call_once(mMaterializeOnce, &Device::MaterializeOnce, this);
+    }
+}
+
+void Device::MaterializeOnce() const {
+    UInt32 theNumberChannels = mStreamDescription.mChannelsPerFrame;
+    mStreamDescriptions.push_back(CAStreamBasicDescription(44100.0, theNumberChannels, CAStreamBasicDescription::kPCMFormatFloat32, true));
+    mStreamDescriptions.push_back(CAStreamBasicDescription(48000.0, theNumberChannels, CAStreamBasicDescription::kPCMFormatFloat32, true));
+    mStreamDescriptions.push_back(CAStreamBasicDescription(96000.0, theNumberChannels, CAStreamBasicDescription::kPCMFormatFloat32, true));
+
+    //	Setup the volume curve with the one range
+    mVolumeCurve.AddRange(kHub_Control_MinRawVolumeValue, kHub_Control_MaxRawVolumeValue, kHub_Control_MinDBVolumeValue, kHub_Control_MaxDbVolumeValue);
+
+    mAutomationQueue = new AutomationQueue();
+
+    sNumberMaterializedDevices.fetch_add(1, std::memory_order_relaxed);
+    mIsMaterialized.store(true, std::memory_order_release);
+}
+
+bool Device::IsIdentityProperty(const AudioObjectPropertyAddress &inAddress) {
+    //  the properties the HAL reads while enumerating devices, none of them touch the lazy state
+    switch (inAddress.mSelector) {
+        case kAudioObjectPropertyBaseClass:
+        case kAudioObjectPropertyClass:
+        case kAudioObjectPropertyOwner:
+        case kAudioObjectPropertyName:
+        case kAudioObjectPropertyManufacturer:
+        case kAudioObjectPropertyOwnedObjects:
+        case kAudioDevicePropertyDeviceUID:
+        case kAudioDevicePropertyModelUID:
+        case kAudioDevicePropertyTransportType:
+        case kAudioDevicePropertyRelatedDevices:
+        case kAudioDevicePropertyClockDomain:
+        case kAudioDevicePropertyDeviceIsAlive:
+        case kAudioDevicePropertyIsHidden:
+        case kAudioDevicePropertyStreams:
+        case kAudioObjectPropertyControlList:
+        case kAudioObjectPropertyCustomPropertyInfoList:
+            return true;
+
+        default:
+            return false;
+    }
 }
 
 #pragma mark Property Operations
@@ -149,6 +207,9 @@ bool Device::IsPropertySettable(AudioObjectID inObjectID, pid_t inClientPID, con
 
 UInt32 Device::GetPropertyDataSize(AudioObjectID inObjectID, pid_t inClientPID, const AudioObjectPropertyAddress &inAddress, UInt32 inQualifierDataSize, const void *inQualifierData) const {
     UInt32 theAnswer = 0;
+    if (!IsIdentityProperty(inAddress)) {
+        Materialize();
+    }
     if (inObjectID == mObjectID) {
         theAnswer = Device_GetPropertyDataSize(inObjectID, inClientPID, inAddress, inQualifierDataSize, inQualifierData);
     }
@@ -164,6 +225,9 @@ UInt32 Device::GetPropertyDataSize(AudioObjectID inObjectID, pid_t inClientPID,
 }
 
 void Device::GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID, const AudioObjectPropertyAddress &inAddress, UInt32 inQualifierDataSize, const void *inQualifierData, UInt32 inDataSize, UInt32 &outDataSize, void *outData) const {
+    if (!IsIdentityProperty(inAddress)) {
+        Materialize();
+    }
     if (inObjectID == mObjectID) {
         Device_GetPropertyData(inObjectID, inClientPID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, outDataSize, outData);
     }
@@ -178,6 +242,7 @@ void Device::GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID, const
 }
 
 void Device::SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID, const AudioObjectPropertyAddress &inAddress, UInt32 inQualifierDataSize, const void *inQualifierData, UInt32 inDataSize, const void *inData) {
+    Materialize();
     if (inObjectID == mObjectID) {
         Device_SetPropertyData(inObjectID, inClientPID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData);
     }
@@ -216,6 +281,11 @@ bool Device::Device_HasProperty(AudioObjectID inObjectID, pid_t inClientPID, con
         case kAudioDevicePropertyIsHidden:
         case kAudioDevicePropertyZeroTimeStampPeriod:
         case kAudioDevicePropertyStreams:
+        case kAudioObjectPropertyCustomPropertyInfoList:
+#if !ULTRASCHALL
+        case kAudioHubCustomPropertySpectrum:
+        case kAudioHubCustomPropertyAutomation:
+#endif
             theAnswer = true;
             break;
 
@@ -263,9 +333,14 @@ bool Device::Device_IsPropertySettable(AudioObjectID inObjectID, pid_t inClientP
         case kAudioDevicePropertyPreferredChannelsForStereo:
         case kAudioDevicePropertyPreferredChannelLayout:
         case kAudioDevicePropertyZeroTimeStampPeriod:
+        case kAudioObjectPropertyCustomPropertyInfoList:
             theAnswer = false;
             break;
         case kAudioDevicePropertyNominalSampleRate:
+#if !ULTRASCHALL
+        case kAudioHubCustomPropertySpectrum:
+        case kAudioHubCustomPropertyAutomation:
+#endif
             theAnswer = true;
             break;
 
@@ -291,6 +366,17 @@ UInt32 Device::Device_GetPropertyDataSize(AudioObjectID inObjectID, pid_t inClie
             theAnswer = sizeof(CFStringRef);
             break;
 
+        case kAudioObjectPropertyCustomPropertyInfoList:
+            theAnswer = (UInt32)(kAudioHubDeviceCustomProperties * sizeof(AudioServerPlugInCustomPropertyInfo));
+            break;
+
+#if !ULTRASCHALL
+        case kAudioHubCustomPropertySpectrum:
+        case kAudioHubCustomPropertyAutomation:
+            theAnswer = sizeof(CFPropertyListRef);
+            break;
+#endif
+
         case kAudioObjectPropertyOwnedObjects:
             switch (inAddress.mScope) {
                 case kAudioObjectPropertyScopeGlobal:
@@ -441,6 +527,56 @@ void Device::Device_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
             outDataSize = sizeof(CFStringRef);
             break;
 
+        case kAudioObjectPropertyCustomPropertyInfoList:
+            theNumberItemsToFetch = (UInt32)(inDataSize / sizeof(AudioServerPlugInCustomPropertyInfo));
+            if (theNumberItemsToFetch > kAudioHubDeviceCustomProperties) {
+                theNumberItemsToFetch = kAudioHubDeviceCustomProperties;
+            }
+#if !ULTRASCHALL
+            if (theNumberItemsToFetch > 0) {
+                ((AudioServerPlugInCustomPropertyInfo *) outData)[0].mSelector = kAudioHubCustomPropertySpectrum;
+                ((AudioServerPlugInCustomPropertyInfo *) outData)[0].mPropertyDataType = kAudioServerPlugInCustomPropertyDataTypeCFPropertyList;
+                ((AudioServerPlugInCustomPropertyInfo *) outData)[0].mQualifierDataType = kAudioServerPlugInCustomPropertyDataTypeNone;
+            }
+            if (theNumberItemsToFetch > 1) {
+                ((AudioServerPlugInCustomPropertyInfo *) outData)[1].mSelector = kAudioHubCustomPropertyAutomation;
+                ((AudioServerPlugInCustomPropertyInfo *) outData)[1].mPropertyDataType = kAudioServerPlugInCustomPropertyDataTypeCFPropertyList;
+                ((AudioServerPlugInCustomPropertyInfo *) outData)[1].mQualifierDataType = kAudioServerPlugInCustomPropertyDataTypeNone;
+            }
+#endif
+            outDataSize = (UInt32)(theNumberItemsToFetch * sizeof(AudioServerPlugInCustomPropertyInfo));
+            break;
+
+#if !ULTRASCHALL
+        case kAudioHubCustomPropertySpectrum: {
+            //  the latest frame of the spectrum analyzer, see SpectrumAnalyzer::CopyFrame. A device
+            //  whose analyzer was never enabled returns an empty dictionary.
+            ThrowIf(inDataSize < sizeof(CFPropertyListRef), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_GetPropertyData: not enough space for the return value of kAudioHubCustomPropertySpectrum for the device");
+            //  PerformConfigChange replaces the analyzer under the state lock
+            CASharedMutex::SharedLocker theStateLocker(mStateMutex);
+            SpectrumAnalyzer *theAnalyzer = GetSpectrumAnalyzer();
+            if (theAnalyzer != nullptr) {
+                *reinterpret_cast<CFPropertyListRef *>(outData) = theAnalyzer->CopyFrame();
+            }
+            else {
+                *reinterpret_cast<CFPropertyListRef *>(outData) = CFDictionaryCreate(kCFAllocatorDefault, NULL, NULL, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+            }
+            outDataSize = sizeof(CFPropertyListRef);
+            break;
+        }
+
+        case kAudioHubCustomPropertyAutomation: {
+            //  {Scheduled, Free}: how many events were queued so far and how many more fit right now
+            ThrowIf(inDataSize < sizeof(CFPropertyListRef), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_GetPropertyData: not enough space for the return value of kAudioHubCustomPropertyAutomation for the device");
+            CACFDictionary theStatus;
+            theStatus.AddUInt64(kAudioHubAutomationKeyScheduled, mAutomationQueue->GetNumberPushedEvents());
+            theStatus.AddUInt32(kAudioHubAutomationKeyFree, mAutomationQueue->GetNumberFreeSlots());
+            *reinterpret_cast<CFPropertyListRef *>(outData) = theStatus.CopyCFDictionary();
+            outDataSize = sizeof(CFPropertyListRef);
+            break;
+        }
+#endif
+
         case kAudioObjectPropertyOwnedObjects:
             //	Calculate the number of items that have been requested. Note that this
             //	number is allowed to be smaller than the actual size of the list. In such
@@ -592,7 +728,7 @@ void Device::Device_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
             ThrowIf(inDataSize < sizeof(UInt32), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_GetPropertyData: not enough space for the return value of kAudioDevicePropertyDeviceIsRunning for the device");
 
             //	The IsRunning state is protected by the state lock
-            CAMutex::Locker theStateLocker(mStateMutex);
+            CASharedMutex::SharedLocker theStateLocker(mStateMutex);
 
             //	return the state and how much data we are touching
             *reinterpret_cast<UInt32 *>(outData) = (UInt32) (mStartCount > 0);
@@ -623,7 +759,7 @@ void Device::Device_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
         case kAudioDevicePropertyLatency:
             //	This property returns the presentation latency of the device.
             ThrowIf(inDataSize < sizeof(UInt32), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_GetPropertyData: not enough space for the return value of kAudioDevicePropertyLatency for the device");
-            *reinterpret_cast<UInt32 *>(outData) = (inAddress.mScope == kAudioObjectPropertyScopeInput) ? mLatencyInput : mLatencyOutput;;
+            *reinterpret_cast<UInt32 *>(outData) = (inAddress.mScope == kAudioObjectPropertyScopeInput) ? GetInputLatency() : mLatencyOutput;
             outDataSize = sizeof(UInt32);
             break;
 
@@ -720,7 +856,7 @@ void Device::Device_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
             ThrowIf(inDataSize < sizeof(Float64), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_GetPropertyData: not enough space for the return value of kAudioDevicePropertyNominalSampleRate for the device");
 
             //	The sample rate is protected by the state lock
-            CAMutex::Locker theStateLocker(mStateMutex);
+            CASharedMutex::SharedLocker theStateLocker(mStateMutex);
 
             //	need to lock around fetching the sample rate
             *reinterpret_cast<Float64 *>(outData) = static_cast<Float64>(mStreamDescription.mSampleRate);
@@ -784,7 +920,7 @@ void Device::Device_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
             //	This property returns which two channesl to use as left/right for stereo
             //	data by default. Note that the channel numbers are 1-based.
             ThrowIf(inDataSize < (2 * sizeof(UInt32)), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_GetPropertyData: not enough space for the return value of kAudioDevicePropertyPreferredChannelsForStereo for the device");
-            CAMutex::Locker theStateLocker(mStateMutex);
+            CASharedMutex::SharedLocker theStateLocker(mStateMutex);
             ((UInt32 *) outData)[0] = 1;
             ((UInt32 *) outData)[1] = mStreamDescription.mChannelsPerFrame > 1 ? 2 : 1;
             outDataSize = 2 * sizeof(UInt32);
@@ -853,7 +989,7 @@ void Device::Device_SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
             //	we need to lock around getting the current sample rate to compare against the new rate
             UInt64 theOldSampleRate = 0;
             {
-                CAMutex::Locker theStateLocker(mStateMutex);
+                CASharedMutex::SharedLocker theStateLocker(mStateMutex);
                 theOldSampleRate = (UInt64) mStreamDescription.mSampleRate;
             }
 
@@ -863,13 +999,48 @@ void Device::Device_SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
                 Float64 *data = new Float64(theNewSampleRate);
                 //	we dispatch this so that the change can happen asynchronously
                 AudioObjectID theDeviceObjectID = GetObjectID();
-                CADispatchQueue::GetGlobalSerialQueue().Dispatch(false, ^{
+                DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneConfiguration, false, ^{
                     PlugIn::Host_RequestDeviceConfigurationChange(theDeviceObjectID, kHub_SampleRateChange, data);
                 });
             }
         }
             break;
 
+#if !ULTRASCHALL
+        case kAudioHubCustomPropertySpectrum: {
+            //  a CFBoolean turns the analyzer on or off
+            ThrowIf(inDataSize != sizeof(CFPropertyListRef), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_SetPropertyData: wrong size for the data for kAudioHubCustomPropertySpectrum");
+            CFPropertyListRef theValue = *reinterpret_cast<const CFPropertyListRef *>(inData);
+            ThrowIf((theValue == NULL) || (CFGetTypeID(theValue) != CFBooleanGetTypeID()), CAException(kAudioHardwareIllegalOperationError), "Device::Device_SetPropertyData: kAudioHubCustomPropertySpectrum needs a boolean");
+            SetSpectrumAnalyzerEnabled(CFBooleanGetValue((CFBooleanRef) theValue));
+            break;
+        }
+
+        case kAudioHubCustomPropertyAutomation: {
+            //  an array of {SampleTime, Parameter, Value} dictionaries, checked as a whole before any
+            //  of it is queued
+            ThrowIf(inDataSize != sizeof(CFPropertyListRef), CAException(kAudioHardwareBadPropertySizeError), "Device::Device_SetPropertyData: wrong size for the data for kAudioHubCustomPropertyAutomation");
+            CFPropertyListRef theValue = *reinterpret_cast<const CFPropertyListRef *>(inData);
+            ThrowIf((theValue == NULL) || (CFGetTypeID(theValue) != CFArrayGetTypeID()), CAException(kAudioHardwareIllegalOperationError), "Device::Device_SetPropertyData: kAudioHubCustomPropertyAutomation needs an array");
+            CACFArray theEventList((CFArrayRef) theValue, false);
+            std::vector<AutomationQueue::Event> theEvents(theEventList.GetNumberItems());
+            for (UInt32 theIndex = 0; theIndex < theEvents.size(); ++theIndex) {
+                CFDictionaryRef theEventDictionary = NULL;
+                bool isValid = theEventList.GetDictionary(theIndex, theEventDictionary);
+                CACFDictionary theEvent(theEventDictionary, false);
+                isValid = isValid && theEvent.GetFloat64(kAudioHubAutomationKeySampleTime, theEvents[theIndex].mSampleTime);
+                isValid = isValid && theEvent.GetUInt32(kAudioHubAutomationKeyParameter, theEvents[theIndex].mParameter);
+                isValid = isValid && theEvent.GetFloat32(kAudioHubAutomationKeyValue, theEvents[theIndex].mValue);
+                ThrowIf(!isValid || (theEvents[theIndex].mParameter >= AutomationQueue::kNumberParameters), CAException(kAudioHardwareIllegalOperationError), "Device::Device_SetPropertyData: malformed event for kAudioHubCustomPropertyAutomation");
+                theEvents[theIndex].mValue = std::min(1.0f, std::max(0.0f, theEvents[theIndex].mValue));
+            }
+            if (!theEvents.empty()) {
+                ScheduleAutomation(&theEvents[0], (UInt32) theEvents.size());
+            }
+            break;
+        }
+#endif
+
         default:
             CAObject::SetPropertyData(inObjectID, inClientPID, inAddress, inQualifierDataSize, inQualifierData, inDataSize, inData);
             break;
@@ -1015,8 +1186,8 @@ void Device::Stream_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
         {
             ThrowIf(inDataSize < sizeof(UInt32), CAException(kAudioHardwareBadPropertySizeError), "Device::Stream_GetPropertyData: not enough space for the return value of kAudioStreamPropertyIsActive for the stream");
 
-            //	lock the state mutex
-            CAMutex::Locker theStateLocker(mStateMutex);
+            //	take the state lock shared, this only reads
+            CASharedMutex::SharedLocker theStateLocker(mStateMutex);
 
             //	return the requested value
             *reinterpret_cast<UInt32 *>(outData) = (UInt32) ((inAddress.mScope == kAudioObjectPropertyScopeInput) ? mInputStreamIsActive : mOutputStreamIsActive);
@@ -1065,8 +1236,8 @@ void Device::Stream_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
         {
             ThrowIf(inDataSize < sizeof(AudioStreamBasicDescription), CAException(kAudioHardwareBadPropertySizeError), "Device::Stream_GetPropertyData: not enough space for the return value of kAudioStreamPropertyVirtualFormat for the stream");
 
-            //	lock the state mutex
-            CAMutex::Locker theStateLocker(mStateMutex);
+            //	take the state lock shared, this only reads
+            CASharedMutex::SharedLocker theStateLocker(mStateMutex);
 
             reinterpret_cast<AudioStreamBasicDescription *>(outData)->mSampleRate = static_cast<Float64>(mStreamDescription.mSampleRate);
             reinterpret_cast<AudioStreamBasicDescription *>(outData)->mFormatID = mStreamDescription.mFormatID;
@@ -1085,8 +1256,8 @@ void Device::Stream_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
             //	This returns an array of AudioStreamRangedDescriptions that describe what
             //	formats are supported.
 
-            //	lock the state mutex
-            CAMutex::Locker theStateLocker(mStateMutex);
+            //	take the state lock shared, this only reads
+            CASharedMutex::SharedLocker theStateLocker(mStateMutex);
 
             //	Calculate the number of items that have been requested. Note that this
             //	number is allowed to be smaller than the actual size of the list. In such
@@ -1156,7 +1327,7 @@ void Device::Stream_SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
             bool isChanged = false;
             //	we need to lock around getting the current stream description to compare against the new one
             {
-                CAMutex::Locker theStateLocker(mStateMutex);
+                CASharedMutex::SharedLocker theStateLocker(mStateMutex);
                 isChanged = (theNewFormat->mSampleRate != mStreamDescription.mSampleRate
                         || theNewFormat->mFormatFlags != mStreamDescription.mFormatFlags
                         || theNewFormat->mBytesPerPacket != mStreamDescription.mBytesPerPacket
@@ -1168,7 +1339,7 @@ void Device::Stream_SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID,
                 AudioStreamBasicDescription *format = new AudioStreamBasicDescription(*theNewFormat);
                 //	we dispatch this so that the change can happen asynchronously
                 AudioObjectID theDeviceObjectID = GetObjectID();
-                CADispatchQueue::GetGlobalSerialQueue().Dispatch(false, ^{
+                DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneConfiguration, false, ^{
                     PlugIn::Host_RequestDeviceConfigurationChange(theDeviceObjectID, kHub_StreamFormatChange, format);
                 });
             }
@@ -1323,12 +1494,11 @@ void Device::Control_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID
             //	This returns the value of the control in the normalized range of 0 to 1.
         {
             ThrowIf(inDataSize < sizeof(Float32), CAException(kAudioHardwareBadPropertySizeError), "Device::Control_GetPropertyData: not enough space for the return value of kAudioLevelControlPropertyScalarValue for the volume control");
-            CAMutex::Locker theStateLocker(mStateMutex);
             if (inObjectID == mInputMasterVolumeControlObjectID) {
-                *reinterpret_cast<Float32 *>(outData) = mMasterInputVolume;
+                *reinterpret_cast<Float32 *>(outData) = mMasterInputVolume.load(std::memory_order_relaxed);
             }
             else {
-                *reinterpret_cast<Float32 *>(outData) = mMasterOutputVolume;
+                *reinterpret_cast<Float32 *>(outData) = mMasterOutputVolume.load(std::memory_order_relaxed);
             }
             outDataSize = sizeof(Float32);
         }
@@ -1338,12 +1508,11 @@ void Device::Control_GetPropertyData(AudioObjectID inObjectID, pid_t inClientPID
             //	This returns the dB value of the control.
         {
             ThrowIf(inDataSize < sizeof(Float32), CAException(kAudioHardwareBadPropertySizeError), "Device::Control_GetPropertyData: not enough space for the return value of kAudioLevelControlPropertyDecibelValue for the volume control");
-            CAMutex::Locker theStateLocker(mStateMutex);
             if (inObjectID == mInputMasterVolumeControlObjectID) {
-                *reinterpret_cast<Float32 *>(outData) = mVolumeCurve.ConvertScalarToDB(mMasterInputVolume);
+                *reinterpret_cast<Float32 *>(outData) = mVolumeCurve.ConvertScalarToDB(mMasterInputVolume.load(std::memory_order_relaxed));
             }
             else {
-                *reinterpret_cast<Float32 *>(outData) = mVolumeCurve.ConvertScalarToDB(mMasterOutputVolume);
+                *reinterpret_cast<Float32 *>(outData) = mVolumeCurve.ConvertScalarToDB(mMasterOutputVolume.load(std::memory_order_relaxed));
             }
             outDataSize = sizeof(Float32);
         }
@@ -1408,12 +1577,11 @@ void Device::Control_SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID
             ThrowIf(inDataSize != sizeof(Float32), CAException(kAudioHardwareBadPropertySizeError), "Device::Control_SetPropertyData: wrong size for the data for kAudioLevelControlPropertyScalarValue");
             theNewVolumeValue = *((const Float32 *) inData);
             theNewVolumeValue = std::min(1.0f, std::max(0.0f, theNewVolumeValue));
-            CAMutex::Locker theStateLocker(mStateMutex);
             if (inObjectID == mInputMasterVolumeControlObjectID) {
-                mMasterInputVolume = theNewVolumeValue;
+                mMasterInputVolume.store(theNewVolumeValue, std::memory_order_relaxed);
             }
             else {
-                mMasterOutputVolume = theNewVolumeValue;
+                mMasterOutputVolume.store(theNewVolumeValue, std::memory_order_relaxed);
             }
             sendNotifications = true;
         }
@@ -1428,12 +1596,11 @@ void Device::Control_SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID
             theNewVolumeValue = *((const Float32 *) inData);
             theNewVolumeValue = std::min(kHub_Control_MaxDbVolumeValue, std::max(kHub_Control_MinDBVolumeValue, theNewVolumeValue));
             theNewVolumeValue = mVolumeCurve.ConvertDBToScalar(theNewVolumeValue);
-            CAMutex::Locker theStateLocker(mStateMutex);
             if (inObjectID == mInputMasterVolumeControlObjectID) {
-                mMasterInputVolume = theNewVolumeValue;
+                mMasterInputVolume.store(theNewVolumeValue, std::memory_order_relaxed);
             }
             else {
-                mMasterOutputVolume = theNewVolumeValue;
+                mMasterOutputVolume.store(theNewVolumeValue, std::memory_order_relaxed);
             }
             sendNotifications = true;
         }
@@ -1445,7 +1612,7 @@ void Device::Control_SetPropertyData(AudioObjectID inObjectID, pid_t inClientPID
     };
 
     if (sendNotifications) {
-        CADispatchQueue::GetGlobalSerialQueue().Dispatch(false, ^{
+        DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneNotification, false, ^{
             AudioObjectPropertyAddress theChangedProperties[] = {{kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}, {kAudioLevelControlPropertyDecibelValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}};
             PlugIn::Host_PropertiesChanged(inObjectID, 2, theChangedProperties);
         });
@@ -1467,6 +1634,8 @@ void Device::ResetIO() {
 
 
 void Device::StartIO() {
+    Materialize();
+
     //	Starting/Stopping IO needs to be reference counted due to the possibility of multiple clients starting IO
     CAMutex::Locker theStateLocker(mStateMutex);
 
@@ -1475,7 +1644,14 @@ void Device::StartIO() {
 
     //	we only tell the hardware to start if this is the first time IO has been started
     if (mStartCount == 0) {
+        SetUpNoiseReducer();
         ResetIO();
+
+        //  a task that is still around from the last run keeps going
+        if (!mIsPostingAutomatedVolumeChanges) {
+            mIsPostingAutomatedVolumeChanges = true;
+            PostAutomatedVolumeChanges(GetObjectID());
+        }
     }
     ++mStartCount;
 }
@@ -1488,12 +1664,47 @@ void Device::StopIO() {
     if (mStartCount == 1) {
         mStartCount = 0;
         mRingBuffer.Deallocate();
+
+        //  the sample times of the next run start over, so the events left are meaningless
+        mAutomationQueue->Clear();
     }
     else if (mStartCount > 1) {
         --mStartCount;
     }
 }
 
+void Device::PostAutomatedVolumeChanges(AudioObjectID inDeviceObjectID) {
+    DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneNotification, kVolumeNotificationIntervalNanos, ^{
+        CATry;
+            CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(inDeviceObjectID));
+            if (!theDevice.IsValid()) {
+                return;
+            }
+
+            //  IO has stopped for good once the count is 0, so the changes taken below are the last
+            bool isRunning;
+            {
+                CAMutex::Locker theStateLocker(theDevice->mStateMutex);
+                isRunning = theDevice->mStartCount > 0;
+                theDevice->mIsPostingAutomatedVolumeChanges = isRunning;
+            }
+
+            UInt32 theChanges = theDevice->mAutomatedVolumeChanges.exchange(0, std::memory_order_relaxed);
+            AudioObjectPropertyAddress theChangedProperties[] = {{kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}, {kAudioLevelControlPropertyDecibelValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}};
+            if ((theChanges & (1 << AutomationQueue::kParameterInputVolume)) != 0) {
+                PlugIn::Host_PropertiesChanged(theDevice->mInputMasterVolumeControlObjectID, 2, theChangedProperties);
+            }
+            if ((theChanges & (1 << AutomationQueue::kParameterOutputVolume)) != 0) {
+                PlugIn::Host_PropertiesChanged(theDevice->mOutputMasterVolumeControlObjectID, 2, theChangedProperties);
+            }
+
+            if (isRunning) {
+                PostAutomatedVolumeChanges(inDeviceObjectID);
+            }
+        CACatch;
+    });
+}
+
 void Device::GetZeroTimeStamp(Float64 &outSampleTime, UInt64 &outHostTime, UInt64 &outSeed) {
     if (mTimeline != mCurrentTimeLine) {
         mCurrentTimeLine = mTimeline;
@@ -1546,6 +1757,8 @@ void Device::WillDoIOOperation(UInt32 inOperationID, bool &outWillDo, bool &outW
 }
 
 void Device::BeginIOOperation(UInt32 /*inOperationID*/, UInt32 /*inIOBufferFrameSize*/, const AudioServerPlugInIOCycleInfo &inIOCycleInfo) {
+    //  in test builds everything from here to EndIOOperation is checked for blocking calls
+    CARealTimeChecker::BeginScope();
 }
 
 void Device::DoIOOperation(AudioObjectID inStreamObjectID, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo &inIOCycleInfo, void *ioMainBuffer, void * /*ioSecondaryBuffer*/) {
@@ -1563,6 +1776,7 @@ void Device::DoIOOperation(AudioObjectID inStreamObjectID, UInt32 inOperationID,
 }
 
 void Device::EndIOOperation(UInt32 /*inOperationID*/, UInt32 /*inIOBufferFrameSize*/, const AudioServerPlugInIOCycleInfo &inIOCycleInfo) {
+    CARealTimeChecker::EndScope();
 }
 
 inline void MakeBufferSilent(AudioBufferList *ioData) {
@@ -1570,6 +1784,22 @@ inline void MakeBufferSilent(AudioBufferList *ioData) {
         memset(ioData->mBuffers[i].mData, 0, ioData->mBuffers[i].mDataByteSize);
 }
 
+//  scales an interleaved buffer by ioVolume, splitting it at the frames where automation of the
+//  parameter changes the volume, returns whether it did. A volume that was set while the buffer was
+//  scaled wins over the automation.
+inline bool ApplyVolume(AutomationQueue *inAutomationQueue, UInt32 inParameter, Float64 inSampleTime, UInt32 inNumberFrames, UInt32 inNumberChannels, Float32 *ioBuffer, std::atomic<Float32> &ioVolume) {
+    Float32 theOldVolume = ioVolume.load(std::memory_order_relaxed);
+    Float32 theVolume = theOldVolume;
+    UInt32 theFrame = 0;
+    while (theFrame < inNumberFrames) {
+        UInt32 theNumberFrames = inAutomationQueue->NextSegment(inParameter, inSampleTime + theFrame, inNumberFrames - theFrame, theVolume);
+        Float32 *theSegment = ioBuffer + theFrame * inNumberChannels;
+        vDSP_vsmul(theSegment, 1, &theVolume, theSegment, 1, theNumberFrames * inNumberChannels);
+        theFrame += theNumberFrames;
+    }
+    return (theVolume != theOldVolume) && ioVolume.compare_exchange_strong(theOldVolume, theVolume, std::memory_order_relaxed);
+}
+
 void Device::ReadInputData(UInt32 inIOBufferFrameSize, Float64 inSampleTime, void *outBuffer) {
     AudioBuffer buffer;
     buffer.mDataByteSize = inIOBufferFrameSize * mStreamDescription.mBytesPerFrame;
@@ -1592,19 +1822,29 @@ void Device::ReadInputData(UInt32 inIOBufferFrameSize, Float64 inSampleTime, voi
             DebugMessage("Device::ReadInputData: RingBufferError Unknown");
         }
         MakeBufferSilent(&bufferList);
-        return;
     }
 
-    for (int channel = 0; channel < mStreamDescription.mChannelsPerFrame; ++channel) {
-        vDSP_vsmul((Float32 *) outBuffer + channel, mStreamDescription.mChannelsPerFrame, &mMasterOutputVolume,
-                (Float32 *) outBuffer + channel, mStreamDescription.mChannelsPerFrame, inIOBufferFrameSize);
+    //  silence is scaled as well, so that automation due in this buffer is not applied late
+    mAutomationQueue->Drain();
+    if (ApplyVolume(mAutomationQueue, AutomationQueue::kParameterOutputVolume, inSampleTime, inIOBufferFrameSize, mStreamDescription.mChannelsPerFrame, (Float32 *) outBuffer, mMasterOutputVolume)) {
+        mAutomatedVolumeChanges.fetch_or(1 << AutomationQueue::kParameterOutputVolume, std::memory_order_relaxed);
     }
 }
 
 void Device::WriteOutputData(UInt32 inIOBufferFrameSize, Float64 inSampleTime, void *inBuffer) {
-    for (int channel = 0; channel < mStreamDescription.mChannelsPerFrame; ++channel) {
-        vDSP_vsmul((Float32 *) inBuffer + channel, mStreamDescription.mChannelsPerFrame, &mMasterInputVolume,
-                (Float32 *) inBuffer + channel, mStreamDescription.mChannelsPerFrame, inIOBufferFrameSize);
+    mAutomationQueue->Drain();
+    if (ApplyVolume(mAutomationQueue, AutomationQueue::kParameterInputVolume, inSampleTime, inIOBufferFrameSize, mStreamDescription.mChannelsPerFrame, (Float32 *) inBuffer, mMasterInputVolume)) {
+        mAutomatedVolumeChanges.fetch_or(1 << AutomationQueue::kParameterInputVolume, std::memory_order_relaxed);
+    }
+
+    if (mNoiseReducer != nullptr) {
+        mNoiseReducer->Process((Float32 *) inBuffer, inIOBufferFrameSize);
+    }
+
+    //  hand the block to the analyzer, this is a single copy and never blocks
+    SpectrumAnalyzer *theAnalyzer = GetSpectrumAnalyzer();
+    if (theAnalyzer != nullptr) {
+        theAnalyzer->Write((const Float32 *) inBuffer, inIOBufferFrameSize);
     }
 
     AudioBuffer buffer;
@@ -1633,6 +1873,7 @@ void Device::WriteOutputData(UInt32 inIOBufferFrameSize, Float64 inSampleTime, v
 #pragma mark Implementation
 
 void Device::PerformConfigChange(UInt64 inChangeAction, void *inChangeInfo) {
+    Materialize();
     if (inChangeAction == kHub_StreamFormatChange) {
         AudioStreamBasicDescription *theNewFormat = reinterpret_cast<AudioStreamBasicDescription *>(inChangeInfo);
         ThrowIfNULL(theNewFormat, CAException(kAudioHardwareIllegalOperationError), "Device::PerformConfigChange: illegal data for kHub_DeviceConfigurationChange");
@@ -1661,11 +1902,88 @@ void Device::PerformConfigChange(UInt64 inChangeAction, void *inChangeInfo) {
 
         delete theNewSampleRate;
     }
+
+    //  the analyzer's bands depend on the sample rate, IO is stopped during the change so the
+    //  analyzer can be replaced. Property reads copy its frame with the state lock held shared, so
+    //  it is only deleted with the lock held exclusively.
+    {
+        CAMutex::Locker theStateLocker(mStateMutex);
+        SpectrumAnalyzer *theAnalyzer = GetSpectrumAnalyzer();
+        if ((theAnalyzer != nullptr) && (theAnalyzer->GetSampleRate() != mStreamDescription.mSampleRate)) {
+            bool theWasEnabled = theAnalyzer->IsEnabled();
+            mSpectrumAnalyzer.store(new SpectrumAnalyzer(mStreamDescription.mChannelsPerFrame, mStreamDescription.mSampleRate), std::memory_order_release);
+            delete theAnalyzer;
+            GetSpectrumAnalyzer()->SetEnabled(theWasEnabled);
+        }
+    }
+
+    //  the noise reducer's time constants depend on the sample rate as well
+    if ((mNoiseReducer != nullptr) && (mNoiseReducer->GetSampleRate() != mStreamDescription.mSampleRate)) {
+        CAMutex::Locker theStateLocker(mStateMutex);
+        SetUpNoiseReducer();
+    }
+}
+
+void Device::SetUpNoiseReducer() {
+    //  called with IO stopped, the reducer is kept across starts as long as its format still fits
+    bool theWasActive = mNoiseReducer != nullptr;
+    if (mNoiseReduction <= 0.0f) {
+        delete mNoiseReducer;
+        mNoiseReducer = nullptr;
+    }
+    else if ((mNoiseReducer != nullptr) &&
+             (mNoiseReducer->GetReduction() == mNoiseReduction) &&
+             (mNoiseReducer->GetNumberChannels() == mStreamDescription.mChannelsPerFrame) &&
+             (mNoiseReducer->GetSampleRate() == mStreamDescription.mSampleRate)) {
+        mNoiseReducer->Reset();
+    }
+    else {
+        NoiseReducer *theNoiseReducer = new NoiseReducer(mStreamDescription.mChannelsPerFrame, mStreamDescription.mSampleRate, mNoiseReduction);
+        delete mNoiseReducer;
+        mNoiseReducer = theNoiseReducer;
+    }
+
+    //  the input latency follows the reducer that is actually there
+    if ((mNoiseReducer != nullptr) != theWasActive) {
+        AudioObjectPropertyAddress theChangedProperties[] = {{kAudioDevicePropertyLatency, kAudioObjectPropertyScopeInput, kAudioObjectPropertyElementMaster}};
+        PlugIn::Host_PropertiesChanged(GetObjectID(), 1, theChangedProperties);
+    }
+}
+
+UInt32 Device::GetInputLatency() const {
+    //  the noise reducer delays everything that reaches the input by its overlap-add
+    return mLatencyInput + ((mNoiseReducer != nullptr) ? NoiseReducer::GetLatency() : 0);
+}
+
+void Device::SetSpectrumAnalyzerEnabled(bool inEnabled) {
+    Materialize();
+    CAMutex::Locker theStateLocker(mStateMutex);
+    SpectrumAnalyzer *theAnalyzer = GetSpectrumAnalyzer();
+    if (theAnalyzer == nullptr) {
+        if (!inEnabled) {
+            return;
+        }
+        theAnalyzer = new SpectrumAnalyzer(mStreamDescription.mChannelsPerFrame, mStreamDescription.mSampleRate);
+        mSpectrumAnalyzer.store(theAnalyzer, std::memory_order_release);
+    }
+    theAnalyzer->SetEnabled(inEnabled);
+}
+
+void Device::ScheduleAutomation(const AutomationQueue::Event *inEvents, UInt32 inNumberEvents) {
+    Materialize();
+
+    //  the state mutex makes the property calls the queue's single producer
+    CAMutex::Locker theStateLocker(mStateMutex);
+    ThrowIf(inNumberEvents > mAutomationQueue->GetNumberFreeSlots(), CAException(kAudioHardwareIllegalOperationError), "Device::ScheduleAutomation: too many events pending");
+    mAutomationQueue->Push(inEvents, inNumberEvents);
 }
 
 void Device::AbortConfigChange(UInt64 /*inChangeAction*/, void * /*inChangeInfo*/) {
+    Materialize();
     // we need to be holding the IO and State lock to do this
     CAMutex::Locker theStateLocker(mStateMutex);
     CAMutex::Locker theIOLocker(mIOMutex);
     ResetIO();
-}
\ No newline at end of file
+}
+
+std::atomic<UInt32> Device::sNumberMaterializedDevices(0);
@@ -26,13 +26,21 @@ THE SOFTWARE.
 #define __Driver__
 
 
+#include <atomic>
+#include <mutex>
+
 #include "CACFString.h"
 #include "CAMutex.h"
+#include "CASharedMutex.h"
 #include "CAVolumeCurve.h"
 #include "CAObject.h"
 #include "CARingBuffer.h"
 #include "CAHostTimeBase.h"
 #include "CAStreamRangedDescription.h"
+#include "AutomationQueue.h"
+
+class NoiseReducer;
+class SpectrumAnalyzer;
 
 //	volume control ranges
 #define kHub_Control_MinRawVolumeValue 0
@@ -60,6 +68,25 @@ public:
 protected:
     virtual ~Device();
 
+#pragma mark Materialization
+public:
+    //  A device is published to the HAL with only its IDs, name, UID and current format. The
+    //  volume curve, format list and automation queue are built the first time IO starts or a
+    //  property needs them, so configured but unused devices stay cheap. The mutexes are built
+    //  with the device, Deactivate and the IO path use them without going through Materialize.
+    bool IsMaterialized() const {
+        return mIsMaterialized.load(std::memory_order_acquire);
+    }
+    void Materialize() const;
+
+    static UInt32 GetNumberMaterializedDevices() {
+        return sNumberMaterializedDevices.load(std::memory_order_relaxed);
+    }
+
+private:
+    void MaterializeOnce() const;
+    static bool IsIdentityProperty(const AudioObjectPropertyAddress &inAddress);
+
 #pragma mark Property Operations
 public:
     virtual bool HasProperty(AudioObjectID inObjectID, pid_t inClientPID, const AudioObjectPropertyAddress &inAddress) const;
@@ -116,6 +143,19 @@ public:
     void PerformConfigChange(UInt64 inChangeAction, void *inChangeInfo);
     void AbortConfigChange(UInt64 inChangeAction, void *inChangeInfo);
 
+    //  The analyzer is created the first time it is enabled. Disabling it keeps it around, it is
+    //  only replaced in PerformConfigChange when the sample rate changes, while the HAL has IO
+    //  stopped, so the IO thread never sees it go away. Anything else that uses it off the IO
+    //  thread has to hold the state lock, shared is enough.
+    void SetSpectrumAnalyzerEnabled(bool inEnabled);
+    SpectrumAnalyzer *GetSpectrumAnalyzer() const {
+        return mSpectrumAnalyzer.load(std::memory_order_acquire);
+    }
+
+    //  queues volume changes at device sample times, the whole batch or nothing. Events that are
+    //  still pending when the last client stops IO are dropped.
+    void ScheduleAutomation(const AutomationQueue::Event *inEvents, UInt32 inNumberEvents);
+
 private:
     enum {
         kNumberOfSubObjects = 4,
@@ -129,8 +169,14 @@ private:
         kNumberOfControls = 2
     };
 
-    CAMutex *mStateMutex;
-    CAMutex *mIOMutex;
+    mutable std::once_flag mMaterializeOnce;
+    mutable std::atomic<bool> mIsMaterialized;
+    static std::atomic<UInt32> sNumberMaterializedDevices;
+
+    //  property reads take the state lock shared and never wait for each other, writers only hold it
+    //  for a moment, so waiting writers spin before they park
+    CASharedMutex *const mStateMutex;
+    CAMutex *const mIOMutex;
 
     CACFString mDeviceUID;
     CACFString mDeviceName;
@@ -155,6 +201,16 @@ public:
     UInt32 GetChannels() {
         return this->mStreamDescription.mChannelsPerFrame;
     }
+
+    //  the most the noise reducer attenuates, in dB, 0 turns it off. Takes effect when IO starts,
+    //  which is also when the input latency changes.
+    void SetNoiseReduction(Float32 inDecibels) {
+        this->mNoiseReduction = inDecibels > 0.0f ? inDecibels : 0.0f;
+    }
+
+    Float32 GetNoiseReduction() const {
+        return this->mNoiseReduction;
+    }
 private:
     // IO
     UInt64 mStartCount;
@@ -170,9 +226,29 @@ private:
     CARingBuffer mRingBuffer;
     UInt32 mRingBufferSize;
 
+    // Spectrum
+    std::atomic<SpectrumAnalyzer *> mSpectrumAnalyzer;
+
+    // Automation
+    mutable AutomationQueue *mAutomationQueue;
+
+    //  The IO thread sets a bit per AutomationQueue parameter when automation changed that volume,
+    //  a task on the notification lane turns the bits into notifications for the volume controls
+    //  every kVolumeNotificationIntervalNanos for as long as IO is running.
+    static const UInt64 kVolumeNotificationIntervalNanos = 20 * 1000 * 1000;
+    static void PostAutomatedVolumeChanges(AudioObjectID inDeviceObjectID);
+    std::atomic<UInt32> mAutomatedVolumeChanges;
+    bool mIsPostingAutomatedVolumeChanges;
+
+    // Noise Reduction
+    void SetUpNoiseReducer();
+    UInt32 GetInputLatency() const;
+    Float32 mNoiseReduction;
+    NoiseReducer *mNoiseReducer;
+
     // Steam
     typedef std::vector<CAStreamBasicDescription> StreamDescriptionList;
-    StreamDescriptionList mStreamDescriptions;
+    mutable StreamDescriptionList mStreamDescriptions;
     AudioStreamBasicDescription mStreamDescription;
 
     AudioObjectID mInputStreamObjectID;
@@ -185,9 +261,10 @@ private:
     SInt32 mInputMasterVolumeControlRawValueShadow;
     AudioObjectID mOutputMasterVolumeControlObjectID;
     SInt32 mOutputMasterVolumeControlRawValueShadow;
-    CAVolumeCurve mVolumeCurve;
-    Float32 mMasterInputVolume;
-    Float32 mMasterOutputVolume;
+    mutable CAVolumeCurve mVolumeCurve;
+    //  the IO thread steps these along the automation while the controls read and set them
+    std::atomic<Float32> mMasterInputVolume;
+    std::atomic<Float32> mMasterOutputVolume;
 
 public:
     enum class Offset : UInt32 {
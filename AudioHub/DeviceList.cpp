@@ -23,11 +23,13 @@ THE SOFTWARE.
 */
 
 #include "DeviceList.h"
-#include "CADispatchQueue.h"
+#include "DispatchLanes.h"
 #include "CACFArray.h"
 #include "CACFNumber.h"
 #include "CAException.h"
 #include "PlugIn.h"
+#include "BinarySettings.h"
+#include "Profiler.h"
 
 DeviceList::DeviceList()
     : mDeviceListMutex(new CAMutex("Hub Device List")) {
@@ -91,7 +93,7 @@ void DeviceList::RemoveAllDevices() {
         AudioObjectID theDeadDeviceObjectID = theDeviceIterator->mDeviceObjectID;
         theDeviceIterator->mDeviceObjectID = 0;
 
-        CADispatchQueue::GetGlobalSerialQueue().Dispatch(false, ^{
+        DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneReclamation, false, ^{
             CATry;
                 //	resolve the device ID to an object
                 CAObjectReleaser<Device> theDeadDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(theDeadDeviceObjectID));
@@ -136,6 +138,9 @@ CFPropertyListRef DeviceList::GetSettings() const {
         deviceSettings.AddCFType(kAudioHubSettingsKeyDeviceName, theDevice->GetDeviceName());
         deviceSettings.AddCFType(kAudioHubSettingsKeyDeviceUID, theDevice->getDeviceUID());
         deviceSettings.AddUInt32(kAudioHubSettingsKeyDeviceChannels, theDevice->GetChannels());
+        if (theDevice->GetNoiseReduction() > 0.0f) {
+            deviceSettings.AddFloat32(kAudioHubSettingsKeyDeviceNoiseReduction, theDevice->GetNoiseReduction());
+        }
         settingsDevices.AppendDictionary(deviceSettings.CopyCFDictionary());
     }
     
@@ -144,6 +149,11 @@ CFPropertyListRef DeviceList::GetSettings() const {
 }
 
 bool DeviceList::SetSettings(CFPropertyListRef propertyList) {
+    ProfileScope(kProfilerPoint_SetSettings);
+    if (BinarySettingsReader::HasMagic(propertyList)) {
+        CFDataRef theData = (CFDataRef)propertyList;
+        return SetBinarySettings(CFDataGetBytePtr(theData), CFDataGetLength(theData));
+    }
     if (CFGetTypeID(propertyList) != CFDictionaryGetTypeID())
         return false;
     
@@ -178,18 +188,60 @@ bool DeviceList::AddDevice(CFPropertyListRef config) {
         if (deviceName.IsValid()) {
             UInt32 deviceChannels = 0;
             device.GetUInt32(kAudioHubSettingsKeyDeviceChannels, deviceChannels);
-            if (deviceChannels > 0 && deviceChannels < kAudioHubMaximumDeviceChannels) {
-                auto theDevice = new Device(CAObjectMap::GetNextObjectID(), (SInt16)deviceChannels);
-                theDevice->setDeviceName(deviceName.CopyCFString());
-                theDevice->setDeviceUID(deviceUUID.CopyCFString());
-                AddDevice(theDevice);
-                return true;
-            }
+            Float32 deviceNoiseReduction = 0.0f;
+            device.GetFloat32(kAudioHubSettingsKeyDeviceNoiseReduction, deviceNoiseReduction);
+            return AddDevice(deviceUUID.GetCFString(), deviceName.GetCFString(), deviceChannels, deviceNoiseReduction);
         }
     }
     return false;
 }
 
+bool DeviceList::AddDevice(CFStringRef inDeviceUID, CFStringRef inDeviceName, UInt32 inDeviceChannels, Float32 inNoiseReduction) {
+    if (inDeviceUID == NULL || inDeviceName == NULL)
+        return false;
+    if (inDeviceChannels > 0 && inDeviceChannels < kAudioHubMaximumDeviceChannels) {
+        auto theDevice = new Device(CAObjectMap::GetNextObjectID(), (SInt16)inDeviceChannels);
+        theDevice->setDeviceName(inDeviceName);
+        theDevice->setDeviceUID(inDeviceUID);
+        theDevice->SetNoiseReduction(inNoiseReduction);
+        AddDevice(theDevice);
+        return true;
+    }
+    return false;
+}
+
+CFDataRef DeviceList::CopyBinarySettings() const {
+    CAMutex::Locker theLocker(mDeviceListMutex);
+    BinarySettingsWriter writer;
+    for(const DeviceInfo &deviceInfo : mDeviceInfoList) {
+        CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(deviceInfo.mDeviceObjectID));
+        ThrowIf(!theDevice.IsValid(), CAException(kAudioHardwareBadObjectError), "CopyBinarySettings: unknown device");
+        writer.AppendDevice(theDevice->getDeviceUID(), theDevice->GetDeviceName(), theDevice->GetChannels(), theDevice->GetNoiseReduction());
+    }
+    return writer.CopyData();
+}
+
+bool DeviceList::SetBinarySettings(const UInt8 *inData, size_t inDataSize) {
+    BinarySettingsReader reader(inData, inDataSize);
+    if (!reader.IsValid())
+        return false;
+
+    RemoveAllDevices();
+    BinarySettingsDevice device;
+    while (reader.GetNextDevice(device)) {
+        CFStringRef deviceUUID = device.CopyUID();
+        CFStringRef deviceName = device.CopyName();
+        AddDevice(deviceUUID, deviceName, device.mChannels, device.mNoiseReduction);
+        if (deviceUUID != NULL)
+            CFRelease(deviceUUID);
+        if (deviceName != NULL)
+            CFRelease(deviceName);
+    }
+
+    //  a truncated record invalidates the reader, keep whatever was read before it
+    return reader.IsValid();
+}
+
 UInt32 DeviceList::NumDevices() {
     return UInt32(mDeviceInfoList.size());
 }
\ No newline at end of file
@@ -43,6 +43,11 @@ public:
     CFPropertyListRef GetSettings() const;
     bool SetSettings(CFPropertyListRef settings);
     bool AddDevice(CFPropertyListRef config);
+    bool AddDevice(CFStringRef inDeviceUID, CFStringRef inDeviceName, UInt32 inDeviceChannels, Float32 inNoiseReduction = 0.0f);
+
+    //  the compact encoding from BinarySettings.h, SetSettings accepts it as a CFData as well
+    CFDataRef CopyBinarySettings() const;
+    bool SetBinarySettings(const UInt8 *inData, size_t inDataSize);
     UInt32 NumDevices();
     
 protected:
@@ -0,0 +1,200 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "DispatchLanes.h"
+
+#include <Block.h>
+#include <CoreAudio/AudioHardwareBase.h>
+#include <string.h>
+
+#include "CADispatchQueue.h"
+#include "CAHostTimeBase.h"
+#include "CADebugMacros.h"
+#include "CAException.h"
+
+static const char *const kLaneNames[DispatchLanes::kNumberLanes] = { "configuration", "notification", "persistence", "reclamation" };
+
+#pragma mark Construction/Destruction
+
+DispatchLanes::DispatchLanes(CADispatchQueue &inQueue)
+        : mQueue(inQueue),
+          mMutex("Hub Dispatch Lanes"),
+          mNumberDelayedTasks(0) {
+    memset(mStatistics, 0, sizeof(mStatistics));
+}
+
+DispatchLanes::~DispatchLanes() {
+    //  a delayed task still references this object, so the lanes have to outlive their delayed tasks
+    Assert(mNumberDelayedTasks == 0, "DispatchLanes::~DispatchLanes: destroyed with delayed tasks pending");
+
+    //  run everything that is already queued
+    mQueue.Dispatch(true, ^{
+    });
+}
+
+#pragma mark Operations
+
+void DispatchLanes::Dispatch(Lane inLane, bool inDoSync, dispatch_block_t inTask) {
+    ThrowIf(inLane >= kNumberLanes, CAException(kAudioHardwareIllegalOperationError), "DispatchLanes::Dispatch: unknown lane");
+    if (!inDoSync) {
+        Enqueue(inLane, Block_copy(inTask));
+        return;
+    }
+
+    //  like a sync dispatch onto the queue, this deadlocks when called from a task on the queue
+    dispatch_semaphore_t theSemaphore = dispatch_semaphore_create(0);
+    Enqueue(inLane, Block_copy(^{
+        inTask();
+        dispatch_semaphore_signal(theSemaphore);
+    }));
+    dispatch_semaphore_wait(theSemaphore, DISPATCH_TIME_FOREVER);
+    dispatch_release(theSemaphore);
+}
+
+void DispatchLanes::Dispatch(Lane inLane, UInt64 inNanoseconds, dispatch_block_t inTask) {
+    ThrowIf(inLane >= kNumberLanes, CAException(kAudioHardwareIllegalOperationError), "DispatchLanes::Dispatch: unknown lane");
+    if (inNanoseconds == 0) {
+        Enqueue(inLane, Block_copy(inTask));
+        return;
+    }
+
+    {
+        CAMutex::Locker theLocker(mMutex);
+        ++mNumberDelayedTasks;
+    }
+    dispatch_block_t theTask = Block_copy(inTask);
+    mQueue.Dispatch(inNanoseconds, ^{
+        {
+            CAMutex::Locker theLocker(mMutex);
+            --mNumberDelayedTasks;
+        }
+        Enqueue(inLane, theTask);
+    });
+}
+
+DispatchLanes &DispatchLanes::GetGlobalLanes() {
+    dispatch_once_f(&sGlobalLanesInitialized, NULL, InitializeGlobalLanes);
+    ThrowIfNULL(sGlobalLanes, CAException('nope'), "DispatchLanes::GetGlobalLanes: there are no global lanes");
+    return *sGlobalLanes;
+}
+
+#pragma mark Statistics
+
+void DispatchLanes::GetStatistics(Lane inLane, Statistics &outStatistics) const {
+    ThrowIf(inLane >= kNumberLanes, CAException(kAudioHardwareIllegalOperationError), "DispatchLanes::GetStatistics: unknown lane");
+    CAMutex::Locker theLocker(mMutex);
+    outStatistics = mStatistics[inLane];
+}
+
+UInt32 DispatchLanes::GetDepth(Lane inLane) const {
+    ThrowIf(inLane >= kNumberLanes, CAException(kAudioHardwareIllegalOperationError), "DispatchLanes::GetDepth: unknown lane");
+    CAMutex::Locker theLocker(mMutex);
+    return mStatistics[inLane].mDepth;
+}
+
+void DispatchLanes::ResetStatistics() {
+    CAMutex::Locker theLocker(mMutex);
+    for (UInt32 theLane = 0; theLane < kNumberLanes; ++theLane) {
+        Statistics &theStatistics = mStatistics[theLane];
+        theStatistics.mMaximumDepth = theStatistics.mDepth;
+        theStatistics.mNumberExecutedTasks = 0;
+        theStatistics.mTotalWaitNanos = 0;
+        theStatistics.mMaximumWaitNanos = 0;
+    }
+}
+
+void DispatchLanes::Dump() const {
+    CAMutex::Locker theLocker(mMutex);
+    for (UInt32 theLane = 0; theLane < kNumberLanes; ++theLane) {
+        const Statistics &theStatistics = mStatistics[theLane];
+        UInt64 theAverageWait = theStatistics.mNumberExecutedTasks > 0 ? theStatistics.mTotalWaitNanos / theStatistics.mNumberExecutedTasks : 0;
+        DebugMsg("DispatchLanes::Dump: %s depth: %u maximum depth: %u executed: %llu average wait: %llu ns maximum wait: %llu ns",
+                 kLaneNames[theLane], theStatistics.mDepth, theStatistics.mMaximumDepth, theStatistics.mNumberExecutedTasks, theAverageWait, theStatistics.mMaximumWaitNanos);
+    }
+}
+
+#pragma mark Implementation
+
+void DispatchLanes::Enqueue(Lane inLane, dispatch_block_t inCopiedTask) {
+    {
+        CAMutex::Locker theLocker(mMutex);
+        Task theTask = { inCopiedTask, CAHostTimeBase::GetCurrentTimeInNanos() };
+        mTasks[inLane].push_back(theTask);
+
+        Statistics &theStatistics = mStatistics[inLane];
+        ++theStatistics.mDepth;
+        if (theStatistics.mDepth > theStatistics.mMaximumDepth) {
+            theStatistics.mMaximumDepth = theStatistics.mDepth;
+        }
+    }
+
+    //  one pump per task; the pump picks the task, so it doesn't have to be this one
+    mQueue.Dispatch(false, this, RunNext);
+}
+
+void DispatchLanes::RunNext() {
+    dispatch_block_t theBlock = NULL;
+    {
+        CAMutex::Locker theLocker(mMutex);
+        for (UInt32 theLane = 0; theLane < kNumberLanes; ++theLane) {
+            if (!mTasks[theLane].empty()) {
+                const Task &theTask = mTasks[theLane].front();
+                UInt64 theNow = CAHostTimeBase::GetCurrentTimeInNanos();
+                UInt64 theWait = theNow > theTask.mEnqueueTime ? theNow - theTask.mEnqueueTime : 0;
+                theBlock = theTask.mBlock;
+                mTasks[theLane].pop_front();
+
+                Statistics &theStatistics = mStatistics[theLane];
+                --theStatistics.mDepth;
+                ++theStatistics.mNumberExecutedTasks;
+                theStatistics.mTotalWaitNanos += theWait;
+                if (theWait > theStatistics.mMaximumWaitNanos) {
+                    theStatistics.mMaximumWaitNanos = theWait;
+                }
+                break;
+            }
+        }
+    }
+
+    if (theBlock != NULL) {
+        theBlock();
+        Block_release(theBlock);
+    }
+}
+
+void DispatchLanes::RunNext(void *inLanes) {
+    static_cast<DispatchLanes *>(inLanes)->RunNext();
+}
+
+void DispatchLanes::InitializeGlobalLanes(void *) {
+    try {
+        sGlobalLanes = new DispatchLanes(CADispatchQueue::GetGlobalSerialQueue());
+    }
+    catch (...) {
+        sGlobalLanes = NULL;
+    }
+}
+
+DispatchLanes *DispatchLanes::sGlobalLanes = NULL;
+dispatch_once_t DispatchLanes::sGlobalLanesInitialized = 0;
@@ -0,0 +1,108 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __DispatchLanes__
+#define __DispatchLanes__
+
+#include <CoreAudio/CoreAudioTypes.h>
+#include <dispatch/dispatch.h>
+
+#include <deque>
+
+#include "CAMutex.h"
+
+class CADispatchQueue;
+
+//  Splits the plug-in's background work into prioritized lanes on top of one serial dispatch queue.
+//  Every dispatched task posts one pump to the queue and every pump runs the first task of the
+//  highest priority lane that has one, so tasks run one at a time and in order within their lane,
+//  and a configuration change waits for at most the task that is already running no matter how
+//  much reclamation work is queued ahead of it. Delayed tasks join their lane once they are due.
+class DispatchLanes {
+public:
+    enum Lane {
+        kLaneConfiguration = 0,
+        kLaneNotification = 1,
+        kLanePersistence = 2,
+        kLaneReclamation = 3,
+        kNumberLanes = 4
+    };
+
+    struct Statistics {
+        UInt32 mDepth;
+        UInt32 mMaximumDepth;
+        UInt64 mNumberExecutedTasks;
+        UInt64 mTotalWaitNanos;
+        UInt64 mMaximumWaitNanos;
+    };
+
+#pragma mark Construction/Destruction
+public:
+    DispatchLanes(CADispatchQueue &inQueue);
+    ~DispatchLanes();
+
+private:
+    DispatchLanes(const DispatchLanes &);
+    DispatchLanes &operator=(const DispatchLanes &);
+
+#pragma mark Operations
+public:
+    void Dispatch(Lane inLane, bool inDoSync, dispatch_block_t inTask);
+    void Dispatch(Lane inLane, UInt64 inNanoseconds, dispatch_block_t inTask);
+
+    //  the lanes on top of CADispatchQueue::GetGlobalSerialQueue
+    static DispatchLanes &GetGlobalLanes();
+
+#pragma mark Statistics
+public:
+    //  the wait time of a task is the time from when it was dispatched (or became due) until it started
+    void GetStatistics(Lane inLane, Statistics &outStatistics) const;
+    UInt32 GetDepth(Lane inLane) const;
+    void ResetStatistics();
+    void Dump() const;
+
+#pragma mark Implementation
+private:
+    struct Task {
+        dispatch_block_t mBlock;
+        UInt64 mEnqueueTime;
+    };
+
+    void Enqueue(Lane inLane, dispatch_block_t inCopiedTask);
+    void RunNext();
+    static void RunNext(void *inLanes);
+    static void InitializeGlobalLanes(void *);
+
+    CADispatchQueue &mQueue;
+
+    mutable CAMutex mMutex;
+    std::deque<Task> mTasks[kNumberLanes];
+    Statistics mStatistics[kNumberLanes];
+    UInt32 mNumberDelayedTasks;
+
+    static DispatchLanes *sGlobalLanes;
+    static dispatch_once_t sGlobalLanesInitialized;
+};
+
+#endif /* __DispatchLanes__ */
@@ -29,6 +29,11 @@ THE SOFTWARE.
 
 #include "CACFObject.h"
 #include "CAException.h"
+#include "CAHostTimeBase.h"
+#include "CAMutex.h"
+#include "Profiler.h"
+
+#include <atomic>
 
 static HRESULT AudioHub_QueryInterface(void *inDriver, REFIID inUUID, LPVOID *outInterface);
 static ULONG AudioHub_AddRef(void *inDriver);
@@ -84,6 +89,68 @@ static AudioServerPlugInDriverInterface *gAudioServerPlugInDriverInterfacePtr =
 static AudioServerPlugInDriverRef gAudioServerPlugInDriverRef = &gAudioServerPlugInDriverInterfacePtr;
 static UInt32 gAudioServerPlugInDriverRefCount = 1;
 
+#pragma mark Running Devices
+
+//  the devices with IO running, so that the IO entry points find them without taking the lock of
+//  the object map. The first StartIO of a device retains and adds it and the last StopIO removes
+//  and releases it, even when the device fails to stop. The HAL makes no IO calls for a device
+//  outside of that, and the IO entry points answer one with kAudioHardwareNotRunningError.
+static const UInt32 kMaximumNumberRunningDevices = 64;
+
+struct RunningDevice {
+    std::atomic<AudioObjectID> mObjectID;
+    std::atomic<Device *> mDevice;
+    UInt64 mStartCount;     //  guarded by gRunningDevicesMutex
+};
+
+static RunningDevice gRunningDevices[kMaximumNumberRunningDevices];
+static CAMutex gRunningDevicesMutex("AudioHub Running Devices");
+
+static void AddRunningDevice(Device *inDevice) {
+    CAMutex::Locker theLocker(gRunningDevicesMutex);
+    RunningDevice *theFreeSlot = NULL;
+    for (RunningDevice &theSlot : gRunningDevices) {
+        AudioObjectID theObjectID = theSlot.mObjectID.load(std::memory_order_relaxed);
+        if (theObjectID == inDevice->GetObjectID()) {
+            ++theSlot.mStartCount;
+            return;
+        }
+        if ((theObjectID == kAudioObjectUnknown) && (theFreeSlot == NULL)) {
+            theFreeSlot = &theSlot;
+        }
+    }
+    ThrowIfNULL(theFreeSlot, CAException(kAudioHardwareIllegalOperationError), "AddRunningDevice: too many devices are running");
+    CAObjectMap::RetainObject(inDevice);
+    theFreeSlot->mDevice.store(inDevice, std::memory_order_relaxed);
+    theFreeSlot->mStartCount = 1;
+    theFreeSlot->mObjectID.store(inDevice->GetObjectID(), std::memory_order_release);
+}
+
+static void RemoveRunningDevice(AudioObjectID inObjectID) {
+    CAMutex::Locker theLocker(gRunningDevicesMutex);
+    for (RunningDevice &theSlot : gRunningDevices) {
+        if (theSlot.mObjectID.load(std::memory_order_relaxed) == inObjectID) {
+            if (--theSlot.mStartCount == 0) {
+                theSlot.mObjectID.store(kAudioObjectUnknown, std::memory_order_release);
+                CAObjectMap::ReleaseObject(theSlot.mDevice.exchange(NULL, std::memory_order_relaxed));
+            }
+            return;
+        }
+    }
+}
+
+//  never blocks or allocates, so it is safe on the IO thread
+static Device *FindRunningDevice(AudioObjectID inObjectID) {
+    if (inObjectID != kAudioObjectUnknown) {
+        for (RunningDevice &theSlot : gRunningDevices) {
+            if (theSlot.mObjectID.load(std::memory_order_acquire) == inObjectID) {
+                return theSlot.mDevice.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return NULL;
+}
+
 #pragma mark Factory
 
 extern "C" void* AudioHub_Create(CFAllocatorRef /*inAllocator*/, CFUUIDRef inRequestedTypeUUID) {
@@ -98,6 +165,7 @@ extern "C" void* AudioHub_Create(CFAllocatorRef /*inAllocator*/, CFUUIDRef inReq
 #pragma mark Inheritence
 
 static HRESULT AudioHub_QueryInterface(void *inDriver, REFIID inUUID, LPVOID *outInterface) {
+    ProfileScope(kProfilerPoint_QueryInterface);
     HRESULT theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_QueryInterface: bad driver reference");
@@ -120,6 +188,7 @@ static HRESULT AudioHub_QueryInterface(void *inDriver, REFIID inUUID, LPVOID *ou
 }
 
 static ULONG AudioHub_AddRef(void *inDriver) {
+    ProfileScope(kProfilerPoint_AddRef);
     ULONG theAnswer = 0;
     FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "AudioHub_AddRef: bad driver reference");
     FailIf(gAudioServerPlugInDriverRefCount == UINT32_MAX, Done, "AudioHub_AddRef: out of references");
@@ -130,6 +199,7 @@ static ULONG AudioHub_AddRef(void *inDriver) {
 }
 
 static ULONG AudioHub_Release(void *inDriver) {
+    ProfileScope(kProfilerPoint_Release);
     ULONG theAnswer = 0;
     FailIf(inDriver != gAudioServerPlugInDriverRef, Done, "AudioHub_Release: bad driver reference");
     FailIf(gAudioServerPlugInDriverRefCount == UINT32_MAX, Done, "AudioHub_Release: out of references");
@@ -142,11 +212,15 @@ static ULONG AudioHub_Release(void *inDriver) {
 #pragma mark Basic Operations
 
 static OSStatus AudioHub_Initialize(AudioServerPlugInDriverRef inDriver, AudioServerPlugInHostRef inHost) {
+    ProfileScope(kProfilerPoint_Initialize);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_Initialize: bad driver reference");
+        UInt64 theStartTime = CAHostTimeBase::GetCurrentTime();
         PlugIn::GetInstance().SetHost(inHost);
         PlugIn::GetInstance().RestoreSettings();
+        DebugMsg("AudioHub_Initialize: devices ready after %lld ns, %u materialized",
+                 CAHostTimeBase::HostDeltaToNanos(theStartTime, CAHostTimeBase::GetCurrentTime()), Device::GetNumberMaterializedDevices());
     }
     catch (const CAException &inException) {
         theAnswer = inException.GetError();
@@ -158,22 +232,27 @@ static OSStatus AudioHub_Initialize(AudioServerPlugInDriverRef inDriver, AudioSe
 }
 
 static OSStatus AudioHub_CreateDevice(AudioServerPlugInDriverRef /*inDriver*/, CFDictionaryRef /*inDescription*/, const AudioServerPlugInClientInfo * /*inClientInfo*/, AudioObjectID * /*outDeviceObjectID*/) {
+    ProfileScope(kProfilerPoint_CreateDevice);
     return kAudioHardwareUnsupportedOperationError;
 }
 
 static OSStatus AudioHub_DestroyDevice(AudioServerPlugInDriverRef /*inDriver*/, AudioObjectID /*inDeviceObjectID*/) {
+    ProfileScope(kProfilerPoint_DestroyDevice);
     return kAudioHardwareUnsupportedOperationError;
 }
 
 static OSStatus AudioHub_AddDeviceClient(AudioServerPlugInDriverRef /*inDriver*/, AudioObjectID /*inDeviceObjectID*/, const AudioServerPlugInClientInfo * /*inClientInfo*/) {
+    ProfileScope(kProfilerPoint_AddDeviceClient);
     return 0;
 }
 
 static OSStatus AudioHub_RemoveDeviceClient(AudioServerPlugInDriverRef /*inDriver*/, AudioObjectID /*inDeviceObjectID*/, const AudioServerPlugInClientInfo * /*inClientInfo*/) {
+    ProfileScope(kProfilerPoint_RemoveDeviceClient);
     return 0;
 }
 
 static OSStatus AudioHub_PerformDeviceConfigurationChange(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void *inChangeInfo) {
+    ProfileScope(kProfilerPoint_PerformDeviceConfigurationChange);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_PerformDeviceConfigurationChange: bad driver reference");
@@ -191,6 +270,7 @@ static OSStatus AudioHub_PerformDeviceConfigurationChange(AudioServerPlugInDrive
 }
 
 static OSStatus AudioHub_AbortDeviceConfigurationChange(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void *inChangeInfo) {
+    ProfileScope(kProfilerPoint_AbortDeviceConfigurationChange);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_PerformDeviceConfigurationChange: bad driver reference");
@@ -210,6 +290,7 @@ static OSStatus AudioHub_AbortDeviceConfigurationChange(AudioServerPlugInDriverR
 #pragma mark Property Operations
 
 static Boolean AudioHub_HasProperty(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress *inAddress) {
+    ProfileScope(kProfilerPoint_HasProperty);
     Boolean theAnswer = false;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_HasProperty: bad driver reference");
@@ -228,6 +309,7 @@ static Boolean AudioHub_HasProperty(AudioServerPlugInDriverRef inDriver, AudioOb
 }
 
 static OSStatus AudioHub_IsPropertySettable(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress *inAddress, Boolean *outIsSettable) {
+    ProfileScope(kProfilerPoint_IsPropertySettable);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_IsPropertySettable: bad driver reference");
@@ -252,6 +334,7 @@ static OSStatus AudioHub_IsPropertySettable(AudioServerPlugInDriverRef inDriver,
 }
 
 static OSStatus AudioHub_GetPropertyDataSize(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress *inAddress, UInt32 inQualifierDataSize, const void *inQualifierData, UInt32 *outDataSize) {
+    ProfileScope(kProfilerPoint_GetPropertyDataSize);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_GetPropertyDataSize: bad driver reference");
@@ -276,6 +359,7 @@ static OSStatus AudioHub_GetPropertyDataSize(AudioServerPlugInDriverRef inDriver
 }
 
 static OSStatus AudioHub_GetPropertyData(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress *inAddress, UInt32 inQualifierDataSize, const void *inQualifierData, UInt32 inDataSize, UInt32 *outDataSize, void *outData) {
+    ProfileScope(kProfilerPoint_GetPropertyData);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_GetPropertyData: bad driver reference");
@@ -301,6 +385,7 @@ static OSStatus AudioHub_GetPropertyData(AudioServerPlugInDriverRef inDriver, Au
 }
 
 static OSStatus AudioHub_SetPropertyData(AudioServerPlugInDriverRef inDriver, AudioObjectID inObjectID, pid_t inClientProcessID, const AudioObjectPropertyAddress *inAddress, UInt32 inQualifierDataSize, const void *inQualifierData, UInt32 inDataSize, const void *inData) {
+    ProfileScope(kProfilerPoint_SetPropertyData);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_SetPropertyData: bad driver reference");
@@ -331,12 +416,20 @@ static OSStatus AudioHub_SetPropertyData(AudioServerPlugInDriverRef inDriver, Au
 #pragma mark IO Operations
 
 static OSStatus AudioHub_StartIO(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 /*inClientID*/) {
+    ProfileScope(kProfilerPoint_StartIO);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_StartIO: bad driver reference");
         CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(inDeviceObjectID));
         ThrowIf(!theDevice.IsValid(), CAException(kAudioHardwareBadObjectError), "AudioHub_StartIO: unknown device");
-        theDevice->StartIO();
+        AddRunningDevice(theDevice.GetObject());
+        try {
+            theDevice->StartIO();
+        }
+        catch (...) {
+            RemoveRunningDevice(inDeviceObjectID);
+            throw;
+        }
     }
     catch (const CAException &inException) {
         theAnswer = inException.GetError();
@@ -348,12 +441,21 @@ static OSStatus AudioHub_StartIO(AudioServerPlugInDriverRef inDriver, AudioObjec
 }
 
 static OSStatus AudioHub_StopIO(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 /*inClientID*/) {
+    ProfileScope(kProfilerPoint_StopIO);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_StopIO: bad driver reference");
         CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(inDeviceObjectID));
         ThrowIf(!theDevice.IsValid(), CAException(kAudioHardwareBadObjectError), "AudioHub_StopIO: unknown device");
-        theDevice->StopIO();
+        //  the HAL counts the client as stopped either way, so the device must not stay retained
+        try {
+            theDevice->StopIO();
+        }
+        catch (...) {
+            RemoveRunningDevice(inDeviceObjectID);
+            throw;
+        }
+        RemoveRunningDevice(inDeviceObjectID);
     }
     catch (const CAException &inException) {
         theAnswer = inException.GetError();
@@ -366,14 +468,15 @@ static OSStatus AudioHub_StopIO(AudioServerPlugInDriverRef inDriver, AudioObject
 }
 
 static OSStatus AudioHub_GetZeroTimeStamp(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 /*inClientID*/, Float64 *outSampleTime, UInt64 *outHostTime, UInt64 *outSeed) {
+    ProfileScope(kProfilerPoint_GetZeroTimeStamp);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_GetZeroTimeStamp: bad driver reference");
         ThrowIfNULL(outSampleTime, CAException(kAudioHardwareIllegalOperationError), "AudioHub_GetZeroTimeStamp: no place to put the sample time");
         ThrowIfNULL(outHostTime, CAException(kAudioHardwareIllegalOperationError), "AudioHub_GetZeroTimeStamp: no place to put the host time");
         ThrowIfNULL(outSeed, CAException(kAudioHardwareIllegalOperationError), "AudioHub_GetZeroTimeStamp: no place to put the seed");
-        CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(inDeviceObjectID));
-        ThrowIf(!theDevice.IsValid(), CAException(kAudioHardwareBadObjectError), "AudioHub_GetZeroTimeStamp: unknown device");
+        Device *theDevice = FindRunningDevice(inDeviceObjectID);
+        ThrowIfNULL(theDevice, CAException(kAudioHardwareNotRunningError), "AudioHub_GetZeroTimeStamp: the device isn't running");
         theDevice->GetZeroTimeStamp(*outSampleTime, *outHostTime, *outSeed);
     }
     catch (const CAException &inException) {
@@ -386,6 +489,7 @@ static OSStatus AudioHub_GetZeroTimeStamp(AudioServerPlugInDriverRef inDriver, A
 }
 
 static OSStatus AudioHub_WillDoIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 /*inClientID*/, UInt32 inOperationID, Boolean *outWillDo, Boolean *outWillDoInPlace) {
+    ProfileScope(kProfilerPoint_WillDoIOOperation);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_WillDoIOOperation: bad driver reference");
@@ -409,12 +513,13 @@ static OSStatus AudioHub_WillDoIOOperation(AudioServerPlugInDriverRef inDriver,
 }
 
 static OSStatus AudioHub_BeginIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 /*inClientID*/, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo *inIOCycleInfo) {
+    ProfileScope(kProfilerPoint_BeginIOOperation);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_BeginIOOperation: bad driver reference");
         ThrowIfNULL(inIOCycleInfo, CAException(kAudioHardwareIllegalOperationError), "AudioHub_BeginIOOperation: no cycle info");
-        CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(inDeviceObjectID));
-        ThrowIf(!theDevice.IsValid(), CAException(kAudioHardwareBadObjectError), "AudioHub_BeginIOOperation: unknown device");
+        Device *theDevice = FindRunningDevice(inDeviceObjectID);
+        ThrowIfNULL(theDevice, CAException(kAudioHardwareNotRunningError), "AudioHub_BeginIOOperation: the device isn't running");
         theDevice->BeginIOOperation(inOperationID, inIOBufferFrameSize, *inIOCycleInfo);
     }
     catch (const CAException &inException) {
@@ -427,12 +532,13 @@ static OSStatus AudioHub_BeginIOOperation(AudioServerPlugInDriverRef inDriver, A
 }
 
 static OSStatus AudioHub_DoIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, AudioObjectID inStreamObjectID, UInt32 /*inClientID*/, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo *inIOCycleInfo, void *ioMainBuffer, void *ioSecondaryBuffer) {
+    ProfileScope(kProfilerPoint_DoIOOperation);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_DoIOOperation: bad driver reference");
         ThrowIfNULL(inIOCycleInfo, CAException(kAudioHardwareIllegalOperationError), "AudioHub_DoIOOperation: no cycle info");
-        CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(inDeviceObjectID));
-        ThrowIf(!theDevice.IsValid(), CAException(kAudioHardwareBadObjectError), "AudioHub_DoIOOperation: unknown device");
+        Device *theDevice = FindRunningDevice(inDeviceObjectID);
+        ThrowIfNULL(theDevice, CAException(kAudioHardwareNotRunningError), "AudioHub_DoIOOperation: the device isn't running");
         theDevice->DoIOOperation(inStreamObjectID, inOperationID, inIOBufferFrameSize, *inIOCycleInfo, ioMainBuffer, ioSecondaryBuffer);
     }
     catch (const CAException &inException) {
@@ -445,12 +551,13 @@ static OSStatus AudioHub_DoIOOperation(AudioServerPlugInDriverRef inDriver, Audi
 }
 
 static OSStatus AudioHub_EndIOOperation(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, UInt32 /*inClientID*/, UInt32 inOperationID, UInt32 inIOBufferFrameSize, const AudioServerPlugInIOCycleInfo *inIOCycleInfo) {
+    ProfileScope(kProfilerPoint_EndIOOperation);
     OSStatus theAnswer = 0;
     try {
         ThrowIf(inDriver != gAudioServerPlugInDriverRef, CAException(kAudioHardwareBadObjectError), "AudioHub_EndIOOperation: bad driver reference");
         ThrowIfNULL(inIOCycleInfo, CAException(kAudioHardwareIllegalOperationError), "AudioHub_EndIOOperation: no cycle info");
-        CAObjectReleaser<Device> theDevice(CAObjectMap::CopyObjectOfClassByObjectID<Device>(inDeviceObjectID));
-        ThrowIf(!theDevice.IsValid(), CAException(kAudioHardwareBadObjectError), "AudioHub_EndIOOperation: unknown device");
+        Device *theDevice = FindRunningDevice(inDeviceObjectID);
+        ThrowIfNULL(theDevice, CAException(kAudioHardwareNotRunningError), "AudioHub_EndIOOperation: the device isn't running");
         theDevice->EndIOOperation(inOperationID, inIOBufferFrameSize, *inIOCycleInfo);
     }
     catch (const CAException &inException) {
@@ -0,0 +1,166 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "NoiseReducer.h"
+
+#include <CoreAudio/AudioHardwareBase.h>
+#include <math.h>
+#include <stddef.h>
+
+#include <algorithm>
+
+#include "CADebugMacros.h"
+#include "CAException.h"
+#include "CASpectralProcessor.h"
+
+//  how quickly the power of a bin is smoothed before its minimum is taken, per hop
+static const Float32 kPowerSmoothing = 0.7f;
+//  the smoothed minimum sits below the mean of the noise, this brings it back up
+static const Float32 kNoiseBias = 2.5f;
+//  how fast the floor may climb when the noise gets louder
+static const Float32 kNoiseRiseDecibelsPerSecond = 5.0f;
+//  the weight of the previous hop's clean estimate in the a priori SNR
+static const Float32 kDecisionDirectedWeight = 0.98f;
+static const Float32 kMinimumPower = 1e-20f;
+
+#pragma mark Construction/Destruction
+
+NoiseReducer::NoiseReducer(UInt32 inNumberChannels, Float64 inSampleRate, Float32 inReductionDecibels)
+        : mNumberChannels(inNumberChannels),
+          mSampleRate(inSampleRate),
+          mReductionDecibels(std::max(inReductionDecibels, 0.0f)),
+          mMinimumGain(1.0f),
+          mNoiseRise(1.0f),
+          mProcessor(NULL),
+          mIsPrimed(false) {
+    ThrowIf(inNumberChannels == 0, CAException(kAudioHardwareIllegalOperationError), "NoiseReducer::NoiseReducer: no channels");
+    ThrowIf(inSampleRate <= 0.0, CAException(kAudioHardwareIllegalOperationError), "NoiseReducer::NoiseReducer: bad sample rate");
+
+    mMinimumGain = powf(10.0f, -mReductionDecibels / 20.0f);
+    mNoiseRise = powf(10.0f, kNoiseRiseDecibelsPerSecond * (Float32) (kHopSize / mSampleRate) / 10.0f);
+
+    mProcessor = new CASpectralProcessor(kFFTSize, kHopSize, mNumberChannels, kMaximumFrames);
+    mProcessor->SetSpectralFunction(SpectralFunction, this);
+
+    mChannelStorage.resize(kMaximumFrames * mNumberChannels);
+    mBufferListStorage.resize(offsetof(AudioBufferList, mBuffers) + mNumberChannels * sizeof(AudioBuffer));
+    AudioBufferList *theBufferList = reinterpret_cast<AudioBufferList *>(&mBufferListStorage[0]);
+    theBufferList->mNumberBuffers = mNumberChannels;
+    for (UInt32 theChannel = 0; theChannel < mNumberChannels; ++theChannel) {
+        theBufferList->mBuffers[theChannel].mNumberChannels = 1;
+        theBufferList->mBuffers[theChannel].mDataByteSize = kMaximumFrames * sizeof(Float32);
+        theBufferList->mBuffers[theChannel].mData = &mChannelStorage[theChannel * kMaximumFrames];
+    }
+
+    mSmoothedPower.resize(kNumberBins * mNumberChannels);
+    mNoise.resize(kNumberBins * mNumberChannels);
+    mCleanPower.resize(kNumberBins * mNumberChannels);
+}
+
+NoiseReducer::~NoiseReducer() {
+    delete mProcessor;
+}
+
+#pragma mark IO Operations
+
+void NoiseReducer::Process(Float32 *ioInterleaved, UInt32 inNumberFrames) {
+    AudioBufferList *theBufferList = reinterpret_cast<AudioBufferList *>(&mBufferListStorage[0]);
+    while (inNumberFrames > 0) {
+        UInt32 theNumberFrames = (inNumberFrames < kMaximumFrames) ? inNumberFrames : kMaximumFrames;
+        for (UInt32 theChannel = 0; theChannel < mNumberChannels; ++theChannel) {
+            Float32 *theChannelData = &mChannelStorage[theChannel * kMaximumFrames];
+            for (UInt32 theFrame = 0; theFrame < theNumberFrames; ++theFrame) {
+                theChannelData[theFrame] = ioInterleaved[theFrame * mNumberChannels + theChannel];
+            }
+            theBufferList->mBuffers[theChannel].mDataByteSize = theNumberFrames * sizeof(Float32);
+        }
+
+        mProcessor->Process(theNumberFrames, theBufferList, theBufferList);
+
+        for (UInt32 theChannel = 0; theChannel < mNumberChannels; ++theChannel) {
+            const Float32 *theChannelData = &mChannelStorage[theChannel * kMaximumFrames];
+            for (UInt32 theFrame = 0; theFrame < theNumberFrames; ++theFrame) {
+                ioInterleaved[theFrame * mNumberChannels + theChannel] = theChannelData[theFrame];
+            }
+        }
+        ioInterleaved += theNumberFrames * mNumberChannels;
+        inNumberFrames -= theNumberFrames;
+    }
+}
+
+#pragma mark Operations
+
+void NoiseReducer::Reset() {
+    mProcessor->Reset();
+    std::fill(mSmoothedPower.begin(), mSmoothedPower.end(), 0.0f);
+    std::fill(mNoise.begin(), mNoise.end(), 0.0f);
+    std::fill(mCleanPower.begin(), mCleanPower.end(), 0.0f);
+    mIsPrimed = false;
+}
+
+#pragma mark Implementation
+
+void NoiseReducer::SpectralFunction(SpectralBufferList *inSpectra, void *inUserData) {
+    static_cast<NoiseReducer *>(inUserData)->ProcessSpectra(inSpectra);
+}
+
+void NoiseReducer::ProcessSpectra(SpectralBufferList *inSpectra) {
+    for (UInt32 theChannel = 0; theChannel < inSpectra->mNumberSpectra; ++theChannel) {
+        Float32 *theReal = inSpectra->mDSPSplitComplex[theChannel].realp;
+        Float32 *theImaginary = inSpectra->mDSPSplitComplex[theChannel].imagp;
+        Float32 *theSmoothedPower = &mSmoothedPower[theChannel * kNumberBins];
+        Float32 *theNoise = &mNoise[theChannel * kNumberBins];
+        Float32 *theCleanPower = &mCleanPower[theChannel * kNumberBins];
+
+        //  bin 0 holds DC and Nyquist packed together, neither carries anything worth keeping
+        theReal[0] *= mMinimumGain;
+        theImaginary[0] *= mMinimumGain;
+
+        for (UInt32 theBin = 1; theBin < kNumberBins; ++theBin) {
+            Float32 thePower = theReal[theBin] * theReal[theBin] + theImaginary[theBin] * theImaginary[theBin];
+
+            //  the first hop seeds the estimates, after that the floor follows the smoothed power
+            //  down immediately and up only at the rise rate
+            if (!mIsPrimed) {
+                theSmoothedPower[theBin] = thePower;
+                theNoise[theBin] = thePower;
+                theCleanPower[theBin] = 0.0f;
+            }
+            theSmoothedPower[theBin] = kPowerSmoothing * theSmoothedPower[theBin] + (1.0f - kPowerSmoothing) * thePower;
+            theNoise[theBin] = std::min(theNoise[theBin] * mNoiseRise, theSmoothedPower[theBin]);
+            theNoise[theBin] = std::max(theNoise[theBin], kMinimumPower);
+
+            //  decision-directed a priori SNR and the Wiener gain for it
+            Float32 theNoisePower = kNoiseBias * theNoise[theBin];
+            Float32 thePosterioriSNR = thePower / theNoisePower;
+            Float32 thePrioriSNR = kDecisionDirectedWeight * (theCleanPower[theBin] / theNoisePower) + (1.0f - kDecisionDirectedWeight) * std::max(thePosterioriSNR - 1.0f, 0.0f);
+            Float32 theGain = std::max(thePrioriSNR / (1.0f + thePrioriSNR), mMinimumGain);
+
+            theCleanPower[theBin] = theGain * theGain * thePower;
+            theReal[theBin] *= theGain;
+            theImaginary[theBin] *= theGain;
+        }
+    }
+    mIsPrimed = true;
+}
@@ -0,0 +1,100 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __NoiseReducer__
+#define __NoiseReducer__
+
+#include <CoreAudio/CoreAudioTypes.h>
+
+#include <vector>
+
+class CASpectralProcessor;
+struct SpectralBufferList;
+
+//  Stationary noise suppression for a device's output. Blocks go through a CASpectralProcessor
+//  whose spectral function tracks the noise floor of every bin as the minimum of its smoothed
+//  power, letting it rise slowly so it follows a changing room, and applies a decision-directed
+//  Wiener gain that never drops below the configured reduction. Everything is allocated in the
+//  constructor, Process is real time safe.
+class NoiseReducer {
+public:
+    static const UInt32 kFFTSize = 1024;
+    static const UInt32 kHopSize = kFFTSize / 2;
+    static const UInt32 kMaximumFrames = 1024;
+
+    //  the delay the overlap-add adds to the signal, in frames
+    static UInt32 GetLatency() { return kFFTSize; }
+
+#pragma mark Construction/Destruction
+public:
+    //  inReductionDecibels is the most a bin is attenuated, 0 passes the signal through delayed
+    NoiseReducer(UInt32 inNumberChannels, Float64 inSampleRate, Float32 inReductionDecibels);
+    ~NoiseReducer();
+
+private:
+    NoiseReducer(const NoiseReducer &);
+    NoiseReducer &operator=(const NoiseReducer &);
+
+#pragma mark IO Operations
+public:
+    //  denoises interleaved Float32 in place, any number of frames
+    void Process(Float32 *ioInterleaved, UInt32 inNumberFrames);
+
+#pragma mark Operations
+public:
+    //  forgets the noise estimate and the signal in flight, not real time safe
+    void Reset();
+
+    UInt32 GetNumberChannels() const { return mNumberChannels; }
+    Float64 GetSampleRate() const { return mSampleRate; }
+    Float32 GetReduction() const { return mReductionDecibels; }
+
+    //  the current noise floor estimate of a bin, in the units of the packed spectrum's power
+    Float32 GetNoiseFloor(UInt32 inChannel, UInt32 inBin) const { return mNoise[inChannel * kNumberBins + inBin]; }
+
+#pragma mark Implementation
+private:
+    static const UInt32 kNumberBins = kFFTSize / 2;
+
+    static void SpectralFunction(SpectralBufferList *inSpectra, void *inUserData);
+    void ProcessSpectra(SpectralBufferList *inSpectra);
+
+    UInt32 mNumberChannels;
+    Float64 mSampleRate;
+    Float32 mReductionDecibels;
+    Float32 mMinimumGain;
+    Float32 mNoiseRise;
+
+    CASpectralProcessor *mProcessor;
+    std::vector<Float32> mChannelStorage;
+    std::vector<UInt8> mBufferListStorage;
+
+    //  per channel and bin
+    std::vector<Float32> mSmoothedPower;
+    std::vector<Float32> mNoise;
+    std::vector<Float32> mCleanPower;
+    bool mIsPrimed;
+};
+
+#endif /* __NoiseReducer__ */
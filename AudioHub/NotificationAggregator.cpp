@@ -0,0 +1,175 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "NotificationAggregator.h"
+
+#include "DispatchLanes.h"
+#include "CADebugMacros.h"
+#include "CAException.h"
+
+#pragma mark Construction/Destruction
+
+NotificationAggregator::NotificationAggregator(DeliveryProc inDeliveryProc, UInt64 inWindowNanos)
+        : mDeliveryProc(inDeliveryProc),
+          mWindowNanos(inWindowNanos),
+          mMutex("Hub Notifications"),
+          mPendingNotifications(),
+          mTransactionDepth(0),
+          mFlushIsScheduled(false),
+          mNumberPostedCalls(0),
+          mNumberPendingCalls(0),
+          mNumberDeliveredCalls(0),
+          mNumberPostedAddresses(0),
+          mNumberDeliveredAddresses(0) {
+}
+
+NotificationAggregator::~NotificationAggregator() {
+    //  a scheduled flush still references this object, so the aggregator has to outlive its window
+    Assert(!mFlushIsScheduled, "NotificationAggregator::~NotificationAggregator: destroyed with a flush pending");
+}
+
+#pragma mark Operations
+
+void NotificationAggregator::PropertiesChanged(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress inAddresses[]) {
+    if ((inNumberAddresses == 0) || (inAddresses == NULL)) {
+        return;
+    }
+
+    bool deliverNow = false;
+    {
+        CAMutex::Locker theLocker(mMutex);
+
+        //  find the list for this object, making a new one if this is the first change for it
+        CAPropertyAddressList *theList = mPendingNotifications.GetItemByIntToken(inObjectID);
+        if (theList == NULL) {
+            mPendingNotifications.AppendItem(CAPropertyAddressList(static_cast<uintptr_t>(inObjectID)));
+            theList = &mPendingNotifications.GetItemByIndex(mPendingNotifications.GetNumberItems() - 1);
+        }
+        for (UInt32 theIndex = 0; theIndex < inNumberAddresses; ++theIndex) {
+            theList->AppendUniqueExactItem(inAddresses[theIndex]);
+        }
+
+        ++mNumberPostedCalls;
+        ++mNumberPendingCalls;
+        mNumberPostedAddresses += inNumberAddresses;
+
+        if (mTransactionDepth == 0) {
+            if (mWindowNanos == 0) {
+                deliverNow = true;
+            }
+            else if (!mFlushIsScheduled) {
+                ScheduleFlush();
+            }
+        }
+    }
+
+    if (deliverNow) {
+        Flush();
+    }
+}
+
+void NotificationAggregator::Flush() {
+    //  swap the pending notifications out so that the host is called without holding the lock
+    CAPropertyAddressListVector theNotifications;
+    {
+        CAMutex::Locker theLocker(mMutex);
+        std::swap(theNotifications, mPendingNotifications);
+        mNumberDeliveredCalls += theNotifications.GetNumberItems();
+        mNumberPendingCalls = 0;
+        for (UInt32 theIndex = 0; theIndex < theNotifications.GetNumberItems(); ++theIndex) {
+            mNumberDeliveredAddresses += theNotifications.GetItemByIndex(theIndex).GetNumberItems();
+        }
+    }
+
+    for (UInt32 theIndex = 0; theIndex < theNotifications.GetNumberItems(); ++theIndex) {
+        const CAPropertyAddressList &theList = theNotifications.GetItemByIndex(theIndex);
+        if ((mDeliveryProc != NULL) && !theList.IsEmpty()) {
+            mDeliveryProc(theList.GetAudioObjectIDToken(), theList.GetNumberItems(), theList.GetItems());
+        }
+    }
+}
+
+void NotificationAggregator::BeginTransaction() {
+    CAMutex::Locker theLocker(mMutex);
+    ++mTransactionDepth;
+}
+
+void NotificationAggregator::EndTransaction() {
+    bool deliverNow = false;
+    {
+        CAMutex::Locker theLocker(mMutex);
+        Assert(mTransactionDepth > 0, "NotificationAggregator::EndTransaction: not in a transaction");
+        if (mTransactionDepth > 0) {
+            --mTransactionDepth;
+        }
+        deliverNow = mTransactionDepth == 0;
+    }
+
+    //  the outermost transaction delivers everything that was collected while it was open
+    if (deliverNow) {
+        Flush();
+    }
+}
+
+#pragma mark Statistics
+
+bool NotificationAggregator::HasPendingNotifications() const {
+    CAMutex::Locker theLocker(mMutex);
+    return mPendingNotifications.HasAnyNonEmptyItems();
+}
+
+void NotificationAggregator::ResetStatistics() {
+    CAMutex::Locker theLocker(mMutex);
+    mNumberPostedCalls = mNumberPendingCalls;
+    mNumberDeliveredCalls = 0;
+    mNumberPostedAddresses = 0;
+    mNumberDeliveredAddresses = 0;
+}
+
+void NotificationAggregator::Dump() const {
+    CAMutex::Locker theLocker(mMutex);
+    DebugMsg("NotificationAggregator::Dump: posted calls: %llu delivered calls: %llu saved calls: %llu posted addresses: %llu delivered addresses: %llu",
+             mNumberPostedCalls, mNumberDeliveredCalls, mNumberPostedCalls - mNumberDeliveredCalls - mNumberPendingCalls, mNumberPostedAddresses, mNumberDeliveredAddresses);
+}
+
+#pragma mark Implementation
+
+void NotificationAggregator::ScheduleFlush() {
+    //  called with the mutex held
+    mFlushIsScheduled = true;
+    UInt64 theWindow = mWindowNanos;
+    DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLaneNotification, theWindow, ^{
+        bool deliverNow = false;
+        {
+            CAMutex::Locker theLocker(mMutex);
+            mFlushIsScheduled = false;
+
+            //  an open transaction will deliver everything when it ends
+            deliverNow = mTransactionDepth == 0;
+        }
+        if (deliverNow) {
+            Flush();
+        }
+    });
+}
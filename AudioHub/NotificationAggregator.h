@@ -0,0 +1,108 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __NotificationAggregator__
+#define __NotificationAggregator__
+
+#include <CoreAudio/AudioServerPlugIn.h>
+
+#include "CAMutex.h"
+#include "CAPropertyAddress.h"
+
+//  Collects property change notifications per object and hands them to the host in as few
+//  PropertiesChanged calls as possible. Notifications posted inside a Transaction are delivered
+//  when the outermost Transaction ends. Notifications posted outside of a Transaction are held
+//  for the aggregation window and then delivered from the global serial queue. A window of 0
+//  delivers them right away.
+class NotificationAggregator {
+public:
+    typedef void (*DeliveryProc)(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress inAddresses[]);
+
+    //  5ms is short enough that clients don't notice and long enough to catch a burst of changes
+    static const UInt64 kDefaultWindowNanos = 5 * 1000 * 1000;
+
+#pragma mark Construction/Destruction
+public:
+    NotificationAggregator(DeliveryProc inDeliveryProc, UInt64 inWindowNanos = kDefaultWindowNanos);
+    ~NotificationAggregator();
+
+private:
+    NotificationAggregator(const NotificationAggregator &);
+    NotificationAggregator &operator=(const NotificationAggregator &);
+
+#pragma mark Operations
+public:
+    void PropertiesChanged(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress inAddresses[]);
+    void Flush();
+
+    void BeginTransaction();
+    void EndTransaction();
+
+    class Transaction {
+    public:
+        Transaction(NotificationAggregator &inAggregator) : mAggregator(inAggregator) { mAggregator.BeginTransaction(); }
+        ~Transaction() { mAggregator.EndTransaction(); }
+
+    private:
+        Transaction(const Transaction &);
+        Transaction &operator=(const Transaction &);
+
+        NotificationAggregator &mAggregator;
+    };
+
+#pragma mark Statistics
+public:
+    //  calls made into PropertiesChanged vs. calls made to the host
+    UInt64 GetNumberPostedCalls() const { return mNumberPostedCalls; }
+    UInt64 GetNumberDeliveredCalls() const { return mNumberDeliveredCalls; }
+    UInt64 GetNumberSavedCalls() const { return mNumberPostedCalls - mNumberDeliveredCalls - mNumberPendingCalls; }
+
+    //  addresses posted vs. addresses handed to the host after de-duplication
+    UInt64 GetNumberPostedAddresses() const { return mNumberPostedAddresses; }
+    UInt64 GetNumberDeliveredAddresses() const { return mNumberDeliveredAddresses; }
+
+    bool HasPendingNotifications() const;
+    void ResetStatistics();
+    void Dump() const;
+
+#pragma mark Implementation
+private:
+    void ScheduleFlush();
+
+    DeliveryProc mDeliveryProc;
+    UInt64 mWindowNanos;
+
+    mutable CAMutex mMutex;
+    CAPropertyAddressListVector mPendingNotifications;
+    UInt32 mTransactionDepth;
+    bool mFlushIsScheduled;
+
+    UInt64 mNumberPostedCalls;
+    UInt64 mNumberPendingCalls;
+    UInt64 mNumberDeliveredCalls;
+    UInt64 mNumberPostedAddresses;
+    UInt64 mNumberDeliveredAddresses;
+};
+
+#endif /* __NotificationAggregator__ */
@@ -40,6 +40,8 @@ THE SOFTWARE.
 #include "Box.h"
 
 #include "CAException.h"
+#include "BinarySettings.h"
+#include "Profiler.h"
 
 PlugIn &PlugIn::GetInstance() {
     pthread_once(&sStaticInitializer, StaticInitializer);
@@ -49,7 +51,9 @@ PlugIn &PlugIn::GetInstance() {
 PlugIn::PlugIn()
         : CAObject(kAudioObjectPlugInObject, kAudioPlugInClassID, kAudioObjectClassID, 0),
           mBoxAudioObjectID(CAObjectMap::GetNextObjectID()),
-          mMutex(new CAMutex("Hub Plugin")) {}
+          mBox(nullptr),
+          mMutex(new CAMutex("Hub Plugin")),
+          mSettingsStore(PlugIn::CopySettings, PlugIn::WriteSettings, this) {}
 
 PlugIn::~PlugIn() {
     delete mMutex;
@@ -66,13 +70,20 @@ void PlugIn::Activate() {
 }
 
 void PlugIn::Deactivate() {
+    //  flushed before taking the mutex, a write on the persistence lane takes it after the store's
+    mSettingsStore.Flush();
     CAMutex::Locker theLocker(mMutex);
+    sNotificationAggregator.Flush();
+    if (Profiler::IsEnabled()) {
+        Profiler::Dump();
+    }
     CAObject::Deactivate();
     CAObjectMap::UnmapObject(mBox->GetObjectID(), mBox);
     mBox = nullptr;
 }
 
 void PlugIn::StaticInitializer() {
+    ProfileScope(kProfilerPoint_StaticInitializer);
     try {
         sInstance = new PlugIn;
         CAObjectMap::MapObject(kAudioObjectPlugInObject, sInstance);
@@ -267,12 +278,29 @@ void PlugIn::StoreSettings(CFPropertyListRef settings) {
 }
 
 void PlugIn::StoreSettings() {
-    CFPropertyListRef settings = mBox->GetSettings();
-    this->StoreSettings(settings);
-    CFRelease(settings);
+    mSettingsStore.MarkDirty();
+}
+
+void PlugIn::FlushSettings() {
+    mSettingsStore.Flush();
+}
+
+CFPropertyListRef PlugIn::CopySettings(void *inClientData) {
+    PlugIn *thePlugIn = static_cast<PlugIn *>(inClientData);
+    //  runs on the persistence lane, the mutex keeps Deactivate from tearing the box down meanwhile
+    CAMutex::Locker theLocker(thePlugIn->mMutex);
+    if (thePlugIn->mBox == nullptr) {
+        return NULL;
+    }
+    return thePlugIn->mBox->CopyBinarySettings();
+}
+
+void PlugIn::WriteSettings(void *inClientData, CFPropertyListRef inSettings) {
+    static_cast<PlugIn *>(inClientData)->StoreSettings(inSettings);
 }
 
 void PlugIn::RestoreSettings() {
+    ProfileScope(kProfilerPoint_RestoreSettings);
 #if ULTRASCHALL
     CFBundleRef myBundle = CFBundleGetBundleWithIdentifier(bundleIdentifier);
     ThrowIf(myBundle == NULL, CAException(kAudioHardwareBadObjectError), "PlugIn::RestoreSettings: bundle not found");
@@ -289,20 +317,28 @@ void PlugIn::RestoreSettings() {
         return;
     }
     
-    // Reconstitute the dictionary using the XML data
-    CFErrorRef myError;
-    CFPropertyListRef propertyList = CFPropertyListCreateWithData(kCFAllocatorDefault, resourceData, kCFPropertyListImmutable, NULL, &myError);
-    
-    if (propertyList != NULL) {
-        DebugMsg("RestoreSettings SetSettings %s %d", __FILE__, __LINE__);
-        mBox->SetSettings(propertyList);
+    // Binary settings are read directly, anything else is treated as an XML plist
+    if (BinarySettingsReader::HasMagic(resourceData)) {
+        DebugMsg("RestoreSettings SetBinarySettings %s %d", __FILE__, __LINE__);
+        mBox->SetBinarySettings(CFDataGetBytePtr(resourceData), CFDataGetLength(resourceData));
     }
-    
+    else {
+        // Reconstitute the dictionary using the XML data
+        CFErrorRef myError;
+        CFPropertyListRef propertyList = CFPropertyListCreateWithData(kCFAllocatorDefault, resourceData, kCFPropertyListImmutable, NULL, &myError);
+
+        if (propertyList != NULL) {
+            DebugMsg("RestoreSettings SetSettings %s %d", __FILE__, __LINE__);
+            mBox->SetSettings(propertyList);
+        }
+    }
+
     // Handle any errors
+    CFRelease(resourceData);
     CFRelease(settingsURL);
 #else
     DebugMsg("RestoreSettings Default %s %d", __FILE__, __LINE__);
-    CFPropertyListRef settigns;
+    CFPropertyListRef settigns = NULL;
     OSStatus status = sHost->CopyFromStorage(sHost, kAudioHubSettingsKey, &settigns);
     if (settigns != NULL) {
         if (!status) {
@@ -314,6 +350,14 @@ void PlugIn::RestoreSettings() {
 }
 
 #pragma mark Host Access
+void PlugIn::Host_DeliverPropertiesChanged(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress inAddresses[]) {
+    if (sHost != NULL)
+    {
+        sHost->PropertiesChanged(sHost, inObjectID, inNumberAddresses, inAddresses);
+    }
+}
+
 pthread_once_t PlugIn::sStaticInitializer = PTHREAD_ONCE_INIT;
 PlugIn *PlugIn::sInstance = NULL;
 AudioServerPlugInHostRef PlugIn::sHost = NULL;
+NotificationAggregator PlugIn::sNotificationAggregator(PlugIn::Host_DeliverPropertiesChanged);
@@ -51,6 +51,8 @@ THE SOFTWARE.
 
 #include "CACFDictionary.h"
 #include "Box.h"
+#include "NotificationAggregator.h"
+#include "SettingsStore.h"
 
 class Device;
 
@@ -82,20 +84,29 @@ public:
 #pragma mark Settings
 public:
     void StoreSettings(CFPropertyListRef settings);
+    //  marks the settings dirty, the write happens later on the global serial queue
     void StoreSettings();
+    void FlushSettings();
     void RestoreSettings();
 
+    SettingsStore &GetSettingsStore() {
+        return mSettingsStore;
+    }
+
 #pragma mark Host Accesss
 public:
     static void SetHost(AudioServerPlugInHostRef inHost) {
         sHost = inHost;
     }
 
+    //  Notifications are coalesced per object by the aggregator before they reach the host. Wrap
+    //  bulk changes in a NotificationAggregator::Transaction to send them as one call per object.
     static void Host_PropertiesChanged(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress inAddresses[]) {
-        if (sHost != NULL)
-        {
-            sHost->PropertiesChanged(GetInstance().sHost, inObjectID, inNumberAddresses, inAddresses);
-        }
+        sNotificationAggregator.PropertiesChanged(inObjectID, inNumberAddresses, inAddresses);
+    }
+
+    static NotificationAggregator &GetNotificationAggregator() {
+        return sNotificationAggregator;
     }
 
     static void Host_RequestDeviceConfigurationChange(AudioObjectID inDeviceObjectID, UInt64 inChangeAction, void *inChangeInfo) {
@@ -107,11 +118,18 @@ public:
 
 #pragma mark Implementation
 private:
+    static void Host_DeliverPropertiesChanged(AudioObjectID inObjectID, UInt32 inNumberAddresses, const AudioObjectPropertyAddress inAddresses[]);
+
+    static CFPropertyListRef CopySettings(void *inClientData);
+    static void WriteSettings(void *inClientData, CFPropertyListRef inSettings);
+
     CAMutex *mMutex;
+    SettingsStore mSettingsStore;
 
     static pthread_once_t sStaticInitializer;
     static PlugIn *sInstance;
     static AudioServerPlugInHostRef sHost;
+    static NotificationAggregator sNotificationAggregator;
 public:
     CFStringRef bundleIdentifier = kAudioHubBundleIdentifier;
 };
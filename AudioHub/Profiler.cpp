@@ -0,0 +1,261 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Profiler.h"
+
+#include <mutex>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CACFDictionary.h"
+#include "CADebugMacros.h"
+
+static const char *sProfilerPointNames[kNumberProfilerPoints] = {
+    "AudioHub_QueryInterface",
+    "AudioHub_AddRef",
+    "AudioHub_Release",
+    "AudioHub_Initialize",
+    "AudioHub_CreateDevice",
+    "AudioHub_DestroyDevice",
+    "AudioHub_AddDeviceClient",
+    "AudioHub_RemoveDeviceClient",
+    "AudioHub_PerformDeviceConfigurationChange",
+    "AudioHub_AbortDeviceConfigurationChange",
+    "AudioHub_HasProperty",
+    "AudioHub_IsPropertySettable",
+    "AudioHub_GetPropertyDataSize",
+    "AudioHub_GetPropertyData",
+    "AudioHub_SetPropertyData",
+    "AudioHub_StartIO",
+    "AudioHub_StopIO",
+    "AudioHub_GetZeroTimeStamp",
+    "AudioHub_WillDoIOOperation",
+    "AudioHub_BeginIOOperation",
+    "AudioHub_DoIOOperation",
+    "AudioHub_EndIOOperation",
+    "PlugIn::StaticInitializer",
+    "PlugIn::RestoreSettings",
+    "DeviceList::SetSettings"
+};
+
+//  Only the owning thread writes to a record, so a relaxed load followed by a relaxed store is
+//  enough and no read-modify-write is needed. A record keeps its samples when its thread exits and
+//  the next thread that claims it adds to them.
+struct Profiler::ThreadRecord {
+    std::atomic<UInt64> mCount[kNumberProfilerPoints];
+    std::atomic<UInt64> mTotalTicks[kNumberProfilerPoints];
+    std::atomic<UInt64> mMaximumTicks[kNumberProfilerPoints];
+    std::atomic<UInt32> mBuckets[kNumberProfilerPoints][kNumberBuckets];
+    std::atomic<bool> mIsClaimed;
+};
+
+//  a thread_local would be allocated on the first access from a new thread on macOS, a pthread key
+//  never is
+static std::once_flag sThreadRecordsOnce;
+static pthread_key_t sThreadRecordKey;
+
+static inline void Increment(std::atomic<UInt64> &ioValue, UInt64 inAmount) {
+    ioValue.store(ioValue.load(std::memory_order_relaxed) + inAmount, std::memory_order_relaxed);
+}
+
+static inline UInt32 BucketForTicks(UInt64 inTicks) {
+    //  bucket n holds durations in [2^n, 2^(n+1)) ticks
+    UInt32 theBucket = (inTicks == 0) ? 0 : static_cast<UInt32>(63 - __builtin_clzll(inTicks));
+    return (theBucket < Profiler::kNumberBuckets) ? theBucket : Profiler::kNumberBuckets - 1;
+}
+
+#pragma mark Operations
+
+void Profiler::SetEnabled(bool inEnabled) {
+    if (inEnabled) {
+        std::call_once(sThreadRecordsOnce, &Profiler::AllocateThreadRecords);
+    }
+    sEnabled.store(inEnabled, std::memory_order_relaxed);
+}
+
+void Profiler::Record(ProfilerPoint inPoint, UInt64 inHostTicks) {
+    ThreadRecord *theRecord = GetThreadRecord();
+    if (theRecord == NULL) {
+        return;
+    }
+    Increment(theRecord->mCount[inPoint], 1);
+    Increment(theRecord->mTotalTicks[inPoint], inHostTicks);
+    if (inHostTicks > theRecord->mMaximumTicks[inPoint].load(std::memory_order_relaxed)) {
+        theRecord->mMaximumTicks[inPoint].store(inHostTicks, std::memory_order_relaxed);
+    }
+    std::atomic<UInt32> &theBucket = theRecord->mBuckets[inPoint][BucketForTicks(inHostTicks)];
+    theBucket.store(theBucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void Profiler::Reset() {
+    //  racing with a writer can lose that writer's sample, which is acceptable
+    ThreadRecord *theRecords = sThreadRecords.load(std::memory_order_acquire);
+    if (theRecords == NULL) {
+        return;
+    }
+    for (UInt32 theIndex = 0; theIndex < kMaximumNumberThreadRecords; ++theIndex) {
+        ThreadRecord *theRecord = &theRecords[theIndex];
+        for (UInt32 thePoint = 0; thePoint < kNumberProfilerPoints; ++thePoint) {
+            theRecord->mCount[thePoint].store(0, std::memory_order_relaxed);
+            theRecord->mTotalTicks[thePoint].store(0, std::memory_order_relaxed);
+            theRecord->mMaximumTicks[thePoint].store(0, std::memory_order_relaxed);
+            for (UInt32 theBucket = 0; theBucket < kNumberBuckets; ++theBucket) {
+                theRecord->mBuckets[thePoint][theBucket].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+#pragma mark Reporting
+
+const char *Profiler::GetPointName(ProfilerPoint inPoint) {
+    return (inPoint < kNumberProfilerPoints) ? sProfilerPointNames[inPoint] : "unknown";
+}
+
+bool Profiler::GetPointStatistics(ProfilerPoint inPoint, PointStatistics &outStatistics) {
+    UInt64 theCount = 0;
+    UInt64 theTotalTicks = 0;
+    UInt64 theMaximumTicks = 0;
+    UInt64 theBuckets[kNumberBuckets];
+    memset(theBuckets, 0, sizeof(theBuckets));
+    ThreadRecord *theRecords = sThreadRecords.load(std::memory_order_acquire);
+    for (UInt32 theIndex = 0; (theRecords != NULL) && (theIndex < kMaximumNumberThreadRecords); ++theIndex) {
+        ThreadRecord *theRecord = &theRecords[theIndex];
+        theCount += theRecord->mCount[inPoint].load(std::memory_order_relaxed);
+        theTotalTicks += theRecord->mTotalTicks[inPoint].load(std::memory_order_relaxed);
+        UInt64 theRecordMaximum = theRecord->mMaximumTicks[inPoint].load(std::memory_order_relaxed);
+        if (theRecordMaximum > theMaximumTicks) {
+            theMaximumTicks = theRecordMaximum;
+        }
+        for (UInt32 theBucket = 0; theBucket < kNumberBuckets; ++theBucket) {
+            theBuckets[theBucket] += theRecord->mBuckets[inPoint][theBucket].load(std::memory_order_relaxed);
+        }
+    }
+    if (theCount == 0) {
+        return false;
+    }
+
+    //  percentiles are reported as the upper bound of the bucket they fall into
+    UInt64 theP50Ticks = 0;
+    UInt64 theP99Ticks = 0;
+    UInt64 theSeen = 0;
+    for (UInt32 theBucket = 0; theBucket < kNumberBuckets; ++theBucket) {
+        theSeen += theBuckets[theBucket];
+        UInt64 theUpperBound = (2ULL << theBucket) - 1;
+        if ((theP50Ticks == 0) && (theSeen * 2 >= theCount)) {
+            theP50Ticks = theUpperBound;
+        }
+        if ((theP99Ticks == 0) && (theSeen * 100 >= theCount * 99)) {
+            theP99Ticks = theUpperBound;
+        }
+    }
+
+    outStatistics.mCount = theCount;
+    outStatistics.mTotalNanos = CAHostTimeBase::ConvertToNanos(theTotalTicks);
+    outStatistics.mMaximumNanos = CAHostTimeBase::ConvertToNanos(theMaximumTicks);
+    outStatistics.mP50Nanos = CAHostTimeBase::ConvertToNanos(theP50Ticks);
+    outStatistics.mP99Nanos = CAHostTimeBase::ConvertToNanos(theP99Ticks);
+    return true;
+}
+
+CFDictionaryRef Profiler::CopyReport() {
+    CACFDictionary theReport(false);
+    for (UInt32 thePoint = 0; thePoint < kNumberProfilerPoints; ++thePoint) {
+        PointStatistics theStatistics;
+        if (!GetPointStatistics(static_cast<ProfilerPoint>(thePoint), theStatistics)) {
+            continue;
+        }
+        CACFDictionary thePointReport(true);
+        thePointReport.AddUInt64(CFSTR("Count"), theStatistics.mCount);
+        thePointReport.AddUInt64(CFSTR("TotalNanos"), theStatistics.mTotalNanos);
+        thePointReport.AddUInt64(CFSTR("MaximumNanos"), theStatistics.mMaximumNanos);
+        thePointReport.AddUInt64(CFSTR("P50Nanos"), theStatistics.mP50Nanos);
+        thePointReport.AddUInt64(CFSTR("P99Nanos"), theStatistics.mP99Nanos);
+        theReport.AddCFTypeWithCStringKey(sProfilerPointNames[thePoint], thePointReport.GetCFDictionary());
+    }
+    return theReport.GetCFDictionary();
+}
+
+void Profiler::Dump() {
+    for (UInt32 thePoint = 0; thePoint < kNumberProfilerPoints; ++thePoint) {
+        PointStatistics theStatistics;
+        if (GetPointStatistics(static_cast<ProfilerPoint>(thePoint), theStatistics)) {
+            DebugMsg("Profiler::Dump: %s count: %llu mean: %llu ns p50: <%llu ns p99: <%llu ns max: %llu ns",
+                     sProfilerPointNames[thePoint], theStatistics.mCount, theStatistics.mTotalNanos / theStatistics.mCount,
+                     theStatistics.mP50Nanos, theStatistics.mP99Nanos, theStatistics.mMaximumNanos);
+        }
+    }
+}
+
+#pragma mark Implementation
+
+void Profiler::AllocateThreadRecords() {
+    //  zeroed memory is a valid empty, unclaimed record
+    ThreadRecord *theRecords = static_cast<ThreadRecord *>(calloc(kMaximumNumberThreadRecords, sizeof(ThreadRecord)));
+    if ((theRecords == NULL) || (pthread_key_create(&sThreadRecordKey, &Profiler::ReleaseThreadRecord) != 0)) {
+        free(theRecords);
+        DebugMsg("Profiler::AllocateThreadRecords: profiling without thread records");
+        return;
+    }
+    sThreadRecords.store(theRecords, std::memory_order_release);
+}
+
+Profiler::ThreadRecord *Profiler::GetThreadRecord() {
+    ThreadRecord *theRecords = sThreadRecords.load(std::memory_order_acquire);
+    if (theRecords == NULL) {
+        return NULL;
+    }
+    ThreadRecord *theRecord = static_cast<ThreadRecord *>(pthread_getspecific(sThreadRecordKey));
+    if (theRecord == NULL) {
+        //  claim the first free record, a thread that finds none stays unrecorded until one is given back
+        for (UInt32 theIndex = 0; theIndex < kMaximumNumberThreadRecords; ++theIndex) {
+            bool wasClaimed = false;
+            if (theRecords[theIndex].mIsClaimed.compare_exchange_strong(wasClaimed, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+                theRecord = &theRecords[theIndex];
+                pthread_setspecific(sThreadRecordKey, theRecord);
+                break;
+            }
+        }
+    }
+    return theRecord;
+}
+
+void Profiler::ReleaseThreadRecord(void *inRecord) {
+    //  called as the thread exits, the samples stay in the record
+    static_cast<ThreadRecord *>(inRecord)->mIsClaimed.store(false, std::memory_order_release);
+}
+
+std::atomic<bool> Profiler::sEnabled(false);
+std::atomic<Profiler::ThreadRecord *> Profiler::sThreadRecords(NULL);
+
+//  AUDIOHUB_PROFILE profiles from the start, this goes through SetEnabled rather than the
+//  initializer of sEnabled so that the records are allocated before anything is recorded
+static struct ProfilerEnvironmentSwitch {
+    ProfilerEnvironmentSwitch() {
+        if (getenv("AUDIOHUB_PROFILE") != NULL) {
+            Profiler::SetEnabled(true);
+        }
+    }
+} sProfilerEnvironmentSwitch;
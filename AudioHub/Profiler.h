@@ -0,0 +1,149 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __Profiler__
+#define __Profiler__
+
+#include <atomic>
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include "CAHostTimeBase.h"
+
+//  The profiler is compiled in unless AUDIOHUB_PROFILER is set to 0. When it is compiled in but
+//  not enabled, a scope costs one load of the enabled flag and one predictable branch.
+#if !defined(AUDIOHUB_PROFILER)
+#define AUDIOHUB_PROFILER 1
+#endif
+
+//  the instrumented places, keep sProfilerPointNames in Profiler.cpp in the same order
+enum ProfilerPoint {
+    kProfilerPoint_QueryInterface,
+    kProfilerPoint_AddRef,
+    kProfilerPoint_Release,
+    kProfilerPoint_Initialize,
+    kProfilerPoint_CreateDevice,
+    kProfilerPoint_DestroyDevice,
+    kProfilerPoint_AddDeviceClient,
+    kProfilerPoint_RemoveDeviceClient,
+    kProfilerPoint_PerformDeviceConfigurationChange,
+    kProfilerPoint_AbortDeviceConfigurationChange,
+    kProfilerPoint_HasProperty,
+    kProfilerPoint_IsPropertySettable,
+    kProfilerPoint_GetPropertyDataSize,
+    kProfilerPoint_GetPropertyData,
+    kProfilerPoint_SetPropertyData,
+    kProfilerPoint_StartIO,
+    kProfilerPoint_StopIO,
+    kProfilerPoint_GetZeroTimeStamp,
+    kProfilerPoint_WillDoIOOperation,
+    kProfilerPoint_BeginIOOperation,
+    kProfilerPoint_DoIOOperation,
+    kProfilerPoint_EndIOOperation,
+    kProfilerPoint_StaticInitializer,
+    kProfilerPoint_RestoreSettings,
+    kProfilerPoint_SetSettings,
+
+    kNumberProfilerPoints
+};
+
+//  Collects the duration of each ProfilerPoint into a log2 histogram of host time ticks. Every
+//  thread writes to its own record. The records come from a fixed pool that is allocated when
+//  profiling is first enabled, a thread claims one the first time it records something and gives it
+//  back when it exits, so recording neither allocates nor takes locks, also on a new IO thread.
+//  Threads beyond kMaximumNumberThreadRecords go unrecorded. Reading the histograms sums up all
+//  records and may see a record that is in the middle of being updated, which is fine for statistics.
+//
+//  Profiling is off until it is enabled via the custom property or the AUDIOHUB_PROFILE environment
+//  variable.
+class Profiler {
+public:
+    static const UInt32 kNumberBuckets = 40;
+    static const UInt32 kMaximumNumberThreadRecords = 64;
+
+    static bool IsEnabled() {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+    static void SetEnabled(bool inEnabled);
+
+    static void Record(ProfilerPoint inPoint, UInt64 inHostTicks);
+    static void Reset();
+
+    struct PointStatistics {
+        UInt64 mCount;
+        UInt64 mTotalNanos;
+        UInt64 mMaximumNanos;
+        UInt64 mP50Nanos;
+        UInt64 mP99Nanos;
+    };
+
+    static const char *GetPointName(ProfilerPoint inPoint);
+    //  returns false if the point has no samples
+    static bool GetPointStatistics(ProfilerPoint inPoint, PointStatistics &outStatistics);
+
+    //  { point name: { Count, TotalNanos, MaximumNanos, P50Nanos, P99Nanos } } for every point with
+    //  samples, the caller must release it
+    static CFDictionaryRef CopyReport();
+    static void Dump();
+
+    //  one per thread that recorded something, defined in Profiler.cpp
+    struct ThreadRecord;
+
+private:
+    static void AllocateThreadRecords();
+    static ThreadRecord *GetThreadRecord();
+    static void ReleaseThreadRecord(void *inRecord);
+
+    static std::atomic<bool> sEnabled;
+    static std::atomic<ThreadRecord *> sThreadRecords;
+};
+
+class ProfilerScope {
+public:
+    ProfilerScope(ProfilerPoint inPoint)
+            : mPoint(inPoint),
+              mStartTime(Profiler::IsEnabled() ? CAHostTimeBase::GetTheCurrentTime() : 0) {
+    }
+
+    ~ProfilerScope() {
+        if (mStartTime != 0) {
+            Profiler::Record(mPoint, CAHostTimeBase::GetTheCurrentTime() - mStartTime);
+        }
+    }
+
+private:
+    ProfilerScope(const ProfilerScope &);
+    ProfilerScope &operator=(const ProfilerScope &);
+
+    ProfilerPoint mPoint;
+    UInt64 mStartTime;
+};
+
+#if AUDIOHUB_PROFILER
+#define ProfileScope(inPoint) ProfilerScope theProfilerScope(inPoint)
+#else
+#define ProfileScope(inPoint)
+#endif
+
+#endif /* __Profiler__ */
@@ -0,0 +1,202 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "SettingsStore.h"
+
+#include "DispatchLanes.h"
+#include "CAHostTimeBase.h"
+#include "CADebugMacros.h"
+#include "CAException.h"
+
+#pragma mark Construction/Destruction
+
+SettingsStore::SettingsStore(CopySettingsProc inCopySettingsProc, WriteSettingsProc inWriteSettingsProc, void *inClientData,
+                             UInt64 inDebounceNanos, UInt64 inMaximumDelayNanos)
+        : mCopySettingsProc(inCopySettingsProc),
+          mWriteSettingsProc(inWriteSettingsProc),
+          mClientData(inClientData),
+          mDebounceNanos(inDebounceNanos),
+          mMaximumDelayNanos(inMaximumDelayNanos < inDebounceNanos ? inDebounceNanos : inMaximumDelayNanos),
+          mMutex("Hub Settings Store"),
+          mWriteMutex("Hub Settings Store Write"),
+          mIsDirty(false),
+          mWriteIsScheduled(false),
+          mFirstDirtyTime(0),
+          mLastDirtyTime(0),
+          mHasLastWrittenHash(false),
+          mLastWrittenHash(0),
+          mNumberDirtyMarks(0),
+          mNumberWrites(0),
+          mNumberSkippedWrites(0) {
+}
+
+SettingsStore::~SettingsStore() {
+    //  a scheduled write still references this object
+    Assert(!mWriteIsScheduled, "SettingsStore::~SettingsStore: destroyed with a write pending");
+}
+
+#pragma mark Operations
+
+void SettingsStore::MarkDirty() {
+    bool writeNow = false;
+    {
+        CAMutex::Locker theLocker(mMutex);
+        UInt64 theNow = CAHostTimeBase::GetCurrentTimeInNanos();
+        ++mNumberDirtyMarks;
+        mLastDirtyTime = theNow;
+        if (!mIsDirty) {
+            mIsDirty = true;
+            mFirstDirtyTime = theNow;
+        }
+
+        if (mDebounceNanos == 0) {
+            writeNow = true;
+        }
+        else if (!mWriteIsScheduled) {
+            ScheduleWrite(mDebounceNanos);
+        }
+    }
+
+    if (writeNow) {
+        Flush();
+    }
+}
+
+void SettingsStore::Flush() {
+    CAMutex::Locker theWriteLocker(mWriteMutex);
+    {
+        CAMutex::Locker theLocker(mMutex);
+        if (!mIsDirty) {
+            return;
+        }
+        mIsDirty = false;
+    }
+
+    //  the snapshot is taken here rather than in MarkDirty so that a burst of changes costs one
+    //  serialization
+    CFPropertyListRef theSettings = (mCopySettingsProc != NULL) ? mCopySettingsProc(mClientData) : NULL;
+    if (theSettings == NULL) {
+        return;
+    }
+
+    UInt64 theHash = HashSettings(theSettings);
+    bool theSettingsChanged;
+    {
+        CAMutex::Locker theLocker(mMutex);
+        theSettingsChanged = !mHasLastWrittenHash || (theHash != mLastWrittenHash);
+        if (theSettingsChanged) {
+            mHasLastWrittenHash = true;
+            mLastWrittenHash = theHash;
+            ++mNumberWrites;
+        }
+        else {
+            ++mNumberSkippedWrites;
+        }
+    }
+
+    if (theSettingsChanged && (mWriteSettingsProc != NULL)) {
+        mWriteSettingsProc(mClientData, theSettings);
+    }
+    CFRelease(theSettings);
+}
+
+bool SettingsStore::IsDirty() const {
+    CAMutex::Locker theLocker(mMutex);
+    return mIsDirty;
+}
+
+void SettingsStore::Invalidate() {
+    CAMutex::Locker theLocker(mMutex);
+    mHasLastWrittenHash = false;
+}
+
+#pragma mark Statistics
+
+void SettingsStore::ResetStatistics() {
+    CAMutex::Locker theLocker(mMutex);
+    mNumberDirtyMarks = 0;
+    mNumberWrites = 0;
+    mNumberSkippedWrites = 0;
+}
+
+void SettingsStore::Dump() const {
+    CAMutex::Locker theLocker(mMutex);
+    DebugMsg("SettingsStore::Dump: dirty marks: %llu writes: %llu skipped writes: %llu", mNumberDirtyMarks, mNumberWrites, mNumberSkippedWrites);
+}
+
+#pragma mark Implementation
+
+void SettingsStore::ScheduleWrite(UInt64 inDelayNanos) {
+    //  called with the mutex held
+    mWriteIsScheduled = true;
+    DispatchLanes::GetGlobalLanes().Dispatch(DispatchLanes::kLanePersistence, inDelayNanos, ^{
+        ScheduledWrite();
+    });
+}
+
+void SettingsStore::ScheduledWrite() {
+    {
+        CAMutex::Locker theLocker(mMutex);
+        if (!mIsDirty) {
+            //  somebody flushed in the meantime
+            mWriteIsScheduled = false;
+            return;
+        }
+
+        //  keep waiting while changes are still coming in, but not past the maximum delay
+        UInt64 theNow = CAHostTimeBase::GetCurrentTimeInNanos();
+        UInt64 theDueTime = mLastDirtyTime + mDebounceNanos;
+        if (theDueTime > mFirstDirtyTime + mMaximumDelayNanos) {
+            theDueTime = mFirstDirtyTime + mMaximumDelayNanos;
+        }
+        if (theNow < theDueTime) {
+            ScheduleWrite(theDueTime - theNow);
+            return;
+        }
+        mWriteIsScheduled = false;
+    }
+
+    try {
+        Flush();
+    }
+    catch (...) {
+        DebugMsg("SettingsStore::ScheduledWrite: failed to write the settings");
+    }
+}
+
+UInt64 SettingsStore::HashSettings(CFPropertyListRef inSettings) {
+    //  FNV-1a over the binary plist representation
+    UInt64 theHash = 14695981039346656037ULL;
+    CFDataRef theData = CFPropertyListCreateData(kCFAllocatorDefault, inSettings, kCFPropertyListBinaryFormat_v1_0, 0, NULL);
+    if (theData != NULL) {
+        const UInt8 *theBytes = CFDataGetBytePtr(theData);
+        CFIndex theLength = CFDataGetLength(theData);
+        for (CFIndex theIndex = 0; theIndex < theLength; ++theIndex) {
+            theHash ^= theBytes[theIndex];
+            theHash *= 1099511628211ULL;
+        }
+        CFRelease(theData);
+    }
+    return theHash;
+}
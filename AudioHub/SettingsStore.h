@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __SettingsStore__
+#define __SettingsStore__
+
+#include <CoreFoundation/CoreFoundation.h>
+
+#include "CAMutex.h"
+
+//  Write-behind persistence for the settings dictionary. MarkDirty only records that the settings
+//  changed; the write happens on the global serial queue once no change has been made for the
+//  debounce interval (but no later than the maximum delay after the first change). Before writing,
+//  the settings are serialized and the write is skipped if they hash to the same value as the last
+//  write. Flush writes pending changes right away and has to be called before the settings source
+//  goes away.
+class SettingsStore {
+public:
+    //  returns a settings dictionary the caller must release, or NULL if there is nothing to store
+    typedef CFPropertyListRef (*CopySettingsProc)(void *inClientData);
+    typedef void (*WriteSettingsProc)(void *inClientData, CFPropertyListRef inSettings);
+
+    static const UInt64 kDefaultDebounceNanos = 250 * 1000 * 1000;
+    static const UInt64 kDefaultMaximumDelayNanos = 2000 * 1000 * 1000;
+
+#pragma mark Construction/Destruction
+public:
+    SettingsStore(CopySettingsProc inCopySettingsProc, WriteSettingsProc inWriteSettingsProc, void *inClientData,
+                  UInt64 inDebounceNanos = kDefaultDebounceNanos, UInt64 inMaximumDelayNanos = kDefaultMaximumDelayNanos);
+    ~SettingsStore();
+
+private:
+    SettingsStore(const SettingsStore &);
+    SettingsStore &operator=(const SettingsStore &);
+
+#pragma mark Operations
+public:
+    void MarkDirty();
+    void Flush();
+    bool IsDirty() const;
+
+    //  forget the hash of the last write so that the next flush writes unconditionally
+    void Invalidate();
+
+#pragma mark Statistics
+public:
+    UInt64 GetNumberDirtyMarks() const { return mNumberDirtyMarks; }
+    UInt64 GetNumberWrites() const { return mNumberWrites; }
+    UInt64 GetNumberSkippedWrites() const { return mNumberSkippedWrites; }
+
+    void ResetStatistics();
+    void Dump() const;
+
+#pragma mark Implementation
+private:
+    void ScheduleWrite(UInt64 inDelayNanos);
+    void ScheduledWrite();
+    static UInt64 HashSettings(CFPropertyListRef inSettings);
+
+    CopySettingsProc mCopySettingsProc;
+    WriteSettingsProc mWriteSettingsProc;
+    void *mClientData;
+    UInt64 mDebounceNanos;
+    UInt64 mMaximumDelayNanos;
+
+    //  mMutex guards the state below, mWriteMutex keeps snapshot + write in order
+    mutable CAMutex mMutex;
+    CAMutex mWriteMutex;
+    bool mIsDirty;
+    bool mWriteIsScheduled;
+    UInt64 mFirstDirtyTime;
+    UInt64 mLastDirtyTime;
+    bool mHasLastWrittenHash;
+    UInt64 mLastWrittenHash;
+
+    UInt64 mNumberDirtyMarks;
+    UInt64 mNumberWrites;
+    UInt64 mNumberSkippedWrites;
+};
+
+#endif /* __SettingsStore__ */
@@ -0,0 +1,222 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "SpectrumAnalyzer.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "CACFArray.h"
+#include "CACFDictionary.h"
+#include "CADebugMacros.h"
+#include "CAException.h"
+#include "CASpectralProcessor.h"
+
+static const Float32 kLowestBandFrequency = 20.0f;
+static const Float32 kSilenceDecibels = -120.0f;
+
+static AudioBufferList *SetupBufferList(std::vector<UInt8> &ioStorage, std::vector<Float32> &inData, UInt32 inNumberChannels, UInt32 inNumberFrames) {
+    ioStorage.resize(offsetof(AudioBufferList, mBuffers) + inNumberChannels * sizeof(AudioBuffer));
+    AudioBufferList *theBufferList = reinterpret_cast<AudioBufferList *>(&ioStorage[0]);
+    theBufferList->mNumberBuffers = inNumberChannels;
+    for (UInt32 theChannel = 0; theChannel < inNumberChannels; ++theChannel) {
+        theBufferList->mBuffers[theChannel].mNumberChannels = 1;
+        theBufferList->mBuffers[theChannel].mDataByteSize = inNumberFrames * sizeof(Float32);
+        theBufferList->mBuffers[theChannel].mData = &inData[theChannel * inNumberFrames];
+    }
+    return theBufferList;
+}
+
+#pragma mark Construction/Destruction
+
+SpectrumAnalyzer::SpectrumAnalyzer(UInt32 inNumberChannels, Float64 inSampleRate)
+        : mNumberChannels(inNumberChannels),
+          mSampleRate(inSampleRate),
+          mWriteIndex(0),
+          mReadIndex(0),
+          mIsEnabled(false),
+          mProcessor(NULL),
+          mWindowSum(1.0f),
+          mFrameMutex("SpectrumAnalyzer Frame"),
+          mFrameSequence(0),
+          mQueue("SpectrumAnalyzer"),
+          mTimer(NULL),
+          mNumberWrittenBlocks(0),
+          mNumberDroppedBlocks(0),
+          mNumberFrames(0) {
+    ThrowIf(inNumberChannels == 0, CAException(kAudioHardwareIllegalOperationError), "SpectrumAnalyzer::SpectrumAnalyzer: no channels");
+
+    //  everything the IO thread and the analysis need is allocated here
+    mSlotStorage.resize(kNumberSlots * kMaximumFrames * mNumberChannels);
+    for (UInt32 theSlot = 0; theSlot < kNumberSlots; ++theSlot) {
+        mSlots[theSlot].mNumberFrames = 0;
+        mSlots[theSlot].mData = &mSlotStorage[theSlot * kMaximumFrames * mNumberChannels];
+    }
+
+    mProcessor = new CASpectralProcessor(kFFTSize, kFFTSize / 2, mNumberChannels, kMaximumFrames);
+    mChannelStorage.resize(kMaximumFrames * mNumberChannels);
+    SetupBufferList(mBufferListStorage, mChannelStorage, mNumberChannels, kMaximumFrames);
+    mMagnitudeStorage.resize((kFFTSize / 2) * mNumberChannels);
+    SetupBufferList(mMagnitudeListStorage, mMagnitudeStorage, mNumberChannels, kFFTSize / 2);
+    mMinima.resize(mNumberChannels);
+    mMaxima.resize(mNumberChannels);
+    mFrame.assign(kNumberBands * mNumberChannels, kSilenceDecibels);
+
+    //  a full scale sine peaks at the window sum in the packed spectrum
+    mWindowSum = 0.0f;
+    for (UInt32 theIndex = 0; theIndex < kFFTSize; ++theIndex) {
+        mWindowSum += mProcessor->Window()[theIndex];
+    }
+
+    //  log-spaced bands from 20 Hz to Nyquist, each covering at least one bin and never bin 0,
+    //  which holds DC and Nyquist packed together
+    Float64 theBinWidth = mSampleRate / kFFTSize;
+    Float64 theNyquist = mSampleRate / 2.0;
+    UInt32 theLastBin = kFFTSize / 2 - 1;
+    for (UInt32 theBand = 0; theBand < kNumberBands; ++theBand) {
+        Float64 theLow = kLowestBandFrequency * pow(theNyquist / kLowestBandFrequency, (Float64) theBand / kNumberBands);
+        Float64 theHigh = kLowestBandFrequency * pow(theNyquist / kLowestBandFrequency, (Float64) (theBand + 1) / kNumberBands);
+        UInt32 theFirst = std::max<UInt32>(1, (UInt32) lround(theLow / theBinWidth));
+        UInt32 theLast = std::max<UInt32>(theFirst, (UInt32) lround(theHigh / theBinWidth) - 1);
+        mBandFirstBin[theBand] = std::min(theFirst, theLastBin);
+        mBandLastBin[theBand] = std::min(theLast, theLastBin);
+        mBandFrequencies[theBand] = (Float32) sqrt(theLow * theHigh);
+    }
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    SetEnabled(false);
+    delete mProcessor;
+}
+
+#pragma mark IO Operations
+
+void SpectrumAnalyzer::Write(const Float32 *inInterleaved, UInt32 inNumberFrames) {
+    if (!mIsEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+    if (theWriteIndex - mReadIndex.load(std::memory_order_acquire) >= kNumberSlots) {
+        mNumberDroppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Slot &theSlot = mSlots[theWriteIndex % kNumberSlots];
+    theSlot.mNumberFrames = (inNumberFrames < kMaximumFrames) ? inNumberFrames : kMaximumFrames;
+    memcpy(theSlot.mData, inInterleaved, theSlot.mNumberFrames * mNumberChannels * sizeof(Float32));
+    mWriteIndex.store(theWriteIndex + 1, std::memory_order_release);
+    mNumberWrittenBlocks.fetch_add(1, std::memory_order_relaxed);
+}
+
+#pragma mark Operations
+
+void SpectrumAnalyzer::SetEnabled(bool inEnabled, UInt64 inIntervalNanos) {
+    if (inEnabled && (mTimer == NULL)) {
+        mTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, mQueue.GetDispatchQueue());
+        ThrowIfNULL(mTimer, CAException(kAudioHardwareUnspecifiedError), "SpectrumAnalyzer::SetEnabled: couldn't create the timer");
+        dispatch_source_set_timer(mTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t) inIntervalNanos), inIntervalNanos, inIntervalNanos / 10);
+        dispatch_source_set_event_handler(mTimer, ^{
+            try {
+                Analyze();
+            }
+            catch (...) {
+                DebugMsg("SpectrumAnalyzer::SetEnabled: analysis failed");
+            }
+        });
+        mIsEnabled.store(true, std::memory_order_relaxed);
+        dispatch_resume(mTimer);
+    }
+    else if (!inEnabled && (mTimer != NULL)) {
+        //  a handler that is already running finishes before the empty sync block runs
+        mIsEnabled.store(false, std::memory_order_relaxed);
+        dispatch_source_cancel(mTimer);
+        mQueue.Dispatch(true, ^{
+        });
+        dispatch_release(mTimer);
+        mTimer = NULL;
+    }
+}
+
+bool SpectrumAnalyzer::Analyze() {
+    AudioBufferList *theBufferList = reinterpret_cast<AudioBufferList *>(&mBufferListStorage[0]);
+    bool thePublished = false;
+    UInt32 theReadIndex = mReadIndex.load(std::memory_order_relaxed);
+    UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+    while (theReadIndex != theWriteIndex) {
+        const Slot &theSlot = mSlots[theReadIndex % kNumberSlots];
+        for (UInt32 theChannel = 0; theChannel < mNumberChannels; ++theChannel) {
+            Float32 *theChannelData = &mChannelStorage[theChannel * kMaximumFrames];
+            for (UInt32 theFrame = 0; theFrame < theSlot.mNumberFrames; ++theFrame) {
+                theChannelData[theFrame] = theSlot.mData[theFrame * mNumberChannels + theChannel];
+            }
+            theBufferList->mBuffers[theChannel].mDataByteSize = theSlot.mNumberFrames * sizeof(Float32);
+        }
+        if (mProcessor->ProcessForwards(theSlot.mNumberFrames, theBufferList)) {
+            Publish();
+            thePublished = true;
+        }
+        ++theReadIndex;
+        mReadIndex.store(theReadIndex, std::memory_order_release);
+    }
+    return thePublished;
+}
+
+void SpectrumAnalyzer::Publish() {
+    AudioBufferList *theMagnitudeList = reinterpret_cast<AudioBufferList *>(&mMagnitudeListStorage[0]);
+    mProcessor->GetMagnitude(theMagnitudeList, &mMinima[0], &mMaxima[0]);
+
+    CAMutex::Locker theLocker(mFrameMutex);
+    for (UInt32 theChannel = 0; theChannel < mNumberChannels; ++theChannel) {
+        const Float32 *theMagnitudes = &mMagnitudeStorage[theChannel * (kFFTSize / 2)];
+        for (UInt32 theBand = 0; theBand < kNumberBands; ++theBand) {
+            Float32 thePeak = 0.0f;
+            for (UInt32 theBin = mBandFirstBin[theBand]; theBin <= mBandLastBin[theBand]; ++theBin) {
+                thePeak = std::max(thePeak, theMagnitudes[theBin]);
+            }
+            Float32 theAmplitude = thePeak / mWindowSum;
+            mFrame[theChannel * kNumberBands + theBand] = std::max(kSilenceDecibels, 20.0f * log10f(std::max(theAmplitude, 1e-9f)));
+        }
+    }
+    ++mFrameSequence;
+    mNumberFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+CFDictionaryRef SpectrumAnalyzer::CopyFrame() const {
+    CACFDictionary theFrame(false);
+    CACFArray theFrequencies(true);
+    for (UInt32 theBand = 0; theBand < kNumberBands; ++theBand) {
+        theFrequencies.AppendFloat32(mBandFrequencies[theBand]);
+    }
+    theFrame.AddUInt32(CFSTR("Channels"), mNumberChannels);
+    theFrame.AddArray(CFSTR("Frequencies"), theFrequencies.GetCFArray());
+
+    CAMutex::Locker theLocker(mFrameMutex);
+    CFDataRef theMagnitudes = CFDataCreate(kCFAllocatorDefault, reinterpret_cast<const UInt8 *>(&mFrame[0]), (CFIndex) (mFrame.size() * sizeof(Float32)));
+    theFrame.AddData(CFSTR("Magnitudes"), theMagnitudes);
+    CFRelease(theMagnitudes);
+    theFrame.AddUInt64(CFSTR("Sequence"), mFrameSequence);
+    return theFrame.GetCFDictionary();
+}
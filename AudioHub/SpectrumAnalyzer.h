@@ -0,0 +1,134 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __SpectrumAnalyzer__
+#define __SpectrumAnalyzer__
+
+#include <CoreFoundation/CoreFoundation.h>
+#include <dispatch/dispatch.h>
+
+#include <atomic>
+#include <vector>
+
+#include "CADispatchQueue.h"
+#include "CAMutex.h"
+
+class CASpectralProcessor;
+
+//  Live spectrum of a device's output. The IO thread hands each block to Write, which copies it
+//  into a free slot of a small single producer/single consumer ring and returns; a full ring drops
+//  the block. A timer on the analyzer's own queue drains the ring through a CASpectralProcessor
+//  and publishes the magnitudes of the latest hop in log-spaced bands, in dBFS per channel, for
+//  CopyFrame to pick up.
+class SpectrumAnalyzer {
+public:
+    static const UInt32 kFFTSize = 2048;
+    static const UInt32 kNumberBands = 32;
+    static const UInt32 kNumberSlots = 8;
+    static const UInt32 kMaximumFrames = 4096;
+    static const UInt64 kDefaultIntervalNanos = 20 * 1000 * 1000;
+
+#pragma mark Construction/Destruction
+public:
+    SpectrumAnalyzer(UInt32 inNumberChannels, Float64 inSampleRate);
+    ~SpectrumAnalyzer();
+
+private:
+    SpectrumAnalyzer(const SpectrumAnalyzer &);
+    SpectrumAnalyzer &operator=(const SpectrumAnalyzer &);
+
+#pragma mark IO Operations
+public:
+    //  real time safe: one memcpy of at most kMaximumFrames frames, nothing when disabled
+    void Write(const Float32 *inInterleaved, UInt32 inNumberFrames);
+
+#pragma mark Operations
+public:
+    //  starts or stops the timer, which must not be done from the analyzer's queue
+    void SetEnabled(bool inEnabled, UInt64 inIntervalNanos = kDefaultIntervalNanos);
+    bool IsEnabled() const { return mIsEnabled.load(std::memory_order_relaxed); }
+
+    //  drains the ring and publishes a frame if a hop completed, returns whether it did
+    bool Analyze();
+
+    //  {Channels, Frequencies, Magnitudes, Sequence}, Magnitudes being a CFData of Float32 dBFS
+    //  values, kNumberBands per channel
+    CFDictionaryRef CopyFrame() const;
+
+    UInt32 GetNumberChannels() const { return mNumberChannels; }
+    Float64 GetSampleRate() const { return mSampleRate; }
+    Float32 GetBandFrequency(UInt32 inBand) const { return mBandFrequencies[inBand]; }
+
+#pragma mark Statistics
+public:
+    UInt64 GetNumberWrittenBlocks() const { return mNumberWrittenBlocks.load(std::memory_order_relaxed); }
+    UInt64 GetNumberDroppedBlocks() const { return mNumberDroppedBlocks.load(std::memory_order_relaxed); }
+    UInt64 GetNumberFrames() const { return mNumberFrames.load(std::memory_order_relaxed); }
+
+#pragma mark Implementation
+private:
+    struct Slot {
+        UInt32 mNumberFrames;
+        Float32 *mData;
+    };
+
+    void Publish();
+
+    UInt32 mNumberChannels;
+    Float64 mSampleRate;
+
+    //  the ring, mWriteIndex is only written by the IO thread and mReadIndex by the queue
+    std::vector<Float32> mSlotStorage;
+    Slot mSlots[kNumberSlots];
+    std::atomic<UInt32> mWriteIndex;
+    std::atomic<UInt32> mReadIndex;
+    std::atomic<bool> mIsEnabled;
+
+    //  analysis state, only touched on the queue or with the timer stopped
+    CASpectralProcessor *mProcessor;
+    std::vector<Float32> mChannelStorage;
+    std::vector<UInt8> mBufferListStorage;
+    std::vector<UInt8> mMagnitudeListStorage;
+    std::vector<Float32> mMagnitudeStorage;
+    std::vector<Float32> mMinima;
+    std::vector<Float32> mMaxima;
+    Float32 mWindowSum;
+    UInt32 mBandFirstBin[kNumberBands];
+    UInt32 mBandLastBin[kNumberBands];
+    Float32 mBandFrequencies[kNumberBands];
+
+    //  the published frame
+    mutable CAMutex mFrameMutex;
+    std::vector<Float32> mFrame;
+    UInt64 mFrameSequence;
+
+    CADispatchQueue mQueue;
+    dispatch_source_t mTimer;
+
+    std::atomic<UInt64> mNumberWrittenBlocks;
+    std::atomic<UInt64> mNumberDroppedBlocks;
+    std::atomic<UInt64> mNumberFrames;
+};
+
+#endif /* __SpectrumAnalyzer__ */
@@ -12,6 +12,7 @@
 @property NSString* name;
 @property NSString* uid;
 @property NSInteger channels;
+@property float noiseReduction;
 @end
 
 @interface AudioHubSettings : NSObject
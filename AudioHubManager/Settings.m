@@ -40,6 +40,8 @@
         [self addDevice:[deviceDictionary objectForKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceName]
                  andUID:[deviceDictionary objectForKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceUID]
             andChannels:[(NSNumber*)[deviceDictionary objectForKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceChannels] integerValue]];
+        AudioHubDevice* device = [self.devices lastObject];
+        device.noiseReduction = [(NSNumber*)[deviceDictionary objectForKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceNoiseReduction] floatValue];
     }
 }
 
@@ -51,6 +53,9 @@
         [deviceDictionary setObject:device.name forKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceName];
         [deviceDictionary setObject:device.uid forKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceUID];
         [deviceDictionary setObject:[NSNumber numberWithInteger:device.channels] forKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceChannels];
+        if (device.noiseReduction > 0) {
+            [deviceDictionary setObject:[NSNumber numberWithFloat:device.noiseReduction] forKey:(__bridge NSString*)kAudioHubSettingsKeyDeviceNoiseReduction];
+        }
         [devicesArray addObject:deviceDictionary];
     }
     [settingsDictionary setObject:devicesArray forKey:(__bridge NSString*)kAudioHubSettingsKeyDevices];
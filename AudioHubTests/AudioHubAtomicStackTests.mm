@@ -0,0 +1,216 @@
+//
+//  AudioHubAtomicStackTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAAtomicStack.h"
+#include "CAAutoDisposer.h"
+#include "CAThreadSafeList.h"
+#include "CAHostTimeBase.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+struct Item {
+    Item *mNext;
+    UInt32 mIndex;
+    Item *&next() { return mNext; }
+};
+
+static const UInt32 kNumberItems = 64;
+
+//  every thread pops items, holds a few and pushes them back; an item that is popped twice or
+//  lost on the way fails the test. Returns the ns per operation.
+template <class Stack>
+static double Stress(Stack& ioStack, UInt32 inNumberThreads, UInt32 inNumberOperations, bool inCheckOwnership, UInt32& outNumberDuplicates) {
+    std::vector<Item> items(kNumberItems);
+    for (UInt32 i = 0; i < kNumberItems; ++i) {
+        items[i].mIndex = i;
+        ioStack.push_NA(&items[i]);
+    }
+    std::vector<std::atomic<UInt32>> owners(kNumberItems);
+    for (std::atomic<UInt32>& owner : owners) {
+        owner = 0;
+    }
+    std::atomic<UInt32> duplicates(0);
+
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < inNumberThreads; ++thread) {
+        threads.emplace_back([&] {
+            std::vector<Item*> held;
+            for (UInt32 operation = 0; operation < inNumberOperations; ++operation) {
+                Item *item = ioStack.pop_atomic();
+                if (item != NULL) {
+                    if (inCheckOwnership && owners[item->mIndex].fetch_add(1) != 0) {
+                        duplicates.fetch_add(1);
+                    }
+                    held.push_back(item);
+                }
+                if (held.size() > 4 || (item == NULL && !held.empty())) {
+                    if (inCheckOwnership) {
+                        owners[held.back()->mIndex].fetch_sub(1);
+                    }
+                    ioStack.push_atomic(held.back());
+                    held.pop_back();
+                }
+            }
+            for (Item *item : held) {
+                if (inCheckOwnership) {
+                    owners[item->mIndex].fetch_sub(1);
+                }
+                ioStack.push_atomic(item);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    UInt32 numberItems = 0;
+    while (ioStack.pop_NA() != NULL) {
+        ++numberItems;
+    }
+    outNumberDuplicates = duplicates.load() + (kNumberItems - numberItems);
+    return (double)nanos / (inNumberThreads * (double)inNumberOperations);
+}
+
+@interface AudioHubAtomicStackTests : XCTestCase
+
+@end
+
+@implementation AudioHubAtomicStackTests
+
+- (void)testTaggedStackOrder {
+    std::vector<Item> items(4);
+    TAtomicTaggedStack<Item> stack;
+    XCTAssert(stack.empty());
+    for (Item& item : items) {
+        stack.push_atomic(&item);
+    }
+    XCTAssertEqual(stack.head(), &items[3]);
+    XCTAssertEqual(stack.pop_atomic(), &items[3]);
+    XCTAssertEqual(stack.pop_atomic(), &items[2]);
+
+    Item *reversed = stack.pop_all_reversed();
+    XCTAssertEqual(reversed, &items[0]);
+    XCTAssertEqual(reversed->next(), &items[1]);
+    XCTAssert(stack.empty());
+    XCTAssert(stack.pop_atomic() == NULL);
+
+    stack.push_multiple_atomic(reversed);
+    XCTAssertEqual(stack.pop_atomic(), &items[0]);
+    XCTAssertEqual(stack.pop_atomic(), &items[1]);
+    XCTAssert(stack.empty());
+}
+
+- (void)testTaggedStackUnderContention {
+    //  run this under the Thread Sanitizer as well
+    for (UInt32 numberThreads = 2; numberThreads <= 16; numberThreads *= 2) {
+        TAtomicTaggedStack<Item> stack;
+        UInt32 duplicates = 0;
+        Stress(stack, numberThreads, 100000, true, duplicates);
+        XCTAssertEqual(duplicates, 0, @"%u threads", numberThreads);
+    }
+}
+
+- (void)testNodePool {
+    TAtomicNodePool<UInt64> pool(128);
+    XCTAssertEqual(pool.capacity(), 128);
+    std::vector<UInt64*> nodes;
+    UInt64 *node;
+    while ((node = pool.allocate()) != NULL) {
+        XCTAssert(pool.owns(node));
+        nodes.push_back(node);
+    }
+    XCTAssertEqual(nodes.size(), 128);
+    XCTAssertEqual(pool.number_in_use(), 128);
+    UInt64 outside = 0;
+    XCTAssertFalse(pool.owns(&outside));
+    for (UInt64 *node : nodes) {
+        pool.deallocate(node);
+    }
+    XCTAssertEqual(pool.number_in_use(), 0);
+
+    //  a node is only ever handed to one thread at a time
+    TAtomicNodePool<UInt64> *poolPointer = &pool;
+    std::atomic<UInt32> corrupted(0);
+    std::vector<std::thread> threads;
+    for (UInt64 thread = 0; thread < 8; ++thread) {
+        threads.emplace_back([=, &corrupted] {
+            for (UInt64 operation = 0; operation < 100000; ++operation) {
+                UInt64 *node = poolPointer->allocate();
+                if (node == NULL) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                *node = (thread << 32) | operation;
+                std::this_thread::yield();
+                if (*node != ((thread << 32) | operation)) {
+                    corrupted.fetch_add(1);
+                }
+                poolPointer->deallocate(node);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    XCTAssertEqual(corrupted.load(), 0);
+    XCTAssertEqual(pool.number_in_use(), 0);
+}
+
+- (void)testThreadSafeList {
+    TThreadSafeList<UInt32> list(16);
+    TThreadSafeList<UInt32> *listPointer = &list;
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([=] {
+            for (UInt32 i = 0; i < 2000; ++i) {
+                listPointer->deferred_add(thread * 10000 + i);
+                if (i % 2) {
+                    listPointer->deferred_remove(thread * 10000 + i);
+                }
+            }
+        });
+    }
+    for (UInt32 i = 0; i < 200; ++i) {
+        list.update();
+        std::this_thread::yield();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    list.update();
+
+    UInt32 numberItems = 0;
+    for (TThreadSafeList<UInt32>::iterator i = list.begin(); i != list.end(); ++i) {
+        XCTAssertEqual(*i % 2, 0);
+        ++numberItems;
+    }
+    XCTAssertEqual(numberItems, 4000);
+}
+
+#pragma mark Performance
+
+//  logs ns per pop or push for both stacks while every thread pops and pushes back
+- (void)testPerformanceContention {
+    [self measureBlock:^{
+        for (UInt32 numberThreads = 2; numberThreads <= 16; numberThreads *= 2) {
+            UInt32 duplicates = 0;
+            TAtomicTaggedStack<Item> tagged;
+            double taggedNanos = Stress(tagged, numberThreads, 200000, false, duplicates);
+            TAtomicStack<Item> plain;
+            double plainNanos = Stress(plain, numberThreads, 200000, false, duplicates);
+            NSLog(@"atomic stack %2u threads: %6.1f ns tagged (%s), %6.1f ns pop_all and push back", numberThreads, taggedNanos,
+                  TAtomicTaggedStack<Item>::is_double_width() ? "double width" : "packed", plainNanos);
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,170 @@
+//
+//  AudioHubAudioBufferListTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAAudioBufferList.h"
+#include "CAHostTimeBase.h"
+#include "CAVectorKernels.h"
+#include <algorithm>
+#include <vector>
+
+//  a buffer list and the samples behind it, every other buffer starts one sample off alignment
+struct TestBufferList {
+    TestBufferList(const std::vector<UInt32> &inLayout, UInt32 inNumberFrames, UInt32 inSeed) : mList(CAAudioBufferList::Create((UInt32)inLayout.size())), mSamples(inLayout.size()) {
+        for (UInt32 i = 0; i < inLayout.size(); ++i) {
+            mSamples[i].resize(inLayout[i] * inNumberFrames + 1);
+            for (UInt32 k = 0; k < mSamples[i].size(); ++k) {
+                //  small integers, so every sum is exact in any order
+                mSamples[i][k] = (inSeed == 0) ? -1.0f : (Float32)((inSeed * 7919 + i * 104729 + k * 31) % 2001) - 1000.0f;
+            }
+            mList->mBuffers[i].mNumberChannels = inLayout[i];
+            mList->mBuffers[i].mDataByteSize = inLayout[i] * inNumberFrames * sizeof(Float32);
+            mList->mBuffers[i].mData = &mSamples[i][i % 2];
+        }
+    }
+    ~TestBufferList() { CAAudioBufferList::Destroy(mList); }
+
+    AudioBufferList *mList;
+    std::vector<std::vector<Float32>> mSamples;
+};
+
+//  what Copy() did before it went through the kernels, one sample of one channel at a time
+static void CopyOneSampleAtATime(const AudioBufferList &inSource, UInt32 inSourceChannel, AudioBufferList &outDestination, UInt32 inDestinationChannel) {
+    UInt32 numberSourceChannels = CAAudioBufferList::GetTotalNumberChannels(inSource);
+    UInt32 numberDestinationChannels = CAAudioBufferList::GetTotalNumberChannels(outDestination);
+    for (; (inSourceChannel < numberSourceChannels) && (inDestinationChannel < numberDestinationChannels); ++inSourceChannel, ++inDestinationChannel) {
+        UInt32 sourceBuffer, sourceBufferChannel, destinationBuffer, destinationBufferChannel;
+        CAAudioBufferList::GetBufferForChannel(inSource, inSourceChannel, sourceBuffer, sourceBufferChannel);
+        CAAudioBufferList::GetBufferForChannel(outDestination, inDestinationChannel, destinationBuffer, destinationBufferChannel);
+        const AudioBuffer &source = inSource.mBuffers[sourceBuffer];
+        AudioBuffer &destination = outDestination.mBuffers[destinationBuffer];
+        UInt32 numberFrames = std::min(source.mDataByteSize / (source.mNumberChannels * (UInt32)sizeof(Float32)), destination.mDataByteSize / (destination.mNumberChannels * (UInt32)sizeof(Float32)));
+        for (UInt32 frame = 0; frame < numberFrames; ++frame) {
+            static_cast<Float32 *>(destination.mData)[frame * destination.mNumberChannels + destinationBufferChannel] = static_cast<const Float32 *>(source.mData)[frame * source.mNumberChannels + sourceBufferChannel];
+        }
+    }
+}
+
+//  what Sum() did before it went through the kernels
+static void SumOneSampleAtATime(const AudioBufferList &inSource, AudioBufferList &ioSum) {
+    for (UInt32 i = 0; i < ioSum.mNumberBuffers; ++i) {
+        const Float32 *source = static_cast<const Float32 *>(inSource.mBuffers[i].mData);
+        Float32 *sum = static_cast<Float32 *>(ioSum.mBuffers[i].mData);
+        for (UInt32 k = 0; k < ioSum.mBuffers[i].mDataByteSize / sizeof(Float32); ++k) {
+            sum[k] += source[k];
+        }
+    }
+}
+
+static const std::vector<std::vector<UInt32>> kLayouts = {
+    { 1 }, { 2 }, { 1, 1 }, { 8 }, { 1, 1, 1, 1, 1, 1, 1, 1 }, { 2, 2, 2, 2 }, { 6, 2 }, { 3, 1, 4, 1, 5 },
+    std::vector<UInt32>(20, 1), { 20 },
+};
+
+@interface AudioHubAudioBufferListTests : XCTestCase
+
+@end
+
+@implementation AudioHubAudioBufferListTests
+
+- (void)tearDown {
+    CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+    [super tearDown];
+}
+
+//  every pair of layouts, starting channels and frame counts, with the best tier and without vectors
+- (void)testCopyMatchesOneSampleAtATime {
+    const UInt32 masks[] = { 0xFFFFFFFF, 0 };
+    for (UInt32 mask : masks) {
+        CAVectorUnit::SetFeatureMask(mask);
+        for (const std::vector<UInt32> &sourceLayout : kLayouts) {
+            for (const std::vector<UInt32> &destinationLayout : kLayouts) {
+                for (UInt32 firstChannel = 0; firstChannel < 9; ++firstChannel) {
+                    UInt32 numberFrames = 37 + firstChannel % 3 * 27;
+                    TestBufferList source(sourceLayout, numberFrames, 1);
+                    TestBufferList destination(destinationLayout, numberFrames + firstChannel % 2, 0);
+                    TestBufferList expected(destinationLayout, numberFrames + firstChannel % 2, 0);
+                    CAAudioBufferList::Copy(*source.mList, firstChannel / 3, *destination.mList, firstChannel % 3);
+                    CopyOneSampleAtATime(*source.mList, firstChannel / 3, *expected.mList, firstChannel % 3);
+                    XCTAssert(destination.mSamples == expected.mSamples, @"%zu buffers to %zu buffers from channel %u to %u",
+                              sourceLayout.size(), destinationLayout.size(), firstChannel / 3, firstChannel % 3);
+                }
+            }
+        }
+    }
+}
+
+- (void)testCopyChannel {
+    TestBufferList source({ 6 }, 100, 1);
+    TestBufferList destination({ 2 }, 80, 0);
+    CAAudioBufferList::CopyChannel(source.mList->mBuffers[0], 5, destination.mList->mBuffers[0], 1);
+    const Float32 *copied = static_cast<const Float32 *>(destination.mList->mBuffers[0].mData);
+    const Float32 *original = static_cast<const Float32 *>(source.mList->mBuffers[0].mData);
+    for (UInt32 frame = 0; frame < 80; ++frame) {
+        XCTAssertEqual(copied[2 * frame], -1.0f);
+        XCTAssertEqual(copied[2 * frame + 1], original[6 * frame + 5]);
+    }
+    //  the destination has fewer frames than the source, nothing behind it is touched
+    XCTAssertEqual(destination.mSamples[0].back(), -1.0f);
+}
+
+- (void)testSum {
+    for (const std::vector<UInt32> &layout : kLayouts) {
+        TestBufferList source(layout, 99, 1);
+        TestBufferList sum(layout, 99, 2);
+        TestBufferList expected(layout, 99, 2);
+        CAAudioBufferList::Sum(*source.mList, *sum.mList);
+        SumOneSampleAtATime(*source.mList, *expected.mList);
+        XCTAssert(sum.mSamples == expected.mSamples, @"%zu buffers", layout.size());
+
+        //  a gain of 0.5 and -2 keeps the integers exact, fused or not
+        CAAudioBufferList::Sum(*source.mList, 0.5f, *sum.mList);
+        CAAudioBufferList::Sum(*source.mList, -2.0f, *sum.mList);
+        for (UInt32 k = 0; k < layout.size(); ++k) {
+            for (UInt32 n = 0; n < 99 * layout[k]; ++n) {
+                static_cast<Float32 *>(expected.mList->mBuffers[k].mData)[n] -= 1.5f * static_cast<const Float32 *>(source.mList->mBuffers[k].mData)[n];
+            }
+        }
+        XCTAssert(sum.mSamples == expected.mSamples, @"%zu buffers with gain", layout.size());
+    }
+}
+
+#pragma mark Performance
+
+enum { kNumberFrames = 512, kNumberRuns = 5000 };
+
+static double MeasureNanosPerSample(UInt32 inNumberSamples, void (^inBlock)(void)) {
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 run = 0; run < kNumberRuns; ++run) {
+        inBlock();
+    }
+    return (double)CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) / ((double)kNumberRuns * inNumberSamples);
+}
+
+//  logs ns per sample of the old loops and of the kernels for mixing and for the common routings
+- (void)testPerformanceAgainstOneSampleAtATime {
+    TestBufferList stereo({ 2 }, kNumberFrames, 1), stereoSum({ 2 }, kNumberFrames, 2);
+    TestBufferList planarStereo({ 1, 1 }, kNumberFrames, 1);
+    TestBufferList eight({ 8 }, kNumberFrames, 1), planarEight(std::vector<UInt32>(8, 1), kNumberFrames, 1);
+    TestBufferList sixteen({ 16 }, kNumberFrames, 1), subset({ 2, 4 }, kNumberFrames, 1);
+    TestBufferList *stereoPointer = &stereo, *stereoSumPointer = &stereoSum, *planarStereoPointer = &planarStereo;
+    TestBufferList *eightPointer = &eight, *planarEightPointer = &planarEight, *sixteenPointer = &sixteen, *subsetPointer = &subset;
+    [self measureBlock:^{
+        NSLog(@"sum              %6.3f ns per sample, was %6.3f", MeasureNanosPerSample(2 * kNumberFrames, ^{ CAAudioBufferList::Sum(*stereoPointer->mList, *stereoSumPointer->mList); }),
+              MeasureNanosPerSample(2 * kNumberFrames, ^{ SumOneSampleAtATime(*stereoPointer->mList, *stereoSumPointer->mList); }));
+        NSLog(@"sum with gain    %6.3f ns per sample", MeasureNanosPerSample(2 * kNumberFrames, ^{ CAAudioBufferList::Sum(*stereoPointer->mList, 0.5f, *stereoSumPointer->mList); }));
+        NSLog(@"interleave 2     %6.3f ns per sample, was %6.3f", MeasureNanosPerSample(2 * kNumberFrames, ^{ CAAudioBufferList::Copy(*planarStereoPointer->mList, 0, *stereoPointer->mList, 0); }),
+              MeasureNanosPerSample(2 * kNumberFrames, ^{ CopyOneSampleAtATime(*planarStereoPointer->mList, 0, *stereoPointer->mList, 0); }));
+        NSLog(@"deinterleave 8   %6.3f ns per sample, was %6.3f", MeasureNanosPerSample(8 * kNumberFrames, ^{ CAAudioBufferList::Copy(*eightPointer->mList, 0, *planarEightPointer->mList, 0); }),
+              MeasureNanosPerSample(8 * kNumberFrames, ^{ CopyOneSampleAtATime(*eightPointer->mList, 0, *planarEightPointer->mList, 0); }));
+        NSLog(@"6 of 16 channels %6.3f ns per sample, was %6.3f", MeasureNanosPerSample(6 * kNumberFrames, ^{ CAAudioBufferList::Copy(*sixteenPointer->mList, 4, *subsetPointer->mList, 0); }),
+              MeasureNanosPerSample(6 * kNumberFrames, ^{ CopyOneSampleAtATime(*sixteenPointer->mList, 4, *subsetPointer->mList, 0); }));
+    }];
+}
+
+@end
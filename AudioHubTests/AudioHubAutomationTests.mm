@@ -0,0 +1,255 @@
+//
+//  AudioHubAutomationTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <CoreAudio/AudioServerPlugIn.h>
+#if !ULTRASCHALL
+#if !TEST
+#include "AudioHubTypes.h"
+#else
+#include "AudioHubTestTypes.h"
+#endif
+#else
+#if !TEST
+#include "UltraschallHubTypes.h"
+#else
+#include "UltraschallHubTestTypes.h"
+#endif
+#endif
+#include "CAHALAudioObjectTester.h"
+#include "CAPropertyAddress.h"
+#include "AutomationQueue.h"
+#include "CARealTimeChecker.h"
+#include "Device.h"
+#include "PlugIn.h"
+#include "AudioHubSimulatedIODriver.h"
+#include <vector>
+
+@interface AudioHubAutomationTests : XCTestCase
+
+@end
+
+@implementation AudioHubAutomationTests
+
+static AutomationQueue::Event MakeEvent(Float64 inSampleTime, UInt32 inParameter, Float32 inValue) {
+    AutomationQueue::Event event = { inSampleTime, inParameter, inValue };
+    return event;
+}
+
+- (void)setUp {
+    [super setUp];
+    CARealTimeChecker::ResetViolations();
+}
+
+//  every cycle a test ran through the simulated driver has to be real time safe
+- (void)tearDown {
+    XCTAssertEqual(CARealTimeChecker::GetNumberViolations(), 0);
+    CARealTimeChecker::DumpViolations();
+    [super tearDown];
+}
+
+- (void)testSegmentsSplitAtEvents {
+    AutomationQueue queue;
+    const AutomationQueue::Event events[] = {
+        MakeEvent(300.0, AutomationQueue::kParameterInputVolume, 0.25f),
+        MakeEvent(100.0, AutomationQueue::kParameterInputVolume, 0.5f),
+        MakeEvent(100.5, AutomationQueue::kParameterOutputVolume, 0.75f),
+    };
+    XCTAssertEqual(queue.Push(events, 3), 3);
+    queue.Drain();
+
+    Float32 value = 1.0f;
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterInputVolume, 0.0, 512, value), 100);
+    XCTAssertEqual(value, 1.0f);
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterInputVolume, 100.0, 412, value), 200);
+    XCTAssertEqual(value, 0.5f);
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterInputVolume, 300.0, 212, value), 212);
+    XCTAssertEqual(value, 0.25f);
+
+    //  a fractional time lands on the next whole frame
+    value = 1.0f;
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterOutputVolume, 0.0, 512, value), 101);
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterOutputVolume, 101.0, 411, value), 411);
+    XCTAssertEqual(value, 0.75f);
+}
+
+- (void)testFullRingDropsEvents {
+    AutomationQueue queue;
+    std::vector<AutomationQueue::Event> events(AutomationQueue::kCapacity + 8, MakeEvent(0.0, AutomationQueue::kParameterInputVolume, 0.5f));
+    XCTAssertEqual(queue.Push(&events[0], (UInt32) events.size()), AutomationQueue::kCapacity);
+    XCTAssertEqual(queue.GetNumberDroppedEvents(), 8);
+    XCTAssertEqual(queue.GetNumberFreeSlots(), 0);
+    queue.Drain();
+    XCTAssertEqual(queue.GetNumberFreeSlots(), AutomationQueue::kCapacity);
+}
+
+- (void)testFullParameterDoesNotStallOthers {
+    AutomationQueue queue;
+    std::vector<AutomationQueue::Event> events(AutomationQueue::kCapacity, MakeEvent(1000.0, AutomationQueue::kParameterInputVolume, 0.5f));
+    XCTAssertEqual(queue.Push(&events[0], (UInt32) events.size()), AutomationQueue::kCapacity);
+    queue.Drain();
+
+    //  the input volume's list is full, its next event waits in the ring, the output volume's does not
+    XCTAssert(queue.Push(MakeEvent(2000.0, AutomationQueue::kParameterInputVolume, 0.25f)));
+    XCTAssert(queue.Push(MakeEvent(0.0, AutomationQueue::kParameterOutputVolume, 0.75f)));
+    queue.Drain();
+    XCTAssertEqual(queue.GetNumberFreeSlots(), AutomationQueue::kCapacity - 2);
+    Float32 value = 1.0f;
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterOutputVolume, 0.0, kBufferFrameSize, value), kBufferFrameSize);
+    XCTAssertEqual(value, 0.75f);
+
+    //  once the input volume's events are due, the waiting one is taken, and the output volume's is not taken twice
+    value = 1.0f;
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterInputVolume, 1000.0, kBufferFrameSize, value), kBufferFrameSize);
+    XCTAssertEqual(value, 0.5f);
+    queue.Drain();
+    XCTAssertEqual(queue.GetNumberFreeSlots(), AutomationQueue::kCapacity);
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterInputVolume, 2000.0, kBufferFrameSize, value), kBufferFrameSize);
+    XCTAssertEqual(value, 0.25f);
+    value = 1.0f;
+    XCTAssertEqual(queue.NextSegment(AutomationQueue::kParameterOutputVolume, 0.0, kBufferFrameSize, value), kBufferFrameSize);
+    XCTAssertEqual(value, 1.0f);
+}
+
+- (void)testWriteVolumeIsSampleAccurate {
+    SimulatedIODriver driver;
+    const AutomationQueue::Event events[] = {
+        MakeEvent(100.0, AutomationQueue::kParameterInputVolume, 0.5f),
+        MakeEvent(700.0, AutomationQueue::kParameterInputVolume, 0.25f),
+        MakeEvent(1024.0, AutomationQueue::kParameterInputVolume, 0.0f),
+        MakeEvent(1025.0, AutomationQueue::kParameterInputVolume, 1.0f),
+    };
+    driver.GetDevice()->ScheduleAutomation(events, 4);
+    driver.RunCycles(4);
+
+    for (UInt32 frame = 0; frame < 4 * kBufferFrameSize; ++frame) {
+        Float32 expected = frame < 100 ? 1.0f : frame < 700 ? 0.5f : frame < 1024 ? 0.25f : frame < 1025 ? 0.0f : 1.0f;
+        XCTAssertEqual(driver.GetWriteGain(frame), expected, @"frame %u", frame);
+    }
+}
+
+- (void)testReadVolumeIsSampleAccurate {
+    SimulatedIODriver driver;
+    const AutomationQueue::Event events[] = {
+        MakeEvent(511.0, AutomationQueue::kParameterOutputVolume, 0.5f),
+        MakeEvent(512.0, AutomationQueue::kParameterOutputVolume, 0.25f),
+    };
+    driver.GetDevice()->ScheduleAutomation(events, 2);
+    driver.RunCycles(2);
+
+    for (UInt32 frame = 0; frame < 2 * kBufferFrameSize; ++frame) {
+        Float32 expected = frame < 511 ? 1.0f : frame < 512 ? 0.5f : 0.25f;
+        XCTAssertEqual(driver.GetWriteGain(frame), 1.0f, @"frame %u", frame);
+        XCTAssertEqual(driver.GetReadGain(frame), expected, @"frame %u", frame);
+    }
+}
+
+- (void)testLateEventsApplyOnTheFirstFrame {
+    SimulatedIODriver driver;
+    driver.RunCycles(2);
+    const AutomationQueue::Event event = MakeEvent(100.0, AutomationQueue::kParameterInputVolume, 0.5f);
+    driver.GetDevice()->ScheduleAutomation(&event, 1);
+    driver.RunCycles(1);
+    XCTAssertEqual(driver.GetWriteGain(2 * kBufferFrameSize - 1), 1.0f);
+    XCTAssertEqual(driver.GetWriteGain(2 * kBufferFrameSize), 0.5f);
+}
+
+- (void)testAutomatedVolumeChangesAreNotified {
+    NotificationAggregator &aggregator = PlugIn::GetNotificationAggregator();
+    UInt64 numberPostedCalls = aggregator.GetNumberPostedCalls();
+    SimulatedIODriver driver;
+    const AutomationQueue::Event events[] = {
+        MakeEvent(100.0, AutomationQueue::kParameterInputVolume, 0.5f),
+        MakeEvent(200.0, AutomationQueue::kParameterOutputVolume, 0.5f),
+    };
+    driver.GetDevice()->ScheduleAutomation(events, 2);
+    driver.RunCycles(1);
+
+    //  one call per volume control, posted off the IO thread
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:2.0];
+    while ((aggregator.GetNumberPostedCalls() < numberPostedCalls + 2) && ([deadline timeIntervalSinceNow] > 0)) {
+        usleep(1000);
+    }
+    XCTAssertEqual(aggregator.GetNumberPostedCalls(), numberPostedCalls + 2);
+}
+
+- (void)testVolumeControlAndAutomationShareTheVolume {
+    SimulatedIODriver driver;
+    Device *device = driver.GetDevice();
+    AudioObjectID controls[2] = {};
+    UInt32 size = sizeof(controls);
+    CAHALAudioObjectTester tester(device);
+    tester.GetPropertyData(CAPropertyAddress(kAudioObjectPropertyControlList), 0, NULL, size, controls);
+    CAPropertyAddress scalarValue(kAudioLevelControlPropertyScalarValue);
+
+    //  the control reads what automation stepped the volume to
+    const AutomationQueue::Event event = MakeEvent(100.0, AutomationQueue::kParameterInputVolume, 0.5f);
+    device->ScheduleAutomation(&event, 1);
+    driver.RunCycles(1);
+    Float32 volume = 0.0f;
+    UInt32 volumeSize = 0;
+    device->GetPropertyData(controls[0], 0, scalarValue, 0, NULL, sizeof(volume), volumeSize, &volume);
+    XCTAssertEqual(volume, 0.5f);
+
+    //  and the IO thread scales by what the control set
+    volume = 0.75f;
+    device->SetPropertyData(controls[0], 0, scalarValue, 0, NULL, sizeof(volume), &volume);
+    driver.RunCycles(1);
+    XCTAssertEqual(driver.GetWriteGain(kBufferFrameSize), 0.75f);
+    volume = 0.0f;
+    device->GetPropertyData(controls[0], 0, scalarValue, 0, NULL, sizeof(volume), volumeSize, &volume);
+    XCTAssertEqual(volume, 0.75f);
+}
+
+#if !ULTRASCHALL
+- (void)testDeviceProperty {
+    SimulatedIODriver driver;
+    CAHALAudioObjectTester tester(driver.GetDevice());
+    CAPropertyAddress address(kAudioHubCustomPropertyAutomation);
+    XCTAssert(tester.HasProperty(address));
+    XCTAssert(tester.IsPropertySettable(address));
+
+    NSArray *events = @[
+        @{(__bridge NSString *)kAudioHubAutomationKeySampleTime: @256, (__bridge NSString *)kAudioHubAutomationKeyParameter: @(kAudioHubAutomationParameterInputVolume), (__bridge NSString *)kAudioHubAutomationKeyValue: @0.5},
+        @{(__bridge NSString *)kAudioHubAutomationKeySampleTime: @300, (__bridge NSString *)kAudioHubAutomationKeyParameter: @(kAudioHubAutomationParameterOutputVolume), (__bridge NSString *)kAudioHubAutomationKeyValue: @2.0},
+    ];
+    tester.SetPropertyData_CFType(address, (__bridge CFArrayRef)events);
+
+    CFDictionaryRef status = (CFDictionaryRef)tester.GetPropertyData_CFType(address);
+    XCTAssertEqual([((__bridge NSDictionary *)status)[(__bridge NSString *)kAudioHubAutomationKeyScheduled] unsignedIntValue], 2);
+    CFRelease(status);
+
+    driver.RunCycles(1);
+    XCTAssertEqual(driver.GetWriteGain(255), 1.0f);
+    XCTAssertEqual(driver.GetWriteGain(256), 0.5f);
+    //  values are clamped like the volume control's scalar value
+    XCTAssertEqual(driver.GetReadGain(299), 0.5f);
+    XCTAssertEqual(driver.GetReadGain(300), 0.5f);
+
+    //  a malformed batch is rejected as a whole
+    NSArray *malformed = @[
+        @{(__bridge NSString *)kAudioHubAutomationKeySampleTime: @1024, (__bridge NSString *)kAudioHubAutomationKeyParameter: @0, (__bridge NSString *)kAudioHubAutomationKeyValue: @0.5},
+        @{(__bridge NSString *)kAudioHubAutomationKeySampleTime: @1024, (__bridge NSString *)kAudioHubAutomationKeyParameter: @7, (__bridge NSString *)kAudioHubAutomationKeyValue: @0.5},
+    ];
+    XCTAssertThrows(tester.SetPropertyData_CFType(address, (__bridge CFArrayRef)malformed));
+    XCTAssertThrows(tester.SetPropertyData_CFType(address, CFSTR("YES")));
+
+    NSMutableArray *tooMany = [NSMutableArray array];
+    for (UInt32 i = 0; i <= AutomationQueue::kCapacity; ++i) {
+        [tooMany addObject:events[0]];
+    }
+    XCTAssertThrows(tester.SetPropertyData_CFType(address, (__bridge CFArrayRef)tooMany));
+
+    status = (CFDictionaryRef)tester.GetPropertyData_CFType(address);
+    XCTAssertEqual([((__bridge NSDictionary *)status)[(__bridge NSString *)kAudioHubAutomationKeyScheduled] unsignedIntValue], 2);
+    XCTAssertEqual([((__bridge NSDictionary *)status)[(__bridge NSString *)kAudioHubAutomationKeyFree] unsignedIntValue], AutomationQueue::kCapacity);
+    CFRelease(status);
+}
+#endif
+
+@end
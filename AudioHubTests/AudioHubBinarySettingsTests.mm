@@ -0,0 +1,190 @@
+//
+//  AudioHubBinarySettingsTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "DeviceList.h"
+#if !ULTRASCHALL
+#if !TEST
+#include "AudioHubTypes.h"
+#else
+#include "AudioHubTestTypes.h"
+#endif
+#else
+#if !TEST
+#include "UltraschallHubTypes.h"
+#else
+#include "UltraschallHubTestTypes.h"
+#endif
+#endif
+#include "BinarySettings.h"
+#include "CACFDictionary.h"
+#include "CACFArray.h"
+
+@interface AudioHubBinarySettingsTests : XCTestCase
+
+@end
+
+@implementation AudioHubBinarySettingsTests
+
+static CFDataRef CopyXMLSettings(UInt32 inNumberDevices) {
+    CACFDictionary settings;
+    CACFArray devices;
+    for (UInt32 i = 0; i < inNumberDevices; ++i) {
+        CACFDictionary device;
+        NSString *name = [NSString stringWithFormat:@"name%u", i];
+        NSString *uid = [NSString stringWithFormat:@"uid%u", i];
+        device.AddCFType(kAudioHubSettingsKeyDeviceName, (__bridge CFStringRef)name);
+        device.AddCFType(kAudioHubSettingsKeyDeviceUID, (__bridge CFStringRef)uid);
+        device.AddUInt32(kAudioHubSettingsKeyDeviceChannels, 2 + (i % 16));
+        devices.AppendDictionary(device.CopyCFDictionary());
+    }
+    settings.AddArray(kAudioHubSettingsKeyDevices, devices.CopyCFArray());
+    CFDictionaryRef dictionary = settings.CopyCFDictionary();
+    CFDataRef data = CFPropertyListCreateData(kCFAllocatorDefault, dictionary, kCFPropertyListXMLFormat_v1_0, 0, NULL);
+    CFRelease(dictionary);
+    return data;
+}
+
+static CFDataRef CopyBinarySettings(UInt32 inNumberDevices) {
+    BinarySettingsWriter writer;
+    for (UInt32 i = 0; i < inNumberDevices; ++i) {
+        NSString *name = [NSString stringWithFormat:@"name%u", i];
+        NSString *uid = [NSString stringWithFormat:@"uid%u", i];
+        writer.AppendDevice((__bridge CFStringRef)uid, (__bridge CFStringRef)name, 2 + (i % 16));
+    }
+    return writer.CopyData();
+}
+
+- (void)testRoundTrip {
+    DeviceList source;
+    source.AddDevice(CFSTR("uid"), CFSTR("näme"), 2);
+    source.AddDevice(CFSTR("uid2"), CFSTR("name2"), 8);
+    CFDataRef data = source.CopyBinarySettings();
+    XCTAssert(BinarySettingsReader::HasMagic(data));
+
+    DeviceList destination;
+    XCTAssert(destination.SetSettings(data));
+    XCTAssertEqual(destination.NumDevices(), 2);
+    XCTAssertNotEqual(destination.GetDeviceObjectIDByUUID(CFSTR("uid2")), kAudioObjectUnknown);
+
+    NSDictionary *settings = (__bridge_transfer NSDictionary*)destination.GetSettings();
+    NSArray *devices = settings[(__bridge NSString*)kAudioHubSettingsKeyDevices];
+    XCTAssertEqual([devices count], 2);
+    XCTAssertEqualObjects(devices[0][(__bridge NSString*)kAudioHubSettingsKeyDeviceName], @"näme");
+    XCTAssertEqualObjects(devices[1][(__bridge NSString*)kAudioHubSettingsKeyDeviceChannels], @8);
+    CFRelease(data);
+}
+
+- (void)testTruncatedData {
+    CFDataRef data = CopyBinarySettings(4);
+    BinarySettingsReader reader(CFDataGetBytePtr(data), CFDataGetLength(data) - 3);
+    XCTAssert(reader.IsValid());
+    XCTAssertEqual(reader.GetNumberDevices(), 4);
+
+    BinarySettingsDevice device;
+    UInt32 numberDevices = 0;
+    while (reader.GetNextDevice(device)) {
+        ++numberDevices;
+    }
+    XCTAssertEqual(numberDevices, 3);
+    XCTAssertFalse(reader.IsValid());
+    CFRelease(data);
+}
+
+- (void)testNewerVersionIsRejected {
+    CFDataRef data = CopyBinarySettings(1);
+    CFMutableDataRef newer = CFDataCreateMutableCopy(kCFAllocatorDefault, 0, data);
+    CFDataGetMutableBytePtr(newer)[4] = kBinarySettingsVersion + 1;
+    BinarySettingsReader reader(newer);
+    XCTAssertFalse(reader.IsValid());
+
+    DeviceList deviceList;
+    XCTAssertFalse(deviceList.SetSettings(newer));
+    CFRelease(newer);
+    CFRelease(data);
+}
+
+- (void)testVersion1StillLoads {
+    const UInt8 data[] = {
+        'B', 'S', 'H', 'A', 1, 0, 0, 0, 1, 0, 0, 0,
+        2, 0, 0, 0, 3, 0, 4, 0, 'u', 'i', 'd', 'n', 'a', 'm', 'e'
+    };
+    BinarySettingsReader reader(data, sizeof(data));
+    XCTAssert(reader.IsValid());
+    XCTAssertEqual(reader.GetVersion(), 1);
+
+    BinarySettingsDevice device;
+    XCTAssert(reader.GetNextDevice(device));
+    XCTAssertEqual(device.mChannels, 2);
+    XCTAssertEqual(device.mNoiseReduction, 0.0f);
+    XCTAssertEqual(device.mUIDLength, 3);
+    XCTAssertEqual(memcmp(device.mName, "name", 4), 0);
+    XCTAssertFalse(reader.GetNextDevice(device));
+    XCTAssert(reader.IsValid());
+}
+
+- (void)testXMLSettingsStillLoad {
+    CFDataRef data = CopyXMLSettings(4);
+    XCTAssertFalse(BinarySettingsReader::HasMagic(data));
+    CFPropertyListRef propertyList = CFPropertyListCreateWithData(kCFAllocatorDefault, data, kCFPropertyListImmutable, NULL, NULL);
+    DeviceList deviceList;
+    XCTAssert(deviceList.SetSettings(propertyList));
+    XCTAssertEqual(deviceList.NumDevices(), 4);
+    CFRelease(propertyList);
+    CFRelease(data);
+}
+
+#pragma mark Startup
+
+- (void)measureXMLStartupWithDevices:(UInt32)inNumberDevices {
+    CFDataRef data = CopyXMLSettings(inNumberDevices);
+    [self measureBlock:^{
+        DeviceList deviceList;
+        CFPropertyListRef propertyList = CFPropertyListCreateWithData(kCFAllocatorDefault, data, kCFPropertyListImmutable, NULL, NULL);
+        deviceList.SetSettings(propertyList);
+        CFRelease(propertyList);
+        XCTAssertEqual(deviceList.NumDevices(), inNumberDevices);
+    }];
+    CFRelease(data);
+}
+
+- (void)measureBinaryStartupWithDevices:(UInt32)inNumberDevices {
+    CFDataRef data = CopyBinarySettings(inNumberDevices);
+    [self measureBlock:^{
+        DeviceList deviceList;
+        deviceList.SetBinarySettings(CFDataGetBytePtr(data), CFDataGetLength(data));
+        XCTAssertEqual(deviceList.NumDevices(), inNumberDevices);
+    }];
+    CFRelease(data);
+}
+
+- (void)testPerformanceXMLStartup4 {
+    [self measureXMLStartupWithDevices:4];
+}
+
+- (void)testPerformanceBinaryStartup4 {
+    [self measureBinaryStartupWithDevices:4];
+}
+
+- (void)testPerformanceXMLStartup64 {
+    [self measureXMLStartupWithDevices:64];
+}
+
+- (void)testPerformanceBinaryStartup64 {
+    [self measureBinaryStartupWithDevices:64];
+}
+
+- (void)testPerformanceXMLStartup256 {
+    [self measureXMLStartupWithDevices:256];
+}
+
+- (void)testPerformanceBinaryStartup256 {
+    [self measureBinaryStartupWithDevices:256];
+}
+
+@end
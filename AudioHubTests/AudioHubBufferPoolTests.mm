@@ -0,0 +1,242 @@
+//
+//  AudioHubBufferPoolTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CABufferPool.h"
+#include "CAAudioBufferList.h"
+#include "CABufferList.h"
+#include "CAHostTimeBase.h"
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+//  allocates and frees inNumberBlocks blocks of a few sizes in a pattern that keeps some of them around
+static void Churn(UInt32 inNumberBlocks) {
+    std::vector<void *> held;
+    for (UInt32 i = 0; i < inNumberBlocks; ++i) {
+        held.push_back(CABufferPool::Allocate((size_t)64 << (i % 10)));
+        if (held.size() > 12) {
+            size_t victim = (i * 7) % held.size();
+            CABufferPool::Deallocate(held[victim]);
+            held.erase(held.begin() + victim);
+        }
+    }
+    for (size_t i = 0; i < held.size(); ++i) {
+        CABufferPool::Deallocate(held[i]);
+    }
+}
+
+static bool IsAligned(const void *inPointer) {
+    return ((uintptr_t)inPointer % CABufferPool::kAlignment) == 0;
+}
+
+@interface AudioHubBufferPoolTests : XCTestCase
+
+@end
+
+@implementation AudioHubBufferPoolTests
+
+- (void)setUp {
+    [super setUp];
+    CABufferPool::Trim();
+}
+
+- (void)tearDown {
+    XCTAssertEqual(CABufferPool::ReportLeaks(), 0);
+    [super tearDown];
+}
+
+- (void)testBlocksAreAligned {
+    const size_t sizes[] = { 1, 63, 64, 65, 100, 4096, 4097, CABufferPool::kMaximumBlockSize, CABufferPool::kMaximumBlockSize + 1, 3 * CABufferPool::kMaximumBlockSize };
+    std::vector<void *> blocks;
+    for (UInt32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        void *block = CABufferPool::Allocate(sizes[i]);
+        XCTAssert(block != NULL);
+        XCTAssert(IsAligned(block), @"%zu bytes", sizes[i]);
+        XCTAssertGreaterThanOrEqual(CABufferPool::GetBlockSize(block), sizes[i]);
+        memset(block, 0xAB, sizes[i]);
+        blocks.push_back(block);
+    }
+    XCTAssertEqual(CABufferPool::ReportLeaks(), blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        CABufferPool::Deallocate(blocks[i]);
+    }
+
+    XCTAssertEqual(CABufferPool::GetSizeClass(64), 0);
+    XCTAssertEqual(CABufferPool::GetSizeClass(65), 1);
+    XCTAssertEqual(CABufferPool::GetSizeClass(CABufferPool::kMaximumBlockSize), CABufferPool::kNumberSizeClasses - 1);
+    XCTAssertEqual(CABufferPool::GetSizeClass(CABufferPool::kMaximumBlockSize + 1), CABufferPool::kNumberSizeClasses);
+}
+
+- (void)testFreedBlocksAreReused {
+    CABufferPool::Statistics before, after;
+    void *block = CABufferPool::Allocate(1000);
+    CABufferPool::Deallocate(block);
+    CABufferPool::GetStatistics(before);
+    for (UInt32 i = 0; i < 1000; ++i) {
+        void *again = CABufferPool::Allocate(900 + i % 100);
+        XCTAssertEqual(again, block);
+        CABufferPool::Deallocate(again);
+    }
+    CABufferPool::GetStatistics(after);
+    XCTAssertEqual(after.mNumberHeapAllocations, before.mNumberHeapAllocations);
+    XCTAssertEqual(after.mNumberAllocations, before.mNumberAllocations + 1000);
+
+    //  a block that is freed twice is only given back once
+    CABufferPool::Deallocate(block);
+    XCTAssertEqual(CABufferPool::GetNumberBlocksInUse(1000), 0);
+}
+
+- (void)testRealTimeThreadOnlyReuses {
+    bool didPass = true;
+    std::thread thread([&didPass] {
+        didPass &= CABufferPool::Reserve(8192, 4);
+        CABufferPool::SetIsRealTimeThread(true);
+        didPass &= !CABufferPool::Reserve(8192, 8);
+
+        CABufferPool::Statistics before, after;
+        CABufferPool::GetStatistics(before);
+        void *blocks[4];
+        for (UInt32 i = 0; i < 4; ++i) {
+            blocks[i] = CABufferPool::Allocate(8000);
+            didPass &= blocks[i] != NULL;
+        }
+        didPass &= CABufferPool::Allocate(8000) == NULL;
+        didPass &= CABufferPool::Allocate(2 * CABufferPool::kMaximumBlockSize) == NULL;
+        for (UInt32 i = 0; i < 4; ++i) {
+            CABufferPool::Deallocate(blocks[i]);
+        }
+        for (UInt32 i = 0; i < 1000; ++i) {
+            void *block = CABufferPool::Allocate(8192);
+            didPass &= block != NULL;
+            CABufferPool::Deallocate(block);
+        }
+        CABufferPool::GetStatistics(after);
+        didPass &= after.mNumberHeapAllocations == before.mNumberHeapAllocations;
+        didPass &= after.mNumberFailedAllocations == before.mNumberFailedAllocations + 2;
+        CABufferPool::SetIsRealTimeThread(false);
+    });
+    thread.join();
+    XCTAssert(didPass);
+}
+
+- (void)testLargeBlocksFreedInRealTimeWait {
+    void *block = CABufferPool::Allocate(4 * CABufferPool::kMaximumBlockSize);
+    std::thread thread([block] {
+        CABufferPool::SetIsRealTimeThread(true);
+        CABufferPool::Deallocate(block);
+    });
+    thread.join();
+
+    CABufferPool::Statistics statistics;
+    CABufferPool::GetStatistics(statistics);
+    XCTAssertEqual(statistics.mBytesInUse, 0);
+    XCTAssertGreaterThanOrEqual(statistics.mBytesReserved, 4 * CABufferPool::kMaximumBlockSize);
+    CABufferPool::Trim();
+    CABufferPool::GetStatistics(statistics);
+    XCTAssertEqual(statistics.mBytesReserved, 0);
+}
+
+- (void)testThreadsGiveTheirCachesBack {
+    std::vector<std::thread> threads;
+    for (UInt32 i = 0; i < 8; ++i) {
+        threads.push_back(std::thread(Churn, 100000));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    CABufferPool::Statistics statistics;
+    CABufferPool::GetStatistics(statistics);
+    XCTAssertEqual(statistics.mNumberBlocksInUse, 0);
+    XCTAssertGreaterThan(statistics.mBytesReserved, 0);
+
+    //  everything the threads cached is shared again, so Trim() can give all of it back
+    CABufferPool::Trim();
+    CABufferPool::GetStatistics(statistics);
+    XCTAssertEqual(statistics.mBytesReserved, 0);
+}
+
+- (void)testLeakReport {
+    void *leaked[3] = { CABufferPool::Allocate(100), CABufferPool::Allocate(100), CABufferPool::Allocate(5000) };
+    XCTAssertEqual(CABufferPool::ReportLeaks(), 3);
+    XCTAssertEqual(CABufferPool::GetNumberBlocksInUse(128), 2);
+    XCTAssertGreaterThanOrEqual(CABufferPool::GetPeakNumberBlocksInUse(128), 2);
+
+    CABufferPool::Statistics statistics;
+    CABufferPool::GetStatistics(statistics);
+    XCTAssertEqual(statistics.mNumberBlocksInUse, 3);
+    XCTAssertEqual(statistics.mBytesInUse, 2 * 128 + 8192);
+    CABufferPool::DumpStatistics();
+
+    for (UInt32 i = 0; i < 3; ++i) {
+        CABufferPool::Deallocate(leaked[i]);
+    }
+}
+
+- (void)testBufferListsUseThePool {
+    AudioBufferList *bufferList = CAAudioBufferList::Create(3);
+    XCTAssert(IsAligned(bufferList));
+    XCTAssertEqual(bufferList->mNumberBuffers, 3);
+    XCTAssert(bufferList->mBuffers[2].mData == NULL);
+    XCTAssertEqual(CABufferPool::ReportLeaks(), 1);
+    CAAudioBufferList::Destroy(bufferList);
+
+    CABufferList *buffers = CABufferList::New(4, 1);
+    buffers->AllocateBuffers(1000);
+    XCTAssertEqual(buffers->GetCapacityBytes(), 1088);
+    for (UInt32 i = 0; i < 4; ++i) {
+        XCTAssert(IsAligned(buffers->GetBufferList().mBuffers[i].mData));
+    }
+    buffers->AllocateBuffers(5000);
+    XCTAssertEqual(CABufferPool::ReportLeaks(), 1);
+    delete buffers;
+}
+
+#pragma mark Performance
+
+enum { kNumberPairs = 1000000 };
+
+static double MeasureNanosPerPair(size_t inSize, bool inUsePool) {
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberPairs; ++i) {
+        void *block = inUsePool ? CABufferPool::Allocate(inSize) : malloc(inSize);
+        *(volatile char *)block = 0;
+        if (inUsePool) {
+            CABufferPool::Deallocate(block);
+        } else {
+            free(block);
+        }
+    }
+    return (double)CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) / kNumberPairs;
+}
+
+- (void)testPerformanceAgainstMalloc {
+    [self measureBlock:^{
+        const size_t sizes[] = { 256, 4096, 65536 };
+        for (UInt32 i = 0; i < 3; ++i) {
+            NSLog(@"%6zu bytes  malloc %6.1f ns  pool %6.1f ns per allocation", sizes[i], MeasureNanosPerPair(sizes[i], false), MeasureNanosPerPair(sizes[i], true));
+        }
+    }];
+}
+
+- (void)testPerformanceOfThreads {
+    [self measureBlock:^{
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        std::vector<std::thread> threads;
+        for (UInt32 i = 0; i < 4; ++i) {
+            threads.push_back(std::thread(Churn, kNumberPairs / 4));
+        }
+        for (size_t i = 0; i < threads.size(); ++i) {
+            threads[i].join();
+        }
+        NSLog(@"4 threads  %6.1f ns per allocation", (double)CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) / kNumberPairs);
+    }];
+}
+
+@end
@@ -0,0 +1,198 @@
+//
+//  AudioHubChannelRemixerTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAChannelRemixer.h"
+#include "CAAudioChannelLayout.h"
+#include "CAHostTimeBase.h"
+#include "CAVectorKernels.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+static AudioChannelLayout LayoutWithTag(AudioChannelLayoutTag inTag) {
+    AudioChannelLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.mChannelLayoutTag = inTag;
+    return layout;
+}
+
+//  one frame at a time, every destination channel as the dot product of its row with the source frame
+static void RemixOneFrameAtATime(const CAChannelRemixer &inRemixer, const Float32 *inSource, Float32 *outDestination, UInt32 inNumberFrames) {
+    UInt32 numberSourceChannels = inRemixer.GetNumberSourceChannels();
+    UInt32 numberDestinationChannels = inRemixer.GetNumberDestinationChannels();
+    for (UInt32 frame = 0; frame < inNumberFrames; ++frame) {
+        for (UInt32 destination = 0; destination < numberDestinationChannels; ++destination) {
+            Float32 sum = 0.0f;
+            for (UInt32 source = 0; source < numberSourceChannels; ++source) {
+                sum += inRemixer.GetCoefficient(destination, source) * inSource[frame * numberSourceChannels + source];
+            }
+            outDestination[frame * numberDestinationChannels + destination] = sum;
+        }
+    }
+}
+
+static const Float32 kMinus3dB = 0.70710678f;
+
+@interface AudioHubChannelRemixerTests : XCTestCase
+
+@end
+
+@implementation AudioHubChannelRemixerTests
+
+- (void)tearDown {
+    CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+    [super tearDown];
+}
+
+- (void)testChannelLabels {
+    AudioChannelLabel labels[8];
+    CAAudioChannelLayout::GetChannelLabels(LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_D), labels);
+    const AudioChannelLabel expected[] = { kAudioChannelLabel_Center, kAudioChannelLabel_Left, kAudioChannelLabel_Right, kAudioChannelLabel_LeftSurround, kAudioChannelLabel_RightSurround, kAudioChannelLabel_LFEScreen };
+    XCTAssertEqual(memcmp(labels, expected, sizeof(expected)), 0);
+
+    AudioChannelLayout bitmap = LayoutWithTag(kAudioChannelLayoutTag_UseChannelBitmap);
+    bitmap.mChannelBitmap = kAudioChannelBit_Left | kAudioChannelBit_Right | kAudioChannelBit_LFEScreen;
+    CAAudioChannelLayout::GetChannelLabels(bitmap, labels);
+    XCTAssertEqual(labels[0], kAudioChannelLabel_Left);
+    XCTAssertEqual(labels[1], kAudioChannelLabel_Right);
+    XCTAssertEqual(labels[2], kAudioChannelLabel_LFEScreen);
+
+    CAAudioChannelLayout::GetChannelLabels(LayoutWithTag(kAudioChannelLayoutTag_DiscreteInOrder | 3), labels);
+    XCTAssertEqual(labels[2], kAudioChannelLabel_Discrete_2);
+}
+
+- (void)testFoldDowns {
+    CAChannelRemixer surroundToStereo(LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_A), LayoutWithTag(kAudioChannelLayoutTag_Stereo));
+    XCTAssertEqual(surroundToStereo.GetNumberSourceChannels(), 6);
+    XCTAssertEqual(surroundToStereo.GetNumberDestinationChannels(), 2);
+    XCTAssertEqual(surroundToStereo.GetCoefficient(0, 0), 1.0f);
+    XCTAssertEqual(surroundToStereo.GetCoefficient(0, 1), 0.0f);
+    XCTAssertEqualWithAccuracy(surroundToStereo.GetCoefficient(0, 2), kMinus3dB, 1e-6);
+    XCTAssertEqual(surroundToStereo.GetCoefficient(0, 3), 0.0f, @"the LFE is dropped");
+    XCTAssertEqualWithAccuracy(surroundToStereo.GetCoefficient(0, 4), kMinus3dB, 1e-6);
+    XCTAssertEqual(surroundToStereo.GetCoefficient(0, 5), 0.0f);
+    XCTAssertEqualWithAccuracy(surroundToStereo.GetCoefficient(1, 5), kMinus3dB, 1e-6);
+
+    //  the rear surrounds of 7.1 go to the surrounds of 5.1 and on from there to the front pair
+    CAChannelRemixer sevenToFive(LayoutWithTag(kAudioChannelLayoutTag_MPEG_7_1_C), LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_A));
+    XCTAssertEqualWithAccuracy(sevenToFive.GetCoefficient(4, 6), kMinus3dB, 1e-6);
+    XCTAssertEqual(sevenToFive.GetCoefficient(0, 6), 0.0f);
+    CAChannelRemixer sevenToStereo(LayoutWithTag(kAudioChannelLayoutTag_MPEG_7_1_C), LayoutWithTag(kAudioChannelLayoutTag_Stereo));
+    XCTAssertEqualWithAccuracy(sevenToStereo.GetCoefficient(0, 6), kMinus3dB, 1e-6);
+
+    CAChannelRemixer surroundToMono(LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_A), LayoutWithTag(kAudioChannelLayoutTag_Mono));
+    XCTAssertEqualWithAccuracy(surroundToMono.GetCoefficient(0, 0), kMinus3dB, 1e-6);
+    XCTAssertEqual(surroundToMono.GetCoefficient(0, 2), 1.0f);
+    XCTAssertEqualWithAccuracy(surroundToMono.GetCoefficient(0, 4), 0.5f, 1e-6);
+
+    CAChannelRemixer stereoToMono(LayoutWithTag(kAudioChannelLayoutTag_Stereo), LayoutWithTag(kAudioChannelLayoutTag_Mono));
+    XCTAssertEqualWithAccuracy(stereoToMono.GetCoefficient(0, 0), kMinus3dB, 1e-6);
+    XCTAssertEqualWithAccuracy(stereoToMono.GetCoefficient(0, 1), kMinus3dB, 1e-6);
+}
+
+- (void)testUpMixesAndDiscreteChannels {
+    CAChannelRemixer monoToStereo(LayoutWithTag(kAudioChannelLayoutTag_Mono), LayoutWithTag(kAudioChannelLayoutTag_Stereo));
+    XCTAssertEqualWithAccuracy(monoToStereo.GetCoefficient(0, 0), kMinus3dB, 1e-6);
+    XCTAssertEqualWithAccuracy(monoToStereo.GetCoefficient(1, 0), kMinus3dB, 1e-6);
+
+    //  an up-mix keeps the channels where they are and invents nothing
+    CAChannelRemixer stereoToSurround(LayoutWithTag(kAudioChannelLayoutTag_Stereo), LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_A));
+    CAChannelRemixer monoToSurround(LayoutWithTag(kAudioChannelLayoutTag_Mono), LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_A));
+    for (UInt32 destination = 0; destination < 6; ++destination) {
+        XCTAssertEqual(stereoToSurround.GetCoefficient(destination, 0), (destination == 0) ? 1.0f : 0.0f);
+        XCTAssertEqual(stereoToSurround.GetCoefficient(destination, 1), (destination == 1) ? 1.0f : 0.0f);
+        XCTAssertEqual(monoToSurround.GetCoefficient(destination, 0), (destination == 2) ? 1.0f : 0.0f);
+    }
+
+    CAChannelRemixer discrete(LayoutWithTag(kAudioChannelLayoutTag_DiscreteInOrder | 4), LayoutWithTag(kAudioChannelLayoutTag_Unknown | 2));
+    XCTAssertEqual(discrete.GetCoefficient(0, 0), 1.0f);
+    XCTAssertEqual(discrete.GetCoefficient(1, 1), 1.0f);
+    XCTAssertEqual(discrete.GetCoefficient(1, 2), 0.0f);
+
+    CAChannelRemixer reordered(LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_A), LayoutWithTag(kAudioChannelLayoutTag_MPEG_5_1_D));
+    XCTAssertFalse(reordered.IsIdentity());
+    XCTAssertEqual(reordered.GetCoefficient(0, 2), 1.0f);
+    XCTAssertEqual(reordered.GetCoefficient(5, 3), 1.0f);
+    CAChannelRemixer same(LayoutWithTag(kAudioChannelLayoutTag_Stereo), LayoutWithTag(kAudioChannelLayoutTag_StereoHeadphones));
+    XCTAssertTrue(same.IsIdentity());
+}
+
+- (void)testMatricesAreShared {
+    CAChannelRemixer first(LayoutWithTag(kAudioChannelLayoutTag_MPEG_6_1_A), LayoutWithTag(kAudioChannelLayoutTag_Quadraphonic));
+    UInt32 numberCachedMatrices = CAChannelRemixer::GetNumberCachedMatrices();
+    CAChannelRemixer second(LayoutWithTag(kAudioChannelLayoutTag_MPEG_6_1_A), LayoutWithTag(kAudioChannelLayoutTag_Quadraphonic));
+    XCTAssertEqual(CAChannelRemixer::GetNumberCachedMatrices(), numberCachedMatrices);
+}
+
+//  every pair of layouts and a few frame counts around the block size, with the best tier and without vectors
+- (void)testProcessMatchesOneFrameAtATime {
+    const AudioChannelLayoutTag tags[] = { kAudioChannelLayoutTag_Mono, kAudioChannelLayoutTag_Stereo, kAudioChannelLayoutTag_MPEG_5_1_A, kAudioChannelLayoutTag_MPEG_7_1_C,
+                                           kAudioChannelLayoutTag_MPEG_7_1_A, kAudioChannelLayoutTag_DiscreteInOrder | 3 };
+    const UInt32 frameCounts[] = { 0, 1, 7, CAChannelRemixer::kBlockSize, CAChannelRemixer::kBlockSize + 1, 1000 };
+    const UInt32 masks[] = { 0xFFFFFFFF, 0 };
+    for (UInt32 mask : masks) {
+        CAVectorUnit::SetFeatureMask(mask);
+        for (AudioChannelLayoutTag sourceTag : tags) {
+            for (AudioChannelLayoutTag destinationTag : tags) {
+                CAChannelRemixer remixer(LayoutWithTag(sourceTag), LayoutWithTag(destinationTag));
+                for (UInt32 numberFrames : frameCounts) {
+                    std::vector<Float32> source(numberFrames * remixer.GetNumberSourceChannels());
+                    for (size_t i = 0; i < source.size(); ++i) {
+                        source[i] = sinf((Float32)i * 0.37f);
+                    }
+                    //  one sample more than needed, to catch writes past the end
+                    std::vector<Float32> destination(numberFrames * remixer.GetNumberDestinationChannels() + 1, 9.0f);
+                    std::vector<Float32> expected(destination.size(), 9.0f);
+                    remixer.Process(source.data(), destination.data(), numberFrames);
+                    RemixOneFrameAtATime(remixer, source.data(), expected.data(), numberFrames);
+                    for (size_t i = 0; i < destination.size(); ++i) {
+                        XCTAssertEqualWithAccuracy(destination[i], expected[i], 1e-5, @"%x to %x, %u frames", sourceTag, destinationTag, numberFrames);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#pragma mark Performance
+
+enum { kNumberFrames = 512, kNumberRuns = 5000 };
+
+static double MeasureNanosPerFrame(void (^inBlock)(void)) {
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 run = 0; run < kNumberRuns; ++run) {
+        inBlock();
+    }
+    return (double)CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) / ((double)kNumberRuns * kNumberFrames);
+}
+
+//  logs ns per frame of the remixer and of a plain matrix multiply for the common down- and up-mixes
+- (void)testPerformanceAgainstOneFrameAtATime {
+    const AudioChannelLayoutTag pairs[][2] = {
+        { kAudioChannelLayoutTag_MPEG_7_1_C, kAudioChannelLayoutTag_Stereo },
+        { kAudioChannelLayoutTag_MPEG_5_1_A, kAudioChannelLayoutTag_Stereo },
+        { kAudioChannelLayoutTag_MPEG_5_1_A, kAudioChannelLayoutTag_Mono },
+        { kAudioChannelLayoutTag_Stereo, kAudioChannelLayoutTag_MPEG_5_1_A },
+    };
+    [self measureBlock:^{
+        for (UInt32 i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i) {
+            CAChannelRemixer remixer(LayoutWithTag(pairs[i][0]), LayoutWithTag(pairs[i][1]));
+            std::vector<Float32> source(kNumberFrames * remixer.GetNumberSourceChannels(), 0.25f);
+            std::vector<Float32> destination(kNumberFrames * remixer.GetNumberDestinationChannels());
+            CAChannelRemixer *remixerPointer = &remixer;
+            const Float32 *sourcePointer = source.data();
+            Float32 *destinationPointer = destination.data();
+            NSLog(@"%u to %u channels  %6.3f ns per frame, one frame at a time %6.3f", remixer.GetNumberSourceChannels(), remixer.GetNumberDestinationChannels(),
+                  MeasureNanosPerFrame(^{ remixerPointer->Process(sourcePointer, destinationPointer, kNumberFrames); }),
+                  MeasureNanosPerFrame(^{ RemixOneFrameAtATime(*remixerPointer, sourcePointer, destinationPointer, kNumberFrames); }));
+        }
+    }];
+}
+
+@end
@@ -9,7 +9,10 @@
 #import <XCTest/XCTest.h>
 #include "CAHALAudioObjectTester.h"
 #include "Device.h"
+#include "DeviceList.h"
 #include "CAPropertyAddress.h"
+#include <malloc/malloc.h>
+#include <vector>
 
 @interface AudioHubDeviceTests : XCTestCase
 @property CAObject *object;
@@ -50,6 +53,115 @@
     CFRelease(outData);
 }
 
+- (void)testLazyMaterialization {
+    Device *device = static_cast<Device *>(_object);
+    XCTAssertFalse(device->IsMaterialized());
+
+    CAHALAudioObjectTester tester(_object);
+    CFStringRef name = tester.GetPropertyData_CFString(CAPropertyAddress(kAudioObjectPropertyName));
+    CFRelease(name);
+    XCTAssertEqual(tester.GetPropertyData_UInt32(CAPropertyAddress(kAudioObjectPropertyClass)), kAudioDeviceClassID);
+    XCTAssertFalse(device->IsMaterialized());
+
+    UInt32 numberMaterializedDevices = Device::GetNumberMaterializedDevices();
+    tester.GetPropertyData_Float64(CAPropertyAddress(kAudioDevicePropertyNominalSampleRate));
+    XCTAssert(device->IsMaterialized());
+    XCTAssertEqual(Device::GetNumberMaterializedDevices(), numberMaterializedDevices + 1);
+}
+
+- (void)testStartIOMaterializes {
+    Device *device = static_cast<Device *>(_object);
+    XCTAssertFalse(device->IsMaterialized());
+    device->StartIO();
+    XCTAssert(device->IsMaterialized());
+    device->StopIO();
+}
+
+//  reads what the HAL reads for every device the plug-in publishes
+static void ScanLikeThePublishingHAL(CAObject *object) {
+    CAHALAudioObjectTester tester(object);
+    const AudioObjectPropertySelector valueSelectors[] = {
+        kAudioObjectPropertyBaseClass, kAudioObjectPropertyClass, kAudioObjectPropertyOwner, kAudioDevicePropertyTransportType,
+        kAudioDevicePropertyClockDomain, kAudioDevicePropertyDeviceIsAlive, kAudioDevicePropertyIsHidden,
+    };
+    for (AudioObjectPropertySelector selector : valueSelectors) {
+        tester.GetPropertyData_UInt32(CAPropertyAddress(selector));
+    }
+    const AudioObjectPropertySelector stringSelectors[] = {
+        kAudioObjectPropertyName, kAudioObjectPropertyManufacturer, kAudioDevicePropertyDeviceUID, kAudioDevicePropertyModelUID,
+    };
+    for (AudioObjectPropertySelector selector : stringSelectors) {
+        CFStringRef string = tester.GetPropertyData_CFString(CAPropertyAddress(selector));
+        if (string != NULL) {
+            CFRelease(string);
+        }
+    }
+    const AudioObjectPropertySelector listSelectors[] = {
+        kAudioObjectPropertyOwnedObjects, kAudioDevicePropertyRelatedDevices, kAudioDevicePropertyStreams,
+        kAudioObjectPropertyControlList, kAudioObjectPropertyCustomPropertyInfoList,
+    };
+    for (AudioObjectPropertySelector selector : listSelectors) {
+        CAPropertyAddress address(selector);
+        if (tester.HasProperty(address)) {
+            UInt32 dataSize = tester.GetPropertyDataSize(address, 0, NULL);
+            std::vector<UInt8> data(dataSize);
+            tester.GetPropertyData(address, 0, NULL, dataSize, data.data());
+        }
+    }
+}
+
+- (void)testPublishScanDoesNotMaterialize {
+    Device *device = static_cast<Device *>(_object);
+    UInt32 numberMaterializedDevices = Device::GetNumberMaterializedDevices();
+    ScanLikeThePublishingHAL(_object);
+    XCTAssertFalse(device->IsMaterialized());
+    XCTAssertEqual(Device::GetNumberMaterializedDevices(), numberMaterializedDevices);
+}
+
+static size_t BytesInUse() {
+    malloc_statistics_t statistics;
+    malloc_zone_statistics(NULL, &statistics);
+    return statistics.size_in_use;
+}
+
+- (void)testMemoryFootprint {
+    const UInt32 numberDevices = 256;
+    DeviceList *deviceList = new DeviceList();
+
+    size_t bytesBefore = BytesInUse();
+    for (UInt32 i = 0; i < numberDevices; ++i) {
+        deviceList->AddDevice(CFSTR("uid"), CFSTR("name"), 2);
+    }
+    UInt32 numberMaterializedDevices = Device::GetNumberMaterializedDevices();
+    for (UInt32 i = 0; i < numberDevices; ++i) {
+        CAObjectReleaser<Device> device(CAObjectMap::CopyObjectOfClassByObjectID<Device>(deviceList->GetDeviceObjectID(i)));
+        ScanLikeThePublishingHAL(device);
+    }
+    XCTAssertEqual(Device::GetNumberMaterializedDevices(), numberMaterializedDevices);
+    size_t bytesLazy = BytesInUse() - bytesBefore;
+
+    for (UInt32 i = 0; i < numberDevices; ++i) {
+        CAObjectReleaser<Device> device(CAObjectMap::CopyObjectOfClassByObjectID<Device>(deviceList->GetDeviceObjectID(i)));
+        device->Materialize();
+    }
+    size_t bytesMaterialized = BytesInUse() - bytesBefore;
+
+    NSLog(@"%u devices: %zu bytes lazy, %zu bytes materialized", numberDevices, bytesLazy, bytesMaterialized);
+    XCTAssertLessThan(bytesLazy, bytesMaterialized);
+
+    deviceList->RemoveAllDevices();
+    delete deviceList;
+}
+
+- (void)testPerformanceStartup256 {
+    [self measureBlock:^{
+        DeviceList deviceList;
+        for (UInt32 i = 0; i < 256; ++i) {
+            deviceList.AddDevice(CFSTR("uid"), CFSTR("name"), 2);
+        }
+        deviceList.RemoveAllDevices();
+    }];
+}
 
 - (void)testPerformanceExample {
     // This is an example of a performance test case.
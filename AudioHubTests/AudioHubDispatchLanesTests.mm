@@ -0,0 +1,156 @@
+//
+//  AudioHubDispatchLanesTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "DispatchLanes.h"
+#include "CADispatchQueue.h"
+#include "CAHostTimeBase.h"
+#include <algorithm>
+#include <vector>
+
+@interface AudioHubDispatchLanesTests : XCTestCase
+
+@end
+
+@implementation AudioHubDispatchLanesTests
+
+//  holds the queue in a reclamation task until the returned semaphore is signaled
+static dispatch_semaphore_t CloseGate(DispatchLanes& inLanes) {
+    dispatch_semaphore_t started = dispatch_semaphore_create(0);
+    dispatch_semaphore_t gate = dispatch_semaphore_create(0);
+    inLanes.Dispatch(DispatchLanes::kLaneReclamation, false, ^{
+        dispatch_semaphore_signal(started);
+        dispatch_semaphore_wait(gate, DISPATCH_TIME_FOREVER);
+    });
+    dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+    return gate;
+}
+
+- (void)testLanesDrainInPriorityOrder {
+    CADispatchQueue queue("AudioHubDispatchLanesTests");
+    DispatchLanes lanes(queue);
+    std::vector<UInt32> order;
+    std::vector<UInt32> *orderPointer = &order;
+
+    dispatch_semaphore_t gate = CloseGate(lanes);
+    //  lowest priority first, three tasks per lane
+    for (SInt32 lane = DispatchLanes::kNumberLanes - 1; lane >= 0; --lane) {
+        for (UInt32 task = 0; task < 3; ++task) {
+            UInt32 value = lane * 10 + task;
+            lanes.Dispatch((DispatchLanes::Lane)lane, false, ^{
+                orderPointer->push_back(value);
+            });
+        }
+    }
+    dispatch_semaphore_signal(gate);
+    lanes.Dispatch(DispatchLanes::kLaneReclamation, true, ^{
+    });
+
+    const UInt32 expected[] = { 0, 1, 2, 10, 11, 12, 20, 21, 22, 30, 31, 32 };
+    XCTAssertEqual(order.size(), 12);
+    for (UInt32 index = 0; index < 12; ++index) {
+        XCTAssertEqual(order[index], expected[index]);
+    }
+}
+
+- (void)testStatistics {
+    CADispatchQueue queue("AudioHubDispatchLanesTests");
+    DispatchLanes lanes(queue);
+
+    dispatch_semaphore_t gate = CloseGate(lanes);
+    for (UInt32 task = 0; task < 3; ++task) {
+        lanes.Dispatch(DispatchLanes::kLanePersistence, false, ^{
+        });
+    }
+    XCTAssertEqual(lanes.GetDepth(DispatchLanes::kLanePersistence), 3);
+    XCTAssertEqual(lanes.GetDepth(DispatchLanes::kLaneConfiguration), 0);
+    usleep(10 * 1000);
+    dispatch_semaphore_signal(gate);
+    lanes.Dispatch(DispatchLanes::kLaneReclamation, true, ^{
+    });
+
+    DispatchLanes::Statistics statistics;
+    lanes.GetStatistics(DispatchLanes::kLanePersistence, statistics);
+    XCTAssertEqual(statistics.mDepth, 0);
+    XCTAssertEqual(statistics.mMaximumDepth, 3);
+    XCTAssertEqual(statistics.mNumberExecutedTasks, 3);
+    XCTAssertGreaterThanOrEqual(statistics.mMaximumWaitNanos, 10 * 1000 * 1000);
+    XCTAssertGreaterThanOrEqual(statistics.mTotalWaitNanos, 3 * statistics.mMaximumWaitNanos / 2);
+
+    lanes.ResetStatistics();
+    lanes.GetStatistics(DispatchLanes::kLanePersistence, statistics);
+    XCTAssertEqual(statistics.mMaximumDepth, 0);
+    XCTAssertEqual(statistics.mNumberExecutedTasks, 0);
+    XCTAssertEqual(statistics.mMaximumWaitNanos, 0);
+    lanes.Dump();
+}
+
+- (void)testDelayedTasksJoinTheirLane {
+    CADispatchQueue queue("AudioHubDispatchLanesTests");
+    DispatchLanes lanes(queue);
+    __block UInt64 ranAt = 0;
+    UInt64 start = CAHostTimeBase::GetCurrentTimeInNanos();
+    lanes.Dispatch(DispatchLanes::kLanePersistence, (UInt64)20 * 1000 * 1000, ^{
+        ranAt = CAHostTimeBase::GetCurrentTimeInNanos();
+    });
+    XCTAssertEqual(lanes.GetDepth(DispatchLanes::kLanePersistence), 0);
+    usleep(40 * 1000);
+    lanes.Dispatch(DispatchLanes::kLaneReclamation, true, ^{
+    });
+    XCTAssertGreaterThanOrEqual(ranAt - start, 20 * 1000 * 1000);
+
+    DispatchLanes::Statistics statistics;
+    lanes.GetStatistics(DispatchLanes::kLanePersistence, statistics);
+    XCTAssertEqual(statistics.mNumberExecutedTasks, 1);
+}
+
+- (void)testConfigurationLatencyStaysBounded {
+    CADispatchQueue queue("AudioHubDispatchLanesTests");
+    DispatchLanes lanes(queue);
+    DispatchLanes *lanesPointer = &lanes;
+
+    //  about a second of reclamation work, 100us at a time
+    const UInt32 numberFloodTasks = 10000;
+    for (UInt32 task = 0; task < numberFloodTasks; ++task) {
+        lanes.Dispatch(DispatchLanes::kLaneReclamation, false, ^{
+            usleep(100);
+        });
+    }
+
+    const UInt32 numberChanges = 20;
+    std::vector<UInt64> latencies(numberChanges);
+    std::vector<UInt32> backlog(numberChanges);
+    UInt64 *latency = &latencies[0];
+    UInt32 *depth = &backlog[0];
+    for (UInt32 change = 0; change < numberChanges; ++change) {
+        UInt64 dispatched = CAHostTimeBase::GetCurrentTimeInNanos();
+        lanes.Dispatch(DispatchLanes::kLaneConfiguration, false, ^{
+            latency[change] = CAHostTimeBase::GetCurrentTimeInNanos() - dispatched;
+            depth[change] = lanesPointer->GetDepth(DispatchLanes::kLaneReclamation);
+        });
+        usleep(10 * 1000);
+    }
+    lanes.Dispatch(DispatchLanes::kLaneConfiguration, true, ^{
+    });
+
+    DispatchLanes::Statistics configuration, reclamation;
+    lanes.GetStatistics(DispatchLanes::kLaneConfiguration, configuration);
+    lanes.GetStatistics(DispatchLanes::kLaneReclamation, reclamation);
+    NSLog(@"configuration latency under a flood: max %llu us (%llu us measured), reclamation backlog %u, waiting up to %llu ms",
+          configuration.mMaximumWaitNanos / 1000, *std::max_element(latencies.begin(), latencies.end()) / 1000, reclamation.mDepth, reclamation.mMaximumWaitNanos / 1000000);
+
+    for (UInt32 change = 0; change < numberChanges; ++change) {
+        //  the flood was still queued, and the change only waited for the task that was running
+        XCTAssertGreaterThan(backlog[change], 0, @"change %u", change);
+        XCTAssertLessThan(latencies[change], 10 * 1000 * 1000, @"change %u", change);
+    }
+    XCTAssertLessThan(configuration.mMaximumWaitNanos, 10 * 1000 * 1000);
+    XCTAssertEqual(configuration.mNumberExecutedTasks, numberChanges + 1);
+}
+
+@end
@@ -0,0 +1,162 @@
+//
+//  AudioHubFFTTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAFFTBackend.h"
+#include "CASpectralProcessor.h"
+#include "CAHostTimeBase.h"
+#include <math.h>
+#include <vector>
+
+@interface AudioHubFFTTests : XCTestCase
+
+@end
+
+@implementation AudioHubFFTTests
+
+static void FillSignal(std::vector<Float32>& outSignal) {
+    for (size_t i = 0; i < outSignal.size(); ++i) {
+        outSignal[i] = sinf(0.37f * i) + 0.25f * cosf(1.3f * (i % 7)) + 0.1f * ((i * 7919) % 13) / 13.0f;
+    }
+}
+
+//  the reference in the zrip layout: twice the DFT, DC and Nyquist packed into bin 0
+static void ReferenceDFT(const std::vector<Float32>& inSignal, std::vector<double>& outReal, std::vector<double>& outImag) {
+    const size_t n = inSignal.size();
+    outReal.assign(n / 2, 0.0);
+    outImag.assign(n / 2, 0.0);
+    for (size_t k = 0; k < n / 2; ++k) {
+        for (size_t i = 0; i < n; ++i) {
+            double angle = 2.0 * M_PI * (double)((k * i) % n) / (double)n;
+            outReal[k] += 2.0 * inSignal[i] * cos(angle);
+            outImag[k] -= 2.0 * inSignal[i] * sin(angle);
+        }
+    }
+    double nyquist = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        nyquist += (i % 2) ? -inSignal[i] : inSignal[i];
+    }
+    outImag[0] = 2.0 * nyquist;
+}
+
+- (void)checkBackend:(CAFFTBackend::Kind)inKind size:(UInt32)inSize {
+    CAFFTBackend* fft = CAFFTBackend::Create(inSize, inKind);
+    XCTAssert(fft != NULL, @"size %u", inSize);
+    if (fft == NULL) {
+        return;
+    }
+    XCTAssertEqual(fft->GetSize(), inSize);
+
+    std::vector<Float32> signal(inSize), output(inSize), real(inSize / 2), imag(inSize / 2);
+    FillSignal(signal);
+    DSPSplitComplex spectrum = { &real[0], &imag[0] };
+    fft->Forward(&signal[0], spectrum);
+
+    std::vector<double> referenceReal, referenceImag;
+    ReferenceDFT(signal, referenceReal, referenceImag);
+    double peak = 0.0, error = 0.0;
+    for (UInt32 k = 0; k < inSize / 2; ++k) {
+        peak = fmax(peak, fabs(referenceReal[k]));
+        error = fmax(error, fabs(referenceReal[k] - real[k]));
+        error = fmax(error, fabs(referenceImag[k] - imag[k]));
+    }
+    XCTAssertLessThan(error / peak, 1e-5, @"%s size %u", fft->GetName(), inSize);
+
+    fft->Inverse(spectrum, &output[0]);
+    double roundTripError = 0.0;
+    for (UInt32 i = 0; i < inSize; ++i) {
+        roundTripError = fmax(roundTripError, fabs(output[i] / (2.0 * inSize) - signal[i]));
+    }
+    XCTAssertLessThan(roundTripError, 1e-5, @"%s size %u", fft->GetName(), inSize);
+    delete fft;
+}
+
+- (void)testSupportedSizes {
+    XCTAssert(CAFFTBackend::IsSupportedSize(8, CAFFTBackend::kKind_Portable));
+    XCTAssert(CAFFTBackend::IsSupportedSize(480, CAFFTBackend::kKind_Portable));
+    XCTAssert(CAFFTBackend::IsSupportedSize(1000, CAFFTBackend::kKind_Portable));
+    XCTAssertFalse(CAFFTBackend::IsSupportedSize(4, CAFFTBackend::kKind_Portable));
+    XCTAssertFalse(CAFFTBackend::IsSupportedSize(15, CAFFTBackend::kKind_Portable));
+    XCTAssertFalse(CAFFTBackend::IsSupportedSize(2 * 7 * 8, CAFFTBackend::kKind_Portable));
+    XCTAssertFalse(CAFFTBackend::IsSupportedSize(480, CAFFTBackend::kKind_vDSP));
+    XCTAssert(CAFFTBackend::Create(2 * 7 * 8) == NULL);
+}
+
+- (void)testPortableAccuracy {
+    const UInt32 sizes[] = { 8, 12, 16, 20, 24, 30, 60, 256, 480, 1000, 1024, 1920 };
+    for (UInt32 size : sizes) {
+        [self checkBackend:CAFFTBackend::kKind_Portable size:size];
+    }
+}
+
+- (void)testvDSPAccuracy {
+    const UInt32 sizes[] = { 16, 256, 1024 };
+    for (UInt32 size : sizes) {
+        [self checkBackend:CAFFTBackend::kKind_vDSP size:size];
+    }
+}
+
+- (void)testPortableMatchesvDSP {
+    const UInt32 size = 2048;
+    CAFFTBackend* portable = CAFFTBackend::Create(size, CAFFTBackend::kKind_Portable);
+    CAFFTBackend* vdsp = CAFFTBackend::Create(size, CAFFTBackend::kKind_vDSP);
+    std::vector<Float32> signal(size), real1(size / 2), imag1(size / 2), real2(size / 2), imag2(size / 2);
+    FillSignal(signal);
+    DSPSplitComplex spectrum1 = { &real1[0], &imag1[0] };
+    DSPSplitComplex spectrum2 = { &real2[0], &imag2[0] };
+    portable->Forward(&signal[0], spectrum1);
+    vdsp->Forward(&signal[0], spectrum2);
+    for (UInt32 k = 0; k < size / 2; ++k) {
+        XCTAssertEqualWithAccuracy(real1[k], real2[k], 1e-2);
+        XCTAssertEqualWithAccuracy(imag1[k], imag2[k], 1e-2);
+    }
+    delete portable;
+    delete vdsp;
+}
+
+- (void)testSpectralProcessorWithNonPowerOfTwoSize {
+    CASpectralProcessor processor(480, 240, 1, 512);
+    XCTAssertEqual(strcmp(processor.FFT()->GetName(), "Portable"), 0);
+    CASpectralProcessor power(512, 256, 1, 512, CAFFTBackend::kKind_Portable);
+    XCTAssertEqual(strcmp(power.FFT()->GetName(), "Portable"), 0);
+    XCTAssertThrows(CASpectralProcessor(14 * 8, 56, 1, 512));
+}
+
+#pragma mark Performance
+
+//  logs ns per forward transform of each backend for the sizes the driver is likely to use
+- (void)measureBackend:(CAFFTBackend::Kind)inKind {
+    for (UInt32 size = 256; size <= 16384; size *= 2) {
+        CAFFTBackend* fft = CAFFTBackend::Create(size, inKind);
+        std::vector<Float32> signal(size), real(size / 2), imag(size / 2);
+        FillSignal(signal);
+        DSPSplitComplex spectrum = { &real[0], &imag[0] };
+        const UInt32 iterations = (1 << 24) / size;
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < iterations; ++i) {
+            fft->Forward(&signal[0], spectrum);
+        }
+        UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+        NSLog(@"%s FFT %5u: %8.0f ns", fft->GetName(), size, (double)nanos / iterations);
+        delete fft;
+    }
+}
+
+- (void)testPerformancevDSP {
+    [self measureBlock:^{
+        [self measureBackend:CAFFTBackend::kKind_vDSP];
+    }];
+}
+
+- (void)testPerformancePortable {
+    [self measureBlock:^{
+        [self measureBackend:CAFFTBackend::kKind_Portable];
+    }];
+}
+
+@end
@@ -29,6 +29,13 @@
     AudioHub_Create(NULL, kAudioServerPlugInTypeUUID);
 }
 
+- (void)testIOOperationsNeedRunningIO {
+    auto driverRef = static_cast<AudioServerPlugInDriverRef>(AudioHub_Create(NULL, kAudioServerPlugInTypeUUID));
+    AudioServerPlugInIOCycleInfo cycleInfo = {};
+    XCTAssertEqual(driverRef[0]->BeginIOOperation(driverRef, 12345, 0, kAudioServerPlugInIOOperationWriteMix, 512, &cycleInfo), kAudioHardwareNotRunningError);
+    XCTAssertEqual(driverRef[0]->EndIOOperation(driverRef, 12345, 0, kAudioServerPlugInIOOperationWriteMix, 512, &cycleInfo), kAudioHardwareNotRunningError);
+}
+
 #if ULTRASCHALL
 - (void)testInitialize {
     auto driver = AudioHub_Create(NULL, kAudioServerPlugInTypeUUID);    
@@ -0,0 +1,218 @@
+//
+//  AudioHubGuardTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAGuard.h"
+#include "CAHostTimeBase.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+@interface AudioHubGuardTests : XCTestCase
+
+@end
+
+@implementation AudioHubGuardTests
+
+- (void)testWaitForTimesOut {
+    CAGuard guard("AudioHubGuardTests");
+    CAGuard::Locker locker(guard);
+    UInt64 start = CAHostTimeBase::GetCurrentTimeInNanos();
+    XCTAssert(locker.WaitFor(20000000));
+    XCTAssertGreaterThanOrEqual(CAHostTimeBase::GetCurrentTimeInNanos() - start, 20000000);
+    XCTAssert(guard.IsOwnedByCurrentThread());
+    XCTAssert(locker.WaitUntil(CAHostTimeBase::GetCurrentTimeInNanos()));
+}
+
+- (void)testNotifyWakesAWaiter {
+    CAGuard guard("AudioHubGuardTests");
+    CAGuard *guardPointer = &guard;
+    bool isReady = false;
+    bool *isReadyPointer = &isReady;
+    std::atomic<bool> timedOut(false);
+    std::atomic<bool> *timedOutPointer = &timedOut;
+    std::thread waiter([guardPointer, isReadyPointer, timedOutPointer] {
+        CAGuard::Locker locker(*guardPointer);
+        while (!*isReadyPointer) {
+            if (locker.WaitFor(5000000000ULL)) {
+                timedOutPointer->store(true);
+                return;
+            }
+        }
+    });
+    usleep(10000);
+    {
+        CAGuard::Locker locker(guard);
+        isReady = true;
+        locker.Notify();
+    }
+    waiter.join();
+    XCTAssertFalse(timedOut.load());
+}
+
+- (void)testEveryNotificationIsConsumed {
+    //  many more notifications than wakeups, none of the items may be left behind
+    CAGuard guard("AudioHubGuardTests");
+    CAGuard *guardPointer = &guard;
+    UInt32 numberItems = 0, numberConsumed = 0;
+    UInt32 *numberItemsPointer = &numberItems, *numberConsumedPointer = &numberConsumed;
+    bool isDone = false;
+    bool *isDonePointer = &isDone;
+    std::vector<std::thread> consumers;
+    for (UInt32 consumer = 0; consumer < 4; ++consumer) {
+        consumers.push_back(std::thread([guardPointer, numberItemsPointer, numberConsumedPointer, isDonePointer] {
+            CAGuard::Locker locker(*guardPointer);
+            for (;;) {
+                while ((*numberItemsPointer == 0) && !*isDonePointer) {
+                    locker.Wait();
+                }
+                if (*numberItemsPointer == 0) {
+                    return;
+                }
+                --*numberItemsPointer;
+                ++*numberConsumedPointer;
+            }
+        }));
+    }
+    for (UInt32 i = 0; i < 100000; ++i) {
+        CAGuard::Locker locker(guard);
+        ++numberItems;
+        locker.Notify();
+    }
+    {
+        CAGuard::Locker locker(guard);
+        isDone = true;
+        locker.NotifyAll();
+    }
+    for (std::thread& consumer : consumers) {
+        consumer.join();
+    }
+    XCTAssertEqual(numberConsumed, 100000);
+    XCTAssertEqual(numberItems, 0);
+}
+
+- (void)testNotifyAllWakesEveryWaiter {
+    CAGuard guard("AudioHubGuardTests");
+    CAGuard *guardPointer = &guard;
+    bool isReady = false;
+    bool *isReadyPointer = &isReady;
+    std::atomic<UInt32> numberWaiting(0), numberWoken(0);
+    std::atomic<UInt32> *numberWaitingPointer = &numberWaiting, *numberWokenPointer = &numberWoken;
+    std::vector<std::thread> waiters;
+    for (UInt32 waiter = 0; waiter < 8; ++waiter) {
+        waiters.push_back(std::thread([guardPointer, isReadyPointer, numberWaitingPointer, numberWokenPointer] {
+            CAGuard::Locker locker(*guardPointer);
+            numberWaitingPointer->fetch_add(1);
+            while (!*isReadyPointer) {
+                locker.Wait();
+            }
+            numberWokenPointer->fetch_add(1);
+        }));
+    }
+    while (numberWaiting.load() < 8) {
+        usleep(1000);
+    }
+    {
+        CAGuard::Locker locker(guard);
+        isReady = true;
+        locker.NotifyAll();
+    }
+    for (std::thread& waiter : waiters) {
+        waiter.join();
+    }
+    XCTAssertEqual(numberWoken.load(), 8);
+}
+
+#pragma mark Performance
+
+enum { kNumberNotifications = 1000000, kNumberWakeups = 5000 };
+
+//  logs ns per Notify with nobody waiting and with a worker that waits again as soon as it is woken
+- (void)testPerformanceNotify {
+    [self measureBlock:^{
+        CAGuard guard("AudioHubGuardTests");
+        CAGuard *guardPointer = &guard;
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberNotifications; ++i) {
+            guard.Notify();
+        }
+        UInt64 idle = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        std::atomic<bool> isDone(false);
+        std::atomic<bool> *isDonePointer = &isDone;
+        std::atomic<UInt32> numberWakeups(0);
+        std::atomic<UInt32> *numberWakeupsPointer = &numberWakeups;
+        std::thread worker([guardPointer, isDonePointer, numberWakeupsPointer] {
+            CAGuard::Locker locker(*guardPointer);
+            while (!isDonePointer->load()) {
+                locker.Wait();
+                numberWakeupsPointer->fetch_add(1);
+            }
+        });
+        usleep(10000);
+        start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberNotifications; ++i) {
+            guard.Notify();
+        }
+        UInt64 busy = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+        {
+            CAGuard::Locker locker(guard);
+            isDone = true;
+            locker.Notify();
+        }
+        worker.join();
+
+        NSLog(@"guard notify: %5.2f ns without waiters, %5.2f ns with a waiter, %u wakeups for %u notifications", (double)idle / kNumberNotifications,
+              (double)busy / kNumberNotifications, numberWakeups.load(), (UInt32)kNumberNotifications);
+    }];
+}
+
+//  logs the p50/p99 time from Notify to the waiter running
+- (void)testPerformanceWakeLatency {
+    [self measureBlock:^{
+        CAGuard guard("AudioHubGuardTests");
+        CAGuard *guardPointer = &guard;
+        std::atomic<UInt64> sent(0);
+        std::atomic<UInt32> sequence(0), acknowledged(0);
+        std::atomic<UInt64> *sentPointer = &sent;
+        std::atomic<UInt32> *sequencePointer = &sequence, *acknowledgedPointer = &acknowledged;
+        std::vector<UInt64> latencies(kNumberWakeups);
+        UInt64 *latency = &latencies[0];
+        std::thread waiter([guardPointer, sentPointer, sequencePointer, acknowledgedPointer, latency] {
+            CAGuard::Locker locker(*guardPointer);
+            UInt32 last = 0;
+            while (last < kNumberWakeups) {
+                while (sequencePointer->load() == last) {
+                    locker.Wait();
+                }
+                last = sequencePointer->load();
+                latency[last - 1] = CAHostTimeBase::GetTheCurrentTime() - sentPointer->load();
+                acknowledgedPointer->store(last);
+            }
+        });
+        for (UInt32 i = 1; i <= kNumberWakeups; ++i) {
+            usleep(50);
+            {
+                CAGuard::Locker locker(guard);
+                sent = CAHostTimeBase::GetTheCurrentTime();
+                sequence = i;
+                locker.Notify();
+            }
+            while (acknowledged.load() != i) {
+                std::this_thread::yield();
+            }
+        }
+        waiter.join();
+        std::sort(latencies.begin(), latencies.end());
+        NSLog(@"guard wake latency: p50 %6llu ns, p99 %6llu ns", CAHostTimeBase::ConvertToNanos(latencies[kNumberWakeups / 2]),
+              CAHostTimeBase::ConvertToNanos(latencies[kNumberWakeups * 99 / 100]));
+    }];
+}
+
+@end
@@ -0,0 +1,143 @@
+//
+//  AudioHubHostTimeTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAHostTimeBase.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+//  a conversion is accurate when it is within a nanosecond, or a part per trillion, of the exact value
+static bool IsAccurate(UInt64 inNanos, long double inExact) {
+    long double error = (long double)inNanos - inExact;
+    if (error < 0) {
+        error = -error;
+    }
+    return error <= 1.0L + inExact * 1e-12L;
+}
+
+@interface AudioHubHostTimeTests : XCTestCase
+
+@end
+
+@implementation AudioHubHostTimeTests
+
+- (void)testMonotonicOnEveryThread {
+    const UInt32 numberThreads = 4;
+    std::atomic<UInt32> backwards(0);
+    std::atomic<UInt32> *backwardsPointer = &backwards;
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < numberThreads; ++thread) {
+        threads.push_back(std::thread([backwardsPointer] {
+            UInt64 last = CAHostTimeBase::GetTheCurrentTime();
+            for (UInt32 i = 0; i < 1000000; ++i) {
+                UInt64 now = CAHostTimeBase::GetTheCurrentTime();
+                if (now < last) {
+                    backwardsPointer->fetch_add(1);
+                }
+                last = now;
+            }
+        }));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    XCTAssertEqual(backwards.load(), 0);
+}
+
+- (void)testMonotonicBetweenThreads {
+    //  a time handed to another thread is never later than what that thread reads next
+    std::atomic<UInt64> published(0);
+    std::atomic<UInt64> *publishedPointer = &published;
+    std::atomic<bool> isDone(false);
+    std::atomic<bool> *isDonePointer = &isDone;
+    std::thread writer([publishedPointer, isDonePointer] {
+        while (!isDonePointer->load()) {
+            publishedPointer->store(CAHostTimeBase::GetTheCurrentTime());
+        }
+    });
+    UInt32 backwards = 0;
+    for (UInt32 i = 0; i < 1000000; ++i) {
+        UInt64 theirs = published.load();
+        if (CAHostTimeBase::GetTheCurrentTime() < theirs) {
+            ++backwards;
+        }
+    }
+    isDone = true;
+    writer.join();
+    XCTAssertEqual(backwards, 0);
+}
+
+- (void)testConversionsAreAccurate {
+    const long double frequency = CAHostTimeBase::GetFrequency();
+    XCTAssertGreaterThan(frequency, 0);
+    const UInt64 ticksPerNano = (UInt64)(frequency / 1e9L) + 1;
+
+    //  up to about a year of host time
+    for (UInt64 ticks = 0; ticks < (UInt64)(frequency * 3.2e7L); ticks = ticks + ticks / 7 + 1) {
+        UInt64 nanos = CAHostTimeBase::ConvertToNanos(ticks);
+        XCTAssert(IsAccurate(nanos, ticks * 1e9L / frequency), @"to nanos %llu", ticks);
+        XCTAssert(IsAccurate(CAHostTimeBase::ConvertFromNanos(ticks), ticks * frequency / 1e9L), @"from nanos %llu", ticks);
+
+        UInt64 roundTrip = CAHostTimeBase::ConvertFromNanos(nanos);
+        XCTAssertLessThanOrEqual(roundTrip > ticks ? roundTrip - ticks : ticks - roundTrip, ticksPerNano, @"round trip %llu", ticks);
+    }
+
+    XCTAssertEqual(CAHostTimeBase::MultiplyByRatio(3000000000ULL, 125, 3), 125000000000ULL);
+    XCTAssertEqual(CAHostTimeBase::MultiplyByRatio(0xFFFFFFFFFFFFULL, 1000000, 1000000), 0xFFFFFFFFFFFFULL);
+}
+
+- (void)testAgreesWithTheSteadyClock {
+    //  catches a badly calibrated clock, which the conversions alone can't
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    UInt64 hostStart = CAHostTimeBase::GetTheCurrentTime();
+    usleep(100000);
+    UInt64 hostNanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - hostStart);
+    Float64 steadyNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    XCTAssertEqualWithAccuracy(hostNanos, steadyNanos, steadyNanos * 0.01);
+}
+
+#pragma mark Performance
+
+enum { kNumberCalls = 10000000 };
+
+//  logs ns per call of reading the clock and of each conversion
+- (void)testPerformanceNanosPerCall {
+    [self measureBlock:^{
+        UInt64 sum = 0;
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberCalls; ++i) {
+            sum += CAHostTimeBase::GetTheCurrentTime();
+        }
+        UInt64 now = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberCalls; ++i) {
+            sum += CAHostTimeBase::ConvertToNanos(sum + i);
+        }
+        UInt64 toNanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberCalls; ++i) {
+            sum += CAHostTimeBase::ConvertFromNanos(sum + i);
+        }
+        UInt64 fromNanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberCalls; ++i) {
+            sum += CAHostTimeBase::MultiplyByRatio(sum + i, 125, 3);
+        }
+        UInt64 ratio = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        NSLog(@"host time: %5.2f ns now, %5.2f ns to nanos, %5.2f ns from nanos, %5.2f ns MultiplyByRatio (%llu)", (double)now / kNumberCalls,
+              (double)toNanos / kNumberCalls, (double)fromNanos / kNumberCalls, (double)ratio / kNumberCalls, sum & 1);
+    }];
+}
+
+@end
@@ -0,0 +1,250 @@
+//
+//  AudioHubMessageQueueTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAMessageQueue.h"
+#include "CAHostTimeBase.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct Record {
+    UInt32 mProducer;
+    UInt32 mSequence;
+    UInt64 mHostTime;
+};
+
+struct Result {
+    UInt32 mNumberOutOfOrder;
+    UInt64 mSum;
+    double mOperationsPerSecond;
+    UInt64 mP50Nanos;
+    UInt64 mP99Nanos;
+};
+
+//  every producer pushes inNumberRecords numbered records in batches, the consumers pop until all
+//  of them arrived and check that each producer's records arrive in order
+template <class Queue>
+static Result Run(Queue& ioQueue, UInt32 inNumberProducers, UInt32 inNumberConsumers, UInt32 inNumberRecords, UInt32 inBatchSize) {
+    std::atomic<UInt64> numberConsumed(0);
+    std::atomic<UInt32> numberOutOfOrder(0);
+    std::atomic<UInt64> sum(0);
+    std::vector<std::vector<UInt64>> latencies(inNumberConsumers);
+    const UInt64 numberRecords = (UInt64)inNumberProducers * inNumberRecords;
+
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    std::vector<std::thread> threads;
+    for (UInt32 producer = 0; producer < inNumberProducers; ++producer) {
+        threads.emplace_back([&, producer] {
+            std::vector<Record> records(inBatchSize);
+            for (UInt32 sequence = 0; sequence < inNumberRecords; ) {
+                UInt32 numberRecords = std::min(inBatchSize, inNumberRecords - sequence);
+                UInt64 now = CAHostTimeBase::GetTheCurrentTime();
+                for (UInt32 i = 0; i < numberRecords; ++i) {
+                    records[i].mProducer = producer;
+                    records[i].mSequence = sequence + i + 1;
+                    records[i].mHostTime = now;
+                }
+                UInt32 numberPushed = ioQueue.Push(&records[0], numberRecords);
+                sequence += numberPushed;
+                if (numberPushed < numberRecords) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (UInt32 consumer = 0; consumer < inNumberConsumers; ++consumer) {
+        threads.emplace_back([&, consumer] {
+            std::vector<Record> records(inBatchSize);
+            std::vector<UInt32> lastSequences(inNumberProducers, 0);
+            std::vector<UInt64>& consumerLatencies = latencies[consumer];
+            consumerLatencies.reserve(numberRecords / inNumberConsumers + inBatchSize);
+            UInt64 consumerSum = 0;
+            while (numberConsumed.load() < numberRecords) {
+                UInt32 numberPopped = ioQueue.Pop(&records[0], inBatchSize);
+                if (numberPopped == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                UInt64 now = CAHostTimeBase::GetTheCurrentTime();
+                for (UInt32 i = 0; i < numberPopped; ++i) {
+                    consumerLatencies.push_back(now - records[i].mHostTime);
+                    if (records[i].mSequence <= lastSequences[records[i].mProducer]) {
+                        numberOutOfOrder.fetch_add(1);
+                    }
+                    lastSequences[records[i].mProducer] = records[i].mSequence;
+                    consumerSum += records[i].mSequence;
+                }
+                numberConsumed.fetch_add(numberPopped);
+            }
+            sum.fetch_add(consumerSum);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    std::vector<UInt64> allLatencies;
+    for (const std::vector<UInt64>& consumerLatencies : latencies) {
+        allLatencies.insert(allLatencies.end(), consumerLatencies.begin(), consumerLatencies.end());
+    }
+    std::sort(allLatencies.begin(), allLatencies.end());
+    Result result = { numberOutOfOrder.load(), sum.load(), numberRecords * 1e9 / nanos,
+                      CAHostTimeBase::ConvertToNanos(allLatencies[allLatencies.size() / 2]), CAHostTimeBase::ConvertToNanos(allLatencies[allLatencies.size() * 99 / 100]) };
+    return result;
+}
+
+static UInt64 ExpectedSum(UInt32 inNumberProducers, UInt32 inNumberRecords) {
+    return (UInt64)inNumberProducers * inNumberRecords * (inNumberRecords + 1) / 2;
+}
+
+//  the same single threaded checks for every record queue
+template <class Queue>
+static bool CheckBatches(Queue& ioQueue) {
+    const UInt32 records[] = { 1, 2, 3, 4, 5, 6 };
+    UInt32 popped[8] = {};
+    bool isCorrect = ioQueue.Push(records, 6) == 4 && !ioQueue.Push(records[0]) && ioQueue.GetNumberRecords() == 4;
+    isCorrect = isCorrect && ioQueue.Pop(popped, 3) == 3 && popped[2] == 3;
+
+    //  the ring wraps around
+    isCorrect = isCorrect && ioQueue.Push(records, 6) == 3 && ioQueue.Pop(popped, 8) == 4;
+    isCorrect = isCorrect && popped[0] == 4 && popped[1] == 1 && popped[3] == 3;
+    return isCorrect && !ioQueue.Pop(popped[0]) && ioQueue.GetNumberRecords() == 0;
+}
+
+static const UInt32 kNumberRecords = 1000000;
+
+template <class Queue>
+static void Measure(const char *inName, UInt32 inNumberProducers, UInt32 inNumberConsumers, UInt32 inBatchSize) {
+    std::unique_ptr<Queue> queue(new Queue);
+    Result result = Run(*queue, inNumberProducers, inNumberConsumers, kNumberRecords / inNumberProducers, inBatchSize);
+    NSLog(@"%s %u producers %u consumers batch %2u: %6.2f M records/s, latency p50 %7llu ns, p99 %8llu ns", inName, inNumberProducers, inNumberConsumers,
+          inBatchSize, result.mOperationsPerSecond / 1e6, result.mP50Nanos, result.mP99Nanos);
+}
+
+@interface AudioHubMessageQueueTests : XCTestCase
+
+@end
+
+@implementation AudioHubMessageQueueTests
+
+- (void)testBatches {
+    TSPSCQueue<UInt32, 4> spsc;
+    XCTAssert(CheckBatches(spsc));
+    TMPSCQueue<UInt32, 4> mpsc;
+    XCTAssert(CheckBatches(mpsc));
+    TSPMCQueue<UInt32, 4> spmc;
+    XCTAssert(CheckBatches(spmc));
+}
+
+- (void)testSingleProducerSingleConsumer {
+    std::unique_ptr<TSPSCQueue<Record, 256>> queue(new TSPSCQueue<Record, 256>);
+    Result result = Run(*queue, 1, 1, 200000, 7);
+    XCTAssertEqual(result.mNumberOutOfOrder, 0);
+    XCTAssertEqual(result.mSum, ExpectedSum(1, 200000));
+}
+
+- (void)testMultipleProducers {
+    std::unique_ptr<TMPSCQueue<Record, 256>> queue(new TMPSCQueue<Record, 256>);
+    Result result = Run(*queue, 8, 1, 50000, 7);
+    XCTAssertEqual(result.mNumberOutOfOrder, 0);
+    XCTAssertEqual(result.mSum, ExpectedSum(8, 50000));
+}
+
+- (void)testMultipleConsumers {
+    //  every record arrives exactly once, the order holds within a consumer
+    std::unique_ptr<TSPMCQueue<Record, 256>> queue(new TSPMCQueue<Record, 256>);
+    Result result = Run(*queue, 1, 8, 200000, 7);
+    XCTAssertEqual(result.mNumberOutOfOrder, 0);
+    XCTAssertEqual(result.mSum, ExpectedSum(1, 200000));
+}
+
+- (void)testByteSpans {
+    TSPSCByteQueue<64> queue;
+    char bytes[64];
+    XCTAssertEqual(TSPSCByteQueue<64>::GetMaximumSpanSize(), 24);
+    XCTAssertFalse(queue.Push(bytes, 25));
+
+    //  spans of every size at every position of the ring
+    for (UInt32 round = 0; round < 100; ++round) {
+        UInt32 numberBytes = round % 25;
+        memset(bytes, (int)round, numberBytes);
+        XCTAssert(queue.Push(bytes, numberBytes));
+        char popped[64] = {};
+        XCTAssertEqual(queue.Pop(popped, sizeof(popped)), numberBytes);
+        XCTAssertEqual(memcmp(popped, bytes, numberBytes), 0);
+    }
+
+    XCTAssert(queue.Push("abc", 3));
+    XCTAssert(queue.Push("defgh", 5));
+    const void *span = NULL;
+    UInt32 numberBytes = 0;
+    XCTAssert(queue.Peek(span, numberBytes));
+    XCTAssertEqual(numberBytes, 3);
+    queue.Pop();
+    XCTAssert(queue.Peek(span, numberBytes));
+    XCTAssertEqual(numberBytes, 5);
+    XCTAssertEqual(memcmp(span, "defgh", 5), 0);
+
+    //  a span that doesn't fit the buffer stays in the queue
+    char small[4];
+    XCTAssertEqual(queue.Pop(small, sizeof(small)), 0);
+    queue.Pop();
+    XCTAssertFalse(queue.Peek(span, numberBytes));
+    XCTAssertEqual(queue.GetNumberUsedBytes(), 0);
+}
+
+- (void)testByteSpansAcrossThreads {
+    std::unique_ptr<TSPSCByteQueue<4096>> queue(new TSPSCByteQueue<4096>);
+    TSPSCByteQueue<4096> *queuePointer = queue.get();
+    const UInt32 numberSpans = 100000;
+    std::thread producer([=] {
+        char bytes[600];
+        for (UInt32 span = 0; span < numberSpans; ++span) {
+            memset(bytes, (int)span, span % 600);
+            while (!queuePointer->Push(bytes, span % 600)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    UInt32 numberCorrupted = 0;
+    for (UInt32 span = 0; span < numberSpans; ++span) {
+        const void *bytes = NULL;
+        UInt32 numberBytes = 0;
+        while (!queue->Peek(bytes, numberBytes)) {
+            std::this_thread::yield();
+        }
+        numberCorrupted += numberBytes != span % 600;
+        for (UInt32 i = 0; i < numberBytes; ++i) {
+            numberCorrupted += ((const char *)bytes)[i] != (char)span;
+        }
+        queue->Pop();
+    }
+    producer.join();
+    XCTAssertEqual(numberCorrupted, 0);
+}
+
+#pragma mark Performance
+
+//  logs records per second and the latency from push to pop, one record at a time and in batches
+- (void)testPerformanceAcrossCores {
+    [self measureBlock:^{
+        for (UInt32 batchSize = 1; batchSize <= 16; batchSize *= 16) {
+            Measure<TSPSCQueue<Record, 1024>>("SPSC", 1, 1, batchSize);
+            for (UInt32 numberThreads = 2; numberThreads <= 8; numberThreads *= 2) {
+                Measure<TMPSCQueue<Record, 1024>>("MPSC", numberThreads, 1, batchSize);
+                Measure<TSPMCQueue<Record, 1024>>("SPMC", 1, numberThreads, batchSize);
+            }
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,208 @@
+//
+//  AudioHubMutexTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAHostTimeBase.h"
+#include "CAMutex.h"
+#include "Device.h"
+#include <thread>
+#include <vector>
+
+@interface AudioHubMutexTests : XCTestCase
+
+@end
+
+@implementation AudioHubMutexTests
+
+- (void)setUp {
+    [super setUp];
+    CAMutex::ResetStatistics();
+    CAMutex::SetIsCollectingStatistics(true);
+}
+
+- (void)tearDown {
+    CAMutex::SetIsCollectingStatistics(false);
+    [super tearDown];
+}
+
+- (void)testTimesNeedStatistics {
+    CAMutex::SetIsCollectingStatistics(false);
+    CAMutex mutex("AudioHubMutexTests Off");
+    {
+        CAMutex::Locker locker(mutex);
+        usleep(1000);
+    }
+    CAMutex::Statistics statistics;
+    mutex.GetStatistics(statistics);
+    XCTAssertEqual(statistics.mNumberAcquisitions, 1);
+    XCTAssertEqual(statistics.mMaximumHoldNanos, 0);
+}
+
+- (void)testRecursiveLocking {
+    for (UInt32 spinCount : { 0U, (UInt32)CAMutex::kDefaultSpinCount }) {
+        CAMutex mutex("AudioHubMutexTests Recursive", spinCount);
+        XCTAssert(mutex.IsFree());
+        XCTAssert(mutex.Lock());
+        XCTAssertFalse(mutex.Lock());
+        XCTAssert(mutex.IsOwnedByCurrentThread());
+
+        bool wasLocked = true;
+        XCTAssert(mutex.Try(wasLocked));
+        XCTAssertFalse(wasLocked);
+        mutex.Unlock();
+        XCTAssert(mutex.IsFree());
+
+        //  another thread can't take it while it is held
+        XCTAssert(mutex.Try(wasLocked));
+        XCTAssert(wasLocked);
+        bool otherThreadGotIt = true;
+        CAMutex *mutexPointer = &mutex;
+        std::thread([&] {
+            bool otherWasLocked = false;
+            otherThreadGotIt = mutexPointer->Try(otherWasLocked);
+        }).join();
+        XCTAssertFalse(otherThreadGotIt);
+        mutex.Unlock();
+    }
+}
+
+- (void)testSpinCountIsClamped {
+    CAMutex mutex("AudioHubMutexTests Clamped", 1000000);
+    XCTAssertEqual(mutex.GetMaximumSpinCount(), CAMutex::kMaximumSpinCount);
+}
+
+- (void)testStatisticsAreSummedByName {
+    CAMutex::Statistics statistics;
+    XCTAssertFalse(CAMutex::GetStatistics("AudioHubMutexTests Summed", statistics));
+
+    CAMutex first("AudioHubMutexTests Summed");
+    {
+        CAMutex second("AudioHubMutexTests Summed", CAMutex::kDefaultSpinCount);
+        for (UInt32 i = 0; i < 3; ++i) {
+            CAMutex::Locker locker(first);
+            CAMutex::Locker secondLocker(second);
+        }
+        CAMutex::Locker locker(second);
+        usleep(2000);
+    }
+
+    //  the counters of a destroyed mutex still count
+    XCTAssert(CAMutex::GetStatistics("AudioHubMutexTests Summed", statistics));
+    XCTAssertEqual(statistics.mNumberAcquisitions, 7);
+    XCTAssertEqual(statistics.mNumberContendedAcquisitions, 0);
+    XCTAssertGreaterThanOrEqual(statistics.mMaximumHoldNanos, 2000000);
+
+    first.GetStatistics(statistics);
+    XCTAssertEqual(statistics.mNumberAcquisitions, 3);
+    CAMutex::DumpStatistics();
+
+    CAMutex::ResetStatistics();
+    first.GetStatistics(statistics);
+    XCTAssertEqual(statistics.mNumberAcquisitions, 0);
+}
+
+- (void)testContendedCounting {
+    CAMutex mutex("AudioHubMutexTests Contended", CAMutex::kDefaultSpinCount);
+    CAMutex *mutexPointer = &mutex;
+    UInt64 counter = 0;
+    UInt64 *counterPointer = &counter;
+
+    //  the holder sleeps, so the other threads have to wait, and some of them have to park
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < 4; ++thread) {
+        threads.push_back(std::thread([=] {
+            for (UInt32 i = 0; i < 50; ++i) {
+                CAMutex::Locker locker(mutexPointer);
+                ++*counterPointer;
+                usleep(100);
+            }
+        }));
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    CAMutex::Statistics statistics;
+    mutex.GetStatistics(statistics);
+    XCTAssertEqual(counter, 200);
+    XCTAssertEqual(statistics.mNumberAcquisitions, 200);
+    XCTAssertGreaterThan(statistics.mNumberContendedAcquisitions, 0);
+    XCTAssertGreaterThan(statistics.mTotalWaitNanos, 0);
+    XCTAssertGreaterThanOrEqual(statistics.mMaximumHoldNanos, 100000);
+}
+
+- (void)testDeviceStateMutex {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    Device *device = new Device(objectId);
+    CAObjectMap::MapObject(objectId, device);
+    device->Activate();
+
+    CAMutex::Statistics before, after;
+    CAMutex::GetStatistics("Hub State", before);
+    for (UInt32 i = 0; i < 10; ++i) {
+        device->StartIO();
+        device->StopIO();
+    }
+    CAMutex::GetStatistics("Hub State", after);
+    //  property reads take the state lock shared, so it's the writers that show up here
+    XCTAssertGreaterThanOrEqual(after.mNumberAcquisitions - before.mNumberAcquisitions, 20);
+
+    device->Deactivate();
+    CAObjectMap::UnmapObject(objectId, device);
+}
+
+#pragma mark Performance
+
+//  logs the time per acquisition of a short critical section for 1 to 16 threads
+- (void)measureSpinCount:(UInt32)inSpinCount {
+    for (UInt32 numberThreads = 1; numberThreads <= 16; numberThreads *= 2) {
+        CAMutex mutex("AudioHubMutexTests Benchmark", inSpinCount);
+        CAMutex *mutexPointer = &mutex;
+        UInt64 counter = 0;
+        UInt64 *counterPointer = &counter;
+        const UInt32 numberAcquisitions = 1 << 20;
+        const UInt32 numberAcquisitionsPerThread = numberAcquisitions / numberThreads;
+
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        std::vector<std::thread> threads;
+        for (UInt32 thread = 0; thread < numberThreads; ++thread) {
+            threads.push_back(std::thread([=] {
+                for (UInt32 i = 0; i < numberAcquisitionsPerThread; ++i) {
+                    CAMutex::Locker locker(mutexPointer);
+                    ++*counterPointer;
+                }
+            }));
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        CAMutex::Statistics statistics;
+        mutex.GetStatistics(statistics);
+        NSLog(@"mutex spin %4u, %2u threads: %6.1f ns per acquisition, %5.1f%% contended, %8.1f ns average wait", inSpinCount, numberThreads,
+              (double)nanos / counter, 100.0 * statistics.mNumberContendedAcquisitions / statistics.mNumberAcquisitions,
+              statistics.mNumberContendedAcquisitions > 0 ? (double)statistics.mTotalWaitNanos / statistics.mNumberContendedAcquisitions : 0.0);
+    }
+}
+
+- (void)testPerformanceContention {
+    [self measureBlock:^{
+        [self measureSpinCount:0];
+        [self measureSpinCount:CAMutex::kDefaultSpinCount];
+    }];
+}
+
+- (void)testPerformanceWithoutStatistics {
+    CAMutex::SetIsCollectingStatistics(false);
+    [self measureBlock:^{
+        [self measureSpinCount:CAMutex::kDefaultSpinCount];
+    }];
+}
+
+@end
@@ -0,0 +1,222 @@
+//
+//  AudioHubNoiseReducerTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <CoreAudio/AudioServerPlugIn.h>
+#if !ULTRASCHALL
+#if !TEST
+#include "AudioHubTypes.h"
+#else
+#include "AudioHubTestTypes.h"
+#endif
+#else
+#if !TEST
+#include "UltraschallHubTypes.h"
+#else
+#include "UltraschallHubTestTypes.h"
+#endif
+#endif
+#include "CAHALAudioObjectTester.h"
+#include "CAPropertyAddress.h"
+#include "CAHostTimeBase.h"
+#include "CACFDictionary.h"
+#include "CACFArray.h"
+#include "Device.h"
+#include "DeviceList.h"
+#include "NoiseReducer.h"
+#include <malloc/malloc.h>
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <vector>
+
+@interface AudioHubNoiseReducerTests : XCTestCase
+
+@end
+
+@implementation AudioHubNoiseReducerTests
+
+static const Float64 kSampleRate = 48000.0;
+static const UInt32 kBlockSize = 512;
+
+//  white noise on every channel, plus a 440 Hz tone from inToneStart on
+static void FillSignal(std::vector<Float32>& outNoisy, std::vector<Float32>& outClean, UInt32 inNumberChannels, UInt32 inNumberFrames, UInt32 inToneStart) {
+    std::mt19937 generator(1);
+    std::normal_distribution<Float32> noise(0.0f, 0.02f);
+    outNoisy.resize(inNumberFrames * inNumberChannels);
+    outClean.resize(inNumberFrames * inNumberChannels);
+    for (UInt32 frame = 0; frame < inNumberFrames; ++frame) {
+        Float32 tone = frame >= inToneStart ? 0.3f * (Float32)sin(2.0 * M_PI * 440.0 * frame / kSampleRate) : 0.0f;
+        for (UInt32 channel = 0; channel < inNumberChannels; ++channel) {
+            outClean[frame * inNumberChannels + channel] = tone;
+            outNoisy[frame * inNumberChannels + channel] = tone + noise(generator);
+        }
+    }
+}
+
+static void ProcessInBlocks(NoiseReducer& inReducer, std::vector<Float32>& ioSignal) {
+    UInt32 numberChannels = inReducer.GetNumberChannels();
+    UInt32 numberFrames = (UInt32)(ioSignal.size() / numberChannels);
+    for (UInt32 frame = 0; frame < numberFrames; frame += kBlockSize) {
+        inReducer.Process(&ioSignal[frame * numberChannels], std::min(kBlockSize, numberFrames - frame));
+    }
+}
+
+//  the energy of channel 0 of inSignal, delayed by inDelay, over [inStart, inEnd)
+static double Energy(const std::vector<Float32>& inSignal, UInt32 inNumberChannels, UInt32 inStart, UInt32 inEnd, UInt32 inDelay) {
+    double energy = 0.0;
+    for (UInt32 frame = inStart; frame < inEnd; ++frame) {
+        Float32 sample = inSignal[(frame + inDelay) * inNumberChannels];
+        energy += sample * sample;
+    }
+    return energy;
+}
+
+- (void)testReducesStationaryNoise {
+    const UInt32 numberFrames = 3 * (UInt32)kSampleRate;
+    std::vector<Float32> signal, clean;
+    FillSignal(signal, clean, 2, numberFrames, numberFrames);
+    std::vector<Float32> input = signal;
+
+    NoiseReducer reducer(2, kSampleRate, 20.0f);
+    ProcessInBlocks(reducer, signal);
+
+    //  skip the first second while the floor settles
+    const UInt32 latency = NoiseReducer::GetLatency();
+    double reduction = 10.0 * log10(Energy(input, 2, kSampleRate, numberFrames - latency, 0) / Energy(signal, 2, kSampleRate, numberFrames - latency, latency));
+    NSLog(@"noise reduction: %.1f dB", reduction);
+    XCTAssertGreaterThan(reduction, 12.0);
+    XCTAssertLessThan(reduction, 21.0);
+}
+
+- (void)testKeepsTone {
+    const UInt32 numberFrames = 4 * (UInt32)kSampleRate;
+    const UInt32 toneStart = 2 * (UInt32)kSampleRate;
+    std::vector<Float32> signal, clean;
+    FillSignal(signal, clean, 1, numberFrames, toneStart);
+    std::vector<Float32> input = signal;
+
+    NoiseReducer reducer(1, kSampleRate, 20.0f);
+    ProcessInBlocks(reducer, signal);
+
+    const UInt32 latency = NoiseReducer::GetLatency();
+    double errorBefore = 0.0, errorAfter = 0.0;
+    for (UInt32 frame = toneStart + latency; frame < numberFrames - latency; ++frame) {
+        errorBefore += (input[frame] - clean[frame]) * (input[frame] - clean[frame]);
+        errorAfter += (signal[frame + latency] - clean[frame]) * (signal[frame + latency] - clean[frame]);
+    }
+    double improvement = 10.0 * log10(errorBefore / errorAfter);
+    NSLog(@"tone SNR improvement: %.1f dB", improvement);
+    XCTAssertGreaterThan(improvement, 6.0);
+}
+
+- (void)testProcessDoesNotAllocate {
+    std::vector<Float32> signal, clean;
+    FillSignal(signal, clean, 8, kBlockSize * 64, 0);
+    NoiseReducer reducer(8, kSampleRate, 20.0f);
+
+    malloc_statistics_t before, after;
+    malloc_zone_statistics(NULL, &before);
+    ProcessInBlocks(reducer, signal);
+    malloc_zone_statistics(NULL, &after);
+    XCTAssertEqual(before.blocks_in_use, after.blocks_in_use);
+}
+
+- (void)testLatency {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    Device *device = new Device(objectId);
+    CAObjectMap::MapObject(objectId, device);
+    device->Activate();
+
+    CAHALAudioObjectTester tester(device);
+    CAPropertyAddress inputLatency(kAudioDevicePropertyLatency, kAudioObjectPropertyScopeInput);
+    CAPropertyAddress outputLatency(kAudioDevicePropertyLatency, kAudioObjectPropertyScopeOutput);
+    XCTAssertEqual(tester.GetPropertyData_UInt32(inputLatency), 0);
+
+    //  the latency follows the reducer, which is only set up when IO starts
+    device->SetNoiseReduction(20.0f);
+    XCTAssertEqual(tester.GetPropertyData_UInt32(inputLatency), 0);
+    device->StartIO();
+    XCTAssertEqual(tester.GetPropertyData_UInt32(inputLatency), NoiseReducer::GetLatency());
+    XCTAssertEqual(tester.GetPropertyData_UInt32(outputLatency), 0);
+
+    //  the first block that is written is still in the reducer's delay line when the call returns
+    XCTAssertGreaterThanOrEqual(NoiseReducer::GetLatency(), kBlockSize);
+    UInt32 numberChannels = device->GetChannels();
+    std::vector<Float32> buffer(kBlockSize * numberChannels, 0.25f);
+    AudioServerPlugInIOCycleInfo cycleInfo = {};
+    device->DoIOOperation(0, kAudioServerPlugInIOOperationWriteMix, kBlockSize, cycleInfo, &buffer[0], NULL);
+    device->StopIO();
+    XCTAssertEqual(*std::max_element(buffer.begin(), buffer.end()), 0.0f);
+    XCTAssertEqual(*std::min_element(buffer.begin(), buffer.end()), 0.0f);
+
+    device->SetNoiseReduction(0.0f);
+    XCTAssertEqual(tester.GetPropertyData_UInt32(inputLatency), NoiseReducer::GetLatency());
+    device->StartIO();
+    device->StopIO();
+    XCTAssertEqual(tester.GetPropertyData_UInt32(inputLatency), 0);
+
+    //  releasing the last reference destroys the device
+    device->Deactivate();
+    CAObjectMap::ReleaseObject(device);
+}
+
+- (void)testSettingsRoundTrip {
+    CACFDictionary settings(true);
+    CACFArray devices(true);
+    CACFDictionary device(true);
+    device.AddCFType(kAudioHubSettingsKeyDeviceName, CFSTR("guest"));
+    device.AddCFType(kAudioHubSettingsKeyDeviceUID, CFSTR("guest-uid"));
+    device.AddUInt32(kAudioHubSettingsKeyDeviceChannels, 2);
+    device.AddFloat32(kAudioHubSettingsKeyDeviceNoiseReduction, 15.0f);
+    devices.AppendDictionary(device.GetCFDictionary());
+    settings.AddArray(kAudioHubSettingsKeyDevices, devices.GetCFArray());
+
+    DeviceList source;
+    XCTAssert(source.SetSettings(settings.GetCFDictionary()));
+    NSDictionary *xml = (__bridge_transfer NSDictionary*)source.GetSettings();
+    XCTAssertEqualObjects(xml[(__bridge NSString*)kAudioHubSettingsKeyDevices][0][(__bridge NSString*)kAudioHubSettingsKeyDeviceNoiseReduction], @15);
+
+    CFDataRef binary = source.CopyBinarySettings();
+    DeviceList destination;
+    XCTAssert(destination.SetSettings(binary));
+    CAObjectReleaser<Device> restored(CAObjectMap::CopyObjectOfClassByObjectID<Device>(destination.GetDeviceObjectIDByUUID(CFSTR("guest-uid"))));
+    XCTAssert(restored.IsValid());
+    XCTAssertEqual(restored->GetNoiseReduction(), 15.0f);
+    CFRelease(binary);
+
+    source.RemoveAllDevices();
+    destination.RemoveAllDevices();
+}
+
+#pragma mark Performance
+
+//  how many channels one core keeps up with in real time
+- (void)measureChannels:(UInt32)inNumberChannels {
+    std::vector<Float32> signal, clean;
+    FillSignal(signal, clean, inNumberChannels, kBlockSize, 0);
+    NoiseReducer reducer(inNumberChannels, kSampleRate, 20.0f);
+    const UInt32 numberBlocks = 1000;
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 block = 0; block < numberBlocks; ++block) {
+        reducer.Process(&signal[0], kBlockSize);
+    }
+    Float64 seconds = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) / 1e9;
+    Float64 audioSeconds = numberBlocks * kBlockSize / kSampleRate;
+    NSLog(@"noise reducer %2u channels: %6.1fx real time, %4.0f channels per core", inNumberChannels, audioSeconds / seconds, inNumberChannels * audioSeconds / seconds);
+}
+
+- (void)testPerformanceChannelsPerCore {
+    [self measureBlock:^{
+        for (UInt32 channels = 1; channels <= 32; channels *= 2) {
+            [self measureChannels:channels];
+        }
+    }];
+}
+
+@end
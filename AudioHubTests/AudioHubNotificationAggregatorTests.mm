@@ -0,0 +1,155 @@
+//
+//  AudioHubNotificationAggregatorTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <CoreAudio/AudioServerPlugIn.h>
+#if !ULTRASCHALL
+#if !TEST
+#include "AudioHubTypes.h"
+#else
+#include "AudioHubTestTypes.h"
+#endif
+#else
+#if !TEST
+#include "UltraschallHubTypes.h"
+#else
+#include "UltraschallHubTestTypes.h"
+#endif
+#endif
+#include "NotificationAggregator.h"
+#include "CAHALAudioObjectTester.h"
+#include "CAPropertyAddress.h"
+#include "PlugIn.h"
+#include "Box.h"
+#import "Settings.h"
+
+static UInt32 sDeliveredCalls = 0;
+static UInt32 sDeliveredAddresses = 0;
+
+static void CountingDeliveryProc(AudioObjectID /*inObjectID*/, UInt32 inNumberAddresses, const AudioObjectPropertyAddress /*inAddresses*/[]) {
+    ++sDeliveredCalls;
+    sDeliveredAddresses += inNumberAddresses;
+}
+
+@interface AudioHubNotificationAggregatorTests : XCTestCase
+
+@end
+
+@implementation AudioHubNotificationAggregatorTests
+
+- (void)setUp {
+    [super setUp];
+    sDeliveredCalls = 0;
+    sDeliveredAddresses = 0;
+}
+
+- (void)tearDown {
+    [super tearDown];
+}
+
+- (void)testTransactionCoalescesPerObject {
+    NotificationAggregator aggregator(CountingDeliveryProc, 0);
+    AudioObjectPropertyAddress theChangedProperties[] = {
+        {kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster},
+        {kAudioBoxPropertyAcquired, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}
+    };
+    {
+        NotificationAggregator::Transaction theTransaction(aggregator);
+        for (UInt32 i = 0; i < 100; ++i) {
+            aggregator.PropertiesChanged(kAudioObjectPlugInObject, 1, theChangedProperties);
+            aggregator.PropertiesChanged(42, 2, theChangedProperties);
+        }
+        XCTAssertEqual(sDeliveredCalls, 0);
+        XCTAssert(aggregator.HasPendingNotifications());
+    }
+    XCTAssertEqual(sDeliveredCalls, 2);
+    XCTAssertEqual(sDeliveredAddresses, 3);
+    XCTAssertEqual(aggregator.GetNumberPostedCalls(), 200);
+    XCTAssertEqual(aggregator.GetNumberDeliveredCalls(), 2);
+    XCTAssertEqual(aggregator.GetNumberSavedCalls(), 198);
+    XCTAssertFalse(aggregator.HasPendingNotifications());
+}
+
+- (void)testNestedTransactionsDeliverOnce {
+    NotificationAggregator aggregator(CountingDeliveryProc, 0);
+    AudioObjectPropertyAddress theChangedProperties[] = {
+        {kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}
+    };
+    {
+        NotificationAggregator::Transaction theOuterTransaction(aggregator);
+        {
+            NotificationAggregator::Transaction theInnerTransaction(aggregator);
+            aggregator.PropertiesChanged(kAudioObjectPlugInObject, 1, theChangedProperties);
+        }
+        XCTAssertEqual(sDeliveredCalls, 0);
+        aggregator.PropertiesChanged(kAudioObjectPlugInObject, 1, theChangedProperties);
+    }
+    XCTAssertEqual(sDeliveredCalls, 1);
+}
+
+- (void)testZeroWindowDeliversImmediately {
+    NotificationAggregator aggregator(CountingDeliveryProc, 0);
+    AudioObjectPropertyAddress theChangedProperties[] = {
+        {kAudioPlugInPropertyDeviceList, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}
+    };
+    aggregator.PropertiesChanged(kAudioObjectPlugInObject, 1, theChangedProperties);
+    aggregator.PropertiesChanged(kAudioObjectPlugInObject, 1, theChangedProperties);
+    XCTAssertEqual(sDeliveredCalls, 2);
+    XCTAssertEqual(aggregator.GetNumberSavedCalls(), 0);
+}
+
+- (void)testWindowCoalesces {
+    static NotificationAggregator aggregator(CountingDeliveryProc, 20 * 1000 * 1000);
+    aggregator.ResetStatistics();
+    AudioObjectPropertyAddress theChangedProperties[] = {
+        {kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster},
+        {kAudioLevelControlPropertyDecibelValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMaster}
+    };
+    for (UInt32 i = 0; i < 50; ++i) {
+        aggregator.PropertiesChanged(42, 2, theChangedProperties);
+    }
+    XCTAssertEqual(sDeliveredCalls, 0);
+
+    for (int i = 0; i < 100 && aggregator.HasPendingNotifications(); ++i) {
+        usleep(10 * 1000);
+    }
+    XCTAssertEqual(sDeliveredCalls, 1);
+    XCTAssertEqual(sDeliveredAddresses, 2);
+    XCTAssertEqual(aggregator.GetNumberSavedCalls(), 49);
+}
+
+#if !ULTRASCHALL
+- (void)testBulkSettingsUploadSavesNotifications {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    CAObject *box = new Box(objectId);
+    CAObjectMap::MapObject(objectId, box);
+    box->Activate();
+
+    NotificationAggregator &aggregator = PlugIn::GetNotificationAggregator();
+    aggregator.Flush();
+    aggregator.ResetStatistics();
+
+    AudioHubSettings* settings = [[AudioHubSettings alloc] init];
+    for (int i = 0; i < 16; ++i) {
+        [settings addDevice:[NSString stringWithFormat:@"name%d", i] andUID:[NSString stringWithFormat:@"uid%d", i] andChannels:2];
+    }
+    CAHALAudioObjectTester tester(box);
+    tester.SetPropertyData_CFType(CAPropertyAddress(kAudioHubCustomPropertySettings), (__bridge CFDictionaryRef)[settings getSettings]);
+
+    XCTAssertFalse(aggregator.HasPendingNotifications());
+    XCTAssertGreaterThanOrEqual(aggregator.GetNumberPostedCalls(), 2);
+    XCTAssertLessThanOrEqual(aggregator.GetNumberDeliveredCalls(), 2);
+    XCTAssertEqual(aggregator.GetNumberSavedCalls(), aggregator.GetNumberPostedCalls() - aggregator.GetNumberDeliveredCalls());
+    aggregator.Dump();
+
+    box->Deactivate();
+    CAObjectMap::UnmapObject(objectId, box);
+}
+#endif
+
+@end
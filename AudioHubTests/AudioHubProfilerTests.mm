@@ -0,0 +1,164 @@
+//
+//  AudioHubProfilerTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <CoreAudio/AudioServerPlugIn.h>
+#if !ULTRASCHALL
+#if !TEST
+#include "AudioHubTypes.h"
+#else
+#include "AudioHubTestTypes.h"
+#endif
+#else
+#if !TEST
+#include "UltraschallHubTypes.h"
+#else
+#include "UltraschallHubTestTypes.h"
+#endif
+#endif
+#include "Profiler.h"
+#include "CARealTimeChecker.h"
+#include "CAHALAudioObjectTester.h"
+#include "CAPropertyAddress.h"
+#include "Box.h"
+#include <thread>
+
+@interface AudioHubProfilerTests : XCTestCase
+@property bool wasEnabled;
+@end
+
+@implementation AudioHubProfilerTests
+
+- (void)setUp {
+    [super setUp];
+    _wasEnabled = Profiler::IsEnabled();
+    Profiler::Reset();
+}
+
+- (void)tearDown {
+    Profiler::SetEnabled(_wasEnabled);
+    [super tearDown];
+}
+
+- (void)testDisabledScopeRecordsNothing {
+    Profiler::SetEnabled(false);
+    {
+        ProfileScope(kProfilerPoint_GetPropertyData);
+    }
+    Profiler::PointStatistics statistics;
+    XCTAssertFalse(Profiler::GetPointStatistics(kProfilerPoint_GetPropertyData, statistics));
+}
+
+- (void)testEnabledScopeRecords {
+    Profiler::SetEnabled(true);
+    for (int i = 0; i < 10; ++i) {
+        ProfileScope(kProfilerPoint_GetPropertyData);
+        usleep(100);
+    }
+    Profiler::PointStatistics statistics;
+    XCTAssert(Profiler::GetPointStatistics(kProfilerPoint_GetPropertyData, statistics));
+    XCTAssertEqual(statistics.mCount, 10);
+    XCTAssertGreaterThanOrEqual(statistics.mTotalNanos, 10 * 100 * 1000ULL);
+    XCTAssertLessThanOrEqual(statistics.mP50Nanos, statistics.mP99Nanos);
+    XCTAssertGreaterThanOrEqual(statistics.mP99Nanos * 2, statistics.mMaximumNanos);
+}
+
+- (void)testThreadsAreAggregated {
+    Profiler::SetEnabled(true);
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t) {
+        for (int i = 0; i < 1000; ++i) {
+            Profiler::Record(kProfilerPoint_DoIOOperation, 100);
+        }
+    });
+    Profiler::PointStatistics statistics;
+    XCTAssert(Profiler::GetPointStatistics(kProfilerPoint_DoIOOperation, statistics));
+    XCTAssertEqual(statistics.mCount, 8000);
+}
+
+- (void)testExitedThreadsGiveTheirRecordsBack {
+    Profiler::SetEnabled(true);
+    const UInt32 numberThreads = 2 * Profiler::kMaximumNumberThreadRecords;
+    for (UInt32 i = 0; i < numberThreads; ++i) {
+        std::thread thread([] {
+            Profiler::Record(kProfilerPoint_DoIOOperation, 100);
+        });
+        thread.join();
+    }
+    Profiler::PointStatistics statistics;
+    XCTAssert(Profiler::GetPointStatistics(kProfilerPoint_DoIOOperation, statistics));
+    XCTAssertEqual(statistics.mCount, numberThreads);
+}
+
+//  the first scope on a new IO thread must not allocate its record
+- (void)testNewThreadRecordsWithoutAllocating {
+    Profiler::SetEnabled(true);
+    CARealTimeChecker::ResetViolations();
+    UInt32 numberViolations = 0;
+    std::thread thread([&numberViolations] {
+        CARealTimeChecker::BeginScope();
+        {
+            ProfileScope(kProfilerPoint_BeginIOOperation);
+        }
+        CARealTimeChecker::EndScope();
+        numberViolations = CARealTimeChecker::GetNumberViolations();
+    });
+    thread.join();
+    XCTAssertEqual(numberViolations, 0);
+    Profiler::PointStatistics statistics;
+    XCTAssert(Profiler::GetPointStatistics(kProfilerPoint_BeginIOOperation, statistics));
+}
+
+#if !ULTRASCHALL
+- (void)testAudioHubCustomPropertyProfile {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    CAObject *box = new Box(objectId);
+    CAObjectMap::MapObject(objectId, box);
+    box->Activate();
+
+    CAHALAudioObjectTester tester(box);
+    CAPropertyAddress address(kAudioHubCustomPropertyProfile);
+    XCTAssert(tester.HasProperty(address));
+    XCTAssert(tester.IsPropertySettable(address));
+
+    tester.SetPropertyData_CFType(address, kCFBooleanTrue);
+    XCTAssert(Profiler::IsEnabled());
+    Profiler::Record(kProfilerPoint_StartIO, 1000);
+
+    CFDictionaryRef report = (CFDictionaryRef)tester.GetPropertyData_CFType(address);
+    XCTAssert(report != NULL);
+    NSDictionary *startIO = ((__bridge NSDictionary *)report)[@"AudioHub_StartIO"];
+    XCTAssertEqualObjects(startIO[@"Count"], @1);
+    CFRelease(report);
+
+    tester.SetPropertyData_CFType(address, kCFBooleanFalse);
+    XCTAssertFalse(Profiler::IsEnabled());
+
+    box->Deactivate();
+    CAObjectMap::UnmapObject(objectId, box);
+}
+#endif
+
+- (void)testPerformanceDisabledScope {
+    Profiler::SetEnabled(false);
+    [self measureBlock:^{
+        for (int i = 0; i < 10000000; ++i) {
+            ProfileScope(kProfilerPoint_DoIOOperation);
+        }
+    }];
+}
+
+- (void)testPerformanceEnabledScope {
+    Profiler::SetEnabled(true);
+    [self measureBlock:^{
+        for (int i = 0; i < 1000000; ++i) {
+            ProfileScope(kProfilerPoint_DoIOOperation);
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,188 @@
+//
+//  AudioHubRealTimeCheckerTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <CoreAudio/AudioServerPlugIn.h>
+#if !ULTRASCHALL
+#if !TEST
+#include "AudioHubTypes.h"
+#else
+#include "AudioHubTestTypes.h"
+#endif
+#else
+#if !TEST
+#include "UltraschallHubTypes.h"
+#else
+#include "UltraschallHubTestTypes.h"
+#endif
+#endif
+#include "AutomationQueue.h"
+#include "CAException.h"
+#include "CAMutex.h"
+#include "CARealTimeChecker.h"
+#include "CASharedMutex.h"
+#include "Device.h"
+#include "Profiler.h"
+#include "AudioHubSimulatedIODriver.h"
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+//  keeps the compiler from taking out an allocation that is freed right away
+static void *volatile sKeptBlock = NULL;
+
+static std::vector<CARealTimeChecker::ViolationKind> GetViolationKinds() {
+    std::vector<CARealTimeChecker::ViolationKind> kinds;
+    for (UInt32 i = 0; i < CARealTimeChecker::GetNumberViolations(); ++i) {
+        CARealTimeChecker::Violation violation;
+        if (CARealTimeChecker::GetViolation(i, violation)) {
+            kinds.push_back(violation.mKind);
+        }
+    }
+    return kinds;
+}
+
+@interface AudioHubRealTimeCheckerTests : XCTestCase
+
+@end
+
+@implementation AudioHubRealTimeCheckerTests
+
+- (void)setUp {
+    [super setUp];
+    CARealTimeChecker::ResetViolations();
+}
+
+- (void)tearDown {
+    CARealTimeChecker::ResetViolations();
+    [super tearDown];
+}
+
+- (void)testNothingIsReportedOutsideAScope {
+    sKeptBlock = malloc(16);
+    free(sKeptBlock);
+    CAMutex mutex("RealTimeChecker Test");
+    mutex.Lock();
+    mutex.Unlock();
+    XCTAssertFalse(CARealTimeChecker::IsInScope());
+    XCTAssertEqual(CARealTimeChecker::GetNumberViolations(), 0);
+}
+
+//  no assertions inside the scopes, a failing one would report itself
+- (void)testViolationsAreReported {
+    CAMutex mutex("RealTimeChecker Test");
+    CASharedMutex sharedMutex("RealTimeChecker Shared Test");
+
+    CARealTimeChecker::BeginScope();
+    bool wasInScope = CARealTimeChecker::IsInScope();
+    sKeptBlock = malloc(16);
+    CARealTimeChecker::EndScope();
+
+    CARealTimeChecker::BeginScope();
+    free(sKeptBlock);
+    mutex.Lock();
+    mutex.Unlock();
+    sharedMutex.LockShared();
+    sharedMutex.UnlockShared();
+    //  trying never waits, so it is fine
+    bool wasLocked = false;
+    if (mutex.Try(wasLocked) && wasLocked) {
+        mutex.Unlock();
+    }
+    CARealTimeChecker::EndScope();
+
+    XCTAssertTrue(wasInScope);
+    XCTAssertFalse(CARealTimeChecker::IsInScope());
+    const std::vector<CARealTimeChecker::ViolationKind> expected = {
+        CARealTimeChecker::kViolation_Allocation, CARealTimeChecker::kViolation_Deallocation, CARealTimeChecker::kViolation_Lock, CARealTimeChecker::kViolation_Lock,
+    };
+    XCTAssert(GetViolationKinds() == expected);
+
+    CARealTimeChecker::Violation violation;
+    XCTAssert(CARealTimeChecker::GetViolation(2, violation));
+    XCTAssertEqual(strcmp(violation.mWhat, "RealTimeChecker Test"), 0);
+    XCTAssertGreaterThan(violation.mNumberFrames, 1);
+    CARealTimeChecker::DumpViolations();
+}
+
+- (void)testThrowingIsReported {
+    CARealTimeChecker::BeginScope();
+    try {
+        Throw(CAException(kAudioHardwareUnspecifiedError));
+    } catch (const CAException &) {
+    }
+    CARealTimeChecker::EndScope();
+    XCTAssertGreaterThan(CARealTimeChecker::GetNumberViolations(), 0);
+}
+
+- (void)testScopesNestAndStayOnTheirThread {
+    std::atomic<bool> isInScope(false), isDone(false);
+    std::thread thread([&isInScope, &isDone] {
+        while (!isInScope.load()) {
+        }
+        for (UInt32 i = 0; i < 100; ++i) {
+            sKeptBlock = malloc(64);
+            free(sKeptBlock);
+        }
+        isDone.store(true);
+    });
+
+    CARealTimeChecker::BeginScope();
+    CARealTimeChecker::BeginScope();
+    CARealTimeChecker::EndScope();
+    bool isStillInScope = CARealTimeChecker::IsInScope();
+    isInScope.store(true);
+    while (!isDone.load()) {
+    }
+    CARealTimeChecker::EndScope();
+    thread.join();
+
+    XCTAssertTrue(isStillInScope);
+    XCTAssertFalse(CARealTimeChecker::IsInScope());
+    XCTAssertEqual(CARealTimeChecker::GetNumberViolations(), 0);
+}
+
+- (void)testReportsBeyondTheLogAreCounted {
+    CARealTimeChecker::BeginScope();
+    for (UInt32 i = 0; i < CARealTimeChecker::kMaximumNumberViolations; ++i) {
+        sKeptBlock = malloc(16);
+        free(sKeptBlock);
+    }
+    CARealTimeChecker::EndScope();
+    XCTAssertEqual(CARealTimeChecker::GetNumberViolations(), 2 * CARealTimeChecker::kMaximumNumberViolations);
+    CARealTimeChecker::Violation violation;
+    XCTAssert(CARealTimeChecker::GetViolation(CARealTimeChecker::kMaximumNumberViolations - 1, violation));
+    XCTAssertFalse(CARealTimeChecker::GetViolation(CARealTimeChecker::kMaximumNumberViolations, violation));
+}
+
+//  runs every stage of the IO path from the driver's entry points on, with the profiler, automation,
+//  the analyzer and the noise reducer, and fails on anything that could block the IO thread
+- (void)testIOPathIsRealTimeSafe {
+    bool wasProfilerEnabled = Profiler::IsEnabled();
+    Profiler::SetEnabled(true);
+    SimulatedIODriver driver(20.0f);
+    driver.GetDevice()->SetSpectrumAnalyzerEnabled(true);
+    AutomationQueue::Event events[] = {
+        { 100.0, AutomationQueue::kParameterInputVolume, 0.5f },
+        { 3000.0, AutomationQueue::kParameterOutputVolume, 0.25f },
+        { 9000.0, AutomationQueue::kParameterInputVolume, 1.0f },
+    };
+    driver.GetDevice()->ScheduleAutomation(events, 3);
+
+    driver.RunCycles(64);
+    Profiler::SetEnabled(wasProfilerEnabled);
+    XCTAssertEqual(driver.GetNumberFailedCalls(), 0);
+    XCTAssertEqual(CARealTimeChecker::GetNumberViolations(), 0);
+    if (CARealTimeChecker::GetNumberViolations() != 0) {
+        CARealTimeChecker::DumpViolations();
+    }
+}
+
+@end
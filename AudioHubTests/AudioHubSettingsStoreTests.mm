@@ -0,0 +1,95 @@
+//
+//  AudioHubSettingsStoreTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include "SettingsStore.h"
+
+static SInt32 sSettingsValue = 0;
+static UInt32 sNumberStorageWrites = 0;
+
+static CFPropertyListRef CopyTestSettings(void * /*inClientData*/) {
+    CFNumberRef theValue = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &sSettingsValue);
+    const void *theKeys[] = { CFSTR("value") };
+    const void *theValues[] = { theValue };
+    CFDictionaryRef theSettings = CFDictionaryCreate(kCFAllocatorDefault, theKeys, theValues, 1, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    CFRelease(theValue);
+    return theSettings;
+}
+
+static void WriteTestSettings(void * /*inClientData*/, CFPropertyListRef /*inSettings*/) {
+    ++sNumberStorageWrites;
+}
+
+@interface AudioHubSettingsStoreTests : XCTestCase
+
+@end
+
+@implementation AudioHubSettingsStoreTests
+
+- (void)setUp {
+    [super setUp];
+    sSettingsValue = 0;
+    sNumberStorageWrites = 0;
+}
+
+- (void)tearDown {
+    [super tearDown];
+}
+
+- (void)testBurstOfChangesIsDebounced {
+    static SettingsStore store(CopyTestSettings, WriteTestSettings, NULL, 50 * 1000 * 1000, 5000ULL * 1000 * 1000);
+    store.ResetStatistics();
+    for (SInt32 i = 0; i < 1000; ++i) {
+        sSettingsValue = i;
+        store.MarkDirty();
+    }
+    XCTAssertEqual(sNumberStorageWrites, 0);
+    XCTAssert(store.IsDirty());
+
+    for (int i = 0; i < 200 && store.IsDirty(); ++i) {
+        usleep(10 * 1000);
+    }
+    XCTAssertFalse(store.IsDirty());
+    XCTAssertEqual(store.GetNumberDirtyMarks(), 1000);
+    XCTAssertEqual(sNumberStorageWrites, 1);
+    XCTAssertEqual(store.GetNumberWrites(), 1);
+}
+
+- (void)testUnchangedSettingsAreSkipped {
+    SettingsStore store(CopyTestSettings, WriteTestSettings, NULL, 0);
+    store.MarkDirty();
+    store.MarkDirty();
+    store.MarkDirty();
+    XCTAssertEqual(sNumberStorageWrites, 1);
+    XCTAssertEqual(store.GetNumberSkippedWrites(), 2);
+
+    sSettingsValue = 1;
+    store.MarkDirty();
+    XCTAssertEqual(sNumberStorageWrites, 2);
+
+    store.Invalidate();
+    store.MarkDirty();
+    XCTAssertEqual(sNumberStorageWrites, 3);
+}
+
+- (void)testFlushWritesPendingChanges {
+    static SettingsStore store(CopyTestSettings, WriteTestSettings, NULL);
+    store.ResetStatistics();
+    store.Invalidate();
+    store.MarkDirty();
+    store.Flush();
+    XCTAssertFalse(store.IsDirty());
+    XCTAssertEqual(sNumberStorageWrites, 1);
+
+    //  nothing is dirty any more, so a second flush and the scheduled write are no-ops
+    store.Flush();
+    XCTAssertEqual(sNumberStorageWrites, 1);
+}
+
+@end
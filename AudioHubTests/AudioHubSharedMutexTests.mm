@@ -0,0 +1,206 @@
+//
+//  AudioHubSharedMutexTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAPropertyAddress.h"
+#include "CAHostTimeBase.h"
+#include "CASharedMutex.h"
+#include "Device.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+@interface AudioHubSharedMutexTests : XCTestCase
+
+@end
+
+@implementation AudioHubSharedMutexTests
+
+- (void)testReadersDontWaitForEachOther {
+    CASharedMutex mutex("AudioHubSharedMutexTests");
+    CASharedMutex::SharedLocker locker(mutex);
+    bool otherReaderGotIt = false;
+    std::thread([&] {
+        CASharedMutex::SharedLocker otherLocker(mutex);
+        otherReaderGotIt = mutex.GetNumberReaders() == 2;
+    }).join();
+    XCTAssert(otherReaderGotIt);
+}
+
+- (void)testWriterWaitsForReaders {
+    CASharedMutex mutex("AudioHubSharedMutexTests");
+    std::atomic<bool> didWrite(false);
+    XCTAssert(mutex.LockShared());
+    std::thread writer([&] {
+        CAMutex::Locker locker(mutex);
+        didWrite = true;
+    });
+    usleep(20 * 1000);
+    XCTAssertFalse(didWrite.load());
+
+    //  a writer can't sneak in through Try either
+    bool wasLocked = true;
+    std::thread([&] {
+        mutex.Try(wasLocked);
+    }).join();
+    XCTAssertFalse(wasLocked);
+
+    mutex.UnlockShared();
+    writer.join();
+    XCTAssert(didWrite.load());
+    XCTAssert(mutex.IsFree());
+}
+
+- (void)testWriterCanRead {
+    CASharedMutex mutex("AudioHubSharedMutexTests");
+    XCTAssert(mutex.Lock());
+    XCTAssertFalse(mutex.Lock());
+    {
+        //  taking it shared while holding it exclusively does nothing
+        CASharedMutex::SharedLocker locker(mutex);
+        XCTAssertEqual(mutex.GetNumberReaders(), 0);
+    }
+    mutex.Unlock();
+    XCTAssert(mutex.IsFree());
+}
+
+- (void)testReadersSeeConsistentState {
+    CASharedMutex mutex("AudioHubSharedMutexTests", CAMutex::kDefaultSpinCount);
+    UInt64 state[2] = { 0, 0 };
+    std::atomic<bool> isDone(false);
+    std::atomic<UInt32> numberTornReads(0);
+
+    std::vector<std::thread> readers;
+    for (UInt32 reader = 0; reader < 4; ++reader) {
+        readers.push_back(std::thread([&] {
+            while (!isDone) {
+                CASharedMutex::SharedLocker locker(mutex);
+                if (state[0] != state[1]) {
+                    ++numberTornReads;
+                }
+            }
+        }));
+    }
+    for (UInt64 value = 1; value <= 10000; ++value) {
+        CAMutex::Locker locker(mutex);
+        state[0] = value;
+        state[1] = value;
+    }
+    isDone = true;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+    XCTAssertEqual(numberTornReads.load(), 0);
+}
+
+- (void)testDevicePropertyReadsDuringIO {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    Device *device = new Device(objectId);
+    CAObjectMap::MapObject(objectId, device);
+    device->Activate();
+
+    //  readers keep reading while another thread starts and stops IO
+    std::atomic<bool> isDone(false);
+    std::atomic<UInt32> numberBadReads(0);
+    std::vector<std::thread> readers;
+    for (UInt32 reader = 0; reader < 4; ++reader) {
+        readers.push_back(std::thread([&] {
+            CAPropertyAddress address(kAudioDevicePropertyNominalSampleRate);
+            while (!isDone) {
+                Float64 sampleRate = 0;
+                UInt32 size = 0;
+                device->GetPropertyData(objectId, 0, address, 0, NULL, sizeof(Float64), size, &sampleRate);
+                if ((size != sizeof(Float64)) || (sampleRate <= 0)) {
+                    ++numberBadReads;
+                }
+            }
+        }));
+    }
+    for (UInt32 cycle = 0; cycle < 100; ++cycle) {
+        device->StartIO();
+        device->StopIO();
+    }
+    isDone = true;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+    XCTAssertEqual(numberBadReads.load(), 0);
+
+    device->Deactivate();
+    CAObjectMap::UnmapObject(objectId, device);
+}
+
+#pragma mark Performance
+
+//  logs how many property reads per second 1 to 16 threads get out of one device
+- (void)testPerformanceDevicePropertyReads {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    Device *device = new Device(objectId);
+    CAObjectMap::MapObject(objectId, device);
+    device->Activate();
+
+    [self measureBlock:^{
+        for (UInt32 numberThreads = 1; numberThreads <= 16; numberThreads *= 2) {
+            const UInt32 numberReadsPerThread = (1 << 18) / numberThreads;
+            UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+            std::vector<std::thread> threads;
+            for (UInt32 thread = 0; thread < numberThreads; ++thread) {
+                threads.push_back(std::thread([=] {
+                    const CAPropertyAddress addresses[] = { CAPropertyAddress(kAudioDevicePropertyNominalSampleRate), CAPropertyAddress(kAudioDevicePropertyDeviceIsRunning) };
+                    for (UInt32 i = 0; i < numberReadsPerThread; ++i) {
+                        UInt64 data = 0;
+                        UInt32 size = 0;
+                        device->GetPropertyData(objectId, 0, addresses[i & 1], 0, NULL, sizeof(data), size, &data);
+                    }
+                }));
+            }
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+            Float64 seconds = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) / 1e9;
+            NSLog(@"device property reads, %2u threads: %6.2f million per second", numberThreads, numberReadsPerThread * numberThreads / seconds / 1e6);
+        }
+    }];
+
+    device->Deactivate();
+    CAObjectMap::UnmapObject(objectId, device);
+}
+
+//  the same short read under the lock taken shared and taken exclusively
+- (void)testPerformanceSharedAgainstExclusive {
+    [self measureBlock:^{
+        for (UInt32 numberThreads = 1; numberThreads <= 16; numberThreads *= 2) {
+            for (UInt32 shared = 0; shared < 2; ++shared) {
+                CASharedMutex mutex("AudioHubSharedMutexTests Benchmark", CAMutex::kDefaultSpinCount);
+                CASharedMutex *mutexPointer = &mutex;
+                const UInt32 numberReadsPerThread = (1 << 20) / numberThreads;
+                UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+                std::vector<std::thread> threads;
+                for (UInt32 thread = 0; thread < numberThreads; ++thread) {
+                    threads.push_back(std::thread([=] {
+                        for (UInt32 i = 0; i < numberReadsPerThread; ++i) {
+                            if (shared) {
+                                CASharedMutex::SharedLocker locker(mutexPointer);
+                            }
+                            else {
+                                CAMutex::Locker locker(mutexPointer);
+                            }
+                        }
+                    }));
+                }
+                for (std::thread &thread : threads) {
+                    thread.join();
+                }
+                UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+                NSLog(@"%-9s %2u threads: %6.1f ns per read", shared ? "shared" : "exclusive", numberThreads, (double)nanos / (numberReadsPerThread * numberThreads));
+            }
+        }
+    }];
+}
+
+@end
@@ -0,0 +1,102 @@
+//
+//  AudioHubSimulatedIODriver.h
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#ifndef AudioHubSimulatedIODriver_h
+#define AudioHubSimulatedIODriver_h
+
+#include <CoreAudio/AudioServerPlugIn.h>
+#include "CARealTimeChecker.h"
+#include "Device.h"
+#include "Factory.h"
+#include <algorithm>
+#include <vector>
+
+static const UInt32 kBufferFrameSize = 512;
+
+//  Drives a device the way the HAL does, through the entry points of the driver interface: every
+//  cycle gets the zero time stamp, mixes a buffer of ones into the device at the output time and
+//  reads the same frames back at the input time, and keeps what both saw. In test builds each cycle
+//  is a real time scope from the first call to the last, like the HAL's IO thread. The noise reducer
+//  is set up when IO starts, so its reduction is given here.
+class SimulatedIODriver {
+public:
+    explicit SimulatedIODriver(Float32 inNoiseReduction = 0.0f)
+            : mDriver(static_cast<AudioServerPlugInDriverRef>(AudioHub_Create(NULL, kAudioServerPlugInTypeUUID))),
+              mObjectID(CAObjectMap::GetNextObjectID()),
+              mDevice(new Device(mObjectID)),
+              mSampleTime(0),
+              mNumberFailedCalls(0) {
+        CAObjectMap::MapObject(mObjectID, mDevice);
+        mDevice->Activate();
+        mDevice->SetNoiseReduction(inNoiseReduction);
+        Call((*mDriver)->StartIO(mDriver, mObjectID, 0));
+    }
+
+    ~SimulatedIODriver() {
+        (*mDriver)->StopIO(mDriver, mObjectID, 0);
+        mDevice->Deactivate();
+        CAObjectMap::UnmapObject(mObjectID, mDevice);
+    }
+
+    Device *GetDevice() const { return mDevice; }
+
+    void RunCycles(UInt32 inNumberCycles) {
+        UInt32 numberChannels = mDevice->GetChannels();
+        std::vector<Float32> output(kBufferFrameSize * numberChannels);
+        std::vector<Float32> input(kBufferFrameSize * numberChannels);
+        for (UInt32 cycle = 0; cycle < inNumberCycles; ++cycle) {
+            std::fill(output.begin(), output.end(), 1.0f);
+            AudioServerPlugInIOCycleInfo cycleInfo = {};
+            cycleInfo.mOutputTime.mSampleTime = mSampleTime;
+            cycleInfo.mInputTime.mSampleTime = mSampleTime;
+
+            CARealTimeChecker::BeginScope();
+            Float64 zeroSampleTime = 0;
+            UInt64 zeroHostTime = 0;
+            UInt64 seed = 0;
+            Call((*mDriver)->GetZeroTimeStamp(mDriver, mObjectID, 0, &zeroSampleTime, &zeroHostTime, &seed));
+            RunOperation(kAudioServerPlugInIOOperationWriteMix, cycleInfo, &output[0]);
+            RunOperation(kAudioServerPlugInIOOperationReadInput, cycleInfo, &input[0]);
+            CARealTimeChecker::EndScope();
+
+            mWritten.insert(mWritten.end(), output.begin(), output.end());
+            mRead.insert(mRead.end(), input.begin(), input.end());
+            mSampleTime += kBufferFrameSize;
+        }
+    }
+
+    //  the gain the device applied to channel 0 of a frame, on the way in and on the way out
+    Float32 GetWriteGain(UInt32 inFrame) const { return mWritten[inFrame * mDevice->GetChannels()]; }
+    Float32 GetReadGain(UInt32 inFrame) const { return mRead[inFrame * mDevice->GetChannels()]; }
+
+    //  the calls into the driver that returned an error
+    UInt32 GetNumberFailedCalls() const { return mNumberFailedCalls; }
+
+private:
+    void RunOperation(UInt32 inOperationID, const AudioServerPlugInIOCycleInfo &inCycleInfo, Float32 *ioBuffer) {
+        Call((*mDriver)->BeginIOOperation(mDriver, mObjectID, 0, inOperationID, kBufferFrameSize, &inCycleInfo));
+        Call((*mDriver)->DoIOOperation(mDriver, mObjectID, 0, 0, inOperationID, kBufferFrameSize, &inCycleInfo, ioBuffer, NULL));
+        Call((*mDriver)->EndIOOperation(mDriver, mObjectID, 0, inOperationID, kBufferFrameSize, &inCycleInfo));
+    }
+
+    void Call(OSStatus inStatus) {
+        if (inStatus != 0) {
+            ++mNumberFailedCalls;
+        }
+    }
+
+    AudioServerPlugInDriverRef mDriver;
+    AudioObjectID mObjectID;
+    Device *mDevice;
+    Float64 mSampleTime;
+    UInt32 mNumberFailedCalls;
+    std::vector<Float32> mWritten;
+    std::vector<Float32> mRead;
+};
+
+#endif /* AudioHubSimulatedIODriver_h */
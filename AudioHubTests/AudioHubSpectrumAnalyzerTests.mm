@@ -0,0 +1,230 @@
+//
+//  AudioHubSpectrumAnalyzerTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include <CoreAudio/AudioServerPlugIn.h>
+#if !ULTRASCHALL
+#if !TEST
+#include "AudioHubTypes.h"
+#else
+#include "AudioHubTestTypes.h"
+#endif
+#else
+#if !TEST
+#include "UltraschallHubTypes.h"
+#else
+#include "UltraschallHubTestTypes.h"
+#endif
+#endif
+#include "CAHALAudioObjectTester.h"
+#include "CAPropertyAddress.h"
+#include "CAHostTimeBase.h"
+#include "Device.h"
+#include "SpectrumAnalyzer.h"
+#include <atomic>
+#include <math.h>
+#include <thread>
+#include <vector>
+
+@interface AudioHubSpectrumAnalyzerTests : XCTestCase
+
+@end
+
+@implementation AudioHubSpectrumAnalyzerTests
+
+//  long enough that the timer never fires while a test calls Analyze itself
+static const UInt64 kManualInterval = 3600ULL * 1000 * 1000 * 1000;
+
+static void FillSine(std::vector<Float32>& outBuffer, UInt32 inNumberChannels, UInt64 inFirstFrame, Float64 inFrequency, Float64 inSampleRate) {
+    UInt32 numberFrames = (UInt32)(outBuffer.size() / inNumberChannels);
+    for (UInt32 frame = 0; frame < numberFrames; ++frame) {
+        Float32 value = 0.5f * (Float32)sin(2.0 * M_PI * inFrequency * (inFirstFrame + frame) / inSampleRate);
+        for (UInt32 channel = 0; channel < inNumberChannels; ++channel) {
+            outBuffer[frame * inNumberChannels + channel] = channel == 0 ? value : 0.0f;
+        }
+    }
+}
+
+- (void)testSinePeaksInItsBand {
+    SpectrumAnalyzer analyzer(2, 48000.0);
+    analyzer.SetEnabled(true, kManualInterval);
+    std::vector<Float32> buffer(512 * 2);
+    for (UInt32 block = 0; block < 32; ++block) {
+        FillSine(buffer, 2, block * 512, 1000.0, 48000.0);
+        analyzer.Write(&buffer[0], 512);
+        if (block % 4 == 3) {
+            analyzer.Analyze();
+        }
+    }
+    XCTAssertEqual(analyzer.GetNumberDroppedBlocks(), 0);
+    XCTAssertGreaterThan(analyzer.GetNumberFrames(), 0);
+
+    CFDictionaryRef frame = analyzer.CopyFrame();
+    NSDictionary *dictionary = (__bridge NSDictionary *)frame;
+    XCTAssertEqual([dictionary[@"Channels"] unsignedIntValue], 2);
+    XCTAssertEqual([dictionary[@"Frequencies"] count], SpectrumAnalyzer::kNumberBands);
+    NSData *magnitudes = dictionary[@"Magnitudes"];
+    XCTAssertEqual(magnitudes.length, 2 * SpectrumAnalyzer::kNumberBands * sizeof(Float32));
+
+    const Float32 *values = (const Float32 *)magnitudes.bytes;
+    UInt32 peak = 0;
+    for (UInt32 band = 1; band < SpectrumAnalyzer::kNumberBands; ++band) {
+        if (values[band] > values[peak]) {
+            peak = band;
+        }
+    }
+    XCTAssertEqualWithAccuracy(analyzer.GetBandFrequency(peak), 1000.0, 200.0);
+    XCTAssertEqualWithAccuracy(values[peak], -6.0, 1.5);
+    for (UInt32 band = 0; band < SpectrumAnalyzer::kNumberBands; ++band) {
+        XCTAssertLessThan(values[SpectrumAnalyzer::kNumberBands + band], -100.0);
+    }
+    CFRelease(frame);
+}
+
+- (void)testFullRingDropsBlocks {
+    SpectrumAnalyzer analyzer(2, 48000.0);
+    std::vector<Float32> buffer(512 * 2);
+    analyzer.Write(&buffer[0], 512);
+    XCTAssertEqual(analyzer.GetNumberWrittenBlocks(), 0);
+
+    analyzer.SetEnabled(true, kManualInterval);
+    for (UInt32 block = 0; block < SpectrumAnalyzer::kNumberSlots + 4; ++block) {
+        analyzer.Write(&buffer[0], 512);
+    }
+    XCTAssertEqual(analyzer.GetNumberWrittenBlocks(), SpectrumAnalyzer::kNumberSlots);
+    XCTAssertEqual(analyzer.GetNumberDroppedBlocks(), 4);
+    analyzer.Analyze();
+    analyzer.Write(&buffer[0], 512);
+    XCTAssertEqual(analyzer.GetNumberWrittenBlocks(), SpectrumAnalyzer::kNumberSlots + 1);
+}
+
+#if !ULTRASCHALL
+- (void)testDeviceProperty {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    Device *device = new Device(objectId);
+    CAObjectMap::MapObject(objectId, device);
+    device->Activate();
+
+    CAHALAudioObjectTester tester(device);
+    CAPropertyAddress address(kAudioHubCustomPropertySpectrum);
+    XCTAssert(tester.HasProperty(address));
+    XCTAssert(tester.IsPropertySettable(address));
+
+    CFDictionaryRef frame = (CFDictionaryRef)tester.GetPropertyData_CFType(address);
+    XCTAssertEqual(CFDictionaryGetCount(frame), 0);
+    CFRelease(frame);
+    XCTAssert(device->GetSpectrumAnalyzer() == nullptr);
+
+    tester.SetPropertyData_CFType(address, kCFBooleanTrue);
+    SpectrumAnalyzer *analyzer = device->GetSpectrumAnalyzer();
+    XCTAssert(analyzer != nullptr);
+    XCTAssert(analyzer->IsEnabled());
+    XCTAssertEqual(analyzer->GetNumberChannels(), device->GetChannels());
+
+    //  drive the device like the HAL does and wait for the timer to publish
+    device->StartIO();
+    UInt32 numberChannels = device->GetChannels();
+    std::vector<Float32> buffer(512 * numberChannels);
+    AudioServerPlugInIOCycleInfo cycleInfo = {};
+    for (UInt32 block = 0; block < 16; ++block) {
+        FillSine(buffer, numberChannels, block * 512, 1000.0, analyzer->GetSampleRate());
+        cycleInfo.mOutputTime.mSampleTime = block * 512;
+        device->DoIOOperation(0, kAudioServerPlugInIOOperationWriteMix, 512, cycleInfo, &buffer[0], NULL);
+        usleep(10000);
+    }
+    device->StopIO();
+    for (UInt32 wait = 0; (wait < 100) && (analyzer->GetNumberFrames() == 0); ++wait) {
+        usleep(10000);
+    }
+    XCTAssertGreaterThan(analyzer->GetNumberFrames(), 0);
+
+    frame = (CFDictionaryRef)tester.GetPropertyData_CFType(address);
+    XCTAssertEqual([((__bridge NSDictionary *)frame)[@"Channels"] unsignedIntValue], numberChannels);
+    CFRelease(frame);
+
+    tester.SetPropertyData_CFType(address, kCFBooleanFalse);
+    XCTAssertFalse(device->GetSpectrumAnalyzer()->IsEnabled());
+    XCTAssertThrows(tester.SetPropertyData_CFType(address, CFSTR("YES")));
+
+    device->Deactivate();
+    CAObjectMap::UnmapObject(objectId, device);
+}
+
+- (void)testPropertyReadWhileSampleRateChanges {
+    AudioObjectID objectId = CAObjectMap::GetNextObjectID();
+    Device *device = new Device(objectId);
+    CAObjectMap::MapObject(objectId, device);
+    device->Activate();
+
+    CAHALAudioObjectTester tester(device);
+    CAPropertyAddress address(kAudioHubCustomPropertySpectrum);
+    tester.SetPropertyData_CFType(address, kCFBooleanTrue);
+
+    //  every change replaces the analyzer while the reader copies frames from it
+    std::atomic<bool> isDone(false);
+    std::atomic<UInt32> numberReads(0);
+    CAHALAudioObjectTester *testerPointer = &tester;
+    std::thread reader([&isDone, &numberReads, testerPointer, address] {
+        while (!isDone.load()) {
+            CFDictionaryRef frame = (CFDictionaryRef)testerPointer->GetPropertyData_CFType(address);
+            if (frame != NULL) {
+                CFRelease(frame);
+            }
+            numberReads.fetch_add(1);
+        }
+    });
+    while (numberReads.load() == 0) {
+        usleep(100);
+    }
+    const Float64 sampleRates[] = { 44100.0, 48000.0, 96000.0 };
+    for (UInt32 change = 0; change < 300; ++change) {
+        device->PerformConfigChange(kHub_SampleRateChange, new Float64(sampleRates[change % 3]));
+    }
+    isDone.store(true);
+    reader.join();
+
+    SpectrumAnalyzer *analyzer = device->GetSpectrumAnalyzer();
+    XCTAssertEqual(analyzer->GetSampleRate(), sampleRates[299 % 3]);
+    XCTAssert(analyzer->IsEnabled());
+
+    device->Deactivate();
+    CAObjectMap::UnmapObject(objectId, device);
+}
+#endif
+
+#pragma mark Performance
+
+//  the IO thread's share of the analyzer: one Write per cycle, 512 frames of 32 channels
+- (void)testPerformanceWrite {
+    const UInt32 numberChannels = 32;
+    const UInt32 iterations = 4000;
+    SpectrumAnalyzer analyzer(numberChannels, 48000.0);
+    analyzer.SetEnabled(true, kManualInterval);
+    std::vector<Float32> buffer(512 * numberChannels);
+    FillSine(buffer, numberChannels, 0, 1000.0, 48000.0);
+    SpectrumAnalyzer *analyzerPointer = &analyzer;
+    const Float32 *data = &buffer[0];
+    [self measureBlock:^{
+        UInt64 total = 0, worst = 0;
+        for (UInt32 i = 0; i < iterations; ++i) {
+            UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+            analyzerPointer->Write(data, 512);
+            UInt64 elapsed = CAHostTimeBase::GetTheCurrentTime() - start;
+            total += elapsed;
+            worst = std::max(worst, elapsed);
+            //  the analysis is off the clock, it runs on the analyzer's queue in the driver
+            if (i % SpectrumAnalyzer::kNumberSlots == SpectrumAnalyzer::kNumberSlots - 1) {
+                analyzerPointer->Analyze();
+            }
+        }
+        NSLog(@"spectrum analyzer write: %6.0f ns mean, %llu ns worst", (double)CAHostTimeBase::ConvertToNanos(total) / iterations, CAHostTimeBase::ConvertToNanos(worst));
+    }];
+    XCTAssertEqual(analyzer.GetNumberDroppedBlocks(), 0);
+}
+
+@end
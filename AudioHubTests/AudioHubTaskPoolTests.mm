@@ -0,0 +1,188 @@
+//
+//  AudioHubTaskPoolTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CATaskPool.h"
+#include "CADispatchQueue.h"
+#include "CAHostTimeBase.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+@interface AudioHubTaskPoolTests : XCTestCase
+
+@end
+
+@implementation AudioHubTaskPoolTests
+
+static std::atomic<UInt32> sCount(0);
+
+static void Increment(void* inContext) {
+    sCount.fetch_add(1);
+}
+
+static void WaitFor(std::atomic<UInt32>* inCounter, UInt32 inValue) {
+    while (inCounter->load() < inValue) {
+        usleep(100);
+    }
+}
+
+- (void)testEveryTaskRunsOnce {
+    CATaskPool pool(4);
+    XCTAssertEqual(pool.GetNumberWorkers(), 4);
+    sCount = 0;
+    for (UInt32 i = 0; i < 100000; ++i) {
+        pool.Dispatch(false, NULL, Increment);
+    }
+    WaitFor(&sCount, 100000);
+    pool.Dispatch(true, NULL, Increment);
+    XCTAssertEqual(sCount.load(), 100001);
+}
+
+- (void)testIdleWorkersSteal {
+    CATaskPool pool(4);
+    CATaskPool *poolPointer = &pool;
+    std::atomic<UInt32> leaves(0);
+    std::atomic<UInt32> *leavesPointer = &leaves;
+    //  everything is dispatched from one worker, so the others only get work by stealing it
+    pool.Dispatch(false, ^{
+        for (UInt32 i = 0; i < 10000; ++i) {
+            poolPointer->Dispatch(false, ^{
+                volatile UInt32 sum = 0;
+                for (UInt32 k = 0; k < 1000; ++k) {
+                    sum += k;
+                }
+                leavesPointer->fetch_add(1);
+            });
+        }
+    });
+    WaitFor(&leaves, 10000);
+    XCTAssertGreaterThan(pool.GetNumberStolenTasks(), 0);
+}
+
+- (void)testStrandKeepsOrder {
+    CATaskPool pool(4);
+    CATaskPool::Strand strand(pool);
+    CATaskPool::Strand *strandPointer = &strand;
+    const UInt32 numberProducers = 4;
+    const UInt32 numberTasks = 20000;
+    std::vector<std::vector<UInt32>> seen(numberProducers);
+    std::vector<std::vector<UInt32>> *seenPointer = &seen;
+    std::atomic<UInt32> inside(0), overlaps(0);
+    std::atomic<UInt32> *insidePointer = &inside, *overlapsPointer = &overlaps;
+
+    dispatch_apply(numberProducers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t producer) {
+        for (UInt32 i = 0; i < numberTasks; ++i) {
+            strandPointer->Dispatch(false, ^{
+                if (insidePointer->fetch_add(1) != 0) {
+                    overlapsPointer->fetch_add(1);
+                }
+                (*seenPointer)[producer].push_back(i);
+                insidePointer->fetch_sub(1);
+            });
+        }
+    });
+    strand.Dispatch(true, ^{});
+
+    XCTAssertEqual(overlaps.load(), 0);
+    for (UInt32 producer = 0; producer < numberProducers; ++producer) {
+        XCTAssertEqual(seen[producer].size(), numberTasks);
+        XCTAssert(std::is_sorted(seen[producer].begin(), seen[producer].end()));
+    }
+}
+
+- (void)testSyncDispatchFromWorkers {
+    //  more waiting workers than there are workers, which only works if they help while they wait
+    CATaskPool pool(2);
+    CATaskPool::Strand strand(pool);
+    CATaskPool::Strand *strandPointer = &strand;
+    std::atomic<UInt32> done(0);
+    std::atomic<UInt32> *donePointer = &done;
+    for (UInt32 i = 0; i < 64; ++i) {
+        pool.Dispatch(false, ^{
+            strandPointer->Dispatch(true, ^{
+                donePointer->fetch_add(1);
+            });
+        });
+    }
+    WaitFor(&done, 64);
+}
+
+- (void)testDelayedDispatch {
+    CATaskPool pool(2);
+    CATaskPool::Strand strand(pool);
+    std::vector<UInt32> order;
+    std::vector<UInt32> *orderPointer = &order;
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < 10; ++i) {
+        strand.Dispatch((UInt64)(10 - i) * 2000000, ^{
+            orderPointer->push_back(i);
+        });
+    }
+    __block bool isDone = false;
+    while (!isDone) {
+        usleep(1000);
+        strand.Dispatch(true, ^{
+            isDone = orderPointer->size() == 10;
+        });
+    }
+    XCTAssertGreaterThanOrEqual(CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start), 20000000);
+    for (UInt32 i = 0; i < 10; ++i) {
+        XCTAssertEqual(order[i], 9 - i);
+    }
+
+    //  a strand takes its delayed tasks with it
+    sCount = 0;
+    {
+        CATaskPool::Strand doomed(pool);
+        doomed.Dispatch((UInt64)50000000, NULL, Increment);
+    }
+    usleep(80000);
+    XCTAssertEqual(sCount.load(), 0);
+}
+
+#pragma mark Performance
+
+static const UInt32 kNumberTasks = 100000;
+
+//  logs the time per task and the p50/p99 latency from dispatch to run
+static void Measure(const char *inName, void (^inDispatch)(void (^)(void)), void (^inDrain)(void)) {
+    std::vector<UInt64> latencies(kNumberTasks);
+    UInt64 *latency = &latencies[0];
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberTasks; ++i) {
+        UInt64 dispatched = CAHostTimeBase::GetTheCurrentTime();
+        inDispatch(^{
+            latency[i] = CAHostTimeBase::GetTheCurrentTime() - dispatched;
+        });
+    }
+    inDrain();
+    UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+    std::sort(latencies.begin(), latencies.end());
+    NSLog(@"%-16s %6.0f ns per task, latency p50 %8llu ns, p99 %8llu ns", inName, (double)nanos / kNumberTasks,
+          CAHostTimeBase::ConvertToNanos(latencies[kNumberTasks / 2]), CAHostTimeBase::ConvertToNanos(latencies[kNumberTasks * 99 / 100]));
+}
+
+- (void)testPerformanceAgainstSerialQueue {
+    CADispatchQueue queue("AudioHubTaskPoolTests");
+    CATaskPool pool;
+    CATaskPool::Strand strand(pool);
+    CADispatchQueue *queuePointer = &queue;
+    CATaskPool *poolPointer = &pool;
+    CATaskPool::Strand *strandPointer = &strand;
+    [self measureBlock:^{
+        Measure("serial queue", ^(void (^inTask)(void)) { queuePointer->Dispatch(false, inTask); }, ^{ queuePointer->Dispatch(true, ^{}); });
+        Measure("strand", ^(void (^inTask)(void)) { strandPointer->Dispatch(false, inTask); }, ^{ strandPointer->Dispatch(true, ^{}); });
+
+        std::atomic<UInt32> done(0);
+        std::atomic<UInt32> *donePointer = &done;
+        Measure("pool", ^(void (^inTask)(void)) { poolPointer->Dispatch(false, ^{ inTask(); donePointer->fetch_add(1); }); }, ^{ WaitFor(donePointer, kNumberTasks); });
+    }];
+}
+
+@end
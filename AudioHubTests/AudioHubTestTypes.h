@@ -26,15 +26,35 @@ static const CFStringRef kAudioHubDeviceModelUID = CFSTR("de.8plugs.audio.AudioH
 
 enum {
     kAudioHubCustomPropertySettings = 'ephs',
-    kAudioHubCustomPropertyActive = 'epha'
+    kAudioHubCustomPropertyActive = 'epha',
+    kAudioHubCustomPropertyProfile = 'ephp'
 };
-const UInt32 kAudioHubCustomProperties = 2;
+const UInt32 kAudioHubCustomProperties = 3;
+
+enum {
+    kAudioHubCustomPropertySpectrum = 'ephf',
+    kAudioHubCustomPropertyAutomation = 'epht'
+};
+const UInt32 kAudioHubDeviceCustomProperties = 2;
+
+//  kAudioHubCustomPropertyAutomation takes an array of events, each a dictionary with the device
+//  sample time the value lands on, the parameter and the scalar value
+enum {
+    kAudioHubAutomationParameterInputVolume = 0,
+    kAudioHubAutomationParameterOutputVolume = 1
+};
+static const CFStringRef kAudioHubAutomationKeySampleTime = CFSTR("SampleTime");
+static const CFStringRef kAudioHubAutomationKeyParameter = CFSTR("Parameter");
+static const CFStringRef kAudioHubAutomationKeyValue = CFSTR("Value");
+static const CFStringRef kAudioHubAutomationKeyScheduled = CFSTR("Scheduled");
+static const CFStringRef kAudioHubAutomationKeyFree = CFSTR("Free");
 
 static const CFStringRef kAudioHubSettingsKey = CFSTR("AudioHubSettings");
 static const CFStringRef kAudioHubSettingsKeyDevices = CFSTR("AudioHubDevices");
 static const CFStringRef kAudioHubSettingsKeyDeviceName = CFSTR("Name");
 static const CFStringRef kAudioHubSettingsKeyDeviceUID = CFSTR("UID");
 static const CFStringRef kAudioHubSettingsKeyDeviceChannels = CFSTR("Channels");
+static const CFStringRef kAudioHubSettingsKeyDeviceNoiseReduction = CFSTR("NoiseReduction");
 
 static const UInt32 kAudioHubMaximumDeviceChannels = 32;
 
@@ -0,0 +1,121 @@
+//
+//  AudioHubThreadTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAPThread.h"
+#include "CAHostTimeBase.h"
+#include <mach/mach_time.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+//  wakes up every millisecond and keeps how late each wakeup was
+struct Wakeups {
+    enum { kNumberWakeups = 2000 };
+
+    Wakeups() : mScheduledPriority(0), mIsDone(false) { mLateness.reserve(kNumberWakeups); }
+
+    static void *Run(void *inWakeups) {
+        Wakeups *wakeups = static_cast<Wakeups *>(inWakeups);
+        wakeups->mScheduledPriority = CAPThread::GetScheduledPriority(CAPThread::GetCurrentThread());
+        const UInt64 period = CAHostTimeBase::ConvertFromNanos(1000000);
+        UInt64 next = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 wakeup = 0; wakeup < kNumberWakeups; ++wakeup) {
+            next += period;
+            mach_wait_until(next);
+            wakeups->mLateness.push_back(CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - next));
+        }
+        wakeups->mIsDone.store(true);
+        return NULL;
+    }
+
+    void WaitUntilDone() {
+        while (!mIsDone.load()) {
+            usleep(10000);
+        }
+        std::sort(mLateness.begin(), mLateness.end());
+    }
+
+    UInt64 GetPercentile(UInt32 inPercent) const { return mLateness[(mLateness.size() - 1) * inPercent / 100]; }
+
+    std::vector<UInt64> mLateness;
+    UInt32 mScheduledPriority;
+    std::atomic<bool> mIsDone;
+};
+
+@interface AudioHubThreadTests : XCTestCase
+
+@end
+
+@implementation AudioHubThreadTests
+
+- (void)testPriorities {
+    Wakeups timeshare;
+    CAPThread timeshareThread(Wakeups::Run, &timeshare, CAPThread::kDefaultThreadPriority, false, false, "timeshare");
+    timeshareThread.Start();
+    timeshare.WaitUntilDone();
+    XCTAssertFalse(timeshareThread.IsFallbackScheduling());
+    XCTAssertFalse(timeshareThread.IsTimeConstraintThread());
+
+    Wakeups fixed;
+    CAPThread fixedThread(Wakeups::Run, &fixed, 47, true, false, "fixed");
+    fixedThread.Start();
+    fixed.WaitUntilDone();
+    XCTAssertGreaterThan(fixed.mScheduledPriority, timeshare.mScheduledPriority);
+}
+
+- (void)testTimeConstraints {
+    const UInt32 period = (UInt32)CAHostTimeBase::ConvertFromNanos(1000000);
+    Wakeups wakeups;
+    CAPThread thread(Wakeups::Run, &wakeups, period, period / 4, period, true, false, "time constraint");
+    XCTAssert(thread.IsTimeConstraintThread());
+    thread.Start();
+    wakeups.WaitUntilDone();
+    XCTAssertEqual(wakeups.mLateness.size(), Wakeups::kNumberWakeups);
+
+    UInt32 outPeriod = 0, outComputation = 0, outConstraint = 0;
+    bool outIsPreemptible = false;
+    thread.GetTimeConstraints(outPeriod, outComputation, outConstraint, outIsPreemptible);
+    XCTAssertEqual(outComputation, period / 4);
+    XCTAssert(outIsPreemptible);
+}
+
+- (void)testAffinity {
+    //  the Mac can't pin threads, it only says so
+    Wakeups wakeups;
+    CAPThread thread(Wakeups::Run, &wakeups, CAPThread::kDefaultThreadPriority, false, false, "affinity");
+    XCTAssert(thread.SetCPUAffinity(0));
+    XCTAssertFalse(thread.SetCPUAffinity(1));
+    XCTAssertEqual(thread.GetCPUAffinity(), 1);
+    thread.Start();
+    wakeups.WaitUntilDone();
+}
+
+#pragma mark Performance
+
+//  logs how late a 1 ms periodic wakeup is for each kind of thread
+- (void)testPerformanceWakeupJitter {
+    const UInt32 period = (UInt32)CAHostTimeBase::ConvertFromNanos(1000000);
+    [self measureBlock:^{
+        Wakeups timeshare, fixed, timeConstraint;
+        CAPThread timeshareThread(Wakeups::Run, &timeshare, CAPThread::kDefaultThreadPriority, false, false, "timeshare");
+        CAPThread fixedThread(Wakeups::Run, &fixed, CAPThread::kMaxThreadPriority, true, false, "fixed");
+        CAPThread timeConstraintThread(Wakeups::Run, &timeConstraint, period, period / 4, period, true, false, "time constraint");
+        const char *names[] = { "timeshare", "fixed priority", "time constraint" };
+        CAPThread *threads[] = { &timeshareThread, &fixedThread, &timeConstraintThread };
+        Wakeups *results[] = { &timeshare, &fixed, &timeConstraint };
+        for (UInt32 kind = 0; kind < 3; ++kind) {
+            threads[kind]->Start();
+            results[kind]->WaitUntilDone();
+            NSLog(@"%-16s wakeup late p50 %7llu ns, p99 %8llu ns, max %9llu ns%s", names[kind], results[kind]->GetPercentile(50), results[kind]->GetPercentile(99),
+                  results[kind]->GetPercentile(100), threads[kind]->IsFallbackScheduling() ? " (fallback)" : "");
+        }
+    }];
+}
+
+@end
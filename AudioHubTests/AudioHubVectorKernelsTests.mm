@@ -0,0 +1,279 @@
+//
+//  AudioHubVectorKernelsTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAVectorKernels.h"
+#include "CAHostTimeBase.h"
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <vector>
+
+struct Tier {
+    const char *mName;
+    UInt32 mFeatures;
+};
+
+static const Tier kTiers[] = {
+    { "AVX-512", CAVectorKernels::kTier_AVX512 },
+    { "AVX2", CAVectorKernels::kTier_AVX2 },
+    { "SSE2", CAVectorKernels::kTier_SSE2 },
+    { "Neon", CAVectorKernels::kTier_Neon },
+    { "Scalar", CAVectorKernels::kTier_Scalar },
+};
+
+static bool IsUsingTier(const char *inName) {
+    for (UInt32 kernel = CAVectorKernels::kKernel_Scale; kernel <= CAVectorKernels::kKernel_ConvertToSInt16; ++kernel) {
+        if (strcmp(CAVectorKernels::GetImplementationName((CAVectorKernels::Kernel)kernel), inName) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//  runs every kernel on every length up to 100 and every misalignment against plain loops, and
+//  checks that nothing outside the range is touched
+static bool KernelsMatchReference(NSString **outFailure) {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<Float32> distribution(-1.5f, 1.5f);
+    for (UInt32 numberSamples = 0; numberSamples <= 100; ++numberSamples) {
+        for (UInt32 offset = 0; offset < 4; ++offset) {
+            std::vector<Float32> source(numberSamples + 8), destination(numberSamples + 8);
+            for (Float32 &sample : source) {
+                sample = distribution(generator);
+            }
+            for (Float32 &sample : destination) {
+                sample = distribution(generator);
+            }
+            std::vector<Float32> expectedSource = source, expectedDestination = destination;
+
+            CAVectorKernels::Add(&source[3 - offset], &destination[offset], numberSamples);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedDestination[offset + i] += source[3 - offset + i];
+            }
+            if (memcmp(&destination[0], &expectedDestination[0], destination.size() * sizeof(Float32)) != 0) {
+                *outFailure = [NSString stringWithFormat:@"Add of %u samples at %u", numberSamples, offset];
+                return false;
+            }
+
+            CAVectorKernels::Scale(&source[offset], numberSamples, 0.7f);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedSource[offset + i] *= 0.7f;
+            }
+            if (memcmp(&source[0], &expectedSource[0], source.size() * sizeof(Float32)) != 0) {
+                *outFailure = [NSString stringWithFormat:@"Scale of %u samples at %u", numberSamples, offset];
+                return false;
+            }
+
+            //  the fused tiers round once where the reference rounds twice
+            CAVectorKernels::AddScaled(&source[offset], &destination[offset], numberSamples, 0.3f);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedDestination[offset + i] += 0.3f * expectedSource[offset + i];
+            }
+            for (size_t i = 0; i < destination.size(); ++i) {
+                if (fabsf(destination[i] - expectedDestination[i]) > 1e-6f) {
+                    *outFailure = [NSString stringWithFormat:@"AddScaled of %u samples at %u", numberSamples, offset];
+                    return false;
+                }
+            }
+
+            Float32 expectedPeak = 0.0f;
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedPeak = fmaxf(expectedPeak, fabsf(source[offset + i]));
+            }
+            if (CAVectorKernels::GetPeak(&source[offset], numberSamples) != expectedPeak) {
+                *outFailure = [NSString stringWithFormat:@"GetPeak of %u samples at %u", numberSamples, offset];
+                return false;
+            }
+
+            std::vector<SInt16> converted(numberSamples + 2, 7), expectedConverted(numberSamples + 2, 7);
+            CAVectorKernels::ConvertToSInt16(&source[offset], &converted[1], numberSamples);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                Float32 value = fminf(fmaxf(source[offset + i] * 32767.0f, -32768.0f), 32767.0f);
+                expectedConverted[1 + i] = (SInt16)lrintf(value);
+            }
+            if (memcmp(&converted[0], &expectedConverted[0], converted.size() * sizeof(SInt16)) != 0) {
+                *outFailure = [NSString stringWithFormat:@"ConvertToSInt16 of %u samples at %u", numberSamples, offset];
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//  interleaves, deinterleaves and copies 1 to 9 and 16 channels at a few strides and misalignments,
+//  every sample has to end up where the plain loops put it and the gaps between the channels stay
+static bool ChannelKernelsMatchReference(NSString **outFailure) {
+    const UInt32 numbersChannels[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 16 };
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<Float32> distribution(-1.0f, 1.0f);
+    for (UInt32 numberChannels : numbersChannels) {
+        const UInt32 strides[] = { numberChannels, numberChannels + 1, numberChannels + 5 };
+        for (UInt32 stride : strides) {
+            for (UInt32 numberFrames = 0; numberFrames <= 40; ++numberFrames) {
+                UInt32 offset = numberFrames % 3;
+                std::vector<std::vector<Float32>> channels(numberChannels, std::vector<Float32>(numberFrames + 1));
+                std::vector<const Float32 *> sources;
+                for (std::vector<Float32> &channel : channels) {
+                    for (Float32 &sample : channel) {
+                        sample = distribution(generator);
+                    }
+                    sources.push_back(&channel[offset % 2]);
+                }
+
+                std::vector<Float32> interleaved(stride * numberFrames + 4, 9.0f), expectedInterleaved = interleaved;
+                CAVectorKernels::Interleave(&sources[0], numberChannels, &interleaved[offset], stride, numberFrames);
+                for (UInt32 frame = 0; frame < numberFrames; ++frame) {
+                    for (UInt32 channel = 0; channel < numberChannels; ++channel) {
+                        expectedInterleaved[offset + frame * stride + channel] = sources[channel][frame];
+                    }
+                }
+                if (interleaved != expectedInterleaved) {
+                    *outFailure = [NSString stringWithFormat:@"Interleave of %u channels at stride %u, %u frames", numberChannels, stride, numberFrames];
+                    return false;
+                }
+
+                std::vector<std::vector<Float32>> deinterleaved(numberChannels, std::vector<Float32>(numberFrames + 2, 7.0f));
+                std::vector<Float32 *> destinations;
+                for (std::vector<Float32> &channel : deinterleaved) {
+                    destinations.push_back(&channel[1]);
+                }
+                CAVectorKernels::Deinterleave(&interleaved[offset], stride, &destinations[0], numberChannels, numberFrames);
+                for (UInt32 channel = 0; channel < numberChannels; ++channel) {
+                    bool isIntact = (deinterleaved[channel].front() == 7.0f) && (deinterleaved[channel].back() == 7.0f);
+                    if (!isIntact || (memcmp(destinations[channel], sources[channel], numberFrames * sizeof(Float32)) != 0)) {
+                        *outFailure = [NSString stringWithFormat:@"Deinterleave of %u channels at stride %u, %u frames", numberChannels, stride, numberFrames];
+                        return false;
+                    }
+                }
+
+                UInt32 destinationStride = stride + 2 - numberFrames % 4;
+                if (destinationStride < numberChannels) {
+                    destinationStride = numberChannels;
+                }
+                std::vector<Float32> copied(destinationStride * numberFrames + 4, 5.0f), expectedCopied = copied;
+                CAVectorKernels::CopyChannels(&interleaved[offset], stride, &copied[1], destinationStride, numberChannels, numberFrames);
+                for (UInt32 frame = 0; frame < numberFrames; ++frame) {
+                    for (UInt32 channel = 0; channel < numberChannels; ++channel) {
+                        expectedCopied[1 + frame * destinationStride + channel] = interleaved[offset + frame * stride + channel];
+                    }
+                }
+                if (copied != expectedCopied) {
+                    *outFailure = [NSString stringWithFormat:@"CopyChannels of %u channels from stride %u to %u, %u frames", numberChannels, stride, destinationStride, numberFrames];
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+@interface AudioHubVectorKernelsTests : XCTestCase
+
+@end
+
+@implementation AudioHubVectorKernelsTests
+
+- (void)tearDown {
+    CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+    [super tearDown];
+}
+
+- (void)testFeaturesMatchTheVectorUnitType {
+    SInt32 type = CAVectorUnit::GetVectorUnitType();
+    XCTAssertEqual(CAVectorUnit::HasAVX512(), type == kVecAVX512);
+    if (CAVectorUnit::HasAVX2()) {
+        XCTAssert(CAVectorUnit::HasAVX1());
+        XCTAssert(CAVectorUnit::HasFeatures(kVecFeature_AVX | kVecFeature_SSE2));
+    }
+    XCTAssertEqual(CAVectorUnit::HasNeon(), CAVectorUnit::HasFeatures(kVecFeature_Neon));
+
+    CAVectorUnit::SetFeatureMask(0);
+    XCTAssertEqual(CAVectorUnit::GetFeatures(), 0);
+    XCTAssertFalse(CAVectorUnit::HasVectorUnit());
+}
+
+- (void)testEveryTier {
+    UInt32 features = CAVectorUnit::GetFeatures();
+    UInt32 numberTested = 0;
+    for (const Tier &tier : kTiers) {
+        if ((tier.mFeatures & ~features) != 0) {
+            NSLog(@"vector kernels: %s isn't available on this CPU", tier.mName);
+            continue;
+        }
+        CAVectorUnit::SetFeatureMask(tier.mFeatures);
+        XCTAssert(IsUsingTier(tier.mName), @"%s", tier.mName);
+        NSString *failure = nil;
+        XCTAssert(KernelsMatchReference(&failure), @"%s: %@", tier.mName, failure);
+        XCTAssert(ChannelKernelsMatchReference(&failure), @"%s: %@", tier.mName, failure);
+        ++numberTested;
+    }
+    XCTAssertGreaterThanOrEqual(numberTested, 2);
+
+    CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+    XCTAssertFalse(IsUsingTier("Scalar") && CAVectorUnit::HasVectorUnit());
+}
+
+- (void)testClipping {
+    const Float32 source[] = { 2.0f, -2.0f, 1.0f, -1.0f, 0.25f, -0.25f, 0.0f, -0.0f, 1e30f, -1e30f };
+    const SInt16 expected[] = { 32767, -32768, 32767, -32767, 8192, -8192, 0, 0, 32767, -32768 };
+    for (const Tier &tier : kTiers) {
+        if ((tier.mFeatures & ~CAVectorUnit::GetFeatures()) != 0) {
+            continue;
+        }
+        CAVectorUnit::SetFeatureMask(tier.mFeatures);
+        //  a block long enough for the vector loop, so the values don't all end up in the scalar tail
+        std::vector<Float32> block;
+        std::vector<SInt16> expectedBlock;
+        for (UInt32 repeat = 0; repeat < 8; ++repeat) {
+            block.insert(block.end(), source, source + 10);
+            expectedBlock.insert(expectedBlock.end(), expected, expected + 10);
+        }
+        std::vector<SInt16> converted(block.size());
+        CAVectorKernels::ConvertToSInt16(&block[0], &converted[0], (UInt32)block.size());
+        XCTAssert(converted == expectedBlock, @"%s", tier.mName);
+        CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+    }
+}
+
+#pragma mark Performance
+
+enum { kNumberSamples = 4096, kNumberRuns = 10000 };
+
+//  logs ns per sample of mixing and metering on every tier the CPU has
+- (void)testPerformanceTiers {
+    std::vector<Float32> source(kNumberSamples, 0.25f), destination(kNumberSamples, 0.0f);
+    Float32 *sourcePointer = &source[0], *destinationPointer = &destination[0];
+    UInt32 features = CAVectorUnit::GetFeatures();
+    [self measureBlock:^{
+        for (const Tier &tier : kTiers) {
+            if ((tier.mFeatures & ~features) != 0) {
+                continue;
+            }
+            CAVectorUnit::SetFeatureMask(tier.mFeatures);
+            UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+            for (UInt32 run = 0; run < kNumberRuns; ++run) {
+                CAVectorKernels::AddScaled(sourcePointer, destinationPointer, kNumberSamples, 1.0f / (run + 1));
+            }
+            UInt64 mix = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+            Float32 peak = 0.0f;
+            start = CAHostTimeBase::GetTheCurrentTime();
+            for (UInt32 run = 0; run < kNumberRuns; ++run) {
+                peak += CAVectorKernels::GetPeak(destinationPointer, kNumberSamples);
+            }
+            UInt64 meter = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+            NSLog(@"vector kernels %-8s %6.3f ns per sample mixed, %6.3f ns per sample metered (%f)", tier.mName,
+                  (double)mix / (kNumberRuns * kNumberSamples), (double)meter / (kNumberRuns * kNumberSamples), peak);
+        }
+        CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+    }];
+}
+
+@end
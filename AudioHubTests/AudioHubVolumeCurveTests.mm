@@ -0,0 +1,182 @@
+//
+//  AudioHubVolumeCurveTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAVolumeCurve.h"
+#include "CAHostTimeBase.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+@interface AudioHubVolumeCurveTests : XCTestCase
+
+@end
+
+@implementation AudioHubVolumeCurveTests
+
+static bool IsSameFloat(Float32 inA, Float32 inB) {
+    return memcmp(&inA, &inB, sizeof(Float32)) == 0;
+}
+
+//  every conversion of the compiled curve has to be bit for bit what the map walk returns
+- (void)checkCurve:(const CAVolumeCurve&)inCurve name:(NSString *)inName {
+    XCTAssert(inCurve.IsCompiled(), @"%@", inName);
+
+    for (SInt32 raw = inCurve.GetMinimumRaw() - 4; raw <= inCurve.GetMaximumRaw() + 4; ++raw) {
+        XCTAssert(IsSameFloat(inCurve.ConvertRawToDB(raw), inCurve.ConvertRawToDBUncompiled(raw)), @"%@ raw %d", inName, raw);
+        XCTAssert(IsSameFloat(inCurve.ConvertRawToScalar(raw), inCurve.ConvertRawToScalarUncompiled(raw)), @"%@ raw %d", inName, raw);
+    }
+
+    const Float32 minimumDB = inCurve.GetMinimumDB() - 3.0f;
+    const Float32 maximumDB = inCurve.GetMaximumDB() + 3.0f;
+    const UInt32 numberSteps = 100000;
+    UInt32 dbFailures = 0, scalarFailures = 0;
+    for (UInt32 step = 0; step <= numberSteps; ++step) {
+        Float32 db = minimumDB + (maximumDB - minimumDB) * step / numberSteps;
+        dbFailures += inCurve.ConvertDBToRaw(db) != inCurve.ConvertDBToRawUncompiled(db);
+
+        //  the scalar lookup decides between raw steps at thresholds, so check the neighbours too
+        Float32 scalar = -0.01f + 1.02f * step / numberSteps;
+        const Float32 scalars[] = { scalar, nextafterf(scalar, -2.0f), nextafterf(scalar, 2.0f) };
+        for (Float32 value : scalars) {
+            scalarFailures += inCurve.ConvertScalarToRaw(value) != inCurve.ConvertScalarToRawUncompiled(value);
+        }
+    }
+    XCTAssertEqual(dbFailures, 0, @"%@", inName);
+    XCTAssertEqual(scalarFailures, 0, @"%@", inName);
+
+    std::vector<Float32> db(4096), scalars(4096), output(4096);
+    std::vector<SInt32> raw(4096);
+    for (UInt32 i = 0; i < 4096; ++i) {
+        db[i] = minimumDB + (maximumDB - minimumDB) * i / 4095;
+        scalars[i] = i / 4095.0f;
+        raw[i] = inCurve.GetMinimumRaw() - 2 + (SInt32)(i % (inCurve.GetMaximumRaw() - inCurve.GetMinimumRaw() + 4));
+    }
+    inCurve.ConvertDBToScalars(&db[0], &output[0], 4096);
+    for (UInt32 i = 0; i < 4096; ++i) {
+        XCTAssert(IsSameFloat(output[i], inCurve.ConvertDBToScalar(db[i])), @"%@ dB %f", inName, db[i]);
+    }
+    inCurve.ConvertRawToScalars(&raw[0], &output[0], 4096);
+    for (UInt32 i = 0; i < 4096; ++i) {
+        XCTAssert(IsSameFloat(output[i], inCurve.ConvertRawToScalar(raw[i])), @"%@ raw %d", inName, raw[i]);
+    }
+    inCurve.ConvertScalarsToDB(&scalars[0], &output[0], 4096);
+    for (UInt32 i = 0; i < 4096; ++i) {
+        XCTAssert(IsSameFloat(output[i], inCurve.ConvertScalarToDB(scalars[i])), @"%@ scalar %f", inName, scalars[i]);
+    }
+}
+
+- (void)testTransferFunctionsMatchMap {
+    for (UInt32 transferFunction = CAVolumeCurve::kLinearCurve; transferFunction <= CAVolumeCurve::kPow12Over1Curve; ++transferFunction) {
+        CAVolumeCurve curve;
+        curve.SetTransferFunction(transferFunction);
+        curve.AddRange(-100, 100, -96.0f, 0.0f);
+        [self checkCurve:curve name:[NSString stringWithFormat:@"transfer function %u", transferFunction]];
+    }
+}
+
+- (void)testMultipleRangesMatchMap {
+    CAVolumeCurve curve;
+    curve.AddRange(0, 64, -64.0f, -32.0f);
+    curve.AddRange(64, 128, -32.0f, 0.0f);
+    curve.AddRange(128, 4096, 0.0f, 12.0f);
+    [self checkCurve:curve name:@"multiple ranges"];
+}
+
+- (void)testNarrowCurveMatchesMap {
+    //  30 dB or less skips the transfer function
+    CAVolumeCurve curve;
+    curve.AddRange(0, 255, -20.0f, 0.0f);
+    [self checkCurve:curve name:@"narrow"];
+}
+
+- (void)testRecompilesWhenTheCurveChanges {
+    CAVolumeCurve curve;
+    XCTAssertFalse(curve.IsCompiled());
+    curve.AddRange(0, 100, -60.0f, 0.0f);
+    XCTAssert(curve.IsCompiled());
+    XCTAssertEqual(curve.GetMaximumRaw(), 100);
+    XCTAssertEqual(curve.GetMinimumDB(), -60.0f);
+
+    curve.SetTransferFunction(CAVolumeCurve::kPow3Over1Curve);
+    [self checkCurve:curve name:@"after transfer function"];
+    curve.SetIsApplyingTransferFunction(false);
+    [self checkCurve:curve name:@"without transfer function"];
+
+    curve.ResetRange();
+    XCTAssertFalse(curve.IsCompiled());
+    XCTAssertEqual(curve.GetMaximumRaw(), 0);
+    curve.AddRange(0, 10, -10.0f, 0.0f);
+    XCTAssertEqual(curve.ConvertDBToRaw(-5.0f), 5);
+}
+
+- (void)testLongCurveFallsBackToMap {
+    CAVolumeCurve curve;
+    curve.AddRange(0, CAVolumeCurve::kMaximumCompiledRawRange + 1, -96.0f, 0.0f);
+    XCTAssertFalse(curve.IsCompiled());
+    XCTAssertEqual(curve.ConvertDBToRaw(0.0f), CAVolumeCurve::kMaximumCompiledRawRange + 1);
+    XCTAssertEqual(curve.ConvertScalarToRaw(0.0f), 0);
+}
+
+#pragma mark Performance
+
+static const UInt32 kNumberValues = 1 << 16;
+
+static void FillAutomation(std::vector<Float32>& outDB) {
+    outDB.resize(kNumberValues);
+    for (UInt32 i = 0; i < kNumberValues; ++i) {
+        outDB[i] = -100.0f + 100.0f * i / kNumberValues;
+    }
+}
+
+//  logs ns per conversion of the map walk, the compiled curve and the batch API
+- (void)testPerformanceConversions {
+    CAVolumeCurve curve;
+    curve.AddRange(0, 1023, -96.0f, 0.0f);
+    std::vector<Float32> db, scalars(kNumberValues);
+    FillAutomation(db);
+    const CAVolumeCurve *curvePointer = &curve;
+    const Float32 *input = &db[0];
+    Float32 *output = &scalars[0];
+    [self measureBlock:^{
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberValues; ++i) {
+            output[i] = curvePointer->ConvertRawToScalarUncompiled(curvePointer->ConvertDBToRawUncompiled(input[i]));
+        }
+        UInt64 uncompiled = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < kNumberValues; ++i) {
+            output[i] = curvePointer->ConvertDBToScalar(input[i]);
+        }
+        UInt64 compiled = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        start = CAHostTimeBase::GetTheCurrentTime();
+        curvePointer->ConvertDBToScalars(input, output, kNumberValues);
+        UInt64 batch = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        NSLog(@"volume curve dB to scalar: %5.2f ns map, %5.2f ns compiled, %5.2f ns batch", (double)uncompiled / kNumberValues, (double)compiled / kNumberValues, (double)batch / kNumberValues);
+    }];
+}
+
+- (void)testPerformanceBatch {
+    CAVolumeCurve curve;
+    curve.AddRange(0, 1023, -96.0f, 0.0f);
+    std::vector<Float32> db, scalars(kNumberValues);
+    FillAutomation(db);
+    const CAVolumeCurve *curvePointer = &curve;
+    const Float32 *input = &db[0];
+    Float32 *output = &scalars[0];
+    [self measureBlock:^{
+        for (UInt32 run = 0; run < 100; ++run) {
+            curvePointer->ConvertDBToScalars(input, output, kNumberValues);
+        }
+    }];
+}
+
+@end
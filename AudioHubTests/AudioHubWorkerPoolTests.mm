@@ -0,0 +1,129 @@
+//
+//  AudioHubWorkerPoolTests.mm
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#include "CAWorkerPool.h"
+#include "CASpectralProcessor.h"
+#include "CAHostTimeBase.h"
+#include <math.h>
+#include <vector>
+
+@interface AudioHubWorkerPoolTests : XCTestCase
+
+@end
+
+@implementation AudioHubWorkerPoolTests
+
+static const UInt32 kBlockSize = 512;
+
+static std::atomic<UInt32> sTaskHits[64];
+
+static void CountTask(void* inContext, UInt32 inTaskIndex) {
+    sTaskHits[inTaskIndex].fetch_add(1);
+}
+
+static void HalveBin(SpectralBufferList* inSpectra, void* inUserData) {
+    for (UInt32 i = 0; i < inSpectra->mNumberSpectra; ++i) {
+        inSpectra->mDSPSplitComplex[i].realp[3] *= 0.5f;
+    }
+}
+
+//  runs inNumberBlocks blocks through a processor and returns the last channel's output
+static std::vector<Float32> RunProcessor(CAWorkerPool* inPool, UInt32 inNumberChannels, UInt32 inNumberBlocks, CAFFTBackend::Kind inKind) {
+    CASpectralProcessor processor(1024, 512, inNumberChannels, kBlockSize, inKind);
+    processor.SetSpectralFunction(HalveBin, NULL);
+    processor.SetWorkerPool(inPool);
+
+    std::vector<std::vector<Float32>> buffers(inNumberChannels, std::vector<Float32>(kBlockSize));
+    std::vector<UInt8> bufferListStorage(offsetof(AudioBufferList, mBuffers) + inNumberChannels * sizeof(AudioBuffer));
+    AudioBufferList* bufferList = reinterpret_cast<AudioBufferList*>(&bufferListStorage[0]);
+    bufferList->mNumberBuffers = inNumberChannels;
+
+    std::vector<Float32> output;
+    for (UInt32 block = 0; block < inNumberBlocks; ++block) {
+        for (UInt32 channel = 0; channel < inNumberChannels; ++channel) {
+            for (UInt32 frame = 0; frame < kBlockSize; ++frame) {
+                buffers[channel][frame] = sinf(0.01f * (channel + 1) * (block * kBlockSize + frame));
+            }
+            bufferList->mBuffers[channel].mNumberChannels = 1;
+            bufferList->mBuffers[channel].mDataByteSize = kBlockSize * sizeof(Float32);
+            bufferList->mBuffers[channel].mData = &buffers[channel][0];
+        }
+        processor.Process(kBlockSize, bufferList, bufferList);
+        output.insert(output.end(), buffers[inNumberChannels - 1].begin(), buffers[inNumberChannels - 1].end());
+    }
+    return output;
+}
+
+- (void)testEveryTaskRunsOnce {
+    CAWorkerPool pool(4);
+    XCTAssertEqual(pool.GetNumberWorkers(), 4);
+    for (UInt32 run = 0; run < 10000; ++run) {
+        UInt32 numberTasks = 1 + (run % 64);
+        for (UInt32 i = 0; i < numberTasks; ++i) {
+            sTaskHits[i] = 0;
+        }
+        pool.Run(CountTask, NULL, numberTasks);
+        for (UInt32 i = 0; i < numberTasks; ++i) {
+            XCTAssertEqual(sTaskHits[i].load(), 1);
+        }
+    }
+}
+
+- (void)testParkedWorkersWakeUp {
+    CAWorkerPool pool(4);
+    pool.SetSpinCount(0);
+    for (UInt32 run = 0; run < 100; ++run) {
+        sTaskHits[0] = 0;
+        pool.Run(CountTask, NULL, 1);
+        XCTAssertEqual(sTaskHits[0].load(), 1);
+        usleep(100);
+    }
+}
+
+- (void)testParallelMatchesSerial {
+    const CAFFTBackend::Kind kinds[] = { CAFFTBackend::kKind_Portable, CAFFTBackend::kKind_vDSP };
+    for (CAFFTBackend::Kind kind : kinds) {
+        std::vector<Float32> serial = RunProcessor(NULL, 16, 32, kind);
+        CAWorkerPool pool(4);
+        std::vector<Float32> parallel = RunProcessor(&pool, 16, 32, kind);
+        XCTAssert(serial == parallel);
+    }
+}
+
+#pragma mark Performance
+
+//  logs ns per block for 1 to 32 channels and 1 to 8 workers
+- (void)testPerformanceScaling {
+    const UInt32 numberBlocks = 200;
+    for (UInt32 workers = 1; workers <= 8; workers *= 2) {
+        CAWorkerPool pool(workers);
+        for (UInt32 channels = 1; channels <= 32; channels *= 2) {
+            UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+            RunProcessor(workers > 1 ? &pool : NULL, channels, numberBlocks, CAFFTBackend::kKind_Default);
+            UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+            NSLog(@"spectral processor %u workers %2u channels: %8.0f ns per block", workers, channels, (double)nanos / numberBlocks);
+        }
+    }
+}
+
+- (void)testPerformance32ChannelsSerial {
+    [self measureBlock:^{
+        RunProcessor(NULL, 32, 100, CAFFTBackend::kKind_Default);
+    }];
+}
+
+- (void)testPerformance32Channels4Workers {
+    CAWorkerPool pool(4);
+    CAWorkerPool *poolPointer = &pool;
+    [self measureBlock:^{
+        RunProcessor(poolPointer, 32, 100, CAFFTBackend::kKind_Default);
+    }];
+}
+
+@end
@@ -0,0 +1,202 @@
+//
+//  AtomicStackBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The contention checks of AudioHubAtomicStackTests and its testPerformanceContention measurement
+//  as a plain program. CMake builds it as it is, with -mcx16 so that the tagged stack swaps 16 bytes
+//  at once, and with the Thread Sanitizer when AUDIOHUB_SANITIZE_THREAD is on. Fails if one of the
+//  checks does.
+
+#include "CAAtomicStack.h"
+#include "CAAutoDisposer.h"
+#include "CAHostTimeBase.h"
+#include "CAThreadSafeList.h"
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+//  the sanitizer is more than 10 times slower, only the tagged stack is worth checking under it
+#if defined(__SANITIZE_THREAD__)
+static const UInt32 kNumberOperations = 20000;
+static const bool kMeasurePlainStack = false;
+#else
+static const UInt32 kNumberOperations = 200000;
+static const bool kMeasurePlainStack = true;
+#endif
+
+struct Item {
+    Item *mNext;
+    UInt32 mIndex;
+    Item *&next() { return mNext; }
+};
+
+static const UInt32 kNumberItems = 64;
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+//  every thread pops items, holds a few and pushes them back; counts an item that is popped twice
+//  or lost on the way. Returns the ns per operation.
+template <class Stack>
+static double Stress(Stack &ioStack, UInt32 inNumberThreads, UInt32 inNumberOperations, bool inCheckOwnership, UInt32 &outNumberDuplicates) {
+    std::vector<Item> items(kNumberItems);
+    for (UInt32 i = 0; i < kNumberItems; ++i) {
+        items[i].mIndex = i;
+        ioStack.push_NA(&items[i]);
+    }
+    std::vector<std::atomic<UInt32>> owners(kNumberItems);
+    for (std::atomic<UInt32> &owner : owners) {
+        owner = 0;
+    }
+    std::atomic<UInt32> duplicates(0);
+
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < inNumberThreads; ++thread) {
+        threads.emplace_back([&] {
+            std::vector<Item *> held;
+            for (UInt32 operation = 0; operation < inNumberOperations; ++operation) {
+                Item *item = ioStack.pop_atomic();
+                if (item != NULL) {
+                    if (inCheckOwnership && owners[item->mIndex].fetch_add(1) != 0) {
+                        duplicates.fetch_add(1);
+                    }
+                    held.push_back(item);
+                }
+                if (held.size() > 4 || (item == NULL && !held.empty())) {
+                    if (inCheckOwnership) {
+                        owners[held.back()->mIndex].fetch_sub(1);
+                    }
+                    ioStack.push_atomic(held.back());
+                    held.pop_back();
+                }
+            }
+            for (Item *item : held) {
+                if (inCheckOwnership) {
+                    owners[item->mIndex].fetch_sub(1);
+                }
+                ioStack.push_atomic(item);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    UInt32 numberItems = 0;
+    while (ioStack.pop_NA() != NULL) {
+        ++numberItems;
+    }
+    outNumberDuplicates = duplicates.load() + (kNumberItems - numberItems);
+    return (double) nanos / (inNumberThreads * (double) inNumberOperations);
+}
+
+static void CheckTaggedStackUnderContention() {
+    bool isIntact = true;
+    for (UInt32 numberThreads = 2; numberThreads <= 16; numberThreads *= 2) {
+        TAtomicTaggedStack<Item> stack;
+        UInt32 duplicates = 0;
+        Stress(stack, numberThreads, kNumberOperations / 2, true, duplicates);
+        isIntact = isIntact && (duplicates == 0);
+    }
+    Check(isIntact, "the tagged stack never hands out an item twice or loses one");
+}
+
+static void CheckNodePool() {
+    TAtomicNodePool<UInt64> pool(128);
+    TAtomicNodePool<UInt64> *poolPointer = &pool;
+    std::atomic<UInt32> corrupted(0);
+    std::vector<std::thread> threads;
+    for (UInt64 thread = 0; thread < 8; ++thread) {
+        threads.emplace_back([=, &corrupted] {
+            for (UInt64 operation = 0; operation < kNumberOperations / 2; ++operation) {
+                UInt64 *node = poolPointer->allocate();
+                if (node == NULL) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                *node = (thread << 32) | operation;
+                std::this_thread::yield();
+                if (*node != ((thread << 32) | operation)) {
+                    corrupted.fetch_add(1);
+                }
+                poolPointer->deallocate(node);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    Check((corrupted.load() == 0) && (pool.number_in_use() == 0), "a pool node is only ever handed to one thread at a time");
+}
+
+static void CheckThreadSafeList() {
+    TThreadSafeList<UInt32> list(16);
+    TThreadSafeList<UInt32> *listPointer = &list;
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([=] {
+            for (UInt32 i = 0; i < 2000; ++i) {
+                listPointer->deferred_add(thread * 10000 + i);
+                if (i % 2) {
+                    listPointer->deferred_remove(thread * 10000 + i);
+                }
+            }
+        });
+    }
+    for (UInt32 i = 0; i < 200; ++i) {
+        list.update();
+        std::this_thread::yield();
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    list.update();
+
+    UInt32 numberItems = 0;
+    bool isEven = true;
+    for (TThreadSafeList<UInt32>::iterator i = list.begin(); i != list.end(); ++i) {
+        isEven = isEven && (*i % 2 == 0);
+        ++numberItems;
+    }
+    Check(isEven && (numberItems == 4000), "the thread safe list applies deferred adds and removes");
+}
+
+//  prints ns per pop or push for both stacks while every thread pops and pushes back
+static void MeasureContention() {
+    printf("tagged stack is %s\n", TAtomicTaggedStack<Item>::is_double_width() ? "double width" : "packed");
+    for (UInt32 numberThreads = 2; numberThreads <= 16; numberThreads *= 2) {
+        UInt32 duplicates = 0;
+        TAtomicTaggedStack<Item> tagged;
+        double taggedNanos = Stress(tagged, numberThreads, kNumberOperations, false, duplicates);
+        if (kMeasurePlainStack) {
+            TAtomicStack<Item> plain;
+            double plainNanos = Stress(plain, numberThreads, kNumberOperations, false, duplicates);
+            printf("atomic stack %2u threads: %6.1f ns tagged, %6.1f ns pop_all and push back\n", numberThreads, taggedNanos, plainNanos);
+        } else {
+            printf("atomic stack %2u threads: %6.1f ns tagged\n", numberThreads, taggedNanos);
+        }
+    }
+}
+
+int main() {
+    CheckTaggedStackUnderContention();
+    CheckNodePool();
+    CheckThreadSafeList();
+    for (UInt32 round = 0; round < 3; ++round) {
+        MeasureContention();
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+//
+//  FFTBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The accuracy checks of AudioHubFFTTests and its ns per transform measurement as a plain program.
+//  There is no vDSP on Linux, so the portable backend is checked against a direct DFT for every
+//  size the spectral tools may use. Fails if one of the checks does.
+
+#include "CAFFTBackend.h"
+#include "CAHostTimeBase.h"
+#include "CASpectralProcessor.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+static void FillSignal(std::vector<Float32> &outSignal) {
+    for (size_t i = 0; i < outSignal.size(); ++i) {
+        outSignal[i] = sinf(0.37f * i) + 0.25f * cosf(1.3f * (i % 7)) + 0.1f * ((i * 7919) % 13) / 13.0f;
+    }
+}
+
+//  the reference in the zrip layout: twice the DFT, DC and Nyquist packed into bin 0. The angles come
+//  from a table, so that the largest sizes don't take minutes.
+static void ReferenceDFT(const std::vector<Float32> &inSignal, std::vector<double> &outReal, std::vector<double> &outImag) {
+    const size_t n = inSignal.size();
+    std::vector<double> cosines(n), sines(n);
+    for (size_t i = 0; i < n; ++i) {
+        cosines[i] = cos(2.0 * M_PI * (double) i / (double) n);
+        sines[i] = sin(2.0 * M_PI * (double) i / (double) n);
+    }
+    outReal.assign(n / 2, 0.0);
+    outImag.assign(n / 2, 0.0);
+    for (size_t k = 0; k < n / 2; ++k) {
+        size_t index = 0;
+        for (size_t i = 0; i < n; ++i) {
+            outReal[k] += 2.0 * inSignal[i] * cosines[index];
+            outImag[k] -= 2.0 * inSignal[i] * sines[index];
+            index += k;
+            if (index >= n) {
+                index -= n;
+            }
+        }
+    }
+    double nyquist = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        nyquist += (i % 2) ? -inSignal[i] : inSignal[i];
+    }
+    outImag[0] = 2.0 * nyquist;
+}
+
+//  returns whether the forward transform matches the DFT and the inverse gets the signal back
+static bool CheckSize(UInt32 inSize) {
+    CAFFTBackend *fft = CAFFTBackend::Create(inSize, CAFFTBackend::kKind_Portable);
+    if ((fft == NULL) || (fft->GetSize() != inSize)) {
+        delete fft;
+        return false;
+    }
+
+    std::vector<Float32> signal(inSize), output(inSize), real(inSize / 2), imag(inSize / 2);
+    FillSignal(signal);
+    DSPSplitComplex spectrum = {&real[0], &imag[0]};
+    fft->Forward(&signal[0], spectrum);
+
+    std::vector<double> referenceReal, referenceImag;
+    ReferenceDFT(signal, referenceReal, referenceImag);
+    double peak = 0.0, error = 0.0;
+    for (UInt32 k = 0; k < inSize / 2; ++k) {
+        peak = fmax(peak, fabs(referenceReal[k]));
+        error = fmax(error, fabs(referenceReal[k] - real[k]));
+        error = fmax(error, fabs(referenceImag[k] - imag[k]));
+    }
+
+    fft->Inverse(spectrum, &output[0]);
+    double roundTripError = 0.0;
+    for (UInt32 i = 0; i < inSize; ++i) {
+        roundTripError = fmax(roundTripError, fabs(output[i] / (2.0 * inSize) - signal[i]));
+    }
+    delete fft;
+    return (error / peak < 1e-5) && (roundTripError < 1e-5);
+}
+
+static void CheckSupportedSizes() {
+    Check(CAFFTBackend::IsSupportedSize(8, CAFFTBackend::kKind_Portable) && CAFFTBackend::IsSupportedSize(480, CAFFTBackend::kKind_Portable) &&
+          CAFFTBackend::IsSupportedSize(1000, CAFFTBackend::kKind_Portable) && !CAFFTBackend::IsSupportedSize(4, CAFFTBackend::kKind_Portable) &&
+          !CAFFTBackend::IsSupportedSize(15, CAFFTBackend::kKind_Portable) && !CAFFTBackend::IsSupportedSize(2 * 7 * 8, CAFFTBackend::kKind_Portable),
+          "the portable backend takes even sizes whose half has no prime factor above 5");
+    Check(!CAFFTBackend::IsSupportedSize(1024, CAFFTBackend::kKind_vDSP) && (CAFFTBackend::Create(1024, CAFFTBackend::kKind_vDSP) == NULL),
+          "there is no vDSP backend");
+    CAFFTBackend *fft = CAFFTBackend::Create(1024);
+    Check((fft != NULL) && (strcmp(fft->GetName(), "Portable") == 0), "the default backend is the portable one");
+    delete fft;
+}
+
+static void CheckAccuracy() {
+    const UInt32 sizes[] = {8, 12, 16, 20, 24, 30, 32, 60, 64, 128, 256, 480, 512, 1000, 1024, 1920, 2048, 4096, 6000, 8192, 16384};
+    for (UInt32 size : sizes) {
+        char what[64];
+        snprintf(what, sizeof(what), "size %u matches the DFT", size);
+        Check(CheckSize(size), what);
+    }
+}
+
+static void CheckSpectralProcessor() {
+    CASpectralProcessor processor(480, 240, 1, 512);
+    bool isThrown = false;
+    try {
+        CASpectralProcessor unsupported(14 * 8, 56, 1, 512);
+    } catch (...) {
+        isThrown = true;
+    }
+    Check((strcmp(processor.FFT()->GetName(), "Portable") == 0) && isThrown, "the spectral processor takes the sizes the backend supports");
+}
+
+#pragma mark Performance
+
+//  prints ns per forward transform for the sizes the driver is likely to use
+static void Measure() {
+    for (UInt32 size = 256; size <= 16384; size *= 2) {
+        CAFFTBackend *fft = CAFFTBackend::Create(size, CAFFTBackend::kKind_Portable);
+        std::vector<Float32> signal(size), real(size / 2), imag(size / 2);
+        FillSignal(signal);
+        DSPSplitComplex spectrum = {&real[0], &imag[0]};
+        const UInt32 iterations = (1 << 24) / size;
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 i = 0; i < iterations; ++i) {
+            fft->Forward(&signal[0], spectrum);
+        }
+        UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+        printf("%s FFT %5u: %8.0f ns\n", fft->GetName(), size, (double) nanos / iterations);
+        delete fft;
+    }
+}
+
+int main() {
+    CheckSupportedSizes();
+    CheckAccuracy();
+    CheckSpectralProcessor();
+    for (UInt32 round = 0; round < 3; ++round) {
+        Measure();
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+//
+//  GuardBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubGuardTests and its notify and wake latency measurements as a plain program,
+//  run against the futex event count the guard uses on Linux instead of a cond var. Fails if one of
+//  the checks does.
+
+#include "CAGuard.h"
+#include "CAHostTimeBase.h"
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+//  the sanitizer makes every notification a lot slower, the orderings are the same with fewer
+#if defined(__SANITIZE_THREAD__)
+static const UInt32 kNumberItems = 10000;
+static const UInt32 kNumberNotifications = 100000;
+static const UInt32 kNumberPingPongs = 1000;
+#else
+static const UInt32 kNumberItems = 100000;
+static const UInt32 kNumberNotifications = 1000000;
+static const UInt32 kNumberPingPongs = 5000;
+#endif
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+static void CheckWaitForTimesOut() {
+    CAGuard guard("GuardBenchmark");
+    CAGuard::Locker locker(guard);
+    UInt64 start = CAHostTimeBase::GetCurrentTimeInNanos();
+    bool isTimedOut = locker.WaitFor(20000000);
+    UInt64 waited = CAHostTimeBase::GetCurrentTimeInNanos() - start;
+    Check(isTimedOut && (waited >= 20000000) && guard.IsOwnedByCurrentThread(), "WaitFor times out after its time with the guard locked again");
+    Check(locker.WaitUntil(CAHostTimeBase::GetCurrentTimeInNanos()), "WaitUntil a time that has passed times out");
+}
+
+static void CheckNotifyWakesAWaiter() {
+    CAGuard guard("GuardBenchmark");
+    bool isReady = false;
+    std::atomic<bool> timedOut(false);
+    std::thread waiter([&] {
+        CAGuard::Locker locker(guard);
+        while (!isReady) {
+            if (locker.WaitFor(5000000000ULL)) {
+                timedOut.store(true);
+                return;
+            }
+        }
+    });
+    usleep(10000);
+    {
+        CAGuard::Locker locker(guard);
+        isReady = true;
+        locker.Notify();
+    }
+    waiter.join();
+    Check(!timedOut.load(), "Notify wakes a waiter before its time out");
+}
+
+//  many more notifications than wakeups, none of the items may be left behind
+static void CheckEveryNotificationIsConsumed() {
+    CAGuard guard("GuardBenchmark");
+    UInt32 numberItems = 0, numberConsumed = 0;
+    bool isDone = false;
+    std::vector<std::thread> consumers;
+    for (UInt32 consumer = 0; consumer < 4; ++consumer) {
+        consumers.emplace_back([&] {
+            CAGuard::Locker locker(guard);
+            for (;;) {
+                while ((numberItems == 0) && !isDone) {
+                    locker.Wait();
+                }
+                if (numberItems == 0) {
+                    return;
+                }
+                --numberItems;
+                ++numberConsumed;
+            }
+        });
+    }
+    for (UInt32 i = 0; i < kNumberItems; ++i) {
+        CAGuard::Locker locker(guard);
+        ++numberItems;
+        locker.Notify();
+    }
+    {
+        CAGuard::Locker locker(guard);
+        isDone = true;
+        locker.NotifyAll();
+    }
+    for (std::thread &consumer : consumers) {
+        consumer.join();
+    }
+    Check((numberConsumed == kNumberItems) && (numberItems == 0), "every notified item is consumed");
+}
+
+//  the waiters wait once and count their wakeups, so the notification decides how many run
+static UInt32 CountWokenWaiters(bool inNotifyAll) {
+    CAGuard guard("GuardBenchmark");
+    UInt32 numberWaiting = 0;
+    std::atomic<UInt32> numberWoken(0);
+    std::vector<std::thread> waiters;
+    for (UInt32 waiter = 0; waiter < 8; ++waiter) {
+        waiters.emplace_back([&] {
+            CAGuard::Locker locker(guard);
+            ++numberWaiting;
+            locker.Wait();
+            numberWoken.fetch_add(1);
+        });
+    }
+
+    //  a waiter only lets go of the guard in Wait, so once all of them are counted all of them wait
+    for (;;) {
+        CAGuard::Locker locker(guard);
+        if (numberWaiting == 8) {
+            if (inNotifyAll) {
+                locker.NotifyAll();
+            } else {
+                locker.Notify();
+            }
+            break;
+        }
+        usleep(1000);
+    }
+    usleep(100000);
+    UInt32 theAnswer = numberWoken.load();
+    while (numberWoken.load() < 8) {
+        CAGuard::Locker locker(guard);
+        locker.NotifyAll();
+    }
+    for (std::thread &waiter : waiters) {
+        waiter.join();
+    }
+    return theAnswer;
+}
+
+static void CheckNotifyAll() {
+    Check(CountWokenWaiters(true) == 8, "NotifyAll wakes every waiter");
+    Check(CountWokenWaiters(false) == 8, "on Linux Notify wakes every waiter when more than one waits");
+}
+
+#pragma mark Performance
+
+//  prints ns per Notify with nobody waiting and with a worker that waits again as soon as it is woken
+static void MeasureNotify() {
+    CAGuard guard("GuardBenchmark");
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberNotifications; ++i) {
+        guard.Notify();
+    }
+    UInt64 idle = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    std::atomic<bool> isDone(false);
+    std::atomic<UInt32> numberWakeups(0);
+    std::thread worker([&] {
+        CAGuard::Locker locker(guard);
+        while (!isDone.load()) {
+            locker.Wait();
+            numberWakeups.fetch_add(1);
+        }
+    });
+    usleep(10000);
+    start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberNotifications; ++i) {
+        guard.Notify();
+    }
+    UInt64 busy = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+    {
+        CAGuard::Locker locker(guard);
+        isDone = true;
+        locker.Notify();
+    }
+    worker.join();
+
+    printf("guard notify: %5.2f ns without waiters, %6.2f ns with a waiter, %u wakeups for %u notifications\n", (double) idle / kNumberNotifications,
+           (double) busy / kNumberNotifications, numberWakeups.load(), kNumberNotifications);
+}
+
+//  prints the p50/p99 time of a ping that is answered with a pong, each a Notify and a Wait
+static void MeasurePingPong() {
+    CAGuard ping("GuardBenchmark Ping"), pong("GuardBenchmark Pong");
+    UInt32 pingSequence = 0, pongSequence = 0;
+    std::thread responder([&] {
+        for (UInt32 i = 1; i <= kNumberPingPongs; ++i) {
+            {
+                CAGuard::Locker locker(ping);
+                while (pingSequence != i) {
+                    locker.Wait();
+                }
+            }
+            CAGuard::Locker locker(pong);
+            pongSequence = i;
+            locker.Notify();
+        }
+    });
+
+    std::vector<UInt64> roundTrips(kNumberPingPongs);
+    for (UInt32 i = 1; i <= kNumberPingPongs; ++i) {
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        {
+            CAGuard::Locker locker(ping);
+            pingSequence = i;
+            locker.Notify();
+        }
+        CAGuard::Locker locker(pong);
+        while (pongSequence != i) {
+            locker.Wait();
+        }
+        roundTrips[i - 1] = CAHostTimeBase::GetTheCurrentTime() - start;
+    }
+    responder.join();
+    std::sort(roundTrips.begin(), roundTrips.end());
+    printf("guard ping-pong: p50 %6llu ns, p99 %7llu ns\n", (unsigned long long) CAHostTimeBase::ConvertToNanos(roundTrips[kNumberPingPongs / 2]),
+           (unsigned long long) CAHostTimeBase::ConvertToNanos(roundTrips[kNumberPingPongs * 99 / 100]));
+}
+
+int main() {
+    CheckWaitForTimesOut();
+    CheckNotifyWakesAWaiter();
+    CheckEveryNotificationIsConsumed();
+    CheckNotifyAll();
+    for (UInt32 round = 0; round < 3; ++round) {
+        MeasureNotify();
+        MeasurePingPong();
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+//
+//  HostTimeBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubHostTimeTests and its testPerformanceNanosPerCall measurement as a plain
+//  program. CMake builds it twice on x86, once reading CLOCK_MONOTONIC_RAW and once with
+//  CAHostTimeBase_Use_TSC, and both are held against clock_gettime. Fails if one of the checks does.
+
+#include "CAHostTimeBase.h"
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#if CAHostTimeBase_Use_TSC
+#include <cpuid.h>
+#endif
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+static UInt64 GetMonotonicRawNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return (UInt64) now.tv_sec * 1000000000ULL + (UInt64) now.tv_nsec;
+}
+
+//  a conversion is accurate when it is within a nanosecond, or a part per trillion, of the exact value
+static bool IsAccurate(UInt64 inNanos, long double inExact) {
+    long double error = (long double) inNanos - inExact;
+    if (error < 0) {
+        error = -error;
+    }
+    return error <= 1.0L + inExact * 1e-12L;
+}
+
+static void CheckClock() {
+#if CAHostTimeBase_Use_TSC
+    unsigned int eax, ebx, ecx, edx;
+    bool hasInvariantTSC = (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) != 0) && ((edx & (1U << 8)) != 0);
+    printf("host time is the TSC at %.6f GHz\n", CAHostTimeBase::GetFrequency() / 1e9);
+    Check(CAHostTimeBase::IsUsingTSC() == hasInvariantTSC, "the host time is the TSC when the CPU has an invariant one");
+#else
+    Check(!CAHostTimeBase::IsUsingTSC() && (CAHostTimeBase::GetFrequency() == 1e9), "the host time is CLOCK_MONOTONIC_RAW in nanoseconds");
+#endif
+    if (!CAHostTimeBase::IsUsingTSC()) {
+        //  the same clock, so a host time read between two others falls between them
+        bool isBracketed = true;
+        for (UInt32 i = 0; i < 1000; ++i) {
+            UInt64 before = GetMonotonicRawNanos();
+            UInt64 nanos = CAHostTimeBase::GetCurrentTimeInNanos();
+            UInt64 after = GetMonotonicRawNanos();
+            isBracketed = isBracketed && (before <= nanos) && (nanos <= after);
+        }
+        Check(isBracketed, "the host time is CLOCK_MONOTONIC_RAW");
+    }
+}
+
+//  catches a badly calibrated clock, which the conversions alone can't
+static void CheckAgreesWithClockGetTime() {
+    UInt64 start = GetMonotonicRawNanos();
+    UInt64 hostStart = CAHostTimeBase::GetTheCurrentTime();
+    usleep(200000);
+    UInt64 hostNanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - hostStart);
+    UInt64 nanos = GetMonotonicRawNanos() - start;
+    double error = ((double) hostNanos - (double) nanos) / (double) nanos;
+    printf("host time is off CLOCK_MONOTONIC_RAW by %.1f ppm\n", error * 1e6);
+    Check((error < 1e-4) && (error > -1e-4), "200 ms of host time are 200 ms of CLOCK_MONOTONIC_RAW within 100 ppm");
+}
+
+static void CheckConversions() {
+    const long double frequency = CAHostTimeBase::GetFrequency();
+    const UInt64 ticksPerNano = (UInt64) (frequency / 1e9L) + 1;
+    bool isToAccurate = true, isFromAccurate = true, isTicksRoundTrip = true, isNanosRoundTrip = true;
+
+    //  up to about a year of host time
+    for (UInt64 ticks = 0; ticks < (UInt64) (frequency * 3.2e7L); ticks = ticks + ticks / 7 + 1) {
+        UInt64 nanos = CAHostTimeBase::ConvertToNanos(ticks);
+        isToAccurate = isToAccurate && IsAccurate(nanos, ticks * 1e9L / frequency);
+        isFromAccurate = isFromAccurate && IsAccurate(CAHostTimeBase::ConvertFromNanos(ticks), ticks * frequency / 1e9L);
+
+        UInt64 roundTrip = CAHostTimeBase::ConvertFromNanos(nanos);
+        isTicksRoundTrip = isTicksRoundTrip && ((roundTrip > ticks ? roundTrip - ticks : ticks - roundTrip) <= ticksPerNano);
+
+        //  the way the IO thread turns a period in nanoseconds into host time and back
+        roundTrip = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::ConvertFromNanos(ticks));
+        isNanosRoundTrip = isNanosRoundTrip && ((roundTrip > ticks ? roundTrip - ticks : ticks - roundTrip) <= 1);
+    }
+    Check(isToAccurate && isFromAccurate, "both conversions are within a nanosecond or a part per trillion for a year");
+    Check(isTicksRoundTrip, "host time converted to nanoseconds and back is within a nanosecond");
+    Check(isNanosRoundTrip, "ConvertToNanos(ConvertFromNanos(x)) is within a nanosecond of x");
+
+    Check((CAHostTimeBase::MultiplyByRatio(3000000000ULL, 125, 3) == 125000000000ULL) &&
+              (CAHostTimeBase::MultiplyByRatio(0xFFFFFFFFFFFFULL, 1000000, 1000000) == 0xFFFFFFFFFFFFULL),
+          "MultiplyByRatio is exact");
+}
+
+static void CheckMonotonic() {
+    std::atomic<UInt32> backwards(0);
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&] {
+            UInt64 last = CAHostTimeBase::GetTheCurrentTime();
+            for (UInt32 i = 0; i < 1000000; ++i) {
+                UInt64 now = CAHostTimeBase::GetTheCurrentTime();
+                if (now < last) {
+                    backwards.fetch_add(1);
+                }
+                last = now;
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    Check(backwards.load() == 0, "the host time never goes backwards on a thread");
+
+    //  a time handed to another thread is never later than what that thread reads next
+    std::atomic<UInt64> published(0);
+    std::atomic<bool> isDone(false);
+    std::thread writer([&] {
+        while (!isDone.load()) {
+            published.store(CAHostTimeBase::GetTheCurrentTime());
+        }
+    });
+    UInt32 backwardsBetween = 0;
+    for (UInt32 i = 0; i < 1000000; ++i) {
+        UInt64 theirs = published.load();
+        if (CAHostTimeBase::GetTheCurrentTime() < theirs) {
+            ++backwardsBetween;
+        }
+    }
+    isDone = true;
+    writer.join();
+    Check(backwardsBetween == 0, "the host time never goes backwards between threads");
+}
+
+#pragma mark Performance
+
+static const UInt32 kNumberCalls = 10000000;
+
+//  prints ns per call of reading the clock and of each conversion, with clock_gettime to compare
+static void MeasureNanosPerCall() {
+    UInt64 sum = 0;
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberCalls; ++i) {
+        sum += CAHostTimeBase::GetTheCurrentTime();
+    }
+    UInt64 now = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberCalls; ++i) {
+        sum += GetMonotonicRawNanos();
+    }
+    UInt64 clock = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberCalls; ++i) {
+        sum += CAHostTimeBase::ConvertToNanos(sum + i);
+    }
+    UInt64 toNanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberCalls; ++i) {
+        sum += CAHostTimeBase::ConvertFromNanos(sum + i);
+    }
+    UInt64 fromNanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberCalls; ++i) {
+        sum += CAHostTimeBase::MultiplyByRatio(sum + i, 125, 3);
+    }
+    UInt64 ratio = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    printf("host time: %5.2f ns now, %5.2f ns clock_gettime, %5.2f ns to nanos, %5.2f ns from nanos, %5.2f ns MultiplyByRatio (%llu)\n",
+           (double) now / kNumberCalls, (double) clock / kNumberCalls, (double) toNanos / kNumberCalls, (double) fromNanos / kNumberCalls,
+           (double) ratio / kNumberCalls, (unsigned long long) (sum & 1));
+}
+
+int main() {
+    CheckClock();
+    CheckAgreesWithClockGetTime();
+    CheckConversions();
+    CheckMonotonic();
+    for (UInt32 round = 0; round < 3; ++round) {
+        MeasureNanosPerCall();
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+//
+//  MessageQueueBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubMessageQueueTests and its throughput and latency measurement as a plain
+//  program, so that the queues are also run with the Thread Sanitizer when AUDIOHUB_SANITIZE_THREAD
+//  is on. Fails if one of the checks does.
+
+#include "CAHostTimeBase.h"
+#include "CAMessageQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+//  the sanitizer is more than 10 times slower
+#if defined(__SANITIZE_THREAD__)
+static const UInt32 kScale = 10;
+#else
+static const UInt32 kScale = 1;
+#endif
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+struct Record {
+    UInt32 mProducer;
+    UInt32 mSequence;
+    UInt64 mHostTime;
+};
+
+struct Result {
+    UInt32 mNumberOutOfOrder;
+    UInt64 mSum;
+    double mOperationsPerSecond;
+    UInt64 mP50Nanos;
+    UInt64 mP99Nanos;
+};
+
+//  every producer pushes inNumberRecords numbered records in batches, the consumers pop until all
+//  of them arrived and check that each producer's records arrive in order
+template <class Queue>
+static Result Run(Queue &ioQueue, UInt32 inNumberProducers, UInt32 inNumberConsumers, UInt32 inNumberRecords, UInt32 inBatchSize) {
+    std::atomic<UInt64> numberConsumed(0);
+    std::atomic<UInt32> numberOutOfOrder(0);
+    std::atomic<UInt64> sum(0);
+    std::vector<std::vector<UInt64>> latencies(inNumberConsumers);
+    const UInt64 numberRecords = (UInt64) inNumberProducers * inNumberRecords;
+
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    std::vector<std::thread> threads;
+    for (UInt32 producer = 0; producer < inNumberProducers; ++producer) {
+        threads.emplace_back([&, producer] {
+            std::vector<Record> records(inBatchSize);
+            for (UInt32 sequence = 0; sequence < inNumberRecords;) {
+                UInt32 numberRecords = std::min(inBatchSize, inNumberRecords - sequence);
+                UInt64 now = CAHostTimeBase::GetTheCurrentTime();
+                for (UInt32 i = 0; i < numberRecords; ++i) {
+                    records[i].mProducer = producer;
+                    records[i].mSequence = sequence + i + 1;
+                    records[i].mHostTime = now;
+                }
+                UInt32 numberPushed = ioQueue.Push(&records[0], numberRecords);
+                sequence += numberPushed;
+                if (numberPushed < numberRecords) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (UInt32 consumer = 0; consumer < inNumberConsumers; ++consumer) {
+        threads.emplace_back([&, consumer] {
+            std::vector<Record> records(inBatchSize);
+            std::vector<UInt32> lastSequences(inNumberProducers, 0);
+            std::vector<UInt64> &consumerLatencies = latencies[consumer];
+            consumerLatencies.reserve(numberRecords / inNumberConsumers + inBatchSize);
+            UInt64 consumerSum = 0;
+            while (numberConsumed.load() < numberRecords) {
+                UInt32 numberPopped = ioQueue.Pop(&records[0], inBatchSize);
+                if (numberPopped == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                UInt64 now = CAHostTimeBase::GetTheCurrentTime();
+                for (UInt32 i = 0; i < numberPopped; ++i) {
+                    consumerLatencies.push_back(now - records[i].mHostTime);
+                    if (records[i].mSequence <= lastSequences[records[i].mProducer]) {
+                        numberOutOfOrder.fetch_add(1);
+                    }
+                    lastSequences[records[i].mProducer] = records[i].mSequence;
+                    consumerSum += records[i].mSequence;
+                }
+                numberConsumed.fetch_add(numberPopped);
+            }
+            sum.fetch_add(consumerSum);
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+    std::vector<UInt64> allLatencies;
+    for (const std::vector<UInt64> &consumerLatencies : latencies) {
+        allLatencies.insert(allLatencies.end(), consumerLatencies.begin(), consumerLatencies.end());
+    }
+    std::sort(allLatencies.begin(), allLatencies.end());
+    Result result = {numberOutOfOrder.load(), sum.load(), numberRecords * 1e9 / nanos, CAHostTimeBase::ConvertToNanos(allLatencies[allLatencies.size() / 2]),
+                     CAHostTimeBase::ConvertToNanos(allLatencies[allLatencies.size() * 99 / 100])};
+    return result;
+}
+
+static UInt64 ExpectedSum(UInt32 inNumberProducers, UInt32 inNumberRecords) {
+    return (UInt64) inNumberProducers * inNumberRecords * (inNumberRecords + 1) / 2;
+}
+
+//  the same single threaded checks for every record queue
+template <class Queue>
+static bool CheckBatches(Queue &ioQueue) {
+    const UInt32 records[] = {1, 2, 3, 4, 5, 6};
+    UInt32 popped[8] = {};
+    bool isCorrect = ioQueue.Push(records, 6) == 4 && !ioQueue.Push(records[0]) && ioQueue.GetNumberRecords() == 4;
+    isCorrect = isCorrect && ioQueue.Pop(popped, 3) == 3 && popped[2] == 3;
+
+    //  the ring wraps around
+    isCorrect = isCorrect && ioQueue.Push(records, 6) == 3 && ioQueue.Pop(popped, 8) == 4;
+    isCorrect = isCorrect && popped[0] == 4 && popped[1] == 1 && popped[3] == 3;
+    return isCorrect && !ioQueue.Pop(popped[0]) && ioQueue.GetNumberRecords() == 0;
+}
+
+static void CheckQueues() {
+    TSPSCQueue<UInt32, 4> spsc;
+    TMPSCQueue<UInt32, 4> mpsc;
+    TSPMCQueue<UInt32, 4> spmc;
+    Check(CheckBatches(spsc) && CheckBatches(mpsc) && CheckBatches(spmc), "batches fill, drain and wrap around the ring");
+
+    std::unique_ptr<TSPSCQueue<Record, 256>> singleQueue(new TSPSCQueue<Record, 256>);
+    Result result = Run(*singleQueue, 1, 1, 200000 / kScale, 7);
+    Check((result.mNumberOutOfOrder == 0) && (result.mSum == ExpectedSum(1, 200000 / kScale)), "one producer and one consumer get every record once and in order");
+
+    std::unique_ptr<TMPSCQueue<Record, 256>> producersQueue(new TMPSCQueue<Record, 256>);
+    result = Run(*producersQueue, 8, 1, 50000 / kScale, 7);
+    Check((result.mNumberOutOfOrder == 0) && (result.mSum == ExpectedSum(8, 50000 / kScale)), "several producers get every record through once and in order");
+
+    //  the order holds within a consumer
+    std::unique_ptr<TSPMCQueue<Record, 256>> consumersQueue(new TSPMCQueue<Record, 256>);
+    result = Run(*consumersQueue, 1, 8, 200000 / kScale, 7);
+    Check((result.mNumberOutOfOrder == 0) && (result.mSum == ExpectedSum(1, 200000 / kScale)), "several consumers get every record once and in order");
+}
+
+static void CheckByteSpans() {
+    TSPSCByteQueue<64> queue;
+    char bytes[64];
+    bool isCorrect = (TSPSCByteQueue<64>::GetMaximumSpanSize() == 24) && !queue.Push(bytes, 25);
+
+    //  spans of every size at every position of the ring
+    for (UInt32 round = 0; round < 100; ++round) {
+        UInt32 numberBytes = round % 25;
+        memset(bytes, (int) round, numberBytes);
+        char popped[64] = {};
+        isCorrect = isCorrect && queue.Push(bytes, numberBytes) && (queue.Pop(popped, sizeof(popped)) == numberBytes) && (memcmp(popped, bytes, numberBytes) == 0);
+    }
+
+    const void *span = NULL;
+    UInt32 numberBytes = 0;
+    isCorrect = isCorrect && queue.Push("abc", 3) && queue.Push("defgh", 5) && queue.Peek(span, numberBytes) && (numberBytes == 3);
+    queue.Pop();
+    isCorrect = isCorrect && queue.Peek(span, numberBytes) && (numberBytes == 5) && (memcmp(span, "defgh", 5) == 0);
+
+    //  a span that doesn't fit the buffer stays in the queue
+    char small[4];
+    isCorrect = isCorrect && (queue.Pop(small, sizeof(small)) == 0);
+    queue.Pop();
+    Check(isCorrect && !queue.Peek(span, numberBytes) && (queue.GetNumberUsedBytes() == 0), "byte spans wrap around the ring in one piece");
+
+    std::unique_ptr<TSPSCByteQueue<4096>> threadQueue(new TSPSCByteQueue<4096>);
+    TSPSCByteQueue<4096> *queuePointer = threadQueue.get();
+    const UInt32 numberSpans = 100000 / kScale;
+    std::thread producer([=] {
+        char producerBytes[600];
+        for (UInt32 span = 0; span < numberSpans; ++span) {
+            memset(producerBytes, (int) span, span % 600);
+            while (!queuePointer->Push(producerBytes, span % 600)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    UInt32 numberCorrupted = 0;
+    for (UInt32 span = 0; span < numberSpans; ++span) {
+        const void *spanBytes = NULL;
+        UInt32 spanSize = 0;
+        while (!threadQueue->Peek(spanBytes, spanSize)) {
+            std::this_thread::yield();
+        }
+        numberCorrupted += spanSize != span % 600;
+        for (UInt32 i = 0; i < spanSize; ++i) {
+            numberCorrupted += ((const char *) spanBytes)[i] != (char) span;
+        }
+        threadQueue->Pop();
+    }
+    producer.join();
+    Check(numberCorrupted == 0, "byte spans arrive intact across threads");
+}
+
+#pragma mark Performance
+
+static const UInt32 kNumberRecords = 1000000 / kScale;
+
+//  prints records per second and the latency from push to pop
+template <class Queue>
+static void Measure(const char *inName, UInt32 inNumberProducers, UInt32 inNumberConsumers, UInt32 inBatchSize) {
+    std::unique_ptr<Queue> queue(new Queue);
+    Result result = Run(*queue, inNumberProducers, inNumberConsumers, kNumberRecords / inNumberProducers, inBatchSize);
+    printf("%s %u producers %u consumers batch %2u: %6.2f M records/s, latency p50 %7llu ns, p99 %8llu ns\n", inName, inNumberProducers, inNumberConsumers, inBatchSize,
+           result.mOperationsPerSecond / 1e6, (unsigned long long) result.mP50Nanos, (unsigned long long) result.mP99Nanos);
+}
+
+int main() {
+    CheckQueues();
+    CheckByteSpans();
+    //  one record at a time and in batches
+    for (UInt32 batchSize = 1; batchSize <= 16; batchSize *= 16) {
+        Measure<TSPSCQueue<Record, 1024>>("SPSC", 1, 1, batchSize);
+        for (UInt32 numberThreads = 2; numberThreads <= 8; numberThreads *= 2) {
+            Measure<TMPSCQueue<Record, 1024>>("MPSC", numberThreads, 1, batchSize);
+            Measure<TSPMCQueue<Record, 1024>>("SPMC", 1, numberThreads, batchSize);
+        }
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
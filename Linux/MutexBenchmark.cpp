@@ -0,0 +1,154 @@
+//
+//  MutexBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubMutexTests and its contention measurement as a plain program, so that the
+//  futex and spinning path CAMutex takes on Linux is covered. Fails if one of the checks does.
+
+#include "CAHostTimeBase.h"
+#include "CAMutex.h"
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+static void CheckRecursiveLocking() {
+    bool isRecursive = true;
+    for (UInt32 spinCount : {0U, (UInt32) CAMutex::kDefaultSpinCount}) {
+        CAMutex mutex("MutexBenchmark Recursive", spinCount);
+        isRecursive = isRecursive && mutex.IsFree() && mutex.Lock() && !mutex.Lock() && mutex.IsOwnedByCurrentThread();
+        bool wasLocked = true;
+        isRecursive = isRecursive && mutex.Try(wasLocked) && !wasLocked;
+        mutex.Unlock();
+        isRecursive = isRecursive && mutex.IsFree();
+
+        //  another thread can't take it while it is held
+        isRecursive = isRecursive && mutex.Try(wasLocked) && wasLocked;
+        bool otherThreadGotIt = true;
+        std::thread([&mutex, &otherThreadGotIt] {
+            bool otherWasLocked = false;
+            otherThreadGotIt = mutex.Try(otherWasLocked);
+        }).join();
+        isRecursive = isRecursive && !otherThreadGotIt;
+        mutex.Unlock();
+    }
+    Check(isRecursive, "a mutex is recursive for its owner and excludes other threads");
+
+    CAMutex clamped("MutexBenchmark Clamped", 1000000);
+    Check(clamped.GetMaximumSpinCount() == CAMutex::kMaximumSpinCount, "the spin count is clamped");
+}
+
+static void CheckStatistics() {
+    Check(!CAMutex::IsCollectingStatistics(), "statistics are off by default");
+    CAMutex::ResetStatistics();
+    CAMutex off("MutexBenchmark Off");
+    {
+        CAMutex::Locker locker(off);
+        usleep(1000);
+    }
+    CAMutex::Statistics statistics;
+    off.GetStatistics(statistics);
+    Check((statistics.mNumberAcquisitions == 1) && (statistics.mMaximumHoldNanos == 0), "without statistics only the acquisitions are counted");
+
+    CAMutex::SetIsCollectingStatistics(true);
+    CAMutex first("MutexBenchmark Summed");
+    {
+        CAMutex second("MutexBenchmark Summed", CAMutex::kDefaultSpinCount);
+        for (UInt32 i = 0; i < 3; ++i) {
+            CAMutex::Locker locker(first);
+            CAMutex::Locker secondLocker(second);
+        }
+        CAMutex::Locker locker(second);
+        usleep(2000);
+    }
+    //  the counters of a destroyed mutex still count
+    bool isSummed = CAMutex::GetStatistics("MutexBenchmark Summed", statistics) && (statistics.mNumberAcquisitions == 7) &&
+                    (statistics.mNumberContendedAcquisitions == 0) && (statistics.mMaximumHoldNanos >= 2000000);
+    first.GetStatistics(statistics);
+    Check(isSummed && (statistics.mNumberAcquisitions == 3), "statistics are summed by name");
+
+    CAMutex contended("MutexBenchmark Contended", CAMutex::kDefaultSpinCount);
+    UInt64 counter = 0;
+    //  the holder sleeps, so the other threads have to wait, and some of them have to park
+    std::vector<std::thread> threads;
+    for (UInt32 thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&contended, &counter] {
+            for (UInt32 i = 0; i < 50; ++i) {
+                CAMutex::Locker locker(contended);
+                ++counter;
+                usleep(100);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    contended.GetStatistics(statistics);
+    Check((counter == 200) && (statistics.mNumberAcquisitions == 200) && (statistics.mNumberContendedAcquisitions > 0) &&
+          (statistics.mTotalWaitNanos > 0) && (statistics.mMaximumHoldNanos >= 100000),
+          "contended acquisitions are counted and timed");
+
+    CAMutex::ResetStatistics();
+    first.GetStatistics(statistics);
+    Check(statistics.mNumberAcquisitions == 0, "statistics can be reset");
+    CAMutex::SetIsCollectingStatistics(false);
+}
+
+#pragma mark Performance
+
+//  prints the time per acquisition of a short critical section for 1 to 16 threads
+static void Measure(UInt32 inSpinCount) {
+    for (UInt32 numberThreads = 1; numberThreads <= 16; numberThreads *= 2) {
+        CAMutex mutex("MutexBenchmark Benchmark", inSpinCount);
+        UInt64 counter = 0;
+        const UInt32 numberAcquisitionsPerThread = (1 << 20) / numberThreads;
+
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        std::vector<std::thread> threads;
+        for (UInt32 thread = 0; thread < numberThreads; ++thread) {
+            threads.emplace_back([&mutex, &counter, numberAcquisitionsPerThread] {
+                for (UInt32 i = 0; i < numberAcquisitionsPerThread; ++i) {
+                    CAMutex::Locker locker(mutex);
+                    ++counter;
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        CAMutex::Statistics statistics;
+        mutex.GetStatistics(statistics);
+        printf("mutex spin %4u, %2u threads, statistics %-3s: %6.1f ns per acquisition, %5.1f%% contended, %8.1f ns average wait\n", inSpinCount,
+               numberThreads, CAMutex::IsCollectingStatistics() ? "on" : "off", (double) nanos / counter,
+               100.0 * statistics.mNumberContendedAcquisitions / statistics.mNumberAcquisitions,
+               statistics.mNumberContendedAcquisitions > 0 ? (double) statistics.mTotalWaitNanos / statistics.mNumberContendedAcquisitions : 0.0);
+    }
+}
+
+int main() {
+    CheckRecursiveLocking();
+    CheckStatistics();
+    for (UInt32 round = 0; round < 3; ++round) {
+        Measure(0);
+        Measure(CAMutex::kDefaultSpinCount);
+        CAMutex::SetIsCollectingStatistics(true);
+        Measure(CAMutex::kDefaultSpinCount);
+        CAMutex::SetIsCollectingStatistics(false);
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+//
+//  NoiseReducerBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The quality checks of AudioHubNoiseReducerTests and its channels per core measurement as a plain
+//  program, so both can be reproduced on Linux. Fails if the quality checks do.
+
+#include "CAHostTimeBase.h"
+#include "NoiseReducer.h"
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+static const Float64 kSampleRate = 48000.0;
+static const UInt32 kBlockSize = 512;
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+//  white noise on every channel, plus a 440 Hz tone from inToneStart on
+static void FillSignal(std::vector<Float32> &outNoisy, std::vector<Float32> &outClean, UInt32 inNumberChannels, UInt32 inNumberFrames, UInt32 inToneStart) {
+    std::mt19937 generator(1);
+    std::normal_distribution<Float32> noise(0.0f, 0.02f);
+    outNoisy.resize(inNumberFrames * inNumberChannels);
+    outClean.resize(inNumberFrames * inNumberChannels);
+    for (UInt32 frame = 0; frame < inNumberFrames; ++frame) {
+        Float32 tone = frame >= inToneStart ? 0.3f * (Float32) sin(2.0 * M_PI * 440.0 * frame / kSampleRate) : 0.0f;
+        for (UInt32 channel = 0; channel < inNumberChannels; ++channel) {
+            outClean[frame * inNumberChannels + channel] = tone;
+            outNoisy[frame * inNumberChannels + channel] = tone + noise(generator);
+        }
+    }
+}
+
+static void ProcessInBlocks(NoiseReducer &inReducer, std::vector<Float32> &ioSignal) {
+    UInt32 numberChannels = inReducer.GetNumberChannels();
+    UInt32 numberFrames = (UInt32)(ioSignal.size() / numberChannels);
+    for (UInt32 frame = 0; frame < numberFrames; frame += kBlockSize) {
+        inReducer.Process(&ioSignal[frame * numberChannels], std::min(kBlockSize, numberFrames - frame));
+    }
+}
+
+//  the energy of channel 0 of inSignal, delayed by inDelay, over [inStart, inEnd)
+static double Energy(const std::vector<Float32> &inSignal, UInt32 inNumberChannels, UInt32 inStart, UInt32 inEnd, UInt32 inDelay) {
+    double energy = 0.0;
+    for (UInt32 frame = inStart; frame < inEnd; ++frame) {
+        Float32 sample = inSignal[(frame + inDelay) * inNumberChannels];
+        energy += sample * sample;
+    }
+    return energy;
+}
+
+static void CheckReducesStationaryNoise() {
+    const UInt32 numberFrames = 3 * (UInt32) kSampleRate;
+    std::vector<Float32> signal, clean;
+    FillSignal(signal, clean, 2, numberFrames, numberFrames);
+    std::vector<Float32> input = signal;
+
+    NoiseReducer reducer(2, kSampleRate, 20.0f);
+    ProcessInBlocks(reducer, signal);
+
+    //  skip the first second while the floor settles
+    const UInt32 latency = NoiseReducer::GetLatency();
+    double reduction = 10.0 * log10(Energy(input, 2, kSampleRate, numberFrames - latency, 0) / Energy(signal, 2, kSampleRate, numberFrames - latency, latency));
+    printf("noise reduction: %.1f dB\n", reduction);
+    Check((reduction > 12.0) && (reduction < 21.0), "reduces stationary noise by 12 to 21 dB");
+}
+
+static void CheckKeepsTone() {
+    const UInt32 numberFrames = 4 * (UInt32) kSampleRate;
+    const UInt32 toneStart = 2 * (UInt32) kSampleRate;
+    std::vector<Float32> signal, clean;
+    FillSignal(signal, clean, 1, numberFrames, toneStart);
+    std::vector<Float32> input = signal;
+
+    NoiseReducer reducer(1, kSampleRate, 20.0f);
+    ProcessInBlocks(reducer, signal);
+
+    const UInt32 latency = NoiseReducer::GetLatency();
+    double errorBefore = 0.0, errorAfter = 0.0;
+    for (UInt32 frame = toneStart + latency; frame < numberFrames - latency; ++frame) {
+        errorBefore += (input[frame] - clean[frame]) * (input[frame] - clean[frame]);
+        errorAfter += (signal[frame + latency] - clean[frame]) * (signal[frame + latency] - clean[frame]);
+    }
+    double improvement = 10.0 * log10(errorBefore / errorAfter);
+    printf("tone SNR improvement: %.1f dB\n", improvement);
+    Check(improvement > 6.0, "improves the SNR of a tone by more than 6 dB");
+}
+
+//  how many channels one core keeps up with in real time
+static void MeasureChannels(UInt32 inNumberChannels) {
+    std::vector<Float32> signal, clean;
+    FillSignal(signal, clean, inNumberChannels, kBlockSize, 0);
+    NoiseReducer reducer(inNumberChannels, kSampleRate, 20.0f);
+    const UInt32 numberBlocks = 1000;
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 block = 0; block < numberBlocks; ++block) {
+        reducer.Process(&signal[0], kBlockSize);
+    }
+    Float64 seconds = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) / 1e9;
+    Float64 audioSeconds = numberBlocks * kBlockSize / kSampleRate;
+    printf("noise reducer %2u channels: %6.1fx real time, %4.0f channels per core\n", inNumberChannels, audioSeconds / seconds, inNumberChannels * audioSeconds / seconds);
+}
+
+int main() {
+    CheckReducesStationaryNoise();
+    CheckKeepsTone();
+    for (UInt32 channels = 1; channels <= 32; channels *= 2) {
+        MeasureChannels(channels);
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,283 @@
+//
+//  RealTimeCheckerTests.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubRealTimeCheckerTests as a plain program, built with TEST set so that
+//  CARealTimeChecker and its interposers are in it. Device and Factory need CoreFoundation,
+//  libdispatch and the AudioServerPlugIn API, so the simulated IO cycle here runs the stages of the
+//  IO path that build on Linux: draining automation, splitting the buffers at the events for the
+//  volume, the noise reducer and blocks from the buffer pool. The XCTest drives the whole path
+//  through the driver's entry points. Fails if one of the checks does.
+
+#include "AutomationQueue.h"
+#include "CABufferPool.h"
+#include "CADebugMacros.h"
+#include "CAException.h"
+#include "CAMutex.h"
+#include "CARealTimeChecker.h"
+#include "CASharedMutex.h"
+#include "NoiseReducer.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+        CARealTimeChecker::DumpViolations();
+    }
+}
+
+//  keeps the compiler from taking out an allocation that is freed right away
+static void *volatile sKeptBlock = NULL;
+
+static std::vector<CARealTimeChecker::ViolationKind> GetViolationKinds() {
+    std::vector<CARealTimeChecker::ViolationKind> kinds;
+    for (UInt32 i = 0; i < CARealTimeChecker::GetNumberViolations(); ++i) {
+        CARealTimeChecker::Violation violation;
+        if (CARealTimeChecker::GetViolation(i, violation)) {
+            kinds.push_back(violation.mKind);
+        }
+    }
+    return kinds;
+}
+
+//  runs inCall in a scope and checks that it is reported as exactly one violation of inKind
+template <class Call>
+static void CheckReported(const char *inWhat, CARealTimeChecker::ViolationKind inKind, Call inCall) {
+    CARealTimeChecker::ResetViolations();
+    CARealTimeChecker::BeginScope();
+    inCall();
+    CARealTimeChecker::EndScope();
+    CARealTimeChecker::Violation violation;
+    bool isReported = (CARealTimeChecker::GetNumberViolations() == 1) && CARealTimeChecker::GetViolation(0, violation) && (violation.mKind == inKind);
+    Check(isReported, inWhat);
+}
+
+static void CheckNothingIsReportedOutsideAScope() {
+    CARealTimeChecker::ResetViolations();
+    sKeptBlock = malloc(16);
+    free(sKeptBlock);
+    CAMutex mutex("RealTimeChecker Test");
+    mutex.Lock();
+    mutex.Unlock();
+    usleep(1);
+    Check(!CARealTimeChecker::IsInScope() && (CARealTimeChecker::GetNumberViolations() == 0), "nothing is reported outside a scope");
+}
+
+static void CheckViolationsAreReported() {
+    CAMutex mutex("RealTimeChecker Test");
+    CASharedMutex sharedMutex("RealTimeChecker Shared Test");
+    static std::mutex sStandardMutex;
+
+    CheckReported("malloc is reported", CARealTimeChecker::kViolation_Allocation, [] {
+        sKeptBlock = malloc(16);
+    });
+    free(sKeptBlock);
+    CheckReported("operator new is reported", CARealTimeChecker::kViolation_Allocation, [] {
+        sKeptBlock = new int(3);
+    });
+    delete (int *) sKeptBlock;
+    sKeptBlock = new int(3);
+    CheckReported("operator delete is reported", CARealTimeChecker::kViolation_Deallocation, [] {
+        delete (int *) sKeptBlock;
+    });
+    CheckReported("CAMutex::Lock is reported", CARealTimeChecker::kViolation_Lock, [&mutex] {
+        mutex.Lock();
+        mutex.Unlock();
+    });
+    CheckReported("CASharedMutex::LockShared is reported", CARealTimeChecker::kViolation_Lock, [&sharedMutex] {
+        sharedMutex.LockShared();
+        sharedMutex.UnlockShared();
+    });
+    CheckReported("pthread_mutex_lock is reported", CARealTimeChecker::kViolation_Lock, [] {
+        sStandardMutex.lock();
+        sStandardMutex.unlock();
+    });
+    CheckReported("write is reported", CARealTimeChecker::kViolation_SystemCall, [] {
+        (void) !write(STDOUT_FILENO, "", 0);
+    });
+    CheckReported("usleep is reported", CARealTimeChecker::kViolation_SystemCall, [] {
+        usleep(1);
+    });
+    CheckReported("yielding is reported", CARealTimeChecker::kViolation_SystemCall, [] {
+        std::this_thread::yield();
+    });
+
+    //  the lock's name is what is kept
+    CARealTimeChecker::ResetViolations();
+    CARealTimeChecker::BeginScope();
+    mutex.Lock();
+    mutex.Unlock();
+    CARealTimeChecker::EndScope();
+    CARealTimeChecker::Violation violation;
+    Check(CARealTimeChecker::GetViolation(0, violation) && (strcmp(violation.mWhat, "RealTimeChecker Test") == 0) && (violation.mNumberFrames > 1),
+          "a violation keeps its name and backtrace");
+
+    //  trying never waits, so it is fine
+    CARealTimeChecker::ResetViolations();
+    CARealTimeChecker::BeginScope();
+    bool wasLocked = false;
+    if (mutex.Try(wasLocked) && wasLocked) {
+        mutex.Unlock();
+    }
+    CARealTimeChecker::EndScope();
+    Check(CARealTimeChecker::GetNumberViolations() == 0, "CAMutex::Try is not reported");
+}
+
+static void CheckThrowingIsReported() {
+    CARealTimeChecker::ResetViolations();
+    CARealTimeChecker::BeginScope();
+    try {
+        Throw(CAException(-1));
+    } catch (const CAException &) {
+    }
+    CARealTimeChecker::EndScope();
+    std::vector<CARealTimeChecker::ViolationKind> kinds = GetViolationKinds();
+    Check(std::find(kinds.begin(), kinds.end(), CARealTimeChecker::kViolation_Throw) != kinds.end(), "throwing is reported");
+}
+
+static void CheckScopesNestAndStayOnTheirThread() {
+    CARealTimeChecker::ResetViolations();
+    std::atomic<bool> isInScope(false), isDone(false);
+    std::thread thread([&isInScope, &isDone] {
+        while (!isInScope.load()) {
+        }
+        for (UInt32 i = 0; i < 100; ++i) {
+            sKeptBlock = malloc(64);
+            free(sKeptBlock);
+        }
+        isDone.store(true);
+    });
+
+    CARealTimeChecker::BeginScope();
+    CARealTimeChecker::BeginScope();
+    CARealTimeChecker::EndScope();
+    bool isStillInScope = CARealTimeChecker::IsInScope();
+    isInScope.store(true);
+    while (!isDone.load()) {
+    }
+    CARealTimeChecker::EndScope();
+    thread.join();
+    Check(isStillInScope && !CARealTimeChecker::IsInScope() && (CARealTimeChecker::GetNumberViolations() == 0), "scopes nest and stay on their thread");
+}
+
+static void CheckReportsBeyondTheLogAreCounted() {
+    CARealTimeChecker::ResetViolations();
+    CARealTimeChecker::BeginScope();
+    for (UInt32 i = 0; i < CARealTimeChecker::kMaximumNumberViolations; ++i) {
+        sKeptBlock = malloc(16);
+        free(sKeptBlock);
+    }
+    CARealTimeChecker::EndScope();
+    CARealTimeChecker::Violation violation;
+    Check((CARealTimeChecker::GetNumberViolations() == 2 * CARealTimeChecker::kMaximumNumberViolations) &&
+          CARealTimeChecker::GetViolation(CARealTimeChecker::kMaximumNumberViolations - 1, violation) &&
+          !CARealTimeChecker::GetViolation(CARealTimeChecker::kMaximumNumberViolations, violation),
+          "reports beyond the log are counted");
+}
+
+#pragma mark Simulated IO
+
+static const Float64 kSampleRate = 48000.0;
+static const UInt32 kBufferFrameSize = 512;
+static const UInt32 kNumberChannels = 2;
+static const UInt32 kNumberCycles = 64;
+static const UInt32 kScratchSize = 4 * kBufferFrameSize * kNumberChannels * sizeof(Float32);
+
+//  what Device does to a buffer for a volume parameter, with a loop in place of vDSP_vsmul
+static void ApplyVolume(AutomationQueue &inQueue, UInt32 inParameter, Float64 inSampleTime, Float32 *ioBuffer, Float32 &ioVolume) {
+    UInt32 frame = 0;
+    while (frame < kBufferFrameSize) {
+        UInt32 numberFrames = inQueue.NextSegment(inParameter, inSampleTime + frame, kBufferFrameSize - frame, ioVolume);
+        Float32 *segment = ioBuffer + frame * kNumberChannels;
+        for (UInt32 i = 0; i < numberFrames * kNumberChannels; ++i) {
+            segment[i] *= ioVolume;
+        }
+        frame += numberFrames;
+    }
+}
+
+//  an IO thread that runs every cycle in a scope while the main thread pushes automation, as the
+//  property calls do; fails on anything in a cycle that could block it
+static void CheckIOCycleIsRealTimeSafe() {
+    AutomationQueue queue;
+    NoiseReducer reducer(kNumberChannels, kSampleRate, 20.0f);
+    CABufferPool::Reserve(kScratchSize, 2);
+    std::vector<Float32> buffer(kBufferFrameSize * kNumberChannels);
+    std::vector<Float32> gains(kNumberCycles * kBufferFrameSize);
+    std::atomic<bool> isPushed(false);
+    std::atomic<UInt32> numberFailedAllocations(0);
+
+    //  two events before IO starts and one while it runs, as the property calls would push them
+    const UInt32 lateFrame = (kNumberCycles / 2) * kBufferFrameSize + 100;
+    const AutomationQueue::Event events[] = {
+        { 100.0, AutomationQueue::kParameterInputVolume, 0.5f },
+        { 3000.0, AutomationQueue::kParameterInputVolume, 0.25f },
+        { (Float64) lateFrame, AutomationQueue::kParameterInputVolume, 1.0f },
+    };
+    queue.Push(events, 2);
+
+    CARealTimeChecker::ResetViolations();
+    std::thread ioThread([&] {
+        CABufferPool::SetIsRealTimeThread(true);
+        Float32 volume = 1.0f;
+        for (UInt32 cycle = 0; cycle < kNumberCycles; ++cycle) {
+            //  the second half only starts once the last event is in
+            while ((cycle == kNumberCycles / 2) && !isPushed.load()) {
+            }
+            Float64 sampleTime = cycle * kBufferFrameSize;
+            std::fill(buffer.begin(), buffer.end(), 1.0f);
+
+            CARealTimeChecker::BeginScope();
+            void *scratch = CABufferPool::Allocate(kScratchSize);
+            if (scratch == NULL) {
+                numberFailedAllocations.fetch_add(1);
+            }
+            queue.Drain();
+            ApplyVolume(queue, AutomationQueue::kParameterInputVolume, sampleTime, &buffer[0], volume);
+            for (UInt32 frame = 0; frame < kBufferFrameSize; ++frame) {
+                gains[cycle * kBufferFrameSize + frame] = buffer[frame * kNumberChannels];
+            }
+            reducer.Process(&buffer[0], kBufferFrameSize);
+            CABufferPool::Deallocate(scratch);
+            CARealTimeChecker::EndScope();
+        }
+        CABufferPool::SetIsRealTimeThread(false);
+    });
+    queue.Push(events[2]);
+    isPushed.store(true);
+    ioThread.join();
+
+    bool isSampleAccurate = true;
+    for (UInt32 frame = 0; frame < kNumberCycles * kBufferFrameSize; ++frame) {
+        Float32 expected = frame < 100 ? 1.0f : frame < 3000 ? 0.5f : frame < lateFrame ? 0.25f : 1.0f;
+        isSampleAccurate = isSampleAccurate && (gains[frame] == expected);
+    }
+    Check(isSampleAccurate, "the IO cycle applies automation at the frames it is due");
+    Check(numberFailedAllocations.load() == 0, "the IO cycle gets its blocks from the pool");
+    Check(CARealTimeChecker::GetNumberViolations() == 0, "the IO cycle does nothing that could block");
+}
+
+int main() {
+    CheckNothingIsReportedOutsideAScope();
+    CheckViolationsAreReported();
+    CheckThrowingIsReported();
+    CheckScopesNestAndStayOnTheirThread();
+    CheckReportsBeyondTheLogAreCounted();
+    CheckIOCycleIsRealTimeSafe();
+    return (sNumberFailures == 0) ? 0 : 1;
+}
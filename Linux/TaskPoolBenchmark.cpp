@@ -0,0 +1,245 @@
+//
+//  TaskPoolBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubTaskPoolTests and its throughput and latency measurement as a plain
+//  program. There is no libdispatch to compare against on Linux, so the pool and the strand are
+//  measured against a plain mutex and condition variable serial queue instead. Fails if one of the
+//  checks does.
+
+#include "CAHostTimeBase.h"
+#include "CATaskPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+static std::atomic<UInt32> sCount(0);
+
+static void Increment(void *inContext) {
+    sCount.fetch_add(1);
+}
+
+static void WaitFor(std::atomic<UInt32> &inCounter, UInt32 inValue) {
+    while (inCounter.load() < inValue) {
+        usleep(100);
+    }
+}
+
+static void CheckEveryTaskRunsOnce() {
+    CATaskPool pool(4);
+    sCount = 0;
+    for (UInt32 i = 0; i < 100000; ++i) {
+        pool.Dispatch(false, NULL, Increment);
+    }
+    WaitFor(sCount, 100000);
+    pool.Dispatch(true, NULL, Increment);
+    Check((pool.GetNumberWorkers() == 4) && (sCount.load() == 100001), "every task runs once");
+}
+
+static void CheckIdleWorkersSteal() {
+    CATaskPool pool(4);
+    std::atomic<UInt32> leaves(0);
+    //  everything is dispatched from one worker, so the others only get work by stealing it
+    pool.Dispatch(false, [&pool, &leaves] {
+        for (UInt32 i = 0; i < 10000; ++i) {
+            pool.Dispatch(false, [&leaves] {
+                volatile UInt32 sum = 0;
+                for (UInt32 k = 0; k < 1000; ++k) {
+                    sum += k;
+                }
+                leaves.fetch_add(1);
+            });
+        }
+    });
+    WaitFor(leaves, 10000);
+    Check(pool.GetNumberStolenTasks() > 0, "idle workers steal");
+}
+
+static void CheckStrandKeepsOrder() {
+    CATaskPool pool(4);
+    CATaskPool::Strand strand(pool);
+    const UInt32 numberProducers = 4;
+    const UInt32 numberTasks = 20000;
+    std::vector<std::vector<UInt32>> seen(numberProducers);
+    std::atomic<UInt32> inside(0), overlaps(0);
+
+    std::vector<std::thread> producers;
+    for (UInt32 producer = 0; producer < numberProducers; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (UInt32 i = 0; i < numberTasks; ++i) {
+                strand.Dispatch(false, [&, producer, i] {
+                    if (inside.fetch_add(1) != 0) {
+                        overlaps.fetch_add(1);
+                    }
+                    seen[producer].push_back(i);
+                    inside.fetch_sub(1);
+                });
+            }
+        });
+    }
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+    strand.Dispatch(true, [] {});
+
+    bool isInOrder = overlaps.load() == 0;
+    for (UInt32 producer = 0; producer < numberProducers; ++producer) {
+        isInOrder = isInOrder && (seen[producer].size() == numberTasks) && std::is_sorted(seen[producer].begin(), seen[producer].end());
+    }
+    Check(isInOrder, "a strand runs one task at a time and keeps each producer's order");
+}
+
+static void CheckSyncDispatchFromWorkers() {
+    //  more waiting workers than there are workers, which only works if they help while they wait
+    CATaskPool pool(2);
+    CATaskPool::Strand strand(pool);
+    std::atomic<UInt32> done(0);
+    for (UInt32 i = 0; i < 64; ++i) {
+        pool.Dispatch(false, [&strand, &done] {
+            strand.Dispatch(true, [&done] {
+                done.fetch_add(1);
+            });
+        });
+    }
+    WaitFor(done, 64);
+    Check(true, "synchronous dispatch from workers does not starve the pool");
+}
+
+static void CheckDelayedDispatch() {
+    CATaskPool pool(2);
+    CATaskPool::Strand strand(pool);
+    std::vector<UInt32> order;
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < 10; ++i) {
+        strand.Dispatch((UInt64)(10 - i) * 2000000, [&order, i] {
+            order.push_back(i);
+        });
+    }
+    bool isDone = false;
+    while (!isDone) {
+        usleep(1000);
+        strand.Dispatch(true, [&order, &isDone] {
+            isDone = order.size() == 10;
+        });
+    }
+    bool isInOrder = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start) >= 20000000;
+    for (UInt32 i = 0; i < 10; ++i) {
+        isInOrder = isInOrder && (order[i] == 9 - i);
+    }
+    Check(isInOrder, "delayed tasks run in the order they are due");
+
+    //  a strand takes its delayed tasks with it
+    sCount = 0;
+    {
+        CATaskPool::Strand doomed(pool);
+        doomed.Dispatch((UInt64) 50000000, NULL, Increment);
+    }
+    usleep(80000);
+    Check(sCount.load() == 0, "a strand drops its delayed tasks when it goes away");
+}
+
+#pragma mark Performance
+
+//  one thread that runs the tasks in order, what a serial queue without work stealing costs
+class SerialQueue {
+public:
+    SerialQueue() : mIsDone(false), mThread(&SerialQueue::Run, this) {}
+
+    ~SerialQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mIsDone = true;
+        }
+        mCondition.notify_one();
+        mThread.join();
+    }
+
+    void Dispatch(const std::function<void()> &inTask) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTasks.push_back(inTask);
+        }
+        mCondition.notify_one();
+    }
+
+private:
+    void Run() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (!mIsDone || !mTasks.empty()) {
+            if (mTasks.empty()) {
+                mCondition.wait(lock);
+                continue;
+            }
+            std::function<void()> task = mTasks.front();
+            mTasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::function<void()>> mTasks;
+    bool mIsDone;
+    std::thread mThread;
+};
+
+static const UInt32 kNumberTasks = 100000;
+
+//  prints the time per task and the p50/p99 latency from dispatch to run
+static void Measure(const char *inName, const std::function<void(const std::function<void()> &)> &inDispatch) {
+    std::vector<UInt64> latencies(kNumberTasks);
+    std::atomic<UInt32> done(0);
+    UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+    for (UInt32 i = 0; i < kNumberTasks; ++i) {
+        UInt64 dispatched = CAHostTimeBase::GetTheCurrentTime();
+        inDispatch([&latencies, &done, i, dispatched] {
+            latencies[i] = CAHostTimeBase::GetTheCurrentTime() - dispatched;
+            done.fetch_add(1);
+        });
+    }
+    WaitFor(done, kNumberTasks);
+    UInt64 nanos = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-16s %6.0f ns per task, latency p50 %8llu ns, p99 %8llu ns\n", inName, (double) nanos / kNumberTasks,
+           (unsigned long long) CAHostTimeBase::ConvertToNanos(latencies[kNumberTasks / 2]), (unsigned long long) CAHostTimeBase::ConvertToNanos(latencies[kNumberTasks * 99 / 100]));
+}
+
+int main() {
+    CheckEveryTaskRunsOnce();
+    CheckIdleWorkersSteal();
+    CheckStrandKeepsOrder();
+    CheckSyncDispatchFromWorkers();
+    CheckDelayedDispatch();
+
+    SerialQueue queue;
+    CATaskPool pool;
+    CATaskPool::Strand strand(pool);
+    for (UInt32 round = 0; round < 3; ++round) {
+        Measure("serial queue", [&queue](const std::function<void()> &inTask) { queue.Dispatch(inTask); });
+        Measure("strand", [&strand](const std::function<void()> &inTask) { strand.Dispatch(false, inTask); });
+        Measure("pool", [&pool](const std::function<void()> &inTask) { pool.Dispatch(false, inTask); });
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+//
+//  ThreadBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubThreadTests and its testPerformanceWakeupJitter measurement as a plain
+//  program, with the Linux scheduling instead of the Mach one. A thread wakes up at absolute times
+//  with clock_nanosleep, the way the IO thread does. Without CAP_SYS_NICE the real time policies
+//  aren't there, so every check also passes when the thread falls back and says so. Fails if one of
+//  the checks does.
+
+#include "CAHostTimeBase.h"
+#include "CAPThread.h"
+#include <algorithm>
+#include <atomic>
+#include <sched.h>
+#include <stdio.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#if !defined(SCHED_DEADLINE)
+#define SCHED_DEADLINE 6
+#endif
+
+static const UInt64 kPeriodNanos = 1000000;
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+static UInt64 GetMonotonicNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (UInt64) now.tv_sec * 1000000000ULL + (UInt64) now.tv_nsec;
+}
+
+//  wakes up every millisecond and keeps how late each wakeup was, and how the thread was scheduled.
+//  The threads delete themselves, so everything about them is read on the thread.
+struct Wakeups {
+    explicit Wakeups(UInt32 inNumberWakeups)
+        : mNumberWakeups(inNumberWakeups), mThread(NULL), mPolicy(-1), mScheduledPriority(0), mNumberCPUs(0), mIsOnCPU0(false),
+          mIsFallbackScheduling(false), mIsDone(false) {
+        mLateness.reserve(inNumberWakeups);
+    }
+
+    static void *Run(void *inWakeups) {
+        Wakeups *wakeups = static_cast<Wakeups *>(inWakeups);
+        wakeups->mPolicy = sched_getscheduler(0) & ~SCHED_RESET_ON_FORK;
+        wakeups->mScheduledPriority = CAPThread::GetScheduledPriority(CAPThread::GetCurrentThread());
+        wakeups->mIsFallbackScheduling = wakeups->mThread->IsFallbackScheduling();
+        cpu_set_t cpus;
+        if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+            wakeups->mNumberCPUs = CPU_COUNT(&cpus);
+            wakeups->mIsOnCPU0 = CPU_ISSET(0, &cpus);
+        }
+
+        timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        for (UInt32 wakeup = 0; wakeup < wakeups->mNumberWakeups; ++wakeup) {
+            next.tv_nsec += kPeriodNanos;
+            if (next.tv_nsec >= 1000000000) {
+                next.tv_nsec -= 1000000000;
+                ++next.tv_sec;
+            }
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0) {
+            }
+            wakeups->mLateness.push_back(GetMonotonicNanos() - ((UInt64) next.tv_sec * 1000000000ULL + (UInt64) next.tv_nsec));
+        }
+        wakeups->mIsDone.store(true);
+        return NULL;
+    }
+
+    void Start(CAPThread *inThread) {
+        mThread = inThread;
+        inThread->Start();
+        while (!mIsDone.load()) {
+            usleep(10000);
+        }
+        std::sort(mLateness.begin(), mLateness.end());
+    }
+
+    UInt64 GetPercentile(UInt32 inPercent) const { return mLateness[(mLateness.size() - 1) * inPercent / 100]; }
+
+    const UInt32 mNumberWakeups;
+    CAPThread *mThread;
+    std::vector<UInt64> mLateness;
+    int mPolicy;
+    UInt32 mScheduledPriority;
+    int mNumberCPUs;
+    bool mIsOnCPU0;
+    bool mIsFallbackScheduling;
+    std::atomic<bool> mIsDone;
+};
+
+static void CheckPriorities() {
+    Wakeups timeshare(100);
+    timeshare.Start(new CAPThread(Wakeups::Run, &timeshare, CAPThread::kDefaultThreadPriority, false, true, "timeshare"));
+    Check(!timeshare.mIsFallbackScheduling && (timeshare.mPolicy == SCHED_OTHER) && (timeshare.mScheduledPriority == CAPThread::kDefaultThreadPriority),
+          "the default priority runs SCHED_OTHER");
+
+    Wakeups fixed(100);
+    fixed.Start(new CAPThread(Wakeups::Run, &fixed, 47, true, true, "fixed"));
+    printf("fixed priority 47 runs %s\n", fixed.mIsFallbackScheduling ? "SCHED_OTHER, no privileges for SCHED_FIFO" : "SCHED_FIFO");
+    Check(fixed.mIsFallbackScheduling ? (fixed.mPolicy == SCHED_OTHER) && (fixed.mScheduledPriority == CAPThread::kDefaultThreadPriority)
+                                      : (fixed.mPolicy == SCHED_FIFO) && (fixed.mScheduledPriority == 47),
+          "a fixed priority runs SCHED_FIFO at the priority it asked for, or falls back to SCHED_OTHER");
+
+    Wakeups roundRobin(100);
+    roundRobin.Start(new CAPThread(Wakeups::Run, &roundRobin, 47, false, true, "round robin"));
+    Check(roundRobin.mIsFallbackScheduling ? (roundRobin.mPolicy == SCHED_OTHER) : (roundRobin.mPolicy == SCHED_RR) && (roundRobin.mScheduledPriority == 47),
+          "a higher priority that isn't fixed runs SCHED_RR, or falls back to SCHED_OTHER");
+}
+
+//  every priority above the default reads back as it was set
+static void CheckPriorityRoundTrip() {
+    bool isRealTime = false, isExact = true;
+    std::thread([&] {
+        for (UInt32 priority = CAPThread::kDefaultThreadPriority + 1; priority <= CAPThread::kMaxThreadPriority; ++priority) {
+            for (bool fixed : {true, false}) {
+                CAPThread::SetPriority(CAPThread::GetCurrentThread(), priority, fixed);
+                UInt32 scheduledPriority = CAPThread::GetScheduledPriority(CAPThread::GetCurrentThread());
+                if (scheduledPriority != CAPThread::kDefaultThreadPriority) {
+                    isRealTime = true;
+                    isExact = isExact && (scheduledPriority == priority);
+                }
+            }
+        }
+    }).join();
+    if (!isRealTime) {
+        printf("no privileges for the real time policies, the priorities fall back to SCHED_OTHER\n");
+    }
+    Check(isExact, "the real time priorities read back as they were set");
+}
+
+static void CheckTimeConstraints() {
+    const UInt32 period = (UInt32) CAHostTimeBase::ConvertFromNanos(kPeriodNanos);
+    Wakeups wakeups(100);
+    CAPThread *thread = new CAPThread(Wakeups::Run, &wakeups, period, period / 4, period, true, true, "time constraint");
+    UInt32 outPeriod = 0, outComputation = 0, outConstraint = 0;
+    bool outIsPreemptible = false;
+    thread->GetTimeConstraints(outPeriod, outComputation, outConstraint, outIsPreemptible);
+    Check(thread->IsTimeConstraintThread() && (outComputation == period / 4) && outIsPreemptible, "a time constraint thread keeps its constraints");
+
+    wakeups.Start(thread);
+    printf("time constraint thread runs %s\n", wakeups.mPolicy == SCHED_DEADLINE ? "SCHED_DEADLINE"
+                                               : wakeups.mPolicy == SCHED_RR     ? "SCHED_RR, no SCHED_DEADLINE"
+                                                                                 : "SCHED_OTHER, no real time policy");
+    Check((wakeups.mLateness.size() == 100) &&
+              (wakeups.mIsFallbackScheduling ? (wakeups.mPolicy == SCHED_RR) || (wakeups.mPolicy == SCHED_OTHER)
+                                             : (wakeups.mPolicy == SCHED_DEADLINE) && (wakeups.mScheduledPriority == CAPThread::kMaxThreadPriority)),
+          "time constraints run SCHED_DEADLINE, or fall back and still run");
+}
+
+static void CheckAffinity() {
+    Wakeups pinned(10);
+    CAPThread *thread = new CAPThread(Wakeups::Run, &pinned, CAPThread::kDefaultThreadPriority, false, true, "pinned");
+    Check(thread->SetCPUAffinity(1) && (thread->GetCPUAffinity() == 1), "a thread that isn't running takes any affinity");
+    pinned.Start(thread);
+    Check((pinned.mNumberCPUs == 1) && pinned.mIsOnCPU0, "the thread runs pinned to CPU 0");
+
+    //  there is no CPU 63 here, the thread runs where it can
+    Wakeups unpinned(10);
+    unpinned.Start(new CAPThread(Wakeups::Run, &unpinned, CAPThread::kDefaultThreadPriority, false, true, "unpinned"));
+    Wakeups missing(10);
+    thread = new CAPThread(Wakeups::Run, &missing, CAPThread::kDefaultThreadPriority, false, true, "missing CPU");
+    thread->SetCPUAffinity(1ULL << 63);
+    missing.Start(thread);
+    Check((missing.mLateness.size() == 10) && (missing.mNumberCPUs == unpinned.mNumberCPUs), "a thread that can't be pinned still runs");
+}
+
+static void CheckLockMemory() {
+    bool isLocked = CAPThread::LockMemory();
+    printf("memory is %s\n", isLocked ? "locked" : "not locked, no privileges for all of it");
+    //  locking future pages must not keep new threads from getting their stacks
+    Wakeups wakeups(10);
+    wakeups.Start(new CAPThread(Wakeups::Run, &wakeups, CAPThread::kDefaultThreadPriority, false, true, "locked"));
+    Check(wakeups.mLateness.size() == 10, "threads still start after the memory is locked");
+}
+
+#pragma mark Performance
+
+//  prints how late a 1 ms periodic wakeup is for each kind of thread
+static void MeasureWakeupJitter() {
+    const UInt32 period = (UInt32) CAHostTimeBase::ConvertFromNanos(kPeriodNanos);
+    Wakeups timeshare(2000), fixed(2000), timeConstraint(2000);
+    CAPThread *threads[] = {new CAPThread(Wakeups::Run, &timeshare, CAPThread::kDefaultThreadPriority, false, true, "timeshare"),
+                            new CAPThread(Wakeups::Run, &fixed, CAPThread::kMaxThreadPriority, true, true, "fixed"),
+                            new CAPThread(Wakeups::Run, &timeConstraint, period, period / 4, period, true, true, "time constraint")};
+    const char *names[] = {"timeshare", "fixed priority", "time constraint"};
+    Wakeups *results[] = {&timeshare, &fixed, &timeConstraint};
+    for (UInt32 kind = 0; kind < 3; ++kind) {
+        results[kind]->Start(threads[kind]);
+        printf("%-16s wakeup late p50 %7llu ns, p99 %8llu ns, max %9llu ns%s\n", names[kind], (unsigned long long) results[kind]->GetPercentile(50),
+               (unsigned long long) results[kind]->GetPercentile(99), (unsigned long long) results[kind]->GetPercentile(100),
+               results[kind]->mIsFallbackScheduling ? " (fallback)" : "");
+    }
+}
+
+int main() {
+    CheckPriorities();
+    CheckPriorityRoundTrip();
+    CheckTimeConstraints();
+    CheckAffinity();
+    CheckLockMemory();
+    for (UInt32 round = 0; round < 3; ++round) {
+        MeasureWakeupJitter();
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
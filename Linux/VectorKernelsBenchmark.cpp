@@ -0,0 +1,280 @@
+//
+//  VectorKernelsBenchmark.cpp
+//  AudioHub
+//
+//  Created by Daniel Lindenfelser on 19/10/26.
+//  Copyright © 2026 Daniel Lindenfelser. All rights reserved.
+//
+
+//  The checks of AudioHubVectorKernelsTests and its testPerformanceTiers measurement as a plain
+//  program. Every tier the CPU has is forced with CAVectorUnit::SetFeatureMask, and every kernel has
+//  to give what the plain scalar loops give. Fails if one of the checks does.
+
+#include "CAHostTimeBase.h"
+#include "CAVectorKernels.h"
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+struct Tier {
+    const char *mName;
+    UInt32 mFeatures;
+};
+
+static const Tier kTiers[] = {
+    {"AVX-512", CAVectorKernels::kTier_AVX512}, {"AVX2", CAVectorKernels::kTier_AVX2}, {"SSE2", CAVectorKernels::kTier_SSE2},
+    {"Neon", CAVectorKernels::kTier_Neon},      {"Scalar", CAVectorKernels::kTier_Scalar},
+};
+
+static int sNumberFailures = 0;
+
+static void Check(bool inCondition, const char *inWhat) {
+    printf("%s: %s\n", inCondition ? "passed" : "FAILED", inWhat);
+    if (!inCondition) {
+        ++sNumberFailures;
+    }
+}
+
+static bool IsUsingTier(const char *inName) {
+    for (UInt32 kernel = CAVectorKernels::kKernel_Scale; kernel <= CAVectorKernels::kKernel_ConvertToSInt16; ++kernel) {
+        if (strcmp(CAVectorKernels::GetImplementationName((CAVectorKernels::Kernel) kernel), inName) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//  runs every kernel on every length up to 100 and every misalignment against plain loops, and
+//  checks that nothing outside the range is touched
+static bool KernelsMatchReference(char *outFailure, size_t inFailureSize) {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<Float32> distribution(-1.5f, 1.5f);
+    for (UInt32 numberSamples = 0; numberSamples <= 100; ++numberSamples) {
+        for (UInt32 offset = 0; offset < 4; ++offset) {
+            std::vector<Float32> source(numberSamples + 8), destination(numberSamples + 8);
+            for (Float32 &sample : source) {
+                sample = distribution(generator);
+            }
+            for (Float32 &sample : destination) {
+                sample = distribution(generator);
+            }
+            std::vector<Float32> expectedSource = source, expectedDestination = destination;
+
+            CAVectorKernels::Add(&source[3 - offset], &destination[offset], numberSamples);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedDestination[offset + i] += source[3 - offset + i];
+            }
+            if (memcmp(&destination[0], &expectedDestination[0], destination.size() * sizeof(Float32)) != 0) {
+                snprintf(outFailure, inFailureSize, "Add of %u samples at %u", numberSamples, offset);
+                return false;
+            }
+
+            CAVectorKernels::Scale(&source[offset], numberSamples, 0.7f);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedSource[offset + i] *= 0.7f;
+            }
+            if (memcmp(&source[0], &expectedSource[0], source.size() * sizeof(Float32)) != 0) {
+                snprintf(outFailure, inFailureSize, "Scale of %u samples at %u", numberSamples, offset);
+                return false;
+            }
+
+            //  the fused tiers round once where the reference rounds twice
+            CAVectorKernels::AddScaled(&source[offset], &destination[offset], numberSamples, 0.3f);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedDestination[offset + i] += 0.3f * expectedSource[offset + i];
+            }
+            for (size_t i = 0; i < destination.size(); ++i) {
+                if (fabsf(destination[i] - expectedDestination[i]) > 1e-6f) {
+                    snprintf(outFailure, inFailureSize, "AddScaled of %u samples at %u", numberSamples, offset);
+                    return false;
+                }
+            }
+
+            Float32 expectedPeak = 0.0f;
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                expectedPeak = fmaxf(expectedPeak, fabsf(source[offset + i]));
+            }
+            if (CAVectorKernels::GetPeak(&source[offset], numberSamples) != expectedPeak) {
+                snprintf(outFailure, inFailureSize, "GetPeak of %u samples at %u", numberSamples, offset);
+                return false;
+            }
+
+            std::vector<SInt16> converted(numberSamples + 2, 7), expectedConverted(numberSamples + 2, 7);
+            CAVectorKernels::ConvertToSInt16(&source[offset], &converted[1], numberSamples);
+            for (UInt32 i = 0; i < numberSamples; ++i) {
+                Float32 value = fminf(fmaxf(source[offset + i] * 32767.0f, -32768.0f), 32767.0f);
+                expectedConverted[1 + i] = (SInt16) lrintf(value);
+            }
+            if (memcmp(&converted[0], &expectedConverted[0], converted.size() * sizeof(SInt16)) != 0) {
+                snprintf(outFailure, inFailureSize, "ConvertToSInt16 of %u samples at %u", numberSamples, offset);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//  interleaves, deinterleaves and copies 1 to 9 and 16 channels at a few strides and misalignments,
+//  every sample has to end up where the plain loops put it and the gaps between the channels stay
+static bool ChannelKernelsMatchReference(char *outFailure, size_t inFailureSize) {
+    const UInt32 numbersChannels[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 16};
+    std::mt19937 generator(2);
+    std::uniform_real_distribution<Float32> distribution(-1.0f, 1.0f);
+    for (UInt32 numberChannels : numbersChannels) {
+        const UInt32 strides[] = {numberChannels, numberChannels + 1, numberChannels + 5};
+        for (UInt32 stride : strides) {
+            for (UInt32 numberFrames = 0; numberFrames <= 40; ++numberFrames) {
+                UInt32 offset = numberFrames % 3;
+                std::vector<std::vector<Float32>> channels(numberChannels, std::vector<Float32>(numberFrames + 1));
+                std::vector<const Float32 *> sources;
+                for (std::vector<Float32> &channel : channels) {
+                    for (Float32 &sample : channel) {
+                        sample = distribution(generator);
+                    }
+                    sources.push_back(&channel[offset % 2]);
+                }
+
+                std::vector<Float32> interleaved(stride * numberFrames + 4, 9.0f), expectedInterleaved = interleaved;
+                CAVectorKernels::Interleave(&sources[0], numberChannels, &interleaved[offset], stride, numberFrames);
+                for (UInt32 frame = 0; frame < numberFrames; ++frame) {
+                    for (UInt32 channel = 0; channel < numberChannels; ++channel) {
+                        expectedInterleaved[offset + frame * stride + channel] = sources[channel][frame];
+                    }
+                }
+                if (interleaved != expectedInterleaved) {
+                    snprintf(outFailure, inFailureSize, "Interleave of %u channels at stride %u, %u frames", numberChannels, stride, numberFrames);
+                    return false;
+                }
+
+                std::vector<std::vector<Float32>> deinterleaved(numberChannels, std::vector<Float32>(numberFrames + 2, 7.0f));
+                std::vector<Float32 *> destinations;
+                for (std::vector<Float32> &channel : deinterleaved) {
+                    destinations.push_back(&channel[1]);
+                }
+                CAVectorKernels::Deinterleave(&interleaved[offset], stride, &destinations[0], numberChannels, numberFrames);
+                for (UInt32 channel = 0; channel < numberChannels; ++channel) {
+                    bool isIntact = (deinterleaved[channel].front() == 7.0f) && (deinterleaved[channel].back() == 7.0f);
+                    if (!isIntact || (memcmp(destinations[channel], sources[channel], numberFrames * sizeof(Float32)) != 0)) {
+                        snprintf(outFailure, inFailureSize, "Deinterleave of %u channels at stride %u, %u frames", numberChannels, stride, numberFrames);
+                        return false;
+                    }
+                }
+
+                UInt32 destinationStride = stride + 2 - numberFrames % 4;
+                if (destinationStride < numberChannels) {
+                    destinationStride = numberChannels;
+                }
+                std::vector<Float32> copied(destinationStride * numberFrames + 4, 5.0f), expectedCopied = copied;
+                CAVectorKernels::CopyChannels(&interleaved[offset], stride, &copied[1], destinationStride, numberChannels, numberFrames);
+                for (UInt32 frame = 0; frame < numberFrames; ++frame) {
+                    for (UInt32 channel = 0; channel < numberChannels; ++channel) {
+                        expectedCopied[1 + frame * destinationStride + channel] = interleaved[offset + frame * stride + channel];
+                    }
+                }
+                if (copied != expectedCopied) {
+                    snprintf(outFailure, inFailureSize, "CopyChannels of %u channels from stride %u to %u, %u frames", numberChannels, stride,
+                             destinationStride, numberFrames);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+//  a block long enough for the vector loop, so the values don't all end up in the scalar tail
+static bool ConvertsWithClipping() {
+    const Float32 source[] = {2.0f, -2.0f, 1.0f, -1.0f, 0.25f, -0.25f, 0.0f, -0.0f, 1e30f, -1e30f};
+    const SInt16 expected[] = {32767, -32768, 32767, -32767, 8192, -8192, 0, 0, 32767, -32768};
+    std::vector<Float32> block;
+    std::vector<SInt16> expectedBlock;
+    for (UInt32 repeat = 0; repeat < 8; ++repeat) {
+        block.insert(block.end(), source, source + 10);
+        expectedBlock.insert(expectedBlock.end(), expected, expected + 10);
+    }
+    std::vector<SInt16> converted(block.size());
+    CAVectorKernels::ConvertToSInt16(&block[0], &converted[0], (UInt32) block.size());
+    return converted == expectedBlock;
+}
+
+static void CheckFeatures() {
+    SInt32 type = CAVectorUnit::GetVectorUnitType();
+    bool isConsistent = (CAVectorUnit::HasAVX512() == (type == kVecAVX512)) && (CAVectorUnit::HasNeon() == CAVectorUnit::HasFeatures(kVecFeature_Neon));
+    if (CAVectorUnit::HasAVX2()) {
+        isConsistent = isConsistent && CAVectorUnit::HasAVX1() && CAVectorUnit::HasFeatures(kVecFeature_AVX | kVecFeature_SSE2);
+    }
+    Check(isConsistent, "the features match the vector unit type");
+
+    CAVectorUnit::SetFeatureMask(0);
+    Check((CAVectorUnit::GetFeatures() == 0) && !CAVectorUnit::HasVectorUnit() && IsUsingTier("Scalar"), "a mask of 0 leaves only the scalar kernels");
+    CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+}
+
+static void CheckEveryTier() {
+    UInt32 features = CAVectorUnit::GetFeatures();
+    UInt32 numberTested = 0;
+    for (const Tier &tier : kTiers) {
+        if ((tier.mFeatures & ~features) != 0) {
+            printf("vector kernels: %s isn't available on this CPU\n", tier.mName);
+            continue;
+        }
+        CAVectorUnit::SetFeatureMask(tier.mFeatures);
+        char what[160], failure[128] = "";
+        snprintf(what, sizeof(what), "%s: every kernel runs the tier", tier.mName);
+        Check(IsUsingTier(tier.mName), what);
+        bool isMatching = KernelsMatchReference(failure, sizeof(failure)) && ChannelKernelsMatchReference(failure, sizeof(failure));
+        snprintf(what, sizeof(what), "%s: every kernel matches the scalar loops %s", tier.mName, failure);
+        Check(isMatching, what);
+        snprintf(what, sizeof(what), "%s: the conversion clips", tier.mName);
+        Check(ConvertsWithClipping(), what);
+        ++numberTested;
+    }
+    Check(numberTested >= 2, "the scalar kernels and at least one vector tier are checked");
+
+    CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+    Check(!(IsUsingTier("Scalar") && CAVectorUnit::HasVectorUnit()), "without a mask the kernels use the vector unit");
+}
+
+#pragma mark Performance
+
+static const UInt32 kNumberSamples = 4096;
+static const UInt32 kNumberRuns = 10000;
+
+//  prints ns per sample of mixing and metering on every tier the CPU has
+static void MeasureTiers() {
+    std::vector<Float32> source(kNumberSamples, 0.25f), destination(kNumberSamples, 0.0f);
+    UInt32 features = CAVectorUnit::GetFeatures();
+    for (const Tier &tier : kTiers) {
+        if ((tier.mFeatures & ~features) != 0) {
+            continue;
+        }
+        CAVectorUnit::SetFeatureMask(tier.mFeatures);
+        UInt64 start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 run = 0; run < kNumberRuns; ++run) {
+            CAVectorKernels::AddScaled(&source[0], &destination[0], kNumberSamples, 1.0f / (run + 1));
+        }
+        UInt64 mix = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        Float32 peak = 0.0f;
+        start = CAHostTimeBase::GetTheCurrentTime();
+        for (UInt32 run = 0; run < kNumberRuns; ++run) {
+            peak += CAVectorKernels::GetPeak(&destination[0], kNumberSamples);
+        }
+        UInt64 meter = CAHostTimeBase::ConvertToNanos(CAHostTimeBase::GetTheCurrentTime() - start);
+
+        printf("vector kernels %-8s %6.3f ns per sample mixed, %6.3f ns per sample metered (%f)\n", tier.mName,
+               (double) mix / ((double) kNumberRuns * kNumberSamples), (double) meter / ((double) kNumberRuns * kNumberSamples), peak);
+    }
+    CAVectorUnit::SetFeatureMask(0xFFFFFFFF);
+}
+
+int main() {
+    CheckFeatures();
+    CheckEveryTier();
+    for (UInt32 round = 0; round < 3; ++round) {
+        MeasureTiers();
+    }
+    return (sNumberFailures == 0) ? 0 : 1;
+}
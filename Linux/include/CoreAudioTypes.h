@@ -0,0 +1,190 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#if !defined(__CoreAudioTypes_h__)
+#define __CoreAudioTypes_h__
+
+//	Linux stand-ins for the parts of the CoreAudio and CoreFoundation SDK headers that the portable
+//	PublicUtility and AudioHub sources use. They only exist so the sources in Linux/CMakeLists.txt
+//	build, nothing here is meant to be complete.
+
+#include <stddef.h>
+#include <stdint.h>
+
+//==================================================================================================
+//	Basic Types
+//==================================================================================================
+
+typedef uint8_t				UInt8;
+typedef int8_t				SInt8;
+typedef uint16_t			UInt16;
+typedef int16_t				SInt16;
+typedef uint32_t			UInt32;
+typedef int32_t				SInt32;
+//	long long like MacTypes.h, so that %llu fits them
+typedef unsigned long long	UInt64;
+typedef long long			SInt64;
+typedef float				Float32;
+typedef double				Float64;
+typedef unsigned char		Boolean;
+typedef SInt32				OSStatus;
+
+enum
+{
+	kAudio_UnimplementedError	= -4,
+	kAudio_FileNotFoundError	= -43,
+	kAudio_ParamError			= -50,
+	kAudio_MemFullError			= -108
+};
+
+//==================================================================================================
+//	Buffers
+//==================================================================================================
+
+struct AudioBuffer
+{
+	UInt32	mNumberChannels;
+	UInt32	mDataByteSize;
+	void*	mData;
+};
+typedef struct AudioBuffer AudioBuffer;
+
+struct AudioBufferList
+{
+	UInt32		mNumberBuffers;
+	AudioBuffer	mBuffers[1];
+};
+typedef struct AudioBufferList AudioBufferList;
+
+//==================================================================================================
+//	Channel Layouts
+//==================================================================================================
+
+typedef UInt32	AudioChannelLabel;
+typedef UInt32	AudioChannelLayoutTag;
+typedef UInt32	AudioChannelBitmap;
+typedef UInt32	AudioChannelFlags;
+
+struct AudioChannelDescription
+{
+	AudioChannelLabel	mChannelLabel;
+	AudioChannelFlags	mChannelFlags;
+	Float32				mCoordinates[3];
+};
+typedef struct AudioChannelDescription AudioChannelDescription;
+
+struct AudioChannelLayout
+{
+	AudioChannelLayoutTag	mChannelLayoutTag;
+	AudioChannelBitmap		mChannelBitmap;
+	UInt32					mNumberChannelDescriptions;
+	AudioChannelDescription	mChannelDescriptions[1];
+};
+typedef struct AudioChannelLayout AudioChannelLayout;
+
+enum : UInt32
+{
+	kAudioChannelLabel_Unknown				= 0xFFFFFFFF,
+	kAudioChannelLabel_Unused				= 0,
+	kAudioChannelLabel_UseCoordinates		= 100,
+	kAudioChannelLabel_Left					= 1,
+	kAudioChannelLabel_Right				= 2,
+	kAudioChannelLabel_Center				= 3,
+	kAudioChannelLabel_LFEScreen			= 4,
+	kAudioChannelLabel_LeftSurround			= 5,
+	kAudioChannelLabel_RightSurround		= 6,
+	kAudioChannelLabel_LeftCenter			= 7,
+	kAudioChannelLabel_RightCenter			= 8,
+	kAudioChannelLabel_CenterSurround		= 9,
+	kAudioChannelLabel_LeftSurroundDirect	= 10,
+	kAudioChannelLabel_RightSurroundDirect	= 11,
+	kAudioChannelLabel_TopCenterSurround	= 12,
+	kAudioChannelLabel_RearSurroundLeft		= 33,
+	kAudioChannelLabel_RearSurroundRight	= 34,
+	kAudioChannelLabel_LeftWide				= 35,
+	kAudioChannelLabel_RightWide			= 36,
+	kAudioChannelLabel_LFE2					= 37,
+	kAudioChannelLabel_LeftTotal			= 38,
+	kAudioChannelLabel_RightTotal			= 39,
+	kAudioChannelLabel_Mono					= 42,
+	kAudioChannelLabel_HeadphonesLeft		= 301,
+	kAudioChannelLabel_HeadphonesRight		= 302,
+	kAudioChannelLabel_Discrete				= 400,
+	kAudioChannelLabel_Discrete_0			= (1U << 16)
+};
+
+enum : UInt32
+{
+	kAudioChannelBit_Left				= (1U << 0),
+	kAudioChannelBit_Right				= (1U << 1),
+	kAudioChannelBit_Center				= (1U << 2),
+	kAudioChannelBit_LFEScreen			= (1U << 3),
+	kAudioChannelBit_LeftSurround		= (1U << 4),
+	kAudioChannelBit_RightSurround		= (1U << 5)
+};
+
+enum : UInt32
+{
+	kAudioChannelLayoutTag_UseChannelDescriptions	= (0U << 16) | 0,
+	kAudioChannelLayoutTag_UseChannelBitmap			= (1U << 16) | 0,
+	kAudioChannelLayoutTag_Mono						= (100U << 16) | 1,
+	kAudioChannelLayoutTag_Stereo					= (101U << 16) | 2,
+	kAudioChannelLayoutTag_StereoHeadphones			= (102U << 16) | 2,
+	kAudioChannelLayoutTag_MatrixStereo				= (103U << 16) | 2,
+	kAudioChannelLayoutTag_Quadraphonic				= (108U << 16) | 4,
+	kAudioChannelLayoutTag_Pentagonal				= (109U << 16) | 5,
+	kAudioChannelLayoutTag_Hexagonal				= (110U << 16) | 6,
+	kAudioChannelLayoutTag_Octagonal				= (111U << 16) | 8,
+	kAudioChannelLayoutTag_MPEG_3_0_A				= (113U << 16) | 3,
+	kAudioChannelLayoutTag_MPEG_3_0_B				= (114U << 16) | 3,
+	kAudioChannelLayoutTag_MPEG_4_0_A				= (115U << 16) | 4,
+	kAudioChannelLayoutTag_MPEG_4_0_B				= (116U << 16) | 4,
+	kAudioChannelLayoutTag_MPEG_5_0_A				= (117U << 16) | 5,
+	kAudioChannelLayoutTag_MPEG_5_0_B				= (118U << 16) | 5,
+	kAudioChannelLayoutTag_MPEG_5_0_C				= (119U << 16) | 5,
+	kAudioChannelLayoutTag_MPEG_5_0_D				= (120U << 16) | 5,
+	kAudioChannelLayoutTag_MPEG_5_1_A				= (121U << 16) | 6,
+	kAudioChannelLayoutTag_MPEG_5_1_B				= (122U << 16) | 6,
+	kAudioChannelLayoutTag_MPEG_5_1_C				= (123U << 16) | 6,
+	kAudioChannelLayoutTag_MPEG_5_1_D				= (124U << 16) | 6,
+	kAudioChannelLayoutTag_MPEG_6_1_A				= (125U << 16) | 7,
+	kAudioChannelLayoutTag_MPEG_7_1_A				= (126U << 16) | 8,
+	kAudioChannelLayoutTag_MPEG_7_1_B				= (127U << 16) | 8,
+	kAudioChannelLayoutTag_MPEG_7_1_C				= (128U << 16) | 8,
+	kAudioChannelLayoutTag_Emagic_Default_7_1		= (129U << 16) | 8,
+	kAudioChannelLayoutTag_SMPTE_DTV				= (130U << 16) | 8,
+	kAudioChannelLayoutTag_ITU_2_1					= (131U << 16) | 3,
+	kAudioChannelLayoutTag_ITU_2_2					= (132U << 16) | 4,
+	kAudioChannelLayoutTag_AudioUnit_6_0			= (139U << 16) | 6,
+	kAudioChannelLayoutTag_AudioUnit_7_0			= (140U << 16) | 7,
+	kAudioChannelLayoutTag_DiscreteInOrder			= (147U << 16) | 0,
+	kAudioChannelLayoutTag_AudioUnit_7_0_Front		= (148U << 16) | 7,
+	kAudioChannelLayoutTag_AudioUnit_5_1			= kAudioChannelLayoutTag_MPEG_5_1_A,
+	kAudioChannelLayoutTag_AudioUnit_7_1			= kAudioChannelLayoutTag_MPEG_7_1_C,
+	kAudioChannelLayoutTag_Unknown					= 0xFFFF0000
+};
+
+#define AudioChannelLayoutTag_GetNumberOfChannels(layoutTag)	((UInt32)((layoutTag) & 0x0000FFFF))
+
+#endif
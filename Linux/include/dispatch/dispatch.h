@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#if !defined(__dispatch_dispatch_h__)
+#define __dispatch_dispatch_h__
+
+//	the semaphores of libdispatch on top of POSIX semaphores, see CoreAudioTypes.h
+
+#include <semaphore.h>
+#include <stdint.h>
+
+typedef sem_t*		dispatch_semaphore_t;
+typedef uint64_t	dispatch_time_t;
+
+#define DISPATCH_TIME_FOREVER	(~0ULL)
+
+static inline dispatch_semaphore_t	dispatch_semaphore_create(long inValue)
+{
+	dispatch_semaphore_t theSemaphore = new sem_t;
+	sem_init(theSemaphore, 0, static_cast<unsigned int>(inValue));
+	return theSemaphore;
+}
+
+static inline long	dispatch_semaphore_signal(dispatch_semaphore_t inSemaphore)
+{
+	sem_post(inSemaphore);
+	return 0;
+}
+
+//	only waiting forever is supported
+static inline long	dispatch_semaphore_wait(dispatch_semaphore_t inSemaphore, dispatch_time_t /*inTimeout*/)
+{
+	return sem_wait(inSemaphore);
+}
+
+static inline void	dispatch_release(dispatch_semaphore_t inSemaphore)
+{
+	sem_destroy(inSemaphore);
+	delete inSemaphore;
+}
+
+#endif
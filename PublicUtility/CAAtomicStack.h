@@ -49,14 +49,28 @@
 
 #if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
 	#include <libkern/OSAtomic.h>
-#else
+#elif !defined(__linux__)
 	#include <CAAtomic.h>
+#else
+	#include <CoreAudioTypes.h>
+	#include <stddef.h>
 #endif
 
 #if MAC_OS_X_VERSION_MAX_ALLOWED < MAC_OS_X_VERSION_10_4
 	#include <CoreServices/CoreServices.h>
 #endif
 
+#include <atomic>
+
+//	TAtomicTaggedStack swaps a pointer and a 64 bit tag as one 16 byte word where the architecture
+//	has a double-width compare-and-swap, and packs the tag into the unused high bits of the pointer
+//	otherwise.
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16) && (__x86_64__ || __arm64__ || __aarch64__)
+	#define CAAtomicStack_Use_Double_Width_CAS	1
+#else
+	#define CAAtomicStack_Use_Double_Width_CAS	0
+#endif
+
 //  linked list LIFO or FIFO (pop_all_reversed) stack, elements are pushed and popped atomically
 //  class T must implement T *& next().
 template <class T>
@@ -88,7 +102,7 @@ public:
 	{
 		T *head_;
 		do {
-			head_ = mHead;
+			head_ = load_head();
 			item->next() = head_;
 		} while (!compare_and_swap(head_, item, &mHead));
 	}
@@ -103,7 +117,7 @@ public:
 			p = p->next();
 		} while (p);
 		do {
-			head_ = mHead;
+			head_ = load_head();
 			tail->next() = head_;
 		} while (!compare_and_swap(head_, item, &mHead));
 	}
@@ -115,7 +129,7 @@ public:
 	{
 		T *result;
 		do {
-			if ((result = mHead) == NULL)
+			if ((result = load_head()) == NULL)
 				break;
 		} while (!compare_and_swap(result, result->next(), &mHead));
 		return result;
@@ -125,6 +139,7 @@ public:
 		// This is inefficient for large linked lists.
 		// prefer pop_all() to a series of calls to pop_atomic.
 		// push_multiple_atomic has to traverse the entire list.
+		// when several threads pop, TAtomicTaggedStack pops in O(1) and keeps the order.
 	{
 		T *result = pop_all();
 		if (result) {
@@ -140,7 +155,7 @@ public:
 	{
 		T *result;
 		do {
-			if ((result = mHead) == NULL)
+			if ((result = load_head()) == NULL)
 				break;
 		} while (!compare_and_swap(result, NULL, &mHead));
 		return result;
@@ -168,6 +183,8 @@ public:
 	#else
 			return ::CompareAndSwap(UInt32(oldvalue), UInt32(newvalue), (UInt32 *)pvalue);
 	#endif
+#elif defined(__GNUC__)
+			return __sync_bool_compare_and_swap(pvalue, oldvalue, newvalue);
 #else
 			//return ::CompareAndSwap(UInt32(oldvalue), UInt32(newvalue), (UInt32 *)pvalue);
 			return CAAtomicCompareAndSwap32Barrier(SInt32(oldvalue), SInt32(newvalue), (SInt32*)pvalue);
@@ -175,10 +192,228 @@ public:
 	}
 	
 protected:
+	//	the head is swapped by other threads while it is read
+	T *		load_head() const { return __atomic_load_n(&mHead, __ATOMIC_ACQUIRE); }
+
 	T *		mHead;
 };
 
-#if ((MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_X_VERSION_10_5) && !TARGET_OS_WIN32)
+/*=============================================================================
+	TAtomicTaggedStack
+
+	A linked list LIFO stack like TAtomicStack, except that the head carries a tag that
+	changes with every pop. A pop that was overtaken by other threads popping and pushing
+	its node again fails its compare-and-swap instead of linking in a stale next (the ABA
+	problem), so any number of threads can pop in O(1).
+
+	A thread that loses the race may still read next() of a node another thread just
+	popped, so nodes must stay readable while the stack is in use, as they do in a free
+	list or in TAtomicNodePool.
+
+	class T must implement T *& next().
+=============================================================================*/
+
+template <class T>
+class TAtomicTaggedStack {
+public:
+	TAtomicTaggedStack() : mHead(0) { }
+
+	// non-atomic routines, for use when initializing/deinitializing, operate NON-atomically
+	void	push_NA(T *item)
+	{
+		HeadWord head_ = load();
+		item->next() = pointer(head_);
+		store(pack(item, tag(head_)));
+	}
+	
+	T *		pop_NA()
+	{
+		HeadWord head_ = load();
+		T *result = pointer(head_);
+		if (result)
+			store(pack(result->next(), tag(head_) + 1));
+		return result;
+	}
+	
+	bool	empty() const { return pointer(load()) == NULL; }
+	
+	T *		head() const { return pointer(load()); }
+	
+	// atomic routines
+	void	push_atomic(T *item)
+	{
+		HeadWord head_;
+		do {
+			head_ = load();
+			set_next(item, pointer(head_));
+		} while (!compare_and_swap(head_, pack(item, tag(head_))));
+	}
+	
+	void	push_multiple_atomic(T *item)
+		// pushes entire linked list headed by item
+	{
+		T *p = item, *tail;
+		do {
+			tail = p;
+			p = p->next();
+		} while (p);
+		HeadWord head_;
+		do {
+			head_ = load();
+			set_next(tail, pointer(head_));
+		} while (!compare_and_swap(head_, pack(item, tag(head_))));
+	}
+	
+	T *		pop_atomic()
+	{
+		HeadWord head_;
+		T *result;
+		do {
+			head_ = load();
+			if ((result = pointer(head_)) == NULL)
+				break;
+		} while (!compare_and_swap(head_, pack(get_next(result), tag(head_) + 1)));
+		return result;
+	}
+	
+	T *		pop_atomic_single_reader() { return pop_atomic(); }
+	
+	T *		pop_all()
+	{
+		HeadWord head_;
+		T *result;
+		do {
+			head_ = load();
+			if ((result = pointer(head_)) == NULL)
+				break;
+		} while (!compare_and_swap(head_, pack(NULL, tag(head_) + 1)));
+		return result;
+	}
+	
+	T *		pop_all_reversed()
+	{
+		T *p = pop_all(), *next, *reversed = NULL;
+		while (p != NULL) {
+			next = p->next();
+			p->next() = reversed;
+			reversed = p;
+			p = next;
+		}
+		return reversed;
+	}
+	
+	static bool	is_double_width() { return CAAtomicStack_Use_Double_Width_CAS; }
+
+private:
+	TAtomicTaggedStack(const TAtomicTaggedStack&);
+	TAtomicTaggedStack& operator=(const TAtomicTaggedStack&);
+
+	//	the low kPointerBits of the head word are the pointer, the rest is the tag. Counting
+	//	the tag up into the bits above the word wraps it around.
+#if CAAtomicStack_Use_Double_Width_CAS
+	typedef unsigned __int128	HeadWord;
+	enum { kPointerBits = 64 };
+#else
+	typedef UInt64				HeadWord;
+	enum { kPointerBits = sizeof(void *) == 4 ? 32 : 48 };
+#endif
+
+	static HeadWord	pack(T *item, HeadWord tag_) { return HeadWord(uintptr_t(item)) | (tag_ << kPointerBits); }
+	static T *		pointer(HeadWord head_) { return (T *)uintptr_t(head_ & ((HeadWord(1) << kPointerBits) - 1)); }
+	static HeadWord	tag(HeadWord head_) { return head_ >> kPointerBits; }
+
+	//	next() of a node on the stack can be read by a losing pop while its new owner writes it
+	static T *		get_next(T *item) { return __atomic_load_n(&item->next(), __ATOMIC_RELAXED); }
+	static void		set_next(T *item, T *next) { __atomic_store_n(&item->next(), next, __ATOMIC_RELAXED); }
+
+#if CAAtomicStack_Use_Double_Width_CAS
+	//	the halves don't need to be read together, a torn read fails the compare-and-swap
+	HeadWord	load() const
+	{
+		const UInt64 *halves = (const UInt64 *)&mHead;
+		UInt64 tag_ = __atomic_load_n(&halves[1], __ATOMIC_ACQUIRE);
+		UInt64 pointer_ = __atomic_load_n(&halves[0], __ATOMIC_ACQUIRE);
+		return HeadWord(pointer_) | (HeadWord(tag_) << 64);
+	}
+	void		store(HeadWord head_) { mHead = head_; }
+	bool		compare_and_swap(HeadWord oldvalue, HeadWord newvalue) { return __sync_bool_compare_and_swap(&mHead, oldvalue, newvalue); }
+
+	HeadWord				mHead __attribute__((aligned(16)));
+#else
+	HeadWord	load() const { return mHead.load(std::memory_order_acquire); }
+	void		store(HeadWord head_) { mHead.store(head_, std::memory_order_relaxed); }
+	bool		compare_and_swap(HeadWord oldvalue, HeadWord newvalue) { return mHead.compare_exchange_weak(oldvalue, newvalue, std::memory_order_acq_rel, std::memory_order_acquire); }
+
+	std::atomic<HeadWord>	mHead;
+#endif
+};
+
+/*=============================================================================
+	TAtomicNodePool
+
+	A fixed number of T's, allocated up front, that any thread can take and give back
+	lock-free in O(1), so the IO thread can allocate from it. allocate() returns NULL
+	when all of them are in use. The T's are constructed once with the pool and are
+	handed out as they were given back.
+=============================================================================*/
+
+template <class T>
+class TAtomicNodePool {
+public:
+	TAtomicNodePool(UInt32 inCapacity) : mNodes(new Node[inCapacity]), mCapacity(inCapacity), mNumberInUse(0)
+	{
+		// push them backwards so that they are handed out in address order
+		for (UInt32 i = inCapacity; i > 0; --i)
+			mFreeNodes.push_NA(&mNodes[i - 1]);
+	}
+	~TAtomicNodePool() { delete[] mNodes; }
+	
+	T *		allocate()
+	{
+		Node *node = mFreeNodes.pop_atomic();
+		if (node == NULL)
+			return NULL;
+		mNumberInUse.fetch_add(1, std::memory_order_relaxed);
+		return &node->mObject;
+	}
+	
+	void	deallocate(T *item)
+	{
+		mNumberInUse.fetch_sub(1, std::memory_order_relaxed);
+		mFreeNodes.push_atomic(node_of(item));
+	}
+	
+	bool	owns(const T *item) const
+	{
+		const char *p = (const char *)item;
+		return p >= (const char *)mNodes && p < (const char *)(mNodes + mCapacity);
+	}
+	
+	UInt32	capacity() const { return mCapacity; }
+	UInt32	number_in_use() const { return mNumberInUse.load(std::memory_order_relaxed); }
+
+private:
+	TAtomicNodePool(const TAtomicNodePool&);
+	TAtomicNodePool& operator=(const TAtomicNodePool&);
+
+	//	the pool links free nodes through its own field, so the T's are never written while
+	//	they are handed out
+	struct Node {
+		Node *	mNext;
+		T		mObject;
+		
+		Node *&	next() { return mNext; }
+	};
+	
+	Node *	node_of(T *item) const { return mNodes + ((char *)item - (char *)&mNodes[0].mObject) / sizeof(Node); }
+
+	Node *						mNodes;
+	UInt32						mCapacity;
+	std::atomic<UInt32>			mNumberInUse;
+	TAtomicTaggedStack<Node>	mFreeNodes;
+};
+
+#if ((MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_X_VERSION_10_5) && !TARGET_OS_WIN32 && !defined(__linux__))
 #include <libkern/OSAtomic.h>
 
 class CAAtomicStack {
@@ -232,8 +467,8 @@ private:
 
 #else
 
-#define TAtomicStack2 TAtomicStack
+#define TAtomicStack2 TAtomicTaggedStack
 
-#endif // MAC_OS_X_VERSION_MAX_ALLOWED && !TARGET_OS_WIN32
+#endif // MAC_OS_X_VERSION_MAX_ALLOWED && !TARGET_OS_WIN32 && !__linux__
 
 #endif // __CAAtomicStack_h__
@@ -49,11 +49,38 @@
 //=============================================================================
 
 #include "CAAudioBufferList.h"
+#include "CABufferPool.h"
 #include "CADebugMacros.h"
 #include "CALogMacros.h"
+#include "CAVectorKernels.h"
 #include <stdlib.h>
 #include <string.h>
 
+//=============================================================================
+//	Helpers
+//=============================================================================
+
+namespace
+{
+	//	how many buffers Copy() interleaves or deinterleaves with one call to the kernel
+	const UInt32	kMaximumNumberGatheredBuffers = 16;
+
+	inline UInt32	GetNumberFrames(const AudioBuffer& inBuffer)
+	{
+		return (inBuffer.mNumberChannels > 0) ? inBuffer.mDataByteSize / (inBuffer.mNumberChannels * SizeOf32(Float32)) : 0;
+	}
+
+	inline UInt32	Minimum(UInt32 inA, UInt32 inB)
+	{
+		return (inA < inB) ? inA : inB;
+	}
+
+	inline bool	IsMonoBuffer(const AudioBuffer& inBuffer)
+	{
+		return (inBuffer.mNumberChannels == 1) && (inBuffer.mData != NULL);
+	}
+}
+
 //=============================================================================
 //	CAAudioBufferList
 //=============================================================================
@@ -61,9 +88,10 @@
 AudioBufferList*	CAAudioBufferList::Create(UInt32 inNumberBuffers)
 {
 	UInt32 theSize = CalculateByteSize(inNumberBuffers);
-	AudioBufferList* theAnswer = static_cast<AudioBufferList*>(calloc(1, theSize));
+	AudioBufferList* theAnswer = static_cast<AudioBufferList*>(CABufferPool::Allocate(theSize));
 	if(theAnswer != NULL)
 	{
+		memset(theAnswer, 0, theSize);
 		theAnswer->mNumberBuffers = inNumberBuffers;
 	}
 	return theAnswer;
@@ -71,7 +99,7 @@ AudioBufferList*	CAAudioBufferList::Create(UInt32 inNumberBuffers)
 
 void	CAAudioBufferList::Destroy(AudioBufferList* inBufferList)
 {
-	free(inBufferList);
+	CABufferPool::Deallocate(inBufferList);
 }
 
 UInt32	CAAudioBufferList::CalculateByteSize(UInt32 inNumberBuffers)
@@ -128,9 +156,10 @@ void	CAAudioBufferList::Clear(AudioBufferList& outBufferList)
 
 void	CAAudioBufferList::Copy(const AudioBufferList& inSource, UInt32 inStartingSourceChannel, AudioBufferList& outDestination, UInt32 inStartingDestinationChannel)
 {
-	//  This is a brute force copy method that can handle ABL's that have different buffer layouts
-	//  This means that this method is probably not the fastest way to do this for all cases.
-	//  This method also assumes that both the source and destination sample formats are Float32
+	//  This method can handle ABL's that have different buffer layouts. It copies as many adjacent
+	//  channels at a time as both layouts allow, and runs of mono buffers on one side and an
+	//  interleaved buffer on the other are interleaved or deinterleaved in one go.
+	//  This method assumes that both the source and destination sample formats are Float32
 
 	UInt32 theInputChannel = inStartingSourceChannel;
 	UInt32 theNumberInputChannels = GetTotalNumberChannels(inSource);
@@ -145,39 +174,82 @@ void	CAAudioBufferList::Copy(const AudioBufferList& inSource, UInt32 inStartingS
 	{
 		GetBufferForChannel(inSource, theInputChannel, theInputBufferIndex, theInputBufferChannel);
 		
-		GetBufferForChannel(inSource, theOutputChannel, theOutputBufferIndex, theOutputBufferChannel);
+		GetBufferForChannel(outDestination, theOutputChannel, theOutputBufferIndex, theOutputBufferChannel);
+		
+		const AudioBuffer& theSourceBuffer = inSource.mBuffers[theInputBufferIndex];
+		AudioBuffer& theDestinationBuffer = outDestination.mBuffers[theOutputBufferIndex];
+		const Float32* theSource = static_cast<const Float32*>(theSourceBuffer.mData);
+		Float32* theDestination = static_cast<Float32*>(theDestinationBuffer.mData);
+		UInt32 theNumberFrames = Minimum(GetNumberFrames(theSourceBuffer), GetNumberFrames(theDestinationBuffer));
+		UInt32 theNumberChannels = Minimum(theSourceBuffer.mNumberChannels - theInputBufferChannel, theDestinationBuffer.mNumberChannels - theOutputBufferChannel);
 		
-		CopyChannel(inSource.mBuffers[theInputBufferIndex], theInputBufferChannel, outDestination.mBuffers[theOutputBufferIndex], theOutputBufferChannel);
+		if((theSource == NULL) || (theDestination == NULL))
+		{
+			//	nothing to copy from or to, so skip the channels
+		}
+		else if(IsMonoBuffer(theSourceBuffer) && (theDestinationBuffer.mNumberChannels - theOutputBufferChannel > 1))
+		{
+			//	gather the following mono buffers that go into the same interleaved buffer
+			const Float32* theSources[kMaximumNumberGatheredBuffers];
+			UInt32 theMaximumNumberChannels = Minimum(Minimum(theDestinationBuffer.mNumberChannels - theOutputBufferChannel, theNumberInputChannels - theInputChannel), kMaximumNumberGatheredBuffers);
+			theNumberChannels = 0;
+			while((theNumberChannels < theMaximumNumberChannels) && IsMonoBuffer(inSource.mBuffers[theInputBufferIndex + theNumberChannels]))
+			{
+				theSources[theNumberChannels] = static_cast<const Float32*>(inSource.mBuffers[theInputBufferIndex + theNumberChannels].mData);
+				theNumberFrames = Minimum(theNumberFrames, GetNumberFrames(inSource.mBuffers[theInputBufferIndex + theNumberChannels]));
+				++theNumberChannels;
+			}
+			CAVectorKernels::Interleave(theSources, theNumberChannels, theDestination + theOutputBufferChannel, theDestinationBuffer.mNumberChannels, theNumberFrames);
+		}
+		else if(IsMonoBuffer(theDestinationBuffer) && (theSourceBuffer.mNumberChannels - theInputBufferChannel > 1))
+		{
+			Float32* theDestinations[kMaximumNumberGatheredBuffers];
+			UInt32 theMaximumNumberChannels = Minimum(Minimum(theSourceBuffer.mNumberChannels - theInputBufferChannel, theNumberOutputChannels - theOutputChannel), kMaximumNumberGatheredBuffers);
+			theNumberChannels = 0;
+			while((theNumberChannels < theMaximumNumberChannels) && IsMonoBuffer(outDestination.mBuffers[theOutputBufferIndex + theNumberChannels]))
+			{
+				theDestinations[theNumberChannels] = static_cast<Float32*>(outDestination.mBuffers[theOutputBufferIndex + theNumberChannels].mData);
+				theNumberFrames = Minimum(theNumberFrames, GetNumberFrames(outDestination.mBuffers[theOutputBufferIndex + theNumberChannels]));
+				++theNumberChannels;
+			}
+			CAVectorKernels::Deinterleave(theSource + theInputBufferChannel, theSourceBuffer.mNumberChannels, theDestinations, theNumberChannels, theNumberFrames);
+		}
+		else
+		{
+			CAVectorKernels::CopyChannels(theSource + theInputBufferChannel, theSourceBuffer.mNumberChannels, theDestination + theOutputBufferChannel, theDestinationBuffer.mNumberChannels, theNumberChannels, theNumberFrames);
+		}
 		
-		++theInputChannel;
-		++theOutputChannel;
+		theInputChannel += theNumberChannels;
+		theOutputChannel += theNumberChannels;
 	}
 }
 
 void	CAAudioBufferList::CopyChannel(const AudioBuffer& inSource, UInt32 inSourceChannel, AudioBuffer& outDestination, UInt32 inDestinationChannel)
 {
-	//  set up the stuff for the loop
-	UInt32 theNumberFramesToCopy = outDestination.mDataByteSize / (outDestination.mNumberChannels * SizeOf32(Float32));
+	//  only as many frames as both buffers have
+	UInt32 theNumberFramesToCopy = Minimum(GetNumberFrames(inSource), GetNumberFrames(outDestination));
 	const Float32* theSource = static_cast<const Float32*>(inSource.mData);
 	Float32* theDestination = static_cast<Float32*>(outDestination.mData);
-	
-	//  loop through the data and copy the samples
-	while(theNumberFramesToCopy > 0)
+	CAVectorKernels::CopyChannels(theSource + inSourceChannel, inSource.mNumberChannels, theDestination + inDestinationChannel, outDestination.mNumberChannels, 1, theNumberFramesToCopy);
+}
+
+void	CAAudioBufferList::Sum(const AudioBufferList& inSourceBufferList, AudioBufferList& ioSummedBufferList)
+{
+	//	assumes that the buffers are Float32 samples and the lists have the same layout
+	for(UInt32 theBufferIndex = 0; theBufferIndex < ioSummedBufferList.mNumberBuffers; ++theBufferIndex)
 	{
-		//  copy the data
-		theDestination[inDestinationChannel] = theSource[inSourceChannel];
-		
-		//  adjust the pointers
-		--theNumberFramesToCopy;
-		theSource += inSource.mNumberChannels;
-		theDestination += outDestination.mNumberChannels;
+		Float32* theSourceBuffer = static_cast<Float32*>(inSourceBufferList.mBuffers[theBufferIndex].mData);
+		Float32* theSummedBuffer = static_cast<Float32*>(ioSummedBufferList.mBuffers[theBufferIndex].mData);
+		UInt32 theNumberSamplesToMix = ioSummedBufferList.mBuffers[theBufferIndex].mDataByteSize / SizeOf32(Float32);
+		if((theSourceBuffer != NULL) && (theSummedBuffer != NULL) && (theNumberSamplesToMix > 0))
+		{
+			CAVectorKernels::Add(theSourceBuffer, theSummedBuffer, theNumberSamplesToMix);
+		}
 	}
 }
 
-void	CAAudioBufferList::Sum(const AudioBufferList& inSourceBufferList, AudioBufferList& ioSummedBufferList)
+void	CAAudioBufferList::Sum(const AudioBufferList& inSourceBufferList, Float32 inGain, AudioBufferList& ioSummedBufferList)
 {
-	//	assumes that the buffers are Float32 samples and the listst have the same layout
-	//	this is a lame algorithm, by the way. it could at least be unrolled a couple of times
 	for(UInt32 theBufferIndex = 0; theBufferIndex < ioSummedBufferList.mNumberBuffers; ++theBufferIndex)
 	{
 		Float32* theSourceBuffer = static_cast<Float32*>(inSourceBufferList.mBuffers[theBufferIndex].mData);
@@ -185,13 +257,7 @@ void	CAAudioBufferList::Sum(const AudioBufferList& inSourceBufferList, AudioBuff
 		UInt32 theNumberSamplesToMix = ioSummedBufferList.mBuffers[theBufferIndex].mDataByteSize / SizeOf32(Float32);
 		if((theSourceBuffer != NULL) && (theSummedBuffer != NULL) && (theNumberSamplesToMix > 0))
 		{
-			while(theNumberSamplesToMix > 0)
-			{
-				*theSummedBuffer += *theSourceBuffer;
-				++theSummedBuffer;
-				++theSourceBuffer;
-				--theNumberSamplesToMix;
-			}
+			CAVectorKernels::AddScaled(theSourceBuffer, theSummedBuffer, theNumberSamplesToMix, inGain);
 		}
 	}
 }
@@ -76,6 +76,7 @@ struct	CAAudioBufferList
 
 //	Construction/Destruction
 public:
+	//	the lists come from CABufferPool, so Destroy() is the only way to free them
 	static AudioBufferList*	Create(UInt32 inNumberBuffers);
 	static void				Destroy(AudioBufferList* inBufferList);
 	static UInt32			CalculateByteSize(UInt32 inNumberBuffers);
@@ -85,9 +86,11 @@ public:
 	static UInt32			GetTotalNumberChannels(const AudioBufferList& inBufferList);
 	static bool				GetBufferForChannel(const AudioBufferList& inBufferList, UInt32 inChannel, UInt32& outBufferNumber, UInt32& outBufferChannel);
 	static void				Clear(AudioBufferList& outBufferList);
+	//	Float32 samples, any mix of interleaved and mono buffers on either side
 	static void				Copy(const AudioBufferList& inSource, UInt32 inStartingSourceChannel, AudioBufferList& outDestination, UInt32 inStartingDestinationChannel);
 	static void				CopyChannel(const AudioBuffer& inSource, UInt32 inSourceChannel, AudioBuffer& outDestination, UInt32 inDestinationChannel);
 	static void				Sum(const AudioBufferList& inSourceBufferList, AudioBufferList& ioSummedBufferList);
+	static void				Sum(const AudioBufferList& inSourceBufferList, Float32 inGain, AudioBufferList& ioSummedBufferList);	// ioSum += inGain * inSource
 	static bool				HasData(AudioBufferList& inBufferList);
 #if	CoreAudio_Debug
 	static void				PrintToLog(const AudioBufferList& inBufferList);
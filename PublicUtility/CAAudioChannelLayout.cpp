@@ -132,6 +132,115 @@ UInt32	CAAudioChannelLayout::NumberChannels (const AudioChannelLayout& inLayout)
 	return AudioChannelLayoutTag_GetNumberOfChannels(inLayout.mChannelLayoutTag);
 }
 
+// the channel order of the common layout tags, as in CoreAudioTypes.h
+namespace
+{
+	const AudioChannelLabel kL = kAudioChannelLabel_Left;
+	const AudioChannelLabel kR = kAudioChannelLabel_Right;
+	const AudioChannelLabel kC = kAudioChannelLabel_Center;
+	const AudioChannelLabel kLFE = kAudioChannelLabel_LFEScreen;
+	const AudioChannelLabel kLs = kAudioChannelLabel_LeftSurround;
+	const AudioChannelLabel kRs = kAudioChannelLabel_RightSurround;
+	const AudioChannelLabel kLc = kAudioChannelLabel_LeftCenter;
+	const AudioChannelLabel kRc = kAudioChannelLabel_RightCenter;
+	const AudioChannelLabel kCs = kAudioChannelLabel_CenterSurround;
+	const AudioChannelLabel kRls = kAudioChannelLabel_RearSurroundLeft;
+	const AudioChannelLabel kRrs = kAudioChannelLabel_RearSurroundRight;
+	const AudioChannelLabel kLw = kAudioChannelLabel_LeftWide;
+	const AudioChannelLabel kRw = kAudioChannelLabel_RightWide;
+	const AudioChannelLabel kLt = kAudioChannelLabel_LeftTotal;
+	const AudioChannelLabel kRt = kAudioChannelLabel_RightTotal;
+
+	struct LayoutTagLabels
+	{
+		AudioChannelLayoutTag	mTag;
+		AudioChannelLabel		mLabels[8];
+	};
+
+	const LayoutTagLabels kLayoutTagLabels[] =
+	{
+		{ kAudioChannelLayoutTag_Mono,					{ kAudioChannelLabel_Mono } },
+		{ kAudioChannelLayoutTag_Stereo,				{ kL, kR } },
+		{ kAudioChannelLayoutTag_StereoHeadphones,		{ kAudioChannelLabel_HeadphonesLeft, kAudioChannelLabel_HeadphonesRight } },
+		{ kAudioChannelLayoutTag_MatrixStereo,			{ kLt, kRt } },
+		{ kAudioChannelLayoutTag_Quadraphonic,			{ kL, kR, kLs, kRs } },
+		{ kAudioChannelLayoutTag_Pentagonal,			{ kL, kR, kRls, kRrs, kC } },
+		{ kAudioChannelLayoutTag_Hexagonal,				{ kL, kR, kRls, kRrs, kC, kCs } },
+		{ kAudioChannelLayoutTag_Octagonal,				{ kL, kR, kRls, kRrs, kC, kCs, kLw, kRw } },
+		{ kAudioChannelLayoutTag_MPEG_3_0_A,			{ kL, kR, kC } },
+		{ kAudioChannelLayoutTag_MPEG_3_0_B,			{ kC, kL, kR } },
+		{ kAudioChannelLayoutTag_MPEG_4_0_A,			{ kL, kR, kC, kCs } },
+		{ kAudioChannelLayoutTag_MPEG_4_0_B,			{ kC, kL, kR, kCs } },
+		{ kAudioChannelLayoutTag_MPEG_5_0_A,			{ kL, kR, kC, kLs, kRs } },
+		{ kAudioChannelLayoutTag_MPEG_5_0_B,			{ kL, kR, kLs, kRs, kC } },
+		{ kAudioChannelLayoutTag_MPEG_5_0_C,			{ kL, kC, kR, kLs, kRs } },
+		{ kAudioChannelLayoutTag_MPEG_5_0_D,			{ kC, kL, kR, kLs, kRs } },
+		{ kAudioChannelLayoutTag_MPEG_5_1_A,			{ kL, kR, kC, kLFE, kLs, kRs } },
+		{ kAudioChannelLayoutTag_MPEG_5_1_B,			{ kL, kR, kLs, kRs, kC, kLFE } },
+		{ kAudioChannelLayoutTag_MPEG_5_1_C,			{ kL, kC, kR, kLs, kRs, kLFE } },
+		{ kAudioChannelLayoutTag_MPEG_5_1_D,			{ kC, kL, kR, kLs, kRs, kLFE } },
+		{ kAudioChannelLayoutTag_MPEG_6_1_A,			{ kL, kR, kC, kLFE, kLs, kRs, kCs } },
+		{ kAudioChannelLayoutTag_MPEG_7_1_A,			{ kL, kR, kC, kLFE, kLs, kRs, kLc, kRc } },
+		{ kAudioChannelLayoutTag_MPEG_7_1_B,			{ kC, kLc, kRc, kL, kR, kLs, kRs, kLFE } },
+		{ kAudioChannelLayoutTag_MPEG_7_1_C,			{ kL, kR, kC, kLFE, kLs, kRs, kRls, kRrs } },
+		{ kAudioChannelLayoutTag_Emagic_Default_7_1,	{ kL, kR, kLs, kRs, kC, kLFE, kLc, kRc } },
+		{ kAudioChannelLayoutTag_SMPTE_DTV,				{ kL, kR, kC, kLFE, kLs, kRs, kLt, kRt } },
+		{ kAudioChannelLayoutTag_ITU_2_1,				{ kL, kR, kCs } },
+		{ kAudioChannelLayoutTag_ITU_2_2,				{ kL, kR, kLs, kRs } },
+		{ kAudioChannelLayoutTag_AudioUnit_6_0,			{ kL, kR, kLs, kRs, kC, kCs } },
+		{ kAudioChannelLayoutTag_AudioUnit_7_0,			{ kL, kR, kLs, kRs, kC, kRls, kRrs } },
+		{ kAudioChannelLayoutTag_AudioUnit_7_0_Front,	{ kL, kR, kLs, kRs, kC, kLc, kRc } }
+	};
+}
+
+void	CAAudioChannelLayout::GetChannelLabels(const AudioChannelLayout& inLayout, AudioChannelLabel* outLabels)
+{
+	UInt32 theNumberChannels = NumberChannels(inLayout);
+	for(UInt32 theChannelIndex = 0; theChannelIndex < theNumberChannels; ++theChannelIndex)
+	{
+		outLabels[theChannelIndex] = kAudioChannelLabel_Unknown;
+	}
+	
+	if(inLayout.mChannelLayoutTag == kAudioChannelLayoutTag_UseChannelDescriptions)
+	{
+		for(UInt32 theChannelIndex = 0; theChannelIndex < theNumberChannels; ++theChannelIndex)
+		{
+			AudioChannelLabel theLabel = inLayout.mChannelDescriptions[theChannelIndex].mChannelLabel;
+			outLabels[theChannelIndex] = (theLabel == kAudioChannelLabel_UseCoordinates) ? kAudioChannelLabel_Unknown : theLabel;
+		}
+	}
+	else if(inLayout.mChannelLayoutTag == kAudioChannelLayoutTag_UseChannelBitmap)
+	{
+		//	up to kAudioChannelBit_TopBackRight, bit n is the channel with the label n + 1
+		UInt32 theChannelIndex = 0;
+		for(UInt32 theBit = 0; (theBit < 32) && (theChannelIndex < theNumberChannels); ++theBit)
+		{
+			if((inLayout.mChannelBitmap & (1U << theBit)) != 0)
+			{
+				outLabels[theChannelIndex++] = (theBit < 18) ? theBit + 1 : kAudioChannelLabel_Unknown;
+			}
+		}
+	}
+	else if((inLayout.mChannelLayoutTag & 0xFFFF0000) == kAudioChannelLayoutTag_DiscreteInOrder)
+	{
+		for(UInt32 theChannelIndex = 0; theChannelIndex < theNumberChannels; ++theChannelIndex)
+		{
+			outLabels[theChannelIndex] = kAudioChannelLabel_Discrete_0 + theChannelIndex;
+		}
+	}
+	else
+	{
+		for(UInt32 theTagIndex = 0; theTagIndex < sizeof(kLayoutTagLabels) / sizeof(kLayoutTagLabels[0]); ++theTagIndex)
+		{
+			if(kLayoutTagLabels[theTagIndex].mTag == inLayout.mChannelLayoutTag)
+			{
+				memcpy(outLabels, kLayoutTagLabels[theTagIndex].mLabels, theNumberChannels * sizeof(AudioChannelLabel));
+				break;
+			}
+		}
+	}
+}
+
 void 	CAShowAudioChannelLayout (FILE* file, const AudioChannelLayout *layout)
 {
 	if (layout == NULL) 
@@ -90,6 +90,10 @@ public:
 								}
 	static void					SetAllToUnknown(AudioChannelLayout& outChannelLayout, UInt32 inNumberChannelDescriptions);
 	static UInt32				NumberChannels(const AudioChannelLayout& inLayout);
+	static void					GetChannelLabels(const AudioChannelLayout& inLayout, AudioChannelLabel* outLabels);
+									// fills in the label of each of the NumberChannels(inLayout) channels,
+									// for the common layout tags and bitmaps too. The channels of a tag
+									// that isn't known and the ones with coordinates are Unknown
 	
 #if !HAL_Build
 // object methods	
@@ -62,6 +62,9 @@ inline void* CA_realloc(void* old, size_t size)
 {
 #if TARGET_OS_WIN32
 	void* p = realloc(old, size);
+#elif defined(__linux__)
+	void* p = realloc(old, size);
+	if (!p && size) free(old);	// what reallocf does
 #else
 	void* p = reallocf(old, size); // reallocf ensures the old pointer is freed if memory is full (p is NULL).
 #endif
@@ -45,18 +45,29 @@
  
 */
 #include "CABufferList.h"
+#include "CABufferPool.h"
 #include "CAByteOrder.h"
+#include <new>
+
+Byte *		CABufferList::AllocateBufferMemory(UInt32 nBytes)
+{
+	// the pool only returns NULL on a real time thread that didn't reserve enough
+	Byte *memory = static_cast<Byte *>(CABufferPool::Allocate(nBytes));
+	if (memory == NULL)
+		throw std::bad_alloc();
+	return memory;
+}
 
 void		CABufferList::AllocateBuffers(UInt32 nBytes)
 {
 	if (nBytes <= GetNumBytes()) return;
 
 	if (mABL.mNumberBuffers > 1)
-		// align successive buffers for Altivec and to take alternating
-		// cache line hits by spacing them by odd multiples of 16
-		nBytes = ((nBytes + 15) & ~15) | 16;
+		// align successive buffers to cache lines and take alternating
+		// cache line hits by spacing them by odd multiples of 64
+		nBytes = ((nBytes + 63) & ~63) | 64;
 	UInt32 memorySize = nBytes * mABL.mNumberBuffers;
-	Byte *newMemory = new Byte[memorySize], *p = newMemory;
+	Byte *newMemory = AllocateBufferMemory(memorySize), *p = newMemory;
 	memset(newMemory, 0, memorySize);	// get page faults now, not later
 	
 	AudioBuffer *buf = mABL.mBuffers;
@@ -71,7 +82,7 @@ void		CABufferList::AllocateBuffers(UInt32 nBytes)
 	Byte *oldMemory = mBufferMemory;
 	mBufferMemory = newMemory;
 	mBufferCapacity = nBytes;
-	delete[] oldMemory;
+	CABufferPool::Deallocate(oldMemory);
 }
 
 void		CABufferList::AllocateBuffersAndCopyFrom(UInt32 nBytes, CABufferList *inSrcList, CABufferList *inSetPtrList)
@@ -86,11 +97,11 @@ void		CABufferList::AllocateBuffersAndCopyFrom(UInt32 nBytes, CABufferList *inSr
 	UInt32 fromByteSize = inSrcList->GetNumBytes();
 	
 	if (mABL.mNumberBuffers > 1)
-		// align successive buffers for Altivec and to take alternating
-		// cache line hits by spacing them by odd multiples of 16
-		nBytes = ((nBytes + 15) & ~15) | 16;
+		// align successive buffers to cache lines and take alternating
+		// cache line hits by spacing them by odd multiples of 64
+		nBytes = ((nBytes + 63) & ~63) | 64;
 	UInt32 memorySize = nBytes * mABL.mNumberBuffers;
-	Byte *newMemory = new Byte[memorySize], *p = newMemory;
+	Byte *newMemory = AllocateBufferMemory(memorySize), *p = newMemory;
 	memset(newMemory, 0, memorySize);	// make buffer "hot"
 	
 	AudioBuffer *buf = mABL.mBuffers;
@@ -111,7 +122,7 @@ void		CABufferList::AllocateBuffersAndCopyFrom(UInt32 nBytes, CABufferList *inSr
 	mBufferCapacity = nBytes;
 	if (inSrcList != inSetPtrList)
 		inSrcList->BytesConsumed(fromByteSize);
-	delete[] oldMemory;
+	CABufferPool::Deallocate(oldMemory);
 }
 
 void		CABufferList::DeallocateBuffers()
@@ -122,7 +133,7 @@ void		CABufferList::DeallocateBuffers()
 		buf->mDataByteSize = 0;
 	}
 	if (mBufferMemory != NULL) {
-		delete[] mBufferMemory;
+		CABufferPool::Deallocate(mBufferMemory);
 		mBufferMemory = NULL;
 		mBufferCapacity = 0;
 	}
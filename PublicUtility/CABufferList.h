@@ -104,8 +104,7 @@ protected:
 public:
 	~CABufferList()
 	{
-		if (mBufferMemory)
-			delete[] mBufferMemory;
+		DeallocateBuffers();
 	}
 	
 	const char *				Name() { return mName; }
@@ -259,6 +258,7 @@ public:
 		return abl;
 	}
 	
+	// the owned memory comes from CABufferPool, so every buffer starts on a cache line
 	void		AllocateBuffers(UInt32 nBytes);
 	void		AllocateBuffersAndCopyFrom(UInt32 nBytes, CABufferList *inCopyFromList, CABufferList *inSetPtrList);
 	
@@ -305,6 +305,8 @@ public:
 	}
 
 protected:
+	static Byte *		AllocateBufferMemory(UInt32 nBytes);
+
 	AudioBufferList &	_GetBufferList() { return mABL; }	// use with care
 							// if we make this public, then we lose ability to call VerifyNotTrashingOwnedBuffer
 	void				VerifyNotTrashingOwnedBuffer()
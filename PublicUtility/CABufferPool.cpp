@@ -0,0 +1,616 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CABufferPool.h"
+
+//	PublicUtility Includes
+#include "CAAtomicStack.h"
+#include "CABitOperations.h"
+#include "CADebugMacros.h"
+
+//	System Includes
+#include <pthread.h>
+
+//	Standard Library Includes
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//==================================================================================================
+//	Implementation
+//
+//	Every block is preceded by a header of its own cache line that says which size class it
+//	belongs to. The header is also the link of the free lists, so a free block is never written
+//	through the pointer it was handed out with, and a thread that loses a pop on a shared stack
+//	only ever reads a header.
+//
+//	A thread counts its own allocations in its cache, with plain loads and stores, so the fast
+//	path has no read-modify-write on memory that other threads write. The shared counters only
+//	change when a block moves between a thread and the shared stacks or the heap. Adding it all
+//	up takes the lock of the list of thread caches.
+//==================================================================================================
+
+namespace
+{
+	enum
+	{
+		kInUseMagic					= 'bpiu',
+		kFreeMagic					= 'bpfr',
+		kNumberSizeClasses			= CABufferPool::kNumberSizeClasses,
+		kOversizeClass				= CABufferPool::kNumberSizeClasses,
+		
+		//	a thread keeps at most this many bytes of every size class for itself
+		kThreadCacheBytes			= 256 * 1024,
+		kMaximumThreadCacheDepth	= 16
+	};
+
+	struct BlockHeader
+	{
+		BlockHeader*	mNext;
+		UInt32			mMagic;
+		UInt32			mSizeClass;
+		size_t			mBlockSize;
+		
+		BlockHeader*&	next()			{ return mNext; }
+		void*			GetBlock()		{ return reinterpret_cast<char*>(this) + CABufferPool::kAlignment; }
+		
+		static BlockHeader*	Get(const void* inBlock)	{ return reinterpret_cast<BlockHeader*>(const_cast<char*>(static_cast<const char*>(inBlock)) - CABufferPool::kAlignment); }
+	};
+	
+	static_assert(sizeof(BlockHeader) <= CABufferPool::kAlignment, "the block header has to fit in the alignment");
+
+	struct __attribute__((aligned(64))) SizeClass
+	{
+		TAtomicTaggedStack<BlockHeader>	mSharedBlocks;		//	for the large blocks, the ones a real time thread freed
+		std::atomic<UInt64>		mNumberSharedBlocks;
+		std::atomic<UInt64>		mNumberBlocks;				//	in use, shared or in a thread cache
+		std::atomic<UInt64>		mNumberBytes;				//	of all of them
+		std::atomic<UInt64>		mNumberBlocksOut;			//	in use or in a thread cache
+		std::atomic<UInt64>		mPeakNumberBlocksOut;
+		std::atomic<UInt64>		mNumberHeapAllocations;
+		std::atomic<UInt64>		mNumberFailedAllocations;
+		std::atomic<UInt64>		mNumberLargeBytesInUse;		//	only kept for the large blocks
+		
+		//	what the threads that are gone counted
+		std::atomic<UInt64>		mNumberRetiredAllocations;
+		std::atomic<SInt64>		mNumberRetiredBlocksInUse;
+	};
+
+	//	only its own thread writes a cache, anybody may read its counters
+	struct ThreadCache
+	{
+		BlockHeader*			mBlocks[kNumberSizeClasses];
+		UInt32					mNumberBlocks[kNumberSizeClasses];
+		std::atomic<UInt64>		mNumberAllocations[kNumberSizeClasses + 1];
+		std::atomic<SInt64>		mNumberBlocksInUse[kNumberSizeClasses + 1];		//	less than zero when it freed the blocks of other threads
+		bool					mIsRealTime;
+		ThreadCache*			mNext;
+		ThreadCache*			mPrevious;
+	};
+	
+	void	DeleteThreadCache(void* inThreadCache);
+	
+	//	the key only deletes the cache when its thread exits, this is the faster way to find it
+	thread_local ThreadCache*	tThreadCache = NULL;
+
+	struct CABufferPoolState
+	{
+		SizeClass		mSizeClasses[kNumberSizeClasses + 1];
+		pthread_key_t	mThreadCacheKey;
+		pthread_mutex_t	mThreadCacheMutex;		//	guards the list of thread caches
+		ThreadCache*	mFirstThreadCache;
+		
+						CABufferPoolState() : mFirstThreadCache(NULL) { pthread_key_create(&mThreadCacheKey, DeleteThreadCache); pthread_mutex_init(&mThreadCacheMutex, NULL); }
+		
+		//	never destroyed, the threads that are still running at exit may use it
+		static CABufferPoolState&	Get() { static CABufferPoolState sState; return sState; }
+	};
+	
+	inline UInt32	GetThreadCacheDepth(UInt32 inSizeClass)
+	{
+		size_t theDepth = kThreadCacheBytes / CABufferPool::GetSizeClassBlockSize(inSizeClass);
+		return static_cast<UInt32>(theDepth < kMaximumThreadCacheDepth ? theDepth : kMaximumThreadCacheDepth);
+	}
+	
+	//	the free lists are written while a losing pop on a shared stack may read them, see TAtomicTaggedStack
+	inline void		SetNext(BlockHeader* inHeader, BlockHeader* inNext)	{ __atomic_store_n(&inHeader->mNext, inNext, __ATOMIC_RELAXED); }
+	
+	//	for the counters that only one thread writes
+	template <typename T>
+	inline void		AddToOwnCounter(std::atomic<T>& ioCounter, T inValue)	{ ioCounter.store(ioCounter.load(std::memory_order_relaxed) + inValue, std::memory_order_relaxed); }
+	
+	ThreadCache*	GetThreadCache(bool inCanCreate)
+	{
+		ThreadCache* theThreadCache = tThreadCache;
+		if((theThreadCache == NULL) && inCanCreate)
+		{
+			theThreadCache = new(std::nothrow) ThreadCache();
+			if(theThreadCache != NULL)
+			{
+				CABufferPoolState& theState = CABufferPoolState::Get();
+				pthread_mutex_lock(&theState.mThreadCacheMutex);
+				theThreadCache->mNext = theState.mFirstThreadCache;
+				if(theState.mFirstThreadCache != NULL)
+				{
+					theState.mFirstThreadCache->mPrevious = theThreadCache;
+				}
+				theState.mFirstThreadCache = theThreadCache;
+				pthread_mutex_unlock(&theState.mThreadCacheMutex);
+				pthread_setspecific(theState.mThreadCacheKey, theThreadCache);
+				tThreadCache = theThreadCache;
+			}
+		}
+		return theThreadCache;
+	}
+	
+	void	CountAllocation(ThreadCache* inThreadCache, UInt32 inSizeClassIndex, SInt64 inNumberBlocks)
+	{
+		if(inThreadCache != NULL)
+		{
+			if(inNumberBlocks > 0)
+			{
+				AddToOwnCounter(inThreadCache->mNumberAllocations[inSizeClassIndex], UInt64(1));
+			}
+			AddToOwnCounter(inThreadCache->mNumberBlocksInUse[inSizeClassIndex], inNumberBlocks);
+		}
+		else
+		{
+			SizeClass& theSizeClass = CABufferPoolState::Get().mSizeClasses[inSizeClassIndex];
+			if(inNumberBlocks > 0)
+			{
+				theSizeClass.mNumberRetiredAllocations.fetch_add(1, std::memory_order_relaxed);
+			}
+			theSizeClass.mNumberRetiredBlocksInUse.fetch_add(inNumberBlocks, std::memory_order_relaxed);
+		}
+	}
+	
+	//	a block leaves the shared stacks and the heap for a thread, or comes back
+	void	CheckOut(SizeClass& inSizeClass)
+	{
+		UInt64 theNumberBlocksOut = inSizeClass.mNumberBlocksOut.fetch_add(1, std::memory_order_relaxed) + 1;
+		UInt64 thePeakNumberBlocksOut = inSizeClass.mPeakNumberBlocksOut.load(std::memory_order_relaxed);
+		while((theNumberBlocksOut > thePeakNumberBlocksOut) && !inSizeClass.mPeakNumberBlocksOut.compare_exchange_weak(thePeakNumberBlocksOut, theNumberBlocksOut, std::memory_order_relaxed))
+		{
+		}
+	}
+	
+	void	CheckIn(SizeClass& inSizeClass)
+	{
+		inSizeClass.mNumberBlocksOut.fetch_sub(1, std::memory_order_relaxed);
+	}
+	
+	void	PushSharedBlock(SizeClass& inSizeClass, BlockHeader* inHeader)
+	{
+		inSizeClass.mSharedBlocks.push_atomic(inHeader);
+		inSizeClass.mNumberSharedBlocks.fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	BlockHeader*	PopSharedBlock(SizeClass& inSizeClass)
+	{
+		BlockHeader* theHeader = inSizeClass.mSharedBlocks.pop_atomic();
+		if(theHeader != NULL)
+		{
+			inSizeClass.mNumberSharedBlocks.fetch_sub(1, std::memory_order_relaxed);
+		}
+		return theHeader;
+	}
+	
+	void	FlushThreadCache(ThreadCache* inThreadCache)
+	{
+		CABufferPoolState& theState = CABufferPoolState::Get();
+		for(UInt32 theSizeClassIndex = 0; theSizeClassIndex < kNumberSizeClasses; ++theSizeClassIndex)
+		{
+			SizeClass& theSizeClass = theState.mSizeClasses[theSizeClassIndex];
+			while(inThreadCache->mBlocks[theSizeClassIndex] != NULL)
+			{
+				BlockHeader* theHeader = inThreadCache->mBlocks[theSizeClassIndex];
+				inThreadCache->mBlocks[theSizeClassIndex] = theHeader->mNext;
+				PushSharedBlock(theSizeClass, theHeader);
+				CheckIn(theSizeClass);
+			}
+			inThreadCache->mNumberBlocks[theSizeClassIndex] = 0;
+		}
+	}
+	
+	//	called when the thread exits
+	void	DeleteThreadCache(void* inThreadCache)
+	{
+		CABufferPoolState& theState = CABufferPoolState::Get();
+		ThreadCache* theThreadCache = static_cast<ThreadCache*>(inThreadCache);
+		tThreadCache = NULL;
+		FlushThreadCache(theThreadCache);
+		
+		pthread_mutex_lock(&theState.mThreadCacheMutex);
+		for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+		{
+			SizeClass& theSizeClass = theState.mSizeClasses[theSizeClassIndex];
+			theSizeClass.mNumberRetiredAllocations.fetch_add(theThreadCache->mNumberAllocations[theSizeClassIndex].load(std::memory_order_relaxed), std::memory_order_relaxed);
+			theSizeClass.mNumberRetiredBlocksInUse.fetch_add(theThreadCache->mNumberBlocksInUse[theSizeClassIndex].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		if(theThreadCache->mPrevious != NULL)
+		{
+			theThreadCache->mPrevious->mNext = theThreadCache->mNext;
+		}
+		else
+		{
+			theState.mFirstThreadCache = theThreadCache->mNext;
+		}
+		if(theThreadCache->mNext != NULL)
+		{
+			theThreadCache->mNext->mPrevious = theThreadCache->mPrevious;
+		}
+		pthread_mutex_unlock(&theState.mThreadCacheMutex);
+		
+		delete theThreadCache;
+	}
+	
+	//	adds up what all the threads counted
+	void	GetCounters(UInt64 outNumberAllocations[kNumberSizeClasses + 1], UInt64 outNumberBlocksInUse[kNumberSizeClasses + 1])
+	{
+		CABufferPoolState& theState = CABufferPoolState::Get();
+		SInt64 theNumberBlocksInUse[kNumberSizeClasses + 1];
+		pthread_mutex_lock(&theState.mThreadCacheMutex);
+		for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+		{
+			outNumberAllocations[theSizeClassIndex] = theState.mSizeClasses[theSizeClassIndex].mNumberRetiredAllocations.load(std::memory_order_relaxed);
+			theNumberBlocksInUse[theSizeClassIndex] = theState.mSizeClasses[theSizeClassIndex].mNumberRetiredBlocksInUse.load(std::memory_order_relaxed);
+		}
+		for(ThreadCache* theThreadCache = theState.mFirstThreadCache; theThreadCache != NULL; theThreadCache = theThreadCache->mNext)
+		{
+			for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+			{
+				outNumberAllocations[theSizeClassIndex] += theThreadCache->mNumberAllocations[theSizeClassIndex].load(std::memory_order_relaxed);
+				theNumberBlocksInUse[theSizeClassIndex] += theThreadCache->mNumberBlocksInUse[theSizeClassIndex].load(std::memory_order_relaxed);
+			}
+		}
+		pthread_mutex_unlock(&theState.mThreadCacheMutex);
+		
+		//	the counts of a thread that is allocating right now can be off by a block
+		for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+		{
+			outNumberBlocksInUse[theSizeClassIndex] = (theNumberBlocksInUse[theSizeClassIndex] > 0) ? static_cast<UInt64>(theNumberBlocksInUse[theSizeClassIndex]) : 0;
+		}
+	}
+	
+	BlockHeader*	NewBlock(UInt32 inSizeClass, size_t inBlockSize)
+	{
+		void* theMemory = NULL;
+		if(posix_memalign(&theMemory, CABufferPool::kAlignment, CABufferPool::kAlignment + inBlockSize) != 0)
+		{
+			return NULL;
+		}
+		BlockHeader* theHeader = static_cast<BlockHeader*>(theMemory);
+		theHeader->mNext = NULL;
+		theHeader->mMagic = kFreeMagic;
+		theHeader->mSizeClass = inSizeClass;
+		theHeader->mBlockSize = inBlockSize;
+		
+		SizeClass& theSizeClass = CABufferPoolState::Get().mSizeClasses[inSizeClass];
+		theSizeClass.mNumberBlocks.fetch_add(1, std::memory_order_relaxed);
+		theSizeClass.mNumberHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+		theSizeClass.mNumberBytes.fetch_add(inBlockSize, std::memory_order_relaxed);
+		return theHeader;
+	}
+	
+	void	DeleteBlock(BlockHeader* inHeader)
+	{
+		SizeClass& theSizeClass = CABufferPoolState::Get().mSizeClasses[inHeader->mSizeClass];
+		theSizeClass.mNumberBlocks.fetch_sub(1, std::memory_order_relaxed);
+		theSizeClass.mNumberBytes.fetch_sub(inHeader->mBlockSize, std::memory_order_relaxed);
+		free(inHeader);
+	}
+	
+	void	DeleteSharedBlocks(UInt32 inSizeClassIndex)
+	{
+		SizeClass& theSizeClass = CABufferPoolState::Get().mSizeClasses[inSizeClassIndex];
+		if(!theSizeClass.mSharedBlocks.empty())
+		{
+			BlockHeader* theHeader = theSizeClass.mSharedBlocks.pop_all();
+			while(theHeader != NULL)
+			{
+				BlockHeader* theNextHeader = theHeader->mNext;
+				theSizeClass.mNumberSharedBlocks.fetch_sub(1, std::memory_order_relaxed);
+				DeleteBlock(theHeader);
+				theHeader = theNextHeader;
+			}
+		}
+	}
+	
+	//	the large blocks that real time threads couldn't give back to the heap
+	void	DeleteDeferredBlocks()
+	{
+		DeleteSharedBlocks(kOversizeClass);
+	}
+}
+
+//==================================================================================================
+//	CABufferPool
+//==================================================================================================
+
+#pragma mark Allocation
+
+void*	CABufferPool::Allocate(size_t inSize)
+{
+	UInt32 theSizeClassIndex = GetSizeClass(inSize);
+	SizeClass& theSizeClass = CABufferPoolState::Get().mSizeClasses[theSizeClassIndex];
+	ThreadCache* theThreadCache = GetThreadCache(true);
+	bool isRealTime = (theThreadCache != NULL) && theThreadCache->mIsRealTime;
+	
+	BlockHeader* theHeader = NULL;
+	if((theSizeClassIndex != kOversizeClass) && (theThreadCache != NULL) && (theThreadCache->mBlocks[theSizeClassIndex] != NULL))
+	{
+		//	the fast path
+		theHeader = theThreadCache->mBlocks[theSizeClassIndex];
+		theThreadCache->mBlocks[theSizeClassIndex] = theHeader->mNext;
+		--theThreadCache->mNumberBlocks[theSizeClassIndex];
+	}
+	else
+	{
+		if(theSizeClassIndex == kOversizeClass)
+		{
+			if(!isRealTime)
+			{
+				DeleteDeferredBlocks();
+				theHeader = NewBlock(kOversizeClass, (inSize + kAlignment - 1) & ~static_cast<size_t>(kAlignment - 1));
+			}
+		}
+		else
+		{
+			theHeader = PopSharedBlock(theSizeClass);
+			if((theHeader == NULL) && !isRealTime)
+			{
+				theHeader = NewBlock(theSizeClassIndex, GetSizeClassBlockSize(theSizeClassIndex));
+			}
+		}
+		
+		if(theHeader == NULL)
+		{
+			theSizeClass.mNumberFailedAllocations.fetch_add(1, std::memory_order_relaxed);
+			return NULL;
+		}
+		CheckOut(theSizeClass);
+		if(theSizeClassIndex == kOversizeClass)
+		{
+			theSizeClass.mNumberLargeBytesInUse.fetch_add(theHeader->mBlockSize, std::memory_order_relaxed);
+		}
+	}
+	
+	theHeader->mMagic = kInUseMagic;
+	CountAllocation(theThreadCache, theSizeClassIndex, 1);
+	return theHeader->GetBlock();
+}
+
+void	CABufferPool::Deallocate(void* inBlock)
+{
+	if(inBlock == NULL)
+	{
+		return;
+	}
+	
+	BlockHeader* theHeader = BlockHeader::Get(inBlock);
+	if(theHeader->mMagic != kInUseMagic)
+	{
+		DebugMsg("CABufferPool::Deallocate: %p was not allocated by the pool or was freed already", inBlock);
+		return;
+	}
+	theHeader->mMagic = kFreeMagic;
+	
+	UInt32 theSizeClassIndex = theHeader->mSizeClass;
+	SizeClass& theSizeClass = CABufferPoolState::Get().mSizeClasses[theSizeClassIndex];
+	ThreadCache* theThreadCache = GetThreadCache(false);
+	CountAllocation(theThreadCache, theSizeClassIndex, -1);
+	
+	if((theSizeClassIndex != kOversizeClass) && (theThreadCache != NULL) && (theThreadCache->mNumberBlocks[theSizeClassIndex] < GetThreadCacheDepth(theSizeClassIndex)))
+	{
+		//	the fast path
+		SetNext(theHeader, theThreadCache->mBlocks[theSizeClassIndex]);
+		theThreadCache->mBlocks[theSizeClassIndex] = theHeader;
+		++theThreadCache->mNumberBlocks[theSizeClassIndex];
+	}
+	else
+	{
+		CheckIn(theSizeClass);
+		if(theSizeClassIndex != kOversizeClass)
+		{
+			PushSharedBlock(theSizeClass, theHeader);
+		}
+		else
+		{
+			theSizeClass.mNumberLargeBytesInUse.fetch_sub(theHeader->mBlockSize, std::memory_order_relaxed);
+			if((theThreadCache != NULL) && theThreadCache->mIsRealTime)
+			{
+				PushSharedBlock(theSizeClass, theHeader);
+			}
+			else
+			{
+				DeleteDeferredBlocks();
+				DeleteBlock(theHeader);
+			}
+		}
+	}
+}
+
+size_t	CABufferPool::GetBlockSize(const void* inBlock)
+{
+	return (inBlock != NULL) ? BlockHeader::Get(inBlock)->mBlockSize : 0;
+}
+
+bool	CABufferPool::Reserve(size_t inSize, UInt32 inNumberBlocks)
+{
+	UInt32 theSizeClassIndex = GetSizeClass(inSize);
+	if((theSizeClassIndex == kOversizeClass) || IsRealTimeThread())
+	{
+		return false;
+	}
+	
+	SizeClass& theSizeClass = CABufferPoolState::Get().mSizeClasses[theSizeClassIndex];
+	while(theSizeClass.mNumberSharedBlocks.load(std::memory_order_relaxed) < inNumberBlocks)
+	{
+		BlockHeader* theHeader = NewBlock(theSizeClassIndex, GetSizeClassBlockSize(theSizeClassIndex));
+		if(theHeader == NULL)
+		{
+			return false;
+		}
+		PushSharedBlock(theSizeClass, theHeader);
+	}
+	return true;
+}
+
+void	CABufferPool::Trim()
+{
+	ThreadCache* theThreadCache = GetThreadCache(false);
+	if(theThreadCache != NULL)
+	{
+		FlushThreadCache(theThreadCache);
+	}
+	for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+	{
+		DeleteSharedBlocks(theSizeClassIndex);
+	}
+}
+
+#pragma mark Real Time Operations
+
+void	CABufferPool::SetIsRealTimeThread(bool inIsRealTimeThread)
+{
+	ThreadCache* theThreadCache = GetThreadCache(true);
+	if(theThreadCache != NULL)
+	{
+		theThreadCache->mIsRealTime = inIsRealTimeThread;
+	}
+	if(!inIsRealTimeThread)
+	{
+		DeleteDeferredBlocks();
+	}
+}
+
+bool	CABufferPool::IsRealTimeThread()
+{
+	ThreadCache* theThreadCache = GetThreadCache(false);
+	return (theThreadCache != NULL) && theThreadCache->mIsRealTime;
+}
+
+#pragma mark Accounting
+
+void	CABufferPool::GetStatistics(Statistics& outStatistics)
+{
+	UInt64 theNumberAllocations[kNumberSizeClasses + 1];
+	UInt64 theNumberBlocksInUse[kNumberSizeClasses + 1];
+	GetCounters(theNumberAllocations, theNumberBlocksInUse);
+	
+	memset(&outStatistics, 0, sizeof(Statistics));
+	CABufferPoolState& theState = CABufferPoolState::Get();
+	for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+	{
+		const SizeClass& theSizeClass = theState.mSizeClasses[theSizeClassIndex];
+		outStatistics.mNumberAllocations += theNumberAllocations[theSizeClassIndex];
+		outStatistics.mNumberHeapAllocations += theSizeClass.mNumberHeapAllocations.load(std::memory_order_relaxed);
+		outStatistics.mNumberFailedAllocations += theSizeClass.mNumberFailedAllocations.load(std::memory_order_relaxed);
+		outStatistics.mNumberBlocksInUse += theNumberBlocksInUse[theSizeClassIndex];
+		outStatistics.mBytesReserved += theSizeClass.mNumberBytes.load(std::memory_order_relaxed);
+		if(theSizeClassIndex < kNumberSizeClasses)
+		{
+			outStatistics.mBytesInUse += theNumberBlocksInUse[theSizeClassIndex] * GetSizeClassBlockSize(theSizeClassIndex);
+		}
+		else
+		{
+			outStatistics.mBytesInUse += theSizeClass.mNumberLargeBytesInUse.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+UInt64	CABufferPool::GetNumberBlocksInUse(size_t inSize)
+{
+	UInt64 theNumberAllocations[kNumberSizeClasses + 1];
+	UInt64 theNumberBlocksInUse[kNumberSizeClasses + 1];
+	GetCounters(theNumberAllocations, theNumberBlocksInUse);
+	return theNumberBlocksInUse[GetSizeClass(inSize)];
+}
+
+UInt64	CABufferPool::GetPeakNumberBlocksInUse(size_t inSize)
+{
+	return CABufferPoolState::Get().mSizeClasses[GetSizeClass(inSize)].mPeakNumberBlocksOut.load(std::memory_order_relaxed);
+}
+
+void	CABufferPool::DumpStatistics()
+{
+	//	straight to stderr, so the report shows up in every build configuration
+	UInt64 theNumberAllocations[kNumberSizeClasses + 1];
+	UInt64 theNumberBlocksInUse[kNumberSizeClasses + 1];
+	GetCounters(theNumberAllocations, theNumberBlocksInUse);
+	
+	CABufferPoolState& theState = CABufferPoolState::Get();
+	for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+	{
+		const SizeClass& theSizeClass = theState.mSizeClasses[theSizeClassIndex];
+		if(theNumberAllocations[theSizeClassIndex] > 0)
+		{
+			fprintf(stderr, "CABufferPool::DumpStatistics: %8llu bytes allocations: %llu from the heap: %llu failed: %llu blocks: %llu in use: %llu peak: %llu\n",
+					 (theSizeClassIndex < kNumberSizeClasses) ? (UInt64)GetSizeClassBlockSize(theSizeClassIndex) : 0ULL,
+					 theNumberAllocations[theSizeClassIndex], theSizeClass.mNumberHeapAllocations.load(std::memory_order_relaxed),
+					 theSizeClass.mNumberFailedAllocations.load(std::memory_order_relaxed), theSizeClass.mNumberBlocks.load(std::memory_order_relaxed),
+					 theNumberBlocksInUse[theSizeClassIndex], theSizeClass.mPeakNumberBlocksOut.load(std::memory_order_relaxed));
+		}
+	}
+}
+
+UInt64	CABufferPool::ReportLeaks()
+{
+	UInt64 theNumberAllocations[kNumberSizeClasses + 1];
+	UInt64 theNumberBlocksInUse[kNumberSizeClasses + 1];
+	GetCounters(theNumberAllocations, theNumberBlocksInUse);
+	
+	UInt64 theAnswer = 0;
+	for(UInt32 theSizeClassIndex = 0; theSizeClassIndex <= kNumberSizeClasses; ++theSizeClassIndex)
+	{
+		if(theNumberBlocksInUse[theSizeClassIndex] > 0)
+		{
+			fprintf(stderr, "CABufferPool::ReportLeaks: %llu blocks of %llu bytes are still in use\n", theNumberBlocksInUse[theSizeClassIndex],
+					 (theSizeClassIndex < kNumberSizeClasses) ? (UInt64)GetSizeClassBlockSize(theSizeClassIndex) : (UInt64)kMaximumBlockSize + 1);
+			theAnswer += theNumberBlocksInUse[theSizeClassIndex];
+		}
+	}
+	return theAnswer;
+}
+
+UInt32	CABufferPool::GetSizeClass(size_t inSize)
+{
+	if(inSize <= kMinimumBlockSize)
+	{
+		return 0;
+	}
+	if(inSize > kMaximumBlockSize)
+	{
+		return kNumberSizeClasses;
+	}
+	return Log2Ceil(static_cast<UInt32>(inSize)) - Log2Ceil(kMinimumBlockSize);
+}
@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#if !defined(__CABufferPool_h__)
+#define __CABufferPool_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+//	Standard Library Includes
+#include <stddef.h>
+
+/*==================================================================================================
+	CABufferPool
+
+	The allocator behind CAAudioBufferList::Create and CABufferList::AllocateBuffers. Every block
+	starts on a 64 byte boundary, so a buffer never shares a cache line with its neighbour and the
+	vector kernels can use aligned loads on it.
+
+	Requests are rounded up to a power of two between kMinimumBlockSize and kMaximumBlockSize. A
+	freed block goes back to its size class instead of to the heap, first to a small cache of the
+	thread that freed it and then to a lock-free stack that all threads share, so a steady state
+	of allocating and freeing the same sizes never calls malloc or takes a lock. The thread caches
+	are given back to the shared stacks when their thread exits. Larger requests come straight
+	from the heap.
+
+	A real time thread calls SetIsRealTimeThread(true) before it starts its work. From then on
+	the pool never calls into the system on that thread: it only hands out blocks that are already
+	there and returns NULL when a size class runs dry, and large blocks freed on the thread are
+	only given back to the heap by the next thread that isn't real time. Reserve() puts the blocks
+	the real time work will need into the pool beforehand.
+
+	Every thread counts the blocks it takes and gives back and every size class counts the blocks
+	it owns, which is what GetStatistics() adds up and DumpStatistics() writes to stderr. A block that is still handed out when the
+	owner should have freed everything is a leak, ReportLeaks() writes the size classes that have
+	some to stderr.
+==================================================================================================*/
+
+class CABufferPool
+{
+
+#pragma mark Constants
+public:
+	enum
+	{
+		kAlignment				= 64,
+		kMinimumBlockSize		= 64,
+		kMaximumBlockSize		= 1024 * 1024,
+		kNumberSizeClasses		= 15		//	64 bytes to 1 MB
+	};
+
+	struct Statistics
+	{
+		UInt64		mNumberAllocations;			//	every successful Allocate()
+		UInt64		mNumberHeapAllocations;		//	the ones the pool had to get from the heap
+		UInt64		mNumberFailedAllocations;	//	the ones that returned NULL
+		UInt64		mNumberBlocksInUse;
+		UInt64		mBytesInUse;				//	by block size, not by the size that was asked for
+		UInt64		mBytesReserved;				//	the blocks in use plus the free ones the pool keeps
+	};
+
+#pragma mark Allocation
+public:
+	//	a block of at least inSize bytes, aligned to kAlignment, or NULL
+	static void*		Allocate(size_t inSize);
+	static void			Deallocate(void* inBlock);
+	
+	//	the number of bytes that can be used in a block from Allocate()
+	static size_t		GetBlockSize(const void* inBlock);
+	
+	//	makes sure that inNumberBlocks free blocks of inSize bytes are waiting in the shared stacks
+	static bool			Reserve(size_t inSize, UInt32 inNumberBlocks);
+	
+	//	gives the free blocks back to the heap, only call this while no other thread uses the pool
+	static void			Trim();
+
+#pragma mark Real Time Operations
+public:
+	//	also sets up the calling thread's cache, so the first allocation on the thread doesn't
+	static void			SetIsRealTimeThread(bool inIsRealTimeThread);
+	static bool			IsRealTimeThread();
+
+#pragma mark Accounting
+public:
+	static void			GetStatistics(Statistics& outStatistics);
+	static UInt64		GetNumberBlocksInUse(size_t inSize);
+	
+	//	counts the blocks that waited in a thread cache too, which makes it a safe number to Reserve()
+	static UInt64		GetPeakNumberBlocksInUse(size_t inSize);
+	static void			DumpStatistics();
+	
+	//	writes every size class that has blocks in use to stderr and returns how many there are
+	static UInt64		ReportLeaks();
+	
+	static UInt32		GetSizeClass(size_t inSize);		//	kNumberSizeClasses for the large ones
+	static size_t		GetSizeClassBlockSize(UInt32 inSizeClass) { return static_cast<size_t>(kMinimumBlockSize) << inSizeClass; }
+
+private:
+						CABufferPool();
+
+};
+
+#endif
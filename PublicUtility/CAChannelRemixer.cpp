@@ -0,0 +1,399 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CAChannelRemixer.h"
+
+//	PublicUtility Includes
+#include "CAAudioChannelLayout.h"
+#include "CABufferPool.h"
+#include "CADebugMacros.h"
+#include "CAException.h"
+#include "CAMutex.h"
+#include "CAVectorKernels.h"
+
+//	Standard Library Includes
+#include <map>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+//==================================================================================================
+//	Fold Rules
+//
+//	Where a label goes when the destination doesn't have it. The first alternative whose labels
+//	are all in the destination wins. If none of them are, the labels of the last one are folded
+//	further, which is how a surround channel ends up in mono.
+//==================================================================================================
+
+namespace
+{
+	const Float32	kMinus3dB = 0.70710678f;
+	const Float32	kMinus6dB = 0.5f;
+
+	//	constant power at 22.5 degrees, half way between the front and the centre
+	const Float32	kNear = 0.92387953f;
+	const Float32	kFar = 0.38268343f;
+
+	//	how many times a channel is folded before it is dropped
+	const UInt32	kMaximumFoldDepth = 4;
+
+	struct Fold
+	{
+		AudioChannelLabel	mLabel;
+		Float32				mGain;			//	0 for the unused second fold of an alternative
+	};
+
+	struct FoldRule
+	{
+		AudioChannelLabel	mLabel;
+		UInt32				mNumberAlternatives;
+		Fold				mAlternatives[4][2];
+	};
+
+	const FoldRule kFoldRules[] =
+	{
+		{ kAudioChannelLabel_Left, 4, { { { kAudioChannelLabel_HeadphonesLeft, 1.0f } }, { { kAudioChannelLabel_LeftTotal, 1.0f } }, { { kAudioChannelLabel_Mono, kMinus3dB } }, { { kAudioChannelLabel_Center, kMinus3dB } } } },
+		{ kAudioChannelLabel_Right, 4, { { { kAudioChannelLabel_HeadphonesRight, 1.0f } }, { { kAudioChannelLabel_RightTotal, 1.0f } }, { { kAudioChannelLabel_Mono, kMinus3dB } }, { { kAudioChannelLabel_Center, kMinus3dB } } } },
+		{ kAudioChannelLabel_HeadphonesLeft, 1, { { { kAudioChannelLabel_Left, 1.0f } } } },
+		{ kAudioChannelLabel_HeadphonesRight, 1, { { { kAudioChannelLabel_Right, 1.0f } } } },
+		{ kAudioChannelLabel_LeftTotal, 1, { { { kAudioChannelLabel_Left, 1.0f } } } },
+		{ kAudioChannelLabel_RightTotal, 1, { { { kAudioChannelLabel_Right, 1.0f } } } },
+		{ kAudioChannelLabel_LeftWide, 1, { { { kAudioChannelLabel_Left, 1.0f } } } },
+		{ kAudioChannelLabel_RightWide, 1, { { { kAudioChannelLabel_Right, 1.0f } } } },
+		{ kAudioChannelLabel_Mono, 2, { { { kAudioChannelLabel_Center, 1.0f } }, { { kAudioChannelLabel_Left, kMinus3dB }, { kAudioChannelLabel_Right, kMinus3dB } } } },
+		{ kAudioChannelLabel_Center, 2, { { { kAudioChannelLabel_Mono, 1.0f } }, { { kAudioChannelLabel_Left, kMinus3dB }, { kAudioChannelLabel_Right, kMinus3dB } } } },
+		{ kAudioChannelLabel_LeftCenter, 2, { { { kAudioChannelLabel_Left, kNear }, { kAudioChannelLabel_Center, kFar } }, { { kAudioChannelLabel_Left, kNear }, { kAudioChannelLabel_Right, kFar } } } },
+		{ kAudioChannelLabel_RightCenter, 2, { { { kAudioChannelLabel_Right, kNear }, { kAudioChannelLabel_Center, kFar } }, { { kAudioChannelLabel_Right, kNear }, { kAudioChannelLabel_Left, kFar } } } },
+		{ kAudioChannelLabel_LeftSurround, 3, { { { kAudioChannelLabel_LeftSurroundDirect, 1.0f } }, { { kAudioChannelLabel_RearSurroundLeft, 1.0f } }, { { kAudioChannelLabel_Left, kMinus3dB } } } },
+		{ kAudioChannelLabel_RightSurround, 3, { { { kAudioChannelLabel_RightSurroundDirect, 1.0f } }, { { kAudioChannelLabel_RearSurroundRight, 1.0f } }, { { kAudioChannelLabel_Right, kMinus3dB } } } },
+		{ kAudioChannelLabel_LeftSurroundDirect, 2, { { { kAudioChannelLabel_LeftSurround, 1.0f } }, { { kAudioChannelLabel_Left, kMinus3dB } } } },
+		{ kAudioChannelLabel_RightSurroundDirect, 2, { { { kAudioChannelLabel_RightSurround, 1.0f } }, { { kAudioChannelLabel_Right, kMinus3dB } } } },
+		{ kAudioChannelLabel_RearSurroundLeft, 2, { { { kAudioChannelLabel_LeftSurround, kMinus3dB } }, { { kAudioChannelLabel_Left, kMinus3dB } } } },
+		{ kAudioChannelLabel_RearSurroundRight, 2, { { { kAudioChannelLabel_RightSurround, kMinus3dB } }, { { kAudioChannelLabel_Right, kMinus3dB } } } },
+		{ kAudioChannelLabel_CenterSurround, 3, { { { kAudioChannelLabel_LeftSurround, kMinus3dB }, { kAudioChannelLabel_RightSurround, kMinus3dB } }, { { kAudioChannelLabel_RearSurroundLeft, kMinus3dB }, { kAudioChannelLabel_RearSurroundRight, kMinus3dB } }, { { kAudioChannelLabel_Left, kMinus6dB }, { kAudioChannelLabel_Right, kMinus6dB } } } },
+		{ kAudioChannelLabel_LFE2, 1, { { { kAudioChannelLabel_LFEScreen, 1.0f } } } }
+	};
+
+	inline bool	IsNumberedDiscrete(AudioChannelLabel inLabel)
+	{
+		return (inLabel & 0xFFFF0000) == kAudioChannelLabel_Discrete_0;
+	}
+
+	//	the discrete and unknown channels have none, they go by their number or their index
+	inline bool	HasPosition(AudioChannelLabel inLabel)
+	{
+		return (inLabel != kAudioChannelLabel_Unknown) && (inLabel != kAudioChannelLabel_Unused) && (inLabel != kAudioChannelLabel_Discrete) && !IsNumberedDiscrete(inLabel);
+	}
+
+	SInt32	FindLabel(AudioChannelLabel inLabel, const AudioChannelLabel* inLabels, UInt32 inNumberLabels)
+	{
+		SInt32 theAnswer = -1;
+		for(UInt32 theIndex = 0; (theAnswer < 0) && (theIndex < inNumberLabels); ++theIndex)
+		{
+			if(inLabels[theIndex] == inLabel)
+			{
+				theAnswer = static_cast<SInt32>(theIndex);
+			}
+		}
+		return theAnswer;
+	}
+
+	const FoldRule*	FindFoldRule(AudioChannelLabel inLabel)
+	{
+		const FoldRule* theAnswer = NULL;
+		for(UInt32 theIndex = 0; (theAnswer == NULL) && (theIndex < sizeof(kFoldRules) / sizeof(kFoldRules[0])); ++theIndex)
+		{
+			if(kFoldRules[theIndex].mLabel == inLabel)
+			{
+				theAnswer = &kFoldRules[theIndex];
+			}
+		}
+		return theAnswer;
+	}
+
+	//	adds inGain times the source channel to the destination channels that inLabel ends up in,
+	//	ioColumn is the source channel's column of the matrix
+	void	Route(AudioChannelLabel inLabel, Float32 inGain, const AudioChannelLabel* inDestinationLabels, UInt32 inNumberDestinationChannels, Float32* ioColumn, UInt32 inColumnStride, UInt32 inDepth)
+	{
+		SInt32 theDestinationChannel = FindLabel(inLabel, inDestinationLabels, inNumberDestinationChannels);
+		const FoldRule* theRule = FindFoldRule(inLabel);
+		if(theDestinationChannel >= 0)
+		{
+			ioColumn[theDestinationChannel * inColumnStride] += inGain;
+		}
+		else if((theRule != NULL) && (inDepth < kMaximumFoldDepth))
+		{
+			UInt32 theAlternative = 0;
+			for(; theAlternative < theRule->mNumberAlternatives - 1; ++theAlternative)
+			{
+				const Fold* theFolds = theRule->mAlternatives[theAlternative];
+				bool isInDestination = FindLabel(theFolds[0].mLabel, inDestinationLabels, inNumberDestinationChannels) >= 0;
+				if(theFolds[1].mGain != 0.0f)
+				{
+					isInDestination = isInDestination && (FindLabel(theFolds[1].mLabel, inDestinationLabels, inNumberDestinationChannels) >= 0);
+				}
+				if(isInDestination)
+				{
+					break;
+				}
+			}
+			for(UInt32 theFold = 0; theFold < 2; ++theFold)
+			{
+				const Fold& theFoldToDo = theRule->mAlternatives[theAlternative][theFold];
+				if(theFoldToDo.mGain != 0.0f)
+				{
+					Route(theFoldToDo.mLabel, inGain * theFoldToDo.mGain, inDestinationLabels, inNumberDestinationChannels, ioColumn, inColumnStride, inDepth + 1);
+				}
+			}
+		}
+	}
+}
+
+//==================================================================================================
+//	CAChannelRemixer::Matrix
+//==================================================================================================
+
+struct CAChannelRemixer::Matrix
+{
+	struct Term
+	{
+		UInt32		mSourceChannel;
+		Float32		mGain;
+	};
+
+	typedef std::pair<std::vector<AudioChannelLabel>, std::vector<AudioChannelLabel> >	Key;
+	typedef std::map<Key, const Matrix*>													Cache;
+
+	UInt32				mNumberSourceChannels;
+	UInt32				mNumberDestinationChannels;
+	std::vector<Float32>	mCoefficients;
+	
+	//	the non-zero coefficients of row d are mTerms[mFirstTerms[d]] up to mTerms[mFirstTerms[d + 1]]
+	std::vector<Term>	mTerms;
+	std::vector<UInt32>	mFirstTerms;
+	bool				mIsIdentity;
+
+	static const Matrix*	Get(const std::vector<AudioChannelLabel>& inSourceLabels, const std::vector<AudioChannelLabel>& inDestinationLabels);
+	
+	//	never destroyed, the remixers point into it until the very end
+	static Cache&		GetCache() { static Cache* sCache = new Cache(); return *sCache; }
+	static CAMutex&		GetCacheMutex() { static CAMutex* sMutex = new CAMutex("CAChannelRemixer Cache"); return *sMutex; }
+};
+
+const CAChannelRemixer::Matrix*	CAChannelRemixer::Matrix::Get(const std::vector<AudioChannelLabel>& inSourceLabels, const std::vector<AudioChannelLabel>& inDestinationLabels)
+{
+	CAMutex::Locker theLocker(GetCacheMutex());
+	Cache& theCache = GetCache();
+	Key theKey(inSourceLabels, inDestinationLabels);
+	Cache::iterator theIterator = theCache.find(theKey);
+	if(theIterator != theCache.end())
+	{
+		return theIterator->second;
+	}
+	
+	Matrix* theMatrix = new Matrix();
+	theMatrix->mNumberSourceChannels = static_cast<UInt32>(inSourceLabels.size());
+	theMatrix->mNumberDestinationChannels = static_cast<UInt32>(inDestinationLabels.size());
+	theMatrix->mCoefficients.resize(theMatrix->mNumberSourceChannels * theMatrix->mNumberDestinationChannels);
+	if(!theMatrix->mCoefficients.empty())
+	{
+		BuildMatrix(&inSourceLabels[0], theMatrix->mNumberSourceChannels, &inDestinationLabels[0], theMatrix->mNumberDestinationChannels, &theMatrix->mCoefficients[0]);
+	}
+	
+	theMatrix->mIsIdentity = theMatrix->mNumberSourceChannels == theMatrix->mNumberDestinationChannels;
+	for(UInt32 theDestinationChannel = 0; theDestinationChannel < theMatrix->mNumberDestinationChannels; ++theDestinationChannel)
+	{
+		theMatrix->mFirstTerms.push_back(static_cast<UInt32>(theMatrix->mTerms.size()));
+		for(UInt32 theSourceChannel = 0; theSourceChannel < theMatrix->mNumberSourceChannels; ++theSourceChannel)
+		{
+			Float32 theGain = theMatrix->mCoefficients[theDestinationChannel * theMatrix->mNumberSourceChannels + theSourceChannel];
+			if(theGain != 0.0f)
+			{
+				Term theTerm = { theSourceChannel, theGain };
+				theMatrix->mTerms.push_back(theTerm);
+			}
+			if(theGain != ((theSourceChannel == theDestinationChannel) ? 1.0f : 0.0f))
+			{
+				theMatrix->mIsIdentity = false;
+			}
+		}
+	}
+	theMatrix->mFirstTerms.push_back(static_cast<UInt32>(theMatrix->mTerms.size()));
+	
+	theCache[theKey] = theMatrix;
+	return theMatrix;
+}
+
+//==================================================================================================
+//	CAChannelRemixer
+//==================================================================================================
+
+CAChannelRemixer::CAChannelRemixer(const AudioChannelLayout& inSourceLayout, const AudioChannelLayout& inDestinationLayout)
+:
+	mMatrix(NULL),
+	mBuffers(NULL),
+	mSourceChannels(NULL),
+	mDestinationChannels(NULL)
+{
+	std::vector<AudioChannelLabel> theSourceLabels(CAAudioChannelLayout::NumberChannels(inSourceLayout));
+	std::vector<AudioChannelLabel> theDestinationLabels(CAAudioChannelLayout::NumberChannels(inDestinationLayout));
+	if(!theSourceLabels.empty())
+	{
+		CAAudioChannelLayout::GetChannelLabels(inSourceLayout, &theSourceLabels[0]);
+	}
+	if(!theDestinationLabels.empty())
+	{
+		CAAudioChannelLayout::GetChannelLabels(inDestinationLayout, &theDestinationLabels[0]);
+	}
+	mMatrix = Matrix::Get(theSourceLabels, theDestinationLabels);
+	
+	//	one block per channel, every one of them on its own cache lines
+	UInt32 theNumberChannels = mMatrix->mNumberSourceChannels + mMatrix->mNumberDestinationChannels;
+	mBuffers = static_cast<Float32*>(CABufferPool::Allocate(theNumberChannels * kBlockSize * sizeof(Float32)));
+	ThrowIfNULL(mBuffers, CAException(kAudio_MemFullError), "CAChannelRemixer::CAChannelRemixer: couldn't allocate the buffers");
+	mSourceChannels = new Float32*[mMatrix->mNumberSourceChannels + 1];
+	mDestinationChannels = new Float32*[mMatrix->mNumberDestinationChannels + 1];
+	for(UInt32 theSourceChannel = 0; theSourceChannel < mMatrix->mNumberSourceChannels; ++theSourceChannel)
+	{
+		mSourceChannels[theSourceChannel] = mBuffers + theSourceChannel * kBlockSize;
+	}
+	for(UInt32 theDestinationChannel = 0; theDestinationChannel < mMatrix->mNumberDestinationChannels; ++theDestinationChannel)
+	{
+		//	a channel that is a copy of a source channel is interleaved straight from that one
+		UInt32 theFirstTerm = mMatrix->mFirstTerms[theDestinationChannel];
+		bool isCopy = (mMatrix->mFirstTerms[theDestinationChannel + 1] == theFirstTerm + 1) && (mMatrix->mTerms[theFirstTerm].mGain == 1.0f);
+		mDestinationChannels[theDestinationChannel] = isCopy ? mSourceChannels[mMatrix->mTerms[theFirstTerm].mSourceChannel] : mBuffers + (mMatrix->mNumberSourceChannels + theDestinationChannel) * kBlockSize;
+	}
+}
+
+CAChannelRemixer::~CAChannelRemixer()
+{
+	delete[] mSourceChannels;
+	delete[] mDestinationChannels;
+	CABufferPool::Deallocate(mBuffers);
+}
+
+UInt32	CAChannelRemixer::GetNumberSourceChannels() const
+{
+	return mMatrix->mNumberSourceChannels;
+}
+
+UInt32	CAChannelRemixer::GetNumberDestinationChannels() const
+{
+	return mMatrix->mNumberDestinationChannels;
+}
+
+Float32	CAChannelRemixer::GetCoefficient(UInt32 inDestinationChannel, UInt32 inSourceChannel) const
+{
+	Float32 theAnswer = 0.0f;
+	if((inDestinationChannel < mMatrix->mNumberDestinationChannels) && (inSourceChannel < mMatrix->mNumberSourceChannels))
+	{
+		theAnswer = mMatrix->mCoefficients[inDestinationChannel * mMatrix->mNumberSourceChannels + inSourceChannel];
+	}
+	return theAnswer;
+}
+
+bool	CAChannelRemixer::IsIdentity() const
+{
+	return mMatrix->mIsIdentity;
+}
+
+void	CAChannelRemixer::Process(const Float32* inSource, Float32* outDestination, UInt32 inNumberFrames)
+{
+	UInt32 theNumberSourceChannels = mMatrix->mNumberSourceChannels;
+	UInt32 theNumberDestinationChannels = mMatrix->mNumberDestinationChannels;
+	if(mMatrix->mIsIdentity)
+	{
+		CAVectorKernels::CopyChannels(inSource, theNumberSourceChannels, outDestination, theNumberDestinationChannels, theNumberDestinationChannels, inNumberFrames);
+		return;
+	}
+	
+	for(UInt32 theFirstFrame = 0; theFirstFrame < inNumberFrames; theFirstFrame += kBlockSize)
+	{
+		UInt32 theNumberFrames = ((inNumberFrames - theFirstFrame) < kBlockSize) ? inNumberFrames - theFirstFrame : kBlockSize;
+		CAVectorKernels::Deinterleave(inSource + theFirstFrame * theNumberSourceChannels, theNumberSourceChannels, mSourceChannels, theNumberSourceChannels, theNumberFrames);
+		
+		for(UInt32 theDestinationChannel = 0; theDestinationChannel < theNumberDestinationChannels; ++theDestinationChannel)
+		{
+			Float32* theChannel = mDestinationChannels[theDestinationChannel];
+			const Matrix::Term* theTerm = mMatrix->mTerms.data() + mMatrix->mFirstTerms[theDestinationChannel];
+			const Matrix::Term* theLastTerm = mMatrix->mTerms.data() + mMatrix->mFirstTerms[theDestinationChannel + 1];
+			if(theTerm == theLastTerm)
+			{
+				memset(theChannel, 0, theNumberFrames * sizeof(Float32));
+			}
+			else if(theChannel != mSourceChannels[theTerm->mSourceChannel])
+			{
+				memcpy(theChannel, mSourceChannels[theTerm->mSourceChannel], theNumberFrames * sizeof(Float32));
+				if(theTerm->mGain != 1.0f)
+				{
+					CAVectorKernels::Scale(theChannel, theNumberFrames, theTerm->mGain);
+				}
+				for(++theTerm; theTerm != theLastTerm; ++theTerm)
+				{
+					CAVectorKernels::AddScaled(mSourceChannels[theTerm->mSourceChannel], theChannel, theNumberFrames, theTerm->mGain);
+				}
+			}
+		}
+		
+		CAVectorKernels::Interleave(mDestinationChannels, theNumberDestinationChannels, outDestination + theFirstFrame * theNumberDestinationChannels, theNumberDestinationChannels, theNumberFrames);
+	}
+}
+
+void	CAChannelRemixer::BuildMatrix(const AudioChannelLabel* inSourceLabels, UInt32 inNumberSourceChannels, const AudioChannelLabel* inDestinationLabels, UInt32 inNumberDestinationChannels, Float32* outCoefficients)
+{
+	memset(outCoefficients, 0, inNumberSourceChannels * inNumberDestinationChannels * sizeof(Float32));
+	for(UInt32 theSourceChannel = 0; theSourceChannel < inNumberSourceChannels; ++theSourceChannel)
+	{
+		AudioChannelLabel theLabel = inSourceLabels[theSourceChannel];
+		if(HasPosition(theLabel))
+		{
+			Route(theLabel, 1.0f, inDestinationLabels, inNumberDestinationChannels, outCoefficients + theSourceChannel, inNumberSourceChannels, 0);
+		}
+		else
+		{
+			SInt32 theDestinationChannel = IsNumberedDiscrete(theLabel) ? FindLabel(theLabel, inDestinationLabels, inNumberDestinationChannels) : -1;
+			if((theDestinationChannel < 0) && (theSourceChannel < inNumberDestinationChannels) && !HasPosition(inDestinationLabels[theSourceChannel]))
+			{
+				theDestinationChannel = static_cast<SInt32>(theSourceChannel);
+			}
+			if(theDestinationChannel >= 0)
+			{
+				outCoefficients[theDestinationChannel * inNumberSourceChannels + theSourceChannel] = 1.0f;
+			}
+		}
+	}
+}
+
+UInt32	CAChannelRemixer::GetNumberCachedMatrices()
+{
+	CAMutex::Locker theLocker(Matrix::GetCacheMutex());
+	return static_cast<UInt32>(Matrix::GetCache().size());
+}
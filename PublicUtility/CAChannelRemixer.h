@@ -0,0 +1,112 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#if !defined(__CAChannelRemixer_h__)
+#define __CAChannelRemixer_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+/*==================================================================================================
+	CAChannelRemixer
+
+	Maps interleaved Float32 frames in one AudioChannelLayout to another with a matrix of gains.
+	Destination channel d is the sum of the source channels s times GetCoefficient(d, s).
+
+	The matrix comes from the channel labels of the two layouts. A label on both sides goes
+	straight through and the others fold down the way ITU-R BS.775 does it: the centre goes to
+	left and right and the surrounds to their side at -3 dB, the rear surrounds to the surrounds
+	if there are any and to the front otherwise, and LFE is dropped. Mono is left and right at
+	-3 dB each, which keeps the centre at 0 dB. Going up, the front pair stays the front pair and
+	mono goes to the centre, nothing is made up for the other speakers. Channels without a speaker
+	position, like the discrete and unknown ones, go to the channel with the same index on the
+	other side if that has no position either, which is what the hub did before for all of them.
+	The matrix isn't normalized, a loud 5.1 mix can clip in stereo.
+
+	Building a matrix allocates and takes a lock, so construct the remixer up front. Remixers for
+	the same pair of layouts share one matrix, the matrices are cached for as long as the process
+	lives. Process() neither allocates nor locks and is safe on the IO thread, but it works in
+	buffers of the remixer, so one remixer is for one thread at a time. It takes kBlockSize frames
+	at a time apart into one buffer per channel, mixes those with CAVectorKernels and interleaves
+	the result again.
+==================================================================================================*/
+
+class CAChannelRemixer
+{
+
+#pragma mark Constants
+public:
+	enum
+	{
+		kBlockSize		= 256
+	};
+
+#pragma mark Construction/Destruction
+public:
+						CAChannelRemixer(const AudioChannelLayout& inSourceLayout, const AudioChannelLayout& inDestinationLayout);
+						~CAChannelRemixer();
+
+private:
+						CAChannelRemixer(const CAChannelRemixer&);
+	CAChannelRemixer&	operator=(const CAChannelRemixer&);
+
+#pragma mark Attributes
+public:
+	UInt32				GetNumberSourceChannels() const;
+	UInt32				GetNumberDestinationChannels() const;
+	Float32				GetCoefficient(UInt32 inDestinationChannel, UInt32 inSourceChannel) const;
+	
+	//	true when every channel goes straight through to the same index
+	bool				IsIdentity() const;
+
+#pragma mark Operations
+public:
+	//	inSource and outDestination are interleaved and can't be the same buffer
+	void				Process(const Float32* inSource, Float32* outDestination, UInt32 inNumberFrames);
+
+	//	the matrix for two lists of labels, inNumberDestinationChannels rows of inNumberSourceChannels
+	static void			BuildMatrix(const AudioChannelLabel* inSourceLabels, UInt32 inNumberSourceChannels, const AudioChannelLabel* inDestinationLabels, UInt32 inNumberDestinationChannels, Float32* outCoefficients);
+	
+	static UInt32		GetNumberCachedMatrices();
+
+#pragma mark Implementation
+private:
+	struct Matrix;
+
+	const Matrix*		mMatrix;
+	Float32*			mBuffers;
+	Float32**			mSourceChannels;
+	Float32**			mDestinationChannels;
+
+};
+
+#endif
@@ -0,0 +1,502 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CAFFTBackend.h"
+
+//	Standard Library Includes
+#include <math.h>
+#include <new>
+#include <vector>
+
+//==================================================================================================
+//	CAPortableFFT
+//
+//	A real FFT of size N is done as a complex FFT of size M = N/2 on z[n] = x[2n] + i x[2n+1]
+//	followed by a post processing pass that separates the even and odd halves. The complex FFT is a
+//	Stockham autosort FFT with radix 4, 2, 3 and 5 stages working on split real and imaginary
+//	arrays, so the inner loops run over contiguous memory and the compiler can vectorize them for
+//	SSE, AVX or NEON. The first forward stage reads the real input as complex pairs and the last
+//	inverse stage writes them back, which replaces vDSP_ctoz and vDSP_ztoc. The inverse uses the
+//	forward stages on the conjugated spectrum.
+//==================================================================================================
+
+namespace
+{
+	struct SplitIn
+	{
+		const Float32*	mReal;
+		const Float32*	mImag;
+		void			Load(UInt32 inIndex, Float32& outReal, Float32& outImag) const { outReal = mReal[inIndex]; outImag = mImag[inIndex]; }
+	};
+
+	struct InterleavedIn
+	{
+		const Float32*	mData;
+		void			Load(UInt32 inIndex, Float32& outReal, Float32& outImag) const { outReal = mData[2 * inIndex]; outImag = mData[2 * inIndex + 1]; }
+	};
+
+	struct SplitOut
+	{
+		Float32*		mReal;
+		Float32*		mImag;
+		void			Store(UInt32 inIndex, Float32 inReal, Float32 inImag) const { mReal[inIndex] = inReal; mImag[inIndex] = inImag; }
+	};
+
+	//	undoes the conjugation of the inverse transform while writing the real samples
+	struct InterleavedConjugateOut
+	{
+		Float32*		mData;
+		void			Store(UInt32 inIndex, Float32 inReal, Float32 inImag) const { mData[2 * inIndex] = inReal; mData[2 * inIndex + 1] = -inImag; }
+	};
+
+	inline void	StoreTwiddled(const SplitOut& inOut, UInt32 inIndex, Float32 inReal, Float32 inImag, Float32 inTwiddleReal, Float32 inTwiddleImag)
+	{
+		inOut.Store(inIndex, inReal * inTwiddleReal - inImag * inTwiddleImag, inReal * inTwiddleImag + inImag * inTwiddleReal);
+	}
+
+	inline void	StoreTwiddled(const InterleavedConjugateOut& inOut, UInt32 inIndex, Float32 inReal, Float32 inImag, Float32 inTwiddleReal, Float32 inTwiddleImag)
+	{
+		inOut.Store(inIndex, inReal * inTwiddleReal - inImag * inTwiddleImag, inReal * inTwiddleImag + inImag * inTwiddleReal);
+	}
+
+	//	One Stockham stage of radix P for a sub-transform of length inM * P with stride inS. The
+	//	twiddles are laid out as [k - 1][p] for k in [1, P).
+	template <class In, class Out>
+	void	Radix2Stage(UInt32 inM, UInt32 inS, const In& inX, const Out& inY, const Float32* inWReal, const Float32* inWImag)
+	{
+		for(UInt32 p = 0; p < inM; ++p)
+		{
+			const Float32 w1r = inWReal[p], w1i = inWImag[p];
+			for(UInt32 q = 0; q < inS; ++q)
+			{
+				Float32 a0r, a0i, a1r, a1i;
+				inX.Load(q + inS * p, a0r, a0i);
+				inX.Load(q + inS * (p + inM), a1r, a1i);
+				inY.Store(q + inS * (2 * p), a0r + a1r, a0i + a1i);
+				StoreTwiddled(inY, q + inS * (2 * p + 1), a0r - a1r, a0i - a1i, w1r, w1i);
+			}
+		}
+	}
+
+	template <class In, class Out>
+	void	Radix3Stage(UInt32 inM, UInt32 inS, const In& inX, const Out& inY, const Float32* inWReal, const Float32* inWImag)
+	{
+		const Float32 c = -0.5f;
+		const Float32 s = -0.86602540378443864676f;		//	-sin(2 pi / 3)
+		for(UInt32 p = 0; p < inM; ++p)
+		{
+			const Float32 w1r = inWReal[p], w1i = inWImag[p];
+			const Float32 w2r = inWReal[inM + p], w2i = inWImag[inM + p];
+			for(UInt32 q = 0; q < inS; ++q)
+			{
+				Float32 a0r, a0i, a1r, a1i, a2r, a2i;
+				inX.Load(q + inS * p, a0r, a0i);
+				inX.Load(q + inS * (p + inM), a1r, a1i);
+				inX.Load(q + inS * (p + 2 * inM), a2r, a2i);
+				
+				Float32 t1r = a1r + a2r, t1i = a1i + a2i;
+				Float32 t2r = a0r + c * t1r, t2i = a0i + c * t1i;
+				Float32 t3r = s * (a1r - a2r), t3i = s * (a1i - a2i);
+				
+				inY.Store(q + inS * (3 * p), a0r + t1r, a0i + t1i);
+				StoreTwiddled(inY, q + inS * (3 * p + 1), t2r - t3i, t2i + t3r, w1r, w1i);
+				StoreTwiddled(inY, q + inS * (3 * p + 2), t2r + t3i, t2i - t3r, w2r, w2i);
+			}
+		}
+	}
+
+	template <class In, class Out>
+	void	Radix4Stage(UInt32 inM, UInt32 inS, const In& inX, const Out& inY, const Float32* inWReal, const Float32* inWImag)
+	{
+		for(UInt32 p = 0; p < inM; ++p)
+		{
+			const Float32 w1r = inWReal[p], w1i = inWImag[p];
+			const Float32 w2r = inWReal[inM + p], w2i = inWImag[inM + p];
+			const Float32 w3r = inWReal[2 * inM + p], w3i = inWImag[2 * inM + p];
+			for(UInt32 q = 0; q < inS; ++q)
+			{
+				Float32 a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i;
+				inX.Load(q + inS * p, a0r, a0i);
+				inX.Load(q + inS * (p + inM), a1r, a1i);
+				inX.Load(q + inS * (p + 2 * inM), a2r, a2i);
+				inX.Load(q + inS * (p + 3 * inM), a3r, a3i);
+				
+				Float32 t0r = a0r + a2r, t0i = a0i + a2i;
+				Float32 t1r = a0r - a2r, t1i = a0i - a2i;
+				Float32 t2r = a1r + a3r, t2i = a1i + a3i;
+				//	(a1 - a3) * -i
+				Float32 t3r = a1i - a3i, t3i = a3r - a1r;
+				
+				inY.Store(q + inS * (4 * p), t0r + t2r, t0i + t2i);
+				StoreTwiddled(inY, q + inS * (4 * p + 1), t1r + t3r, t1i + t3i, w1r, w1i);
+				StoreTwiddled(inY, q + inS * (4 * p + 2), t0r - t2r, t0i - t2i, w2r, w2i);
+				StoreTwiddled(inY, q + inS * (4 * p + 3), t1r - t3r, t1i - t3i, w3r, w3i);
+			}
+		}
+	}
+
+	template <class In, class Out>
+	void	Radix5Stage(UInt32 inM, UInt32 inS, const In& inX, const Out& inY, const Float32* inWReal, const Float32* inWImag)
+	{
+		const Float32 c1 = 0.30901699437494742410f;		//	cos(2 pi / 5)
+		const Float32 c2 = -0.80901699437494742410f;	//	cos(4 pi / 5)
+		const Float32 s1 = -0.95105651629515357212f;	//	-sin(2 pi / 5)
+		const Float32 s2 = -0.58778525229247312917f;	//	-sin(4 pi / 5)
+		for(UInt32 p = 0; p < inM; ++p)
+		{
+			const Float32 w1r = inWReal[p], w1i = inWImag[p];
+			const Float32 w2r = inWReal[inM + p], w2i = inWImag[inM + p];
+			const Float32 w3r = inWReal[2 * inM + p], w3i = inWImag[2 * inM + p];
+			const Float32 w4r = inWReal[3 * inM + p], w4i = inWImag[3 * inM + p];
+			for(UInt32 q = 0; q < inS; ++q)
+			{
+				Float32 a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i, a4r, a4i;
+				inX.Load(q + inS * p, a0r, a0i);
+				inX.Load(q + inS * (p + inM), a1r, a1i);
+				inX.Load(q + inS * (p + 2 * inM), a2r, a2i);
+				inX.Load(q + inS * (p + 3 * inM), a3r, a3i);
+				inX.Load(q + inS * (p + 4 * inM), a4r, a4i);
+				
+				Float32 b1r = a1r + a4r, b1i = a1i + a4i;
+				Float32 b2r = a2r + a3r, b2i = a2i + a3i;
+				Float32 d1r = a1r - a4r, d1i = a1i - a4i;
+				Float32 d2r = a2r - a3r, d2i = a2i - a3i;
+				
+				Float32 e1r = a0r + c1 * b1r + c2 * b2r, e1i = a0i + c1 * b1i + c2 * b2i;
+				Float32 e2r = a0r + c2 * b1r + c1 * b2r, e2i = a0i + c2 * b1i + c1 * b2i;
+				Float32 f1r = s1 * d1r + s2 * d2r, f1i = s1 * d1i + s2 * d2i;
+				Float32 f2r = s2 * d1r - s1 * d2r, f2i = s2 * d1i - s1 * d2i;
+				
+				//	y1 = e1 + i f1, y4 = e1 - i f1, y2 = e2 + i f2, y3 = e2 - i f2
+				inY.Store(q + inS * (5 * p), a0r + b1r + b2r, a0i + b1i + b2i);
+				StoreTwiddled(inY, q + inS * (5 * p + 1), e1r - f1i, e1i + f1r, w1r, w1i);
+				StoreTwiddled(inY, q + inS * (5 * p + 2), e2r - f2i, e2i + f2r, w2r, w2i);
+				StoreTwiddled(inY, q + inS * (5 * p + 3), e2r + f2i, e2i - f2r, w3r, w3i);
+				StoreTwiddled(inY, q + inS * (5 * p + 4), e1r + f1i, e1i - f1r, w4r, w4i);
+			}
+		}
+	}
+}
+
+class CAPortableFFT : public CAFFTBackend
+{
+
+public:
+								CAPortableFFT(UInt32 inFFTSize);
+
+	virtual const char*			GetName() const { return "Portable"; }
+	virtual bool				IsReentrant() const { return false; }
+	virtual void				Forward(const Float32* inInput, DSPSplitComplex& outSpectrum);
+	virtual void				Inverse(DSPSplitComplex& ioSpectrum, Float32* outOutput);
+
+	static bool					Factor(UInt32 inSize, std::vector<UInt32>* outRadices);
+
+private:
+	struct Stage
+	{
+		UInt32					mRadix;
+		UInt32					mM;			//	sub-transform length divided by the radix
+		UInt32					mStride;
+		std::vector<Float32>	mTwiddleReal;
+		std::vector<Float32>	mTwiddleImag;
+	};
+
+	template <class In, class Out>
+	static void					RunStage(const Stage& inStage, const In& inX, const Out& inY);
+
+	UInt32						mHalfSize;
+	std::vector<Stage>			mStages;
+	std::vector<Float32>		mPostCos;	//	cos(2 pi k / N)
+	std::vector<Float32>		mPostSin;	//	sin(2 pi k / N)
+	std::vector<Float32>		mWork[2][2];
+
+};
+
+CAPortableFFT::CAPortableFFT(UInt32 inFFTSize)
+:
+	CAFFTBackend(inFFTSize),
+	mHalfSize(inFFTSize / 2)
+{
+	std::vector<UInt32> theRadices;
+	Factor(mHalfSize, &theRadices);
+	
+	//	build the stages and their twiddles, exp(-2 pi i k p / n) for the sub-transform length n
+	UInt32 theLength = mHalfSize;
+	UInt32 theStride = 1;
+	mStages.resize(theRadices.size());
+	for(size_t theStageIndex = 0; theStageIndex < theRadices.size(); ++theStageIndex)
+	{
+		Stage& theStage = mStages[theStageIndex];
+		theStage.mRadix = theRadices[theStageIndex];
+		theStage.mM = theLength / theStage.mRadix;
+		theStage.mStride = theStride;
+		theStage.mTwiddleReal.resize((theStage.mRadix - 1) * theStage.mM);
+		theStage.mTwiddleImag.resize((theStage.mRadix - 1) * theStage.mM);
+		for(UInt32 k = 1; k < theStage.mRadix; ++k)
+		{
+			for(UInt32 p = 0; p < theStage.mM; ++p)
+			{
+				double theAngle = -2.0 * M_PI * (double)(k * p) / (double)theLength;
+				theStage.mTwiddleReal[(k - 1) * theStage.mM + p] = (Float32)cos(theAngle);
+				theStage.mTwiddleImag[(k - 1) * theStage.mM + p] = (Float32)sin(theAngle);
+			}
+		}
+		theLength = theStage.mM;
+		theStride *= theStage.mRadix;
+	}
+	
+	mPostCos.resize(mHalfSize);
+	mPostSin.resize(mHalfSize);
+	for(UInt32 k = 0; k < mHalfSize; ++k)
+	{
+		double theAngle = 2.0 * M_PI * (double)k / (double)inFFTSize;
+		mPostCos[k] = (Float32)cos(theAngle);
+		mPostSin[k] = (Float32)sin(theAngle);
+	}
+	
+	for(int i = 0; i < 2; ++i)
+	{
+		mWork[i][0].resize(mHalfSize);
+		mWork[i][1].resize(mHalfSize);
+	}
+}
+
+bool	CAPortableFFT::Factor(UInt32 inSize, std::vector<UInt32>* outRadices)
+{
+	//	radix 4 first since it needs the fewest operations per point
+	static const UInt32 kRadices[] = { 4, 2, 3, 5 };
+	if(inSize < 4)
+	{
+		return false;
+	}
+	UInt32 theRest = inSize;
+	for(UInt32 theRadixIndex = 0; theRadixIndex < sizeof(kRadices) / sizeof(kRadices[0]); ++theRadixIndex)
+	{
+		while((theRest % kRadices[theRadixIndex]) == 0)
+		{
+			if(outRadices != NULL)
+			{
+				outRadices->push_back(kRadices[theRadixIndex]);
+			}
+			theRest /= kRadices[theRadixIndex];
+		}
+	}
+	return theRest == 1;
+}
+
+template <class In, class Out>
+void	CAPortableFFT::RunStage(const Stage& inStage, const In& inX, const Out& inY)
+{
+	const Float32* theWReal = &inStage.mTwiddleReal[0];
+	const Float32* theWImag = &inStage.mTwiddleImag[0];
+	switch(inStage.mRadix)
+	{
+		case 2:
+			Radix2Stage(inStage.mM, inStage.mStride, inX, inY, theWReal, theWImag);
+			break;
+		case 3:
+			Radix3Stage(inStage.mM, inStage.mStride, inX, inY, theWReal, theWImag);
+			break;
+		case 4:
+			Radix4Stage(inStage.mM, inStage.mStride, inX, inY, theWReal, theWImag);
+			break;
+		case 5:
+			Radix5Stage(inStage.mM, inStage.mStride, inX, inY, theWReal, theWImag);
+			break;
+	};
+}
+
+void	CAPortableFFT::Forward(const Float32* inInput, DSPSplitComplex& outSpectrum)
+{
+	//	complex FFT of the input read as M complex pairs, ping-ponging between the work buffers
+	InterleavedIn theInput = { inInput };
+	SplitOut theFirstOutput = { &mWork[0][0][0], &mWork[0][1][0] };
+	RunStage(mStages[0], theInput, theFirstOutput);
+	UInt32 theCurrent = 0;
+	for(size_t theStageIndex = 1; theStageIndex < mStages.size(); ++theStageIndex)
+	{
+		SplitIn theX = { &mWork[theCurrent][0][0], &mWork[theCurrent][1][0] };
+		SplitOut theY = { &mWork[1 - theCurrent][0][0], &mWork[1 - theCurrent][1][0] };
+		RunStage(mStages[theStageIndex], theX, theY);
+		theCurrent = 1 - theCurrent;
+	}
+	const Float32* zr = &mWork[theCurrent][0][0];
+	const Float32* zi = &mWork[theCurrent][1][0];
+	
+	//	S[k] = E + (-sin - i cos) O with E = Z[k] + conj(Z[M - k]), O = Z[k] - conj(Z[M - k]),
+	//	which is twice the DFT of the real input
+	Float32* sr = outSpectrum.realp;
+	Float32* si = outSpectrum.imagp;
+	sr[0] = 2.0f * (zr[0] + zi[0]);
+	si[0] = 2.0f * (zr[0] - zi[0]);
+	for(UInt32 k = 1; k < mHalfSize; ++k)
+	{
+		UInt32 j = mHalfSize - k;
+		Float32 er = zr[k] + zr[j], ei = zi[k] - zi[j];
+		Float32 orr = zr[k] - zr[j], oi = zi[k] + zi[j];
+		Float32 c = mPostCos[k], s = mPostSin[k];
+		sr[k] = er - s * orr + c * oi;
+		si[k] = ei - s * oi - c * orr;
+	}
+}
+
+void	CAPortableFFT::Inverse(DSPSplitComplex& ioSpectrum, Float32* outOutput)
+{
+	//	rebuild 4 Z[k] from the packed spectrum and store it conjugated, so the forward stages
+	//	compute the inverse
+	const Float32* sr = ioSpectrum.realp;
+	const Float32* si = ioSpectrum.imagp;
+	Float32* zr = &mWork[0][0][0];
+	Float32* zi = &mWork[0][1][0];
+	zr[0] = sr[0] + si[0];
+	zi[0] = -(sr[0] - si[0]);
+	for(UInt32 k = 1; k < mHalfSize; ++k)
+	{
+		UInt32 j = mHalfSize - k;
+		//	A = S[k], B = conj(S[M - k]), 4 Z[k] = (A + B) + (sin - i cos) (B - A)
+		Float32 ar = sr[k], ai = si[k];
+		Float32 br = sr[j], bi = -si[j];
+		Float32 dr = br - ar, di = bi - ai;
+		Float32 c = mPostCos[k], s = mPostSin[k];
+		zr[k] = (ar + br) + s * dr + c * di;
+		zi[k] = -((ai + bi) + s * di - c * dr);
+	}
+	
+	UInt32 theCurrent = 0;
+	InterleavedConjugateOut theOutput = { outOutput };
+	for(size_t theStageIndex = 0; theStageIndex < mStages.size(); ++theStageIndex)
+	{
+		SplitIn theX = { &mWork[theCurrent][0][0], &mWork[theCurrent][1][0] };
+		if(theStageIndex + 1 == mStages.size())
+		{
+			RunStage(mStages[theStageIndex], theX, theOutput);
+		}
+		else
+		{
+			SplitOut theY = { &mWork[1 - theCurrent][0][0], &mWork[1 - theCurrent][1][0] };
+			RunStage(mStages[theStageIndex], theX, theY);
+			theCurrent = 1 - theCurrent;
+		}
+	}
+}
+
+#if __APPLE__
+
+//==================================================================================================
+//	CAvDSPFFT
+//==================================================================================================
+
+class CAvDSPFFT : public CAFFTBackend
+{
+
+public:
+								CAvDSPFFT(UInt32 inFFTSize)
+								:
+									CAFFTBackend(inFFTSize),
+									mLog2FFTSize(0),
+									mFFTSetup(NULL)
+								{
+									while((1U << mLog2FFTSize) < inFFTSize)
+									{
+										++mLog2FFTSize;
+									}
+									mFFTSetup = vDSP_create_fftsetup(mLog2FFTSize, FFT_RADIX2);
+									if(mFFTSetup == NULL)
+									{
+										throw std::bad_alloc();
+									}
+								}
+	virtual						~CAvDSPFFT() { vDSP_destroy_fftsetup(mFFTSetup); }
+
+	virtual const char*			GetName() const { return "vDSP"; }
+	virtual bool				IsReentrant() const { return true; }
+
+	virtual void				Forward(const Float32* inInput, DSPSplitComplex& outSpectrum)
+								{
+									vDSP_ctoz(reinterpret_cast<const DSPComplex*>(inInput), 2, &outSpectrum, 1, mFFTSize >> 1);
+									vDSP_fft_zrip(mFFTSetup, &outSpectrum, 1, mLog2FFTSize, FFT_FORWARD);
+								}
+
+	virtual void				Inverse(DSPSplitComplex& ioSpectrum, Float32* outOutput)
+								{
+									vDSP_fft_zrip(mFFTSetup, &ioSpectrum, 1, mLog2FFTSize, FFT_INVERSE);
+									vDSP_ztoc(&ioSpectrum, 1, reinterpret_cast<DSPComplex*>(outOutput), 2, mFFTSize >> 1);
+								}
+
+private:
+	UInt32						mLog2FFTSize;
+	FFTSetup					mFFTSetup;
+
+};
+
+static bool	IsPowerOfTwo(UInt32 inValue)
+{
+	return (inValue != 0) && ((inValue & (inValue - 1)) == 0);
+}
+
+#endif
+
+//==================================================================================================
+//	CAFFTBackend
+//==================================================================================================
+
+bool	CAFFTBackend::IsSupportedSize(UInt32 inFFTSize, Kind inKind)
+{
+	bool thePortableAnswer = ((inFFTSize % 2) == 0) && (inFFTSize >= 8) && CAPortableFFT::Factor(inFFTSize / 2, NULL);
+	switch(inKind)
+	{
+		case kKind_vDSP:
+			#if __APPLE__
+				return IsPowerOfTwo(inFFTSize) && (inFFTSize >= 8);
+			#else
+				return false;
+			#endif
+		
+		case kKind_Portable:
+		case kKind_Default:
+		default:
+			return thePortableAnswer;
+	};
+}
+
+CAFFTBackend*	CAFFTBackend::Create(UInt32 inFFTSize, Kind inKind)
+{
+	if(!IsSupportedSize(inFFTSize, inKind))
+	{
+		return NULL;
+	}
+	
+	#if __APPLE__
+		if((inKind == kKind_vDSP) || ((inKind == kKind_Default) && IsPowerOfTwo(inFFTSize)))
+		{
+			return new CAvDSPFFT(inFFTSize);
+		}
+	#endif
+	return new CAPortableFFT(inFFTSize);
+}
@@ -0,0 +1,105 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#if !defined(__CAFFTBackend_h__)
+#define __CAFFTBackend_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+#if __APPLE__
+	#include <Accelerate/Accelerate.h>
+#else
+	//	the split complex layout vDSP uses, so that SpectralBufferList looks the same everywhere
+	struct DSPSplitComplex
+	{
+		float*	realp;
+		float*	imagp;
+	};
+	typedef struct DSPSplitComplex DSPSplitComplex;
+#endif
+
+/*==================================================================================================
+	CAFFTBackend
+
+	The real FFT used by CASpectralProcessor. Every backend follows the vDSP_fft_zrip conventions
+	so that spectral functions don't care which one is in use:
+
+	-	Forward() takes N real samples and produces N/2 complex bins in split form that are twice
+		the DFT. The real parts of the DC and Nyquist bins are packed into realp[0] and imagp[0].
+	-	Inverse() takes such a spectrum and produces the unnormalized inverse, so a round trip
+		scales the signal by 2N.
+
+	The portable backend works for any even N of at least 8 whose half is a product of 2, 3 and 5.
+	It reads the real input and writes the real output in place of the complex pairs, so no
+	separate interleaved to split conversion pass is needed. The vDSP backend only exists on Apple
+	platforms and needs a power of two size.
+==================================================================================================*/
+
+class CAFFTBackend
+{
+
+public:
+	enum Kind
+	{
+		kKind_Default,		//	vDSP where it can, the portable backend otherwise
+		kKind_vDSP,
+		kKind_Portable
+	};
+
+	//	returns NULL if the kind doesn't support the size
+	static CAFFTBackend*		Create(UInt32 inFFTSize, Kind inKind = kKind_Default);
+	static bool					IsSupportedSize(UInt32 inFFTSize, Kind inKind = kKind_Default);
+
+	virtual						~CAFFTBackend() {}
+
+	UInt32						GetSize() const { return mFFTSize; }
+	virtual const char*			GetName() const = 0;
+
+	//	whether one instance can transform on several threads at the same time
+	virtual bool				IsReentrant() const = 0;
+
+	//	ioSpectrum may be used as scratch space by Inverse()
+	virtual void				Forward(const Float32* inInput, DSPSplitComplex& outSpectrum) = 0;
+	virtual void				Inverse(DSPSplitComplex& ioSpectrum, Float32* outOutput) = 0;
+
+protected:
+								CAFFTBackend(UInt32 inFFTSize) : mFFTSize(inFFTSize) {}
+
+	UInt32						mFFTSize;
+
+private:
+								CAFFTBackend(const CAFFTBackend&);
+	CAFFTBackend&				operator=(const CAFFTBackend&);
+
+};
+
+#endif	//	__CAFFTBackend_h__
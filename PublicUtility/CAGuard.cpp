@@ -53,6 +53,13 @@
 
 #if TARGET_OS_MAC
 	#include <errno.h>
+#elif CAMutex_Use_Futex
+	#include <errno.h>
+	#include <limits.h>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#include <time.h>
+	#include <unistd.h>
 #endif
 
 //	PublicUtility Inludes
@@ -72,6 +79,34 @@
 //	#define	Log_Errors			1
 #endif
 
+//==================================================================================================
+//	Helpers
+//==================================================================================================
+
+#if CAMutex_Use_Futex
+
+//	returns the error, or 0 if the wait was ended by a wake up or the value having changed already
+static inline int	CAGuard_FutexWait(std::atomic<UInt32>& inEventCount, UInt32 inValue, const struct timespec* inTimeout)
+{
+	int theError = 0;
+	if(syscall(SYS_futex, reinterpret_cast<int*>(&inEventCount), FUTEX_WAIT_PRIVATE, inValue, inTimeout, NULL, 0) != 0)
+	{
+		theError = errno;
+		if((theError == EAGAIN) || (theError == EINTR))
+		{
+			theError = 0;
+		}
+	}
+	return theError;
+}
+
+static inline void	CAGuard_FutexWake(std::atomic<UInt32>& inEventCount, int inNumberThreads)
+{
+	syscall(SYS_futex, reinterpret_cast<int*>(&inEventCount), FUTEX_WAKE_PRIVATE, inNumberThreads, NULL, NULL, 0);
+}
+
+#endif
+
 //#warning		Need a try-based Locker too
 //==================================================================================================
 //	CAGuard
@@ -80,6 +115,10 @@
 CAGuard::CAGuard(const char* inName)
 :
 	CAMutex(inName)
+#if CAMutex_Use_Futex
+	,mEventCount(0),
+	mNumberWaiters(0)
+#endif
 #if	Log_Average_Latency
 	,mAverageLatencyAccumulator(0.0),
 	mAverageLatencyCount(0)
@@ -143,6 +182,21 @@ void	CAGuard::Wait()
 	#if	Log_WaitOwnership
 		DebugPrintfRtn(DebugPrintfFileComma "%lu %.4f: CAGuard::Wait: thread %lu waited on %s, owner: %lu\n", GetCurrentThreadId(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), GetCurrentThreadId(), mName, mOwner);
 	#endif
+#elif CAMutex_Use_Futex
+	ThrowIf(!pthread_equal(pthread_self(), mOwner), CAException(1), "CAGuard::Wait: A thread has to have locked a guard before it can wait");
+
+	#if	Log_WaitOwnership
+		DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAGuard::Wait: thread %p is waiting on %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
+	#endif
+
+	UInt32 theEventCount = PrepareToWait();
+	int theError = CAGuard_FutexWait(mEventCount, theEventCount, NULL);
+	FinishWaiting();
+	ThrowIf(theError != 0, CAException(theError), "CAGuard::Wait: Could not wait for a signal");
+
+	#if	Log_WaitOwnership
+		DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAGuard::Wait: thread %p waited on %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
+	#endif
 #endif
 }
 
@@ -271,6 +325,60 @@ bool	CAGuard::WaitFor(UInt64 inNanos)
 	#endif
 
 	theAnswer = theError == WAIT_TIMEOUT;
+#elif CAMutex_Use_Futex
+	ThrowIf(!pthread_equal(pthread_self(), mOwner), CAException(1), "CAGuard::WaitFor: A thread has to have locked a guard be for it can wait");
+
+	#if	Log_TimedWaits
+		DebugMessageN1("CAGuard::WaitFor: waiting %.0f", (Float64)inNanos);
+	#endif
+
+	//	FUTEX_WAIT takes a relative time out on CLOCK_MONOTONIC
+	struct timespec	theTimeSpec;
+	static const UInt64	kNanosPerSecond = 1000000000ULL;
+	theTimeSpec.tv_sec = static_cast<time_t>(inNanos / kNanosPerSecond);
+	theTimeSpec.tv_nsec = static_cast<long>(inNanos % kNanosPerSecond);
+	
+	#if	Log_TimedWaits || Log_Latency || Log_Average_Latency
+		UInt64	theStartNanos = CAHostTimeBase::GetCurrentTimeInNanos();
+	#endif
+
+	#if	Log_WaitOwnership
+		DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAGuard::WaitFor: thread %p is waiting on %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
+	#endif
+
+	UInt32 theEventCount = PrepareToWait();
+	int theError = CAGuard_FutexWait(mEventCount, theEventCount, &theTimeSpec);
+	FinishWaiting();
+	ThrowIf((theError != 0) && (theError != ETIMEDOUT), CAException(theError), "CAGuard::WaitFor: Wait got an error");
+	
+	#if	Log_TimedWaits || Log_Latency || Log_Average_Latency
+		UInt64	theEndNanos = CAHostTimeBase::GetCurrentTimeInNanos();
+	#endif
+	
+	#if	Log_TimedWaits
+		DebugMessageN1("CAGuard::WaitFor: waited  %.0f", (Float64)(theEndNanos - theStartNanos));
+	#endif
+	
+	#if	Log_Latency
+		DebugMessageN1("CAGuard::WaitFor: latency  %.0f", (Float64)((theEndNanos - theStartNanos) - inNanos));
+	#endif
+	
+	#if	Log_Average_Latency
+		++mAverageLatencyCount;
+		mAverageLatencyAccumulator += (theEndNanos - theStartNanos) - inNanos;
+		if(mAverageLatencyCount >= 50)
+		{
+			DebugMessageN2("CAGuard::WaitFor: average latency  %.3f ns over %ld waits", mAverageLatencyAccumulator / mAverageLatencyCount, mAverageLatencyCount);
+			mAverageLatencyCount = 0;
+			mAverageLatencyAccumulator = 0.0;
+		}
+	#endif
+
+	#if	Log_WaitOwnership
+		DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAGuard::WaitFor: thread %p waited on %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
+	#endif
+
+	theAnswer = theError == ETIMEDOUT;
 #endif
 
 	return theAnswer;
@@ -321,6 +429,12 @@ void	CAGuard::Notify()
 	#endif
 	
 	SetEvent(mEvent);
+#elif CAMutex_Use_Futex
+	#if	Log_WaitOwnership
+		DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAGuard::Notify: thread %p is notifying %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
+	#endif
+
+	WakeWaiters(false);
 #endif
 }
 
@@ -339,5 +453,54 @@ void	CAGuard::NotifyAll()
 	#endif
 	
 	SetEvent(mEvent);
+#elif CAMutex_Use_Futex
+	#if	Log_WaitOwnership
+		DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAGuard::NotifyAll: thread %p is notifying %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
+	#endif
+
+	WakeWaiters(true);
 #endif
 }
+
+#if CAMutex_Use_Futex
+
+UInt32	CAGuard::PrepareToWait()
+{
+	//	a waiter is counted before it sets the bit, so a notification that clears the bit sees it
+	mNumberWaiters.fetch_add(1, std::memory_order_seq_cst);
+	UInt32 theEventCount = mEventCount.fetch_or(kHasWaitersBit, std::memory_order_seq_cst) | kHasWaitersBit;
+	
+	//	from here on any notification changes the event count, so the futex won't sleep through it
+	mOwner = 0;
+	Release();
+	return theEventCount;
+}
+
+void	CAGuard::FinishWaiting()
+{
+	mNumberWaiters.fetch_sub(1, std::memory_order_relaxed);
+	if(!TryToAcquire())
+	{
+		Acquire();
+	}
+	mOwner = pthread_self();
+}
+
+void	CAGuard::WakeWaiters(bool inWakeAll)
+{
+	//	nobody has waited since the last wake up, which is the free case
+	UInt32 theEventCount = mEventCount.load(std::memory_order_acquire);
+	while((theEventCount & kHasWaitersBit) != 0)
+	{
+		//	every thread that set the bit before this is either woken now or sees the new count
+		if(mEventCount.compare_exchange_weak(theEventCount, (theEventCount + kEventIncrement) & ~static_cast<UInt32>(kHasWaitersBit), std::memory_order_seq_cst, std::memory_order_acquire))
+		{
+			//	clearing the bit hides any other sleeper from the next notification, so they all have to go
+			bool wakeAll = inWakeAll || (mNumberWaiters.load(std::memory_order_seq_cst) > 1);
+			CAGuard_FutexWake(mEventCount, wakeAll ? INT_MAX : 1);
+			break;
+		}
+	}
+}
+
+#endif
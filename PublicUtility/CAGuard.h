@@ -54,6 +54,8 @@
 //	Super Class Includes
 #include "CAMutex.h"
 
+#include <atomic>
+
 #if CoreAudio_Debug
 //	#define	Log_Average_Latency	1
 #endif
@@ -68,6 +70,18 @@
 //	to properly manage the recursive nesting. The Wait calls with timeouts
 //	will return true if and only if the timeout period expired. They will
 //	return false if they receive notification any other way.
+//
+//	On Linux the signalling is an event count on a futex instead of a cond
+//	var. Notify costs one atomic load when nobody is waiting, and the
+//	notifications that arrive before a woken thread waits again are folded
+//	into the wakeup that is already on its way, so a worker that is notified
+//	once per IO cycle doesn't make the IO thread enter the kernel every time.
+//	Like with a cond var, a notification that isn't made with the guard
+//	locked can be missed by a thread that is just about to wait. Notify
+//	wakes one thread only when one is waiting, with more it is NotifyAll:
+//	it clears the bit the other sleepers would need for the next Notify to
+//	reach them. So a woken thread has to check what it waited for again,
+//	which a cond var asks for anyway.
 //==================================================================================================
 
 class	CAGuard : public CAMutex
@@ -84,15 +98,28 @@ public:
 	virtual bool	WaitFor(UInt64 inNanos);
 	virtual bool	WaitUntil(UInt64 inNanos);
 	
-	virtual void	Notify();
+	virtual void	Notify();			//	on Linux, all waiters when there are several
 	virtual void	NotifyAll();
 
 //	Implementation
 protected:
 #if TARGET_OS_MAC
 	pthread_cond_t	mCondVar;
-#else
+#elif TARGET_OS_WIN32
 	HANDLE			mEvent;
+#elif CAMutex_Use_Futex
+	enum
+	{
+					kHasWaitersBit	= 1,	//	set by a waiter, cleared by the notification that wakes it
+					kEventIncrement	= 2
+	};
+	
+	UInt32			PrepareToWait();
+	void			FinishWaiting();
+	void			WakeWaiters(bool inWakeAll);
+	
+	std::atomic<UInt32>	mEventCount;
+	std::atomic<UInt32>	mNumberWaiters;
 #endif
 #if	Log_Average_Latency
 	Float64			mAverageLatencyAccumulator;
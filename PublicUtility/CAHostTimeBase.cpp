@@ -49,12 +49,20 @@
 //=============================================================================
 
 #include "CAHostTimeBase.h"
+#if CAHostTimeBase_Use_TSC
+	#include <cpuid.h>
+#endif
 
 Float64			CAHostTimeBase::sFrequency = 0;
 Float64			CAHostTimeBase::sInverseFrequency = 0;
 UInt32			CAHostTimeBase::sMinDelta = 0;
 UInt32			CAHostTimeBase::sToNanosNumerator = 0;
 UInt32			CAHostTimeBase::sToNanosDenominator = 0;
+UInt64			CAHostTimeBase::sToNanosMultiplier = 0;
+UInt32			CAHostTimeBase::sToNanosShift = 0;
+UInt64			CAHostTimeBase::sFromNanosMultiplier = 0;
+UInt32			CAHostTimeBase::sFromNanosShift = 0;
+bool			CAHostTimeBase::sIsUsingTSC = false;
 pthread_once_t	CAHostTimeBase::sIsInited = PTHREAD_ONCE_INIT;
 #if Track_Host_TimeBase
 UInt64			CAHostTimeBase::sLastTime = 0;
@@ -86,14 +94,128 @@ void	CAHostTimeBase::Initialize()
 		sToNanosNumerator = 1000000000ULL;
 		sToNanosDenominator = *((UInt64*)&theFrequency);
 		sFrequency = static_cast<Float64>(*((UInt64*)&theFrequency));
+	#elif defined(__linux__)
+		//	CLOCK_MONOTONIC_RAW isn't slewed by NTP, so it ticks like mach_absolute_time does
+		sMinDelta = 1;
+		sToNanosNumerator = 1;
+		sToNanosDenominator = 1;
+		sFrequency = 1000000000.0;
+		#if CAHostTimeBase_Use_TSC
+			sIsUsingTSC = CalibrateTSC();
+		#endif
 	#endif
 	sInverseFrequency = 1.0 / sFrequency;
 	
+	SetFixedPointRatio(sToNanosNumerator, sToNanosDenominator, sToNanosMultiplier, sToNanosShift);
+	SetFixedPointRatio(sToNanosDenominator, sToNanosNumerator, sFromNanosMultiplier, sFromNanosShift);
+	
 	#if	Log_Host_Time_Base_Parameters
 		DebugPrintf("Host Time Base Parameters");
 		DebugPrintf(" Minimum Delta:          %lu", (unsigned long)sMinDelta);
 		DebugPrintf(" Frequency:              %f", sFrequency);
 		DebugPrintf(" To Nanos Numerator:     %lu", (unsigned long)sToNanosNumerator);
 		DebugPrintf(" To Nanos Denominator:   %lu", (unsigned long)sToNanosDenominator);
+		DebugPrintf(" Using TSC:              %d", sIsUsingTSC ? 1 : 0);
 	#endif
 }
+
+void	CAHostTimeBase::SetFixedPointRatio(UInt32 inNumerator, UInt32 inDenominator, UInt64& outMultiplier, UInt32& outShift)
+{
+	outMultiplier = 0;
+	outShift = 0;
+	
+	#if CAHostTimeBase_Use_Fixed_Point
+		//	reduce the ratio, which makes the multiplier exact more often
+		UInt32 theA = inNumerator;
+		UInt32 theB = inDenominator;
+		while(theB != 0)
+		{
+			UInt32 theRemainder = theA % theB;
+			theA = theB;
+			theB = theRemainder;
+		}
+		if(theA == 0)
+		{
+			return;
+		}
+		UInt64 theNumerator = inNumerator / theA;
+		UInt64 theDenominator = inDenominator / theA;
+		
+		//	use the largest shift whose multiplier still fits in 64 bits. Rounding the multiplier up
+		//	makes (x * multiplier) >> shift equal to MultiplyByRatio's floor(x * numerator / denominator)
+		//	while x < 2^shift / denominator, and at most one more than it while x < 2^shift. The
+		//	numerator has at most 32 bits, so shifting it by up to 96 can't overflow.
+		for(UInt32 theShift = 96; theShift > 0; --theShift)
+		{
+			unsigned __int128 theScaled = static_cast<unsigned __int128>(theNumerator) << theShift;
+			unsigned __int128 theMultiplier = (theScaled + theDenominator - 1) / theDenominator;
+			if((theMultiplier >> 64) == 0)
+			{
+				outMultiplier = static_cast<UInt64>(theMultiplier);
+				outShift = theShift;
+				return;
+			}
+		}
+	#endif
+}
+
+#if CAHostTimeBase_Use_TSC
+bool	CAHostTimeBase::CalibrateTSC()
+{
+	//	only an invariant TSC ticks at a constant rate through frequency and power state changes
+	unsigned int theEAX, theEBX, theECX, theEDX;
+	if((__get_cpuid(0x80000007, &theEAX, &theEBX, &theECX, &theEDX) == 0) || ((theEDX & (1U << 8)) == 0))
+	{
+		return false;
+	}
+	
+	//	two samples ~10ms apart
+	UInt64 theStartTSC = 0, theStartNanos = 0;
+	SampleTSC(theStartTSC, theStartNanos);
+	
+	struct timespec theDelay = { 0, 10000000 };
+	while(nanosleep(&theDelay, &theDelay) != 0)
+	{
+	}
+	
+	UInt64 theEndTSC = 0, theEndNanos = 0;
+	SampleTSC(theEndTSC, theEndNanos);
+	
+	if((theEndNanos <= theStartNanos) || (theEndTSC <= theStartTSC))
+	{
+		return false;
+	}
+	
+	//	keep the ratio in kHz so that it fits the 32 bit numerator and denominator
+	Float64 theFrequency = static_cast<Float64>(theEndTSC - theStartTSC) * 1000000000.0 / static_cast<Float64>(theEndNanos - theStartNanos);
+	UInt64 theKiloHertz = static_cast<UInt64>(theFrequency / 1000.0 + 0.5);
+	if((theKiloHertz < 100000) || (theKiloHertz > 0xFFFFFFFFULL))
+	{
+		return false;
+	}
+	
+	sToNanosNumerator = 1000000;
+	sToNanosDenominator = static_cast<UInt32>(theKiloHertz);
+	sFrequency = static_cast<Float64>(theKiloHertz) * 1000.0;
+	return true;
+}
+
+void	CAHostTimeBase::SampleTSC(UInt64& outTSC, UInt64& outNanos)
+{
+	//	bracket a CLOCK_MONOTONIC_RAW read between two TSC reads and keep the tightest of a few. The
+	//	first read of the clock is slow, and bracketing only that one was off by hundreds of ppm.
+	UInt64 theNarrowest = ~0ULL;
+	for(UInt32 theTry = 0; theTry < 8; ++theTry)
+	{
+		UInt64 theBefore = __rdtsc();
+		UInt64 theNanos = GetMonotonicRawNanos();
+		UInt64 theAfter = __rdtsc();
+		if(theAfter - theBefore < theNarrowest)
+		{
+			theNarrowest = theAfter - theBefore;
+			outTSC = theBefore + (theAfter - theBefore) / 2;
+			outNanos = theNanos;
+		}
+	}
+}
+#endif
@@ -63,16 +63,37 @@
 #elif TARGET_OS_WIN32
 	#include <windows.h>
 	#include "WinPThreadDefs.h"
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <time.h>
+	#if CAHostTimeBase_Use_TSC && (defined(__x86_64__) || defined(__i386__))
+		#include <x86intrin.h>
+	#else
+		#undef	CAHostTimeBase_Use_TSC
+		#define	CAHostTimeBase_Use_TSC	0
+	#endif
 #else
 	#error	Unsupported operating system
 #endif
 
+//	the conversions multiply by a fixed-point ratio and shift instead of dividing
+#if defined(__SIZEOF_INT128__)
+	#define	CAHostTimeBase_Use_Fixed_Point	1
+#else
+	#define	CAHostTimeBase_Use_Fixed_Point	0
+#endif
+
 #include "CADebugPrintf.h"
 
 //=============================================================================
 //	CAHostTimeBase
 //
 //	This class provides platform independent access to the host's time base.
+//
+//	On Linux the host time is CLOCK_MONOTONIC_RAW in nanoseconds. Building with
+//	CAHostTimeBase_Use_TSC set to 1 reads the TSC instead when the CPU has an invariant one,
+//	with its frequency calibrated against CLOCK_MONOTONIC_RAW the first time the time base is
+//	used. That takes a few milliseconds, so touch the time base before the IO thread does.
 //=============================================================================
 
 #if CoreAudio_Debug
@@ -88,7 +109,7 @@ public:
 	static UInt64			ConvertFromNanos(UInt64 inNanos);
 
 	static UInt64			GetTheCurrentTime();
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
 	static UInt64			GetCurrentTime() { return GetTheCurrentTime(); }
 #endif
 	static UInt64			GetCurrentTimeInNanos();
@@ -102,8 +123,17 @@ public:
 
 	static UInt64			MultiplyByRatio(UInt64 inMuliplicand, UInt32 inNumerator, UInt32 inDenominator);
 	
+	//	whether the host time comes from the TSC, only ever on Linux
+	static bool				IsUsingTSC() { pthread_once(&sIsInited, Initialize); return sIsUsingTSC; }
+	
 private:
 	static void				Initialize();
+	static void				SetFixedPointRatio(UInt32 inNumerator, UInt32 inDenominator, UInt64& outMultiplier, UInt32& outShift);
+#if defined(__linux__)
+	static UInt64			GetMonotonicRawNanos();
+	static bool				CalibrateTSC();
+	static void				SampleTSC(UInt64& outTSC, UInt64& outNanos);
+#endif
 	
 	static pthread_once_t	sIsInited;
 	
@@ -112,6 +142,13 @@ private:
 	static UInt32			sMinDelta;
 	static UInt32			sToNanosNumerator;
 	static UInt32			sToNanosDenominator;
+	
+	//	x * numerator / denominator == (x * multiplier) >> shift, with the multiplier in 64 bits
+	static UInt64			sToNanosMultiplier;
+	static UInt32			sToNanosShift;
+	static UInt64			sFromNanosMultiplier;
+	static UInt32			sFromNanosShift;
+	static bool				sIsUsingTSC;
 #if Track_Host_TimeBase
 	static UInt64			sLastTime;
 #endif
@@ -127,6 +164,12 @@ inline UInt64	CAHostTimeBase::GetTheCurrentTime()
 		LARGE_INTEGER theValue;
 		QueryPerformanceCounter(&theValue);
 		theTime = *((UInt64*)&theValue);
+	#elif CAHostTimeBase_Use_TSC
+		//	the clock has to be chosen before the first time is handed out
+		pthread_once(&sIsInited, Initialize);
+		theTime = sIsUsingTSC ? __rdtsc() : GetMonotonicRawNanos();
+	#elif defined(__linux__)
+		theTime = GetMonotonicRawNanos();
 	#endif
 	
 	#if	Track_Host_TimeBase
@@ -147,11 +190,24 @@ inline UInt64	CAHostTimeBase::GetTheCurrentTime()
 	return theTime;
 }
 
+#if defined(__linux__)
+inline UInt64	CAHostTimeBase::GetMonotonicRawNanos()
+{
+	struct timespec theTime;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &theTime);
+	return static_cast<UInt64>(theTime.tv_sec) * 1000000000ULL + static_cast<UInt64>(theTime.tv_nsec);
+}
+#endif
+
 inline UInt64	CAHostTimeBase::ConvertToNanos(UInt64 inHostTime)
 {
 	pthread_once(&sIsInited, Initialize);
 	
+#if CAHostTimeBase_Use_Fixed_Point
+	UInt64 theAnswer = static_cast<UInt64>((static_cast<unsigned __int128>(inHostTime) * sToNanosMultiplier) >> sToNanosShift);
+#else
 	UInt64 theAnswer = MultiplyByRatio(inHostTime, sToNanosNumerator, sToNanosDenominator);
+#endif
 	#if CoreAudio_Debug
 		if(((sToNanosNumerator > sToNanosDenominator) && (theAnswer < inHostTime)) || ((sToNanosDenominator > sToNanosNumerator) && (theAnswer > inHostTime)))
 		{
@@ -166,7 +222,11 @@ inline UInt64	CAHostTimeBase::ConvertFromNanos(UInt64 inNanos)
 {
 	pthread_once(&sIsInited, Initialize);
 
+#if CAHostTimeBase_Use_Fixed_Point
+	UInt64 theAnswer = static_cast<UInt64>((static_cast<unsigned __int128>(inNanos) * sFromNanosMultiplier) >> sFromNanosShift);
+#else
 	UInt64 theAnswer = MultiplyByRatio(inNanos, sToNanosDenominator, sToNanosNumerator);
+#endif
 	#if CoreAudio_Debug
 		if(((sToNanosDenominator > sToNanosNumerator) && (theAnswer < inNanos)) || ((sToNanosNumerator > sToNanosDenominator) && (theAnswer > inNanos)))
 		{
@@ -218,7 +278,7 @@ inline SInt64	CAHostTimeBase::HostDeltaToNanos(UInt64 inStartTime, UInt64 inEndT
 
 inline UInt64	CAHostTimeBase::MultiplyByRatio(UInt64 inMuliplicand, UInt32 inNumerator, UInt32 inDenominator)
 {
-#if TARGET_OS_MAC && TARGET_RT_64_BIT
+#if (TARGET_OS_MAC && TARGET_RT_64_BIT) || defined(__SIZEOF_INT128__)
 	__uint128_t theAnswer = inMuliplicand;
 #else
 	long double theAnswer = inMuliplicand;
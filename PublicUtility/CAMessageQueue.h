@@ -0,0 +1,542 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#if !defined(__CAMessageQueue_h__)
+#define __CAMessageQueue_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+//	Standard Library Includes
+#include <atomic>
+#include <string.h>
+
+/*==================================================================================================
+	CAMessageQueue.h
+
+	Bounded lock-free ring queues for passing messages between the IO thread and the rest of the
+	driver: meter frames and recorder blocks on the way out, parameter events and commands on the
+	way in. Everything is allocated with the queue, and no call ever blocks, allocates or makes a
+	system call. A full queue turns a push away and an empty queue returns nothing, so the caller
+	decides whether to drop, retry later or count the loss.
+
+	TSPSCQueue			one producer and one consumer, both wait-free
+	TMPSCQueue			any number of producers, one consumer
+	TSPMCQueue			one producer, any number of consumers
+	TSPSCByteQueue		one producer and one consumer of variable sized byte spans
+
+	The record queues copy fixed-size records of type T by assignment, so T should be a plain
+	struct. Their capacity is a power of two. The indices the producers and the consumers write sit
+	on cache lines of their own, and each side keeps a private copy of the other side's index that
+	it only refreshes when the queue looks full or empty, so in the steady state a push and a pop
+	don't touch any line the other side writes except the slots themselves.
+
+	Every queue has batch versions of Push and Pop that move as many records as fit in one go and
+	publish them with a single store, which is what the IO thread should use for a cycle's worth of
+	messages.
+
+	In the multiple producer and multiple consumer queues every slot carries a sequence number that
+	says whether it holds the record of the current lap. The side that has several threads claims
+	slots with a compare-and-swap on its index, which only has to be repeated when another thread
+	claimed slots in the meantime, and it gives up right away when the queue is full or empty. The
+	single side never loops. A record becomes visible once it is written, so a producer that was
+	preempted between claiming and writing its slot holds back the records behind it until it runs.
+==================================================================================================*/
+
+#if defined(__arm64__) || defined(__aarch64__)
+	#define	CAMessageQueue_CacheLineSize	128
+#else
+	#define	CAMessageQueue_CacheLineSize	64
+#endif
+
+//==================================================================================================
+//	TSPSCQueue
+//==================================================================================================
+
+template <class T, UInt32 kCapacity>
+class TSPSCQueue
+{
+
+	static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "TSPSCQueue: the capacity has to be a power of two");
+
+#pragma mark Construction/Destruction
+public:
+							TSPSCQueue() : mWriteIndex(0), mCachedReadIndex(0), mReadIndex(0), mCachedWriteIndex(0) {}
+
+private:
+							TSPSCQueue(const TSPSCQueue&);
+	TSPSCQueue&				operator=(const TSPSCQueue&);
+
+#pragma mark Producer
+public:
+	//	returns how many of the records fit, the rest were not pushed
+	UInt32					Push(const T* inRecords, UInt32 inNumberRecords)
+	{
+		UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+		UInt32 theNumberFree = kCapacity - (theWriteIndex - mCachedReadIndex);
+		if(theNumberFree < inNumberRecords)
+		{
+			mCachedReadIndex = mReadIndex.load(std::memory_order_acquire);
+			theNumberFree = kCapacity - (theWriteIndex - mCachedReadIndex);
+		}
+		UInt32 theNumberRecords = inNumberRecords < theNumberFree ? inNumberRecords : theNumberFree;
+		for(UInt32 theIndex = 0; theIndex < theNumberRecords; ++theIndex)
+		{
+			mSlots[(theWriteIndex + theIndex) & (kCapacity - 1)] = inRecords[theIndex];
+		}
+		mWriteIndex.store(theWriteIndex + theNumberRecords, std::memory_order_release);
+		return theNumberRecords;
+	}
+	
+	bool					Push(const T& inRecord)		{ return Push(&inRecord, 1) == 1; }
+
+#pragma mark Consumer
+public:
+	//	returns how many records were popped
+	UInt32					Pop(T* outRecords, UInt32 inMaximumNumberRecords)
+	{
+		UInt32 theReadIndex = mReadIndex.load(std::memory_order_relaxed);
+		UInt32 theNumberRecords = mCachedWriteIndex - theReadIndex;
+		if(theNumberRecords < inMaximumNumberRecords)
+		{
+			mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+			theNumberRecords = mCachedWriteIndex - theReadIndex;
+		}
+		if(theNumberRecords > inMaximumNumberRecords)
+		{
+			theNumberRecords = inMaximumNumberRecords;
+		}
+		for(UInt32 theIndex = 0; theIndex < theNumberRecords; ++theIndex)
+		{
+			outRecords[theIndex] = mSlots[(theReadIndex + theIndex) & (kCapacity - 1)];
+		}
+		mReadIndex.store(theReadIndex + theNumberRecords, std::memory_order_release);
+		return theNumberRecords;
+	}
+	
+	bool					Pop(T& outRecord)			{ return Pop(&outRecord, 1) == 1; }
+
+#pragma mark Attributes
+public:
+	static UInt32			GetCapacity()				{ return kCapacity; }
+	
+	//	only exact when neither side is running
+	UInt32					GetNumberRecords() const	{ return mWriteIndex.load(std::memory_order_acquire) - mReadIndex.load(std::memory_order_acquire); }
+
+#pragma mark Implementation
+private:
+	char					mLeadingPadding[CAMessageQueue_CacheLineSize];
+	
+	//	the producer's line
+	std::atomic<UInt32>		mWriteIndex;
+	UInt32					mCachedReadIndex;
+	char					mProducerPadding[CAMessageQueue_CacheLineSize - 2 * sizeof(UInt32)];
+	
+	//	the consumer's line
+	std::atomic<UInt32>		mReadIndex;
+	UInt32					mCachedWriteIndex;
+	char					mConsumerPadding[CAMessageQueue_CacheLineSize - 2 * sizeof(UInt32)];
+	
+	T						mSlots[kCapacity];
+
+};
+
+//==================================================================================================
+//	TMPSCQueue
+//==================================================================================================
+
+template <class T, UInt32 kCapacity>
+class TMPSCQueue
+{
+
+	static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "TMPSCQueue: the capacity has to be a power of two");
+
+#pragma mark Construction/Destruction
+public:
+							TMPSCQueue() : mWriteIndex(0), mReadIndex(0)
+							{
+								//	a slot is ready to be read once its sequence is one past its index, to
+								//	begin with they all look like they were read in the lap before the first
+								for(UInt32 theIndex = 0; theIndex < kCapacity; ++theIndex)
+								{
+									mSlots[theIndex].mSequence.store(theIndex - kCapacity + 1, std::memory_order_relaxed);
+								}
+							}
+
+private:
+							TMPSCQueue(const TMPSCQueue&);
+	TMPSCQueue&				operator=(const TMPSCQueue&);
+
+#pragma mark Producers
+public:
+	//	may be called on any thread, returns how many of the records fit
+	UInt32					Push(const T* inRecords, UInt32 inNumberRecords)
+	{
+		UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+		UInt32 theNumberRecords;
+		for(;;)
+		{
+			//	the consumer moves its index only after it is done with the slots
+			UInt32 theNumberUsed = theWriteIndex - mReadIndex.load(std::memory_order_acquire);
+			if(theNumberUsed > kCapacity)
+			{
+				//	other producers moved on since theWriteIndex was read
+				theWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+				continue;
+			}
+			theNumberRecords = kCapacity - theNumberUsed;
+			if(theNumberRecords > inNumberRecords)
+			{
+				theNumberRecords = inNumberRecords;
+			}
+			if(theNumberRecords == 0)
+			{
+				return 0;
+			}
+			if(mWriteIndex.compare_exchange_weak(theWriteIndex, theWriteIndex + theNumberRecords, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		
+		for(UInt32 theIndex = 0; theIndex < theNumberRecords; ++theIndex)
+		{
+			Slot& theSlot = mSlots[(theWriteIndex + theIndex) & (kCapacity - 1)];
+			theSlot.mRecord = inRecords[theIndex];
+			theSlot.mSequence.store(theWriteIndex + theIndex + 1, std::memory_order_release);
+		}
+		return theNumberRecords;
+	}
+	
+	bool					Push(const T& inRecord)		{ return Push(&inRecord, 1) == 1; }
+
+#pragma mark Consumer
+public:
+	//	returns how many records were popped, stops early at a slot that is claimed but not written
+	UInt32					Pop(T* outRecords, UInt32 inMaximumNumberRecords)
+	{
+		UInt32 theReadIndex = mReadIndex.load(std::memory_order_relaxed);
+		UInt32 theNumberRecords = 0;
+		while(theNumberRecords < inMaximumNumberRecords)
+		{
+			Slot& theSlot = mSlots[(theReadIndex + theNumberRecords) & (kCapacity - 1)];
+			if(theSlot.mSequence.load(std::memory_order_acquire) != theReadIndex + theNumberRecords + 1)
+			{
+				break;
+			}
+			outRecords[theNumberRecords] = theSlot.mRecord;
+			++theNumberRecords;
+		}
+		if(theNumberRecords != 0)
+		{
+			mReadIndex.store(theReadIndex + theNumberRecords, std::memory_order_release);
+		}
+		return theNumberRecords;
+	}
+	
+	bool					Pop(T& outRecord)			{ return Pop(&outRecord, 1) == 1; }
+
+#pragma mark Attributes
+public:
+	static UInt32			GetCapacity()				{ return kCapacity; }
+	
+	//	only exact when nobody is running
+	UInt32					GetNumberRecords() const	{ return mWriteIndex.load(std::memory_order_acquire) - mReadIndex.load(std::memory_order_acquire); }
+
+#pragma mark Implementation
+private:
+	struct Slot
+	{
+		std::atomic<UInt32>	mSequence;
+		T					mRecord;
+	};
+	
+	char					mLeadingPadding[CAMessageQueue_CacheLineSize];
+	std::atomic<UInt32>		mWriteIndex;
+	char					mProducerPadding[CAMessageQueue_CacheLineSize - sizeof(UInt32)];
+	std::atomic<UInt32>		mReadIndex;
+	char					mConsumerPadding[CAMessageQueue_CacheLineSize - sizeof(UInt32)];
+	Slot					mSlots[kCapacity];
+
+};
+
+//==================================================================================================
+//	TSPMCQueue
+//==================================================================================================
+
+template <class T, UInt32 kCapacity>
+class TSPMCQueue
+{
+
+	static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "TSPMCQueue: the capacity has to be a power of two");
+
+#pragma mark Construction/Destruction
+public:
+							TSPMCQueue() : mWriteIndex(0), mReadIndex(0)
+							{
+								//	a slot is free for the index equal to its sequence, and ready to be
+								//	read once its sequence is one past its index
+								for(UInt32 theIndex = 0; theIndex < kCapacity; ++theIndex)
+								{
+									mSlots[theIndex].mSequence.store(theIndex, std::memory_order_relaxed);
+								}
+							}
+
+private:
+							TSPMCQueue(const TSPMCQueue&);
+	TSPMCQueue&				operator=(const TSPMCQueue&);
+
+#pragma mark Producer
+public:
+	//	returns how many of the records fit, stops early at a slot a consumer is still copying from
+	UInt32					Push(const T* inRecords, UInt32 inNumberRecords)
+	{
+		UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+		UInt32 theNumberRecords = 0;
+		while(theNumberRecords < inNumberRecords)
+		{
+			Slot& theSlot = mSlots[(theWriteIndex + theNumberRecords) & (kCapacity - 1)];
+			if(theSlot.mSequence.load(std::memory_order_acquire) != theWriteIndex + theNumberRecords)
+			{
+				break;
+			}
+			theSlot.mRecord = inRecords[theNumberRecords];
+			theSlot.mSequence.store(theWriteIndex + theNumberRecords + 1, std::memory_order_release);
+			++theNumberRecords;
+		}
+		mWriteIndex.store(theWriteIndex + theNumberRecords, std::memory_order_relaxed);
+		return theNumberRecords;
+	}
+	
+	bool					Push(const T& inRecord)		{ return Push(&inRecord, 1) == 1; }
+
+#pragma mark Consumers
+public:
+	//	may be called on any thread, returns how many records were popped
+	UInt32					Pop(T* outRecords, UInt32 inMaximumNumberRecords)
+	{
+		UInt32 theReadIndex = mReadIndex.load(std::memory_order_relaxed);
+		UInt32 theNumberRecords;
+		for(;;)
+		{
+			theNumberRecords = 0;
+			while(theNumberRecords < inMaximumNumberRecords && mSlots[(theReadIndex + theNumberRecords) & (kCapacity - 1)].mSequence.load(std::memory_order_acquire) == theReadIndex + theNumberRecords + 1)
+			{
+				++theNumberRecords;
+			}
+			if(theNumberRecords == 0)
+			{
+				//	empty, unless other consumers moved on since theReadIndex was read
+				UInt32 theCurrentReadIndex = mReadIndex.load(std::memory_order_relaxed);
+				if(theCurrentReadIndex == theReadIndex)
+				{
+					return 0;
+				}
+				theReadIndex = theCurrentReadIndex;
+				continue;
+			}
+			if(mReadIndex.compare_exchange_weak(theReadIndex, theReadIndex + theNumberRecords, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		
+		//	the slots are ours until they are handed back to the producer for the next lap
+		for(UInt32 theIndex = 0; theIndex < theNumberRecords; ++theIndex)
+		{
+			Slot& theSlot = mSlots[(theReadIndex + theIndex) & (kCapacity - 1)];
+			outRecords[theIndex] = theSlot.mRecord;
+			theSlot.mSequence.store(theReadIndex + theIndex + kCapacity, std::memory_order_release);
+		}
+		return theNumberRecords;
+	}
+	
+	bool					Pop(T& outRecord)			{ return Pop(&outRecord, 1) == 1; }
+
+#pragma mark Attributes
+public:
+	static UInt32			GetCapacity()				{ return kCapacity; }
+	
+	//	only exact when nobody is running
+	UInt32					GetNumberRecords() const	{ return mWriteIndex.load(std::memory_order_relaxed) - mReadIndex.load(std::memory_order_relaxed); }
+
+#pragma mark Implementation
+private:
+	struct Slot
+	{
+		std::atomic<UInt32>	mSequence;
+		T					mRecord;
+	};
+	
+	char					mLeadingPadding[CAMessageQueue_CacheLineSize];
+	std::atomic<UInt32>		mWriteIndex;
+	char					mProducerPadding[CAMessageQueue_CacheLineSize - sizeof(UInt32)];
+	std::atomic<UInt32>		mReadIndex;
+	char					mConsumerPadding[CAMessageQueue_CacheLineSize - sizeof(UInt32)];
+	Slot					mSlots[kCapacity];
+
+};
+
+//==================================================================================================
+//	TSPSCByteQueue
+//
+//	Byte spans of up to half the capacity less the header, each stored in one piece so the
+//	consumer can read it in place. A span takes its size rounded up to 8 bytes plus an 8 byte
+//	header, and a span that doesn't fit before the end of the ring starts over at the beginning.
+//==================================================================================================
+
+template <UInt32 kCapacity>
+class TSPSCByteQueue
+{
+
+	static_assert(kCapacity >= 16 && (kCapacity & (kCapacity - 1)) == 0, "TSPSCByteQueue: the capacity has to be a power of two");
+
+#pragma mark Construction/Destruction
+public:
+							TSPSCByteQueue() : mWriteIndex(0), mCachedReadIndex(0), mReadIndex(0), mCachedWriteIndex(0) {}
+
+private:
+							TSPSCByteQueue(const TSPSCByteQueue&);
+	TSPSCByteQueue&			operator=(const TSPSCByteQueue&);
+
+#pragma mark Producer
+public:
+	//	returns false if the span doesn't fit right now, or never does
+	bool					Push(const void* inBytes, UInt32 inNumberBytes)
+	{
+		if(inNumberBytes > GetMaximumSpanSize())
+		{
+			return false;
+		}
+		UInt32 theSpanSize = GetSpanSize(inNumberBytes);
+		UInt32 theWriteIndex = mWriteIndex.load(std::memory_order_relaxed);
+		UInt32 theNumberBytesToEnd = kCapacity - (theWriteIndex & (kCapacity - 1));
+		UInt32 theNumberBytesNeeded = theSpanSize + (theNumberBytesToEnd < theSpanSize ? theNumberBytesToEnd : 0);
+		if(kCapacity - (theWriteIndex - mCachedReadIndex) < theNumberBytesNeeded)
+		{
+			mCachedReadIndex = mReadIndex.load(std::memory_order_acquire);
+			if(kCapacity - (theWriteIndex - mCachedReadIndex) < theNumberBytesNeeded)
+			{
+				return false;
+			}
+		}
+		if(theNumberBytesToEnd < theSpanSize)
+		{
+			*GetHeader(theWriteIndex) = kWrapMarker;
+			theWriteIndex += theNumberBytesToEnd;
+		}
+		*GetHeader(theWriteIndex) = inNumberBytes;
+		memcpy(GetHeader(theWriteIndex) + kHeaderSize / sizeof(UInt32), inBytes, inNumberBytes);
+		mWriteIndex.store(theWriteIndex + theSpanSize, std::memory_order_release);
+		return true;
+	}
+
+#pragma mark Consumer
+public:
+	//	the oldest span, which stays valid and in place until it is popped
+	bool					Peek(const void*& outBytes, UInt32& outNumberBytes)
+	{
+		UInt32 theReadIndex = mReadIndex.load(std::memory_order_relaxed);
+		if(theReadIndex == mCachedWriteIndex)
+		{
+			mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+			if(theReadIndex == mCachedWriteIndex)
+			{
+				return false;
+			}
+		}
+		if(*GetHeader(theReadIndex) == kWrapMarker)
+		{
+			//	the producer published the marker together with the span behind it
+			theReadIndex += kCapacity - (theReadIndex & (kCapacity - 1));
+			mReadIndex.store(theReadIndex, std::memory_order_release);
+		}
+		outNumberBytes = *GetHeader(theReadIndex);
+		outBytes = GetHeader(theReadIndex) + kHeaderSize / sizeof(UInt32);
+		return true;
+	}
+	
+	//	drops the span Peek returned
+	void					Pop()
+	{
+		UInt32 theReadIndex = mReadIndex.load(std::memory_order_relaxed);
+		mReadIndex.store(theReadIndex + GetSpanSize(*GetHeader(theReadIndex)), std::memory_order_release);
+	}
+	
+	//	copies the oldest span if it fits in inMaximumNumberBytes and pops it, returns its size or 0
+	UInt32					Pop(void* outBytes, UInt32 inMaximumNumberBytes)
+	{
+		const void* theBytes = NULL;
+		UInt32 theNumberBytes = 0;
+		if(!Peek(theBytes, theNumberBytes) || theNumberBytes > inMaximumNumberBytes)
+		{
+			return 0;
+		}
+		memcpy(outBytes, theBytes, theNumberBytes);
+		Pop();
+		return theNumberBytes;
+	}
+
+#pragma mark Attributes
+public:
+	static UInt32			GetCapacity()				{ return kCapacity; }
+	//	so that a span always fits into an empty queue, wherever the ring wraps
+	static UInt32			GetMaximumSpanSize()		{ return kCapacity / 2 - kHeaderSize; }
+	
+	//	only exact when neither side is running
+	UInt32					GetNumberUsedBytes() const	{ return mWriteIndex.load(std::memory_order_acquire) - mReadIndex.load(std::memory_order_acquire); }
+
+#pragma mark Implementation
+private:
+	enum					{ kHeaderSize = 8 };
+	enum : UInt32			{ kWrapMarker = 0xFFFFFFFF };
+	
+	static UInt32			GetSpanSize(UInt32 inNumberBytes)		{ return kHeaderSize + ((inNumberBytes + 7) & ~UInt32(7)); }
+	UInt32*					GetHeader(UInt32 inIndex)				{ return reinterpret_cast<UInt32*>(reinterpret_cast<char*>(mBytes) + (inIndex & (kCapacity - 1))); }
+	
+	char					mLeadingPadding[CAMessageQueue_CacheLineSize];
+	
+	//	the producer's line
+	std::atomic<UInt32>		mWriteIndex;
+	UInt32					mCachedReadIndex;
+	char					mProducerPadding[CAMessageQueue_CacheLineSize - 2 * sizeof(UInt32)];
+	
+	//	the consumer's line
+	std::atomic<UInt32>		mReadIndex;
+	UInt32					mCachedWriteIndex;
+	char					mConsumerPadding[CAMessageQueue_CacheLineSize - 2 * sizeof(UInt32)];
+	
+	UInt64					mBytes[kCapacity / sizeof(UInt64)];
+
+};
+
+#endif	//	__CAMessageQueue_h__
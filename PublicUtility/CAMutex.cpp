@@ -53,12 +53,25 @@
 
 #if TARGET_OS_MAC
 	#include <errno.h>
+#elif CAMutex_Use_Futex
+	#include <errno.h>
+	#include <linux/futex.h>
+	#include <sys/syscall.h>
+	#include <time.h>
+	#include <unistd.h>
 #endif
 
 //	PublicUtility Includes
 #include "CADebugMacros.h"
 #include "CAException.h"
-#include "CAHostTimeBase.h"
+#include "CARealTimeChecker.h"
+#if !CAMutex_Use_Futex
+	#include "CAHostTimeBase.h"
+#endif
+
+//	Standard Library Includes
+#include <string.h>
+#include <vector>
 
 //==================================================================================================
 //	Logging
@@ -71,14 +84,147 @@
 //	#define LongLatencyThreshholdNS	1000000ULL	// nanoseconds
 #endif
 
+//==================================================================================================
+//	Helpers
+//==================================================================================================
+
+static inline UInt64	CAMutex_GetCurrentTime()
+{
+#if CAMutex_Use_Futex
+	struct timespec theTime;
+	clock_gettime(CLOCK_MONOTONIC, &theTime);
+	return static_cast<UInt64>(theTime.tv_sec) * 1000000000ULL + static_cast<UInt64>(theTime.tv_nsec);
+#else
+	return CAHostTimeBase::GetTheCurrentTime();
+#endif
+}
+
+static inline UInt64	CAMutex_ConvertToNanos(UInt64 inTime)
+{
+#if CAMutex_Use_Futex
+	return inTime;
+#else
+	return CAHostTimeBase::ConvertToNanos(inTime);
+#endif
+}
+
+static inline void	CAMutex_Pause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__arm64__) || defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+//==================================================================================================
+//	CAMutexRegistry
+//
+//	Keeps track of every mutex so that the statistics can be added up by name. The counters of a
+//	mutex that goes away are folded into the retired list. The registry is never destroyed since
+//	mutexes with static storage can outlive any other static object.
+//==================================================================================================
+
+struct	CAMutexRegistry
+{
+	struct		RetiredMutex
+	{
+		const char*				mName;
+		CAMutex::Statistics		mStatistics;
+	};
+	typedef std::vector<RetiredMutex>	RetiredMutexList;
+
+	pthread_mutex_t		mMutex;
+	CAMutex*			mFirstMutex;
+	RetiredMutexList	mRetiredMutexes;
+
+						CAMutexRegistry() : mFirstMutex(NULL), mRetiredMutexes() { pthread_mutex_init(&mMutex, NULL); }
+	
+	static CAMutexRegistry&	Get() { static CAMutexRegistry* sRegistry = new CAMutexRegistry(); return *sRegistry; }
+	
+	static bool			IsSameName(const char* inName1, const char* inName2) { return strcmp(inName1 != NULL ? inName1 : "", inName2 != NULL ? inName2 : "") == 0; }
+	static void			Add(CAMutex::Statistics& ioSum, const CAMutex::Statistics& inStatistics)
+	{
+		ioSum.mNumberAcquisitions += inStatistics.mNumberAcquisitions;
+		ioSum.mNumberContendedAcquisitions += inStatistics.mNumberContendedAcquisitions;
+		ioSum.mTotalWaitNanos += inStatistics.mTotalWaitNanos;
+		if(inStatistics.mMaximumHoldNanos > ioSum.mMaximumHoldNanos)
+		{
+			ioSum.mMaximumHoldNanos = inStatistics.mMaximumHoldNanos;
+		}
+	}
+	
+	void				Register(CAMutex* inMutex)
+	{
+		pthread_mutex_lock(&mMutex);
+		inMutex->mPreviousMutex = NULL;
+		inMutex->mNextMutex = mFirstMutex;
+		if(mFirstMutex != NULL)
+		{
+			mFirstMutex->mPreviousMutex = inMutex;
+		}
+		mFirstMutex = inMutex;
+		pthread_mutex_unlock(&mMutex);
+	}
+	
+	void				Unregister(CAMutex* inMutex)
+	{
+		CAMutex::Statistics theStatistics;
+		inMutex->GetStatistics(theStatistics);
+		
+		pthread_mutex_lock(&mMutex);
+		if(inMutex->mPreviousMutex != NULL)
+		{
+			inMutex->mPreviousMutex->mNextMutex = inMutex->mNextMutex;
+		}
+		else
+		{
+			mFirstMutex = inMutex->mNextMutex;
+		}
+		if(inMutex->mNextMutex != NULL)
+		{
+			inMutex->mNextMutex->mPreviousMutex = inMutex->mPreviousMutex;
+		}
+		
+		//	the name usually is a string constant, so it outlives the mutex
+		RetiredMutexList::iterator theIterator = mRetiredMutexes.begin();
+		while((theIterator != mRetiredMutexes.end()) && !IsSameName(theIterator->mName, inMutex->mName))
+		{
+			++theIterator;
+		}
+		if(theIterator != mRetiredMutexes.end())
+		{
+			Add(theIterator->mStatistics, theStatistics);
+		}
+		else if(theStatistics.mNumberAcquisitions > 0)
+		{
+			RetiredMutex theRetiredMutex = { inMutex->mName, theStatistics };
+			mRetiredMutexes.push_back(theRetiredMutex);
+		}
+		pthread_mutex_unlock(&mMutex);
+	}
+};
+
 //==================================================================================================
 //	CAMutex
 //==================================================================================================
 
-CAMutex::CAMutex(const char* inName)
+CAMutex::CAMutex(const char* inName, UInt32 inMaximumSpinCount)
 :
 	mName(inName),
-	mOwner(0)
+	mOwner(0),
+#if CAMutex_Use_Futex
+	mState(0),
+#endif
+	mMaximumSpinCount(inMaximumSpinCount < kMaximumSpinCount ? inMaximumSpinCount : kMaximumSpinCount),
+	mSpinCount(0),
+	mNumberAcquisitions(0),
+	mNumberContendedAcquisitions(0),
+	mTotalWaitTime(0),
+	mMaximumHoldTime(0),
+	mAcquireTime(0),
+	mNextMutex(NULL),
+	mPreviousMutex(NULL)
 {
 #if TARGET_OS_MAC
 	OSStatus theError = pthread_mutex_init(&mMutex, NULL);
@@ -95,10 +241,12 @@ CAMutex::CAMutex(const char* inName)
 		DebugPrintfRtn(DebugPrintfFileComma "%lu %.4f: CAMutex::CAMutex: creating %s, owner: %lu\n", GetCurrentThreadId(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), mName, mOwner);
 	#endif
 #endif
+	CAMutexRegistry::Get().Register(this);
 }
 
 CAMutex::~CAMutex()
 {
+	CAMutexRegistry::Get().Unregister(this);
 #if TARGET_OS_MAC
 	#if	Log_Ownership
 		DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAMutex::~CAMutex: destroying %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), mName, mOwner);
@@ -117,9 +265,10 @@ CAMutex::~CAMutex()
 
 bool	CAMutex::Lock()
 {
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Lock, mName);
 	bool theAnswer = false;
 	
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || CAMutex_Use_Futex
 	pthread_t theCurrentThread = pthread_self();
 	if(!pthread_equal(theCurrentThread, mOwner))
 	{
@@ -131,9 +280,17 @@ bool	CAMutex::Lock()
 			UInt64 lockTryTime = CAHostTimeBase::GetCurrentTimeInNanos();
 		#endif
 		
-		OSStatus theError = pthread_mutex_lock(&mMutex);
-		ThrowIf(theError != 0, CAException(theError), "CAMutex::Lock: Could not lock the mutex");
+		//	the clock is only read with statistics on, and before taking the lock only when it has to
+		//	be waited for
+		bool wasContended = !TryToAcquire();
+		UInt64 theWaitStartTime = 0;
+		if(wasContended)
+		{
+			theWaitStartTime = IsCollectingStatistics() ? CAMutex_GetCurrentTime() : 0;
+			Acquire();
+		}
 		mOwner = theCurrentThread;
+		RecordAcquisition(wasContended, theWaitStartTime);
 		theAnswer = true;
 	
 		#if Log_LongLatencies
@@ -156,6 +313,7 @@ bool	CAMutex::Lock()
 		OSStatus theError = WaitForSingleObject(mMutex, INFINITE);
 		ThrowIfError(theError, CAException(theError), "CAMutex::Lock: could not lock the mutex");
 		mOwner = GetCurrentThreadId();
+		RecordAcquisition(false, 0);
 		theAnswer = true;
 	
 		#if	Log_Ownership
@@ -169,16 +327,16 @@ bool	CAMutex::Lock()
 
 void	CAMutex::Unlock()
 {
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || CAMutex_Use_Futex
 	if(pthread_equal(pthread_self(), mOwner))
 	{
 		#if	Log_Ownership
 			DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAMutex::Unlock: thread %p is unlocking %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
 		#endif
 
+		RecordRelease();
 		mOwner = 0;
-		OSStatus theError = pthread_mutex_unlock(&mMutex);
-		ThrowIf(theError != 0, CAException(theError), "CAMutex::Unlock: Could not unlock the mutex");
+		Release();
 	
 		#if	Log_Ownership
 			DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAMutex::Unlock: thread %p has unlocked %s, owner: %p\n", pthread_self(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), pthread_self(), mName, mOwner);
@@ -195,6 +353,7 @@ void	CAMutex::Unlock()
 			DebugPrintfRtn(DebugPrintfFileComma "%lu %.4f: CAMutex::Unlock: thread %lu is unlocking %s, owner: %lu\n", GetCurrentThreadId(), ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), GetCurrentThreadId(), mName, mOwner);
 		#endif
 
+		RecordRelease();
 		mOwner = 0;
 		bool wasReleased = ReleaseMutex(mMutex);
 		ThrowIf(!wasReleased, CAException(GetLastError()), "CAMutex::Unlock: Could not unlock the mutex");
@@ -215,7 +374,7 @@ bool	CAMutex::Try(bool& outWasLocked)
 	bool theAnswer = false;
 	outWasLocked = false;
 
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || CAMutex_Use_Futex
 	pthread_t theCurrentThread = pthread_self();
 	if(!pthread_equal(theCurrentThread, mOwner))
 	{
@@ -224,12 +383,12 @@ bool	CAMutex::Try(bool& outWasLocked)
 			DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAMutex::Try: thread %p is try-locking %s, owner: %p\n", theCurrentThread, ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), theCurrentThread, mName, mOwner);
 		#endif
 
-		//	go ahead and call trylock to see if we can lock it.
-		int theError = pthread_mutex_trylock(&mMutex);
-		if(theError == 0)
+		//	go ahead and try to lock it.
+		if(TryToAcquire())
 		{
-			//	return value of 0 means we successfully locked the lock
+			//	we successfully locked the lock
 			mOwner = theCurrentThread;
+			RecordAcquisition(false, 0);
 			theAnswer = true;
 			outWasLocked = true;
 	
@@ -237,9 +396,9 @@ bool	CAMutex::Try(bool& outWasLocked)
 				DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAMutex::Try: thread %p has locked %s, owner: %p\n", theCurrentThread, ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), theCurrentThread, mName, mOwner);
 			#endif
 		}
-		else if(theError == EBUSY)
+		else
 		{
-			//	return value of EBUSY means that the lock was already locked by another thread
+			//	the lock was already locked by another thread
 			theAnswer = false;
 			outWasLocked = false;
 	
@@ -247,11 +406,6 @@ bool	CAMutex::Try(bool& outWasLocked)
 				DebugPrintfRtn(DebugPrintfFileComma "%p %.4f: CAMutex::Try: thread %p failed to lock %s, owner: %p\n", theCurrentThread, ((Float64)(CAHostTimeBase::GetCurrentTimeInNanos()) / 1000000.0), theCurrentThread, mName, mOwner);
 			#endif
 		}
-		else
-		{
-			//	any other return value means something really bad happenned
-			ThrowIfError(theError, CAException(theError), "CAMutex::Try: call to pthread_mutex_trylock failed");
-		}
 	}
 	else
 	{
@@ -273,6 +427,7 @@ bool	CAMutex::Try(bool& outWasLocked)
 		{
 			//	this means we successfully locked the lock
 			mOwner = GetCurrentThreadId();
+			RecordAcquisition(false, 0);
 			theAnswer = true;
 			outWasLocked = true;
 	
@@ -316,7 +471,7 @@ bool	CAMutex::IsOwnedByCurrentThread() const
 {
 	bool theAnswer = true;
 	
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || CAMutex_Use_Futex
 	theAnswer = pthread_equal(pthread_self(), mOwner);
 #elif TARGET_OS_WIN32
 	theAnswer = (mOwner == GetCurrentThreadId());
@@ -325,6 +480,234 @@ bool	CAMutex::IsOwnedByCurrentThread() const
 	return theAnswer;
 }
 
+void	CAMutex::GetStatistics(Statistics& outStatistics) const
+{
+	outStatistics.mNumberAcquisitions = mNumberAcquisitions.load(std::memory_order_relaxed);
+	outStatistics.mNumberContendedAcquisitions = mNumberContendedAcquisitions.load(std::memory_order_relaxed);
+	outStatistics.mTotalWaitNanos = CAMutex_ConvertToNanos(mTotalWaitTime.load(std::memory_order_relaxed));
+	outStatistics.mMaximumHoldNanos = CAMutex_ConvertToNanos(mMaximumHoldTime.load(std::memory_order_relaxed));
+}
+
+bool	CAMutex::GetStatistics(const char* inName, Statistics& outStatistics)
+{
+	memset(&outStatistics, 0, sizeof(Statistics));
+	bool wasFound = false;
+	
+	CAMutexRegistry& theRegistry = CAMutexRegistry::Get();
+	pthread_mutex_lock(&theRegistry.mMutex);
+	for(CAMutex* theMutex = theRegistry.mFirstMutex; theMutex != NULL; theMutex = theMutex->mNextMutex)
+	{
+		if(CAMutexRegistry::IsSameName(theMutex->mName, inName))
+		{
+			Statistics theStatistics;
+			theMutex->GetStatistics(theStatistics);
+			CAMutexRegistry::Add(outStatistics, theStatistics);
+			wasFound = true;
+		}
+	}
+	for(CAMutexRegistry::RetiredMutexList::iterator theIterator = theRegistry.mRetiredMutexes.begin(); theIterator != theRegistry.mRetiredMutexes.end(); ++theIterator)
+	{
+		if(CAMutexRegistry::IsSameName(theIterator->mName, inName))
+		{
+			CAMutexRegistry::Add(outStatistics, theIterator->mStatistics);
+			wasFound = true;
+		}
+	}
+	pthread_mutex_unlock(&theRegistry.mMutex);
+	
+	return wasFound;
+}
+
+void	CAMutex::ResetStatistics()
+{
+	//	the counters may only be written with the lock held, so the ones of a busy mutex are left alone
+	CAMutexRegistry& theRegistry = CAMutexRegistry::Get();
+	pthread_mutex_lock(&theRegistry.mMutex);
+	for(CAMutex* theMutex = theRegistry.mFirstMutex; theMutex != NULL; theMutex = theMutex->mNextMutex)
+	{
+		if(theMutex->TryToAcquire())
+		{
+			theMutex->mNumberAcquisitions.store(0, std::memory_order_relaxed);
+			theMutex->mNumberContendedAcquisitions.store(0, std::memory_order_relaxed);
+			theMutex->mTotalWaitTime.store(0, std::memory_order_relaxed);
+			theMutex->mMaximumHoldTime.store(0, std::memory_order_relaxed);
+			theMutex->Release();
+		}
+	}
+	theRegistry.mRetiredMutexes.clear();
+	pthread_mutex_unlock(&theRegistry.mMutex);
+}
+
+void	CAMutex::DumpStatistics()
+{
+	CAMutexRegistry& theRegistry = CAMutexRegistry::Get();
+	std::vector<const char*> theNames;
+	pthread_mutex_lock(&theRegistry.mMutex);
+	for(CAMutex* theMutex = theRegistry.mFirstMutex; theMutex != NULL; theMutex = theMutex->mNextMutex)
+	{
+		theNames.push_back(theMutex->mName);
+	}
+	for(CAMutexRegistry::RetiredMutexList::iterator theIterator = theRegistry.mRetiredMutexes.begin(); theIterator != theRegistry.mRetiredMutexes.end(); ++theIterator)
+	{
+		theNames.push_back(theIterator->mName);
+	}
+	pthread_mutex_unlock(&theRegistry.mMutex);
+	
+	for(UInt32 theIndex = 0; theIndex < theNames.size(); ++theIndex)
+	{
+		bool isDuplicate = false;
+		for(UInt32 theOtherIndex = 0; !isDuplicate && (theOtherIndex < theIndex); ++theOtherIndex)
+		{
+			isDuplicate = CAMutexRegistry::IsSameName(theNames[theIndex], theNames[theOtherIndex]);
+		}
+		Statistics theStatistics;
+		if(!isDuplicate && GetStatistics(theNames[theIndex], theStatistics) && (theStatistics.mNumberAcquisitions > 0))
+		{
+			DebugMsg("CAMutex::DumpStatistics: %s acquisitions: %llu contended: %llu total wait: %llu ns maximum hold: %llu ns", theNames[theIndex] != NULL ? theNames[theIndex] : "",
+					 theStatistics.mNumberAcquisitions, theStatistics.mNumberContendedAcquisitions, theStatistics.mTotalWaitNanos, theStatistics.mMaximumHoldNanos);
+		}
+	}
+}
+
+//==================================================================================================
+//	Implementation
+//==================================================================================================
+
+#if CAMutex_Use_Futex
+
+static inline void	CAMutex_FutexWait(std::atomic<SInt32>& inState, SInt32 inValue)
+{
+	syscall(SYS_futex, reinterpret_cast<int*>(&inState), FUTEX_WAIT_PRIVATE, inValue, NULL, NULL, 0);
+}
+
+static inline void	CAMutex_FutexWake(std::atomic<SInt32>& inState)
+{
+	syscall(SYS_futex, reinterpret_cast<int*>(&inState), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+#endif
+
+bool	CAMutex::TryToAcquire()
+{
+	bool theAnswer = false;
+	
+#if TARGET_OS_MAC
+	int theError = pthread_mutex_trylock(&mMutex);
+	if(theError == 0)
+	{
+		theAnswer = true;
+	}
+	else if(theError != EBUSY)
+	{
+		//	any other return value means something really bad happenned
+		ThrowIfError(theError, CAException(theError), "CAMutex::TryToAcquire: call to pthread_mutex_trylock failed");
+	}
+#elif CAMutex_Use_Futex
+	SInt32 theState = 0;
+	theAnswer = mState.compare_exchange_strong(theState, 1, std::memory_order_acquire, std::memory_order_relaxed);
+#endif
+
+	return theAnswer;
+}
+
+void	CAMutex::Acquire()
+{
+	//	spin for about twice as long as it took the last few times, plus a little
+	SInt32 theSpinLimit = 0;
+	if(mMaximumSpinCount > 0)
+	{
+		theSpinLimit = 2 * mSpinCount.load(std::memory_order_relaxed) + 10;
+		theSpinLimit = theSpinLimit < static_cast<SInt32>(mMaximumSpinCount) ? theSpinLimit : static_cast<SInt32>(mMaximumSpinCount);
+	}
+	
+	bool wasAcquired = false;
+	SInt32 theSpin = 0;
+	while(!wasAcquired && (theSpin < theSpinLimit))
+	{
+		CAMutex_Pause();
+		++theSpin;
+#if CAMutex_Use_Futex
+		//	only try the atomic operation when the lock looks free, so spinning doesn't take the cache line away from the owner
+		wasAcquired = (mState.load(std::memory_order_relaxed) == 0) && TryToAcquire();
+#else
+		wasAcquired = TryToAcquire();
+#endif
+	}
+	if(theSpinLimit > 0)
+	{
+		//	we have the lock now or are about to, so the average is only updated by one thread at a time
+		SInt32 theSpinCount = mSpinCount.load(std::memory_order_relaxed);
+		theSpinCount += (theSpin - theSpinCount) / 8;
+		mSpinCount.store(theSpinCount, std::memory_order_relaxed);
+	}
+	if(wasAcquired)
+	{
+		return;
+	}
+	
+#if TARGET_OS_MAC
+	OSStatus theError = pthread_mutex_lock(&mMutex);
+	ThrowIf(theError != 0, CAException(theError), "CAMutex::Lock: Could not lock the mutex");
+#elif CAMutex_Use_Futex
+	//	mark the lock as having waiters and park until it is released
+	SInt32 theState = mState.exchange(2, std::memory_order_acquire);
+	while(theState != 0)
+	{
+		CAMutex_FutexWait(mState, 2);
+		theState = mState.exchange(2, std::memory_order_acquire);
+	}
+#endif
+}
+
+void	CAMutex::Release()
+{
+#if TARGET_OS_MAC
+	OSStatus theError = pthread_mutex_unlock(&mMutex);
+	ThrowIf(theError != 0, CAException(theError), "CAMutex::Unlock: Could not unlock the mutex");
+#elif CAMutex_Use_Futex
+	if(mState.exchange(0, std::memory_order_release) == 2)
+	{
+		CAMutex_FutexWake(mState);
+	}
+#endif
+}
+
+void	CAMutex::RecordAcquisition(bool inWasContended, UInt64 inWaitStartTime)
+{
+	//	called with the lock held, so nobody else writes the counters
+	mNumberAcquisitions.store(mNumberAcquisitions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	if(inWasContended)
+	{
+		mNumberContendedAcquisitions.store(mNumberContendedAcquisitions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	if(IsCollectingStatistics())
+	{
+		mAcquireTime = CAMutex_GetCurrentTime();
+		if(inWaitStartTime != 0)
+		{
+			mTotalWaitTime.store(mTotalWaitTime.load(std::memory_order_relaxed) + (mAcquireTime - inWaitStartTime), std::memory_order_relaxed);
+		}
+	}
+	else
+	{
+		mAcquireTime = 0;
+	}
+}
+
+void	CAMutex::RecordRelease()
+{
+	if((mAcquireTime != 0) && IsCollectingStatistics())
+	{
+		UInt64 theHoldTime = CAMutex_GetCurrentTime() - mAcquireTime;
+		if(theHoldTime > mMaximumHoldTime.load(std::memory_order_relaxed))
+		{
+			mMaximumHoldTime.store(theHoldTime, std::memory_order_relaxed);
+		}
+	}
+}
+
+//	off, so that an uncontended Lock and Unlock never read the clock
+std::atomic<bool>	CAMutex::sIsCollectingStatistics(false);
 
 CAMutex::Unlocker::Unlocker(CAMutex& inMutex)
 :	mMutex(inMutex),
@@ -62,19 +62,50 @@
 	#include <pthread.h>
 #elif TARGET_OS_WIN32
 	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#define	CAMutex_Use_Futex	1
 #else
 	#error	Unsupported operating system
 #endif
 
+#include <atomic>
+
 //==================================================================================================
 //	A recursive mutex.
+//
+//	A mutex constructed with a spin count tries to take the lock that many times before it parks
+//	the thread, which pays off when the lock is only ever held for a few instructions. The spin
+//	count adapts to how long it took to get the lock the last few times, up to the given maximum.
+//	On Linux the lock is a futex, elsewhere it is a pthread mutex either way, so CAGuard can wait
+//	on any CAMutex.
+//
+//	Every mutex counts its acquisitions, the ones that had to wait, the time spent waiting and the
+//	longest time the lock was held. The counters of all the mutexes with the same name are added
+//	up, including the ones that have been destroyed, so "Hub State" covers every device.
 //==================================================================================================
 
 class	CAMutex
 {
+//	Constants
+public:
+	enum
+	{
+					kDefaultSpinCount	= 100,
+					kMaximumSpinCount	= 1000
+	};
+
+	struct			Statistics
+	{
+		UInt64		mNumberAcquisitions;
+		UInt64		mNumberContendedAcquisitions;
+		UInt64		mTotalWaitNanos;
+		UInt64		mMaximumHoldNanos;
+	};
+
 //	Construction/Destruction
 public:
-					CAMutex(const char* inName);
+					CAMutex(const char* inName, UInt32 inMaximumSpinCount = 0);
 	virtual			~CAMutex();
 
 //	Actions
@@ -85,9 +116,30 @@ public:
 	
 	virtual bool	IsFree() const;
 	virtual bool	IsOwnedByCurrentThread() const;
+
+//	Statistics
+public:
+	const char*		GetName() const { return mName; }
+	UInt32			GetMaximumSpinCount() const { return mMaximumSpinCount; }
+	void			GetStatistics(Statistics& outStatistics) const;
+	
+	static bool		GetStatistics(const char* inName, Statistics& outStatistics);	// returns false if there never was a mutex with that name
+	static void		ResetStatistics();
+	static void		DumpStatistics();
+	
+	//	the wait and hold times need the clock on every Lock and Unlock, so they are only collected
+	//	while a test or tool turns this on. The acquisitions are always counted.
+	static bool		IsCollectingStatistics() { return sIsCollectingStatistics.load(std::memory_order_relaxed); }
+	static void		SetIsCollectingStatistics(bool inIsCollectingStatistics) { sIsCollectingStatistics.store(inIsCollectingStatistics, std::memory_order_relaxed); }
 		
 //	Implementation
 protected:
+	bool			TryToAcquire();
+	void			Acquire();
+	void			Release();
+	void			RecordAcquisition(bool inWasContended, UInt64 inWaitStartTime);
+	void			RecordRelease();
+	
 	const char*		mName;
 #if TARGET_OS_MAC
 	pthread_t		mOwner;
@@ -95,7 +147,38 @@ protected:
 #elif TARGET_OS_WIN32
 	UInt32			mOwner;
 	HANDLE			mMutex;
+#elif CAMutex_Use_Futex
+	//	a thread that doesn't hold the lock reads the owner to find out, relaxed is enough because a
+	//	thread only ever finds itself in there after it wrote itself there
+	class			Owner
+	{
+	public:
+					Owner(pthread_t inThread) : mThread(inThread) {}
+					operator pthread_t() const { return mThread.load(std::memory_order_relaxed); }
+		Owner&		operator=(pthread_t inThread) { mThread.store(inThread, std::memory_order_relaxed); return *this; }
+	private:
+		std::atomic<pthread_t>	mThread;
+	};
+	
+	Owner			mOwner;
+	std::atomic<SInt32>	mState;		//	0: free, 1: locked, 2: locked and somebody might be parked
 #endif
+	UInt32			mMaximumSpinCount;
+	std::atomic<SInt32>	mSpinCount;
+
+	//	only ever written by the thread holding the lock
+	std::atomic<UInt64>	mNumberAcquisitions;
+	std::atomic<UInt64>	mNumberContendedAcquisitions;
+	std::atomic<UInt64>	mTotalWaitTime;
+	std::atomic<UInt64>	mMaximumHoldTime;
+	UInt64			mAcquireTime;
+	
+	CAMutex*		mNextMutex;
+	CAMutex*		mPreviousMutex;
+	
+	static std::atomic<bool>	sIsCollectingStatistics;
+	
+	friend struct	CAMutexRegistry;
 
 //	Helper class to manage taking and releasing recursively
 public:
@@ -58,10 +58,17 @@
 //	System Includes
 #if	TARGET_OS_MAC
 	#include <mach/mach.h>
+#elif defined(__linux__)
+	#include "CAHostTimeBase.h"
+	#include <errno.h>
+	#include <sys/mman.h>
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
 #endif
 
 //	Standard Library Includes
 #include <stdio.h>
+#include <string.h>
 
 //==================================================================================================
 //	CAPThread
@@ -76,7 +83,7 @@
 
 CAPThread::CAPThread(ThreadRoutine inThreadRoutine, void* inParameter, UInt32 inPriority, bool inFixedPriority, bool inAutoDelete, const char* inThreadName)
 :
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
 	mPThread(0),
     mSpawningThreadPriority(getScheduledPriority(pthread_self(), CAPTHREAD_SET_PRIORITY)),
 #elif TARGET_OS_WIN32
@@ -92,11 +99,16 @@ CAPThread::CAPThread(ThreadRoutine inThreadRoutine, void* inParameter, UInt32 in
 	mIsPreemptible(true),
 	mTimeConstraintSet(false),
 	mFixedPriority(inFixedPriority),
-	mAutoDelete(inAutoDelete)
+	mAutoDelete(inAutoDelete),
+	mIsFallbackScheduling(false),
+	mCPUAffinity(0)
+#if defined(__linux__)
+	, mThreadID(0)
+#endif
 {
 	if(inThreadName != NULL)
 	{
-		strlcpy(mThreadName, inThreadName, kMaxThreadNameLength);
+		snprintf(mThreadName, kMaxThreadNameLength, "%s", inThreadName);
 	}
 	else
 	{
@@ -106,7 +118,7 @@ CAPThread::CAPThread(ThreadRoutine inThreadRoutine, void* inParameter, UInt32 in
 
 CAPThread::CAPThread(ThreadRoutine inThreadRoutine, void* inParameter, UInt32 inPeriod, UInt32 inComputation, UInt32 inConstraint, bool inIsPreemptible, bool inAutoDelete, const char* inThreadName)
 :
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
 	mPThread(0),
     mSpawningThreadPriority(getScheduledPriority(pthread_self(), CAPTHREAD_SET_PRIORITY)),
 #elif TARGET_OS_WIN32
@@ -122,11 +134,16 @@ CAPThread::CAPThread(ThreadRoutine inThreadRoutine, void* inParameter, UInt32 in
 	mIsPreemptible(inIsPreemptible),
 	mTimeConstraintSet(true),
 	mFixedPriority(false),
-	mAutoDelete(inAutoDelete)
+	mAutoDelete(inAutoDelete),
+	mIsFallbackScheduling(false),
+	mCPUAffinity(0)
+#if defined(__linux__)
+	, mThreadID(0)
+#endif
 {
 	if(inThreadName != NULL)
 	{
-		strlcpy(mThreadName, inThreadName, kMaxThreadNameLength);
+		snprintf(mThreadName, kMaxThreadNameLength, "%s", inThreadName);
 	}
 	else
 	{
@@ -140,7 +157,7 @@ CAPThread::~CAPThread()
 
 UInt32	CAPThread::GetScheduledPriority()
 {
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
     return CAPThread::getScheduledPriority( mPThread, CAPTHREAD_SCHEDULED_PRIORITY );
 #elif TARGET_OS_WIN32
 	UInt32 theAnswer = 0;
@@ -154,7 +171,7 @@ UInt32	CAPThread::GetScheduledPriority()
 
 UInt32	CAPThread::GetScheduledPriority(NativeThread thread)
 {
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
     return getScheduledPriority( thread, CAPTHREAD_SCHEDULED_PRIORITY );
 #elif TARGET_OS_WIN32
 	return 0;	// ???
@@ -176,6 +193,11 @@ void	CAPThread::SetPriority(UInt32 inPriority, bool inFixedPriority)
 	{
 		SetPriority(mThreadID, mPriority, mFixedPriority);
 	}
+#elif defined(__linux__)
+	if((mPThread != 0) && (mThreadID != 0))
+	{
+		mIsFallbackScheduling = !SetLinuxPriority(mPThread, mThreadID, mPriority, mFixedPriority);
+	}
 #endif
 }
 
@@ -213,6 +235,12 @@ void	CAPThread::SetPriority(NativeThread inThread, UInt32 inPriority, bool inFix
 			CloseHandle(hThread);
 		}
 	}
+#elif defined(__linux__)
+	if(inThread != 0)
+	{
+		//	only the calling thread's nice value can be reached from a pthread_t
+		SetLinuxPriority(inThread, pthread_equal(inThread, pthread_self()) ? static_cast<pid_t>(syscall(SYS_gettid)) : 0, inPriority, inFixedPriority);
+	}
 #endif
 }
 
@@ -238,12 +266,45 @@ void	CAPThread::SetTimeConstraints(UInt32 inPeriod, UInt32 inComputation, UInt32
 	{
 		SetThreadPriority(mThreadHandle, THREAD_PRIORITY_TIME_CRITICAL);
 	}
+#elif defined(__linux__)
+	if((mPThread != 0) && (mThreadID != 0))
+	{
+		mIsFallbackScheduling = !SetLinuxTimeConstraints(mPThread, mThreadID, mPeriod, mComputation, mConstraint, mIsPreemptible);
+	}
+#endif
+}
+
+bool	CAPThread::SetCPUAffinity(UInt64 inCPUMask)
+{
+	mCPUAffinity = inCPUMask;
+#if defined(__linux__)
+	return (mPThread == 0) || SetLinuxCPUAffinity(mPThread, mCPUAffinity);
+#else
+	//	thread affinity on the Mac only groups threads by tag, it can't pin them
+	return inCPUMask == 0;
+#endif
+}
+
+bool	CAPThread::LockMemory()
+{
+#if defined(__linux__)
+	//	under a finite RLIMIT_MEMLOCK, locking future pages would make later allocations fail once the
+	//	limit is reached, including the stacks of new threads, so only lock what is there
+	rlimit theLimit;
+	if((geteuid() == 0) || ((getrlimit(RLIMIT_MEMLOCK, &theLimit) == 0) && (theLimit.rlim_cur == RLIM_INFINITY)))
+	{
+		return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+	}
+	mlockall(MCL_CURRENT);
+	return false;
+#else
+	return false;
 #endif
 }
 
 void	CAPThread::Start()
 {
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
 	Assert(mPThread == 0, "CAPThread::Start: can't start because the thread is already running");
 	if(mPThread == 0)
 	{
@@ -256,8 +317,9 @@ void	CAPThread::Start()
 		theResult = pthread_attr_setdetachstate(&theThreadAttributes, PTHREAD_CREATE_DETACHED);
 		ThrowIf(theResult != 0, CAException(theResult), "CAPThread::Start: A thread could not be created in the detached state.");
 		
+		//	the thread may already be running, and an auto deleting one may already be gone, so only the result is checked
 		theResult = pthread_create(&mPThread, &theThreadAttributes, (ThreadRoutine)CAPThread::Entry, this);
-		ThrowIf(theResult != 0 || !mPThread, CAException(theResult), "CAPThread::Start: Could not create a thread.");
+		ThrowIf(theResult != 0, CAException(theResult), "CAPThread::Start: Could not create a thread.");
 		
 		pthread_attr_destroy(&theThreadAttributes);
 		
@@ -280,19 +342,25 @@ void	CAPThread::Start()
 #endif
 }
 
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
 
 void*	CAPThread::Entry(CAPThread* inCAPThread)
 {
 	void* theAnswer = NULL;
 
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
 	inCAPThread->mPThread = pthread_self();
 #elif TARGET_OS_WIN32
 	// do we need to do something here?
 #endif
 	
-#if	!TARGET_OS_IPHONE && (MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_X_VERSION_10_6)
+#if defined(__linux__)
+	inCAPThread->mThreadID = static_cast<pid_t>(syscall(SYS_gettid));
+	if(inCAPThread->mThreadName[0] != 0)
+	{
+		pthread_setname_np(pthread_self(), inCAPThread->mThreadName);
+	}
+#elif	!TARGET_OS_IPHONE && (MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_X_VERSION_10_6)
 	if(inCAPThread->mThreadName[0] != 0)
 	{
 		pthread_setname_np(inCAPThread->mThreadName);
@@ -301,6 +369,13 @@ void*	CAPThread::Entry(CAPThread* inCAPThread)
 
 	try 
 	{
+#if defined(__linux__)
+		//	before the scheduling, the kernel turns SCHED_DEADLINE down for pinned threads
+		if((inCAPThread->mCPUAffinity != 0) && !SetLinuxCPUAffinity(inCAPThread->mPThread, inCAPThread->mCPUAffinity))
+		{
+			DebugMessage("CAPThread::Entry: the thread could not be pinned");
+		}
+#endif
 		if(inCAPThread->mTimeConstraintSet)
 		{
 			inCAPThread->SetTimeConstraints(inCAPThread->mPeriod, inCAPThread->mComputation, inCAPThread->mConstraint, inCAPThread->mIsPreemptible);
@@ -320,11 +395,18 @@ void*	CAPThread::Entry(CAPThread* inCAPThread)
 		// what should be done here?
 	}
 	inCAPThread->mPThread = 0;
+#if defined(__linux__)
+	inCAPThread->mThreadID = 0;
+#endif
 	if (inCAPThread->mAutoDelete)
 		delete inCAPThread;
 	return theAnswer;
 }
 
+#endif
+
+#if TARGET_OS_MAC
+
 UInt32 CAPThread::getScheduledPriority(pthread_t inThread, int inPriorityKind)
 {
     thread_basic_info_data_t			threadInfo;
@@ -370,6 +452,176 @@ UInt32 CAPThread::getScheduledPriority(pthread_t inThread, int inPriorityKind)
     return 0;
 }
 
+#elif defined(__linux__)
+
+#if !defined(SCHED_DEADLINE)
+	#define	SCHED_DEADLINE				6
+#endif
+#if !defined(SCHED_FLAG_RESET_ON_FORK)
+	#define	SCHED_FLAG_RESET_ON_FORK	0x01
+#endif
+#if !defined(SCHED_RESET_ON_FORK)
+	#define	SCHED_RESET_ON_FORK			0x40000000
+#endif
+
+//	the real time priorities at the top belong to the kernel's own threads
+static const int kLinuxRealTimePriorityHeadroom = 10;
+
+//	spreads the Mach priorities above the default over the real time priorities below the headroom
+static int	LinuxRealTimePriority(int inPolicy, UInt32 inPriority)
+{
+	int theMinimum = sched_get_priority_min(inPolicy);
+	int theMaximum = sched_get_priority_max(inPolicy) - kLinuxRealTimePriorityHeadroom;
+	if(inPriority <= CAPThread::kDefaultThreadPriority)
+	{
+		return theMinimum;
+	}
+	if(inPriority > CAPThread::kMaxThreadPriority)
+	{
+		inPriority = CAPThread::kMaxThreadPriority;
+	}
+	return theMinimum + static_cast<int>(inPriority - CAPThread::kDefaultThreadPriority - 1) * (theMaximum - theMinimum) / (CAPThread::kMaxThreadPriority - CAPThread::kDefaultThreadPriority - 1);
+}
+
+UInt32 CAPThread::getScheduledPriority(pthread_t inThread, int /*inPriorityKind*/)
+{
+	int thePolicy = SCHED_OTHER;
+	sched_param theParameters;
+	if(inThread == 0)
+	{
+		return 0;
+	}
+	if(pthread_equal(inThread, pthread_self()))
+	{
+		//	ask the kernel, pthreads only knows the policies that were set through it
+		thePolicy = sched_getscheduler(0);
+		if((thePolicy < 0) || (sched_getparam(0, &theParameters) != 0))
+		{
+			return 0;
+		}
+		thePolicy &= ~SCHED_RESET_ON_FORK;
+	}
+	else if(pthread_getschedparam(inThread, &thePolicy, &theParameters) != 0)
+	{
+		return 0;
+	}
+	switch(thePolicy)
+	{
+		case SCHED_FIFO:
+		case SCHED_RR:
+			{
+				int theMinimum = sched_get_priority_min(thePolicy);
+				int theMaximum = sched_get_priority_max(thePolicy) - kLinuxRealTimePriorityHeadroom;
+				int thePriority = theParameters.sched_priority < theMaximum ? theParameters.sched_priority : theMaximum;
+				int theRange = theMaximum - theMinimum;
+				//	rounded up, the inverse of LinuxRealTimePriority, so that a priority reads back as it was set
+				return kDefaultThreadPriority + 1 + static_cast<UInt32>(((thePriority - theMinimum) * static_cast<int>(kMaxThreadPriority - kDefaultThreadPriority - 1) + theRange - 1) / theRange);
+			}
+		
+		case SCHED_DEADLINE:
+			return kMaxThreadPriority;
+	}
+	return kDefaultThreadPriority;
+}
+
+bool	CAPThread::SetLinuxPriority(pthread_t inThread, pid_t inThreadID, UInt32 inPriority, bool inFixedPriority)
+{
+	sched_param theParameters;
+	if(!inFixedPriority && (inPriority <= kDefaultThreadPriority))
+	{
+		//	lower priorities only raise the nice value, which needs no privileges
+		theParameters.sched_priority = 0;
+		bool theAnswer = pthread_setschedparam(inThread, SCHED_OTHER, &theParameters) == 0;
+		if(inThreadID != 0)
+		{
+			int theNice = static_cast<int>(kDefaultThreadPriority - (inPriority < kMinThreadPriority ? kMinThreadPriority : inPriority)) * 19 / (kDefaultThreadPriority - kMinThreadPriority);
+			theAnswer = (setpriority(PRIO_PROCESS, static_cast<id_t>(inThreadID), theNice) == 0) && theAnswer;
+		}
+		return theAnswer;
+	}
+	
+	int thePolicy = inFixedPriority ? SCHED_FIFO : SCHED_RR;
+	theParameters.sched_priority = LinuxRealTimePriority(thePolicy, inPriority);
+	int theError = pthread_setschedparam(inThread, thePolicy, &theParameters);
+	if(theError == 0)
+	{
+		return true;
+	}
+	
+	//	without CAP_SYS_NICE or an RLIMIT_RTPRIO that allows it, take the lowest nice value RLIMIT_NICE allows
+	DebugMessageN1("CAPThread::SetLinuxPriority: no real time scheduling, error %d, falling back to SCHED_OTHER", theError);
+	theParameters.sched_priority = 0;
+	pthread_setschedparam(inThread, SCHED_OTHER, &theParameters);
+	rlimit theLimit;
+	if((inThreadID != 0) && (getrlimit(RLIMIT_NICE, &theLimit) == 0))
+	{
+		int theNice = (theLimit.rlim_cur == RLIM_INFINITY) ? -20 : 20 - static_cast<int>(theLimit.rlim_cur < 40 ? theLimit.rlim_cur : 40);
+		if(theNice < 0)
+		{
+			setpriority(PRIO_PROCESS, static_cast<id_t>(inThreadID), theNice);
+		}
+	}
+	return false;
+}
+
+bool	CAPThread::SetLinuxTimeConstraints(pthread_t inThread, pid_t inThreadID, UInt32 inPeriod, UInt32 inComputation, UInt32 inConstraint, bool inIsPreemptible)
+{
+#if defined(SYS_sched_setattr)
+	//	the layout of the kernel's struct sched_attr, which glibc doesn't declare
+	struct
+	{
+		UInt32	mSize;
+		UInt32	mPolicy;
+		UInt64	mFlags;
+		SInt32	mNice;
+		UInt32	mPriority;
+		UInt64	mRuntime;
+		UInt64	mDeadline;
+		UInt64	mPeriod;
+	} theAttributes;
+	
+	//	the kernel wants runtime <= deadline <= period and at least a microsecond of runtime, and a
+	//	period of 0 means the period is the deadline like it does for Mach
+	UInt64 theRuntime = CAHostTimeBase::ConvertToNanos(inComputation);
+	UInt64 theDeadline = CAHostTimeBase::ConvertToNanos(inConstraint);
+	UInt64 thePeriod = CAHostTimeBase::ConvertToNanos(inPeriod);
+	theRuntime = theRuntime < 1024 ? 1024 : theRuntime;
+	theDeadline = theDeadline < theRuntime ? theRuntime : theDeadline;
+	thePeriod = thePeriod < theDeadline ? theDeadline : thePeriod;
+	
+	memset(&theAttributes, 0, sizeof(theAttributes));
+	theAttributes.mSize = sizeof(theAttributes);
+	theAttributes.mPolicy = SCHED_DEADLINE;
+	theAttributes.mFlags = SCHED_FLAG_RESET_ON_FORK;	// or the thread couldn't start threads of its own
+	theAttributes.mRuntime = theRuntime;
+	theAttributes.mDeadline = theDeadline;
+	theAttributes.mPeriod = thePeriod;
+	if(syscall(SYS_sched_setattr, inThreadID, &theAttributes, 0) == 0)
+	{
+		return true;
+	}
+	
+	//	EPERM without CAP_SYS_NICE or for a pinned thread, EBUSY when admission control is out of bandwidth
+	DebugMessageN1("CAPThread::SetLinuxTimeConstraints: no SCHED_DEADLINE, error %d, falling back to a fixed priority", errno);
+#endif
+	SetLinuxPriority(inThread, inThreadID, kMaxThreadPriority, !inIsPreemptible);
+	return false;
+}
+
+bool	CAPThread::SetLinuxCPUAffinity(pthread_t inThread, UInt64 inCPUMask)
+{
+	cpu_set_t theCPUs;
+	CPU_ZERO(&theCPUs);
+	for(UInt32 theCPU = 0; theCPU < 64; ++theCPU)
+	{
+		if((inCPUMask == 0) || ((inCPUMask & (1ULL << theCPU)) != 0))
+		{
+			CPU_SET(theCPU, &theCPUs);
+		}
+	}
+	return pthread_setaffinity_np(inThread, sizeof(theCPUs), &theCPUs) == 0;
+}
+
 #elif TARGET_OS_WIN32
 
 UInt32 WINAPI	CAPThread::Entry(CAPThread* inCAPThread)
@@ -416,7 +668,7 @@ void	CAPThread::SetName(const char* inThreadName)
 {
 	if(inThreadName != NULL)
 	{
-		strlcpy(mThreadName, inThreadName, kMaxThreadNameLength);
+		snprintf(mThreadName, kMaxThreadNameLength, "%s", inThreadName);
 	}
 	else
 	{
@@ -63,6 +63,11 @@
 	#include <unistd.h>
 #elif TARGET_OS_WIN32
 	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+	#include <sys/types.h>
+	#include <unistd.h>
 #else
 	#error	Unsupported operating system
 #endif
@@ -72,6 +77,16 @@
 //
 //	This class wraps a pthread and a Win32 thread.
 //	caution: long-running fixed priority threads can make the system unresponsive
+//
+//	On Linux the priorities keep the Mach scale. Priorities up to kDefaultThreadPriority that are
+//	not fixed stay in SCHED_OTHER and only ever raise the nice value, fixed priorities run
+//	SCHED_FIFO and higher ones SCHED_RR. Time constraints, which are in host time like on the Mac,
+//	become SCHED_DEADLINE with the computation as the runtime, the constraint as the deadline and
+//	the period as the period. Without the privileges for that a thread falls back to SCHED_FIFO or
+//	SCHED_RR and then to SCHED_OTHER, and IsFallbackScheduling() says so. GetScheduledPriority()
+//	reads a real time priority back as it was set, SCHED_OTHER as kDefaultThreadPriority whatever the
+//	nice value and SCHED_DEADLINE as kMaxThreadPriority. Threads can be pinned to a set of CPUs, and
+//	LockMemory() keeps the process from paging.
 //==================================================================================================
 
 class	CAPThread
@@ -95,6 +110,11 @@ public:
 							kMaxThreadPriority = 31,
 							kDefaultThreadPriority = THREAD_PRIORITY_NORMAL,
 							kMaxThreadNameLength = 256
+#elif defined(__linux__)
+							kMinThreadPriority = 1,
+							kMaxThreadPriority = 63,
+							kDefaultThreadPriority = 31,
+							kMaxThreadNameLength = 16
 #endif
 	};
 
@@ -119,6 +139,19 @@ public:
 	bool					IsCurrentThread() const { return (0 != mPThread) && (pthread_self() == mPThread); }
 	bool					IsRunning() const { return 0 != mPThread; }
     static UInt32			getScheduledPriority(pthread_t inThread, int inPriorityKind);
+#elif defined(__linux__)
+	typedef pthread_t		NativeThread;
+
+	NativeThread			GetNativeThread() { return mPThread; }
+	static NativeThread		GetCurrentThread() { return pthread_self(); }
+	static bool				IsNativeThreadsEqual(NativeThread a, NativeThread b) { return pthread_equal(a, b); }
+
+	bool					operator==(NativeThread b) { return pthread_equal(mPThread,b); }
+
+	pthread_t				GetPThread() const { return mPThread; }
+	bool					IsCurrentThread() const { return (0 != mPThread) && pthread_equal(pthread_self(), mPThread); }
+	bool					IsRunning() const { return 0 != mPThread; }
+    static UInt32			getScheduledPriority(pthread_t inThread, int inPriorityKind);
 #elif TARGET_OS_WIN32
 	typedef unsigned long	NativeThread;
 	
@@ -147,6 +180,19 @@ public:
 	void					SetTimeConstraints(UInt32 inPeriod, UInt32 inComputation, UInt32 inConstraint, bool inIsPreemptible);
 	void					ClearTimeConstraints() { SetPriority(mPriority); }
 	
+	//	whether the thread had to settle for less than the scheduling it asked for, only on Linux
+	bool					IsFallbackScheduling() const { return mIsFallbackScheduling; }
+	
+	//	bit n of the mask is CPU n, 0 lets the thread run anywhere. Only Linux pins threads, the
+	//	call returns false where the thread could not be pinned.
+	UInt64					GetCPUAffinity() const { return mCPUAffinity; }
+	bool					SetCPUAffinity(UInt64 inCPUMask);
+	
+	//	locks the process' current and future pages into memory so the real time threads never
+	//	fault. Returns false where that is not possible. Without the privilege on Linux only the
+	//	current pages that fit RLIMIT_MEMLOCK are locked.
+	static bool				LockMemory();
+	
 	bool					WillAutoDelete() const { return mAutoDelete; }
 	void					SetAutoDelete(bool b) { mAutoDelete = b; }
 	
@@ -162,13 +208,20 @@ public:
 
 //	Implementation
 protected:
-#if TARGET_OS_MAC
+#if TARGET_OS_MAC || defined(__linux__)
 	static void*			Entry(CAPThread* inCAPThread);
 #elif TARGET_OS_WIN32
 	static UInt32 WINAPI	Entry(CAPThread* inCAPThread);
 #endif
 
-#if	TARGET_OS_MAC
+#if defined(__linux__)
+	//	each returns whether the thread got what was asked for, a thread ID of 0 means unknown
+	static bool				SetLinuxPriority(pthread_t inThread, pid_t inThreadID, UInt32 inPriority, bool inFixedPriority);
+	static bool				SetLinuxTimeConstraints(pthread_t inThread, pid_t inThreadID, UInt32 inPeriod, UInt32 inComputation, UInt32 inConstraint, bool inIsPreemptible);
+	static bool				SetLinuxCPUAffinity(pthread_t inThread, UInt64 inCPUMask);
+#endif
+
+#if	TARGET_OS_MAC || defined(__linux__)
 	pthread_t				mPThread;
     UInt32					mSpawningThreadPriority;
 #elif TARGET_OS_WIN32
@@ -186,6 +239,11 @@ protected:
 	bool					mTimeConstraintSet;
     bool					mFixedPriority;
 	bool					mAutoDelete;		// delete self when thread terminates
+	bool					mIsFallbackScheduling;
+	UInt64					mCPUAffinity;
+#if defined(__linux__)
+	pid_t					mThreadID;			// the kernel's id for the thread, the scheduler calls take it
+#endif
 };
 
 #endif
@@ -0,0 +1,450 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CARealTimeChecker.h"
+
+#if CARealTimeChecker_Enabled
+
+//	System Includes
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__linux__)
+	#include <dlfcn.h>
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <sched.h>
+	#include <sys/mman.h>
+	#include <sys/select.h>
+	#include <time.h>
+#endif
+
+//	Standard Library Includes
+#include <atomic>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//==================================================================================================
+//	Implementation
+//
+//	A thread's state is its scope depth times two, with the low bit set while the checker itself is
+//	at work, so that what the checker calls isn't reported again. The state has to be readable from
+//	inside malloc. On macOS it lives in a pthread key, since the first access to a thread_local on a
+//	thread allocates it. On Linux it is a thread_local in the initial exec model, which never does.
+//
+//	The first kMaximumNumberViolations reports each claim a slot of the log and mark it complete
+//	once the backtrace is in.
+//==================================================================================================
+
+#if TARGET_OS_MAC
+typedef void	(MallocLogger)(uint32_t inType, uintptr_t inArgument1, uintptr_t inArgument2, uintptr_t inArgument3, uintptr_t inResult, uint32_t inNumberFramesToSkip);
+
+//	the hook malloc calls for every allocation, the same one MallocStackLogging uses
+extern "C" MallocLogger*	malloc_logger;
+#endif
+
+namespace
+{
+	enum
+	{
+		kIsReporting		= 1,
+		kScopeDepthUnit		= 2
+	};
+
+#if TARGET_OS_MAC
+	pthread_key_t	CreateThreadStateKey()
+	{
+		pthread_key_t theKey;
+		pthread_key_create(&theKey, NULL);
+		return theKey;
+	}
+	
+	const pthread_key_t	sThreadStateKey = CreateThreadStateKey();
+	
+	inline UInt32	GetThreadState()
+	{
+		return static_cast<UInt32>(reinterpret_cast<uintptr_t>(pthread_getspecific(sThreadStateKey)));
+	}
+	
+	inline void		SetThreadState(UInt32 inState)
+	{
+		pthread_setspecific(sThreadStateKey, reinterpret_cast<void*>(static_cast<uintptr_t>(inState)));
+	}
+#else
+	thread_local UInt32	tThreadState __attribute__((tls_model("initial-exec"))) = 0;
+	
+	inline UInt32	GetThreadState()
+	{
+		return tThreadState;
+	}
+	
+	inline void		SetThreadState(UInt32 inState)
+	{
+		tThreadState = inState;
+	}
+#endif
+
+	//	keeps what the checker does itself from being reported
+	class Exemption
+	{
+	public:
+						Exemption() : mState(GetThreadState()) { SetThreadState(mState | kIsReporting); }
+						~Exemption() { SetThreadState(mState); }
+		
+	private:
+						Exemption(const Exemption&);
+		Exemption&		operator=(const Exemption&);
+		
+		UInt32			mState;
+	};
+
+	struct ViolationSlot
+	{
+		std::atomic<bool>				mIsComplete;
+		CARealTimeChecker::Violation	mViolation;
+	};
+	
+	//	zero initialized before any code runs, so malloc can report into it at any time
+	std::atomic<UInt32>	sNumberViolations;
+	ViolationSlot		sViolationSlots[CARealTimeChecker::kMaximumNumberViolations];
+
+#if TARGET_OS_MAC
+	enum
+	{
+		kMallocLogType_Allocate		= 2,
+		kMallocLogType_Deallocate	= 4
+	};
+	
+	MallocLogger*	sNextMallocLogger = NULL;
+	
+	void	LogMalloc(uint32_t inType, uintptr_t inArgument1, uintptr_t inArgument2, uintptr_t inArgument3, uintptr_t inResult, uint32_t inNumberFramesToSkip)
+	{
+		//	realloc logs both, it counts as an allocation
+		if((inType & kMallocLogType_Allocate) != 0)
+		{
+			CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Allocation, "malloc");
+		}
+		else if((inType & kMallocLogType_Deallocate) != 0)
+		{
+			CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Deallocation, "free");
+		}
+		
+		if(sNextMallocLogger != NULL)
+		{
+			sNextMallocLogger(inType, inArgument1, inArgument2, inArgument3, inResult, inNumberFramesToSkip);
+		}
+	}
+#endif
+
+	bool	Install()
+	{
+		//	the first backtrace() loads the unwinder, which allocates
+		void* theFrame;
+		backtrace(&theFrame, 1);
+		
+#if TARGET_OS_MAC
+		sNextMallocLogger = malloc_logger;
+		malloc_logger = LogMalloc;
+#endif
+		return true;
+	}
+}
+
+#pragma mark Scope
+
+void	CARealTimeChecker::BeginScope()
+{
+	static bool sIsInstalled = Install();
+	(void)sIsInstalled;
+	
+	SetThreadState(GetThreadState() + kScopeDepthUnit);
+}
+
+void	CARealTimeChecker::EndScope()
+{
+	UInt32 theState = GetThreadState();
+	if(theState >= kScopeDepthUnit)
+	{
+		SetThreadState(theState - kScopeDepthUnit);
+	}
+}
+
+bool	CARealTimeChecker::IsInScope()
+{
+	return GetThreadState() >= kScopeDepthUnit;
+}
+
+#pragma mark Violations
+
+void	CARealTimeChecker::ReportViolation(ViolationKind inKind, const char* inWhat)
+{
+	UInt32 theState = GetThreadState();
+	if((theState < kScopeDepthUnit) || ((theState & kIsReporting) != 0))
+	{
+		return;
+	}
+	
+	Exemption theExemption;
+	UInt32 theIndex = sNumberViolations.fetch_add(1, std::memory_order_relaxed);
+	if(theIndex < kMaximumNumberViolations)
+	{
+		ViolationSlot& theSlot = sViolationSlots[theIndex];
+		theSlot.mViolation.mKind = inKind;
+		theSlot.mViolation.mWhat = inWhat;
+		int theNumberFrames = backtrace(theSlot.mViolation.mFrames, kMaximumNumberFrames);
+		theSlot.mViolation.mNumberFrames = (theNumberFrames > 0) ? static_cast<UInt32>(theNumberFrames) : 0;
+		theSlot.mIsComplete.store(true, std::memory_order_release);
+	}
+}
+
+UInt32	CARealTimeChecker::GetNumberViolations()
+{
+	return sNumberViolations.load(std::memory_order_relaxed);
+}
+
+bool	CARealTimeChecker::GetViolation(UInt32 inIndex, Violation& outViolation)
+{
+	bool theAnswer = (inIndex < kMaximumNumberViolations) && sViolationSlots[inIndex].mIsComplete.load(std::memory_order_acquire);
+	if(theAnswer)
+	{
+		outViolation = sViolationSlots[inIndex].mViolation;
+	}
+	return theAnswer;
+}
+
+void	CARealTimeChecker::ResetViolations()
+{
+	//	only call this while no thread is in a scope
+	for(UInt32 theIndex = 0; theIndex < kMaximumNumberViolations; ++theIndex)
+	{
+		sViolationSlots[theIndex].mIsComplete.store(false, std::memory_order_relaxed);
+	}
+	sNumberViolations.store(0, std::memory_order_relaxed);
+}
+
+void	CARealTimeChecker::DumpViolations()
+{
+	//	straight to stderr, so the report shows up in every build configuration
+	Exemption theExemption;
+	UInt32 theNumberViolations = GetNumberViolations();
+	for(UInt32 theIndex = 0; theIndex < theNumberViolations; ++theIndex)
+	{
+		Violation theViolation;
+		if(GetViolation(theIndex, theViolation))
+		{
+			fprintf(stderr, "CARealTimeChecker: %s in a real time scope: %s\n", GetKindName(theViolation.mKind), theViolation.mWhat);
+			fflush(stderr);
+			backtrace_symbols_fd(theViolation.mFrames, static_cast<int>(theViolation.mNumberFrames), STDERR_FILENO);
+		}
+	}
+	if(theNumberViolations > kMaximumNumberViolations)
+	{
+		fprintf(stderr, "CARealTimeChecker: %u more violations\n", theNumberViolations - kMaximumNumberViolations);
+	}
+}
+
+const char*	CARealTimeChecker::GetKindName(ViolationKind inKind)
+{
+	static const char* const sKindNames[] = { "allocation", "deallocation", "lock", "system call", "throw" };
+	return (static_cast<UInt32>(inKind) < sizeof(sKindNames) / sizeof(sKindNames[0])) ? sKindNames[inKind] : "unknown";
+}
+
+#if defined(__linux__)
+
+//==================================================================================================
+//	Interposed Functions
+//
+//	The malloc family goes straight to glibc's own entry points, since looking up the next
+//	definition would allocate. Everything else finds the next definition the first time it is
+//	called. All of them report before they do anything else.
+//==================================================================================================
+
+extern "C"
+{
+	void*	__libc_malloc(size_t inSize);
+	void*	__libc_calloc(size_t inNumberElements, size_t inElementSize);
+	void*	__libc_realloc(void* inBlock, size_t inSize);
+	void*	__libc_memalign(size_t inAlignment, size_t inSize);
+	void	__libc_free(void* inBlock);
+}
+
+namespace
+{
+	void*	FindNextFunction(const char* inName)
+	{
+		//	dlsym() may allocate, which isn't the caller's doing
+		Exemption theExemption;
+		return dlsym(RTLD_NEXT, inName);
+	}
+}
+
+#define	CARealTimeChecker_Interpose(inKind, inReturnType, inName, inParameters, inArguments, inExceptionSpecification)								\
+	extern "C" inReturnType	inName inParameters inExceptionSpecification																	\
+	{																																		\
+		CARealTimeChecker::ReportViolation(CARealTimeChecker::inKind, #inName);																\
+		static inReturnType (*sNext) inParameters = reinterpret_cast<inReturnType (*) inParameters>(FindNextFunction(#inName));				\
+		return sNext inArguments;																											\
+	}
+
+extern "C" void*	malloc(size_t inSize) noexcept
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Allocation, "malloc");
+	return __libc_malloc(inSize);
+}
+
+extern "C" void*	calloc(size_t inNumberElements, size_t inElementSize) noexcept
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Allocation, "calloc");
+	return __libc_calloc(inNumberElements, inElementSize);
+}
+
+extern "C" void*	realloc(void* inBlock, size_t inSize) noexcept
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Allocation, "realloc");
+	return __libc_realloc(inBlock, inSize);
+}
+
+extern "C" void*	memalign(size_t inAlignment, size_t inSize) noexcept
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Allocation, "memalign");
+	return __libc_memalign(inAlignment, inSize);
+}
+
+extern "C" void*	aligned_alloc(size_t inAlignment, size_t inSize) noexcept
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Allocation, "aligned_alloc");
+	return __libc_memalign(inAlignment, inSize);
+}
+
+extern "C" int	posix_memalign(void** outBlock, size_t inAlignment, size_t inSize) noexcept
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Allocation, "posix_memalign");
+	if((inAlignment < sizeof(void*)) || ((inAlignment & (inAlignment - 1)) != 0))
+	{
+		return EINVAL;
+	}
+	void* theBlock = __libc_memalign(inAlignment, inSize);
+	if(theBlock == NULL)
+	{
+		return ENOMEM;
+	}
+	*outBlock = theBlock;
+	return 0;
+}
+
+extern "C" void	free(void* inBlock) noexcept
+{
+	if(inBlock != NULL)
+	{
+		CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Deallocation, "free");
+	}
+	__libc_free(inBlock);
+}
+
+CARealTimeChecker_Interpose(kViolation_SystemCall, ssize_t, read, (int inFile, void* outData, size_t inSize), (inFile, outData, inSize), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, ssize_t, write, (int inFile, const void* inData, size_t inSize), (inFile, inData, inSize), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, ssize_t, pread, (int inFile, void* outData, size_t inSize, off_t inOffset), (inFile, outData, inSize, inOffset), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, ssize_t, pwrite, (int inFile, const void* inData, size_t inSize, off_t inOffset), (inFile, inData, inSize, inOffset), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, close, (int inFile), (inFile), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, nanosleep, (const struct timespec* inDuration, struct timespec* outRemaining), (inDuration, outRemaining), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, clock_nanosleep, (clockid_t inClock, int inFlags, const struct timespec* inTime, struct timespec* outRemaining), (inClock, inFlags, inTime, outRemaining), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, usleep, (useconds_t inMicroseconds), (inMicroseconds), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, unsigned int, sleep, (unsigned int inSeconds), (inSeconds), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, sched_yield, (void), (), noexcept)
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, poll, (struct pollfd* ioFiles, nfds_t inNumberFiles, int inTimeout), (ioFiles, inNumberFiles, inTimeout), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, select, (int inNumberFiles, fd_set* ioRead, fd_set* ioWrite, fd_set* ioExcept, struct timeval* inTimeout), (inNumberFiles, ioRead, ioWrite, ioExcept, inTimeout), )
+CARealTimeChecker_Interpose(kViolation_SystemCall, void*, mmap, (void* inAddress, size_t inSize, int inProtection, int inFlags, int inFile, off_t inOffset), (inAddress, inSize, inProtection, inFlags, inFile, inOffset), noexcept)
+CARealTimeChecker_Interpose(kViolation_SystemCall, int, munmap, (void* inAddress, size_t inSize), (inAddress, inSize), noexcept)
+CARealTimeChecker_Interpose(kViolation_Lock, int, pthread_mutex_lock, (pthread_mutex_t* inMutex), (inMutex), noexcept)
+
+extern "C" int	open(const char* inPath, int inFlags, ...)
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_SystemCall, "open");
+	mode_t theMode = 0;
+	if((inFlags & (O_CREAT | O_TMPFILE)) != 0)
+	{
+		va_list theArguments;
+		va_start(theArguments, inFlags);
+		theMode = static_cast<mode_t>(va_arg(theArguments, int));
+		va_end(theArguments);
+	}
+	static int (*sNext)(const char*, int, ...) = reinterpret_cast<int (*)(const char*, int, ...)>(FindNextFunction("open"));
+	return sNext(inPath, inFlags, theMode);
+}
+
+extern "C" int	openat(int inDirectory, const char* inPath, int inFlags, ...)
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_SystemCall, "openat");
+	mode_t theMode = 0;
+	if((inFlags & (O_CREAT | O_TMPFILE)) != 0)
+	{
+		va_list theArguments;
+		va_start(theArguments, inFlags);
+		theMode = static_cast<mode_t>(va_arg(theArguments, int));
+		va_end(theArguments);
+	}
+	static int (*sNext)(int, const char*, int, ...) = reinterpret_cast<int (*)(int, const char*, int, ...)>(FindNextFunction("openat"));
+	return sNext(inDirectory, inPath, inFlags, theMode);
+}
+
+//	covers the futex calls of CAMutex and CAGuard as well
+extern "C" long	syscall(long inNumber, ...) noexcept
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_SystemCall, "syscall");
+	va_list theArguments;
+	va_start(theArguments, inNumber);
+	long theArgument1 = va_arg(theArguments, long);
+	long theArgument2 = va_arg(theArguments, long);
+	long theArgument3 = va_arg(theArguments, long);
+	long theArgument4 = va_arg(theArguments, long);
+	long theArgument5 = va_arg(theArguments, long);
+	long theArgument6 = va_arg(theArguments, long);
+	va_end(theArguments);
+	static long (*sNext)(long, ...) = reinterpret_cast<long (*)(long, ...)>(FindNextFunction("syscall"));
+	return sNext(inNumber, theArgument1, theArgument2, theArgument3, theArgument4, theArgument5, theArgument6);
+}
+
+namespace std { class type_info; }
+
+extern "C" void	__cxa_throw(void* inException, std::type_info* inType, void (*inDestructor)(void*))
+{
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Throw, "__cxa_throw");
+	typedef void (*Throw)(void*, std::type_info*, void (*)(void*));
+	static Throw sNext = reinterpret_cast<Throw>(FindNextFunction("__cxa_throw"));
+	sNext(inException, inType, inDestructor);
+	__builtin_unreachable();
+}
+
+#endif
+
+#endif
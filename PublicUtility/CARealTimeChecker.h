@@ -0,0 +1,140 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#if !defined(__CARealTimeChecker_h__)
+#define __CARealTimeChecker_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+//	The checker is compiled into the test builds only, everywhere else its calls are empty inline
+//	functions.
+#if !defined(CARealTimeChecker_Enabled)
+	#if defined(TEST) && TEST
+		#define CARealTimeChecker_Enabled	1
+	#else
+		#define CARealTimeChecker_Enabled	0
+	#endif
+#endif
+
+/*==================================================================================================
+	CARealTimeChecker
+
+	Catches work on a real time thread that can block it. A thread is in a real time scope from
+	BeginScope() to the matching EndScope(), the device puts its IO thread in one from
+	BeginIOOperation to EndIOOperation. Everything the thread does in the scope that may take a
+	lock, wait for the kernel or touch the heap is recorded as a violation along with the
+	backtrace of the call:
+
+	-	heap allocations and deallocations, through malloc_logger on macOS and by interposing the
+		malloc family on Linux, which also covers operator new and the exceptions ThrowIf creates
+	-	CAMutex::Lock() and CASharedMutex::LockShared(), CAMutex::Try() is fine since it never waits
+	-	on Linux, the libc calls that enter the kernel or block: file IO, sleeping, yielding,
+		pthread_mutex_lock(), which std::mutex goes through as well, mapping memory, syscall() and
+		throwing. Waiting on a condition variable is not caught, glibc versions those symbols.
+
+	The interposed Linux functions only take effect when the checker is linked into the executable
+	or into a library that is loaded with it, not into one that is opened later.
+
+	Reporting never allocates. The first kMaximumNumberViolations violations are kept with their
+	backtraces, later ones are only counted. Tests reset the record, run the IO path and fail if
+	GetNumberViolations() isn't 0, DumpViolations() logs what went wrong.
+==================================================================================================*/
+
+class CARealTimeChecker
+{
+
+#pragma mark Constants
+public:
+	enum
+	{
+		kMaximumNumberViolations	= 64,
+		kMaximumNumberFrames		= 32
+	};
+
+	enum ViolationKind
+	{
+		kViolation_Allocation,
+		kViolation_Deallocation,
+		kViolation_Lock,
+		kViolation_SystemCall,
+		kViolation_Throw
+	};
+
+	struct Violation
+	{
+		ViolationKind	mKind;
+		const char*		mWhat;		//	the function or the name of the mutex, never freed
+		UInt32			mNumberFrames;
+		void*			mFrames[kMaximumNumberFrames];
+	};
+
+#if CARealTimeChecker_Enabled
+
+#pragma mark Scope
+public:
+	//	scopes nest, the thread is real time until the outermost one ends
+	static void			BeginScope();
+	static void			EndScope();
+	static bool			IsInScope();
+
+#pragma mark Violations
+public:
+	//	does nothing unless the calling thread is in a scope
+	static void			ReportViolation(ViolationKind inKind, const char* inWhat);
+
+	//	every violation since the last reset, including the ones that weren't kept
+	static UInt32		GetNumberViolations();
+	static bool			GetViolation(UInt32 inIndex, Violation& outViolation);
+	static void			ResetViolations();
+	static void			DumpViolations();
+
+	static const char*	GetKindName(ViolationKind inKind);
+
+#else
+
+public:
+	static void			BeginScope() {}
+	static void			EndScope() {}
+	static bool			IsInScope() { return false; }
+	static void			ReportViolation(ViolationKind /*inKind*/, const char* /*inWhat*/) {}
+	static UInt32		GetNumberViolations() { return 0; }
+	static bool			GetViolation(UInt32 /*inIndex*/, Violation& /*outViolation*/) { return false; }
+	static void			ResetViolations() {}
+	static void			DumpViolations() {}
+	static const char*	GetKindName(ViolationKind /*inKind*/) { return ""; }
+
+#endif
+
+};
+
+#endif
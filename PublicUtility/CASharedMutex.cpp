@@ -0,0 +1,137 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CASharedMutex.h"
+
+//	PublicUtility Includes
+#include "CADebugMacros.h"
+#include "CARealTimeChecker.h"
+
+//	Standard Library Includes
+#include <thread>
+
+//==================================================================================================
+//	CASharedMutex
+//==================================================================================================
+
+CASharedMutex::CASharedMutex(const char* inName, UInt32 inMaximumSpinCount)
+:
+	CAMutex(inName, inMaximumSpinCount),
+	mNumberReaders(0),
+	mIsWriting(false)
+{
+}
+
+CASharedMutex::~CASharedMutex()
+{
+	Assert(mNumberReaders.load() == 0, "CASharedMutex::~CASharedMutex: destroyed while held shared");
+}
+
+bool	CASharedMutex::Lock()
+{
+	bool theAnswer = CAMutex::Lock();
+	if(theAnswer)
+	{
+		//	keep new readers out, then wait for the ones that are already in
+		mIsWriting.store(true, std::memory_order_seq_cst);
+		WaitForReaders();
+	}
+	return theAnswer;
+}
+
+void	CASharedMutex::Unlock()
+{
+	if(IsOwnedByCurrentThread())
+	{
+		mIsWriting.store(false, std::memory_order_seq_cst);
+	}
+	CAMutex::Unlock();
+}
+
+bool	CASharedMutex::Try(bool& outWasLocked)
+{
+	bool theAnswer = CAMutex::Try(outWasLocked);
+	if(theAnswer && outWasLocked)
+	{
+		mIsWriting.store(true, std::memory_order_seq_cst);
+		if(mNumberReaders.load(std::memory_order_seq_cst) != 0)
+		{
+			//	there are readers, so the lock isn't free after all
+			mIsWriting.store(false, std::memory_order_seq_cst);
+			CAMutex::Unlock();
+			theAnswer = false;
+			outWasLocked = false;
+		}
+	}
+	return theAnswer;
+}
+
+bool	CASharedMutex::LockShared()
+{
+	//	a reader waits for a writer, so this is as bad on a real time thread as Lock()
+	CARealTimeChecker::ReportViolation(CARealTimeChecker::kViolation_Lock, mName);
+	
+	if(IsOwnedByCurrentThread())
+	{
+		return false;
+	}
+	
+	for(;;)
+	{
+		//	announce the reader first, so a writer that comes in now waits for it
+		mNumberReaders.fetch_add(1, std::memory_order_seq_cst);
+		if(!mIsWriting.load(std::memory_order_seq_cst))
+		{
+			return true;
+		}
+		
+		//	back off and park on the writer's lock until it is done
+		mNumberReaders.fetch_sub(1, std::memory_order_seq_cst);
+		CAMutex::Lock();
+		CAMutex::Unlock();
+	}
+}
+
+void	CASharedMutex::UnlockShared()
+{
+	UInt32 theNumberReaders = mNumberReaders.fetch_sub(1, std::memory_order_seq_cst);
+	Assert(theNumberReaders > 0, "CASharedMutex::UnlockShared: the mutex isn't held shared");
+}
+
+void	CASharedMutex::WaitForReaders()
+{
+	//	readers only copy a few values, so they are gone in a moment unless they were preempted
+	for(UInt32 theSpin = 0; mNumberReaders.load(std::memory_order_seq_cst) != 0; ++theSpin)
+	{
+		if(theSpin >= 64)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
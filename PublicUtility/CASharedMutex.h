@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#if !defined(__CASharedMutex_h__)
+#define __CASharedMutex_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Super Class Includes
+#include "CAMutex.h"
+
+//	Standard Library Includes
+#include <atomic>
+
+/*==================================================================================================
+	CASharedMutex
+	
+	A CAMutex that can also be taken shared. Any number of threads can hold it shared at the same
+	time without waiting for each other, which is what the exclusive lock is for in code that
+	mostly reads. A reader announces itself in a counter and backs off while a writer holds the
+	lock. A writer takes the underlying CAMutex, which keeps it recursive and keeps its statistics
+	and spinning, and then waits for the readers that got in before it to leave.
+	
+	A thread that holds the lock exclusively may take it shared as well, which does nothing. Taking
+	it shared twice on the same thread or taking it exclusively while holding it shared deadlocks
+	as soon as a writer shows up, so don't.
+==================================================================================================*/
+
+class	CASharedMutex : public CAMutex
+{
+
+//	Construction/Destruction
+public:
+					CASharedMutex(const char* inName, UInt32 inMaximumSpinCount = 0);
+	virtual			~CASharedMutex();
+
+//	Actions
+public:
+	virtual bool	Lock();
+	virtual void	Unlock();
+	virtual bool	Try(bool& outWasLocked);
+	
+	bool			LockShared();	// returns false if the current thread already holds the lock exclusively
+	void			UnlockShared();
+	
+	UInt32			GetNumberReaders() const { return mNumberReaders.load(std::memory_order_relaxed); }
+
+//	Implementation
+protected:
+	void			WaitForReaders();
+	
+	std::atomic<UInt32>	mNumberReaders;
+	std::atomic<bool>	mIsWriting;
+
+//	Helper class to manage taking and releasing shared
+public:
+	class			SharedLocker
+	{
+	
+	//	Construction/Destruction
+	public:
+					SharedLocker(CASharedMutex& inMutex) : mMutex(&inMutex), mNeedsRelease(false) { mNeedsRelease = mMutex->LockShared(); }
+					SharedLocker(CASharedMutex* inMutex) : mMutex(inMutex), mNeedsRelease(false) { mNeedsRelease = (mMutex != NULL && mMutex->LockShared()); }
+						// in this case the mutex can be null
+					~SharedLocker() { if(mNeedsRelease) { mMutex->UnlockShared(); } }
+	
+	private:
+					SharedLocker(const SharedLocker&);
+		SharedLocker&	operator=(const SharedLocker&);
+	
+	//	Implementation
+	private:
+		CASharedMutex*	mMutex;
+		bool			mNeedsRelease;
+	
+	};
+};
+
+#endif	//	__CASharedMutex_h__
@@ -48,14 +48,18 @@
 //#include "AudioFormulas.h"
 #include "CASpectralProcessor.h"
 #include "CABitOperations.h"
+#include "CADebugMacros.h"
+#include "CAException.h"
+#include "CAWorkerPool.h"
 
-
-#include <Accelerate/Accelerate.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 
 #define OFFSETOF(class, field)((size_t)&((class*)0)->field)
 
-CASpectralProcessor::CASpectralProcessor(UInt32 inFFTSize, UInt32 inHopSize, UInt32 inNumChannels, UInt32 inMaxFrames)
+CASpectralProcessor::CASpectralProcessor(UInt32 inFFTSize, UInt32 inHopSize, UInt32 inNumChannels, UInt32 inMaxFrames, CAFFTBackend::Kind inFFTKind)
 	: mFFTSize(inFFTSize), mHopSize(inHopSize), mNumChannels(inNumChannels), mMaxFrames(inMaxFrames),
 	mLog2FFTSize(Log2Ceil(mFFTSize)), 
 	mFFTMask(mFFTSize - 1),
@@ -65,8 +69,13 @@ CASpectralProcessor::CASpectralProcessor(UInt32 inFFTSize, UInt32 inHopSize, UIn
 	mInputSize(0),
 	mInputPos(0), mOutputPos(-mFFTSize & mIOMask), 
 	mInFFTPos(0), mOutFFTPos(0),
+	mFFTKind(inFFTKind),
+	mFFT(CAFFTBackend::Create(inFFTSize, inFFTKind)),
+	mWorkerPool(0),
 	mSpectralFunction(0), mUserData(0)
 {
+	ThrowIfNULL(mFFT, CAException(kAudio_ParamError), "CASpectralProcessor::CASpectralProcessor: unsupported FFT size");
+	
 	mWindow.alloc(mFFTSize, false);
 	SineWindow(); // set default window.
 	
@@ -82,9 +91,6 @@ CASpectralProcessor::CASpectralProcessor(UInt32 inFFTSize, UInt32 inHopSize, UIn
 		mSpectralBufferList->mDSPSplitComplex[i].realp = mChannels[i].mSplitFFTBuf();
 		mSpectralBufferList->mDSPSplitComplex[i].imagp = mChannels[i].mSplitFFTBuf() + (mFFTSize >> 1);
 	}
-
-	mFFTSetup = vDSP_create_fftsetup (mLog2FFTSize, FFT_RADIX2);
-	
 }
 
 CASpectralProcessor::~CASpectralProcessor()
@@ -92,7 +98,7 @@ CASpectralProcessor::~CASpectralProcessor()
 	mWindow.free();
 	mChannels.free();
 	mSpectralBufferList.free();
-	vDSP_destroy_fftsetup(mFFTSetup);
+	delete mFFT;
 }
 
 void CASpectralProcessor::Reset()
@@ -140,30 +146,89 @@ void CASpectralProcessor::Process(UInt32 inNumFrames, AudioBufferList* inInput,
 	// if enough input to process, then process.
 	while (mInputSize >= mFFTSize) 
 	{
-		CopyInputToFFT(); // copy from input buffer to fft buffer
-		DoWindowing();
-		DoFwdFFT();
+		Analyze(); // copy from input buffer to fft buffer, window and transform
 		ProcessSpectrum(mFFTSize, mSpectralBufferList());
-		DoInvFFT();
-		DoWindowing();
-		OverlapAddOutput();
+		Synthesize();
 	}
 
 	// copy from output buffer to buffer list
 	CopyOutput(inNumFrames, outOutput);
 }
 
-void CASpectralProcessor::DoWindowing()
+void CASpectralProcessor::SetWorkerPool(CAWorkerPool* inWorkerPool)
 {
-	Float32 *win = mWindow();
-	if (!win) return;
+	mWorkerPool = inWorkerPool;
+	
+	// the channels run concurrently, so each needs its own transform unless the shared one can cope
 	for (UInt32 i=0; i<mNumChannels; ++i) {
-		Float32 *x = mChannels[i].mFFTBuf();
-		vDSP_vmul(x, 1, win, 1, x, 1, mFFTSize);
+		if (mWorkerPool && !mFFT->IsReentrant()) {
+			if (!mChannels[i].mFFT)
+				mChannels[i].mFFT = CAFFTBackend::Create(mFFTSize, mFFTKind);
+		} else {
+			delete mChannels[i].mFFT;
+			mChannels[i].mFFT = 0;
+		}
+	}
+}
+
+void CASpectralProcessor::Analyze()
+{
+	if (mWorkerPool) {
+		mWorkerPool->Run(AnalyzeChannel, this, mNumChannels);
+	} else {
+		for (UInt32 i=0; i<mNumChannels; ++i)
+			AnalyzeChannel(this, i);
 	}
+	mInputSize -= mHopSize;
+	mInFFTPos = (mInFFTPos + mHopSize) & mIOMask;
+}
+
+void CASpectralProcessor::Synthesize()
+{
+	if (mWorkerPool) {
+		mWorkerPool->Run(SynthesizeChannel, this, mNumChannels);
+	} else {
+		for (UInt32 i=0; i<mNumChannels; ++i)
+			SynthesizeChannel(this, i);
+	}
+	mOutFFTPos = (mOutFFTPos + mHopSize) & mIOMask;
+}
+
+void CASpectralProcessor::AnalyzeChannel(void* inProcessor, UInt32 inChannel)
+{
+	CASpectralProcessor* processor = static_cast<CASpectralProcessor*>(inProcessor);
+	processor->CopyInputToFFT(inChannel);
+	processor->DoWindowing(inChannel);
+	processor->DoFwdFFT(inChannel);
+}
+
+void CASpectralProcessor::SynthesizeChannel(void* inProcessor, UInt32 inChannel)
+{
+	CASpectralProcessor* processor = static_cast<CASpectralProcessor*>(inProcessor);
+	processor->DoInvFFT(inChannel);
+	processor->DoWindowing(inChannel);
+	processor->OverlapAddOutput(inChannel);
+}
+
+void CASpectralProcessor::DoWindowing()
+{
+	for (UInt32 i=0; i<mNumChannels; ++i)
+		DoWindowing(i);
 	//printf("DoWindowing %g %g\n", mChannels[0].mFFTBuf()[0], mChannels[0].mFFTBuf()[200]);
 }
 
+void CASpectralProcessor::DoWindowing(UInt32 inChannel)
+{
+	Float32 *win = mWindow();
+	if (!win) return;
+	Float32 *x = mChannels[inChannel].mFFTBuf();
+#if __APPLE__
+	vDSP_vmul(x, 1, win, 1, x, 1, mFFTSize);
+#else
+	for (UInt32 j=0; j<mFFTSize; ++j) x[j] *= win[j];
+#endif
+}
+
 
 
 void CASpectralProcessor::CopyInput(UInt32 inNumFrames, AudioBufferList* inInput)
@@ -232,73 +297,92 @@ void CASpectralProcessor::PrintSpectralBufferList()
 void CASpectralProcessor::CopyInputToFFT()
 {
 	//printf("CopyInputToFFT mInFFTPos %u\n", (unsigned)mInFFTPos);
+	for (UInt32 i=0; i<mNumChannels; ++i)
+		CopyInputToFFT(i);
+	mInputSize -= mHopSize;
+	mInFFTPos = (mInFFTPos + mHopSize) & mIOMask;
+	//printf("CopyInputToFFT %g %g\n", mChannels[0].mFFTBuf()[0], mChannels[0].mFFTBuf()[200]);
+}
+
+void CASpectralProcessor::CopyInputToFFT(UInt32 inChannel)
+{
 	UInt32 firstPart = mIOBufSize - mInFFTPos;
 	UInt32 firstPartBytes = firstPart * sizeof(Float32);
+	SpectralChannel &channel = mChannels[inChannel];
 	if (firstPartBytes < mFFTByteSize) {
 		UInt32 secondPartBytes = mFFTByteSize - firstPartBytes;
-		for (UInt32 i=0; i<mNumChannels; ++i) {
-			memcpy(mChannels[i].mFFTBuf(), mChannels[i].mInputBuf() + mInFFTPos, firstPartBytes);
-			memcpy((UInt8*)mChannels[i].mFFTBuf() + firstPartBytes, mChannels[i].mInputBuf(), secondPartBytes);
-		}
+		memcpy(channel.mFFTBuf(), channel.mInputBuf() + mInFFTPos, firstPartBytes);
+		memcpy((UInt8*)channel.mFFTBuf() + firstPartBytes, channel.mInputBuf(), secondPartBytes);
 	} else {
-		for (UInt32 i=0; i<mNumChannels; ++i) {
-			memcpy(mChannels[i].mFFTBuf(), mChannels[i].mInputBuf() + mInFFTPos, mFFTByteSize);
-		}
+		memcpy(channel.mFFTBuf(), channel.mInputBuf() + mInFFTPos, mFFTByteSize);
 	}
-	mInputSize -= mHopSize;
-	mInFFTPos = (mInFFTPos + mHopSize) & mIOMask;
-	//printf("CopyInputToFFT %g %g\n", mChannels[0].mFFTBuf()[0], mChannels[0].mFFTBuf()[200]);
+}
+
+static inline void AddInPlace(Float32* ioDest, const Float32* inSource, UInt32 inCount)
+{
+#if __APPLE__
+	vDSP_vadd(ioDest, 1, inSource, 1, ioDest, 1, inCount);
+#else
+	for (UInt32 i=0; i<inCount; ++i) ioDest[i] += inSource[i];
+#endif
 }
 
 void CASpectralProcessor::OverlapAddOutput()
 {
 	//printf("OverlapAddOutput mOutFFTPos %u\n", (unsigned)mOutFFTPos);
+	for (UInt32 i=0; i<mNumChannels; ++i)
+		OverlapAddOutput(i);
+	//printf("OverlapAddOutput %g %g\n", mChannels[0].mOutputBuf[mOutFFTPos], mChannels[0].mOutputBuf[(mOutFFTPos + 200) & mIOMask]);
+	mOutFFTPos = (mOutFFTPos + mHopSize) & mIOMask;
+}
+
+void CASpectralProcessor::OverlapAddOutput(UInt32 inChannel)
+{
 	UInt32 firstPart = mIOBufSize - mOutFFTPos;
+	SpectralChannel &channel = mChannels[inChannel];
 	if (firstPart < mFFTSize) {
 		UInt32 secondPart = mFFTSize - firstPart;
-		for (UInt32 i=0; i<mNumChannels; ++i) {
-			float* out1 = mChannels[i].mOutputBuf() + mOutFFTPos;
-			vDSP_vadd(out1, 1, mChannels[i].mFFTBuf(), 1, out1, 1, firstPart);
-			float* out2 = mChannels[i].mOutputBuf();
-			vDSP_vadd(out2, 1, mChannels[i].mFFTBuf() + firstPart, 1, out2, 1, secondPart);
-		}
+		AddInPlace(channel.mOutputBuf() + mOutFFTPos, channel.mFFTBuf(), firstPart);
+		AddInPlace(channel.mOutputBuf(), channel.mFFTBuf() + firstPart, secondPart);
 	} else {
-		for (UInt32 i=0; i<mNumChannels; ++i) {
-			float* out1 = mChannels[i].mOutputBuf() + mOutFFTPos;
-			vDSP_vadd(out1, 1, mChannels[i].mFFTBuf(), 1, out1, 1, mFFTSize);
-		}
+		AddInPlace(channel.mOutputBuf() + mOutFFTPos, channel.mFFTBuf(), mFFTSize);
 	}
-	//printf("OverlapAddOutput %g %g\n", mChannels[0].mOutputBuf[mOutFFTPos], mChannels[0].mOutputBuf[(mOutFFTPos + 200) & mIOMask]);
-	mOutFFTPos = (mOutFFTPos + mHopSize) & mIOMask;
 }
 
 
 void CASpectralProcessor::DoFwdFFT()
 {
 	//printf("->DoFwdFFT %g %g\n", mChannels[0].mFFTBuf()[0], mChannels[0].mFFTBuf()[200]);
-	UInt32 half = mFFTSize >> 1;
 	for (UInt32 i=0; i<mNumChannels; ++i) 
-	{
-		vDSP_ctoz((DSPComplex*)mChannels[i].mFFTBuf(), 2, &mSpectralBufferList->mDSPSplitComplex[i], 1, half);
-		vDSP_fft_zrip(mFFTSetup, &mSpectralBufferList->mDSPSplitComplex[i], 1, mLog2FFTSize, FFT_FORWARD);
-	}
+		DoFwdFFT(i);
 	//printf("<-DoFwdFFT %g %g\n", direction, mChannels[0].mFFTBuf()[0], mChannels[0].mFFTBuf()[200]);
 }
 
+void CASpectralProcessor::DoFwdFFT(UInt32 inChannel)
+{
+	ChannelFFT(inChannel)->Forward(mChannels[inChannel].mFFTBuf(), mSpectralBufferList->mDSPSplitComplex[inChannel]);
+}
+
 void CASpectralProcessor::DoInvFFT()
 {
 	//printf("->DoInvFFT %g %g\n", mChannels[0].mFFTBuf()[0], mChannels[0].mFFTBuf()[200]);
-	UInt32 half = mFFTSize >> 1;
 	for (UInt32 i=0; i<mNumChannels; ++i) 
-	{
-		vDSP_fft_zrip(mFFTSetup, &mSpectralBufferList->mDSPSplitComplex[i], 1, mLog2FFTSize, FFT_INVERSE);
-		vDSP_ztoc(&mSpectralBufferList->mDSPSplitComplex[i], 1, (DSPComplex*)mChannels[i].mFFTBuf(), 2, half);		
-		float scale = 0.5 / mFFTSize;
-		vDSP_vsmul(mChannels[i].mFFTBuf(), 1, &scale, mChannels[i].mFFTBuf(), 1, mFFTSize );
-	}
+		DoInvFFT(i);
 	//printf("<-DoInvFFT %g %g\n", direction, mChannels[0].mFFTBuf()[0], mChannels[0].mFFTBuf()[200]);
 }
 
+void CASpectralProcessor::DoInvFFT(UInt32 inChannel)
+{
+	float scale = 0.5 / mFFTSize;
+	Float32* x = mChannels[inChannel].mFFTBuf();
+	ChannelFFT(inChannel)->Inverse(mSpectralBufferList->mDSPSplitComplex[inChannel], x);
+#if __APPLE__
+	vDSP_vsmul(x, 1, &scale, x, 1, mFFTSize);
+#else
+	for (UInt32 j=0; j<mFFTSize; ++j) x[j] *= scale;
+#endif
+}
+
 void CASpectralProcessor::SetSpectralFunction(SpectralFunction inFunction, void* inUserData)
 {
 	mSpectralFunction = inFunction; 
@@ -321,10 +405,20 @@ void CASpectralProcessor::GetMagnitude(AudioBufferList* list, Float32* min, Floa
 		
 		Float32* b = (Float32*) list->mBuffers[i].mData;
 		
+#if __APPLE__
 		vDSP_zvabs(&freqData,1,b,1,half); 		
    
 		vDSP_maxmgv(b, 1, &max[i], half); 
  		vDSP_minmgv(b, 1, &min[i], half); 
+#else
+		max[i] = 0.f;
+		min[i] = INFINITY;
+		for (UInt32 j=0; j<half; ++j) {
+			b[j] = sqrtf(freqData.realp[j] * freqData.realp[j] + freqData.imagp[j] * freqData.imagp[j]);
+			if (b[j] > max[i]) max[i] = b[j];
+			if (b[j] < min[i]) min[i] = b[j];
+		}
+#endif
 		
    } 
 }
@@ -349,9 +443,7 @@ bool CASpectralProcessor::ProcessForwards(UInt32 inNumFrames, AudioBufferList* i
 	// if enough input to process, then process.
 	while (mInputSize >= mFFTSize) 
 	{
-		CopyInputToFFT(); // copy from input buffer to fft buffer
-		DoWindowing();
-		DoFwdFFT();
+		Analyze(); // copy from input buffer to fft buffer, window and transform
 		ProcessSpectrum(mFFTSize, mSpectralBufferList()); // here you would copy the fft results out to a buffer indicated in mUserData, say for sonogram drawing
 		processed = true;
 	}
@@ -363,9 +455,7 @@ bool CASpectralProcessor::ProcessBackwards(UInt32 inNumFrames, AudioBufferList*
 {		
 	
 	ProcessSpectrum(mFFTSize, mSpectralBufferList());
-	DoInvFFT();
-	DoWindowing();
-	OverlapAddOutput();		
+	Synthesize();
 	
 	// copy from output buffer to buffer list
 	CopyOutput(inNumFrames, outOutput);
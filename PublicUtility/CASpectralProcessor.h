@@ -55,9 +55,10 @@
 #include <CoreFoundation.h>
 #endif
 
-#include <Accelerate/Accelerate.h>
-
 #include "CAAutoDisposer.h"
+#include "CAFFTBackend.h"
+
+class CAWorkerPool;
 
 struct SpectralBufferList
 {
@@ -68,7 +69,8 @@ struct SpectralBufferList
 class CASpectralProcessor 
 {
 public:
-	CASpectralProcessor(UInt32 inFFTSize, UInt32 inHopSize, UInt32 inNumChannels, UInt32 inMaxFrames);
+	// inFFTSize must be supported by the chosen backend, see CAFFTBackend::IsSupportedSize
+	CASpectralProcessor(UInt32 inFFTSize, UInt32 inHopSize, UInt32 inNumChannels, UInt32 inMaxFrames, CAFFTBackend::Kind inFFTKind = CAFFTBackend::kKind_Default);
 	virtual ~CASpectralProcessor();
 	
 	void Reset();
@@ -79,11 +81,18 @@ public:
 	
 	void SetSpectralFunction(SpectralFunction inFunction, void* inUserData);
 	
+	// Spreads the per channel windowing, transforms and overlap-add over the pool's workers. The
+	// pool may be shared between processors and has to outlive its use here. Not real time safe,
+	// call it before processing starts. NULL goes back to processing on the calling thread.
+	void SetWorkerPool(CAWorkerPool* inWorkerPool);
+	CAWorkerPool* WorkerPool() const { return mWorkerPool; }
+	
 	UInt32 FFTSize() const { return mFFTSize; }
 	UInt32 MaxFrames() const { return mMaxFrames; }
 	UInt32 NumChannels() const { return mNumChannels; }
 	UInt32 HopSize() const { return mHopSize; }
 	Float32* Window() const { return mWindow; }
+	const CAFFTBackend* FFT() const { return mFFT; }
 	
 	
 	void HanningWindow(); // set up a hanning window
@@ -108,6 +117,19 @@ protected:
 	void CopyOutput(UInt32 inNumFrames, AudioBufferList* inOutput);
 	void ProcessSpectrum(UInt32 inFFTSize, SpectralBufferList* inSpectra);
 	
+	// one hop of CopyInputToFFT, DoWindowing and DoFwdFFT, and of DoInvFFT, DoWindowing and
+	// OverlapAddOutput, split by channel so they can run on the worker pool
+	void Analyze();
+	void Synthesize();
+	static void AnalyzeChannel(void* inProcessor, UInt32 inChannel);
+	static void SynthesizeChannel(void* inProcessor, UInt32 inChannel);
+	void CopyInputToFFT(UInt32 inChannel);
+	void DoWindowing(UInt32 inChannel);
+	void DoFwdFFT(UInt32 inChannel);
+	void DoInvFFT(UInt32 inChannel);
+	void OverlapAddOutput(UInt32 inChannel);
+	CAFFTBackend* ChannelFFT(UInt32 inChannel) const { return mChannels[inChannel].mFFT ? mChannels[inChannel].mFFT : mFFT; }
+	
 	UInt32 mFFTSize;
 	UInt32 mHopSize;
 	UInt32 mNumChannels;
@@ -123,15 +145,21 @@ protected:
 	UInt32 mOutputPos;
 	UInt32 mInFFTPos;
 	UInt32 mOutFFTPos;
-	FFTSetup mFFTSetup;
+	CAFFTBackend::Kind mFFTKind;
+	CAFFTBackend* mFFT;
+	CAWorkerPool* mWorkerPool;
 
 	CAAutoFree<Float32> mWindow;
 	struct SpectralChannel 
 	{
+		SpectralChannel() : mFFT(0) {}
+		~SpectralChannel() { delete mFFT; }
+		
 		CAAutoFree<Float32> mInputBuf;		// log2ceil(FFT size + max frames)
 		CAAutoFree<Float32> mOutputBuf;		// log2ceil(FFT size + max frames)
 		CAAutoFree<Float32> mFFTBuf;		// FFT size
 		CAAutoFree<Float32> mSplitFFTBuf;	// FFT size
+		CAFFTBackend* mFFT;					// own transform for the worker pool if the shared one isn't reentrant
 	};
 	CAAutoArrayDelete<SpectralChannel> mChannels;
 
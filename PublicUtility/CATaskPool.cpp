@@ -0,0 +1,452 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CATaskPool.h"
+
+//	Standard Library Includes
+#include <algorithm>
+
+#if defined(__BLOCKS__)
+	#include <Block.h>
+#endif
+
+//==================================================================================================
+//	CATaskPool
+//==================================================================================================
+
+//	the pool and worker the current thread belongs to, if any
+static thread_local CATaskPool*	tCurrentPool = NULL;
+static thread_local UInt32		tCurrentWorker = 0;
+
+CATaskPool::CATaskPool(UInt32 inNumberWorkers)
+:
+	mWorkers(),
+	mNextWorker(0),
+	mNumberQueuedTasks(0),
+	mNumberParkedWorkers(0),
+	mQuit(false),
+	mNextTimerSequence(0),
+	mNumberExecutedTasks(0),
+	mNumberStolenTasks(0)
+{
+	UInt32 theNumberWorkers = inNumberWorkers;
+	if(theNumberWorkers == 0)
+	{
+		theNumberWorkers = std::max(1U, std::thread::hardware_concurrency());
+	}
+	
+	//	all the deques have to exist before the first worker goes looking for something to steal
+	for(UInt32 theWorkerIndex = 0; theWorkerIndex < theNumberWorkers; ++theWorkerIndex)
+	{
+		mWorkers.push_back(std::unique_ptr<Worker>(new Worker));
+	}
+	for(UInt32 theWorkerIndex = 0; theWorkerIndex < theNumberWorkers; ++theWorkerIndex)
+	{
+		mWorkers[theWorkerIndex]->mThread = std::thread(&CATaskPool::WorkerLoop, this, theWorkerIndex);
+	}
+	mTimerThread = std::thread(&CATaskPool::TimerLoop, this);
+}
+
+CATaskPool::~CATaskPool()
+{
+	{
+		std::lock_guard<std::mutex> theTimerLocker(mTimerMutex);
+		mQuit.store(true);
+		mTimers.clear();
+	}
+	mTimerCondition.notify_all();
+	mTimerThread.join();
+	
+	{
+		std::lock_guard<std::mutex> theParkLocker(mParkMutex);
+	}
+	mParkCondition.notify_all();
+	for(UInt32 theWorkerIndex = 0; theWorkerIndex < mWorkers.size(); ++theWorkerIndex)
+	{
+		mWorkers[theWorkerIndex]->mThread.join();
+	}
+}
+
+void	CATaskPool::Dispatch(bool inDoSync, const Task& inTask)
+{
+	//	like dispatch_sync on a concurrent queue, a synchronous task just runs on the calling thread
+	if(inDoSync)
+	{
+		inTask();
+	}
+	else
+	{
+		Enqueue(inTask);
+	}
+}
+
+void	CATaskPool::Dispatch(UInt64 inNanoseconds, const Task& inTask)
+{
+	AddTimer(inNanoseconds, NULL, inTask);
+}
+
+#if defined(__BLOCKS__)
+
+void	CATaskPool::Dispatch(bool inDoSync, void (^inTask)(void))
+{
+	if(inDoSync)
+	{
+		inTask();
+	}
+	else
+	{
+		void (^theTask)(void) = Block_copy(inTask);
+		Enqueue([theTask]() { theTask(); Block_release(theTask); });
+	}
+}
+
+void	CATaskPool::Dispatch(UInt64 inNanoseconds, void (^inTask)(void))
+{
+	void (^theTask)(void) = Block_copy(inTask);
+	AddTimer(inNanoseconds, NULL, [theTask]() { theTask(); Block_release(theTask); });
+}
+
+#endif
+
+CATaskPool&	CATaskPool::GetGlobalPool()
+{
+	//	never destroyed, like the global serial queue, so it can be used during static destruction
+	static CATaskPool* sGlobalPool = new CATaskPool();
+	return *sGlobalPool;
+}
+
+bool	CATaskPool::Timer::operator<(const Timer& inTimer) const
+{
+	//	std::push_heap keeps the largest element in front, so the earliest deadline has to be largest
+	return (mDeadline > inTimer.mDeadline) || ((mDeadline == inTimer.mDeadline) && (mSequence > inTimer.mSequence));
+}
+
+void	CATaskPool::Enqueue(const Task& inTask, bool inIsYielding)
+{
+	//	Count the task before it can be taken, so the count never goes below the number of tasks
+	//	in the deques. A parked worker only sleeps while the count is zero, and it increments
+	//	mNumberParkedWorkers before it looks, so either it sees this task or we see it parked.
+	mNumberQueuedTasks.fetch_add(1, std::memory_order_seq_cst);
+	
+	if(IsWorkerThread())
+	{
+		Worker& theWorker = *mWorkers[tCurrentWorker];
+		std::lock_guard<std::mutex> theLocker(theWorker.mMutex);
+		if(inIsYielding)
+		{
+			theWorker.mTasks.push_front(inTask);
+		}
+		else
+		{
+			theWorker.mTasks.push_back(inTask);
+		}
+	}
+	else
+	{
+		Worker& theWorker = *mWorkers[mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size()];
+		std::lock_guard<std::mutex> theLocker(theWorker.mMutex);
+		theWorker.mTasks.push_back(inTask);
+	}
+	
+	if(mNumberParkedWorkers.load(std::memory_order_seq_cst) > 0)
+	{
+		std::lock_guard<std::mutex> theParkLocker(mParkMutex);
+		mParkCondition.notify_one();
+	}
+}
+
+void	CATaskPool::Wait(const Task& inTask, std::function<void(const Task&)> inEnqueue)
+{
+	std::mutex theMutex;
+	std::condition_variable theCondition;
+	std::atomic<bool> isDone(false);
+	inEnqueue([&]()
+	{
+		inTask();
+		std::lock_guard<std::mutex> theLocker(theMutex);
+		isDone.store(true, std::memory_order_release);
+		theCondition.notify_all();
+	});
+	
+	if(IsWorkerThread())
+	{
+		//	a worker keeps working while it waits, otherwise enough waiting workers would starve
+		//	the task they are waiting for
+		while(!isDone.load(std::memory_order_acquire))
+		{
+			if(!RunOneTask(tCurrentWorker))
+			{
+				std::unique_lock<std::mutex> theLocker(theMutex);
+				theCondition.wait_for(theLocker, std::chrono::microseconds(100), [&]() { return isDone.load(std::memory_order_acquire); });
+			}
+		}
+	}
+	
+	//	also makes sure the task is done with the mutex before it goes away
+	std::unique_lock<std::mutex> theLocker(theMutex);
+	theCondition.wait(theLocker, [&]() { return isDone.load(std::memory_order_acquire); });
+}
+
+void	CATaskPool::AddTimer(UInt64 inNanoseconds, Strand* inStrand, const Task& inTask)
+{
+	Timer theTimer;
+	theTimer.mDeadline = Clock::now() + std::chrono::nanoseconds(inNanoseconds);
+	theTimer.mStrand = inStrand;
+	theTimer.mTask = inTask;
+	{
+		std::lock_guard<std::mutex> theTimerLocker(mTimerMutex);
+		theTimer.mSequence = mNextTimerSequence++;
+		mTimers.push_back(theTimer);
+		std::push_heap(mTimers.begin(), mTimers.end());
+	}
+	mTimerCondition.notify_one();
+}
+
+void	CATaskPool::RemoveTimers(Strand* inStrand)
+{
+	std::lock_guard<std::mutex> theTimerLocker(mTimerMutex);
+	mTimers.erase(std::remove_if(mTimers.begin(), mTimers.end(), [inStrand](const Timer& inTimer) { return inTimer.mStrand == inStrand; }), mTimers.end());
+	std::make_heap(mTimers.begin(), mTimers.end());
+}
+
+bool	CATaskPool::RunOneTask(UInt32 inWorkerIndex)
+{
+	Task theTask;
+	if(!TakeTask(inWorkerIndex, theTask))
+	{
+		return false;
+	}
+	theTask();
+	mNumberExecutedTasks.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool	CATaskPool::TakeTask(UInt32 inWorkerIndex, Task& outTask)
+{
+	//	the newest task of our own
+	{
+		Worker& theWorker = *mWorkers[inWorkerIndex];
+		std::lock_guard<std::mutex> theLocker(theWorker.mMutex);
+		if(!theWorker.mTasks.empty())
+		{
+			outTask.swap(theWorker.mTasks.back());
+			theWorker.mTasks.pop_back();
+			mNumberQueuedTasks.fetch_sub(1, std::memory_order_seq_cst);
+			return true;
+		}
+	}
+	
+	//	the oldest task of somebody else
+	UInt32 theNumberWorkers = static_cast<UInt32>(mWorkers.size());
+	for(UInt32 theOffset = 1; theOffset < theNumberWorkers; ++theOffset)
+	{
+		Worker& theVictim = *mWorkers[(inWorkerIndex + theOffset) % theNumberWorkers];
+		std::lock_guard<std::mutex> theLocker(theVictim.mMutex);
+		if(!theVictim.mTasks.empty())
+		{
+			outTask.swap(theVictim.mTasks.front());
+			theVictim.mTasks.pop_front();
+			mNumberQueuedTasks.fetch_sub(1, std::memory_order_seq_cst);
+			mNumberStolenTasks.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void	CATaskPool::WorkerLoop(UInt32 inWorkerIndex)
+{
+	tCurrentPool = this;
+	tCurrentWorker = inWorkerIndex;
+	while(true)
+	{
+		if(RunOneTask(inWorkerIndex))
+		{
+			continue;
+		}
+		
+		std::unique_lock<std::mutex> theParkLocker(mParkMutex);
+		mNumberParkedWorkers.fetch_add(1, std::memory_order_seq_cst);
+		while((mNumberQueuedTasks.load(std::memory_order_seq_cst) == 0) && !mQuit.load())
+		{
+			mParkCondition.wait(theParkLocker);
+		}
+		mNumberParkedWorkers.fetch_sub(1, std::memory_order_seq_cst);
+		
+		//	the pool is going away once everything that was dispatched has run
+		if(mQuit.load() && (mNumberQueuedTasks.load(std::memory_order_seq_cst) == 0))
+		{
+			break;
+		}
+	}
+	tCurrentPool = NULL;
+}
+
+void	CATaskPool::TimerLoop()
+{
+	std::unique_lock<std::mutex> theTimerLocker(mTimerMutex);
+	while(!mQuit.load())
+	{
+		if(mTimers.empty())
+		{
+			mTimerCondition.wait(theTimerLocker);
+		}
+		else if(mTimers.front().mDeadline <= Clock::now())
+		{
+			std::pop_heap(mTimers.begin(), mTimers.end());
+			Timer theTimer;
+			std::swap(theTimer, mTimers.back());
+			mTimers.pop_back();
+			
+			//	still holding the lock, so a strand that is going away can't be removed under us
+			if(theTimer.mStrand != NULL)
+			{
+				theTimer.mStrand->Enqueue(theTimer.mTask);
+			}
+			else
+			{
+				Enqueue(theTimer.mTask);
+			}
+		}
+		else
+		{
+			mTimerCondition.wait_until(theTimerLocker, mTimers.front().mDeadline);
+		}
+	}
+}
+
+bool	CATaskPool::IsWorkerThread() const
+{
+	return tCurrentPool == this;
+}
+
+//==================================================================================================
+//	CATaskPool::Strand
+//==================================================================================================
+
+CATaskPool::Strand::Strand(CATaskPool& inPool)
+:
+	mPool(inPool),
+	mIsScheduled(false)
+{
+}
+
+CATaskPool::Strand::~Strand()
+{
+	mPool.RemoveTimers(this);
+	std::unique_lock<std::mutex> theLocker(mMutex);
+	mIdleCondition.wait(theLocker, [this]() { return !mIsScheduled; });
+}
+
+void	CATaskPool::Strand::Dispatch(bool inDoSync, const Task& inTask)
+{
+	if(inDoSync)
+	{
+		mPool.Wait(inTask, [this](const Task& inWrappedTask) { Enqueue(inWrappedTask); });
+	}
+	else
+	{
+		Enqueue(inTask);
+	}
+}
+
+void	CATaskPool::Strand::Dispatch(UInt64 inNanoseconds, const Task& inTask)
+{
+	mPool.AddTimer(inNanoseconds, this, inTask);
+}
+
+#if defined(__BLOCKS__)
+
+void	CATaskPool::Strand::Dispatch(bool inDoSync, void (^inTask)(void))
+{
+	if(inDoSync)
+	{
+		Dispatch(true, Task([inTask]() { inTask(); }));
+	}
+	else
+	{
+		void (^theTask)(void) = Block_copy(inTask);
+		Enqueue([theTask]() { theTask(); Block_release(theTask); });
+	}
+}
+
+void	CATaskPool::Strand::Dispatch(UInt64 inNanoseconds, void (^inTask)(void))
+{
+	void (^theTask)(void) = Block_copy(inTask);
+	mPool.AddTimer(inNanoseconds, this, [theTask]() { theTask(); Block_release(theTask); });
+}
+
+#endif
+
+void	CATaskPool::Strand::Enqueue(const Task& inTask)
+{
+	{
+		std::lock_guard<std::mutex> theLocker(mMutex);
+		mTasks.push_back(inTask);
+		if(mIsScheduled)
+		{
+			return;
+		}
+		mIsScheduled = true;
+	}
+	mPool.Enqueue([this]() { RunTurn(); });
+}
+
+void	CATaskPool::Strand::RunTurn()
+{
+	for(UInt32 theTaskIndex = 0; theTaskIndex < kMaximumTasksPerTurn; ++theTaskIndex)
+	{
+		Task theTask;
+		{
+			std::lock_guard<std::mutex> theLocker(mMutex);
+			if(mTasks.empty())
+			{
+				//	the strand may be destroyed as soon as the lock is released
+				mIsScheduled = false;
+				mIdleCondition.notify_all();
+				return;
+			}
+			theTask.swap(mTasks.front());
+			mTasks.pop_front();
+		}
+		theTask();
+	}
+	
+	//	give the worker back and queue another turn behind whatever else is waiting
+	{
+		std::lock_guard<std::mutex> theLocker(mMutex);
+		if(mTasks.empty())
+		{
+			mIsScheduled = false;
+			mIdleCondition.notify_all();
+			return;
+		}
+	}
+	mPool.Enqueue([this]() { RunTurn(); }, true);
+}
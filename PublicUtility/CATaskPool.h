@@ -0,0 +1,222 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#if !defined(__CATaskPool_h__)
+#define __CATaskPool_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+//	Standard Library Includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*==================================================================================================
+	CATaskPool
+
+	A portable executor for the work that goes through CADispatchQueue today, with the same
+	Dispatch(bool inDoSync, ...) and Dispatch(UInt64 inNanoseconds, ...) surface. It only needs the
+	standard library, so it builds wherever the rest of the DSP code does.
+
+	Every worker owns a deque. A task dispatched from a worker goes to the back of that worker's
+	deque and the worker takes its own work from the back, so related work stays on a warm cache.
+	Tasks from any other thread are dealt round robin to the workers. A worker that runs dry steals
+	from the front of the other deques before it parks. Each deque has its own mutex, which is
+	rarely contended since the owner and the thieves work at opposite ends.
+
+	The pool runs its tasks concurrently and in no particular order. Work that has to stay ordered,
+	like the global serial queue's config changes and object releases, goes through a Strand: a
+	serial queue that borrows one worker at a time from the pool and keeps its tasks in order.
+
+	Delayed tasks wait in a heap that a timer thread moves to the pool or strand when they are due.
+	Synchronous dispatch from a worker keeps running other tasks while it waits, so it can't starve
+	the pool, but a synchronous dispatch to the strand the caller is running on deadlocks just like
+	dispatch_sync does. Tasks must not throw.
+==================================================================================================*/
+
+class CATaskPool
+{
+
+#pragma mark Types
+public:
+	typedef void						(*TaskFunction)(void* inContext);
+	typedef std::function<void()>		Task;
+	class								Strand;
+
+#pragma mark Construction/Destruction
+public:
+	//	0 workers means one per CPU
+	explicit							CATaskPool(UInt32 inNumberWorkers = 0);
+	
+	//	waits for the tasks that are due, drops the delayed ones that are not
+										~CATaskPool();
+
+private:
+										CATaskPool(const CATaskPool&);
+	CATaskPool&							operator=(const CATaskPool&);
+
+#pragma mark Execution Operations
+public:
+	void								Dispatch(bool inDoSync, const Task& inTask);
+	void								Dispatch(UInt64 inNanoseconds, const Task& inTask);
+	
+	void								Dispatch(bool inDoSync, void* inTaskContext, TaskFunction inTask)			{ Dispatch(inDoSync, Task(std::bind(inTask, inTaskContext))); }
+	void								Dispatch(UInt64 inNanoseconds, void* inTaskContext, TaskFunction inTask)	{ Dispatch(inNanoseconds, Task(std::bind(inTask, inTaskContext))); }
+
+#if defined(__BLOCKS__)
+	void								Dispatch(bool inDoSync, void (^inTask)(void));
+	void								Dispatch(UInt64 inNanoseconds, void (^inTask)(void));
+#endif
+
+#pragma mark Attributes
+public:
+	UInt32								GetNumberWorkers() const		{ return static_cast<UInt32>(mWorkers.size()); }
+	UInt64								GetNumberExecutedTasks() const	{ return mNumberExecutedTasks.load(std::memory_order_relaxed); }
+	UInt64								GetNumberStolenTasks() const	{ return mNumberStolenTasks.load(std::memory_order_relaxed); }
+	
+	//	the pool that shares the CPUs with everything else in the process
+	static CATaskPool&					GetGlobalPool();
+
+#pragma mark Implementation
+private:
+	typedef std::chrono::steady_clock	Clock;
+	
+	struct								Worker
+	{
+		std::mutex						mMutex;
+		std::deque<Task>				mTasks;
+		std::thread						mThread;
+	};
+	
+	struct								Timer
+	{
+		Clock::time_point				mDeadline;
+		UInt64							mSequence;
+		Strand*							mStrand;
+		Task							mTask;
+		
+		bool							operator<(const Timer& inTimer) const;
+	};
+	
+	//	a worker puts a yielding task at the front of its deque, where it runs after everything else
+	void								Enqueue(const Task& inTask, bool inIsYielding = false);
+	void								Wait(const Task& inTask, std::function<void(const Task&)> inEnqueue);
+	void								AddTimer(UInt64 inNanoseconds, Strand* inStrand, const Task& inTask);
+	void								RemoveTimers(Strand* inStrand);
+	bool								RunOneTask(UInt32 inWorkerIndex);
+	bool								TakeTask(UInt32 inWorkerIndex, Task& outTask);
+	void								WorkerLoop(UInt32 inWorkerIndex);
+	void								TimerLoop();
+	bool								IsWorkerThread() const;
+	
+	std::vector<std::unique_ptr<Worker>>	mWorkers;
+	std::atomic<UInt32>					mNextWorker;
+	
+	//	parking, see Enqueue() and WorkerLoop()
+	std::mutex							mParkMutex;
+	std::condition_variable				mParkCondition;
+	std::atomic<UInt64>					mNumberQueuedTasks;
+	std::atomic<UInt32>					mNumberParkedWorkers;
+	std::atomic<bool>					mQuit;
+	
+	//	the delayed tasks, a heap on mDeadline
+	std::mutex							mTimerMutex;
+	std::condition_variable				mTimerCondition;
+	std::vector<Timer>					mTimers;
+	UInt64								mNextTimerSequence;
+	std::thread							mTimerThread;
+	
+	std::atomic<UInt64>					mNumberExecutedTasks;
+	std::atomic<UInt64>					mNumberStolenTasks;
+
+};
+
+/*==================================================================================================
+	CATaskPool::Strand
+
+	A serial queue on a CATaskPool. Its tasks run one at a time, in the order they were dispatched,
+	but on whichever worker is free. A strand hands its worker back after a few tasks so that a busy
+	strand can't keep the others waiting. Destroying a strand drops its delayed tasks and waits for
+	the rest.
+==================================================================================================*/
+
+class CATaskPool::Strand
+{
+
+#pragma mark Construction/Destruction
+public:
+	explicit							Strand(CATaskPool& inPool);
+										~Strand();
+
+private:
+										Strand(const Strand&);
+	Strand&								operator=(const Strand&);
+
+#pragma mark Execution Operations
+public:
+	void								Dispatch(bool inDoSync, const Task& inTask);
+	void								Dispatch(UInt64 inNanoseconds, const Task& inTask);
+	
+	void								Dispatch(bool inDoSync, void* inTaskContext, TaskFunction inTask)			{ Dispatch(inDoSync, Task(std::bind(inTask, inTaskContext))); }
+	void								Dispatch(UInt64 inNanoseconds, void* inTaskContext, TaskFunction inTask)	{ Dispatch(inNanoseconds, Task(std::bind(inTask, inTaskContext))); }
+
+#if defined(__BLOCKS__)
+	void								Dispatch(bool inDoSync, void (^inTask)(void));
+	void								Dispatch(UInt64 inNanoseconds, void (^inTask)(void));
+#endif
+
+	CATaskPool&							GetPool() const		{ return mPool; }
+
+#pragma mark Implementation
+private:
+	friend class						CATaskPool;
+	
+	enum								{ kMaximumTasksPerTurn = 16 };
+	
+	void								Enqueue(const Task& inTask);
+	void								RunTurn();
+	
+	CATaskPool&							mPool;
+	std::mutex							mMutex;
+	std::condition_variable				mIdleCondition;
+	std::deque<Task>					mTasks;
+	bool								mIsScheduled;
+
+};
+
+#endif	//	__CATaskPool_h__
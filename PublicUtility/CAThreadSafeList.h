@@ -82,7 +82,12 @@ public:
 		Node *		mNode;
 	};
 	
-	TThreadSafeList() { }
+	TThreadSafeList(UInt32 inNumberReservedNodes = 0)
+		// reserved nodes let the deferred calls run without allocating until they are used up
+	{
+		for (UInt32 i = 0; i < inNumberReservedNodes; ++i)
+			mFreeList.push_NA((Node *)CA_malloc(sizeof(Node)));
+	}
 	~TThreadSafeList()
 	{
 		mActiveList.free_all();
@@ -225,9 +230,18 @@ private:
 		Node *	head() const { return this->mHead; }
 	};
 
+	class FreeStack : public TAtomicTaggedStack<Node> {
+	public:
+		void free_all() {
+			Node *node;
+			while ((node = this->pop_NA()) != NULL)
+				free(node);
+		}
+	};
+
 	NodeStack	mActiveList;	// what's actually in the container - only accessed on one thread
 	NodeStack	mPendingList;	// add or remove requests - threadsafe
-	NodeStack	mFreeList;		// free nodes for reuse - threadsafe
+	FreeStack	mFreeList;		// free nodes for reuse - threadsafe, popped by any thread
 };
 
 #endif // __CAThreadSafeList_h__
@@ -0,0 +1,1164 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CAVectorKernels.h"
+
+//	System Includes
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+	#define	CAVectorKernels_Use_X86		1
+	#include <immintrin.h>
+#elif (defined(__aarch64__) || defined(__arm64__)) && defined(__ARM_NEON)
+	#define	CAVectorKernels_Use_Neon	1
+	#include <arm_neon.h>
+#endif
+
+//	Standard Library Includes
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+//==================================================================================================
+//	Scalar
+//
+//	The reference every tier is tested against, and what the vector tiers use for their tails.
+//==================================================================================================
+
+namespace
+{
+	void	Scale_Scalar(Float32* ioData, UInt32 inNumberSamples, Float32 inGain)
+	{
+		for(UInt32 i = 0; i < inNumberSamples; ++i)
+		{
+			ioData[i] *= inGain;
+		}
+	}
+
+	void	AddScaled_Scalar(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples, Float32 inGain)
+	{
+		for(UInt32 i = 0; i < inNumberSamples; ++i)
+		{
+			ioDestination[i] += inGain * inSource[i];
+		}
+	}
+
+	Float32	GetPeak_Scalar(const Float32* inData, UInt32 inNumberSamples, Float32 inPeak)
+	{
+		for(UInt32 i = 0; i < inNumberSamples; ++i)
+		{
+			Float32 theValue = fabsf(inData[i]);
+			inPeak = theValue > inPeak ? theValue : inPeak;
+		}
+		return inPeak;
+	}
+
+	Float32	GetPeak_Scalar(const Float32* inData, UInt32 inNumberSamples)
+	{
+		return GetPeak_Scalar(inData, inNumberSamples, 0.0f);
+	}
+
+	void	ConvertToSInt16_Scalar(const Float32* inSource, SInt16* outDestination, UInt32 inNumberSamples)
+	{
+		for(UInt32 i = 0; i < inNumberSamples; ++i)
+		{
+			Float32 theValue = inSource[i] * 32767.0f;
+			theValue = theValue > -32768.0f ? theValue : -32768.0f;
+			theValue = theValue < 32767.0f ? theValue : 32767.0f;
+			outDestination[i] = static_cast<SInt16>(lrintf(theValue));
+		}
+	}
+
+	//	all the channels of all the frames, which memcpy does better than any of the tiers
+	inline bool	IsContiguousCopy(UInt32 inSourceStride, UInt32 inDestinationStride, UInt32 inNumberChannels)
+	{
+		return (inSourceStride == inNumberChannels) && (inDestinationStride == inNumberChannels);
+	}
+
+	//	a Float32 pointer that isn't on a 4 byte boundary never gets to a vector boundary
+	inline bool	IsSampleAligned(const Float32* inData)
+	{
+		return (reinterpret_cast<uintptr_t>(inData) % sizeof(Float32)) == 0;
+	}
+
+	//	the number of samples in front of the first one on an inAlignment byte boundary
+	inline UInt32	GetNumberSamplesToAlign(const Float32* inData, UInt32 inAlignment, UInt32 inNumberSamples)
+	{
+		UInt32 theNumberSamples = static_cast<UInt32>(((inAlignment - (reinterpret_cast<uintptr_t>(inData) % inAlignment)) % inAlignment) / sizeof(Float32));
+		return theNumberSamples < inNumberSamples ? theNumberSamples : inNumberSamples;
+	}
+
+	void	Add_Scalar(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples)
+	{
+		for(UInt32 i = 0; i < inNumberSamples; ++i)
+		{
+			ioDestination[i] += inSource[i];
+		}
+	}
+
+	//	the frames from inFirstFrame on, the vector tiers interleave the ones in front of it
+	void	Interleave_Scalar(const Float32* const* inSources, UInt32 inNumberChannels, Float32* outDestination, UInt32 inDestinationStride, UInt32 inFirstFrame, UInt32 inNumberFrames)
+	{
+		for(UInt32 f = inFirstFrame; f < inNumberFrames; ++f)
+		{
+			for(UInt32 c = 0; c < inNumberChannels; ++c)
+			{
+				outDestination[f * inDestinationStride + c] = inSources[c][f];
+			}
+		}
+	}
+
+	void	Interleave_Scalar(const Float32* const* inSources, UInt32 inNumberChannels, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		Interleave_Scalar(inSources, inNumberChannels, outDestination, inDestinationStride, 0, inNumberFrames);
+	}
+
+	void	Deinterleave_Scalar(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberChannels, UInt32 inFirstFrame, UInt32 inNumberFrames)
+	{
+		for(UInt32 f = inFirstFrame; f < inNumberFrames; ++f)
+		{
+			for(UInt32 c = 0; c < inNumberChannels; ++c)
+			{
+				outDestinations[c][f] = inSource[f * inSourceStride + c];
+			}
+		}
+	}
+
+	void	Deinterleave_Scalar(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		Deinterleave_Scalar(inSource, inSourceStride, outDestinations, inNumberChannels, 0, inNumberFrames);
+	}
+
+	void	CopyChannels_Scalar(const Float32* inSource, UInt32 inSourceStride, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		if(IsContiguousCopy(inSourceStride, inDestinationStride, inNumberChannels))
+		{
+			memcpy(outDestination, inSource, inNumberFrames * inNumberChannels * sizeof(Float32));
+			return;
+		}
+		for(UInt32 f = 0; f < inNumberFrames; ++f)
+		{
+			for(UInt32 c = 0; c < inNumberChannels; ++c)
+			{
+				outDestination[f * inDestinationStride + c] = inSource[f * inSourceStride + c];
+			}
+		}
+	}
+}
+
+#if CAVectorKernels_Use_X86
+
+//==================================================================================================
+//	SSE2
+//
+//	The tiers are compiled with target attributes, so one translation unit has all of them no
+//	matter what the project's architecture flags are.
+//==================================================================================================
+
+namespace
+{
+	__attribute__((target("sse2")))
+	void	Scale_SSE2(Float32* ioData, UInt32 inNumberSamples, Float32 inGain)
+	{
+		const __m128 theGain = _mm_set1_ps(inGain);
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			_mm_storeu_ps(ioData + i, _mm_mul_ps(_mm_loadu_ps(ioData + i), theGain));
+			_mm_storeu_ps(ioData + i + 4, _mm_mul_ps(_mm_loadu_ps(ioData + i + 4), theGain));
+		}
+		Scale_Scalar(ioData + i, inNumberSamples - i, inGain);
+	}
+
+	__attribute__((target("sse2")))
+	void	AddScaled_SSE2(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples, Float32 inGain)
+	{
+		const __m128 theGain = _mm_set1_ps(inGain);
+		UInt32 i = 0;
+		if(IsSampleAligned(ioDestination))
+		{
+			i = GetNumberSamplesToAlign(ioDestination, 16, inNumberSamples);
+			AddScaled_Scalar(inSource, ioDestination, i, inGain);
+			for(; i + 8 <= inNumberSamples; i += 8)
+			{
+				_mm_store_ps(ioDestination + i, _mm_add_ps(_mm_load_ps(ioDestination + i), _mm_mul_ps(theGain, _mm_loadu_ps(inSource + i))));
+				_mm_store_ps(ioDestination + i + 4, _mm_add_ps(_mm_load_ps(ioDestination + i + 4), _mm_mul_ps(theGain, _mm_loadu_ps(inSource + i + 4))));
+			}
+		}
+		for(; i + 4 <= inNumberSamples; i += 4)
+		{
+			_mm_storeu_ps(ioDestination + i, _mm_add_ps(_mm_loadu_ps(ioDestination + i), _mm_mul_ps(theGain, _mm_loadu_ps(inSource + i))));
+		}
+		AddScaled_Scalar(inSource + i, ioDestination + i, inNumberSamples - i, inGain);
+	}
+
+	__attribute__((target("sse2")))
+	Float32	GetPeak_SSE2(const Float32* inData, UInt32 inNumberSamples)
+	{
+		const __m128 theAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128 thePeak0 = _mm_setzero_ps(), thePeak1 = _mm_setzero_ps();
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			thePeak0 = _mm_max_ps(thePeak0, _mm_and_ps(_mm_loadu_ps(inData + i), theAbsMask));
+			thePeak1 = _mm_max_ps(thePeak1, _mm_and_ps(_mm_loadu_ps(inData + i + 4), theAbsMask));
+		}
+		thePeak0 = _mm_max_ps(thePeak0, thePeak1);
+		thePeak0 = _mm_max_ps(thePeak0, _mm_shuffle_ps(thePeak0, thePeak0, _MM_SHUFFLE(1, 0, 3, 2)));
+		thePeak0 = _mm_max_ps(thePeak0, _mm_shuffle_ps(thePeak0, thePeak0, _MM_SHUFFLE(2, 3, 0, 1)));
+		return GetPeak_Scalar(inData + i, inNumberSamples - i, _mm_cvtss_f32(thePeak0));
+	}
+
+	__attribute__((target("sse2")))
+	void	ConvertToSInt16_SSE2(const Float32* inSource, SInt16* outDestination, UInt32 inNumberSamples)
+	{
+		//	clipping before the conversion keeps large values from turning into 0x80000000
+		const __m128 theScale = _mm_set1_ps(32767.0f);
+		const __m128 theMinimum = _mm_set1_ps(-32768.0f);
+		const __m128 theMaximum = _mm_set1_ps(32767.0f);
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			__m128 theValues0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(inSource + i), theScale), theMinimum), theMaximum);
+			__m128 theValues1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(inSource + i + 4), theScale), theMinimum), theMaximum);
+			__m128i theSamples = _mm_packs_epi32(_mm_cvtps_epi32(theValues0), _mm_cvtps_epi32(theValues1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(outDestination + i), theSamples);
+		}
+		ConvertToSInt16_Scalar(inSource + i, outDestination + i, inNumberSamples - i);
+	}
+
+	__attribute__((target("sse2")))
+	void	Add_SSE2(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples)
+	{
+		UInt32 i = 0;
+		if(IsSampleAligned(ioDestination))
+		{
+			i = GetNumberSamplesToAlign(ioDestination, 16, inNumberSamples);
+			Add_Scalar(inSource, ioDestination, i);
+			for(; i + 8 <= inNumberSamples; i += 8)
+			{
+				_mm_store_ps(ioDestination + i, _mm_add_ps(_mm_load_ps(ioDestination + i), _mm_loadu_ps(inSource + i)));
+				_mm_store_ps(ioDestination + i + 4, _mm_add_ps(_mm_load_ps(ioDestination + i + 4), _mm_loadu_ps(inSource + i + 4)));
+			}
+		}
+		for(; i + 4 <= inNumberSamples; i += 4)
+		{
+			_mm_storeu_ps(ioDestination + i, _mm_add_ps(_mm_loadu_ps(ioDestination + i), _mm_loadu_ps(inSource + i)));
+		}
+		Add_Scalar(inSource + i, ioDestination + i, inNumberSamples - i);
+	}
+
+	//	2 channels at any stride, 4 frames at a time
+	__attribute__((target("sse2")))
+	void	Interleave2_SSE2(const Float32* const* inSources, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			__m128 theLeft = _mm_loadu_ps(inSources[0] + f);
+			__m128 theRight = _mm_loadu_ps(inSources[1] + f);
+			__m128 theFrames01 = _mm_unpacklo_ps(theLeft, theRight);
+			__m128 theFrames23 = _mm_unpackhi_ps(theLeft, theRight);
+			Float32* theDestination = outDestination + f * inDestinationStride;
+			_mm_storel_pi(reinterpret_cast<__m64*>(theDestination), theFrames01);
+			_mm_storeh_pi(reinterpret_cast<__m64*>(theDestination + inDestinationStride), theFrames01);
+			_mm_storel_pi(reinterpret_cast<__m64*>(theDestination + 2 * inDestinationStride), theFrames23);
+			_mm_storeh_pi(reinterpret_cast<__m64*>(theDestination + 3 * inDestinationStride), theFrames23);
+		}
+		Interleave_Scalar(inSources, 2, outDestination, inDestinationStride, f, inNumberFrames);
+	}
+
+	//	4 channels at any stride, a 4 by 4 transpose at a time
+	__attribute__((target("sse2")))
+	void	Interleave4_SSE2(const Float32* const* inSources, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			__m128 theRow0 = _mm_loadu_ps(inSources[0] + f);
+			__m128 theRow1 = _mm_loadu_ps(inSources[1] + f);
+			__m128 theRow2 = _mm_loadu_ps(inSources[2] + f);
+			__m128 theRow3 = _mm_loadu_ps(inSources[3] + f);
+			_MM_TRANSPOSE4_PS(theRow0, theRow1, theRow2, theRow3);
+			Float32* theDestination = outDestination + f * inDestinationStride;
+			_mm_storeu_ps(theDestination, theRow0);
+			_mm_storeu_ps(theDestination + inDestinationStride, theRow1);
+			_mm_storeu_ps(theDestination + 2 * inDestinationStride, theRow2);
+			_mm_storeu_ps(theDestination + 3 * inDestinationStride, theRow3);
+		}
+		Interleave_Scalar(inSources, 4, outDestination, inDestinationStride, f, inNumberFrames);
+	}
+
+	__attribute__((target("sse2")))
+	void	Interleave_SSE2(const Float32* const* inSources, UInt32 inNumberChannels, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		UInt32 c = 0;
+		for(; c + 4 <= inNumberChannels; c += 4)
+		{
+			Interleave4_SSE2(inSources + c, outDestination + c, inDestinationStride, inNumberFrames);
+		}
+		if(c + 2 <= inNumberChannels)
+		{
+			Interleave2_SSE2(inSources + c, outDestination + c, inDestinationStride, inNumberFrames);
+			c += 2;
+		}
+		Interleave_Scalar(inSources + c, inNumberChannels - c, outDestination + c, inDestinationStride, inNumberFrames);
+	}
+
+	__attribute__((target("sse2")))
+	void	Deinterleave2_SSE2(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			__m128 theFrames01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(theSource)), reinterpret_cast<const __m64*>(theSource + inSourceStride));
+			__m128 theFrames23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(theSource + 2 * inSourceStride)), reinterpret_cast<const __m64*>(theSource + 3 * inSourceStride));
+			_mm_storeu_ps(outDestinations[0] + f, _mm_shuffle_ps(theFrames01, theFrames23, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(outDestinations[1] + f, _mm_shuffle_ps(theFrames01, theFrames23, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+		Deinterleave_Scalar(inSource, inSourceStride, outDestinations, 2, f, inNumberFrames);
+	}
+
+	__attribute__((target("sse2")))
+	void	Deinterleave4_SSE2(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			__m128 theRow0 = _mm_loadu_ps(theSource);
+			__m128 theRow1 = _mm_loadu_ps(theSource + inSourceStride);
+			__m128 theRow2 = _mm_loadu_ps(theSource + 2 * inSourceStride);
+			__m128 theRow3 = _mm_loadu_ps(theSource + 3 * inSourceStride);
+			_MM_TRANSPOSE4_PS(theRow0, theRow1, theRow2, theRow3);
+			_mm_storeu_ps(outDestinations[0] + f, theRow0);
+			_mm_storeu_ps(outDestinations[1] + f, theRow1);
+			_mm_storeu_ps(outDestinations[2] + f, theRow2);
+			_mm_storeu_ps(outDestinations[3] + f, theRow3);
+		}
+		Deinterleave_Scalar(inSource, inSourceStride, outDestinations, 4, f, inNumberFrames);
+	}
+
+	__attribute__((target("sse2")))
+	void	Deinterleave_SSE2(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		UInt32 c = 0;
+		for(; c + 4 <= inNumberChannels; c += 4)
+		{
+			Deinterleave4_SSE2(inSource + c, inSourceStride, outDestinations + c, inNumberFrames);
+		}
+		if(c + 2 <= inNumberChannels)
+		{
+			Deinterleave2_SSE2(inSource + c, inSourceStride, outDestinations + c, inNumberFrames);
+			c += 2;
+		}
+		Deinterleave_Scalar(inSource + c, inSourceStride, outDestinations + c, inNumberChannels - c, inNumberFrames);
+	}
+
+	__attribute__((target("sse2")))
+	void	CopyChannels_SSE2(const Float32* inSource, UInt32 inSourceStride, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		if(IsContiguousCopy(inSourceStride, inDestinationStride, inNumberChannels) || (inNumberChannels < 2))
+		{
+			CopyChannels_Scalar(inSource, inSourceStride, outDestination, inDestinationStride, inNumberChannels, inNumberFrames);
+			return;
+		}
+		for(UInt32 f = 0; f < inNumberFrames; ++f)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			Float32* theDestination = outDestination + f * inDestinationStride;
+			UInt32 c = 0;
+			for(; c + 4 <= inNumberChannels; c += 4)
+			{
+				_mm_storeu_ps(theDestination + c, _mm_loadu_ps(theSource + c));
+			}
+			if(c + 2 <= inNumberChannels)
+			{
+				_mm_storel_pi(reinterpret_cast<__m64*>(theDestination + c), _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(theSource + c)));
+				c += 2;
+			}
+			if(c < inNumberChannels)
+			{
+				theDestination[c] = theSource[c];
+			}
+		}
+	}
+}
+
+//==================================================================================================
+//	AVX2 and FMA
+//==================================================================================================
+
+namespace
+{
+	__attribute__((target("avx2,fma")))
+	void	Scale_AVX2(Float32* ioData, UInt32 inNumberSamples, Float32 inGain)
+	{
+		const __m256 theGain = _mm256_set1_ps(inGain);
+		UInt32 i = 0;
+		for(; i + 16 <= inNumberSamples; i += 16)
+		{
+			_mm256_storeu_ps(ioData + i, _mm256_mul_ps(_mm256_loadu_ps(ioData + i), theGain));
+			_mm256_storeu_ps(ioData + i + 8, _mm256_mul_ps(_mm256_loadu_ps(ioData + i + 8), theGain));
+		}
+		Scale_Scalar(ioData + i, inNumberSamples - i, inGain);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	AddScaled_AVX2(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples, Float32 inGain)
+	{
+		const __m256 theGain = _mm256_set1_ps(inGain);
+		UInt32 i = 0;
+		if(IsSampleAligned(ioDestination))
+		{
+			i = GetNumberSamplesToAlign(ioDestination, 32, inNumberSamples);
+			AddScaled_Scalar(inSource, ioDestination, i, inGain);
+			for(; i + 16 <= inNumberSamples; i += 16)
+			{
+				_mm256_store_ps(ioDestination + i, _mm256_fmadd_ps(theGain, _mm256_loadu_ps(inSource + i), _mm256_load_ps(ioDestination + i)));
+				_mm256_store_ps(ioDestination + i + 8, _mm256_fmadd_ps(theGain, _mm256_loadu_ps(inSource + i + 8), _mm256_load_ps(ioDestination + i + 8)));
+			}
+		}
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			_mm256_storeu_ps(ioDestination + i, _mm256_fmadd_ps(theGain, _mm256_loadu_ps(inSource + i), _mm256_loadu_ps(ioDestination + i)));
+		}
+		AddScaled_Scalar(inSource + i, ioDestination + i, inNumberSamples - i, inGain);
+	}
+
+	__attribute__((target("avx2,fma")))
+	Float32	GetPeak_AVX2(const Float32* inData, UInt32 inNumberSamples)
+	{
+		const __m256 theAbsMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+		__m256 thePeak0 = _mm256_setzero_ps(), thePeak1 = _mm256_setzero_ps();
+		UInt32 i = 0;
+		for(; i + 16 <= inNumberSamples; i += 16)
+		{
+			thePeak0 = _mm256_max_ps(thePeak0, _mm256_and_ps(_mm256_loadu_ps(inData + i), theAbsMask));
+			thePeak1 = _mm256_max_ps(thePeak1, _mm256_and_ps(_mm256_loadu_ps(inData + i + 8), theAbsMask));
+		}
+		thePeak0 = _mm256_max_ps(thePeak0, thePeak1);
+		__m128 thePeak = _mm_max_ps(_mm256_castps256_ps128(thePeak0), _mm256_extractf128_ps(thePeak0, 1));
+		thePeak = _mm_max_ps(thePeak, _mm_shuffle_ps(thePeak, thePeak, _MM_SHUFFLE(1, 0, 3, 2)));
+		thePeak = _mm_max_ps(thePeak, _mm_shuffle_ps(thePeak, thePeak, _MM_SHUFFLE(2, 3, 0, 1)));
+		return GetPeak_Scalar(inData + i, inNumberSamples - i, _mm_cvtss_f32(thePeak));
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	ConvertToSInt16_AVX2(const Float32* inSource, SInt16* outDestination, UInt32 inNumberSamples)
+	{
+		const __m256 theScale = _mm256_set1_ps(32767.0f);
+		const __m256 theMinimum = _mm256_set1_ps(-32768.0f);
+		const __m256 theMaximum = _mm256_set1_ps(32767.0f);
+		UInt32 i = 0;
+		for(; i + 16 <= inNumberSamples; i += 16)
+		{
+			__m256 theValues0 = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(inSource + i), theScale), theMinimum), theMaximum);
+			__m256 theValues1 = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(inSource + i + 8), theScale), theMinimum), theMaximum);
+			//	the pack works within 128 bit lanes, the permute puts the four quarters back in order
+			__m256i theSamples = _mm256_packs_epi32(_mm256_cvtps_epi32(theValues0), _mm256_cvtps_epi32(theValues1));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(outDestination + i), _mm256_permute4x64_epi64(theSamples, _MM_SHUFFLE(3, 1, 2, 0)));
+		}
+		ConvertToSInt16_Scalar(inSource + i, outDestination + i, inNumberSamples - i);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	Add_AVX2(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples)
+	{
+		UInt32 i = 0;
+		if(IsSampleAligned(ioDestination))
+		{
+			i = GetNumberSamplesToAlign(ioDestination, 32, inNumberSamples);
+			Add_Scalar(inSource, ioDestination, i);
+			for(; i + 16 <= inNumberSamples; i += 16)
+			{
+				_mm256_store_ps(ioDestination + i, _mm256_add_ps(_mm256_load_ps(ioDestination + i), _mm256_loadu_ps(inSource + i)));
+				_mm256_store_ps(ioDestination + i + 8, _mm256_add_ps(_mm256_load_ps(ioDestination + i + 8), _mm256_loadu_ps(inSource + i + 8)));
+			}
+		}
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			_mm256_storeu_ps(ioDestination + i, _mm256_add_ps(_mm256_loadu_ps(ioDestination + i), _mm256_loadu_ps(inSource + i)));
+		}
+		Add_Scalar(inSource + i, ioDestination + i, inNumberSamples - i);
+	}
+
+	//	turns 8 rows of 8 into 8 columns of 8, in the unpack, shuffle and swap lanes steps
+	__attribute__((target("avx2,fma")))
+	inline void	Transpose8x8(__m256& ioRow0, __m256& ioRow1, __m256& ioRow2, __m256& ioRow3, __m256& ioRow4, __m256& ioRow5, __m256& ioRow6, __m256& ioRow7)
+	{
+		__m256 theUnpacked0 = _mm256_unpacklo_ps(ioRow0, ioRow1);
+		__m256 theUnpacked1 = _mm256_unpackhi_ps(ioRow0, ioRow1);
+		__m256 theUnpacked2 = _mm256_unpacklo_ps(ioRow2, ioRow3);
+		__m256 theUnpacked3 = _mm256_unpackhi_ps(ioRow2, ioRow3);
+		__m256 theUnpacked4 = _mm256_unpacklo_ps(ioRow4, ioRow5);
+		__m256 theUnpacked5 = _mm256_unpackhi_ps(ioRow4, ioRow5);
+		__m256 theUnpacked6 = _mm256_unpacklo_ps(ioRow6, ioRow7);
+		__m256 theUnpacked7 = _mm256_unpackhi_ps(ioRow6, ioRow7);
+		__m256 theShuffled0 = _mm256_shuffle_ps(theUnpacked0, theUnpacked2, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 theShuffled1 = _mm256_shuffle_ps(theUnpacked0, theUnpacked2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 theShuffled2 = _mm256_shuffle_ps(theUnpacked1, theUnpacked3, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 theShuffled3 = _mm256_shuffle_ps(theUnpacked1, theUnpacked3, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 theShuffled4 = _mm256_shuffle_ps(theUnpacked4, theUnpacked6, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 theShuffled5 = _mm256_shuffle_ps(theUnpacked4, theUnpacked6, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 theShuffled6 = _mm256_shuffle_ps(theUnpacked5, theUnpacked7, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 theShuffled7 = _mm256_shuffle_ps(theUnpacked5, theUnpacked7, _MM_SHUFFLE(3, 2, 3, 2));
+		ioRow0 = _mm256_permute2f128_ps(theShuffled0, theShuffled4, 0x20);
+		ioRow1 = _mm256_permute2f128_ps(theShuffled1, theShuffled5, 0x20);
+		ioRow2 = _mm256_permute2f128_ps(theShuffled2, theShuffled6, 0x20);
+		ioRow3 = _mm256_permute2f128_ps(theShuffled3, theShuffled7, 0x20);
+		ioRow4 = _mm256_permute2f128_ps(theShuffled0, theShuffled4, 0x31);
+		ioRow5 = _mm256_permute2f128_ps(theShuffled1, theShuffled5, 0x31);
+		ioRow6 = _mm256_permute2f128_ps(theShuffled2, theShuffled6, 0x31);
+		ioRow7 = _mm256_permute2f128_ps(theShuffled3, theShuffled7, 0x31);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	Interleave8_AVX2(const Float32* const* inSources, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 8 <= inNumberFrames; f += 8)
+		{
+			__m256 theRow0 = _mm256_loadu_ps(inSources[0] + f);
+			__m256 theRow1 = _mm256_loadu_ps(inSources[1] + f);
+			__m256 theRow2 = _mm256_loadu_ps(inSources[2] + f);
+			__m256 theRow3 = _mm256_loadu_ps(inSources[3] + f);
+			__m256 theRow4 = _mm256_loadu_ps(inSources[4] + f);
+			__m256 theRow5 = _mm256_loadu_ps(inSources[5] + f);
+			__m256 theRow6 = _mm256_loadu_ps(inSources[6] + f);
+			__m256 theRow7 = _mm256_loadu_ps(inSources[7] + f);
+			Transpose8x8(theRow0, theRow1, theRow2, theRow3, theRow4, theRow5, theRow6, theRow7);
+			Float32* theDestination = outDestination + f * inDestinationStride;
+			_mm256_storeu_ps(theDestination, theRow0);
+			_mm256_storeu_ps(theDestination + inDestinationStride, theRow1);
+			_mm256_storeu_ps(theDestination + 2 * inDestinationStride, theRow2);
+			_mm256_storeu_ps(theDestination + 3 * inDestinationStride, theRow3);
+			_mm256_storeu_ps(theDestination + 4 * inDestinationStride, theRow4);
+			_mm256_storeu_ps(theDestination + 5 * inDestinationStride, theRow5);
+			_mm256_storeu_ps(theDestination + 6 * inDestinationStride, theRow6);
+			_mm256_storeu_ps(theDestination + 7 * inDestinationStride, theRow7);
+		}
+		Interleave_Scalar(inSources, 8, outDestination, inDestinationStride, f, inNumberFrames);
+	}
+
+	//	the packed stereo case, 8 frames at a time
+	__attribute__((target("avx2,fma")))
+	void	Interleave2_AVX2(const Float32* const* inSources, Float32* outDestination, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 8 <= inNumberFrames; f += 8)
+		{
+			__m256 theLeft = _mm256_loadu_ps(inSources[0] + f);
+			__m256 theRight = _mm256_loadu_ps(inSources[1] + f);
+			//	the unpacks work within 128 bit lanes, frames 0, 1, 4, 5 and 2, 3, 6, 7
+			__m256 theLow = _mm256_unpacklo_ps(theLeft, theRight);
+			__m256 theHigh = _mm256_unpackhi_ps(theLeft, theRight);
+			_mm256_storeu_ps(outDestination + 2 * f, _mm256_permute2f128_ps(theLow, theHigh, 0x20));
+			_mm256_storeu_ps(outDestination + 2 * f + 8, _mm256_permute2f128_ps(theLow, theHigh, 0x31));
+		}
+		Interleave_Scalar(inSources, 2, outDestination, 2, f, inNumberFrames);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	Interleave_AVX2(const Float32* const* inSources, UInt32 inNumberChannels, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		if((inNumberChannels == 2) && (inDestinationStride == 2))
+		{
+			Interleave2_AVX2(inSources, outDestination, inNumberFrames);
+			return;
+		}
+		UInt32 c = 0;
+		for(; c + 8 <= inNumberChannels; c += 8)
+		{
+			Interleave8_AVX2(inSources + c, outDestination + c, inDestinationStride, inNumberFrames);
+		}
+		Interleave_SSE2(inSources + c, inNumberChannels - c, outDestination + c, inDestinationStride, inNumberFrames);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	Deinterleave8_AVX2(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 8 <= inNumberFrames; f += 8)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			__m256 theRow0 = _mm256_loadu_ps(theSource);
+			__m256 theRow1 = _mm256_loadu_ps(theSource + inSourceStride);
+			__m256 theRow2 = _mm256_loadu_ps(theSource + 2 * inSourceStride);
+			__m256 theRow3 = _mm256_loadu_ps(theSource + 3 * inSourceStride);
+			__m256 theRow4 = _mm256_loadu_ps(theSource + 4 * inSourceStride);
+			__m256 theRow5 = _mm256_loadu_ps(theSource + 5 * inSourceStride);
+			__m256 theRow6 = _mm256_loadu_ps(theSource + 6 * inSourceStride);
+			__m256 theRow7 = _mm256_loadu_ps(theSource + 7 * inSourceStride);
+			Transpose8x8(theRow0, theRow1, theRow2, theRow3, theRow4, theRow5, theRow6, theRow7);
+			_mm256_storeu_ps(outDestinations[0] + f, theRow0);
+			_mm256_storeu_ps(outDestinations[1] + f, theRow1);
+			_mm256_storeu_ps(outDestinations[2] + f, theRow2);
+			_mm256_storeu_ps(outDestinations[3] + f, theRow3);
+			_mm256_storeu_ps(outDestinations[4] + f, theRow4);
+			_mm256_storeu_ps(outDestinations[5] + f, theRow5);
+			_mm256_storeu_ps(outDestinations[6] + f, theRow6);
+			_mm256_storeu_ps(outDestinations[7] + f, theRow7);
+		}
+		Deinterleave_Scalar(inSource, inSourceStride, outDestinations, 8, f, inNumberFrames);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	Deinterleave2_AVX2(const Float32* inSource, Float32* const* outDestinations, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 8 <= inNumberFrames; f += 8)
+		{
+			__m256 theFrames0123 = _mm256_loadu_ps(inSource + 2 * f);
+			__m256 theFrames4567 = _mm256_loadu_ps(inSource + 2 * f + 8);
+			//	frames 0, 1, 4, 5 and 2, 3, 6, 7, so the shuffles within the lanes come out in order
+			__m256 theLow = _mm256_permute2f128_ps(theFrames0123, theFrames4567, 0x20);
+			__m256 theHigh = _mm256_permute2f128_ps(theFrames0123, theFrames4567, 0x31);
+			_mm256_storeu_ps(outDestinations[0] + f, _mm256_shuffle_ps(theLow, theHigh, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm256_storeu_ps(outDestinations[1] + f, _mm256_shuffle_ps(theLow, theHigh, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+		Deinterleave_Scalar(inSource, 2, outDestinations, 2, f, inNumberFrames);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	Deinterleave_AVX2(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		if((inNumberChannels == 2) && (inSourceStride == 2))
+		{
+			Deinterleave2_AVX2(inSource, outDestinations, inNumberFrames);
+			return;
+		}
+		UInt32 c = 0;
+		for(; c + 8 <= inNumberChannels; c += 8)
+		{
+			Deinterleave8_AVX2(inSource + c, inSourceStride, outDestinations + c, inNumberFrames);
+		}
+		Deinterleave_SSE2(inSource + c, inSourceStride, outDestinations + c, inNumberChannels - c, inNumberFrames);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void	CopyChannels_AVX2(const Float32* inSource, UInt32 inSourceStride, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		if(IsContiguousCopy(inSourceStride, inDestinationStride, inNumberChannels) || (inNumberChannels < 8))
+		{
+			CopyChannels_SSE2(inSource, inSourceStride, outDestination, inDestinationStride, inNumberChannels, inNumberFrames);
+			return;
+		}
+		UInt32 theNumberWideChannels = inNumberChannels & ~7U;
+		for(UInt32 f = 0; f < inNumberFrames; ++f)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			Float32* theDestination = outDestination + f * inDestinationStride;
+			for(UInt32 c = 0; c < theNumberWideChannels; c += 8)
+			{
+				_mm256_storeu_ps(theDestination + c, _mm256_loadu_ps(theSource + c));
+			}
+		}
+		CopyChannels_SSE2(inSource + theNumberWideChannels, inSourceStride, outDestination + theNumberWideChannels, inDestinationStride, inNumberChannels - theNumberWideChannels, inNumberFrames);
+	}
+}
+
+//==================================================================================================
+//	AVX-512
+//
+//	The tails are done with masked loads and stores instead of the scalar loop.
+//==================================================================================================
+
+namespace
+{
+	__attribute__((target("avx512f")))
+	inline __mmask16	TailMask(UInt32 inNumberSamples)
+	{
+		return static_cast<__mmask16>((1U << inNumberSamples) - 1);
+	}
+
+	__attribute__((target("avx512f")))
+	void	Scale_AVX512(Float32* ioData, UInt32 inNumberSamples, Float32 inGain)
+	{
+		const __m512 theGain = _mm512_set1_ps(inGain);
+		UInt32 i = 0;
+		for(; i + 32 <= inNumberSamples; i += 32)
+		{
+			_mm512_storeu_ps(ioData + i, _mm512_mul_ps(_mm512_loadu_ps(ioData + i), theGain));
+			_mm512_storeu_ps(ioData + i + 16, _mm512_mul_ps(_mm512_loadu_ps(ioData + i + 16), theGain));
+		}
+		for(; i < inNumberSamples; i += 16)
+		{
+			__mmask16 theMask = (inNumberSamples - i >= 16) ? 0xFFFF : TailMask(inNumberSamples - i);
+			_mm512_mask_storeu_ps(ioData + i, theMask, _mm512_mul_ps(_mm512_maskz_loadu_ps(theMask, ioData + i), theGain));
+		}
+	}
+
+	__attribute__((target("avx512f")))
+	void	AddScaled_AVX512(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples, Float32 inGain)
+	{
+		const __m512 theGain = _mm512_set1_ps(inGain);
+		UInt32 i = 0;
+		if(IsSampleAligned(ioDestination))
+		{
+			i = GetNumberSamplesToAlign(ioDestination, 64, inNumberSamples);
+			if(i > 0)
+			{
+				__mmask16 theMask = TailMask(i);
+				__m512 theSum = _mm512_fmadd_ps(theGain, _mm512_maskz_loadu_ps(theMask, inSource), _mm512_maskz_loadu_ps(theMask, ioDestination));
+				_mm512_mask_storeu_ps(ioDestination, theMask, theSum);
+			}
+			for(; i + 32 <= inNumberSamples; i += 32)
+			{
+				_mm512_store_ps(ioDestination + i, _mm512_fmadd_ps(theGain, _mm512_loadu_ps(inSource + i), _mm512_load_ps(ioDestination + i)));
+				_mm512_store_ps(ioDestination + i + 16, _mm512_fmadd_ps(theGain, _mm512_loadu_ps(inSource + i + 16), _mm512_load_ps(ioDestination + i + 16)));
+			}
+		}
+		for(; i < inNumberSamples; i += 16)
+		{
+			__mmask16 theMask = (inNumberSamples - i >= 16) ? 0xFFFF : TailMask(inNumberSamples - i);
+			__m512 theSum = _mm512_fmadd_ps(theGain, _mm512_maskz_loadu_ps(theMask, inSource + i), _mm512_maskz_loadu_ps(theMask, ioDestination + i));
+			_mm512_mask_storeu_ps(ioDestination + i, theMask, theSum);
+		}
+	}
+
+	__attribute__((target("avx512f")))
+	Float32	GetPeak_AVX512(const Float32* inData, UInt32 inNumberSamples)
+	{
+		__m512 thePeak0 = _mm512_setzero_ps(), thePeak1 = _mm512_setzero_ps();
+		UInt32 i = 0;
+		for(; i + 32 <= inNumberSamples; i += 32)
+		{
+			thePeak0 = _mm512_max_ps(thePeak0, _mm512_abs_ps(_mm512_loadu_ps(inData + i)));
+			thePeak1 = _mm512_max_ps(thePeak1, _mm512_abs_ps(_mm512_loadu_ps(inData + i + 16)));
+		}
+		for(; i < inNumberSamples; i += 16)
+		{
+			//	the masked off lanes load as 0, which never raises the peak
+			__mmask16 theMask = (inNumberSamples - i >= 16) ? 0xFFFF : TailMask(inNumberSamples - i);
+			thePeak0 = _mm512_max_ps(thePeak0, _mm512_abs_ps(_mm512_maskz_loadu_ps(theMask, inData + i)));
+		}
+		return _mm512_reduce_max_ps(_mm512_max_ps(thePeak0, thePeak1));
+	}
+
+	__attribute__((target("avx512f")))
+	void	ConvertToSInt16_AVX512(const Float32* inSource, SInt16* outDestination, UInt32 inNumberSamples)
+	{
+		const __m512 theScale = _mm512_set1_ps(32767.0f);
+		const __m512 theMinimum = _mm512_set1_ps(-32768.0f);
+		const __m512 theMaximum = _mm512_set1_ps(32767.0f);
+		for(UInt32 i = 0; i < inNumberSamples; i += 16)
+		{
+			__mmask16 theMask = (inNumberSamples - i >= 16) ? 0xFFFF : TailMask(inNumberSamples - i);
+			__m512 theValues = _mm512_min_ps(_mm512_max_ps(_mm512_mul_ps(_mm512_maskz_loadu_ps(theMask, inSource + i), theScale), theMinimum), theMaximum);
+			_mm512_mask_cvtsepi32_storeu_epi16(outDestination + i, theMask, _mm512_cvtps_epi32(theValues));
+		}
+	}
+
+	__attribute__((target("avx512f")))
+	void	Add_AVX512(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples)
+	{
+		UInt32 i = 0;
+		if(IsSampleAligned(ioDestination))
+		{
+			//	a masked first vector up to the boundary, full cache lines from there
+			i = GetNumberSamplesToAlign(ioDestination, 64, inNumberSamples);
+			if(i > 0)
+			{
+				__mmask16 theMask = TailMask(i);
+				_mm512_mask_storeu_ps(ioDestination, theMask, _mm512_add_ps(_mm512_maskz_loadu_ps(theMask, ioDestination), _mm512_maskz_loadu_ps(theMask, inSource)));
+			}
+			for(; i + 32 <= inNumberSamples; i += 32)
+			{
+				_mm512_store_ps(ioDestination + i, _mm512_add_ps(_mm512_load_ps(ioDestination + i), _mm512_loadu_ps(inSource + i)));
+				_mm512_store_ps(ioDestination + i + 16, _mm512_add_ps(_mm512_load_ps(ioDestination + i + 16), _mm512_loadu_ps(inSource + i + 16)));
+			}
+		}
+		for(; i < inNumberSamples; i += 16)
+		{
+			__mmask16 theMask = (inNumberSamples - i >= 16) ? 0xFFFF : TailMask(inNumberSamples - i);
+			_mm512_mask_storeu_ps(ioDestination + i, theMask, _mm512_add_ps(_mm512_maskz_loadu_ps(theMask, ioDestination + i), _mm512_maskz_loadu_ps(theMask, inSource + i)));
+		}
+	}
+}
+
+#endif	//	CAVectorKernels_Use_X86
+
+#if CAVectorKernels_Use_Neon
+
+//==================================================================================================
+//	Neon
+//==================================================================================================
+
+namespace
+{
+	void	Scale_Neon(Float32* ioData, UInt32 inNumberSamples, Float32 inGain)
+	{
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			vst1q_f32(ioData + i, vmulq_n_f32(vld1q_f32(ioData + i), inGain));
+			vst1q_f32(ioData + i + 4, vmulq_n_f32(vld1q_f32(ioData + i + 4), inGain));
+		}
+		Scale_Scalar(ioData + i, inNumberSamples - i, inGain);
+	}
+
+	void	AddScaled_Neon(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples, Float32 inGain)
+	{
+		const float32x4_t theGain = vdupq_n_f32(inGain);
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			vst1q_f32(ioDestination + i, vfmaq_f32(vld1q_f32(ioDestination + i), theGain, vld1q_f32(inSource + i)));
+			vst1q_f32(ioDestination + i + 4, vfmaq_f32(vld1q_f32(ioDestination + i + 4), theGain, vld1q_f32(inSource + i + 4)));
+		}
+		AddScaled_Scalar(inSource + i, ioDestination + i, inNumberSamples - i, inGain);
+	}
+
+	Float32	GetPeak_Neon(const Float32* inData, UInt32 inNumberSamples)
+	{
+		float32x4_t thePeak0 = vdupq_n_f32(0.0f), thePeak1 = vdupq_n_f32(0.0f);
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			thePeak0 = vmaxq_f32(thePeak0, vabsq_f32(vld1q_f32(inData + i)));
+			thePeak1 = vmaxq_f32(thePeak1, vabsq_f32(vld1q_f32(inData + i + 4)));
+		}
+		return GetPeak_Scalar(inData + i, inNumberSamples - i, vmaxvq_f32(vmaxq_f32(thePeak0, thePeak1)));
+	}
+
+	void	ConvertToSInt16_Neon(const Float32* inSource, SInt16* outDestination, UInt32 inNumberSamples)
+	{
+		const float32x4_t theMinimum = vdupq_n_f32(-32768.0f);
+		const float32x4_t theMaximum = vdupq_n_f32(32767.0f);
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			float32x4_t theValues0 = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(inSource + i), 32767.0f), theMinimum), theMaximum);
+			float32x4_t theValues1 = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(inSource + i + 4), 32767.0f), theMinimum), theMaximum);
+			vst1q_s16(outDestination + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(theValues0)), vqmovn_s32(vcvtnq_s32_f32(theValues1))));
+		}
+		ConvertToSInt16_Scalar(inSource + i, outDestination + i, inNumberSamples - i);
+	}
+
+	void	Add_Neon(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples)
+	{
+		UInt32 i = 0;
+		for(; i + 8 <= inNumberSamples; i += 8)
+		{
+			vst1q_f32(ioDestination + i, vaddq_f32(vld1q_f32(ioDestination + i), vld1q_f32(inSource + i)));
+			vst1q_f32(ioDestination + i + 4, vaddq_f32(vld1q_f32(ioDestination + i + 4), vld1q_f32(inSource + i + 4)));
+		}
+		Add_Scalar(inSource + i, ioDestination + i, inNumberSamples - i);
+	}
+
+	void	Interleave2_Neon(const Float32* const* inSources, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			float32x4x2_t theFrames = vzipq_f32(vld1q_f32(inSources[0] + f), vld1q_f32(inSources[1] + f));
+			if(inDestinationStride == 2)
+			{
+				vst1q_f32(outDestination + 2 * f, theFrames.val[0]);
+				vst1q_f32(outDestination + 2 * f + 4, theFrames.val[1]);
+			}
+			else
+			{
+				Float32* theDestination = outDestination + f * inDestinationStride;
+				vst1_f32(theDestination, vget_low_f32(theFrames.val[0]));
+				vst1_f32(theDestination + inDestinationStride, vget_high_f32(theFrames.val[0]));
+				vst1_f32(theDestination + 2 * inDestinationStride, vget_low_f32(theFrames.val[1]));
+				vst1_f32(theDestination + 3 * inDestinationStride, vget_high_f32(theFrames.val[1]));
+			}
+		}
+		Interleave_Scalar(inSources, 2, outDestination, inDestinationStride, f, inNumberFrames);
+	}
+
+	//	a 4 by 4 transpose, two element transposes and then the halves
+	inline void	Transpose4x4(float32x4_t& ioRow0, float32x4_t& ioRow1, float32x4_t& ioRow2, float32x4_t& ioRow3)
+	{
+		float32x4x2_t theLow = vtrnq_f32(ioRow0, ioRow1);
+		float32x4x2_t theHigh = vtrnq_f32(ioRow2, ioRow3);
+		ioRow0 = vcombine_f32(vget_low_f32(theLow.val[0]), vget_low_f32(theHigh.val[0]));
+		ioRow1 = vcombine_f32(vget_low_f32(theLow.val[1]), vget_low_f32(theHigh.val[1]));
+		ioRow2 = vcombine_f32(vget_high_f32(theLow.val[0]), vget_high_f32(theHigh.val[0]));
+		ioRow3 = vcombine_f32(vget_high_f32(theLow.val[1]), vget_high_f32(theHigh.val[1]));
+	}
+
+	void	Interleave4_Neon(const Float32* const* inSources, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			float32x4_t theRow0 = vld1q_f32(inSources[0] + f);
+			float32x4_t theRow1 = vld1q_f32(inSources[1] + f);
+			float32x4_t theRow2 = vld1q_f32(inSources[2] + f);
+			float32x4_t theRow3 = vld1q_f32(inSources[3] + f);
+			Transpose4x4(theRow0, theRow1, theRow2, theRow3);
+			Float32* theDestination = outDestination + f * inDestinationStride;
+			vst1q_f32(theDestination, theRow0);
+			vst1q_f32(theDestination + inDestinationStride, theRow1);
+			vst1q_f32(theDestination + 2 * inDestinationStride, theRow2);
+			vst1q_f32(theDestination + 3 * inDestinationStride, theRow3);
+		}
+		Interleave_Scalar(inSources, 4, outDestination, inDestinationStride, f, inNumberFrames);
+	}
+
+	void	Interleave_Neon(const Float32* const* inSources, UInt32 inNumberChannels, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames)
+	{
+		UInt32 c = 0;
+		for(; c + 4 <= inNumberChannels; c += 4)
+		{
+			Interleave4_Neon(inSources + c, outDestination + c, inDestinationStride, inNumberFrames);
+		}
+		if(c + 2 <= inNumberChannels)
+		{
+			Interleave2_Neon(inSources + c, outDestination + c, inDestinationStride, inNumberFrames);
+			c += 2;
+		}
+		Interleave_Scalar(inSources + c, inNumberChannels - c, outDestination + c, inDestinationStride, inNumberFrames);
+	}
+
+	void	Deinterleave2_Neon(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			float32x4_t theFrames01 = vcombine_f32(vld1_f32(theSource), vld1_f32(theSource + inSourceStride));
+			float32x4_t theFrames23 = vcombine_f32(vld1_f32(theSource + 2 * inSourceStride), vld1_f32(theSource + 3 * inSourceStride));
+			float32x4x2_t theChannels = vuzpq_f32(theFrames01, theFrames23);
+			vst1q_f32(outDestinations[0] + f, theChannels.val[0]);
+			vst1q_f32(outDestinations[1] + f, theChannels.val[1]);
+		}
+		Deinterleave_Scalar(inSource, inSourceStride, outDestinations, 2, f, inNumberFrames);
+	}
+
+	void	Deinterleave4_Neon(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberFrames)
+	{
+		UInt32 f = 0;
+		for(; f + 4 <= inNumberFrames; f += 4)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			float32x4_t theRow0 = vld1q_f32(theSource);
+			float32x4_t theRow1 = vld1q_f32(theSource + inSourceStride);
+			float32x4_t theRow2 = vld1q_f32(theSource + 2 * inSourceStride);
+			float32x4_t theRow3 = vld1q_f32(theSource + 3 * inSourceStride);
+			Transpose4x4(theRow0, theRow1, theRow2, theRow3);
+			vst1q_f32(outDestinations[0] + f, theRow0);
+			vst1q_f32(outDestinations[1] + f, theRow1);
+			vst1q_f32(outDestinations[2] + f, theRow2);
+			vst1q_f32(outDestinations[3] + f, theRow3);
+		}
+		Deinterleave_Scalar(inSource, inSourceStride, outDestinations, 4, f, inNumberFrames);
+	}
+
+	void	Deinterleave_Neon(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		UInt32 c = 0;
+		for(; c + 4 <= inNumberChannels; c += 4)
+		{
+			Deinterleave4_Neon(inSource + c, inSourceStride, outDestinations + c, inNumberFrames);
+		}
+		if(c + 2 <= inNumberChannels)
+		{
+			Deinterleave2_Neon(inSource + c, inSourceStride, outDestinations + c, inNumberFrames);
+			c += 2;
+		}
+		Deinterleave_Scalar(inSource + c, inSourceStride, outDestinations + c, inNumberChannels - c, inNumberFrames);
+	}
+
+	void	CopyChannels_Neon(const Float32* inSource, UInt32 inSourceStride, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberChannels, UInt32 inNumberFrames)
+	{
+		if(IsContiguousCopy(inSourceStride, inDestinationStride, inNumberChannels) || (inNumberChannels < 2))
+		{
+			CopyChannels_Scalar(inSource, inSourceStride, outDestination, inDestinationStride, inNumberChannels, inNumberFrames);
+			return;
+		}
+		for(UInt32 f = 0; f < inNumberFrames; ++f)
+		{
+			const Float32* theSource = inSource + f * inSourceStride;
+			Float32* theDestination = outDestination + f * inDestinationStride;
+			UInt32 c = 0;
+			for(; c + 4 <= inNumberChannels; c += 4)
+			{
+				vst1q_f32(theDestination + c, vld1q_f32(theSource + c));
+			}
+			if(c + 2 <= inNumberChannels)
+			{
+				vst1_f32(theDestination + c, vld1_f32(theSource + c));
+				c += 2;
+			}
+			if(c < inNumberChannels)
+			{
+				theDestination[c] = theSource[c];
+			}
+		}
+	}
+}
+
+#endif	//	CAVectorKernels_Use_Neon
+
+//==================================================================================================
+//	CAVectorKernels
+//==================================================================================================
+
+namespace
+{
+	const CAVectorDispatch<CAVectorKernels::ScaleFunction>::Implementation kScaleImplementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX-512", CAVectorKernels::kTier_AVX512, Scale_AVX512 },
+		{ "AVX2", CAVectorKernels::kTier_AVX2, Scale_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, Scale_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, Scale_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, Scale_Scalar }
+	};
+
+	const CAVectorDispatch<CAVectorKernels::AddFunction>::Implementation kAddImplementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX-512", CAVectorKernels::kTier_AVX512, Add_AVX512 },
+		{ "AVX2", CAVectorKernels::kTier_AVX2, Add_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, Add_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, Add_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, Add_Scalar }
+	};
+
+	const CAVectorDispatch<CAVectorKernels::AddScaledFunction>::Implementation kAddScaledImplementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX-512", CAVectorKernels::kTier_AVX512, AddScaled_AVX512 },
+		{ "AVX2", CAVectorKernels::kTier_AVX2, AddScaled_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, AddScaled_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, AddScaled_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, AddScaled_Scalar }
+	};
+
+	const CAVectorDispatch<CAVectorKernels::GetPeakFunction>::Implementation kGetPeakImplementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX-512", CAVectorKernels::kTier_AVX512, GetPeak_AVX512 },
+		{ "AVX2", CAVectorKernels::kTier_AVX2, GetPeak_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, GetPeak_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, GetPeak_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, GetPeak_Scalar }
+	};
+
+	const CAVectorDispatch<CAVectorKernels::ConvertToSInt16Function>::Implementation kConvertToSInt16Implementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX-512", CAVectorKernels::kTier_AVX512, ConvertToSInt16_AVX512 },
+		{ "AVX2", CAVectorKernels::kTier_AVX2, ConvertToSInt16_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, ConvertToSInt16_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, ConvertToSInt16_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, ConvertToSInt16_Scalar }
+	};
+
+	const CAVectorDispatch<CAVectorKernels::InterleaveFunction>::Implementation kInterleaveImplementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX2", CAVectorKernels::kTier_AVX2, Interleave_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, Interleave_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, Interleave_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, Interleave_Scalar }
+	};
+
+	const CAVectorDispatch<CAVectorKernels::DeinterleaveFunction>::Implementation kDeinterleaveImplementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX2", CAVectorKernels::kTier_AVX2, Deinterleave_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, Deinterleave_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, Deinterleave_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, Deinterleave_Scalar }
+	};
+
+	const CAVectorDispatch<CAVectorKernels::CopyChannelsFunction>::Implementation kCopyChannelsImplementations[] =
+	{
+	#if CAVectorKernels_Use_X86
+		{ "AVX2", CAVectorKernels::kTier_AVX2, CopyChannels_AVX2 },
+		{ "SSE2", CAVectorKernels::kTier_SSE2, CopyChannels_SSE2 },
+	#elif CAVectorKernels_Use_Neon
+		{ "Neon", CAVectorKernels::kTier_Neon, CopyChannels_Neon },
+	#endif
+		{ "Scalar", CAVectorKernels::kTier_Scalar, CopyChannels_Scalar }
+	};
+}
+
+CAVectorDispatch<CAVectorKernels::ScaleFunction>			CAVectorKernels::sScale("Scale", kScaleImplementations);
+CAVectorDispatch<CAVectorKernels::AddFunction>				CAVectorKernels::sAdd("Add", kAddImplementations);
+CAVectorDispatch<CAVectorKernels::AddScaledFunction>		CAVectorKernels::sAddScaled("AddScaled", kAddScaledImplementations);
+CAVectorDispatch<CAVectorKernels::GetPeakFunction>			CAVectorKernels::sGetPeak("GetPeak", kGetPeakImplementations);
+CAVectorDispatch<CAVectorKernels::ConvertToSInt16Function>	CAVectorKernels::sConvertToSInt16("ConvertToSInt16", kConvertToSInt16Implementations);
+CAVectorDispatch<CAVectorKernels::InterleaveFunction>		CAVectorKernels::sInterleave("Interleave", kInterleaveImplementations);
+CAVectorDispatch<CAVectorKernels::DeinterleaveFunction>		CAVectorKernels::sDeinterleave("Deinterleave", kDeinterleaveImplementations);
+CAVectorDispatch<CAVectorKernels::CopyChannelsFunction>		CAVectorKernels::sCopyChannels("CopyChannels", kCopyChannelsImplementations);
+
+const char*	CAVectorKernels::GetImplementationName(Kernel inKernel)
+{
+	const char* theAnswer = NULL;
+	switch(inKernel)
+	{
+		case kKernel_Scale:
+			theAnswer = sScale.GetImplementationName();
+			break;
+		case kKernel_Add:
+			theAnswer = sAdd.GetImplementationName();
+			break;
+		case kKernel_AddScaled:
+			theAnswer = sAddScaled.GetImplementationName();
+			break;
+		case kKernel_GetPeak:
+			theAnswer = sGetPeak.GetImplementationName();
+			break;
+		case kKernel_ConvertToSInt16:
+			theAnswer = sConvertToSInt16.GetImplementationName();
+			break;
+		case kKernel_Interleave:
+			theAnswer = sInterleave.GetImplementationName();
+			break;
+		case kKernel_Deinterleave:
+			theAnswer = sDeinterleave.GetImplementationName();
+			break;
+		case kKernel_CopyChannels:
+			theAnswer = sCopyChannels.GetImplementationName();
+			break;
+	};
+	return theAnswer;
+}
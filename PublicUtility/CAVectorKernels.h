@@ -0,0 +1,141 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#if !defined(__CAVectorKernels_h__)
+#define __CAVectorKernels_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+//	PublicUtility Includes
+#include "CAVectorUnit.h"
+
+/*==================================================================================================
+	CAVectorKernels
+
+	The small DSP loops the IO path runs over whole buffers: gain, mixing, metering and conversion.
+	Each one has an implementation per instruction set tier, AVX-512, AVX2 with FMA and SSE2 on x86
+	and Neon on ARM, plus a scalar one, and goes through a CAVectorDispatch. So the first call picks
+	the best tier the CPU has and every call after that is one indirect call. The tiers can be
+	forced with CAVectorUnit::SetFeatureMask.
+
+	None of them need aligned buffers. The mixing kernels work their way up to an aligned
+	destination and go faster from there, which is free for the buffers from CABufferPool. Mixing
+	with a gain is fused on the tiers that have FMA, so it can differ from the scalar result in the
+	last bit. The others give the same result on every tier, except for NaNs, which come out
+	unspecified.
+
+	The interleaving kernels transpose blocks of 4 or 8 channels at a time and have their own paths
+	for 2 channels, so any number of channels is fast, and 2, 4 and 8 a bit faster. Neon works in
+	blocks of 4 and 2 channels. What is left over after the blocks is done in scalar code.
+==================================================================================================*/
+
+class CAVectorKernels
+{
+
+#pragma mark Types
+public:
+	enum Kernel
+	{
+		kKernel_Scale,
+		kKernel_Add,
+		kKernel_AddScaled,
+		kKernel_GetPeak,
+		kKernel_ConvertToSInt16,
+		kKernel_Interleave,
+		kKernel_Deinterleave,
+		kKernel_CopyChannels
+	};
+
+	//	the features each tier needs
+	enum
+	{
+		kTier_Scalar	= 0,
+		kTier_SSE2		= kVecFeature_SSE2,
+		kTier_AVX2		= kVecFeature_AVX | kVecFeature_AVX2 | kVecFeature_FMA,
+		kTier_AVX512	= kVecFeature_AVX512F | kTier_AVX2,
+		kTier_Neon		= kVecFeature_Neon
+	};
+
+	typedef void						(*ScaleFunction)(Float32* ioData, UInt32 inNumberSamples, Float32 inGain);
+	typedef void						(*AddFunction)(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples);
+	typedef void						(*AddScaledFunction)(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples, Float32 inGain);
+	typedef Float32						(*GetPeakFunction)(const Float32* inData, UInt32 inNumberSamples);
+	typedef void						(*ConvertToSInt16Function)(const Float32* inSource, SInt16* outDestination, UInt32 inNumberSamples);
+	typedef void						(*InterleaveFunction)(const Float32* const* inSources, UInt32 inNumberChannels, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames);
+	typedef void						(*DeinterleaveFunction)(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberChannels, UInt32 inNumberFrames);
+	typedef void						(*CopyChannelsFunction)(const Float32* inSource, UInt32 inSourceStride, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberChannels, UInt32 inNumberFrames);
+
+#pragma mark Kernels
+public:
+	//	ioData[i] *= inGain
+	static void							Scale(Float32* ioData, UInt32 inNumberSamples, Float32 inGain) { sScale.Get()(ioData, inNumberSamples, inGain); }
+
+	//	ioDestination[i] += inSource[i]
+	static void							Add(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples) { sAdd.Get()(inSource, ioDestination, inNumberSamples); }
+
+	//	ioDestination[i] += inGain * inSource[i]
+	static void							AddScaled(const Float32* inSource, Float32* ioDestination, UInt32 inNumberSamples, Float32 inGain) { sAddScaled.Get()(inSource, ioDestination, inNumberSamples, inGain); }
+
+	//	the largest absolute value, 0 for no samples
+	static Float32						GetPeak(const Float32* inData, UInt32 inNumberSamples) { return sGetPeak.Get()(inData, inNumberSamples); }
+
+	//	scaled by 32767, clipped and rounded to nearest even
+	static void							ConvertToSInt16(const Float32* inSource, SInt16* outDestination, UInt32 inNumberSamples) { sConvertToSInt16.Get()(inSource, outDestination, inNumberSamples); }
+
+	//	outDestination[f * inDestinationStride + c] = inSources[c][f], the stride is at least inNumberChannels
+	static void							Interleave(const Float32* const* inSources, UInt32 inNumberChannels, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberFrames) { sInterleave.Get()(inSources, inNumberChannels, outDestination, inDestinationStride, inNumberFrames); }
+
+	//	outDestinations[c][f] = inSource[f * inSourceStride + c], the stride is at least inNumberChannels
+	static void							Deinterleave(const Float32* inSource, UInt32 inSourceStride, Float32* const* outDestinations, UInt32 inNumberChannels, UInt32 inNumberFrames) { sDeinterleave.Get()(inSource, inSourceStride, outDestinations, inNumberChannels, inNumberFrames); }
+
+	//	copies inNumberChannels adjacent samples of every frame from one interleaved buffer to another,
+	//	outDestination[f * inDestinationStride + c] = inSource[f * inSourceStride + c]
+	static void							CopyChannels(const Float32* inSource, UInt32 inSourceStride, Float32* outDestination, UInt32 inDestinationStride, UInt32 inNumberChannels, UInt32 inNumberFrames) { sCopyChannels.Get()(inSource, inSourceStride, outDestination, inDestinationStride, inNumberChannels, inNumberFrames); }
+
+	//	the name of the tier a kernel resolved to, like "AVX2" or "Scalar"
+	static const char*					GetImplementationName(Kernel inKernel);
+
+#pragma mark Implementation
+private:
+	static CAVectorDispatch<ScaleFunction>				sScale;
+	static CAVectorDispatch<AddFunction>				sAdd;
+	static CAVectorDispatch<AddScaledFunction>			sAddScaled;
+	static CAVectorDispatch<GetPeakFunction>			sGetPeak;
+	static CAVectorDispatch<ConvertToSInt16Function>	sConvertToSInt16;
+	static CAVectorDispatch<InterleaveFunction>			sInterleave;
+	static CAVectorDispatch<DeinterleaveFunction>		sDeinterleave;
+	static CAVectorDispatch<CopyChannelsFunction>		sCopyChannels;
+
+};
+
+#endif	//	__CAVectorKernels_h__
@@ -46,14 +46,87 @@
 */
 #include "CAVectorUnit.h"
 
-#if !TARGET_OS_WIN32
+#if TARGET_OS_WIN32
+	#if HAS_IPP
+		#include "ippdefs.h"
+		#include "ippcore.h"
+	#endif
+#elif defined(__linux__)
+	#if defined(__i386__) || defined(__x86_64__)
+		#include <cpuid.h>
+	#elif defined(__arm__) || defined(__aarch64__)
+		#include <sys/auxv.h>
+		#include <asm/hwcap.h>
+	#endif
+#else
 	#include <sys/sysctl.h>
-#elif HAS_IPP
-	#include "ippdefs.h"
-	#include "ippcore.h"
 #endif
 
 int gCAVectorUnitType = kVecUninitialized;
+UInt32 gCAVectorUnitFeatures = 0;
+
+static UInt32 sCAVectorUnitFeatureMask = 0xFFFFFFFF;
+
+#if defined(__linux__) && (defined(__i386__) || defined(__x86_64__))
+// The extended registers are only usable when the OS saves them on a context switch, which XCR0 tells.
+static UInt64 GetXCR0()
+{
+	UInt32 eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<UInt64>(edx) << 32) | eax;
+}
+
+static UInt32 ExamineX86Features()
+{
+	UInt32 features = 0;
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return features;
+	
+	if (edx & (1U << 26)) features |= kVecFeature_SSE2;
+	if (ecx & (1U << 0)) features |= kVecFeature_SSE3;
+	if (ecx & (1U << 9)) features |= kVecFeature_SSSE3;
+	if (ecx & (1U << 19)) features |= kVecFeature_SSE41;
+	if (ecx & (1U << 20)) features |= kVecFeature_SSE42;
+	
+	// AVX needs the OS to save the XMM and YMM state, AVX-512 also the opmask and ZMM state
+	bool hasYMM = false, hasZMM = false;
+	if (ecx & (1U << 27)) {
+		UInt64 xcr0 = GetXCR0();
+		hasYMM = (xcr0 & 0x06) == 0x06;
+		hasZMM = hasYMM && ((xcr0 & 0xE0) == 0xE0);
+	}
+	if (!hasYMM)
+		return features;
+	
+	if (ecx & (1U << 28)) features |= kVecFeature_AVX;
+	if (ecx & (1U << 12)) features |= kVecFeature_FMA;
+	if (__get_cpuid_max(0, NULL) >= 7) {
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		if (ebx & (1U << 5)) features |= kVecFeature_AVX2;
+		if (hasZMM) {
+			if (ebx & (1U << 16)) features |= kVecFeature_AVX512F;
+			if (ebx & (1U << 17)) features |= kVecFeature_AVX512DQ;
+			if (ebx & (1U << 30)) features |= kVecFeature_AVX512BW;
+			if (ebx & (1U << 31)) features |= kVecFeature_AVX512VL;
+		}
+	}
+	return features;
+}
+#endif
+
+// the vector unit type is the best tier the features add up to
+static SInt32 GetTypeForFeatures(UInt32 features)
+{
+	if (features & kVecFeature_AVX512F) return kVecAVX512;
+	if (features & kVecFeature_AVX2) return kVecAVX2;
+	if (features & kVecFeature_AVX) return kVecAVX1;
+	if (features & kVecFeature_SSE3) return kVecSSE3;
+	if (features & kVecFeature_SSE2) return kVecSSE2;
+	if (features & kVecFeature_Neon) return kVecNeon;
+	if (features & kVecFeature_Altivec) return kVecAltivec;
+	return kVecNone;
+}
 
 #if TARGET_OS_WIN32
 // Use cpuid to check if SSE2 is available.
@@ -123,6 +196,7 @@ end_cpuid_identify:
 SInt32	CAVectorUnit_Examine()
 {
 	int result = kVecNone;
+	UInt32 features = 0;
 	
 #if TARGET_OS_WIN32
 #if HAS_IPP	
@@ -144,10 +218,12 @@ SInt32	CAVectorUnit_Examine()
 			if(IsSSE3Available())
 			{
 				result = kVecSSE3;
+				features = kVecFeature_SSE2 | kVecFeature_SSE3;
 			}
 			else if(IsSSE2Available())
 			{
 				result = kVecSSE2;
+				features = kVecFeature_SSE2;
 			}
 		}
 	}
@@ -166,30 +242,98 @@ SInt32	CAVectorUnit_Examine()
 		size_t length = sizeof(vType);
 		int error = sysctl(sels, 2, &vType, &length, NULL, 0);
 		if (!error && vType > 0)
+		{
 			result = kVecAltivec;
+			features = kVecFeature_Altivec;
+		}
 	#elif (TARGET_CPU_X86 || TARGET_CPU_X86_64)
-		static const struct { const char* kName; const int kVectype; } kStringVectypes[] = {
-			{ "hw.optional.avx1_0", kVecAVX1 }, { "hw.optional.sse3", kVecSSE3 }, { "hw.optional.sse2", kVecSSE2 }
+		static const struct { const char* kName; const UInt32 kFeature; } kStringFeatures[] = {
+			{ "hw.optional.sse2", kVecFeature_SSE2 }, { "hw.optional.sse3", kVecFeature_SSE3 },
+			{ "hw.optional.supplementalsse3", kVecFeature_SSSE3 }, { "hw.optional.sse4_1", kVecFeature_SSE41 },
+			{ "hw.optional.sse4_2", kVecFeature_SSE42 }, { "hw.optional.avx1_0", kVecFeature_AVX },
+			{ "hw.optional.avx2_0", kVecFeature_AVX2 }, { "hw.optional.fma", kVecFeature_FMA },
+			{ "hw.optional.avx512f", kVecFeature_AVX512F }, { "hw.optional.avx512bw", kVecFeature_AVX512BW },
+			{ "hw.optional.avx512dq", kVecFeature_AVX512DQ }, { "hw.optional.avx512vl", kVecFeature_AVX512VL }
 		};
-		static const size_t kNumStringVectypes = sizeof(kStringVectypes)/sizeof(kStringVectypes[0]);
-		int i = 0, answer = 0;
-		while(i != kNumStringVectypes)
+		static const size_t kNumStringFeatures = sizeof(kStringFeatures)/sizeof(kStringFeatures[0]);
+		for (size_t i = 0; i != kNumStringFeatures; ++i)
 		{
+			int answer = 0;
 			size_t length = sizeof(answer);
-			int error = sysctlbyname(kStringVectypes[i].kName, &answer, &length, NULL, 0);
+			int error = sysctlbyname(kStringFeatures[i].kName, &answer, &length, NULL, 0);
 			if (!error && answer)
-			{
-				result = kStringVectypes[i].kVectype;
-				break;
-			}
-			++i;
-		};
-	#elif CA_ARM_NEON
-		result = kVecNeon;
+				features |= kStringFeatures[i].kFeature;
+		}
+	#elif CA_ARM_NEON || defined(__ARM_NEON)
+		features = kVecFeature_Neon;
+		#if defined(__aarch64__) || defined(__arm64__)
+			int answer = 0;
+			size_t length = sizeof(answer);
+			if (!sysctlbyname("hw.optional.neon_fp16", &answer, &length, NULL, 0) && answer)
+				features |= kVecFeature_NeonFP16;
+		#endif
+	#endif
+	}
+#elif defined(__linux__)
+#if DEBUG
+	if (getenv("CA_NoVector")) {
+		fprintf(stderr, "CA_NoVector set; Vector unit optimized routines will be bypassed\n");
+	}
+	else
+#endif
+	{
+	#if defined(__i386__) || defined(__x86_64__)
+		features = ExamineX86Features();
+	#elif defined(__aarch64__)
+		unsigned long hwcap = getauxval(AT_HWCAP);
+		if (hwcap & HWCAP_ASIMD)
+			features |= kVecFeature_Neon;
+		if (hwcap & HWCAP_ASIMDHP)
+			features |= kVecFeature_NeonFP16;
+	#elif defined(__arm__)
+		if (getauxval(AT_HWCAP) & HWCAP_NEON)
+			features |= kVecFeature_Neon;
 	#endif
 	}
 #endif
+	// the features are written first, GetFeatures() only looks at them once the type is set
+	gCAVectorUnitFeatures = features & sCAVectorUnitFeatureMask;
+	result = GetTypeForFeatures(gCAVectorUnitFeatures);
 	gCAVectorUnitType = result;
 	return result;
 }
 
+void	CAVectorUnit_SetFeatureMask(UInt32 inMask)
+{
+	sCAVectorUnitFeatureMask = inMask;
+	CAVectorUnit_Examine();
+	CAVectorDispatchBase::ResolveAll();
+}
+
+//=============================================================================
+//	CAVectorDispatch
+//=============================================================================
+
+std::atomic<CAVectorDispatchBase*>	CAVectorDispatchBase::sFirst(NULL);
+
+void*	CAVectorDispatchBase::Resolve()
+{
+	// registered before it is resolved, so a feature mask change in between can't be missed
+	if (!mIsRegistered.exchange(true, std::memory_order_acq_rel)) {
+		CAVectorDispatchBase* first = sFirst.load(std::memory_order_relaxed);
+		do {
+			mNext = first;
+		} while (!sFirst.compare_exchange_weak(first, this, std::memory_order_release, std::memory_order_relaxed));
+	}
+	mResolve(*this, CAVectorUnit_GetFeatures());
+	return mFunction.load(std::memory_order_acquire);
+}
+
+void	CAVectorDispatchBase::ResolveAll()
+{
+	UInt32 features = CAVectorUnit_GetFeatures();
+	for (CAVectorDispatchBase* dispatch = sFirst.load(std::memory_order_acquire); dispatch != NULL; dispatch = dispatch->mNext) {
+		dispatch->mResolve(*dispatch, features);
+	}
+}
+
@@ -58,10 +58,17 @@
 	#include "CFBase.h"
 #endif
 
+#ifdef __cplusplus
+	#include <atomic>
+	#include <stddef.h>
+#endif
+
 // Unify checks for vector units.
 // Allow setting an environment variable "CA_NoVector" to turn off vectorized code at runtime (very useful for performance testing).
+// On Linux the vector unit is found with cpuid and XGETBV on x86 and with getauxval on ARM.
 
 extern int gCAVectorUnitType;
+extern UInt32 gCAVectorUnitFeatures;	// the kVecFeature bits that are present and allowed by the feature mask
 
 #ifdef __cplusplus
 extern "C" {
@@ -75,6 +82,18 @@ static inline SInt32 CAVectorUnit_GetType()
 	return (x != kVecUninitialized) ? x : CAVectorUnit_Examine();
 }
 
+static inline UInt32 CAVectorUnit_GetFeatures()
+{
+	if (gCAVectorUnitType == kVecUninitialized)
+		CAVectorUnit_Examine();
+	return gCAVectorUnitFeatures;
+}
+
+// Hides the features that aren't in the mask, as if the CPU didn't have them, and resolves every
+// dispatched kernel again. Pass 0xFFFFFFFF to allow everything again. Meant for tests and
+// benchmarks that want a particular tier, so don't call it while kernels are running.
+extern void CAVectorUnit_SetFeatureMask(UInt32 inMask);
+
 static inline Boolean CAVectorUnit_HasVectorUnit()
 {
 	return CAVectorUnit_GetType() > kVecNone;
@@ -95,6 +114,85 @@ public:
 	static bool			HasSSE3() { return GetVectorUnitType() >= kVecSSE3; }
 	static bool			HasAVX1() { return GetVectorUnitType() >= kVecAVX1; }
 	static bool			HasNeon() { return GetVectorUnitType() == kVecNeon; }
+	
+	static UInt32		GetFeatures() { return CAVectorUnit_GetFeatures(); }
+	static bool			HasFeatures(UInt32 inFeatures) { return (GetFeatures() & inFeatures) == inFeatures; }
+	static bool			HasAVX2() { return HasFeatures(kVecFeature_AVX2); }
+	static bool			HasFMA() { return HasFeatures(kVecFeature_FMA); }
+	static bool			HasAVX512() { return HasFeatures(kVecFeature_AVX512F); }
+	static void			SetFeatureMask(UInt32 inMask) { CAVectorUnit_SetFeatureMask(inMask); }
+};
+
+//=============================================================================
+//	CAVectorDispatch
+//
+//	A kernel with one implementation per instruction set tier, resolved to the best one the CPU
+//	has the first time it is used and called through the cached function pointer from then on.
+//	The implementations are listed best first, each with the kVecFeature bits it needs, and the
+//	last one has to need none. The constructor is constexpr so that a kernel with static storage
+//	can be called from any other static initializer. Every kernel that has been resolved is kept
+//	in a list so that CAVectorUnit_SetFeatureMask can resolve it again.
+//=============================================================================
+
+class CAVectorDispatchBase {
+public:
+	const char*			GetName() const { return mName; }
+	const char*			GetImplementationName() { Get(); return mImplementationName.load(std::memory_order_acquire); }
+	
+	static void			ResolveAll();
+	
+protected:
+	typedef void		(*ResolveFunction)(CAVectorDispatchBase& ioDispatch, UInt32 inFeatures);
+	
+	constexpr			CAVectorDispatchBase(const char* inName, ResolveFunction inResolve) : mName(inName), mResolve(inResolve), mFunction(NULL), mImplementationName(NULL), mIsRegistered(false), mNext(NULL) {}
+	
+	void*				Get() { void* theFunction = mFunction.load(std::memory_order_acquire); return (theFunction != NULL) ? theFunction : Resolve(); }
+	void*				Resolve();
+	
+	const char*			mName;
+	ResolveFunction		mResolve;
+	std::atomic<void*>	mFunction;
+	std::atomic<const char*>	mImplementationName;
+	std::atomic<bool>	mIsRegistered;
+	CAVectorDispatchBase*	mNext;
+	
+	static std::atomic<CAVectorDispatchBase*>	sFirst;
+	
+private:
+						CAVectorDispatchBase(const CAVectorDispatchBase&);
+	CAVectorDispatchBase&	operator=(const CAVectorDispatchBase&);
+};
+
+template <typename F>
+class CAVectorDispatch : public CAVectorDispatchBase {
+public:
+	struct Implementation {
+		const char*		mName;
+		UInt32			mRequiredFeatures;
+		F				mFunction;
+	};
+	
+	template <size_t N>
+	constexpr			CAVectorDispatch(const char* inName, const Implementation (&inImplementations)[N]) : CAVectorDispatchBase(inName, &ResolveImplementation), mImplementations(inImplementations), mNumberImplementations(N) {}
+	
+	F					Get() { return reinterpret_cast<F>(CAVectorDispatchBase::Get()); }
+	
+private:
+	static void			ResolveImplementation(CAVectorDispatchBase& ioDispatch, UInt32 inFeatures)
+	{
+		CAVectorDispatch& theDispatch = static_cast<CAVectorDispatch&>(ioDispatch);
+		for (size_t i = 0; i < theDispatch.mNumberImplementations; ++i) {
+			const Implementation& theImplementation = theDispatch.mImplementations[i];
+			if (((theImplementation.mRequiredFeatures & ~inFeatures) == 0) || (i == theDispatch.mNumberImplementations - 1)) {
+				theDispatch.mImplementationName.store(theImplementation.mName, std::memory_order_relaxed);
+				theDispatch.mFunction.store(reinterpret_cast<void*>(theImplementation.mFunction), std::memory_order_release);
+				break;
+			}
+		}
+	}
+	
+	const Implementation*	mImplementations;
+	size_t				mNumberImplementations;
 };
 #endif
 
@@ -54,7 +54,28 @@ enum {
 	kVecSSE2 = 100,
 	kVecSSE3 = 101,
 	kVecAVX1 = 110,
+	kVecAVX2 = 111,
+	kVecAVX512 = 112,
 	kVecNeon = 200
 };
 
+//	the individual instruction set extensions, so that a kernel can ask for exactly what it uses
+enum {
+	kVecFeature_SSE2 = 1 << 0,
+	kVecFeature_SSE3 = 1 << 1,
+	kVecFeature_SSSE3 = 1 << 2,
+	kVecFeature_SSE41 = 1 << 3,
+	kVecFeature_SSE42 = 1 << 4,
+	kVecFeature_AVX = 1 << 5,
+	kVecFeature_AVX2 = 1 << 6,
+	kVecFeature_FMA = 1 << 7,
+	kVecFeature_AVX512F = 1 << 8,
+	kVecFeature_AVX512BW = 1 << 9,
+	kVecFeature_AVX512DQ = 1 << 10,
+	kVecFeature_AVX512VL = 1 << 11,
+	kVecFeature_Altivec = 1 << 16,
+	kVecFeature_Neon = 1 << 17,
+	kVecFeature_NeonFP16 = 1 << 18
+};
+
 #endif
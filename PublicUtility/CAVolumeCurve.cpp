@@ -51,6 +51,8 @@
 #include "CAVolumeCurve.h"
 #include "CADebugMacros.h"
 #include <math.h>
+#include <string.h>
+#include <algorithm>
 
 //=============================================================================
 //	CAVolumeCurve
@@ -63,7 +65,13 @@ CAVolumeCurve::CAVolumeCurve()
 	mIsApplyingTransferFunction(true),
 	mTransferFunction(kPow2Over1Curve),
 	mRawToScalarExponentNumerator(2.0f),
-	mRawToScalarExponentDenominator(1.0f)
+	mRawToScalarExponentDenominator(1.0f),
+	mMinimumRaw(0),
+	mMaximumRaw(0),
+	mMinimumDB(0),
+	mMaximumDB(0),
+	mIsCompiled(false),
+	mSegmentsRawEnd(0)
 {
 }
 
@@ -71,60 +79,6 @@ CAVolumeCurve::~CAVolumeCurve()
 {
 }
 
-SInt32	CAVolumeCurve::GetMinimumRaw() const
-{
-	SInt32 theAnswer = 0;
-	
-	if(!mCurveMap.empty())
-	{
-		CurveMap::const_iterator theIterator = mCurveMap.begin();
-		theAnswer = theIterator->first.mMinimum;
-	}
-	
-	return theAnswer;
-}
-
-SInt32	CAVolumeCurve::GetMaximumRaw() const
-{
-	SInt32 theAnswer = 0;
-	
-	if(!mCurveMap.empty())
-	{
-		CurveMap::const_iterator theIterator = mCurveMap.begin();
-		std::advance(theIterator, static_cast<int>(mCurveMap.size() - 1));
-		theAnswer = theIterator->first.mMaximum;
-	}
-	
-	return theAnswer;
-}
-
-Float32	CAVolumeCurve::GetMinimumDB() const
-{
-	Float32 theAnswer = 0;
-	
-	if(!mCurveMap.empty())
-	{
-		CurveMap::const_iterator theIterator = mCurveMap.begin();
-		theAnswer = theIterator->second.mMinimum;
-	}
-	
-	return theAnswer;
-}
-
-Float32	CAVolumeCurve::GetMaximumDB() const
-{
-	Float32 theAnswer = 0;
-	
-	if(!mCurveMap.empty())
-	{
-		CurveMap::const_iterator theIterator = mCurveMap.begin();
-		std::advance(theIterator, static_cast<int>(mCurveMap.size() - 1));
-		theAnswer = theIterator->second.mMaximum;
-	}
-	
-	return theAnswer;
-}
-
 void	CAVolumeCurve::SetTransferFunction(UInt32 inTransferFunction)
 {
 	mTransferFunction = inTransferFunction;
@@ -234,6 +188,8 @@ void	CAVolumeCurve::SetTransferFunction(UInt32 inTransferFunction)
 			mRawToScalarExponentDenominator = 1.0f;
 			break;
 	};
+	
+	Compile();
 }
 
 void	CAVolumeCurve::AddRange(SInt32 inMinRaw, SInt32 inMaxRaw, Float32 inMinDB, Float32 inMaxDB)
@@ -258,6 +214,7 @@ void	CAVolumeCurve::AddRange(SInt32 inMinRaw, SInt32 inMaxRaw, Float32 inMinDB,
 	if(!isOverlapped)
 	{
 		mCurveMap.insert(CurveMap::value_type(theRaw, theDB));
+		Compile();
 	}
 	else
 	{
@@ -268,6 +225,7 @@ void	CAVolumeCurve::AddRange(SInt32 inMinRaw, SInt32 inMaxRaw, Float32 inMinDB,
 void	CAVolumeCurve::ResetRange()
 {
 	mCurveMap.clear();
+	Compile();
 }
 
 bool	CAVolumeCurve::CheckForContinuity() const
@@ -303,7 +261,7 @@ bool	CAVolumeCurve::CheckForContinuity() const
 	return theAnswer;
 }
 
-SInt32	CAVolumeCurve::ConvertDBToRaw(Float32 inDB) const
+SInt32	CAVolumeCurve::ConvertDBToRawUncompiled(Float32 inDB) const
 {
 	//	clamp the value to the dB range
 	Float32 theOverallDBMin = GetMinimumDB();
@@ -362,7 +320,7 @@ SInt32	CAVolumeCurve::ConvertDBToRaw(Float32 inDB) const
 	return theAnswer;
 }
 
-Float32	CAVolumeCurve::ConvertRawToDB(SInt32 inRaw) const
+Float32	CAVolumeCurve::ConvertRawToDBUncompiled(SInt32 inRaw) const
 {
 	Float32 theAnswer = 0;
 	
@@ -412,7 +370,7 @@ Float32	CAVolumeCurve::ConvertRawToDB(SInt32 inRaw) const
 	return theAnswer;
 }
 
-Float32	CAVolumeCurve::ConvertRawToScalar(SInt32 inRaw) const
+Float32	CAVolumeCurve::ConvertRawToScalarUncompiled(SInt32 inRaw) const
 {
 	//	get some important values
 	Float32	theDBMin = GetMinimumDB();
@@ -438,14 +396,7 @@ Float32	CAVolumeCurve::ConvertRawToScalar(SInt32 inRaw) const
 	return theAnswer;
 }
 
-Float32	CAVolumeCurve::ConvertDBToScalar(Float32 inDB) const
-{
-	SInt32 theRawValue = ConvertDBToRaw(inDB);
-	Float32 theAnswer = ConvertRawToScalar(theRawValue);
-	return theAnswer;
-}
-
-SInt32	CAVolumeCurve::ConvertScalarToRaw(Float32 inScalar) const
+SInt32	CAVolumeCurve::ConvertScalarToRawUncompiled(Float32 inScalar) const
 {
 	//	range the scalar value
 	inScalar = std::min(1.0f, std::max(0.0f, inScalar));
@@ -474,9 +425,247 @@ SInt32	CAVolumeCurve::ConvertScalarToRaw(Float32 inScalar) const
 	return theAnswer;
 }
 
+SInt32	CAVolumeCurve::ConvertDBToRaw(Float32 inDB) const
+{
+	return mIsCompiled ? CompiledDBToRaw(inDB) : ConvertDBToRawUncompiled(inDB);
+}
+
+Float32	CAVolumeCurve::ConvertRawToDB(SInt32 inRaw) const
+{
+	return mIsCompiled ? TableRawToDB(inRaw) : ConvertRawToDBUncompiled(inRaw);
+}
+
+Float32	CAVolumeCurve::ConvertRawToScalar(SInt32 inRaw) const
+{
+	return mIsCompiled ? TableRawToScalar(inRaw) : ConvertRawToScalarUncompiled(inRaw);
+}
+
+Float32	CAVolumeCurve::ConvertDBToScalar(Float32 inDB) const
+{
+	SInt32 theRawValue = ConvertDBToRaw(inDB);
+	Float32 theAnswer = ConvertRawToScalar(theRawValue);
+	return theAnswer;
+}
+
+SInt32	CAVolumeCurve::ConvertScalarToRaw(Float32 inScalar) const
+{
+	return mIsCompiled ? CompiledScalarToRaw(inScalar) : ConvertScalarToRawUncompiled(inScalar);
+}
+
 Float32	CAVolumeCurve::ConvertScalarToDB(Float32 inScalar) const
 {
 	SInt32 theRawValue = ConvertScalarToRaw(inScalar);
 	Float32 theAnswer = ConvertRawToDB(theRawValue);
 	return theAnswer;
 }
+
+void	CAVolumeCurve::ConvertRawToScalars(const SInt32* inRaw, Float32* outScalars, UInt32 inNumberValues) const
+{
+	if(mIsCompiled)
+	{
+		//	clamp and gather, which the compiler can vectorize
+		const Float32* theTable = &mRawToScalarTable[0];
+		SInt32 theRawMin = mMinimumRaw;
+		SInt32 theRawMax = mMaximumRaw;
+		for(UInt32 theIndex = 0; theIndex < inNumberValues; ++theIndex)
+		{
+			SInt32 theRaw = inRaw[theIndex];
+			theRaw = theRaw < theRawMin ? theRawMin : theRaw;
+			theRaw = theRaw > theRawMax ? theRawMax : theRaw;
+			outScalars[theIndex] = theTable[theRaw - theRawMin];
+		}
+	}
+	else
+	{
+		for(UInt32 theIndex = 0; theIndex < inNumberValues; ++theIndex)
+		{
+			outScalars[theIndex] = ConvertRawToScalarUncompiled(inRaw[theIndex]);
+		}
+	}
+}
+
+void	CAVolumeCurve::ConvertDBToScalars(const Float32* inDB, Float32* outScalars, UInt32 inNumberValues) const
+{
+	if(mIsCompiled && (mSegments.size() == 1))
+	{
+		//	with only one range, converting to raw is a straight line that the compiler can vectorize
+		//	along with the clamping and the table lookup
+		const Segment& theSegment = mSegments[0];
+		const Float32* theTable = &mRawToScalarTable[0];
+		Float32 theDBMin = mMinimumDB;
+		Float32 theDBMax = mMaximumDB;
+		SInt32 theRawRange = mMaximumRaw - mMinimumRaw;
+		SInt32 theRawOffset = theSegment.mRawStart - mMinimumRaw;
+		for(UInt32 theIndex = 0; theIndex < inNumberValues; ++theIndex)
+		{
+			Float32 theDB = inDB[theIndex];
+			theDB = theDB < theDBMin ? theDBMin : theDB;
+			theDB = theDB > theDBMax ? theDBMax : theDB;
+			SInt32 theStep = theRawOffset + static_cast<SInt32>(roundf((theDB - theSegment.mDBMinimum) / theSegment.mDBPerRaw));
+			theStep = theStep < 0 ? 0 : theStep;
+			theStep = theStep > theRawRange ? theRawRange : theStep;
+			outScalars[theIndex] = theTable[theStep];
+		}
+	}
+	else
+	{
+		for(UInt32 theIndex = 0; theIndex < inNumberValues; ++theIndex)
+		{
+			outScalars[theIndex] = ConvertDBToScalar(inDB[theIndex]);
+		}
+	}
+}
+
+void	CAVolumeCurve::ConvertScalarsToDB(const Float32* inScalars, Float32* outDB, UInt32 inNumberValues) const
+{
+	for(UInt32 theIndex = 0; theIndex < inNumberValues; ++theIndex)
+	{
+		outDB[theIndex] = ConvertScalarToDB(inScalars[theIndex]);
+	}
+}
+
+void	CAVolumeCurve::Compile()
+{
+	mIsCompiled = false;
+	mSegments.clear();
+	mRawToDBTable.clear();
+	mRawToScalarTable.clear();
+	mScalarThresholds.clear();
+	mScalarIndex.clear();
+	
+	//	cache the extents of the curve
+	mMinimumRaw = 0;
+	mMaximumRaw = 0;
+	mMinimumDB = 0;
+	mMaximumDB = 0;
+	if(mCurveMap.empty())
+	{
+		return;
+	}
+	mMinimumRaw = mCurveMap.begin()->first.mMinimum;
+	mMaximumRaw = mCurveMap.rbegin()->first.mMaximum;
+	mMinimumDB = mCurveMap.begin()->second.mMinimum;
+	mMaximumDB = mCurveMap.rbegin()->second.mMaximum;
+	
+	SInt32 theRawRange = mMaximumRaw - mMinimumRaw;
+	if((theRawRange <= 0) || (theRawRange > kMaximumCompiledRawRange))
+	{
+		return;
+	}
+	
+	//	the ranges, laid out the way ConvertDBToRawUncompiled walks them
+	SInt32 theRawStart = mMinimumRaw;
+	for(CurveMap::const_iterator theIterator = mCurveMap.begin(); theIterator != mCurveMap.end(); std::advance(theIterator, 1))
+	{
+		Segment theSegment;
+		theSegment.mRawStart = theRawStart;
+		theSegment.mRawRange = theIterator->first.mMaximum - theIterator->first.mMinimum;
+		theSegment.mDBMinimum = theIterator->second.mMinimum;
+		theSegment.mDBMaximum = theIterator->second.mMaximum;
+		theSegment.mDBPerRaw = (theSegment.mDBMaximum - theSegment.mDBMinimum) / static_cast<Float32>(theSegment.mRawRange);
+		mSegments.push_back(theSegment);
+		theRawStart += theSegment.mRawRange;
+	}
+	mSegmentsRawEnd = theRawStart;
+	
+	//	the raw conversions, one entry per raw value
+	mRawToDBTable.resize(theRawRange + 1);
+	mRawToScalarTable.resize(theRawRange + 1);
+	for(SInt32 theStep = 0; theStep <= theRawRange; ++theStep)
+	{
+		mRawToDBTable[theStep] = ConvertRawToDBUncompiled(mMinimumRaw + theStep);
+		mRawToScalarTable[theStep] = ConvertRawToScalarUncompiled(mMinimumRaw + theStep);
+	}
+	
+	//	the scalar thresholds, found by bisecting the bit patterns of the floats in [0, 1], which
+	//	sort the same way as their values
+	mScalarThresholds.resize(theRawRange + 1);
+	mScalarThresholds[0] = 0.0f;
+	UInt32 theLowerBits = 0;
+	for(SInt32 theStep = 1; theStep <= theRawRange; ++theStep)
+	{
+		UInt32 theUpperBits = 0x3F800000;
+		while(theLowerBits < theUpperBits)
+		{
+			UInt32 theMiddleBits = theLowerBits + (theUpperBits - theLowerBits) / 2;
+			Float32 theMiddle;
+			memcpy(&theMiddle, &theMiddleBits, sizeof(Float32));
+			if(ConvertScalarToRawUncompiled(theMiddle) >= mMinimumRaw + theStep)
+			{
+				theUpperBits = theMiddleBits;
+			}
+			else
+			{
+				theLowerBits = theMiddleBits + 1;
+			}
+		}
+		memcpy(&mScalarThresholds[theStep], &theLowerBits, sizeof(Float32));
+	}
+	
+	//	the index into the thresholds
+	SInt32 theNumberSlots = std::max(1024, 4 * (theRawRange + 1));
+	mScalarIndex.resize(theNumberSlots + 1);
+	for(SInt32 theSlot = 0; theSlot <= theNumberSlots; ++theSlot)
+	{
+		mScalarIndex[theSlot] = ConvertScalarToRawUncompiled(static_cast<Float32>(theSlot) / static_cast<Float32>(theNumberSlots)) - mMinimumRaw;
+	}
+	
+	mIsCompiled = true;
+}
+
+SInt32	CAVolumeCurve::CompiledDBToRaw(Float32 inDB) const
+{
+	//	clamp the value to the dB range
+	if(inDB < mMinimumDB) inDB = mMinimumDB;
+	if(inDB > mMaximumDB) inDB = mMaximumDB;
+	
+	//	find the range the value is in, which is almost always the first one
+	std::vector<Segment>::const_iterator theSegment = mSegments.begin();
+	while((theSegment != mSegments.end()) && (inDB > theSegment->mDBMaximum))
+	{
+		std::advance(theSegment, 1);
+	}
+	if(theSegment == mSegments.end())
+	{
+		return mSegmentsRawEnd;
+	}
+	
+	//	only move in whole steps
+	Float32 theNumberRawSteps = roundf((inDB - theSegment->mDBMinimum) / theSegment->mDBPerRaw);
+	return theSegment->mRawStart + static_cast<SInt32>(theNumberRawSteps);
+}
+
+SInt32	CAVolumeCurve::CompiledScalarToRaw(Float32 inScalar) const
+{
+	//	range the scalar value
+	inScalar = std::min(1.0f, std::max(0.0f, inScalar));
+	
+	//	start at the slot's first step and walk to the step the scalar is in
+	SInt32 theNumberSlots = static_cast<SInt32>(mScalarIndex.size()) - 1;
+	SInt32 theRawRange = static_cast<SInt32>(mScalarThresholds.size()) - 1;
+	SInt32 theStep = mScalarIndex[static_cast<SInt32>(inScalar * static_cast<Float32>(theNumberSlots))];
+	while((theStep > 0) && (inScalar < mScalarThresholds[theStep]))
+	{
+		--theStep;
+	}
+	while((theStep < theRawRange) && (inScalar >= mScalarThresholds[theStep + 1]))
+	{
+		++theStep;
+	}
+	
+	return mMinimumRaw + theStep;
+}
+
+Float32	CAVolumeCurve::TableRawToDB(SInt32 inRaw) const
+{
+	if(inRaw < mMinimumRaw) inRaw = mMinimumRaw;
+	if(inRaw > mMaximumRaw) inRaw = mMaximumRaw;
+	return mRawToDBTable[inRaw - mMinimumRaw];
+}
+
+Float32	CAVolumeCurve::TableRawToScalar(SInt32 inRaw) const
+{
+	if(inRaw < mMinimumRaw) inRaw = mMinimumRaw;
+	if(inRaw > mMaximumRaw) inRaw = mMaximumRaw;
+	return mRawToScalarTable[inRaw - mMinimumRaw];
+}
@@ -57,6 +57,7 @@
 	#include <CoreAudioTypes.h>
 #endif
 #include <map>
+#include <vector>
 
 //=============================================================================
 //	Types
@@ -140,12 +141,12 @@ public:
 public:
 	UInt32			GetTag() const			{ return mTag; }
 	void			SetTag(UInt32 inTag)	{ mTag = inTag; }
-	SInt32			GetMinimumRaw() const;
-	SInt32			GetMaximumRaw() const;
-	Float32			GetMinimumDB() const;
-	Float32			GetMaximumDB() const;
+	SInt32			GetMinimumRaw() const	{ return mMinimumRaw; }
+	SInt32			GetMaximumRaw() const	{ return mMaximumRaw; }
+	Float32			GetMinimumDB() const	{ return mMinimumDB; }
+	Float32			GetMaximumDB() const	{ return mMaximumDB; }
 	
-	void			SetIsApplyingTransferFunction(bool inIsApplyingTransferFunction)  { mIsApplyingTransferFunction = inIsApplyingTransferFunction; }
+	void			SetIsApplyingTransferFunction(bool inIsApplyingTransferFunction)  { mIsApplyingTransferFunction = inIsApplyingTransferFunction; Compile(); }
 	UInt32			GetTransferFunction() const { return mTransferFunction; }
 	void			SetTransferFunction(UInt32 inTransferFunction);
 
@@ -162,16 +163,70 @@ public:
 	SInt32			ConvertScalarToRaw(Float32 inScalar) const;
 	Float32			ConvertScalarToDB(Float32 inScalar) const;
 
+//	Batch Operations
+public:
+	//	the same conversions over whole arrays, for automation curves
+	void			ConvertRawToScalars(const SInt32* inRaw, Float32* outScalars, UInt32 inNumberValues) const;
+	void			ConvertDBToScalars(const Float32* inDB, Float32* outScalars, UInt32 inNumberValues) const;
+	void			ConvertScalarsToDB(const Float32* inScalars, Float32* outDB, UInt32 inNumberValues) const;
+
+//	Uncompiled Operations
+public:
+	//	The conversions walk the curve map and evaluate the transfer function on every call. Every
+	//	time the curve changes, their results for each raw value are compiled into tables, which the
+	//	conversions above read instead. Curves with more than kMaximumCompiledRawRange raw steps
+	//	are not compiled and fall back to these.
+	enum { kMaximumCompiledRawRange = 4096 };
+	
+	bool			IsCompiled() const		{ return mIsCompiled; }
+	SInt32			ConvertDBToRawUncompiled(Float32 inDB) const;
+	Float32			ConvertRawToDBUncompiled(SInt32 inRaw) const;
+	Float32			ConvertRawToScalarUncompiled(SInt32 inRaw) const;
+	SInt32			ConvertScalarToRawUncompiled(Float32 inScalar) const;
+
 //	Implementation
 private:
 	typedef	std::map<CARawPoint, CADBPoint>	CurveMap;
 	
+	//	a range of the curve map, with the raw value it starts at once the earlier ranges are added up
+	struct Segment
+	{
+		SInt32		mRawStart;
+		SInt32		mRawRange;
+		Float32		mDBMinimum;
+		Float32		mDBMaximum;
+		Float32		mDBPerRaw;
+	};
+	
+	void			Compile();
+	SInt32			CompiledDBToRaw(Float32 inDB) const;
+	SInt32			CompiledScalarToRaw(Float32 inScalar) const;
+	Float32			TableRawToDB(SInt32 inRaw) const;
+	Float32			TableRawToScalar(SInt32 inRaw) const;
+	
 	UInt32			mTag;
 	CurveMap		mCurveMap;
 	bool			mIsApplyingTransferFunction;
 	UInt32			mTransferFunction;
 	Float32			mRawToScalarExponentNumerator;
 	Float32			mRawToScalarExponentDenominator;
+	
+	//	the compiled curve
+	SInt32					mMinimumRaw;
+	SInt32					mMaximumRaw;
+	Float32					mMinimumDB;
+	Float32					mMaximumDB;
+	bool					mIsCompiled;
+	std::vector<Segment>	mSegments;
+	SInt32					mSegmentsRawEnd;
+	std::vector<Float32>	mRawToDBTable;
+	std::vector<Float32>	mRawToScalarTable;
+	
+	//	mScalarThresholds[r] is the smallest scalar that converts to at least mMinimumRaw + r, and
+	//	mScalarIndex maps evenly spaced scalars to the raw step they start in, so a lookup only has
+	//	to walk the few thresholds inside one slot
+	std::vector<Float32>	mScalarThresholds;
+	std::vector<SInt32>		mScalarIndex;
 
 };
 
@@ -0,0 +1,227 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+//	Self Include
+#include "CAWorkerPool.h"
+
+//	PublicUtility Includes
+#include "CADebugMacros.h"
+#include "CAException.h"
+#include "CAHostTimeBase.h"
+#include "CAPThread.h"
+
+//	System Includes
+#include <unistd.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+	#include <xmmintrin.h>
+#endif
+
+//==================================================================================================
+//	CAWorkerPool
+//==================================================================================================
+
+static const UInt32	kDefaultSpinCount = 20000;
+
+static inline UInt64	MakeState(UInt32 inGeneration, UInt32 inNumberTasks, UInt32 inNextTask)
+{
+	return (static_cast<UInt64>(inGeneration) << 32) | (static_cast<UInt64>(inNumberTasks) << 16) | inNextTask;
+}
+
+static inline UInt32	GetStateGeneration(UInt64 inState)
+{
+	return static_cast<UInt32>(inState >> 32);
+}
+
+static inline UInt32	GetStateNumberTasks(UInt64 inState)
+{
+	return static_cast<UInt32>(inState >> 16) & 0xFFFF;
+}
+
+static inline UInt32	GetStateNextTask(UInt64 inState)
+{
+	return static_cast<UInt32>(inState) & 0xFFFF;
+}
+
+static inline void	CPUPause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	_mm_pause();
+#elif defined(__arm64__) || defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+CAWorkerPool::CAWorkerPool(UInt32 inNumberWorkers, UInt64 inPeriodNanos)
+:
+	mNumberThreads(inNumberWorkers > 1 ? inNumberWorkers - 1 : 0),
+	mThreads(NULL),
+	mParkSemaphore(dispatch_semaphore_create(0)),
+	mFunction(NULL),
+	mContext(NULL),
+	mState(0),
+	mCompletedTasks(0),
+	mNumberParked(0),
+	mNumberRunning(0),
+	mSpinCount(kDefaultSpinCount),
+	mQuit(false)
+{
+	ThrowIfNULL(mParkSemaphore, CAException(kAudio_MemFullError), "CAWorkerPool::CAWorkerPool: couldn't create the semaphore");
+	
+	mThreads = new CAPThread*[mNumberThreads];
+	for(UInt32 theThreadIndex = 0; theThreadIndex < mNumberThreads; ++theThreadIndex)
+	{
+		//	the threads delete themselves once they leave WorkerLoop()
+		if(inPeriodNanos != 0)
+		{
+			UInt32 thePeriod = static_cast<UInt32>(CAHostTimeBase::ConvertFromNanos(inPeriodNanos));
+			mThreads[theThreadIndex] = new CAPThread(WorkerEntry, this, thePeriod, thePeriod / 2, thePeriod, true, true, "CAWorkerPool");
+		}
+		else
+		{
+			mThreads[theThreadIndex] = new CAPThread(WorkerEntry, this, CAPThread::kMaxThreadPriority, true, true, "CAWorkerPool");
+		}
+		mNumberRunning.fetch_add(1);
+		mThreads[theThreadIndex]->Start();
+	}
+}
+
+CAWorkerPool::~CAWorkerPool()
+{
+	//	wake everybody with an empty generation and wait for them to leave
+	mQuit.store(true);
+	mState.store(MakeState(GetStateGeneration(mState.load()) + 1, 0, 0));
+	for(UInt32 theThreadIndex = 0; theThreadIndex < mNumberThreads; ++theThreadIndex)
+	{
+		dispatch_semaphore_signal(mParkSemaphore);
+	}
+	while(mNumberRunning.load() > 0)
+	{
+		usleep(1000);
+	}
+	delete[] mThreads;
+	dispatch_release(mParkSemaphore);
+}
+
+void	CAWorkerPool::Run(TaskFunction inFunction, void* inContext, UInt32 inNumberTasks)
+{
+	Assert(inNumberTasks <= kMaximumNumberTasks, "CAWorkerPool::Run: too many tasks");
+	if(inNumberTasks == 0)
+	{
+		return;
+	}
+	
+	//	publish the job, nobody from the previous generation can still be reading it since all of
+	//	its tasks are done
+	mFunction = inFunction;
+	mContext = inContext;
+	mCompletedTasks.store(0, std::memory_order_relaxed);
+	UInt32 theGeneration = GetStateGeneration(mState.load(std::memory_order_relaxed)) + 1;
+	mState.store(MakeState(theGeneration, inNumberTasks, 0), std::memory_order_seq_cst);
+	
+	//	only wake the workers that gave up spinning
+	UInt32 theNumberParked = mNumberParked.exchange(0, std::memory_order_seq_cst);
+	for(UInt32 theIndex = 0; theIndex < theNumberParked; ++theIndex)
+	{
+		dispatch_semaphore_signal(mParkSemaphore);
+	}
+	
+	DoTasks(theGeneration);
+	
+	//	the join
+	while(mCompletedTasks.load(std::memory_order_acquire) < inNumberTasks)
+	{
+		CPUPause();
+	}
+}
+
+void*	CAWorkerPool::WorkerEntry(void* inPool)
+{
+	static_cast<CAWorkerPool*>(inPool)->WorkerLoop();
+	return NULL;
+}
+
+void	CAWorkerPool::WorkerLoop()
+{
+	UInt32 theSeenGeneration = GetStateGeneration(mState.load(std::memory_order_acquire));
+	while(WaitForGeneration(theSeenGeneration))
+	{
+		theSeenGeneration = GetStateGeneration(mState.load(std::memory_order_acquire));
+		DoTasks(theSeenGeneration);
+	}
+	
+	//	this has to be the last access to the pool
+	mNumberRunning.fetch_sub(1);
+}
+
+bool	CAWorkerPool::WaitForGeneration(UInt32 inSeenGeneration)
+{
+	UInt32 theSpinCount = mSpinCount.load(std::memory_order_relaxed);
+	for(UInt32 theSpin = 0; theSpin < theSpinCount; ++theSpin)
+	{
+		if(GetStateGeneration(mState.load(std::memory_order_acquire)) != inSeenGeneration)
+		{
+			return !mQuit.load();
+		}
+		CPUPause();
+	}
+	
+	//	Park. Every increment of mNumberParked is matched by either one semaphore signal from Run()
+	//	or by taking the increment back here, so the semaphore count never drifts.
+	mNumberParked.fetch_add(1, std::memory_order_seq_cst);
+	if(GetStateGeneration(mState.load(std::memory_order_seq_cst)) != inSeenGeneration)
+	{
+		UInt32 theNumberParked = mNumberParked.load(std::memory_order_seq_cst);
+		while((theNumberParked > 0) && !mNumberParked.compare_exchange_weak(theNumberParked, theNumberParked - 1, std::memory_order_seq_cst))
+		{
+		}
+		if(theNumberParked > 0)
+		{
+			return !mQuit.load();
+		}
+		//	Run() already claimed the increment, so consume its signal
+	}
+	while(dispatch_semaphore_wait(mParkSemaphore, DISPATCH_TIME_FOREVER) != 0)
+	{
+	}
+	return !mQuit.load();
+}
+
+void	CAWorkerPool::DoTasks(UInt32 inGeneration)
+{
+	UInt64 theState = mState.load(std::memory_order_acquire);
+	while((GetStateGeneration(theState) == inGeneration) && (GetStateNextTask(theState) < GetStateNumberTasks(theState)))
+	{
+		if(mState.compare_exchange_weak(theState, theState + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			mFunction(mContext, GetStateNextTask(theState));
+			mCompletedTasks.fetch_add(1, std::memory_order_release);
+			theState = mState.load(std::memory_order_acquire);
+		}
+	}
+}
@@ -0,0 +1,114 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Daniel Lindenfelser
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#if !defined(__CAWorkerPool_h__)
+#define __CAWorkerPool_h__
+
+//==================================================================================================
+//	Includes
+//==================================================================================================
+
+#if !defined(__COREAUDIO_USE_FLAT_INCLUDES__)
+	#include <CoreAudio/CoreAudioTypes.h>
+#else
+	#include <CoreAudioTypes.h>
+#endif
+
+#include <dispatch/dispatch.h>
+
+//	Standard Library Includes
+#include <atomic>
+
+class CAPThread;
+
+/*==================================================================================================
+	CAWorkerPool
+
+	A fixed set of real time threads for fork/join work on the IO thread. Run() hands out task
+	indices through a single atomic state word that also carries the run's generation and task
+	count, works on them on the calling thread as well, and returns once every task has finished. Nothing is allocated and no thread is created after
+	construction, and the join is a lock-free counter rather than a mutex or condition variable.
+
+	Idle workers spin for a short while after a run so that back to back runs, like the analysis
+	and synthesis halves of an FFT frame, don't pay for a wakeup. After that they park on a
+	semaphore, which Run() only signals when somebody is actually parked.
+
+	Run() may only be called from one thread at a time, takes at most kMaximumNumberTasks tasks and
+	its task functions must not throw.
+==================================================================================================*/
+
+class CAWorkerPool
+{
+
+#pragma mark Construction/Destruction
+public:
+	typedef void				(*TaskFunction)(void* inContext, UInt32 inTaskIndex);
+	enum						{ kMaximumNumberTasks = 0xFFFF };
+
+	//	inNumberWorkers counts the calling thread, so 1 means no extra threads. With a period the
+	//	workers become time constraint threads with that period, otherwise fixed priority threads.
+								CAWorkerPool(UInt32 inNumberWorkers, UInt64 inPeriodNanos = 0);
+								~CAWorkerPool();
+
+private:
+								CAWorkerPool(const CAWorkerPool&);
+	CAWorkerPool&				operator=(const CAWorkerPool&);
+
+#pragma mark Operations
+public:
+	UInt32						GetNumberWorkers() const { return mNumberThreads + 1; }
+
+	void						Run(TaskFunction inFunction, void* inContext, UInt32 inNumberTasks);
+
+	//	how many polls an idle worker spins before it parks
+	UInt32						GetSpinCount() const { return mSpinCount.load(std::memory_order_relaxed); }
+	void						SetSpinCount(UInt32 inSpinCount) { mSpinCount.store(inSpinCount, std::memory_order_relaxed); }
+
+#pragma mark Implementation
+private:
+	static void*				WorkerEntry(void* inPool);
+	void						WorkerLoop();
+	bool						WaitForGeneration(UInt32 inSeenGeneration);
+	void						DoTasks(UInt32 inGeneration);
+
+	UInt32						mNumberThreads;
+	CAPThread**					mThreads;
+	dispatch_semaphore_t		mParkSemaphore;
+
+	//	the current job, published by the release store of mState and only read by a worker that
+	//	claimed one of its tasks
+	TaskFunction				mFunction;
+	void*						mContext;
+
+	//	generation in the upper 32 bits, then the number of tasks and the next task in 16 bits each
+	std::atomic<UInt64>			mState;
+	std::atomic<UInt32>			mCompletedTasks;
+	std::atomic<UInt32>			mNumberParked;
+	std::atomic<UInt32>			mNumberRunning;
+	std::atomic<UInt32>			mSpinCount;
+	std::atomic<bool>			mQuit;
+
+};
+
+#endif	//	__CAWorkerPool_h__
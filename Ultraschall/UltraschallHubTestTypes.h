@@ -24,12 +24,14 @@ static const CFStringRef kAudioHubBoxUID = CFSTR("fm.ultraschall.audio.Ultrascha
 static const CFStringRef kAudioHubDeviceModelUID = CFSTR("fm.ultraschall.audio.UltraschallHubDevice");
 
 const UInt32 kAudioHubCustomProperties = 0;
+const UInt32 kAudioHubDeviceCustomProperties = 0;
 
 static const CFStringRef kAudioHubSettingsKey = CFSTR("UltraschallHubSettings");
 static const CFStringRef kAudioHubSettingsKeyDevices = CFSTR("UltraschallHubDevices");
 static const CFStringRef kAudioHubSettingsKeyDeviceName = CFSTR("Name");
 static const CFStringRef kAudioHubSettingsKeyDeviceUID = CFSTR("UID");
 static const CFStringRef kAudioHubSettingsKeyDeviceChannels = CFSTR("Channels");
+static const CFStringRef kAudioHubSettingsKeyDeviceNoiseReduction = CFSTR("NoiseReduction");
 
 static const UInt32 kAudioHubMaximumDeviceChannels = 32;
 